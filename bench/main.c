@@ -0,0 +1,1320 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+/* Benchmark suite of the library: micro benchmarks of the kernels (fully connected, convolution,
+ * pooling, lstm cells, normalizations and optimizers) and end-to-end training steps of model,
+ * rmodel, vaemodel, recurrent_enc_dec, ddpg and neat generations, and the framed messages of the client/server transport on the loopback.
+ * 
+ * Each benchmark is repeated until --min-time seconds are elapsed and reports the ns spent for a
+ * single operation and the items processed per second (flops, elements, params, samples, genomes).
+ * The results can be written as json (--json) and csv (--csv), and compared against a baseline
+ * csv written by a previous run (--baseline), a benchmark slower than the baseline more than
+ * --tolerance is a regression and the program exits with 1.
+ * 
+ * Usage:
+ * 
+ *             ./bench [--min-time seconds] [--threads n] [--filter substring] [--json file] [--csv file] [--baseline file] [--tolerance fraction]
+ * 
+ * */
+
+#include <llab.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#define BENCH_MAX_RESULTS 64
+#define BENCH_NAME_SIZE 64
+#define BENCH_UNIT_SIZE 16
+#define BENCH_SEED 17
+#define BENCH_BATCH 16
+#define BENCH_NEAT_GENERATIONS 20
+#define BENCH_MESSAGE_FLOATS 4194304
+#define BENCH_SHARED_TRAINER_STEPS 200
+
+typedef struct bench_result{
+    char name[BENCH_NAME_SIZE];
+    char unit[BENCH_UNIT_SIZE];
+    long long int iterations;
+    double ns_per_op;
+    double items_per_sec;
+} bench_result;
+
+typedef struct bench_suite{
+    int n_results,threads;
+    double min_time;
+    char* filter;
+    bench_result results[BENCH_MAX_RESULTS];
+} bench_suite;
+
+
+/* This function returns the monotonic clock in nanoseconds*/
+double bench_now(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (double)ts.tv_sec*1e9+(double)ts.tv_nsec;
+}
+
+/* This function returns 1 if the benchmark name must be run according to the --filter option*/
+int bench_enabled(bench_suite* s, char* name){
+    return s->filter == NULL || strstr(name,s->filter) != NULL;
+}
+
+/* This function returns 1 until the benchmark has been repeated for at least min_time seconds
+ * (and at least 3 times)
+ * 
+ * Inputs:
+ * 
+ *             @ bench_suite* s:= the suite
+ *             @ double start:= the time when the benchmark started, from bench_now
+ *             @ long long int iterations:= the iterations already done
+ * */
+int bench_running(bench_suite* s, double start, long long int iterations){
+    return iterations < 3 || bench_now()-start < s->min_time*1e9;
+}
+
+/* This function stores the result of a benchmark and prints it
+ * 
+ * Inputs:
+ * 
+ *             @ bench_suite* s:= the suite
+ *             @ char* name:= the name of the benchmark
+ *             @ long long int iterations:= the number of operations timed
+ *             @ double elapsed:= the ns spent by all the operations
+ *             @ double items_per_op:= the items processed by a single operation
+ *             @ char* unit:= the unit of the items
+ * */
+void bench_record(bench_suite* s, char* name, long long int iterations, double elapsed, double items_per_op, char* unit){
+    if(s->n_results == BENCH_MAX_RESULTS){
+        fprintf(stderr,"Error: too many benchmarks, increase BENCH_MAX_RESULTS\n");
+        exit(1);
+    }
+    bench_result* r = &s->results[s->n_results];
+    snprintf(r->name,BENCH_NAME_SIZE,"%s",name);
+    snprintf(r->unit,BENCH_UNIT_SIZE,"%s",unit);
+    r->iterations = iterations;
+    r->ns_per_op = elapsed/(double)iterations;
+    r->items_per_sec = items_per_op*1e9/r->ns_per_op;
+    s->n_results++;
+    printf("%-32s %10lld it %16.1f ns/op %14.4e %s/s\n",r->name,r->iterations,r->ns_per_op,r->items_per_sec,r->unit);
+    fflush(stdout);
+}
+
+/* This function returns a new array of random values in [-1,1)*/
+float* bench_random_array(int size){
+    int i;
+    float* a = (float*)malloc(sizeof(float)*size);
+    for(i = 0; i < size; i++){
+        a[i] = 2*r2()-1;
+    }
+    return a;
+}
+
+/* This function returns a new matrix rows x cols of random values in [-1,1)*/
+float** bench_random_matrix(int rows, int cols){
+    int i;
+    float** m = (float**)malloc(sizeof(float*)*rows);
+    for(i = 0; i < rows; i++){
+        m[i] = bench_random_array(cols);
+    }
+    return m;
+}
+
+/* This function returns a new tensor n x rows x cols of random values in [-1,1)*/
+float*** bench_random_tensor(int n, int rows, int cols){
+    int i;
+    float*** t = (float***)malloc(sizeof(float**)*n);
+    for(i = 0; i < n; i++){
+        t[i] = bench_random_matrix(rows,cols);
+    }
+    return t;
+}
+
+void bench_free_tensor(float*** t, int n, int rows){
+    int i;
+    for(i = 0; i < n; i++){
+        free_matrix(t[i],rows);
+    }
+    free(t);
+}
+
+/* micro benchmarks of the fully connected, convolutional and pooling feed forward*/
+void bench_layer_kernels(bench_suite* s){
+    long long int it;
+    double start;
+    
+    if(bench_enabled(s,"fcl_ff_1024x1024")){
+        int in = 1024, out = 1024;
+        float* input = bench_random_array(in);
+        float* weights = bench_random_array(in*out);
+        float* biases = bench_random_array(out);
+        float* output = (float*)calloc(out,sizeof(float));
+        fully_connected_feed_forward(input,output,weights,biases,in,out);
+        for(it = 0, start = bench_now(); bench_running(s,start,it); it++)
+            fully_connected_feed_forward(input,output,weights,biases,in,out);
+        bench_record(s,"fcl_ff_1024x1024",it,bench_now()-start,2.0*in*out,"flop");
+        free(input);
+        free(weights);
+        free(biases);
+        free(output);
+    }
+    
+    if(bench_enabled(s,"conv_ff_16x32x32_k3")){
+        int channels = 16, rows = 32, cols = 32, k = 3, padding = 1;
+        float* input = bench_random_array(channels*rows*cols);
+        float* kernel = bench_random_array(channels*k*k);
+        float* output = (float*)calloc(rows*cols,sizeof(float));
+        convolutional_feed_forward(input,kernel,rows,cols,k,k,0.1,channels,output,1,padding);
+        for(it = 0, start = bench_now(); bench_running(s,start,it); it++)
+            convolutional_feed_forward(input,kernel,rows,cols,k,k,0.1,channels,output,1,padding);
+        bench_record(s,"conv_ff_16x32x32_k3",it,bench_now()-start,2.0*channels*k*k*rows*cols,"flop");
+        free(input);
+        free(kernel);
+        free(output);
+    }
+    
+    if(bench_enabled(s,"max_pool_ff_128x128_2x2")){
+        int rows = 128, cols = 128;
+        float* input = bench_random_array(rows*cols);
+        float* output = (float*)calloc(rows*cols/4,sizeof(float));
+        max_pooling_feed_forward(input,output,rows,cols,2,2,2,0);
+        for(it = 0, start = bench_now(); bench_running(s,start,it); it++)
+            max_pooling_feed_forward(input,output,rows,cols,2,2,2,0);
+        bench_record(s,"max_pool_ff_128x128_2x2",it,bench_now()-start,rows*cols,"elem");
+        free(input);
+        free(output);
+    }
+    
+    if(bench_enabled(s,"avg_pool_ff_128x128_2x2")){
+        int rows = 128, cols = 128;
+        float* input = bench_random_array(rows*cols);
+        float* output = (float*)calloc(rows*cols/4,sizeof(float));
+        avarage_pooling_feed_forward(input,output,rows,cols,2,2,2,0);
+        for(it = 0, start = bench_now(); bench_running(s,start,it); it++)
+            avarage_pooling_feed_forward(input,output,rows,cols,2,2,2,0);
+        bench_record(s,"avg_pool_ff_128x128_2x2",it,bench_now()-start,rows*cols,"elem");
+        free(input);
+        free(output);
+    }
+}
+
+/* micro benchmarks of the feed forward and back propagation of a single lstm cell,
+ * and of the fused feed forward of a window of lstm cells*/
+void bench_lstm_kernels(bench_suite* s){
+    long long int it;
+    double start;
+    int i, size = 256, window = 16;
+    
+    if(!bench_enabled(s,"lstm_ff_256") && !bench_enabled(s,"lstm_ff_fused_256_w16") && !bench_enabled(s,"lstm_bp_256"))
+        return;
+    
+    float** w = bench_random_matrix(4,size*size);
+    float** u = bench_random_matrix(4,size*size);
+    float** b = bench_random_matrix(4,size);
+    float** z = bench_random_matrix(4,size);
+    float** dw = (float**)malloc(sizeof(float*)*4);
+    float** du = (float**)malloc(sizeof(float*)*4);
+    float** db = (float**)malloc(sizeof(float*)*4);
+    for(i = 0; i < 4; i++){
+        dw[i] = (float*)calloc(size*size,sizeof(float));
+        du[i] = (float*)calloc(size*size,sizeof(float));
+        db[i] = (float*)calloc(size,sizeof(float));
+    }
+    float* x = bench_random_array(size);
+    float* h = bench_random_array(size);
+    float* c = bench_random_array(size);
+    float* dy = bench_random_array(size);
+    float* cell_state = (float*)calloc(size,sizeof(float));
+    float* hidden_state = (float*)calloc(size,sizeof(float));
+    float* x_window = bench_random_array(window*size);
+    float* zx = (float*)calloc(window*4*size,sizeof(float));
+    float** dfioc;
+    
+    if(bench_enabled(s,"lstm_ff_256")){
+        for(it = 0, start = bench_now(); bench_running(s,start,it); it++){
+            // z is accumulated by lstm_ff as it is in the lstm layers after a reset
+            for(i = 0; i < 4; i++){
+                memset(z[i],0,sizeof(float)*size);
+            }
+            lstm_ff(x,h,c,cell_state,hidden_state,w,u,b,z,size);
+        }
+        bench_record(s,"lstm_ff_256",it,bench_now()-start,16.0*size*size,"flop");
+    }
+    
+    if(bench_enabled(s,"lstm_ff_fused_256_w16")){
+        for(it = 0, start = bench_now(); bench_running(s,start,it); it++){
+            lstm_input_projections(x_window,window,size,w,b,zx);
+            for(i = 0; i < window; i++){
+                lstm_ff_fused(&zx[i*4*size],h,c,cell_state,hidden_state,u,z,size);
+            }
+        }
+        bench_record(s,"lstm_ff_fused_256_w16",it,bench_now()-start,16.0*size*size*window,"flop");
+    }
+    
+    if(bench_enabled(s,"lstm_bp_256")){
+        lstm_ff(x,h,c,cell_state,hidden_state,w,u,b,z,size);
+        for(it = 0, start = bench_now(); bench_running(s,start,it); it++){
+            dfioc = lstm_bp(0,size,dw,du,db,w,u,z,dy,x,cell_state,h,c,NULL,NULL,NULL,NULL,NULL,NULL,NULL);
+            free_matrix(dfioc,4);
+        }
+        bench_record(s,"lstm_bp_256",it,bench_now()-start,16.0*size*size,"flop");
+    }
+    
+    free_matrix(w,4);
+    free_matrix(u,4);
+    free_matrix(b,4);
+    free_matrix(z,4);
+    free_matrix(dw,4);
+    free_matrix(du,4);
+    free_matrix(db,4);
+    free(x);
+    free(x_window);
+    free(zx);
+    free(h);
+    free(c);
+    free(dy);
+    free(cell_state);
+    free(hidden_state);
+}
+
+/* the attention of the recurrent encoder decoder over a window of 32 encoder outputs of size 64,
+ * for a window of 32 decoder timesteps*/
+void bench_attention_kernels(bench_suite* s){
+    long long int it;
+    double start;
+    int i, size = 64, window = 32, steps = 32;
+    
+    if(!bench_enabled(s,"attention_ff_w32_64") && !bench_enabled(s,"attention_bp_w32_64"))
+        return;
+    
+    float* weights = bench_random_array(window*(window+1)*size);
+    float* biases = bench_random_array(window);
+    float* values = bench_random_array(window*size);
+    float* queries = bench_random_array(steps*size);
+    float* contexts_error = bench_random_array(steps*size);
+    float* keys = (float*)calloc(window,sizeof(float));
+    float* scores = (float*)calloc(steps*window,sizeof(float));
+    float* attention = (float*)calloc(steps*window,sizeof(float));
+    float* scores_error = (float*)calloc(steps*window,sizeof(float));
+    float* context = (float*)calloc(size,sizeof(float));
+    float* query_error = (float*)calloc(size,sizeof(float));
+    float* d_weights = (float*)calloc(window*(window+1)*size,sizeof(float));
+    float* d_biases = (float*)calloc(window,sizeof(float));
+    float* values_error = (float*)calloc(window*size,sizeof(float));
+    float* temp = (float*)calloc(window,sizeof(float));
+    
+    if(bench_enabled(s,"attention_ff_w32_64")){
+        for(it = 0, start = bench_now(); bench_running(s,start,it); it++){
+            attention_keys(values,weights,biases,keys,window,size);
+            for(i = 0; i < steps; i++){
+                attention_feed_forward(keys,values,&queries[i*size],weights,&scores[i*window],&attention[i*window],context,window,size);
+            }
+        }
+        bench_record(s,"attention_ff_w32_64",it,bench_now()-start,steps,"step");
+    }
+    
+    if(bench_enabled(s,"attention_bp_w32_64")){
+        for(it = 0, start = bench_now(); bench_running(s,start,it); it++){
+            for(i = 0; i < steps; i++){
+                attention_back_prop(values,weights,&scores[i*window],&attention[i*window],&contexts_error[i*size],&scores_error[i*window],query_error,window,size);
+            }
+            attention_weights_back_prop(values,queries,attention,contexts_error,scores_error,weights,d_weights,d_biases,values_error,temp,window,size,steps);
+        }
+        bench_record(s,"attention_bp_w32_64",it,bench_now()-start,steps,"step");
+    }
+    
+    free(weights);
+    free(biases);
+    free(values);
+    free(queries);
+    free(contexts_error);
+    free(keys);
+    free(scores);
+    free(attention);
+    free(scores_error);
+    free(context);
+    free(query_error);
+    free(d_weights);
+    free(d_biases);
+    free(values_error);
+    free(temp);
+}
+
+/* micro benchmarks of the batch normalization and of the local response normalization*/
+void bench_normalization_kernels(bench_suite* s){
+    long long int it;
+    double start;
+    int batch_size = 32, size = 1024;
+    
+    if(bench_enabled(s,"batch_norm_ff_32x1024") || bench_enabled(s,"batch_norm_bp_32x1024")){
+        float** input = bench_random_matrix(batch_size,size);
+        float** temp = bench_random_matrix(batch_size,size);
+        float** output = bench_random_matrix(batch_size,size);
+        float** output_error = bench_random_matrix(batch_size,size);
+        float** input_error = bench_random_matrix(batch_size,size);
+        float** temp_error = bench_random_matrix(batch_size,size);
+        float* gamma = bench_random_array(size);
+        float* beta = bench_random_array(size);
+        float* mean = (float*)calloc(size,sizeof(float));
+        float* var = (float*)calloc(size,sizeof(float));
+        float* d_gamma = (float*)calloc(size,sizeof(float));
+        float* d_beta = (float*)calloc(size,sizeof(float));
+        float* temp_array = (float*)calloc(size,sizeof(float));
+        
+        batch_normalization_feed_forward(batch_size,input,temp,size,gamma,beta,mean,var,output,EPSILON);
+        if(bench_enabled(s,"batch_norm_ff_32x1024")){
+            for(it = 0, start = bench_now(); bench_running(s,start,it); it++)
+                batch_normalization_feed_forward(batch_size,input,temp,size,gamma,beta,mean,var,output,EPSILON);
+            bench_record(s,"batch_norm_ff_32x1024",it,bench_now()-start,batch_size*size,"elem");
+        }
+        
+        if(bench_enabled(s,"batch_norm_bp_32x1024")){
+            for(it = 0, start = bench_now(); bench_running(s,start,it); it++)
+                batch_normalization_back_prop(batch_size,input,temp,size,gamma,beta,mean,var,output_error,d_gamma,d_beta,input_error,temp_error,temp_array,EPSILON);
+            bench_record(s,"batch_norm_bp_32x1024",it,bench_now()-start,batch_size*size,"elem");
+        }
+        
+        free_matrix(input,batch_size);
+        free_matrix(temp,batch_size);
+        free_matrix(output,batch_size);
+        free_matrix(output_error,batch_size);
+        free_matrix(input_error,batch_size);
+        free_matrix(temp_error,batch_size);
+        free(gamma);
+        free(beta);
+        free(mean);
+        free(var);
+        free(d_gamma);
+        free(d_beta);
+        free(temp_array);
+    }
+    
+    if(bench_enabled(s,"lrn_ff_16x32x32")){
+        int channels = 16, rows = 32, cols = 32, c, i, j;
+        float* tensor = bench_random_array(channels*rows*cols);
+        float* output = (float*)calloc(channels*rows*cols,sizeof(float));
+        int* used_kernels = (int*)malloc(sizeof(int)*channels);
+        for(c = 0; c < channels; c++){
+            used_kernels[c] = 1;
+        }
+        for(it = 0, start = bench_now(); bench_running(s,start,it); it++){
+            for(c = 0; c < channels; c++){
+                for(i = 0; i < rows; i++){
+                    for(j = 0; j < cols; j++){
+                        local_response_normalization_feed_forward(tensor,output,c,i,j,channels,rows,cols,N_NORMALIZATION,BETA_NORMALIZATION,ALPHA_NORMALIZATION,K_NORMALIZATION,used_kernels);
+                    }
+                }
+            }
+        }
+        bench_record(s,"lrn_ff_16x32x32",it,bench_now()-start,channels*rows*cols,"elem");
+        free(tensor);
+        free(used_kernels);
+        free(output);
+    }
+}
+
+/* micro benchmarks of the fused optimizer steps over a single span of params*/
+void bench_optimizer_kernels(bench_suite* s){
+    long long int it;
+    double start;
+    int n = 1<<20;
+    
+    if(!bench_enabled(s,"opt_"))
+        return;
+    
+    float* p = bench_random_array(n);
+    float* d = bench_random_array(n);
+    float* d1 = (float*)calloc(n,sizeof(float));
+    float* d2 = (float*)calloc(n,sizeof(float));
+    float* d3 = (float*)calloc(n,sizeof(float));
+    float lr = 0.0001, b1 = BETA1_ADAM, b2 = BETA2_ADAM;
+    
+    if(bench_enabled(s,"opt_nesterov_1M")){
+        for(it = 0, start = bench_now(); bench_running(s,start,it); it++)
+            nesterov_momentum_span(p,d,d1,n,lr,0.9,BENCH_BATCH,0,0);
+        bench_record(s,"opt_nesterov_1M",it,bench_now()-start,n,"param");
+    }
+    
+    if(bench_enabled(s,"opt_adam_1M")){
+        for(it = 0, start = bench_now(); bench_running(s,start,it); it++)
+            adam_algorithm_span(p,d,d1,d2,n,lr,BETA1_ADAM,BETA2_ADAM,b1,b2,EPSILON_ADAM,BENCH_BATCH,0,0);
+        bench_record(s,"opt_adam_1M",it,bench_now()-start,n,"param");
+    }
+    
+    if(bench_enabled(s,"opt_radam_1M")){
+        for(it = 0, start = bench_now(); bench_running(s,start,it); it++)
+            radam_algorithm_span(p,d,d1,d2,n,lr,BETA1_ADAM,BETA2_ADAM,b1,b2,EPSILON_ADAM,BENCH_BATCH,100,0,0);
+        bench_record(s,"opt_radam_1M",it,bench_now()-start,n,"param");
+    }
+    
+    if(bench_enabled(s,"opt_diff_grad_1M")){
+        for(it = 0, start = bench_now(); bench_running(s,start,it); it++)
+            adam_diff_grad_algorithm_span(p,d,d1,d2,d3,n,lr,BETA1_ADAM,BETA2_ADAM,b1,b2,EPSILON_ADAM,BENCH_BATCH,0,0);
+        bench_record(s,"opt_diff_grad_1M",it,bench_now()-start,n,"param");
+    }
+    
+    if(bench_enabled(s,"opt_adamod_1M")){
+        for(it = 0, start = bench_now(); bench_running(s,start,it); it++)
+            adamod_span(p,d,d1,d2,d3,n,lr,BETA1_ADAM,BETA2_ADAM,b1,b2,EPSILON_ADAM,BENCH_BATCH,BETA3_ADAMOD,0,0);
+        bench_record(s,"opt_adamod_1M",it,bench_now()-start,n,"param");
+    }
+    
+    if(bench_enabled(s,"opt_adam_l2_clip_1M")){
+        for(it = 0, start = bench_now(); bench_running(s,start,it); it++)
+            adam_algorithm_span(p,d,d1,d2,n,lr,BETA1_ADAM,BETA2_ADAM,b1,b2,EPSILON_ADAM,BENCH_BATCH,0.5,0.0001);
+        bench_record(s,"opt_adam_l2_clip_1M",it,bench_now()-start,n,"param");
+    }
+    
+    free(p);
+    free(d);
+    free(d1);
+    free(d2);
+    free(d3);
+}
+
+/* end-to-end training step of a convolutional model: feed forward, back propagation,
+ * sum of the partial derivatives and adam update of a batch*/
+void bench_model_train_step(bench_suite* s){
+    long long int it;
+    double start;
+    int i, batch_size = BENCH_BATCH, input_size = 28*28, output_size = 10;
+    unsigned long long int t = 1;
+    
+    if(!bench_enabled(s,"model_train_step_conv"))
+        return;
+    
+    cl** cls = (cl**)malloc(sizeof(cl*));
+    fcl** fcls = (fcl**)malloc(sizeof(fcl*)*2);
+    cls[0] = convolutional(1,28,28,3,3,8,1,1,1,1,2,2,0,0,2,2,NO_NORMALIZATION,RELU,MAX_POOLING,0,CONVOLUTION,0);
+    fcls[0] = fully_connected(cls[0]->n_kernels*cls[0]->rows2*cls[0]->cols2,64,1,NO_DROPOUT,RELU,0,0,NO_NORMALIZATION);
+    fcls[1] = fully_connected(64,output_size,2,NO_DROPOUT,SIGMOID,0,0,NO_NORMALIZATION);
+    model* m = network(3,0,1,2,NULL,cls,fcls);
+    set_model_error(m,MSE_LOSS,0,0,0,NULL,output_size);
+    int n_weights = count_weights(m);
+    model** batch_m = (model**)malloc(sizeof(model*)*batch_size);
+    for(i = 0; i < batch_size; i++){
+        batch_m[i] = share_model(m);
+    }
+    float** inputs = bench_random_matrix(batch_size,input_size);
+    float** outputs = bench_random_matrix(batch_size,output_size);
+    float** ret_err = (float**)malloc(sizeof(float*)*batch_size);
+    
+    for(it = -1, start = 0; it < 0 || bench_running(s,start,it); it++){
+        if(!it)
+            start = bench_now();
+        ff_error_bp_model_multicore(batch_m,1,28,28,inputs,batch_size,s->threads,outputs,ret_err);
+        sum_models_partial_derivatives_multicore(m,batch_m,batch_size,1,s->threads);
+        update_model(m,0.0001,0,batch_size,ADAM,&m->beta1_adam,&m->beta2_adam,NO_REGULARIZATION,n_weights,0,&t);
+        reset_model(m);
+    }
+    bench_record(s,"model_train_step_conv",it,bench_now()-start,batch_size,"sample");
+    
+    for(i = 0; i < batch_size; i++){
+        free_model(batch_m[i]);
+    }
+    free(batch_m);
+    free_model(m);
+    free_matrix(inputs,batch_size);
+    free_matrix(outputs,batch_size);
+    free(ret_err);
+}
+
+/* end-to-end training step of a batched fully-connected model, with float or 16 bits activations and weights
+ * (the master weights are float) and with the loss scaling of the 16 bits modes*/
+void bench_batch_model_train_step(bench_suite* s, int precision, char* name){
+    long long int it;
+    double start;
+    int i, batch_size = 64, input_size = 1024, hidden_size = 1024, output_size = 10;
+    unsigned long long int t = 1;
+    
+    if(!bench_enabled(s,name))
+        return;
+    
+    fcl** fcls = (fcl**)malloc(sizeof(fcl*)*3);
+    fcls[0] = fully_connected(input_size,hidden_size,0,NO_DROPOUT,RELU,0,0,NO_NORMALIZATION);
+    fcls[1] = fully_connected(hidden_size,hidden_size,1,NO_DROPOUT,RELU,0,0,NO_NORMALIZATION);
+    fcls[2] = fully_connected(hidden_size,output_size,2,NO_DROPOUT,SIGMOID,0,0,NO_NORMALIZATION);
+    model* m = network(3,0,0,3,NULL,NULL,fcls);
+    int n_weights = count_weights(m);
+    bmodel* bm = batch_model_precision(m,batch_size,precision);
+    loss_scaler* scaler = init_loss_scaler(1024,2000);
+    float** inputs = bench_random_matrix(batch_size,input_size);
+    float** errors = bench_random_matrix(batch_size,output_size);
+    float** scaled_errors = bench_random_matrix(batch_size,output_size);
+    
+    for(it = -1, start = 0; it < 0 || bench_running(s,start,it); it++){
+        if(!it)
+            start = bench_now();
+        model_tensor_input_ff_batch(bm,1,1,input_size,inputs,s->threads);
+        // the scale changes during the training, so the errors are scaled at each step
+        for(i = 0; i < batch_size; i++){
+            copy_array(errors[i],scaled_errors[i],output_size);
+            if(precision != FP32_PRECISION)
+                scale_loss_error(scaler,scaled_errors[i],output_size);
+        }
+        model_tensor_input_bp_batch(bm,1,1,input_size,inputs,scaled_errors,output_size,NULL,s->threads);
+        if(precision == FP32_PRECISION || unscale_model_partial_derivatives(scaler,m))
+            update_model(m,0.0001,0,batch_size,ADAM,&m->beta1_adam,&m->beta2_adam,NO_REGULARIZATION,n_weights,0,&t);
+        reset_batch_model(bm);
+    }
+    bench_record(s,name,it,bench_now()-start,batch_size,"sample");
+    
+    free_batch_model(bm);
+    free_model(m);
+    free_loss_scaler(scaler);
+    free_matrix(inputs,batch_size);
+    free_matrix(errors,batch_size);
+    free_matrix(scaled_errors,batch_size);
+}
+
+/* one prediction of a convolutional model for inference: the float feed forward (model_tensor_input_ff)
+ * against the compiled float feed forward (plan_tensor_input_ff) and the int8 feed forward of the quantized model (qmodel_tensor_input_ff)*/
+void bench_model_inference(bench_suite* s){
+    long long int it;
+    double start;
+    int n_samples = 16, input_size = 28*28, output_size = 10;
+    
+    if(!bench_enabled(s,"model_ff_conv_fp32") && !bench_enabled(s,"plan_ff_conv_fp32") && !bench_enabled(s,"qmodel_ff_conv_int8"))
+        return;
+    
+    cl** cls = (cl**)malloc(sizeof(cl*)*2);
+    fcl** fcls = (fcl**)malloc(sizeof(fcl*)*2);
+    cls[0] = convolutional(1,28,28,3,3,16,1,1,1,1,2,2,0,0,2,2,NO_NORMALIZATION,RELU,MAX_POOLING,0,CONVOLUTION,0);
+    cls[1] = convolutional(16,14,14,3,3,32,1,1,1,1,2,2,0,0,2,2,NO_NORMALIZATION,RELU,MAX_POOLING,0,CONVOLUTION,1);
+    fcls[0] = fully_connected(cls[1]->n_kernels*cls[1]->rows2*cls[1]->cols2,512,2,DROPOUT_TEST,RELU,0.5,0,NO_NORMALIZATION);
+    fcls[1] = fully_connected(512,output_size,3,NO_DROPOUT,SOFTMAX,0,0,NO_NORMALIZATION);
+    model* m = network(4,0,2,2,NULL,cls,fcls);
+    float** inputs = bench_random_matrix(n_samples,input_size);
+    qmodel* q = quantize_model(m,inputs,n_samples,1,28,28);
+    inference_plan* p = compile_model(m,1,28,28);
+    
+    if(bench_enabled(s,"model_ff_conv_fp32")){
+        for(it = 0, start = bench_now(); bench_running(s,start,it); it++){
+            reset_model_except_partial_derivatives(m);
+            model_tensor_input_ff(m,1,28,28,inputs[it%n_samples]);
+        }
+        bench_record(s,"model_ff_conv_fp32",it,bench_now()-start,1,"prediction");
+    }
+    
+    if(bench_enabled(s,"plan_ff_conv_fp32")){
+        for(it = 0, start = bench_now(); bench_running(s,start,it); it++){
+            plan_tensor_input_ff(p,inputs[it%n_samples]);
+        }
+        bench_record(s,"plan_ff_conv_fp32",it,bench_now()-start,1,"prediction");
+    }
+    
+    if(bench_enabled(s,"qmodel_ff_conv_int8")){
+        for(it = 0, start = bench_now(); bench_running(s,start,it); it++){
+            qmodel_tensor_input_ff(q,inputs[it%n_samples]);
+        }
+        bench_record(s,"qmodel_ff_conv_int8",it,bench_now()-start,1,"prediction");
+    }
+    
+    free_inference_plan(p);
+    free_qmodel(q);
+    free_model(m);
+    free_matrix(inputs,n_samples);
+}
+
+/* one prediction of a 2 layers lstm rmodel on a sliding window: the full window with ff_rmodel
+ * against a single timestep with rmodel_step*/
+void bench_rmodel_inference(bench_suite* s){
+    long long int it;
+    double start;
+    int i, size = 256, window = 32, layers = 2;
+    
+    if(!bench_enabled(s,"rmodel_ff_window_2x256_w32") && !bench_enabled(s,"rmodel_step_2x256"))
+        return;
+    
+    lstm** lstms = (lstm**)malloc(sizeof(lstm*)*layers);
+    for(i = 0; i < layers; i++){
+        lstms[i] = recurrent_lstm(size,NO_DROPOUT,0,NO_DROPOUT,0,i,window,LSTM_NO_RESIDUAL,NO_NORMALIZATION,0);
+    }
+    rmodel* m = recurrent_network(layers,layers,lstms,window,STATEFUL);
+    rstep* state = rmodel_step_state(m);
+    float** hidden_states = bench_random_matrix(layers,size);
+    float** cell_states = bench_random_matrix(layers,size);
+    float** inputs = bench_random_matrix(window,size);
+    
+    if(bench_enabled(s,"rmodel_ff_window_2x256_w32")){
+        for(it = 0, start = bench_now(); bench_running(s,start,it); it++){
+            ff_rmodel(hidden_states,cell_states,inputs,m);
+        }
+        bench_record(s,"rmodel_ff_window_2x256_w32",it,bench_now()-start,1,"prediction");
+    }
+    
+    if(bench_enabled(s,"rmodel_step_2x256")){
+        for(it = 0, start = bench_now(); bench_running(s,start,it); it++){
+            rmodel_step(state,inputs[it%window]);
+        }
+        bench_record(s,"rmodel_step_2x256",it,bench_now()-start,1,"prediction");
+    }
+    
+    free_rmodel_step_state(state);
+    free_rmodel(m);
+    free_matrix(hidden_states,layers);
+    free_matrix(cell_states,layers);
+    free_matrix(inputs,window);
+}
+
+/* end-to-end training step of a 2 layers rmodel, with lstm or gru cells. Both the ways back propagate
+ * with bp_rmodel_workspace, without workspace bp_rmodel_lstm_multicore returns also the errors of the first timesteps
+ * allocated by bp_rmodel, with workspace nothing is allocated: the 2 rows differ only by these allocations and copies*/
+void bench_rmodel_train_step(bench_suite* s, int cell_type, int workspace, char* name){
+    long long int it;
+    double start;
+    int i, batch_size = BENCH_BATCH, size = 64, window = 16, layers = 2;
+    unsigned long long int t = 1;
+    
+    if(!bench_enabled(s,name))
+        return;
+    
+    lstm** lstms = (lstm**)malloc(sizeof(lstm*)*layers);
+    for(i = 0; i < layers; i++){
+        lstms[i] = recurrent_cell(cell_type,size,NO_DROPOUT,0,NO_DROPOUT,0,i,window,LSTM_NO_RESIDUAL,NO_NORMALIZATION,0);
+    }
+    rmodel* m = recurrent_network(layers,layers,lstms,window,STATELESS);
+    int n_weights = count_weights_rmodel(m);
+    rmodel** batch_m = (rmodel**)malloc(sizeof(rmodel*)*batch_size);
+    for(i = 0; i < batch_size; i++){
+        batch_m[i] = share_rmodel(m);
+    }
+    float*** hidden_states = bench_random_tensor(batch_size,layers,size);
+    float*** cell_states = bench_random_tensor(batch_size,layers,size);
+    float*** inputs = bench_random_tensor(batch_size,window,size);
+    float*** errors = bench_random_tensor(batch_size,window,size);
+    float**** ret_err = (float****)malloc(sizeof(float***)*batch_size);
+    
+    for(it = -1, start = 0; it < 0 || bench_running(s,start,it); it++){
+        if(!it)
+            start = bench_now();
+        ff_rmodel_lstm_multicore(hidden_states,cell_states,inputs,batch_m,batch_size,s->threads);
+        if(workspace){
+            bp_rmodel_lstm_multicore(hidden_states,cell_states,inputs,batch_m,errors,batch_size,s->threads,NULL,NULL);
+        }
+        else{
+            bp_rmodel_lstm_multicore(hidden_states,cell_states,inputs,batch_m,errors,batch_size,s->threads,ret_err,NULL);
+            for(i = 0; i < batch_size; i++){
+                bench_free_tensor(ret_err[i],layers,4);
+            }
+        }
+        sum_rmodels_partial_derivatives_multicore(m,batch_m,batch_size,1,s->threads);
+        update_rmodel(m,0.0001,0,batch_size,ADAM,&m->beta1_adam,&m->beta2_adam,NO_REGULARIZATION,n_weights,0,&t);
+        reset_rmodel(m);
+    }
+    bench_record(s,name,it,bench_now()-start,batch_size,"sample");
+    
+    for(i = 0; i < batch_size; i++){
+        free_rmodel(batch_m[i]);
+    }
+    free(batch_m);
+    free_rmodel(m);
+    bench_free_tensor(hidden_states,batch_size,layers);
+    bench_free_tensor(cell_states,batch_size,layers);
+    bench_free_tensor(inputs,batch_size,window);
+    bench_free_tensor(errors,batch_size,window);
+    free(ret_err);
+}
+
+/* end-to-end training step of the same rmodel with the sequences of the batch computed in lockstep by a batched rmodel*/
+void bench_batch_rmodel_train_step(bench_suite* s){
+    long long int it;
+    double start;
+    int i, batch_size = BENCH_BATCH, size = 64, window = 16, layers = 2;
+    unsigned long long int t = 1;
+    
+    if(!bench_enabled(s,"batch_rmodel_train_step_lstm"))
+        return;
+    
+    lstm** lstms = (lstm**)malloc(sizeof(lstm*)*layers);
+    for(i = 0; i < layers; i++){
+        lstms[i] = recurrent_lstm(size,NO_DROPOUT,0,NO_DROPOUT,0,i,window,LSTM_NO_RESIDUAL,NO_NORMALIZATION,0);
+    }
+    rmodel* m = recurrent_network(layers,layers,lstms,window,STATELESS);
+    int n_weights = count_weights_rmodel(m);
+    brmodel* bm = batch_rmodel(m,batch_size);
+    float*** inputs = bench_random_tensor(batch_size,window,size);
+    float*** errors = bench_random_tensor(batch_size,window,size);
+    
+    for(it = -1, start = 0; it < 0 || bench_running(s,start,it); it++){
+        if(!it)
+            start = bench_now();
+        ff_rmodel_batch(bm,inputs);
+        bp_rmodel_batch(bm,errors);
+        update_rmodel(m,0.0001,0,batch_size,ADAM,&m->beta1_adam,&m->beta2_adam,NO_REGULARIZATION,n_weights,0,&t);
+        reset_batch_rmodel(bm);
+    }
+    bench_record(s,"batch_rmodel_train_step_lstm",it,bench_now()-start,batch_size,"sample");
+    
+    free_batch_rmodel(bm);
+    free_rmodel(m);
+    bench_free_tensor(inputs,batch_size,window);
+    bench_free_tensor(errors,batch_size,window);
+}
+
+/* end-to-end training step of a fully connected variational auto encoder*/
+void bench_vae_train_step(bench_suite* s){
+    long long int it;
+    double start;
+    int i, batch_size = BENCH_BATCH, input_size = 64, latent_size = 8;
+    unsigned long long int t = 1;
+    float b1 = BETA1_ADAM, b2 = BETA2_ADAM;
+    
+    if(!bench_enabled(s,"vae_train_step_fcl"))
+        return;
+    
+    fcl** fcls = (fcl**)malloc(sizeof(fcl*)*2);
+    fcl** dfcls = (fcl**)malloc(sizeof(fcl*)*2);
+    fcls[0] = fully_connected(input_size,32,0,NO_DROPOUT,RELU,0,0,NO_NORMALIZATION);
+    fcls[1] = fully_connected(32,2*latent_size,1,NO_DROPOUT,NO_ACTIVATION,0,0,NO_NORMALIZATION);
+    dfcls[0] = fully_connected(latent_size,32,0,NO_DROPOUT,RELU,0,0,NO_NORMALIZATION);
+    dfcls[1] = fully_connected(32,input_size,1,NO_DROPOUT,SIGMOID,0,0,NO_NORMALIZATION);
+    vaemodel* vae = variational_auto_encoder_model(network(2,0,0,2,NULL,NULL,fcls),network(2,0,0,2,NULL,NULL,dfcls),latent_size);
+    int n_weights = count_weights_vae_model(vae);
+    vaemodel** batch_m = (vaemodel**)malloc(sizeof(vaemodel*)*batch_size);
+    for(i = 0; i < batch_size; i++){
+        batch_m[i] = copy_vae_model(vae);
+    }
+    float** inputs = bench_random_matrix(batch_size,input_size);
+    float** errors = bench_random_matrix(batch_size,input_size);
+    float** ret_err = (float**)malloc(sizeof(float*)*batch_size);
+    
+    for(it = -1, start = 0; it < 0 || bench_running(s,start,it); it++){
+        if(!it)
+            start = bench_now();
+        vae_model_tensor_input_ff_multicore(batch_m,input_size,1,1,inputs,batch_size,s->threads);
+        for(i = 0; i < batch_size; i++){
+            derivative_mse_array(batch_m[i]->decoder->fcls[1]->post_activation,inputs[i],errors[i],input_size);
+        }
+        vae_model_tensor_input_bp_multicore(batch_m,input_size,1,1,inputs,batch_size,s->threads,errors,input_size,ret_err);
+        sum_vae_models_partial_derivatives_multicore(vae,batch_m,batch_size,1,s->threads);
+        update_vae_model(vae,0.0001,0,batch_size,ADAM,&b1,&b2,NO_REGULARIZATION,n_weights,0,&t);
+        reset_vae_model(vae);
+        for(i = 0; i < batch_size; i++){
+            paste_vae_model(vae,batch_m[i]);
+        }
+    }
+    bench_record(s,"vae_train_step_fcl",it,bench_now()-start,batch_size,"sample");
+    
+    for(i = 0; i < batch_size; i++){
+        free_vae_model(batch_m[i]);
+    }
+    free(batch_m);
+    free_vae_model(vae);
+    free_matrix(inputs,batch_size);
+    free_matrix(errors,batch_size);
+    free(ret_err);
+}
+
+/* end-to-end training step of a recurrent encoder decoder with attention*/
+void bench_enc_dec_train_step(bench_suite* s){
+    long long int it;
+    double start;
+    int i, batch_size = BENCH_BATCH, size = 32, window = 8;
+    unsigned long long int t = 1;
+    float b1 = BETA1_ADAM, b2 = BETA2_ADAM;
+    
+    if(!bench_enabled(s,"enc_dec_train_step_lstm"))
+        return;
+    
+    lstm** encoder_lstms = (lstm**)malloc(sizeof(lstm*));
+    lstm** decoder_lstms = (lstm**)malloc(sizeof(lstm*));
+    encoder_lstms[0] = recurrent_lstm(size,NO_DROPOUT,0,NO_DROPOUT,0,0,window,LSTM_NO_RESIDUAL,NO_NORMALIZATION,0);
+    // the decoder cells get the attention of the encoder concatenated with their inputs
+    decoder_lstms[0] = recurrent_lstm(2*size,NO_DROPOUT,0,NO_DROPOUT,0,0,window,LSTM_NO_RESIDUAL,NO_NORMALIZATION,0);
+    recurrent_enc_dec* rec = recurrent_enc_dec_network(recurrent_network(1,1,encoder_lstms,window,STATELESS),recurrent_network(1,1,decoder_lstms,window,STATELESS));
+    int n_weights = count_weights_recurrent_enc_dec(rec);
+    recurrent_enc_dec** batch_m = (recurrent_enc_dec**)malloc(sizeof(recurrent_enc_dec*)*batch_size);
+    for(i = 0; i < batch_size; i++){
+        batch_m[i] = copy_recurrent_enc_dec(rec);
+    }
+    float*** hidden_states = bench_random_tensor(batch_size,1,size);
+    float*** cell_states = bench_random_tensor(batch_size,1,size);
+    float*** inputs1 = bench_random_tensor(batch_size,window,size);
+    float*** inputs2 = bench_random_tensor(batch_size,window,size);
+    float*** errors = bench_random_tensor(batch_size,window,2*size);
+    float*** input_errors2 = bench_random_tensor(batch_size,window,size);
+    float**** ret_err = (float****)malloc(sizeof(float***)*batch_size);
+    
+    for(it = -1, start = 0; it < 0 || bench_running(s,start,it); it++){
+        if(!it)
+            start = bench_now();
+        ff_recurrent_enc_dec_multicore(hidden_states,cell_states,inputs1,inputs2,batch_m,batch_size,s->threads);
+        bp_recurrent_enc_dec_multicore(hidden_states,cell_states,inputs1,inputs2,batch_m,errors,batch_size,s->threads,ret_err,NULL,input_errors2);
+        for(i = 0; i < batch_size; i++){
+            bench_free_tensor(ret_err[i],1,4);
+        }
+        sum_recurrent_enc_decs_partial_derivatives_multicore(rec,batch_m,batch_size,1,s->threads);
+        update_recurrent_enc_dec_model(rec,0.0001,0,batch_size,ADAM,&b1,&b2,NO_REGULARIZATION,n_weights,0,&t);
+        reset_recurrent_enc_dec(rec);
+        for(i = 0; i < batch_size; i++){
+            paste_recurrent_enc_dec(rec,batch_m[i]);
+        }
+    }
+    bench_record(s,"enc_dec_train_step_lstm",it,bench_now()-start,batch_size,"sample");
+    
+    for(i = 0; i < batch_size; i++){
+        free_recurrent_enc_dec(batch_m[i]);
+    }
+    free(batch_m);
+    free_recurrent_enc_dec(rec);
+    bench_free_tensor(hidden_states,batch_size,1);
+    bench_free_tensor(cell_states,batch_size,1);
+    bench_free_tensor(inputs1,batch_size,window);
+    bench_free_tensor(inputs2,batch_size,window);
+    bench_free_tensor(errors,batch_size,window);
+    bench_free_tensor(input_errors2,batch_size,window);
+    free(ret_err);
+}
+
+/* end-to-end training step of ddpg: critic and actor updates plus the soft update of the targets*/
+void bench_ddpg_train_step(bench_suite* s){
+    long long int it;
+    double start;
+    int i, batch_size = BENCH_BATCH, state_size = 8, action_size = 2, features = 32;
+    
+    if(!bench_enabled(s,"ddpg_train_step"))
+        return;
+    
+    fcl** fcls1 = (fcl**)malloc(sizeof(fcl*)*2);
+    fcl** fcls2 = (fcl**)malloc(sizeof(fcl*)*2);
+    fcl** fcls3 = (fcl**)malloc(sizeof(fcl*));
+    fcl** fcls4 = (fcl**)malloc(sizeof(fcl*)*2);
+    fcls1[0] = fully_connected(state_size,64,0,NO_DROPOUT,RELU,0,0,NO_NORMALIZATION);
+    fcls1[1] = fully_connected(64,action_size,1,NO_DROPOUT,TANH,0,0,NO_NORMALIZATION);
+    fcls2[0] = fully_connected(state_size,64,0,NO_DROPOUT,RELU,0,0,NO_NORMALIZATION);
+    fcls2[1] = fully_connected(64,features,1,NO_DROPOUT,RELU,0,0,NO_NORMALIZATION);
+    fcls3[0] = fully_connected(action_size,features,0,NO_DROPOUT,RELU,0,0,NO_NORMALIZATION);
+    fcls4[0] = fully_connected(2*features,64,0,NO_DROPOUT,RELU,0,0,NO_NORMALIZATION);
+    fcls4[1] = fully_connected(64,1,1,NO_DROPOUT,NO_ACTIVATION,0,0,NO_NORMALIZATION);
+    model* m1 = network(2,0,0,2,NULL,NULL,fcls1);
+    model* m2 = network(2,0,0,2,NULL,NULL,fcls2);
+    model* m3 = network(1,0,0,1,NULL,NULL,fcls3);
+    model* m4 = network(2,0,0,2,NULL,NULL,fcls4);
+    set_model_error(m1,MSE_LOSS,0,0,0,NULL,action_size);
+    set_model_error(m2,MSE_LOSS,0,0,0,NULL,features);
+    set_model_error(m3,MSE_LOSS,0,0,0,NULL,features);
+    set_model_error(m4,MSE_LOSS,0,0,0,NULL,1);
+    ddpg* d = init_ddpg(m1,m2,m3,m4,batch_size,s->threads,NO_REGULARIZATION,NO_REGULARIZATION,state_size,action_size,features,features,ADAM,ADAM,state_size,batch_size,0.001,0.0001,0,0,0,0,0.005,0.1,0.99);
+    for(i = 0; i < batch_size; i++){
+        free(d->buff1[i]);
+        free(d->buff2[i]);
+        free(d->actions[i]);
+        d->buff1[i] = bench_random_array(state_size);
+        d->buff2[i] = bench_random_array(state_size);
+        d->actions[i] = bench_random_array(action_size);
+        d->rewards[i] = r2();
+        d->terminal[i] = 0;
+    }
+    
+    for(it = -1, start = 0; it < 0 || bench_running(s,start,it); it++){
+        if(!it)
+            start = bench_now();
+        ddpg_train(d);
+    }
+    bench_record(s,"ddpg_train_step",it,bench_now()-start,batch_size,"sample");
+    
+    free_ddpg(d);
+}
+
+/* the xor fitness of the neat genomes*/
+void bench_neat_xor_fitness(genome** gg, int actual_genomes, int global_inn_numb_nodes, int global_inn_numb_connections){
+    int i,j;
+    float inputs[2];
+    float* output;
+    for(i = 0; i < actual_genomes; i++){
+        gg[i]->fitness = 0;
+        for(j = 0; j < 4; j++){
+            inputs[0] = j&1;
+            inputs[1] = (j>>1)&1;
+            output = feed_forward(gg[i],inputs,global_inn_numb_nodes,global_inn_numb_connections);
+            gg[i]->fitness += inputs[0] == inputs[1] ? 1-output[0] : output[0];
+            free(output);
+        }
+    }
+}
+
+/* neat generations on the xor problem, the generations are a fixed number so that
+ * the population grows the same way in each run*/
+void bench_neat_generation(bench_suite* s){
+    long long int genomes = 0;
+    double start;
+    
+    if(!bench_enabled(s,"neat_generation_xor"))
+        return;
+    
+    srand(BENCH_SEED);
+    neat* nes = init(MAX_POPULATION/INITIAL_POPULATION+1,2,1);
+    nes->keep_parents = 1;
+    // no best genome saved on disk during the benchmark
+    nes->saving = BENCH_NEAT_GENERATIONS+1;
+    start = bench_now();
+    for(nes->k = 1; nes->k <= BENCH_NEAT_GENERATIONS; nes->k++){
+        genomes+=nes->actual_genomes;
+        bench_neat_xor_fitness(nes->gg,nes->actual_genomes,nes->global_inn_numb_nodes,nes->global_inn_numb_connections);
+        neat_generation_run(nes,nes->gg);
+    }
+    bench_record(s,"neat_generation_xor",BENCH_NEAT_GENERATIONS,bench_now()-start,(double)genomes/BENCH_NEAT_GENERATIONS,"genome");
+    free_neat(nes);
+}
+
+/* This function returns the user and system cpu time of the process or of its waited children in ns*/
+double bench_cpu_time(int who){
+    struct rusage usage;
+    getrusage(who,&usage);
+    return ((double)usage.ru_utime.tv_sec+(double)usage.ru_stime.tv_sec)*1e9+((double)usage.ru_utime.tv_usec+(double)usage.ru_stime.tv_usec)*1e3;
+}
+
+/* the framed messages of server.c and client.c: the checksum of a 16 MB vector, and a 16 MB vector sent on the loopback
+ * to a child process that answers with an empty message, the cpu used by the sender and the receiver is printed*/
+void bench_gradient_compression(bench_suite* s){
+    int i, types[] = {COMPRESSION_FP16,COMPRESSION_INT8,COMPRESSION_1BIT,COMPRESSION_TOPK};
+    char* names[] = {"fp16","int8","1bit","topk"};
+    char compress_name[64], decompress_name[64];
+    long long int it, bytes = sizeof(float)*(long long int)BENCH_MESSAGE_FLOATS, compressed_bytes;
+    double start;
+    
+    float* vector = bench_random_array(BENCH_MESSAGE_FLOATS);
+    float* output = (float*)calloc(BENCH_MESSAGE_FLOATS,sizeof(float));
+    for(i = 0; i < 4; i++){
+        snprintf(compress_name,sizeof(compress_name),"compress_%s_4m",names[i]);
+        snprintf(decompress_name,sizeof(decompress_name),"decompress_add_%s_4m",names[i]);
+        if(!bench_enabled(s,compress_name) && !bench_enabled(s,decompress_name))
+            continue;
+        compressor* c = create_compressor(types[i],BENCH_MESSAGE_FLOATS,0.01);
+        void* compressed = malloc(compressed_size(types[i],BENCH_MESSAGE_FLOATS,0.01));
+        compressed_bytes = compress_vector(c,vector,compressed);
+        if(bench_enabled(s,compress_name)){
+            for(it = 0, start = bench_now(); bench_running(s,start,it); it++){
+                compress_vector(c,vector,compressed);
+            }
+            bench_record(s,compress_name,it,bench_now()-start,bytes,"byte");
+        }
+        if(bench_enabled(s,decompress_name)){
+            for(it = 0, start = bench_now(); bench_running(s,start,it); it++){
+                decompress_add(types[i],compressed,compressed_bytes,output,BENCH_MESSAGE_FLOATS);
+            }
+            bench_record(s,decompress_name,it,bench_now()-start,bytes,"byte");
+        }
+        printf("%-32s %10.2f %% of the bytes\n","",100.0*compressed_bytes/bytes);
+        free(compressed);
+        free_compressor(c);
+    }
+    free(vector);
+    free(output);
+}
+
+/* the synchronization, sum of the partial derivatives and nesterov update of a data parallel step of a 1M params model
+ * without the feed forward and back propagation: the replicas of a batch summed by the threads of a single process
+ * against the workers of a shared_trainer, one process each (the bench process is the worker 0)*/
+void bench_data_parallel_step(bench_suite* s){
+    int i, pid, status, workers = s->threads > 2 ? s->threads : 2;
+    long long int it;
+    double start;
+    float b1, b2;
+    unsigned long long int t = 1;
+    char name[64];
+    
+    if(!bench_enabled(s,"threaded_reduce_update_1m") && !bench_enabled(s,"shared_trainer_step_1m"))
+        return;
+    
+    fcl** fcls = (fcl**)malloc(sizeof(fcl*));
+    fcls[0] = fully_connected(1024,1024,0,NO_DROPOUT,RELU,0,0,NO_NORMALIZATION);
+    model* m = network(1,0,0,1,NULL,NULL,fcls);
+    make_model_contiguous(m);
+    b1 = m->beta1_adam;
+    b2 = m->beta2_adam;
+    
+    if(bench_enabled(s,"threaded_reduce_update_1m")){
+        model** batch_m = (model**)malloc(sizeof(model*)*workers);
+        for(i = 0; i < workers; i++){
+            batch_m[i] = share_model(m);
+        }
+        for(it = 0, start = bench_now(); bench_running(s,start,it); it++){
+            sum_models_partial_derivatives_multicore(m,batch_m,workers,1,workers);
+            update_model_multicore(m,0.0001,0.9,workers,NESTEROV,&b1,&b2,NO_REGULARIZATION,0,0,&t,0,workers);
+            reset_model(m);
+        }
+        bench_record(s,"threaded_reduce_update_1m",it,bench_now()-start,m->arena->size,"param");
+        for(i = 0; i < workers; i++){
+            free_model(batch_m[i]);
+        }
+        free(batch_m);
+    }
+    
+    if(bench_enabled(s,"shared_trainer_step_1m")){
+        // the workers can't agree on a time, they run a fixed number of steps
+        snprintf(name,sizeof(name),"/llab_bench_%d",(int)getpid());
+        shared_trainer* st = create_shared_trainer(name,workers,m);
+        fflush(stdout);
+        for(i = 1; i < workers; i++){
+            pid = fork();
+            if(pid == -1){
+                fprintf(stderr,"Error: not able to create a son process\n");
+                exit(1);
+            }
+            if(pid == 0){
+                join_shared_trainer(st,i,m,1);
+                for(it = 0; it < BENCH_SHARED_TRAINER_STEPS+1; it++){
+                    shared_trainer_step(st,m,0.0001,0.9,workers,NESTEROV,&b1,&b2,NO_REGULARIZATION,0,0,&t);
+                }
+                exit(0);
+            }
+        }
+        join_shared_trainer(st,0,m,1);
+        shared_trainer_step(st,m,0.0001,0.9,workers,NESTEROV,&b1,&b2,NO_REGULARIZATION,0,0,&t);
+        for(it = 0, start = bench_now(); it < BENCH_SHARED_TRAINER_STEPS; it++){
+            shared_trainer_step(st,m,0.0001,0.9,workers,NESTEROV,&b1,&b2,NO_REGULARIZATION,0,0,&t);
+        }
+        bench_record(s,"shared_trainer_step_1m",it,bench_now()-start,m->arena->size,"param");
+        while(wait(&status) > 0);
+        leave_shared_trainer(st,m);
+        free_shared_trainer(st);
+    }
+    free_model(m);
+}
+
+void bench_message_transport(bench_suite* s){
+    long long int it, bytes = sizeof(float)*(long long int)BENCH_MESSAGE_FLOATS;
+    double start, elapsed, cpu;
+    int pid, fd, listen_fd, status;
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    message_header header;
+    
+    if(!bench_enabled(s,"message_checksum_16mb") && !bench_enabled(s,"message_loopback_16mb"))
+        return;
+    
+    float* vector = bench_random_array(BENCH_MESSAGE_FLOATS);
+    
+    if(bench_enabled(s,"message_checksum_16mb")){
+        for(it = 0, start = bench_now(); bench_running(s,start,it); it++){
+            message_checksum(vector,bytes);
+        }
+        bench_record(s,"message_checksum_16mb",it,bench_now()-start,bytes,"byte");
+    }
+    
+    if(bench_enabled(s,"message_loopback_16mb")){
+        listen_fd = ring_listen(0);
+        getsockname(listen_fd,(struct sockaddr*)&addr,&addr_len);
+        pid = fork();
+        if(pid == -1){
+            fprintf(stderr,"Error: not able to create a son process\n");
+            exit(1);
+        }
+        if(pid == 0){
+            fd = ring_connect("127.0.0.1",ntohs(addr.sin_port));
+            set_socket_options(fd);
+            while(recv_message(fd,&header,vector,bytes) != -1 && header.type != MESSAGE_CLOSE){
+                send_message(fd,MESSAGE_VECTOR,header.step,NULL,0);
+            }
+            close(fd);
+            exit(0);
+        }
+        fd = accept(listen_fd,NULL,NULL);
+        set_socket_options(fd);
+        cpu = bench_cpu_time(RUSAGE_SELF);
+        for(it = 0, start = bench_now(); bench_running(s,start,it); it++){
+            send_message(fd,MESSAGE_VECTOR,it,vector,bytes);
+            if(recv_message(fd,&header,NULL,0) == -1 || header.step != it){
+                fprintf(stderr,"Error: wrong answer of the receiver\n");
+                exit(1);
+            }
+        }
+        elapsed = bench_now()-start;
+        cpu = bench_cpu_time(RUSAGE_SELF)-cpu;
+        send_message(fd,MESSAGE_CLOSE,it,NULL,0);
+        waitpid(pid,&status,0);
+        bench_record(s,"message_loopback_16mb",it,elapsed,bytes,"byte");
+        printf("%-32s %10.1f %% cpu of the sender %10.1f %% cpu of the receiver\n","",100*cpu/elapsed,100*bench_cpu_time(RUSAGE_CHILDREN)/elapsed);
+        close(fd);
+        close(listen_fd);
+    }
+    free(vector);
+}
+
+/* This function writes the results as csv: name,iterations,ns_per_op,items_per_sec,unit*/
+void bench_write_csv(bench_suite* s, char* filename){
+    int i;
+    FILE* f = fopen(filename,"w");
+    if(f == NULL){
+        fprintf(stderr,"Error: an error occurred opening the file %s\n",filename);
+        exit(1);
+    }
+    fprintf(f,"name,iterations,ns_per_op,items_per_sec,unit\n");
+    for(i = 0; i < s->n_results; i++){
+        fprintf(f,"%s,%lld,%.3f,%.6e,%s\n",s->results[i].name,s->results[i].iterations,s->results[i].ns_per_op,s->results[i].items_per_sec,s->results[i].unit);
+    }
+    fclose(f);
+}
+
+/* This function returns the name of the sgemm instruction set in use*/
+char* bench_instruction_set(){
+    switch(get_sgemm_instruction_set()){
+        case SGEMM_AVX512:
+            return "avx512";
+        case SGEMM_AVX2:
+            return "avx2";
+        case SGEMM_SSE2:
+            return "sse2";
+        default:
+            return "scalar";
+    }
+}
+
+/* This function writes the results as json*/
+void bench_write_json(bench_suite* s, char* filename){
+    int i;
+    FILE* f = fopen(filename,"w");
+    if(f == NULL){
+        fprintf(stderr,"Error: an error occurred opening the file %s\n",filename);
+        exit(1);
+    }
+    fprintf(f,"{\n  \"threads\": %d,\n  \"min_time\": %g,\n  \"instruction_set\": \"%s\",\n  \"results\": [\n",s->threads,s->min_time,bench_instruction_set());
+    for(i = 0; i < s->n_results; i++){
+        fprintf(f,"    {\"name\": \"%s\", \"iterations\": %lld, \"ns_per_op\": %.3f, \"items_per_sec\": %.6e, \"unit\": \"%s\"}%s\n",s->results[i].name,s->results[i].iterations,s->results[i].ns_per_op,s->results[i].items_per_sec,s->results[i].unit,i == s->n_results-1 ? "" : ",");
+    }
+    fprintf(f,"  ]\n}\n");
+    fclose(f);
+}
+
+/* This function compares the ns/op of the results against a baseline csv written by bench_write_csv
+ * 
+ * Inputs:
+ * 
+ *             @ bench_suite* s:= the suite already run
+ *             @ char* filename:= the baseline csv
+ *             @ float tolerance:= a result slower than baseline*(1+tolerance) is a regression
+ * 
+ * Returns the number of regressions
+ * */
+int bench_compare_baseline(bench_suite* s, char* filename, float tolerance){
+    int i,found,regressions = 0;
+    char line[256];
+    char name[BENCH_NAME_SIZE];
+    long long int iterations;
+    double ns_per_op,items_per_sec,ratio;
+    FILE* f = fopen(filename,"r");
+    if(f == NULL){
+        fprintf(stderr,"Error: an error occurred opening the file %s\n",filename);
+        exit(1);
+    }
+    printf("\n%-32s %16s %16s %9s\n","benchmark","baseline ns/op","current ns/op","ratio");
+    for(i = 0; i < s->n_results; i++){
+        found = 0;
+        rewind(f);
+        while(fgets(line,sizeof(line),f) != NULL){
+            if(sscanf(line,"%63[^,],%lld,%lf,%lf",name,&iterations,&ns_per_op,&items_per_sec) == 4 && !strcmp(name,s->results[i].name)){
+                found = 1;
+                break;
+            }
+        }
+        if(!found){
+            printf("%-32s %16s %16.1f %9s new\n",s->results[i].name,"-",s->results[i].ns_per_op,"-");
+            continue;
+        }
+        ratio = s->results[i].ns_per_op/ns_per_op;
+        printf("%-32s %16.1f %16.1f %9.3f %s\n",s->results[i].name,ns_per_op,s->results[i].ns_per_op,ratio,ratio > 1+tolerance ? "REGRESSION" : (ratio < 1-tolerance ? "improved" : "ok"));
+        if(ratio > 1+tolerance)
+            regressions++;
+    }
+    fclose(f);
+    return regressions;
+}
+
+int main(int argc, char** argv){
+    int i,regressions = 0;
+    char* json = NULL;
+    char* csv = NULL;
+    char* baseline = NULL;
+    float tolerance = 0.1;
+    bench_suite* s = (bench_suite*)calloc(1,sizeof(bench_suite));
+    s->threads = 1;
+    s->min_time = 0.5;
+    
+    for(i = 1; i < argc; i++){
+        if(i+1 < argc && !strcmp(argv[i],"--min-time"))
+            s->min_time = atof(argv[++i]);
+        else if(i+1 < argc && !strcmp(argv[i],"--threads"))
+            s->threads = atoi(argv[++i]);
+        else if(i+1 < argc && !strcmp(argv[i],"--filter"))
+            s->filter = argv[++i];
+        else if(i+1 < argc && !strcmp(argv[i],"--json"))
+            json = argv[++i];
+        else if(i+1 < argc && !strcmp(argv[i],"--csv"))
+            csv = argv[++i];
+        else if(i+1 < argc && !strcmp(argv[i],"--baseline"))
+            baseline = argv[++i];
+        else if(i+1 < argc && !strcmp(argv[i],"--tolerance"))
+            tolerance = atof(argv[++i]);
+        else{
+            fprintf(stderr,"Usage: %s [--min-time seconds] [--threads n] [--filter substring] [--json file] [--csv file] [--baseline file] [--tolerance fraction]\n",argv[0]);
+            exit(1);
+        }
+    }
+    
+    if(s->threads < 1 || s->min_time <= 0 || tolerance < 0){
+        fprintf(stderr,"Error: threads must be >= 1, min-time > 0 and tolerance >= 0\n");
+        exit(1);
+    }
+    
+    srand(BENCH_SEED);
+    printf("instruction set: %s, threads: %d, min time: %g s\n",bench_instruction_set(),s->threads,s->min_time);
+    
+    bench_layer_kernels(s);
+    bench_lstm_kernels(s);
+    bench_attention_kernels(s);
+    bench_normalization_kernels(s);
+    bench_optimizer_kernels(s);
+    bench_model_train_step(s);
+    bench_model_inference(s);
+    bench_rmodel_inference(s);
+    bench_batch_model_train_step(s,FP32_PRECISION,"batch_model_train_step_fp32");
+    bench_batch_model_train_step(s,BF16_PRECISION,"batch_model_train_step_bf16");
+    bench_rmodel_train_step(s,LSTM_CELL,0,"rmodel_train_step_lstm");
+    bench_rmodel_train_step(s,LSTM_CELL,1,"rmodel_train_step_lstm_workspace");
+    bench_rmodel_train_step(s,GRU_CELL,0,"rmodel_train_step_gru");
+    bench_rmodel_train_step(s,GRU_CELL,1,"rmodel_train_step_gru_workspace");
+    bench_batch_rmodel_train_step(s);
+    bench_vae_train_step(s);
+    bench_enc_dec_train_step(s);
+    bench_ddpg_train_step(s);
+    bench_neat_generation(s);
+    bench_message_transport(s);
+    bench_gradient_compression(s);
+    bench_data_parallel_step(s);
+    
+    if(csv != NULL)
+        bench_write_csv(s,csv);
+    if(json != NULL)
+        bench_write_json(s,json);
+    if(baseline != NULL){
+        regressions = bench_compare_baseline(s,baseline,tolerance);
+        fflush(stdout);
+        if(regressions)
+            fprintf(stderr,"Error: %d benchmarks are slower than the baseline by more than %g%%\n",regressions,tolerance*100);
+    }
+    
+    free(s);
+    return regressions ? 1 : 0;
+}
@@ -0,0 +1,2 @@
+sh create_library.sh
+make bench
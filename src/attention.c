@@ -0,0 +1,160 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include "llab.h"
+
+/* The attention of the recurrent encoder decoder scores the outputs of the encoder (the values) with a fully-connected
+ * layer of window outputs, whose input is the flattened values followed by the query:
+ * 
+ *     score = tanh(W_v*values + W_q*query + b), attention = softmax(score), context = sum_k attention[k]*values[k]
+ * 
+ * the weights are a window x (window+1)*size matrix, W_v are its first window*size columns, W_q the last size ones.
+ * The values do not change while a sequence is decoded, so W_v*values + b (the keys) is computed once for all the
+ * timesteps instead of once for each timestep, and each timestep costs a window x size matrix vector product.
+ * In the same way the back propagation of a timestep computes only what is needed by the previous timestep
+ * (the error of the query) and the errors of the weights and of the values are computed once for all the timesteps*/
+
+
+/* This function computes the keys of the attention, W_v*values + b
+ * 
+ * Input:
+ * 
+ *             @ float* values:= the values, dimensions: window*size
+ *             @ float* weights:= the weights of the attention, dimensions: window*(window+1)*size
+ *             @ float* biases:= the biases of the attention, dimensions: window
+ *             @ float* keys:= where the keys are stored, dimensions: window
+ *             @ int window:= the number of values
+ *             @ int size:= the size of each value
+ * */
+void attention_keys(float* values, float* weights, float* biases, float* keys, int window, int size){
+    copy_array(biases,keys,window);
+    sgemv(window,window*size,weights,(window+1)*size,values,keys);
+}
+
+/* This function computes the attention of a query and adds the context to float* context.
+ * The softmax subtracts the max score before the exponentials
+ * 
+ * Input:
+ * 
+ *             @ float* keys:= the keys computed by attention_keys, dimensions: window
+ *             @ float* values:= the values, dimensions: window*size
+ *             @ float* query:= the query, dimensions: size
+ *             @ float* weights:= the weights of the attention, dimensions: window*(window+1)*size
+ *             @ float* scores:= where the scores after the tanh are stored, dimensions: window
+ *             @ float* attention:= where the softmax of the scores is stored, dimensions: window
+ *             @ float* context:= where the context is summed, dimensions: size
+ *             @ int window:= the number of values
+ *             @ int size:= the size of each value and of the query
+ * */
+void attention_feed_forward(float* keys, float* values, float* query, float* weights, float* scores, float* attention, float* context, int window, int size){
+    int i;
+    float max,sum = 0;
+    copy_array(keys,scores,window);
+    sgemv(window,size,&weights[window*size],(window+1)*size,query,scores);
+    
+    for(i = 0; i < window; i++){
+        scores[i] = tanhf(scores[i]);
+    }
+    max = scores[0];
+    for(i = 1; i < window; i++){
+        if(scores[i] > max)
+            max = scores[i];
+    }
+    for(i = 0; i < window; i++){
+        attention[i] = expf(scores[i]-max);
+        sum += attention[i];
+    }
+    sum = 1/sum;
+    for(i = 0; i < window; i++){
+        attention[i] *= sum;
+    }
+    
+    sgemv_t(window,size,values,size,attention,context);
+}
+
+/* This function computes the back propagation of the attention of a timestep through the softmax and the tanh, the errors of the
+ * scores are stored to compute later the errors of the weights and of the values with attention_weights_back_prop
+ * 
+ * Input:
+ * 
+ *             @ float* values:= the values, dimensions: window*size
+ *             @ float* weights:= the weights of the attention, dimensions: window*(window+1)*size
+ *             @ float* scores:= the scores after the tanh computed by attention_feed_forward, dimensions: window
+ *             @ float* attention:= the softmax computed by attention_feed_forward, dimensions: window
+ *             @ float* context_error:= the error of the context, dimensions: size
+ *             @ float* scores_error:= where the errors of the scores before the tanh are stored, dimensions: window
+ *             @ float* query_error:= where the error of the query is summed, dimensions: size
+ *             @ int window:= the number of values
+ *             @ int size:= the size of each value and of the query
+ * */
+void attention_back_prop(float* values, float* weights, float* scores, float* attention, float* context_error, float* scores_error, float* query_error, int window, int size){
+    int i;
+    float sum = 0;
+    memset(scores_error,0,sizeof(float)*window);
+    sgemv(window,size,values,size,context_error,scores_error);
+    
+    for(i = 0; i < window; i++){
+        sum += attention[i]*scores_error[i];
+    }
+    for(i = 0; i < window; i++){
+        scores_error[i] = attention[i]*(scores_error[i]-sum)*(1-scores[i]*scores[i]);
+    }
+    
+    sgemv_t(window,size,&weights[window*size],(window+1)*size,scores_error,query_error);
+}
+
+/* This function sums the errors of the weights, of the biases and of the values of the attention
+ * for all the timesteps back propagated with attention_back_prop
+ * 
+ * Input:
+ * 
+ *             @ float* values:= the values, dimensions: window*size
+ *             @ float* queries:= the queries of the timesteps, dimensions: steps*size
+ *             @ float* attention:= the softmax of the timesteps, dimensions: steps*window
+ *             @ float* contexts_error:= the errors of the contexts of the timesteps, dimensions: steps*size
+ *             @ float* scores_error:= the errors of the scores of the timesteps, dimensions: steps*window
+ *             @ float* weights:= the weights of the attention, dimensions: window*(window+1)*size
+ *             @ float* weights_error:= where the errors of the weights are summed, dimensions: window*(window+1)*size
+ *             @ float* biases_error:= where the errors of the biases are summed, dimensions: window
+ *             @ float* values_error:= where the errors of the values are summed, dimensions: window*size
+ *             @ float* temp:= a temporary array, dimensions: window
+ *             @ int window:= the number of values
+ *             @ int size:= the size of each value and of the queries
+ *             @ int steps:= the number of timesteps
+ * */
+void attention_weights_back_prop(float* values, float* queries, float* attention, float* contexts_error, float* scores_error, float* weights, float* weights_error, float* biases_error, float* values_error, float* temp, int window, int size, int steps){
+    int i;
+    // the keys are shared by all the timesteps, so only the sum of the errors of the scores is needed for them
+    memset(temp,0,sizeof(float)*window);
+    for(i = 0; i < steps; i++){
+        sum1D(temp,&scores_error[i*window],temp,window);
+    }
+    sum1D(biases_error,temp,biases_error,window);
+    sger(window,window*size,temp,values,weights_error,(window+1)*size);
+    sgemv_t(window,window*size,weights,(window+1)*size,temp,values_error);
+    
+    sgemm_tn(window,size,steps,scores_error,window,queries,size,&weights_error[window*size],(window+1)*size);
+    sgemm_tn(window,size,steps,attention,window,contexts_error,size,values_error,size);
+}
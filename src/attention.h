@@ -0,0 +1,34 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef __ATTENTION_H__
+#define __ATTENTION_H__
+
+void attention_keys(float* values, float* weights, float* biases, float* keys, int window, int size);
+void attention_feed_forward(float* keys, float* values, float* query, float* weights, float* scores, float* attention, float* context, int window, int size);
+void attention_back_prop(float* values, float* weights, float* scores, float* attention, float* context_error, float* scores_error, float* query_error, int window, int size);
+void attention_weights_back_prop(float* values, float* queries, float* attention, float* contexts_error, float* scores_error, float* weights, float* weights_error, float* biases_error, float* values_error, float* temp, int window, int size, int steps);
+
+#endif
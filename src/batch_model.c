@@ -0,0 +1,619 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "llab.h"
+
+/* This function creates a model with the first layers of m, that must be convolutional or residual layers.
+ * The layers of the new model share the weights, the biases and the optimizer arrays with the layers of m,
+ * while the arrays used during the feed forward and back propagation and the partial derivatives are owned by the new model.
+ * The returned model must be deallocated with free_shared_model_prefix
+ * 
+ * Input:
+ *             
+ *             @ model* m:= the model that owns the parameters
+ *             @ int layers:= the number of layers of m that must be shared (all the convolutional and residual layers of m)
+ * 
+ * */
+model* share_model_prefix(model* m, int layers){
+    if(m == NULL)
+        return NULL;
+    
+    int i;
+    cl** cls = NULL;
+    rl** rls = NULL;
+    
+    if(m->n_cl)
+        cls = (cl**)malloc(sizeof(cl*)*m->n_cl);
+    if(m->n_rl)
+        rls = (rl**)malloc(sizeof(rl*)*m->n_rl);
+    
+    for(i = 0; i < m->n_cl; i++){
+        cls[i] = share_cl(m->cls[i]);
+    }
+    for(i = 0; i < m->n_rl; i++){
+        rls[i] = share_rl(m->rls[i]);
+    }
+    
+    model* s = network(layers, m->n_rl, m->n_cl, 0, rls, cls, NULL);
+    s->beta1_adam = m->beta1_adam;
+    s->beta2_adam = m->beta2_adam;
+    s->beta3_adamod = m->beta3_adamod;
+    return s;
+}
+
+/* This function frees the space allocated by a model created with share_model_prefix,
+ * the shared arrays are not freed
+ * 
+ * Input:
+ *             @ model* m:= the shared model
+ * 
+ * */
+void free_shared_model_prefix(model* m){
+    if(m == NULL)
+        return;
+    int i;
+    
+    for(i = 0; i < m->n_rl; i++){
+        free_shared_rl(m->rls[i]);
+    }
+    free(m->rls);
+    for(i = 0; i < m->n_cl; i++){
+        free_shared_cl(m->cls[i]);
+    }
+    free(m->cls);
+    for(i = 0; i < m->layers; i++){
+        free(m->sla[i]);
+    }
+    free(m->sla);
+    free(m->error);
+    free(m->error_alpha);
+    free(m);
+}
+
+/* This function creates the structure used to compute the feed forward and the back propagation
+ * of a model for a whole batch with only one copy of the weights. The fully-connected layers
+ * keep their activations as batch_size*features matrices, and are computed for the whole batch at once.
+ * The convolutional and residual layers (that must come before the fully-connected layers) are computed
+ * for each instance by batch_size models sharing their parameters with m.
+ * The partial derivatives are accumulated inside m, in the same order you would get summing the partial derivatives
+ * of batch_size copies of m with sum_model_partial_derivatives, so you can update m directly with update_model
+ * 
+ * Input:
+ *             
+ *             @ model* m:= the model, it is not copied
+ *             @ int batch_size:= the size of the batch
+ * 
+ * */
+bmodel* batch_model(model* m, int batch_size){
+    return batch_model_precision(m,batch_size,FP32_PRECISION);
+}
+
+/* This function creates a batched model like batch_model, choosing the precision of the fully-connected layers.
+ * With BF16_PRECISION or FP16_PRECISION the gemms read a 16 bits copy of the weights of m, refreshed by reset_batch_model
+ * and sync_batch_model_weights, and the activations kept for the back propagation are stored in 16 bits, while
+ * the float arrays used during the computation are shared by the layers (but the last one, whose output stays float).
+ * The weights of m, the partial derivatives and the accumulations stay float, so m can be updated and saved as usual.
+ * You can scale the errors of the outputs with a loss_scaler and unscale the partial derivatives with unscale_model_partial_derivatives
+ * 
+ * Input:
+ *             
+ *             @ model* m:= the model, it is not copied
+ *             @ int batch_size:= the size of the batch
+ *             @ int precision:= FP32_PRECISION, BF16_PRECISION or FP16_PRECISION
+ * 
+ * */
+bmodel* batch_model_precision(model* m, int batch_size, int precision){
+    if(m == NULL || batch_size < 1){
+        fprintf(stderr,"Error: you need a model and a batch size > 0 to create a batched model\n");
+        exit(1);
+    }
+    
+    int i,j,k,prefix_layers,max_output = 0;
+    
+    if(precision < FP32_PRECISION || precision > FP16_PRECISION){
+        fprintf(stderr,"Error: unknown precision for a batched model\n");
+        exit(1);
+    }
+    
+    for(prefix_layers = 0; prefix_layers < m->layers && m->sla[prefix_layers][0] != FCLS; prefix_layers++);
+    
+    for(i = prefix_layers; i < m->layers; i++){
+        if(m->sla[i][0] != FCLS){
+            fprintf(stderr,"Error: with a batched model the fully-connected layers must be the last layers of the model\n");
+            exit(1);
+        }
+    }
+    
+    for(i = 0; i < m->n_fcl; i++){
+        if(m->fcls[i]->feed_forward_flag != FULLY_FEED_FORWARD || m->fcls[i]->training_mode == EDGE_POPUP || m->fcls[i]->normalization_flag == LAYER_NORMALIZATION){
+            fprintf(stderr,"Error: a batched model supports only fully-connected layers without edge popup and layer normalization, layer: %d\n",m->fcls[i]->layer);
+            exit(1);
+        }
+    }
+    
+    bmodel* bm = (bmodel*)malloc(sizeof(bmodel));
+    bm->m = m;
+    bm->batch_size = batch_size;
+    bm->prefix = NULL;
+    bm->input = NULL;
+    bm->error = NULL;
+    bm->error_rows = NULL;
+    bm->outputs = NULL;
+    bm->pre_activation = NULL;
+    bm->post_activation = NULL;
+    bm->dropout_mask = NULL;
+    bm->dropout_temp = NULL;
+    bm->temp = NULL;
+    bm->temp3 = NULL;
+    bm->error2 = NULL;
+    bm->precision = precision;
+    bm->weights_half = NULL;
+    bm->pre_activation_half = NULL;
+    bm->outputs_half = NULL;
+    bm->scratch = NULL;
+    
+    if(prefix_layers){
+        bm->prefix = (model**)malloc(sizeof(model*)*batch_size);
+        for(i = 0; i < batch_size; i++){
+            bm->prefix[i] = share_model_prefix(m,prefix_layers);
+        }
+    }
+    
+    if(m->n_fcl){
+        bm->input = (float*)calloc(batch_size*m->fcls[0]->input,sizeof(float));
+        bm->error = (float*)calloc(batch_size*m->fcls[m->n_fcl-1]->output,sizeof(float));
+        bm->error_rows = (float**)malloc(sizeof(float*)*batch_size);
+        bm->outputs = (float**)malloc(sizeof(float*)*m->n_fcl);
+        bm->pre_activation = (float**)malloc(sizeof(float*)*m->n_fcl);
+        bm->post_activation = (float**)malloc(sizeof(float*)*m->n_fcl);
+        bm->dropout_mask = (float**)malloc(sizeof(float*)*m->n_fcl);
+        bm->dropout_temp = (float**)malloc(sizeof(float*)*m->n_fcl);
+        bm->temp = (float**)malloc(sizeof(float*)*m->n_fcl);
+        bm->temp3 = (float**)malloc(sizeof(float*)*m->n_fcl);
+        bm->error2 = (float**)malloc(sizeof(float*)*m->n_fcl);
+        if(precision != FP32_PRECISION){
+            bm->weights_half = (unsigned short**)malloc(sizeof(unsigned short*)*m->n_fcl);
+            bm->pre_activation_half = (unsigned short**)malloc(sizeof(unsigned short*)*m->n_fcl);
+            bm->outputs_half = (unsigned short**)malloc(sizeof(unsigned short*)*m->n_fcl);
+            bm->scratch = (float**)malloc(sizeof(float*)*2*BMODEL_SCRATCH);
+            for(i = 0; i < m->n_fcl-1; i++){
+                if(m->fcls[i]->output > max_output)
+                    max_output = m->fcls[i]->output;
+            }
+            for(i = 0; i < 2*BMODEL_SCRATCH; i++){
+                bm->scratch[i] = (float*)calloc(batch_size*max_output,sizeof(float));
+            }
+        }
+        for(i = 0; i < m->n_fcl; i++){
+            if(precision != FP32_PRECISION && i < m->n_fcl-1){
+                // the layers i and i+1 use different scratch arrays, the float activations of a layer are still there for the next one
+                k = (i%2)*BMODEL_SCRATCH;
+                bm->pre_activation[i] = bm->scratch[k];
+                bm->post_activation[i] = bm->scratch[k+1];
+                bm->dropout_temp[i] = bm->scratch[k+2];
+                bm->temp[i] = bm->scratch[k+3];
+                bm->temp3[i] = bm->scratch[k+4];
+                bm->pre_activation_half[i] = (unsigned short*)calloc(batch_size*m->fcls[i]->output,sizeof(unsigned short));
+                bm->outputs_half[i] = (unsigned short*)calloc(batch_size*m->fcls[i]->output,sizeof(unsigned short));
+            }
+            else{
+                bm->pre_activation[i] = (float*)calloc(batch_size*m->fcls[i]->output,sizeof(float));
+                bm->post_activation[i] = (float*)calloc(batch_size*m->fcls[i]->output,sizeof(float));
+                bm->dropout_temp[i] = (float*)calloc(batch_size*m->fcls[i]->output,sizeof(float));
+                bm->temp[i] = (float*)calloc(batch_size*m->fcls[i]->output,sizeof(float));
+                bm->temp3[i] = (float*)calloc(batch_size*m->fcls[i]->output,sizeof(float));
+                if(precision != FP32_PRECISION){
+                    bm->pre_activation_half[i] = NULL;
+                    bm->outputs_half[i] = NULL;
+                }
+            }
+            if(precision != FP32_PRECISION)
+                bm->weights_half[i] = (unsigned short*)malloc(sizeof(unsigned short)*m->fcls[i]->output*m->fcls[i]->input);
+            bm->dropout_mask[i] = (float*)calloc(batch_size*m->fcls[i]->output,sizeof(float));
+            bm->error2[i] = (float*)calloc(batch_size*m->fcls[i]->input,sizeof(float));
+            bm->outputs[i] = bm->pre_activation[i];
+            if(m->fcls[i]->dropout_flag){
+                for(j = 0; j < batch_size*m->fcls[i]->output; j++){
+                    bm->dropout_mask[i][j] = 1;
+                }
+            }
+        }
+        
+        for(i = 0; i < batch_size; i++){
+            bm->error_rows[i] = &bm->error2[0][i*m->fcls[0]->input];
+        }
+    }
+    
+    sync_batch_model_weights(bm);
+    return bm;
+}
+
+/* This function copies the weights of the model of a batched model in the 16 bits weights used by the gemms,
+ * nothing is done with FP32_PRECISION. reset_batch_model already calls it, you need it only if the weights of the model
+ * change without a reset of the batched model
+ * 
+ * Input:
+ *             @ bmodel* bm:= the batched model
+ * 
+ * */
+void sync_batch_model_weights(bmodel* bm){
+    if(bm == NULL || bm->precision == FP32_PRECISION)
+        return;
+    int i;
+    for(i = 0; i < bm->m->n_fcl; i++){
+        float_to_half_array(bm->precision,bm->m->fcls[i]->weights,bm->weights_half[i],bm->m->fcls[i]->output*bm->m->fcls[i]->input);
+    }
+}
+
+/* This function frees the space allocated by a batched model, the model m is not deallocated
+ * 
+ * Input:
+ *             @ bmodel* bm:= the batched model
+ * 
+ * */
+void free_batch_model(bmodel* bm){
+    if(bm == NULL)
+        return;
+    int i;
+    if(bm->prefix != NULL){
+        for(i = 0; i < bm->batch_size; i++){
+            free_shared_model_prefix(bm->prefix[i]);
+        }
+        free(bm->prefix);
+    }
+    
+    if(bm->m->n_fcl){
+        for(i = 0; i < bm->m->n_fcl; i++){
+            if(bm->precision == FP32_PRECISION || i == bm->m->n_fcl-1){
+                free(bm->pre_activation[i]);
+                free(bm->post_activation[i]);
+                free(bm->dropout_temp[i]);
+                free(bm->temp[i]);
+                free(bm->temp3[i]);
+            }
+            if(bm->precision != FP32_PRECISION){
+                free(bm->weights_half[i]);
+                free(bm->pre_activation_half[i]);
+                free(bm->outputs_half[i]);
+            }
+            free(bm->dropout_mask[i]);
+            free(bm->error2[i]);
+        }
+        if(bm->precision != FP32_PRECISION){
+            free_matrix(bm->scratch,2*BMODEL_SCRATCH);
+            free(bm->weights_half);
+            free(bm->pre_activation_half);
+            free(bm->outputs_half);
+        }
+        free(bm->pre_activation);
+        free(bm->post_activation);
+        free(bm->dropout_mask);
+        free(bm->dropout_temp);
+        free(bm->temp);
+        free(bm->temp3);
+        free(bm->error2);
+        free(bm->outputs);
+        free(bm->error_rows);
+        free(bm->input);
+        free(bm->error);
+    }
+    free(bm);
+}
+
+/* This function resets the arrays used by the feed forward and back propagation of a batched model
+ * and the partial derivatives of its model m, the weights don't change. The winograd kernels of the
+ * views are invalidated and the 16 bits weights are copied again from m, because m could have been updated
+ * 
+ * Input:
+ *             @ bmodel* bm:= the batched model
+ * 
+ * */
+void reset_batch_model(bmodel* bm){
+    if(bm == NULL)
+        return;
+    int i,j,size;
+    reset_model(bm->m);
+    if(bm->prefix != NULL){
+        for(i = 0; i < bm->batch_size; i++){
+            reset_model(bm->prefix[i]);
+            invalidate_model_winograd_kernels(bm->prefix[i]);
+        }
+    }
+    
+    for(i = 0; i < bm->m->n_fcl; i++){
+        size = bm->batch_size*bm->m->fcls[i]->output;
+        memset(bm->pre_activation[i],0,sizeof(float)*size);
+        memset(bm->post_activation[i],0,sizeof(float)*size);
+        memset(bm->dropout_temp[i],0,sizeof(float)*size);
+        memset(bm->temp[i],0,sizeof(float)*size);
+        memset(bm->temp3[i],0,sizeof(float)*size);
+        memset(bm->error2[i],0,sizeof(float)*bm->batch_size*bm->m->fcls[i]->input);
+        if(bm->m->fcls[i]->dropout_flag){
+            for(j = 0; j < size; j++){
+                bm->dropout_mask[i][j] = 1;
+            }
+        }
+    }
+    sync_batch_model_weights(bm);
+}
+
+/* This function returns the output of the model for an instance of the batch, after model_tensor_input_ff_batch
+ * 
+ * Input:
+ *             @ bmodel* bm:= the batched model
+ *             @ int index:= the index of the instance in the batch
+ * 
+ * */
+float* get_batch_model_output(bmodel* bm, int index){
+    if(bm->m->n_fcl)
+        return &bm->outputs[bm->m->n_fcl-1][index*bm->m->fcls[bm->m->n_fcl-1]->output];
+    return bm->prefix[index]->output_layer;
+}
+
+/* This function computes the feed forward of a model for a whole batch of inputs. The fully-connected layers
+ * are computed for the whole batch at once, using each row of the weights for all the instances,
+ * the convolutional and residual layers are computed for each instance with threads threads.
+ * 
+ * Input:
+ *             
+ *             @ bmodel* bm:= the batched model
+ *             @ int tensor_depth:= the depth of the input tensor
+ *             @ int tensor_i:= the number of rows of the tensor
+ *             @ int tensor_j:= the number of columns of the tensor
+ *             @ float** inputs:= the inputs of the batch, dimensions: batch_size*(tensor_depth*tensor_i*tensor_j)
+ *             @ int threads:= the number of threads used for the convolutional and residual layers
+ * 
+ * */
+void model_tensor_input_ff_batch(bmodel* bm, int tensor_depth, int tensor_i, int tensor_j, float** inputs, int threads){
+    if(bm == NULL)
+        return;
+    
+    model* m = bm->m;
+    int i,j,size;
+    fcl* f;
+    float* input;
+    
+    if(bm->prefix != NULL)
+        model_tensor_input_ff_multicore(bm->prefix,tensor_depth,tensor_i,tensor_j,inputs,bm->batch_size,threads);
+    
+    if(!m->n_fcl)
+        return;
+    
+    if(bm->prefix == NULL && tensor_depth*tensor_i*tensor_j != m->fcls[0]->input){
+        fprintf(stderr,"Error: the sizes between the input and the first fully-connected layer don't match, layer: %d\n",m->fcls[0]->layer);
+        exit(1);
+    }
+    
+    for(i = 0; i < bm->batch_size; i++){
+        if(bm->prefix != NULL)
+            copy_array(bm->prefix[i]->output_layer,&bm->input[i*m->fcls[0]->input],m->fcls[0]->input);
+        else
+            copy_array(inputs[i],&bm->input[i*m->fcls[0]->input],m->fcls[0]->input);
+    }
+    
+    for(i = 0; i < m->n_fcl; i++){
+        f = m->fcls[i];
+        
+        if(f->feed_forward_flag != FULLY_FEED_FORWARD || f->training_mode == EDGE_POPUP || f->normalization_flag == LAYER_NORMALIZATION){
+            fprintf(stderr,"Error: a batched model supports only fully-connected layers without edge popup and layer normalization, layer: %d\n",f->layer);
+            exit(1);
+        }
+        
+        if(f->activation_flag == SOFTMAX && i != m->n_fcl-1){
+            fprintf(stderr,"Error: the softmax can be applied only on the last fully-connected layers\n");
+            exit(1);
+        }
+        
+        if(i && m->fcls[i-1]->output != f->input){
+            fprintf(stderr,"Error: the sizes between 2 fully-connected layers don't match, layer1: %d, layer2: %d\n",m->fcls[i-1]->layer,f->layer);
+            exit(1);
+        }
+        
+        size = bm->batch_size*f->output;
+        
+        if(!i)
+            input = bm->input;
+        else
+            input = bm->outputs[i-1];
+        
+        if(bm->precision != FP32_PRECISION)
+            fully_connected_feed_forward_batch_half(input, bm->pre_activation[i], bm->weights_half[i], f->biases, f->input, f->output, bm->batch_size, bm->precision);
+        else
+            fully_connected_feed_forward_batch(input, bm->pre_activation[i], f->weights, f->biases, f->input, f->output, bm->batch_size);
+        
+        /* computing the activation for f (if the activation_flag is > 0)*/
+        if(f->activation_flag == SIGMOID)
+            sigmoid_array(bm->pre_activation[i],bm->post_activation[i],size);
+        else if(f->activation_flag == RELU)
+            relu_array(bm->pre_activation[i],bm->post_activation[i],size);
+        else if(f->activation_flag == ELU)
+            elu_array(bm->pre_activation[i],bm->post_activation[i],size,ELU_THRESHOLD);
+        else if(f->activation_flag == SOFTMAX){
+            for(j = 0; j < bm->batch_size; j++){
+                softmax(&bm->pre_activation[i][j*f->output],&bm->post_activation[i][j*f->output],f->output);
+            }
+        }
+        else if(f->activation_flag == TANH)
+            tanhh_array(bm->pre_activation[i],bm->post_activation[i],size);
+        else if(f->activation_flag == LEAKY_RELU)
+            leaky_relu_array(bm->pre_activation[i],bm->post_activation[i],size);
+        
+        /* setting the dropout mask and the output of f, with the same arrays used by ff_fcl_fcl*/
+        if(f->activation_flag)
+            bm->outputs[i] = bm->post_activation[i];
+        else
+            bm->outputs[i] = bm->pre_activation[i];
+        
+        if(f->dropout_flag){
+            set_dropout_mask(size, bm->dropout_mask[i], f->dropout_threshold);
+            if(f->dropout_flag == DROPOUT){
+                if(f->activation_flag)
+                    get_dropout_array(size,bm->dropout_mask[i],bm->pre_activation[i],bm->dropout_temp[i]);
+                else
+                    get_dropout_array(size,bm->dropout_mask[i],bm->post_activation[i],bm->dropout_temp[i]);
+            }
+            else if(f->dropout_flag == DROPOUT_TEST)
+                mul_value(bm->outputs[i],f->dropout_threshold,bm->dropout_temp[i],size);
+            bm->outputs[i] = bm->dropout_temp[i];
+        }
+        
+        /* keeping in 16 bits what the back propagation needs, the float arrays will be used by the layer i+2*/
+        if(bm->precision != FP32_PRECISION && i < m->n_fcl-1){
+            if(f->activation_flag != NO_ACTIVATION)
+                float_to_half_array(bm->precision,bm->pre_activation[i],bm->pre_activation_half[i],size);
+            float_to_half_array(bm->precision,bm->outputs[i],bm->outputs_half[i],size);
+        }
+    }
+}
+
+/* This function computes the back propagation of a model for a whole batch, after model_tensor_input_ff_batch.
+ * The partial derivatives are accumulated inside the model bm->m
+ * 
+ * Input:
+ *             
+ *             @ bmodel* bm:= the batched model
+ *             @ int tensor_depth:= the depth of the input tensor
+ *             @ int tensor_i:= the number of rows of the tensor
+ *             @ int tensor_j:= the number of columns of the tensor
+ *             @ float** inputs:= the inputs of the batch, dimensions: batch_size*(tensor_depth*tensor_i*tensor_j)
+ *             @ float** errors:= the errors of the batch, dimensions: batch_size*error_dimension
+ *             @ int error_dimension:= the dimension of each error
+ *             @ float** returning_error:= where are stored the errors of the inputs, can be NULL, dimensions: batch_size*(tensor_depth*tensor_i*tensor_j)
+ *             @ int threads:= the number of threads used for the convolutional and residual layers
+ * 
+ * */
+void model_tensor_input_bp_batch(bmodel* bm, int tensor_depth, int tensor_i, int tensor_j, float** inputs, float** errors, int error_dimension, float** returning_error, int threads){
+    if(bm == NULL)
+        return;
+    
+    model* m = bm->m;
+    int i,j,size;
+    fcl* f;
+    float* error;
+    float* input;
+    
+    if(!m->n_fcl){
+        model_tensor_input_bp_multicore(bm->prefix,tensor_depth,tensor_i,tensor_j,inputs,bm->batch_size,threads,errors,error_dimension,returning_error);
+        for(i = 0; i < bm->batch_size; i++){
+            sum_model_partial_derivatives(bm->prefix[i],m,m);
+        }
+        return;
+    }
+    
+    if(error_dimension != m->fcls[m->n_fcl-1]->output){
+        fprintf(stderr,"Error: the error dimension doesn't match the output of the last fully-connected layer\n");
+        exit(1);
+    }
+    
+    for(i = 0; i < bm->batch_size; i++){
+        copy_array(errors[i],&bm->error[i*error_dimension],error_dimension);
+    }
+    
+    for(i = m->n_fcl-1; i >= 0; i--){
+        f = m->fcls[i];
+        size = bm->batch_size*f->output;
+        
+        if(i == m->n_fcl-1)
+            error = bm->error;
+        else
+            error = bm->error2[i+1];
+        
+        if(bm->precision != FP32_PRECISION && i < m->n_fcl-1 && f->activation_flag != NO_ACTIVATION)
+            half_to_float_array(bm->precision,bm->pre_activation_half[i],bm->pre_activation[i],size);
+        
+        /*computing the backpropagation for f, as bp_fcl_fcl does*/
+        if(f->dropout_flag){
+            dot1D(error,bm->dropout_mask[i],bm->temp[i],size);
+            if(f->activation_flag == SOFTMAX){
+                for(j = 0; j < bm->batch_size; j++){
+                    derivative_softmax_array(f->active_output_neurons,&bm->temp3[i][j*f->output],&bm->post_activation[i][j*f->output],&bm->temp[i][j*f->output],f->output);
+                }
+                copy_array(bm->temp3[i],bm->temp[i],size);
+            }
+            else if(f->activation_flag != NO_ACTIVATION){
+                if(f->activation_flag == SIGMOID)
+                    derivative_sigmoid_array(bm->pre_activation[i],bm->temp3[i],size);
+                else if(f->activation_flag == RELU)
+                    derivative_relu_array(bm->pre_activation[i],bm->temp3[i],size);
+                else if(f->activation_flag == ELU)
+                    derivative_elu_array(bm->pre_activation[i],bm->temp3[i],size,ELU_THRESHOLD);
+                else if(f->activation_flag == TANH)
+                    derivative_tanhh_array(bm->pre_activation[i],bm->temp3[i],size);
+                else if(f->activation_flag == LEAKY_RELU)
+                    derivative_leaky_relu_array(bm->pre_activation[i],bm->temp3[i],size);
+                dot1D(bm->temp3[i],bm->temp[i],bm->temp[i],size);
+            }
+        }
+        
+        else{
+            if(f->activation_flag == SOFTMAX){
+                for(j = 0; j < bm->batch_size; j++){
+                    derivative_softmax_array(f->active_output_neurons,&bm->temp[i][j*f->output],&bm->post_activation[i][j*f->output],&error[j*f->output],f->output);
+                }
+            }
+            else if(f->activation_flag != NO_ACTIVATION){
+                if(f->activation_flag == SIGMOID)
+                    derivative_sigmoid_array(bm->pre_activation[i],bm->temp3[i],size);
+                else if(f->activation_flag == RELU)
+                    derivative_relu_array(bm->pre_activation[i],bm->temp3[i],size);
+                else if(f->activation_flag == ELU)
+                    derivative_elu_array(bm->pre_activation[i],bm->temp3[i],size,ELU_THRESHOLD);
+                else if(f->activation_flag == TANH)
+                    derivative_tanhh_array(bm->pre_activation[i],bm->temp3[i],size);
+                else if(f->activation_flag == LEAKY_RELU)
+                    derivative_leaky_relu_array(bm->pre_activation[i],bm->temp3[i],size);
+                dot1D(bm->temp3[i],error,bm->temp[i],size);
+            }
+            else
+                copy_array(error,bm->temp[i],size);
+        }
+        
+        if(!i)
+            input = bm->input;
+        else{
+            input = bm->outputs[i-1];
+            if(bm->precision != FP32_PRECISION)
+                half_to_float_array(bm->precision,bm->outputs_half[i-1],input,bm->batch_size*f->input);
+        }
+        
+        /* computing the weight and bias derivatives for f for the whole batch*/
+        if(bm->precision != FP32_PRECISION)
+            fully_connected_back_prop_batch_half(input, bm->temp[i], bm->weights_half[i], bm->error2[i], f->d_weights, f->d_biases, f->input, f->output, bm->batch_size, bm->precision);
+        else
+            fully_connected_back_prop_batch(input, bm->temp[i], f->weights, bm->error2[i], f->d_weights, f->d_biases, f->input, f->output, bm->batch_size);
+    }
+    
+    if(bm->prefix != NULL){
+        model_tensor_input_bp_multicore(bm->prefix,tensor_depth,tensor_i,tensor_j,inputs,bm->batch_size,threads,bm->error_rows,m->fcls[0]->input,returning_error);
+        for(i = 0; i < bm->batch_size; i++){
+            sum_model_partial_derivatives(bm->prefix[i],m,m);
+        }
+    }
+    
+    else if(returning_error != NULL){
+        for(i = 0; i < bm->batch_size; i++){
+            returning_error[i] = bm->error_rows[i];
+        }
+    }
+}
@@ -0,0 +1,39 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __BATCH_MODEL_H__
+#define __BATCH_MODEL_H__
+
+bmodel* batch_model(model* m, int batch_size);
+bmodel* batch_model_precision(model* m, int batch_size, int precision);
+void sync_batch_model_weights(bmodel* bm);
+void free_batch_model(bmodel* bm);
+void reset_batch_model(bmodel* bm);
+model* share_model_prefix(model* m, int layers);
+void free_shared_model_prefix(model* m);
+float* get_batch_model_output(bmodel* bm, int index);
+void model_tensor_input_ff_batch(bmodel* bm, int tensor_depth, int tensor_i, int tensor_j, float** inputs, int threads);
+void model_tensor_input_bp_batch(bmodel* bm, int tensor_depth, int tensor_i, int tensor_j, float** inputs, float** errors, int error_dimension, float** returning_error, int threads);
+
+#endif
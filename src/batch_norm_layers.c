@@ -722,6 +722,27 @@ bn* copy_bn(bn* b){
  * 
  * */
 bn* reset_bn(bn* b){
+    if(b == NULL)
+        return NULL;
+    int i;
+    reset_bn_except_partial_derivatives(b);
+    for(i = 0; i < b->vector_dim; i++){
+        b->d_gamma[i] = 0; 
+        b->d_beta[i] = 0; 
+    } 
+    
+    return b;
+}
+
+/* this function resets all the arrays of a batch normalized layer like reset_bn, except for the partial derivatives
+ * d_gamma and d_beta that are left untouched
+ * 
+ * Input:
+ * 
+ *             @ bn* b:= a bn* b layer
+ * 
+ * */
+bn* reset_bn_except_partial_derivatives(bn* b){
     if(b == NULL)
         return NULL;
     int i,j;
@@ -735,8 +756,6 @@ bn* reset_bn(bn* b){
             b->temp1[j][i] = 0;
         }
         
-        b->d_gamma[i] = 0; 
-        b->d_beta[i] = 0; 
         b->temp2[i] = 0; 
         b->mean[i] = 0; 
         b->var[i] = 0; 
@@ -839,3 +858,71 @@ void slow_paste_bn(bn* f, bn* copy,float tau){
     
     return;
 }
+
+/* This function returns a bn* layer that shares the weights, biases and the optimizer
+ * arrays (d1,d2,d3 and ex_d) with the layer b, while the arrays used during the feed forward,
+ * the back propagation and the partial derivatives d_gamma, d_beta are owned by the new layer.
+ * The returned layer must be deallocated with free_shared_bn.
+ * 
+ * Input:
+ * 
+ *             @ bn* b:= the batch normalized layer that owns the parameters
+ * 
+ * */
+bn* share_bn(bn* b){
+    if(b == NULL)
+        return NULL;
+    bn* s = batch_normalization(b->batch_size,b->vector_dim, b->layer, b->activation_flag);
+    free(s->gamma);
+    free(s->ex_d_gamma_diff_grad);
+    free(s->d1_gamma);
+    free(s->d2_gamma);
+    free(s->d3_gamma);
+    free(s->beta);
+    free(s->ex_d_beta_diff_grad);
+    free(s->d1_beta);
+    free(s->d2_beta);
+    free(s->d3_beta);
+    free(s->final_mean);
+    free(s->final_var);
+    s->gamma = b->gamma;
+    s->ex_d_gamma_diff_grad = b->ex_d_gamma_diff_grad;
+    s->d1_gamma = b->d1_gamma;
+    s->d2_gamma = b->d2_gamma;
+    s->d3_gamma = b->d3_gamma;
+    s->beta = b->beta;
+    s->ex_d_beta_diff_grad = b->ex_d_beta_diff_grad;
+    s->d1_beta = b->d1_beta;
+    s->d2_beta = b->d2_beta;
+    s->d3_beta = b->d3_beta;
+    s->final_mean = b->final_mean;
+    s->final_var = b->final_var;
+    s->mode_flag = b->mode_flag;
+    s->epsilon = b->epsilon;
+    return s;
+}
+
+/* This function deallocates a bn* layer created with share_bn, the shared arrays are not freed
+ * 
+ * Input:
+ * 
+ *             @ bn* b:= the shared batch normalized layer
+ * 
+ * */
+void free_shared_bn(bn* b){
+    if(b == NULL)
+        return;
+    b->gamma = NULL;
+    b->ex_d_gamma_diff_grad = NULL;
+    b->d1_gamma = NULL;
+    b->d2_gamma = NULL;
+    b->d3_gamma = NULL;
+    b->beta = NULL;
+    b->ex_d_beta_diff_grad = NULL;
+    b->d1_beta = NULL;
+    b->d2_beta = NULL;
+    b->d3_beta = NULL;
+    b->final_mean = NULL;
+    b->final_var = NULL;
+    free_batch_normalization(b);
+}
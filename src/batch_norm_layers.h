@@ -31,11 +31,14 @@ void save_bn(bn* b, int n);
 bn* load_bn(FILE* fr);
 bn* copy_bn(bn* b);
 bn* reset_bn(bn* b);
+bn* reset_bn_except_partial_derivatives(bn* b);
 unsigned long long int size_of_bn(bn* b);
 void paste_bn(bn* b1, bn* b2);
 void slow_paste_bn(bn* f, bn* copy,float tau);
 void paste_w_bn(bn* b1, bn* b2);
 void heavy_save_bn(bn* b, int n);
 bn* heavy_load_bn(FILE* fr);
+bn* share_bn(bn* b);
+void free_shared_bn(bn* b);
 
 #endif
@@ -0,0 +1,434 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include "llab.h"
+
+/* This function creates the structure used to compute the feed forward and the back propagation
+ * of a rmodel for a whole batch of sequences with only one copy of the weights. The sequences are computed in lockstep:
+ * the hidden states of a layer at a timestep are a batch_size*size matrix, so each recurrent step is a gemm
+ * instead of batch_size gemv, and the input projections of a layer are computed for all the timesteps and sequences at once.
+ * The partial derivatives are accumulated inside m, so you can update m directly with update_rmodel.
+ * The states before the first timestep are zero with a STATELESS rmodel, while with a STATEFUL rmodel
+ * each feed forward starts from the last states of the previous feed forward (see reset_batch_rmodel_states)
+ * 
+ * Input:
+ *             
+ *             @ rmodel* m:= the rmodel, it is not copied
+ *             @ int batch_size:= the size of the batch
+ * 
+ * */
+brmodel* batch_rmodel(rmodel* m, int batch_size){
+    if(m == NULL || batch_size < 1){
+        fprintf(stderr,"Error: you need a rmodel and a batch size > 0 to create a batched rmodel\n");
+        exit(1);
+    }
+    
+    int i,j,n,size = m->lstms[0]->size;
+    
+    for(i = 0; i < m->layers; i++){
+        if(m->lstms[i]->size != size || m->lstms[i]->cell_type != LSTM_CELL || m->lstms[i]->residual_flag == LSTM_RESIDUAL || m->lstms[i]->norm_flag == GROUP_NORMALIZATION){
+            fprintf(stderr,"Error: a batched rmodel supports only lstm layers (no gru) with the same size, without residual connections and group normalization, layer: %d\n",i);
+            exit(1);
+        }
+    }
+    
+    n = m->window*batch_size*size;
+    
+    brmodel* bm = (brmodel*)malloc(sizeof(brmodel));
+    bm->m = m;
+    bm->batch_size = batch_size;
+    bm->window = m->window;
+    bm->size = size;
+    bm->layers = m->layers;
+    bm->ff_flag = 0;
+    bm->input = (float*)calloc(n,sizeof(float));
+    bm->error = (float*)calloc(n,sizeof(float));
+    bm->input_error = (float*)calloc(n,sizeof(float));
+    bm->dh = (float*)calloc(batch_size*size,sizeof(float));
+    bm->dc = (float*)calloc(batch_size*size,sizeof(float));
+    bm->hidden_states = (float**)malloc(sizeof(float*)*m->layers);
+    bm->cell_states = (float**)malloc(sizeof(float*)*m->layers);
+    bm->hidden_states_error = (float**)malloc(sizeof(float*)*m->layers);
+    bm->cell_states_error = (float**)malloc(sizeof(float*)*m->layers);
+    bm->z = (float**)malloc(sizeof(float*)*m->layers);
+    bm->dz = (float**)malloc(sizeof(float*)*m->layers);
+    bm->hidden = (float**)malloc(sizeof(float*)*m->layers);
+    bm->cell = (float**)malloc(sizeof(float*)*m->layers);
+    bm->h_right = (float**)malloc(sizeof(float*)*m->layers);
+    bm->out_up = (float**)malloc(sizeof(float*)*m->layers);
+    bm->d_out_up = (float**)malloc(sizeof(float*)*m->layers);
+    bm->dropout_mask_up = (float**)malloc(sizeof(float*)*m->layers);
+    bm->dropout_mask_right = (float**)malloc(sizeof(float*)*m->layers);
+    
+    for(i = 0; i < m->layers; i++){
+        bm->hidden_states[i] = (float*)calloc(batch_size*size,sizeof(float));
+        bm->cell_states[i] = (float*)calloc(batch_size*size,sizeof(float));
+        bm->hidden_states_error[i] = (float*)calloc(batch_size*size,sizeof(float));
+        bm->cell_states_error[i] = (float*)calloc(batch_size*size,sizeof(float));
+        bm->z[i] = (float*)calloc(4*n,sizeof(float));
+        bm->dz[i] = (float*)calloc(4*n,sizeof(float));
+        bm->hidden[i] = (float*)calloc(n,sizeof(float));
+        bm->cell[i] = (float*)calloc(n,sizeof(float));
+        bm->h_right[i] = (float*)calloc(n,sizeof(float));
+        bm->out_up[i] = (float*)calloc(n,sizeof(float));
+        bm->d_out_up[i] = (float*)calloc(n,sizeof(float));
+        bm->dropout_mask_up[i] = (float*)malloc(sizeof(float)*batch_size*size);
+        bm->dropout_mask_right[i] = (float*)malloc(sizeof(float)*batch_size*size);
+        for(j = 0; j < batch_size*size; j++){
+            bm->dropout_mask_up[i][j] = 1;
+            bm->dropout_mask_right[i][j] = 1;
+        }
+    }
+    
+    return bm;
+}
+
+/* This function frees the space allocated by a batched rmodel, the rmodel m is not deallocated
+ * 
+ * Input:
+ *             @ brmodel* bm:= the batched rmodel
+ * 
+ * */
+void free_batch_rmodel(brmodel* bm){
+    if(bm == NULL)
+        return;
+    int i;
+    for(i = 0; i < bm->layers; i++){
+        free(bm->hidden_states[i]);
+        free(bm->cell_states[i]);
+        free(bm->hidden_states_error[i]);
+        free(bm->cell_states_error[i]);
+        free(bm->z[i]);
+        free(bm->dz[i]);
+        free(bm->hidden[i]);
+        free(bm->cell[i]);
+        free(bm->h_right[i]);
+        free(bm->out_up[i]);
+        free(bm->d_out_up[i]);
+        free(bm->dropout_mask_up[i]);
+        free(bm->dropout_mask_right[i]);
+    }
+    free(bm->hidden_states);
+    free(bm->cell_states);
+    free(bm->hidden_states_error);
+    free(bm->cell_states_error);
+    free(bm->z);
+    free(bm->dz);
+    free(bm->hidden);
+    free(bm->cell);
+    free(bm->h_right);
+    free(bm->out_up);
+    free(bm->d_out_up);
+    free(bm->dropout_mask_up);
+    free(bm->dropout_mask_right);
+    free(bm->input);
+    free(bm->error);
+    free(bm->input_error);
+    free(bm->dh);
+    free(bm->dc);
+    free(bm);
+}
+
+/* This function resets the partial derivatives of the rmodel m and the dropout masks of a batched rmodel,
+ * the weights and the states carried between the feed forwards of a STATEFUL rmodel don't change
+ * 
+ * Input:
+ *             @ brmodel* bm:= the batched rmodel
+ * 
+ * */
+void reset_batch_rmodel(brmodel* bm){
+    if(bm == NULL)
+        return;
+    int i,j;
+    reset_rmodel(bm->m);
+    for(i = 0; i < bm->layers; i++){
+        for(j = 0; j < bm->batch_size*bm->size; j++){
+            bm->dropout_mask_up[i][j] = 1;
+            bm->dropout_mask_right[i][j] = 1;
+        }
+    }
+}
+
+/* This function sets to zero the hidden and cell states before the first timestep of a batched rmodel,
+ * with a STATEFUL rmodel you should call it when the sequences of the batch start again (for example at each epoch)
+ * 
+ * Input:
+ *             @ brmodel* bm:= the batched rmodel
+ * 
+ * */
+void reset_batch_rmodel_states(brmodel* bm){
+    if(bm == NULL)
+        return;
+    int i;
+    for(i = 0; i < bm->layers; i++){
+        memset(bm->hidden_states[i],0,sizeof(float)*bm->batch_size*bm->size);
+        memset(bm->cell_states[i],0,sizeof(float)*bm->batch_size*bm->size);
+    }
+    bm->ff_flag = 0;
+}
+
+/* This function returns the output of the last layer at the timestep t for a sequence of the batch, after ff_rmodel_batch
+ * 
+ * Input:
+ *             @ brmodel* bm:= the batched rmodel
+ *             @ int index:= the index of the sequence in the batch
+ *             @ int t:= the timestep
+ * 
+ * */
+float* get_batch_rmodel_output(brmodel* bm, int index, int t){
+    return &bm->out_up[bm->layers-1][(t*bm->batch_size+index)*bm->size];
+}
+
+/* This function returns the error of the input at the timestep t for a sequence of the batch, after bp_rmodel_batch
+ * 
+ * Input:
+ *             @ brmodel* bm:= the batched rmodel
+ *             @ int index:= the index of the sequence in the batch
+ *             @ int t:= the timestep
+ * 
+ * */
+float* get_batch_rmodel_input_error(brmodel* bm, int index, int t){
+    return &bm->input_error[(t*bm->batch_size+index)*bm->size];
+}
+
+/* This function computes the feed forward of a rmodel for a whole batch of sequences.
+ * Each layer computes the input projections w*x+b of all the timesteps and sequences with a gemm for each gate,
+ * then for each timestep the recurrent products u*h of all the sequences with a gemm for each gate
+ * 
+ * Input:
+ *             
+ *             @ brmodel* bm:= the batched rmodel
+ *             @ float*** inputs:= the inputs of the batch, dimensions: batch_size*window*size
+ * 
+ * */
+void ff_rmodel_batch(brmodel* bm, float*** inputs){
+    if(bm == NULL)
+        return;
+    
+    int j,t,b,size = bm->size,batch_size = bm->batch_size,window = bm->window,n = batch_size*size;
+    lstm* l;
+    
+    // the states before the first timestep
+    for(j = 0; j < bm->layers; j++){
+        if(bm->m->hidden_state_mode == STATEFUL && bm->ff_flag){
+            copy_array(&bm->hidden[j][(window-1)*n],bm->hidden_states[j],n);
+            copy_array(&bm->cell[j][(window-1)*n],bm->cell_states[j],n);
+        }
+        else if(bm->m->hidden_state_mode != STATEFUL){
+            memset(bm->hidden_states[j],0,sizeof(float)*n);
+            memset(bm->cell_states[j],0,sizeof(float)*n);
+        }
+    }
+    bm->ff_flag = 1;
+    
+    for(j = 0; j < bm->layers; j++){
+        l = bm->m->lstms[j];
+        if(l->dropout_flag_right == DROPOUT)
+            set_dropout_mask(n,bm->dropout_mask_right[j],l->dropout_threshold_right);
+        if(l->dropout_flag_up == DROPOUT)
+            set_dropout_mask(n,bm->dropout_mask_up[j],l->dropout_threshold_up);
+    }
+    
+    for(t = 0; t < window; t++){
+        for(b = 0; b < batch_size; b++){
+            copy_array(inputs[b][t],&bm->input[(t*batch_size+b)*size],size);
+        }
+    }
+    
+    ff_rmodel_batch_packed(bm);
+}
+
+/* This function computes the feed forward of ff_rmodel_batch from the inputs already packed in bm->input,
+ * starting from bm->hidden_states and bm->cell_states and with the current dropout masks, that are not changed
+ * 
+ * Input:
+ *             
+ *             @ brmodel* bm:= the batched rmodel
+ * 
+ * */
+void ff_rmodel_batch_packed(brmodel* bm){
+    if(bm == NULL)
+        return;
+    
+    int i,j,k,t,b,size = bm->size,batch_size = bm->batch_size,window = bm->window,n = batch_size*size;
+    float scale_up,scale_right;
+    float* x;
+    float* h;
+    float* c;
+    float* z[4];
+    lstm* l;
+    
+    for(j = 0; j < bm->layers; j++){
+        l = bm->m->lstms[j];
+        x = j == 0 ? bm->input : bm->out_up[j-1];
+        scale_up = l->dropout_flag_up == DROPOUT_TEST ? l->dropout_threshold_up : 1;
+        scale_right = l->dropout_flag_right == DROPOUT_TEST ? l->dropout_threshold_right : 1;
+        
+        lstm_input_projections(x,window*batch_size,size,l->w,l->biases,bm->z[j]);
+        for(t = 0; t < window; t++){
+            h = t == 0 ? bm->hidden_states[j] : &bm->hidden[j][(t-1)*n];
+            c = t == 0 ? bm->cell_states[j] : &bm->cell[j][(t-1)*n];
+            
+            for(i = 0; i < n; i++){
+                bm->h_right[j][t*n+i] = bm->dropout_mask_right[j][i]*h[i]*scale_right;
+            }
+            
+            for(k = 0; k < 4; k++){
+                sgemm_nt(batch_size,size,size,&bm->h_right[j][t*n],size,l->u[k],size,&bm->z[j][t*4*n+k*size],4*size);
+            }
+            
+            for(b = 0; b < batch_size; b++){
+                for(k = 0; k < 4; k++){
+                    z[k] = &bm->z[j][(t*batch_size+b)*4*size+k*size];
+                }
+                lstm_gates(z,&c[b*size],&bm->cell[j][t*n+b*size],&bm->hidden[j][t*n+b*size],size);
+            }
+            
+            for(i = 0; i < n; i++){
+                bm->out_up[j][t*n+i] = bm->dropout_mask_up[j][i]*bm->hidden[j][t*n+i]*scale_up;
+            }
+        }
+    }
+}
+
+/* This function computes the back propagation of a rmodel for a whole batch of sequences, after ff_rmodel_batch.
+ * The partial derivatives of all the sequences are accumulated in the rmodel with a gemm for each gate
+ * over all the timesteps and sequences, the error of the inputs can be read with get_batch_rmodel_input_error
+ * and the errors of the states before the first timestep are stored in hidden_states_error and cell_states_error
+ * 
+ * Input:
+ *             
+ *             @ brmodel* bm:= the batched rmodel
+ *             @ float*** errors:= the errors of the outputs of the batch, dimensions: batch_size*window*size
+ * 
+ * */
+void bp_rmodel_batch(brmodel* bm, float*** errors){
+    if(bm == NULL)
+        return;
+    
+    int t,b,size = bm->size,batch_size = bm->batch_size;
+    
+    for(t = 0; t < bm->window; t++){
+        for(b = 0; b < batch_size; b++){
+            copy_array(errors[b][t],&bm->d_out_up[bm->layers-1][(t*batch_size+b)*size],size);
+        }
+    }
+    
+    bp_rmodel_batch_packed(bm,NULL,NULL);
+}
+
+/* This function computes the back propagation of bp_rmodel_batch with the errors of the outputs already packed
+ * in bm->d_out_up[layers-1]. The errors of the states after the last timestep can be given, for example
+ * the hidden_states_error and cell_states_error of the following window of a longer sequence, they can be
+ * the hidden_states_error and cell_states_error of bm itself
+ * 
+ * Input:
+ *             
+ *             @ brmodel* bm:= the batched rmodel
+ *             @ float** hidden_states_error:= dL/dh of the hidden states after the last timestep, dimensions: layers x batch_size*size, can be NULL
+ *             @ float** cell_states_error:= dL/dc of the cell states after the last timestep, dimensions: layers x batch_size*size, can be NULL
+ * 
+ * */
+void bp_rmodel_batch_packed(brmodel* bm, float** hidden_states_error, float** cell_states_error){
+    if(bm == NULL)
+        return;
+    
+    int i,j,k,t,b,r,size = bm->size,batch_size = bm->batch_size,window = bm->window,n = batch_size*size;
+    float scale_up,scale_right,dh,dc,f,in,o,g,tc;
+    float* x;
+    float* c;
+    float* z;
+    float* dz;
+    float* dx;
+    lstm* l;
+    
+    for(j = bm->layers-1; j >= 0; j--){
+        l = bm->m->lstms[j];
+        x = j == 0 ? bm->input : bm->out_up[j-1];
+        dx = j == 0 ? bm->input_error : bm->d_out_up[j-1];
+        scale_up = l->dropout_flag_up == DROPOUT_TEST ? l->dropout_threshold_up : 1;
+        scale_right = l->dropout_flag_right == DROPOUT_TEST ? l->dropout_threshold_right : 1;
+        
+        if(hidden_states_error != NULL)
+            copy_array(hidden_states_error[j],bm->dh,n);
+        else
+            memset(bm->dh,0,sizeof(float)*n);
+        if(cell_states_error != NULL)
+            copy_array(cell_states_error[j],bm->dc,n);
+        else
+            memset(bm->dc,0,sizeof(float)*n);
+        
+        for(t = window-1; t >= 0; t--){
+            c = t == 0 ? bm->cell_states[j] : &bm->cell[j][(t-1)*n];
+            
+            for(b = 0; b < batch_size; b++){
+                z = &bm->z[j][(t*batch_size+b)*4*size];
+                dz = &bm->dz[j][(t*batch_size+b)*4*size];
+                for(i = 0; i < size; i++){
+                    r = b*size+i;
+                    // dh from the next layer and from the next timestep, dc from the next timestep
+                    dh = bm->d_out_up[j][t*n+r]*bm->dropout_mask_up[j][r]*scale_up + bm->dh[r];
+                    f = sigmoid(z[i]);
+                    in = sigmoid(z[size+i]);
+                    o = sigmoid(z[2*size+i]);
+                    g = tanhh(z[3*size+i]);
+                    tc = tanhh(bm->cell[j][t*n+r]);
+                    dc = dh*o*(1-tc*tc) + bm->dc[r];
+                    dz[i] = dc*c[r]*f*(1-f);
+                    dz[size+i] = dc*g*in*(1-in);
+                    dz[2*size+i] = dh*tc*o*(1-o);
+                    dz[3*size+i] = dc*in*(1-g*g);
+                    bm->dc[r] = dc*f;
+                }
+            }
+            
+            memset(bm->dh,0,sizeof(float)*n);
+            for(k = 0; k < 4; k++){
+                sgemm_nn(batch_size,size,size,&bm->dz[j][t*4*n+k*size],4*size,l->u[k],size,bm->dh,size);
+            }
+            for(i = 0; i < n; i++){
+                bm->dh[i] *= bm->dropout_mask_right[j][i]*scale_right;
+            }
+        }
+        
+        copy_array(bm->dh,bm->hidden_states_error[j],n);
+        copy_array(bm->dc,bm->cell_states_error[j],n);
+        
+        // partial derivatives of all the timesteps and sequences
+        for(k = 0; k < 4; k++){
+            sgemm_tn(size,size,window*batch_size,&bm->dz[j][k*size],4*size,x,size,l->d_w[k],size);
+            sgemm_tn(size,size,window*batch_size,&bm->dz[j][k*size],4*size,bm->h_right[j],size,l->d_u[k],size);
+            for(r = 0; r < window*batch_size; r++){
+                sum1D(l->d_biases[k],&bm->dz[j][r*4*size+k*size],l->d_biases[k],size);
+            }
+        }
+        
+        // error of the input of this layer
+        memset(dx,0,sizeof(float)*window*n);
+        for(k = 0; k < 4; k++){
+            sgemm_nn(window*batch_size,size,size,&bm->dz[j][k*size],4*size,l->w[k],size,dx,size);
+        }
+    }
+}
@@ -0,0 +1,40 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef __BATCH_RMODEL_H__
+#define __BATCH_RMODEL_H__
+
+brmodel* batch_rmodel(rmodel* m, int batch_size);
+void free_batch_rmodel(brmodel* bm);
+void reset_batch_rmodel(brmodel* bm);
+void reset_batch_rmodel_states(brmodel* bm);
+float* get_batch_rmodel_output(brmodel* bm, int index, int t);
+float* get_batch_rmodel_input_error(brmodel* bm, int index, int t);
+void ff_rmodel_batch(brmodel* bm, float*** inputs);
+void ff_rmodel_batch_packed(brmodel* bm);
+void bp_rmodel_batch(brmodel* bm, float*** errors);
+void bp_rmodel_batch_packed(brmodel* bm, float** hidden_states_error, float** cell_states_error);
+
+#endif
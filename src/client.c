@@ -27,7 +27,9 @@ SOFTWARE.
 
 /* This function uses sockfd for the reading a buffersize*sizeof(float) array from the server, then use writing_pipe
  * to send this array to the father wwho created the son who called this function, then reading pipe is used to read the answer 
- * from the parent waiting always for an array of buffersize*sizeof(float) dimension, and then the answer is sent back to sockfd
+ * from the parent waiting always for an array of buffersize*sizeof(float) dimension, and then the answer is sent back to sockfd.
+ * The arrays are exchanged with the server as framed messages (see message.c), the answer has the step of the request.
+ * The function returns when the server or the parent process close the connection
  * 
  * Input:
  * 
@@ -38,16 +40,67 @@ SOFTWARE.
  * 
  * */
 void contact_server(int sockfd, int buffer_size, int reading_pipe, int writing_pipe) { 
+    contact_server_compressed(sockfd,buffer_size,reading_pipe,writing_pipe,COMPRESSION_NONE,0);
+}
+
+/* This function is contact_server, but the answers sent back to the server are compressed (see compression.c).
+ * The compression is negotiated with a MESSAGE_HELLO: if the server doesn't accept it the answers are not compressed.
+ * The compressor keeps what is lost by the compression and adds it to the next answer, so with COMPRESSION_TOPK
+ * the small partial derivatives are delayed, not dropped. The weights sent by the server are not compressed
+ * 
+ * Input:
+ * 
+ *                 @ int sockfd:= the socket between server and client (who calls this function is the client)
+ *                 @ int buffer_size:= the size*sizeof(float) space that must be read
+ *                 @ int reading_pipe:= the pipe used for the communication father son (who calls this function is the son)
+ *                 @ int writing_pipe:= the pipe used for the communication father son, the son must write in this pie
+ *                 @ int compression:= COMPRESSION_NONE, COMPRESSION_FP16, COMPRESSION_INT8, COMPRESSION_1BIT or COMPRESSION_TOPK
+ *                 @ float ratio:= the fraction of the values sent by COMPRESSION_TOPK, in (0,1]
+ * 
+ * */
+void contact_server_compressed(int sockfd, int buffer_size, int reading_pipe, int writing_pipe, int compression, float ratio) { 
     float* buff = (float*)calloc(buffer_size,sizeof(float));
-    int ret;
-    while(1){   
-        while(read(sockfd, buff, sizeof(float)*buffer_size) == 0);// waiting for server
-        ret = write(writing_pipe,buff, sizeof(float)*buffer_size);// writing to parent process
-        while(read(reading_pipe, buff, sizeof(float)*buffer_size) == 0);// waiting for parent process
-        ret = write(sockfd,buff, sizeof(float)*buffer_size);// writing to server
-        
+    long long int bytes = sizeof(float)*(long long int)buffer_size, compressed_bytes;
+    float hello[2] = {compression,ratio};
+    compressor* c = NULL;
+    void* compressed = NULL;
+    message_header header;
+    
+    // negotiating the compression
+    if(send_message(sockfd,MESSAGE_HELLO,0,hello,sizeof(hello)) == -1 || recv_message(sockfd,&header,hello,sizeof(hello)) == -1 || header.type != MESSAGE_HELLO){
+        fprintf(stderr,"Error: the server didn't answer to the hello message\n");
+        exit(1);
+    }
+    if((int)hello[0] != COMPRESSION_NONE){
+        c = create_compressor((int)hello[0],buffer_size,ratio);
+        compressed = malloc(compressed_size(c->type,buffer_size,ratio));
     }
+    
+    while(1){
+        if(recv_message(sockfd,&header,buff,bytes) == -1 || header.type == MESSAGE_CLOSE)// waiting for server
+            break;
+        if(header.length != (unsigned long long int)bytes){
+            fprintf(stderr,"Error: the server sent %llu bytes instead of %lld bytes\n",header.length,bytes);
+            exit(1);
+        }
+        if(write_all(writing_pipe,buff,bytes) == -1)// writing to parent process
+            break;
+        if(read_all(reading_pipe,buff,bytes) == -1)// waiting for parent process
+            break;
+        if(c == NULL){
+            if(send_message(sockfd,MESSAGE_VECTOR,header.step,buff,bytes) == -1)// writing to server
+                break;
+        }
+        else{
+            compressed_bytes = compress_vector(c,buff,compressed);
+            if(send_message(sockfd,MESSAGE_COMPRESSED,header.step,compressed,compressed_bytes) == -1)// writing to server
+                break;
+        }
+    }
+    send_message(sockfd,MESSAGE_CLOSE,0,NULL,0);
     free(buff);
+    free(compressed);
+    free_compressor(c);
 } 
 
 
@@ -63,6 +116,23 @@ void contact_server(int sockfd, int buffer_size, int reading_pipe, int writing_p
  *                 @ int writing_pipe:= to write to parent
  * */
 int run_client(int port, char* server_address, int buffer_size, int reading_pipe, int writing_pipe){
+    return run_client_compressed(port,server_address,buffer_size,reading_pipe,writing_pipe,COMPRESSION_NONE,0);
+}
+
+/* This function is run_client, but the vectors sent to the server are compressed, see contact_server_compressed
+ * 
+ * 
+ * Inputs:
+ *             
+ *                 @ int port:= the port of the server
+ *                 @ char* server_address:= the server address
+ *                 @ int buffer_size:= the buffer size written by the server and parent process
+ *                 @ int reading_pipe:= to read from parent
+ *                 @ int writing_pipe:= to write to parent
+ *                 @ int compression:= COMPRESSION_NONE, COMPRESSION_FP16, COMPRESSION_INT8, COMPRESSION_1BIT or COMPRESSION_TOPK
+ *                 @ float ratio:= the fraction of the values sent by COMPRESSION_TOPK, in (0,1]
+ * */
+int run_client_compressed(int port, char* server_address, int buffer_size, int reading_pipe, int writing_pipe, int compression, float ratio){
     
     int sockfd, connfd; 
     struct sockaddr_in servaddr, cli;
@@ -91,9 +161,10 @@ int run_client(int port, char* server_address, int buffer_size, int reading_pipe
     } 
     else
         printf("connected to the server..\n");  
+    set_socket_options(sockfd);
   
     // function for chat 
-    contact_server(sockfd,buffer_size,reading_pipe,writing_pipe); 
+    contact_server_compressed(sockfd,buffer_size,reading_pipe,writing_pipe,compression,ratio); 
   
     // close the socket 
     close(sockfd);
@@ -29,5 +29,7 @@ SOFTWARE.
 
 int run_client(int port, char* server_address, int buffer_size, int reading_pipe, int writing_pipe);
 void contact_server(int sockfd, int buffer_size, int reading_pipe, int writing_pipe);
+int run_client_compressed(int port, char* server_address, int buffer_size, int reading_pipe, int writing_pipe, int compression, float ratio);
+void contact_server_compressed(int sockfd, int buffer_size, int reading_pipe, int writing_pipe, int compression, float ratio);
 
 #endif
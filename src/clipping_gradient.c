@@ -223,19 +223,15 @@ void clip_fcls(fcl** fcls, int n, float threshold, float norm){
   * 
   * */
 void clip_lstms(lstm** lstms, int n, float threshold, float norm){
-    int i,j;
+    int i,j,k;
     for(i = 0; i < n; i++){
         if(lstms[i]->norm_flag == GROUP_NORMALIZATION)
             clip_bns(lstms[i]->bns,lstms[i]->window/lstms[i]->n_grouped_cell,threshold,norm);
-        for(j = 0; j < lstms[i]->size*lstms[i]->size; j++){
-            lstms[i]->d_w[0][j]*=(threshold)/(norm);
-            lstms[i]->d_u[0][j]*=(threshold)/(norm);
-            lstms[i]->d_w[1][j]*=(threshold)/(norm);
-            lstms[i]->d_u[1][j]*=(threshold)/(norm);
-            lstms[i]->d_w[2][j]*=(threshold)/(norm);
-            lstms[i]->d_u[2][j]*=(threshold)/(norm);
-            lstms[i]->d_w[3][j]*=(threshold)/(norm);
-            lstms[i]->d_u[3][j]*=(threshold)/(norm);
+        for(k = 0; k < lstms[i]->n_gates; k++){
+            for(j = 0; j < lstms[i]->size*lstms[i]->size; j++){
+                lstms[i]->d_w[k][j]*=(threshold)/(norm);
+                lstms[i]->d_u[k][j]*=(threshold)/(norm);
+            }
         }
     }
     
@@ -351,29 +347,19 @@ float sum_all_quadratic_derivative_weights_fcls(fcl** fcls, int n){
   * 
   * */
 float sum_all_quadratic_derivative_weights_lstms(lstm** lstms, int n){
-    int i,j;
+    int i,j,k;
     float sum = 0,temp;
     for(i = 0; i < n; i++){
         if(lstms[i]->norm_flag == GROUP_NORMALIZATION)
             sum += sum_all_quadratic_derivative_weights_bns(lstms[i]->bns,lstms[i]->window/lstms[i]->n_grouped_cell);
         
-        for(j = 0; j < lstms[i]->size*lstms[i]->size; j++){
-            temp = lstms[i]->d_w[0][j];
-            sum += temp*temp;
-            temp = lstms[i]->d_u[0][j];
-            sum += temp*temp;
-            temp = lstms[i]->d_w[1][j];
-            sum += temp*temp;
-            temp = lstms[i]->d_u[1][j];
-            sum += temp*temp;
-            temp = lstms[i]->d_w[2][j];
-            sum += temp*temp;
-            temp = lstms[i]->d_u[2][j];
-            sum += temp*temp;
-            temp = lstms[i]->d_w[3][j];
-            sum += temp*temp;
-            temp = lstms[i]->d_u[3][j];
-            sum += temp*temp;
+        for(k = 0; k < lstms[i]->n_gates; k++){
+            for(j = 0; j < lstms[i]->size*lstms[i]->size; j++){
+                temp = lstms[i]->d_w[k][j];
+                sum += temp*temp;
+                temp = lstms[i]->d_u[k][j];
+                sum += temp*temp;
+            }
         }
     }
     
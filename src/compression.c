@@ -0,0 +1,465 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+#include "llab.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define COMPRESSION_X86
+#endif
+
+/* Compression of the vectors (partial derivatives) sent by the clients to the server:
+ * 
+ * - COMPRESSION_FP16: half precision floats, 2 bytes each value, clamped to +-COMPRESSION_FP16_MAX
+ * - COMPRESSION_INT8: each block of COMPRESSION_BLOCK floats is divided by its largest magnitude and rounded to 8 bits,
+ *   1 byte each value
+ * - COMPRESSION_1BIT: each value of a block becomes + or - the largest magnitude of the block, 1 bit each value
+ * - COMPRESSION_TOPK: the ratio*size values with the largest magnitude with their indices, 8 bytes each value sent
+ * 
+ * The roundings of COMPRESSION_INT8 and COMPRESSION_1BIT are stochastic: a value is rounded up with probability equal to its
+ * distance from the lower level, so the compressed vector is equal to the vector on average.
+ * What a compression loses is kept in the residual of the compressor and added to the next vector (error feedback),
+ * so the values not sent by COMPRESSION_TOPK are accumulated until they are large enough to be sent.
+ * COMPRESSION_1BIT has no error feedback, its errors are too large to be fed back but have mean 0.
+ * The server sums the compressed vectors with decompress_add, vectorized with avx2 and f16c.
+ * 
+ * Layouts:
+ * 
+ * - COMPRESSION_FP16: unsigned short values[size]
+ * - COMPRESSION_INT8: float factors[blocks], signed char values[size], the value is factor*values[i]
+ * - COMPRESSION_1BIT: float scales[blocks], unsigned char bits[(size+7)/8], the value is scale if the bit i is 1, -scale otherwise
+ * - COMPRESSION_TOPK: int k, unsigned int indices[k] in ascending order, float values[k]
+ * */
+
+/* This function creates a compressor
+ * 
+ * Input:
+ *             @ int type:= COMPRESSION_NONE, COMPRESSION_FP16, COMPRESSION_INT8, COMPRESSION_1BIT or COMPRESSION_TOPK
+ *             @ int size:= the floats of the vectors
+ *             @ float ratio:= the fraction of the values sent by COMPRESSION_TOPK, in (0,1]
+ * 
+ * Output:
+ *             @ compressor*:= the compressor
+ * */
+compressor* create_compressor(int type, int size, float ratio){
+    if(type < COMPRESSION_NONE || type > COMPRESSION_TOPK || size <= 0){
+        fprintf(stderr,"Error: unknown compression or size <= 0\n");
+        exit(1);
+    }
+    if(type == COMPRESSION_TOPK && (ratio <= 0 || ratio > 1)){
+        fprintf(stderr,"Error: the ratio of the top-k compression must be in (0,1]\n");
+        exit(1);
+    }
+    compressor* c = (compressor*)calloc(1,sizeof(compressor));
+    c->type = type;
+    c->size = size;
+    c->ratio = ratio;
+    c->seed = 0x9e3779b97f4a7c15ULL^(unsigned long long int)rand();
+    if(type != COMPRESSION_NONE){
+        c->residual = (float*)calloc(size,sizeof(float));
+        c->workspace = (float*)calloc(size,sizeof(float));
+    }
+    return c;
+}
+
+/* This function frees a compressor
+ * 
+ * Input:
+ *             @ compressor* c:= the compressor
+ * */
+void free_compressor(compressor* c){
+    if(c == NULL)
+        return;
+    free(c->residual);
+    free(c->workspace);
+    free(c);
+}
+
+/* This function returns the values sent by COMPRESSION_TOPK
+ * 
+ * Input:
+ *             @ int size:= the floats of the vectors
+ *             @ float ratio:= the fraction of the values sent
+ * 
+ * Output:
+ *             @ int:= the values sent, at least 1
+ * */
+int topk_count(int size, float ratio){
+    int k = (int)((double)ratio*size);
+    if(k < 1)
+        k = 1;
+    if(k > size)
+        k = size;
+    return k;
+}
+
+/* This function returns the bytes of a compressed vector, for COMPRESSION_TOPK the maximum
+ * 
+ * Input:
+ *             @ int type:= the compression
+ *             @ int size:= the floats of the vector
+ *             @ float ratio:= the fraction of the values sent by COMPRESSION_TOPK
+ * 
+ * Output:
+ *             @ long long int:= the bytes
+ * */
+long long int compressed_size(int type, int size, float ratio){
+    long long int blocks = (size+COMPRESSION_BLOCK-1)/COMPRESSION_BLOCK;
+    if(type == COMPRESSION_FP16)
+        return sizeof(unsigned short)*(long long int)size;
+    if(type == COMPRESSION_INT8)
+        return sizeof(float)*blocks+size;
+    if(type == COMPRESSION_1BIT)
+        return sizeof(float)*blocks+(size+7)/8;
+    if(type == COMPRESSION_TOPK)
+        return sizeof(int)+(sizeof(unsigned int)+sizeof(float))*(long long int)topk_count(size,ratio);
+    return sizeof(float)*(long long int)size;
+}
+
+/* This function returns a random number in [0,1) for the stochastic rounding of the i-th value of a vector,
+ * it is a hash of the seed and the index so the values can be rounded independently (and vectorized by the compiler)
+ * 
+ * Input:
+ *             @ unsigned int seed:= the seed of the vector
+ *             @ unsigned int i:= the index of the value
+ * 
+ * Output:
+ *             @ float:= the random number
+ * */
+float compressor_uniform(unsigned int seed, unsigned int i){
+    unsigned int x = seed^(i*0x9e3779b9U);
+    x^=x>>16;
+    x*=0x7feb352dU;
+    x^=x>>15;
+    x*=0x846ca68bU;
+    x^=x>>16;
+    return (float)(x>>8)*(1.0f/16777216.0f);
+}
+
+/* This function returns the k-th largest value of an array (quickselect), the array is reordered
+ * 
+ * Input:
+ *             @ float* values:= the array, dimensions: n
+ *             @ int n:= the size of the array
+ *             @ int k:= 1 for the largest value, n for the smallest one
+ * 
+ * Output:
+ *             @ float:= the k-th largest value
+ * */
+float kth_largest(float* values, int n, int k){
+    int low = 0, high = n-1, i, j;
+    float pivot, temp;
+    k--;
+    while(low < high){
+        pivot = values[low+(high-low)/2];
+        i = low;
+        j = high;
+        while(i <= j){
+            while(values[i] > pivot)
+                i++;
+            while(values[j] < pivot)
+                j--;
+            if(i <= j){
+                temp = values[i];
+                values[i] = values[j];
+                values[j] = temp;
+                i++;
+                j--;
+            }
+        }
+        if(k <= j)
+            high = j;
+        else if(k >= i)
+            low = i;
+        else
+            return values[k];
+    }
+    return values[k];
+}
+
+/* This function compresses a vector, the residual of the compressor is added to the vector before the compression
+ * and then replaced with what the compression loses
+ * 
+ * Input:
+ *             @ compressor* c:= the compressor
+ *             @ float* vector:= the vector, dimensions: c->size
+ *             @ void* output:= the compressed vector, dimensions: compressed_size(c->type,c->size,c->ratio) bytes
+ * 
+ * Output:
+ *             @ long long int:= the bytes of the compressed vector
+ * */
+long long int compress_vector(compressor* c, float* vector, void* output){
+    int i, j, k, end, n_blocks = (c->size+COMPRESSION_BLOCK-1)/COMPRESSION_BLOCK, greater, equal;
+    float max, value, factor, threshold;
+    float* x = c->residual;
+    unsigned int seed;
+    float* scales = (float*)output;
+    signed char* q8 = (signed char*)(scales+n_blocks);
+    unsigned char* bits = (unsigned char*)(scales+n_blocks);
+    unsigned int* indices;
+    float* values;
+    
+    if(c->type == COMPRESSION_NONE){
+        memcpy(output,vector,sizeof(float)*c->size);
+        return sizeof(float)*(long long int)c->size;
+    }
+    
+    // a new seed for each vector (xorshift64)
+    c->seed^=c->seed>>12;
+    c->seed^=c->seed<<25;
+    c->seed^=c->seed>>27;
+    seed = (unsigned int)(c->seed>>32);
+    
+    // error feedback: x = vector + residual, the residual becomes what is lost of x
+    sum1D(vector,c->residual,x,c->size);
+    
+    if(c->type == COMPRESSION_FP16){
+        // the values beyond the half precision range are clamped, the overflow stays in the residual instead of an infinity
+        for(i = 0; i < c->size; i++){
+            c->workspace[i] = x[i] > COMPRESSION_FP16_MAX ? COMPRESSION_FP16_MAX : (x[i] < -COMPRESSION_FP16_MAX ? -COMPRESSION_FP16_MAX : x[i]);
+        }
+        float_to_fp16_array(c->workspace,(unsigned short*)output,c->size);
+        fp16_to_float_array((unsigned short*)output,c->workspace,c->size);
+        for(i = 0; i < c->size; i++){
+            x[i]-=c->workspace[i];
+        }
+    }
+    
+    else if(c->type == COMPRESSION_INT8){
+        for(i = 0; i < n_blocks; i++){
+            end = (i+1)*COMPRESSION_BLOCK < c->size ? (i+1)*COMPRESSION_BLOCK : c->size;
+            for(j = i*COMPRESSION_BLOCK, max = 0; j < end; j++){
+                if(fabsf(x[j]) > max)
+                    max = fabsf(x[j]);
+            }
+            scales[i] = max/QUANTIZED_MAX;
+            factor = max > 0 ? QUANTIZED_MAX/max : 0;
+            for(j = i*COMPRESSION_BLOCK; j < end; j++){
+                // floor(x*factor+u), x*factor+u is in [-QUANTIZED_MAX,QUANTIZED_MAX+1)
+                value = x[j]*factor+compressor_uniform(seed,j);
+                k = (int)value;
+                k-=value < k;
+                k = k > QUANTIZED_MAX ? QUANTIZED_MAX : k;
+                q8[j] = (signed char)k;
+                x[j]-=scales[i]*k;
+            }
+        }
+    }
+    
+    else if(c->type == COMPRESSION_1BIT){
+        for(i = 0; i < n_blocks; i++){
+            end = (i+1)*COMPRESSION_BLOCK < c->size ? (i+1)*COMPRESSION_BLOCK : c->size;
+            for(j = i*COMPRESSION_BLOCK, max = 0; j < end; j++){
+                if(fabsf(x[j]) > max)
+                    max = fabsf(x[j]);
+            }
+            scales[i] = max;
+            // + max with probability (x/max+1)/2, the blocks start at multiples of 8 values
+            for(j = i*COMPRESSION_BLOCK; j < end; j+=8){
+                for(k = 0, greater = 0; k < 8 && j+k < end; k++){
+                    greater|=(compressor_uniform(seed,j+k)*2*max < x[j+k]+max)<<k;
+                }
+                bits[j>>3] = (unsigned char)greater;
+            }
+        }
+        // the error of a value can be 2*max, fed back it would raise the max of the next vector and so on,
+        // the rounding is unbiased anyway so the error is dropped
+        memset(x,0,sizeof(float)*c->size);
+    }
+    
+    else{
+        k = topk_count(c->size,c->ratio);
+        indices = (unsigned int*)((int*)output+1);
+        values = (float*)(indices+k);
+        // the threshold is estimated on a sample, then searched among the values above the estimate only
+        for(i = 0, equal = 0; c->size > 4*COMPRESSION_SAMPLE && i < COMPRESSION_SAMPLE; i++){
+            c->workspace[i] = fabsf(x[(int)(compressor_uniform(seed,i)*c->size)]);
+        }
+        if(i == COMPRESSION_SAMPLE){
+            threshold = kth_largest(c->workspace,COMPRESSION_SAMPLE,(int)(2.0*k*COMPRESSION_SAMPLE/c->size)+16 < COMPRESSION_SAMPLE ? (int)(2.0*k*COMPRESSION_SAMPLE/c->size)+16 : COMPRESSION_SAMPLE);
+            for(i = 0; i < c->size; i++){
+                c->workspace[equal] = fabsf(x[i]);
+                equal+=c->workspace[equal] >= threshold;
+            }
+        }
+        if(equal >= k)
+            threshold = kth_largest(c->workspace,equal,k);
+        else{
+            for(i = 0; i < c->size; i++){
+                c->workspace[i] = fabsf(x[i]);
+            }
+            threshold = kth_largest(c->workspace,c->size,k);
+        }
+        for(i = 0, greater = 0; i < c->size; i++){
+            if(fabsf(x[i]) > threshold)
+                greater++;
+        }
+        // the values equal to the threshold are taken in order until k values are taken
+        for(i = 0, j = 0, equal = k-greater; i < c->size && j < k; i++){
+            value = fabsf(x[i]);
+            if(value > threshold || (value == threshold && equal-- > 0)){
+                indices[j] = i;
+                values[j] = x[i];
+                x[i] = 0;
+                j++;
+            }
+        }
+        *(int*)output = k;
+    }
+    return compressed_size(c->type,c->size,c->ratio);
+}
+
+/* This function adds a compressed vector to an array one value at a time
+ * 
+ * Input:
+ *             @ int type:= the compression
+ *             @ void* input:= the compressed vector
+ *             @ float* output:= the array, dimensions: size
+ *             @ int size:= the floats of the vector
+ * */
+void decompress_add_scalar(int type, void* input, float* output, int size){
+    int i, k, n_blocks = (size+COMPRESSION_BLOCK-1)/COMPRESSION_BLOCK;
+    float* scales = (float*)input;
+    signed char* q8 = (signed char*)(scales+n_blocks);
+    unsigned char* bits = (unsigned char*)(scales+n_blocks);
+    unsigned short* h = (unsigned short*)input;
+    unsigned int* indices;
+    float* values;
+    if(type == COMPRESSION_FP16){
+        for(i = 0; i < size; i++){
+            output[i]+=fp16_to_float(h[i]);
+        }
+    }
+    else if(type == COMPRESSION_INT8){
+        for(i = 0; i < size; i++){
+            output[i]+=scales[i/COMPRESSION_BLOCK]*q8[i];
+        }
+    }
+    else if(type == COMPRESSION_1BIT){
+        for(i = 0; i < size; i++){
+            output[i]+=(bits[i>>3]>>(i&7))&1 ? scales[i/COMPRESSION_BLOCK] : -scales[i/COMPRESSION_BLOCK];
+        }
+    }
+    else if(type == COMPRESSION_TOPK){
+        k = *(int*)input;
+        indices = (unsigned int*)((int*)input+1);
+        values = (float*)(indices+k);
+        for(i = 0; i < k; i++){
+            output[indices[i]]+=values[i];
+        }
+    }
+    else
+        sum1D((float*)input,output,output,size);
+}
+
+#ifdef COMPRESSION_X86
+__attribute__((target("avx2,f16c")))
+void decompress_add_avx2(int type, void* input, float* output, int size){
+    int i, j, end, n_blocks = (size+COMPRESSION_BLOCK-1)/COMPRESSION_BLOCK;
+    float* scales = (float*)input;
+    signed char* q8 = (signed char*)(scales+n_blocks);
+    unsigned char* bits = (unsigned char*)(scales+n_blocks);
+    unsigned short* h = (unsigned short*)input;
+    __m256 scale, minus, sum;
+    __m256i mask = _mm256_setr_epi32(1,2,4,8,16,32,64,128), byte;
+    
+    if(type == COMPRESSION_FP16){
+        for(i = 0; i+8 <= size; i+=8){
+            sum = _mm256_add_ps(_mm256_loadu_ps(&output[i]),_mm256_cvtph_ps(_mm_loadu_si128((__m128i*)&h[i])));
+            _mm256_storeu_ps(&output[i],sum);
+        }
+        for(; i < size; i++){
+            output[i]+=fp16_to_float(h[i]);
+        }
+    }
+    
+    else if(type == COMPRESSION_INT8){
+        for(i = 0; i < n_blocks; i++){
+            end = (i+1)*COMPRESSION_BLOCK < size ? (i+1)*COMPRESSION_BLOCK : size;
+            scale = _mm256_set1_ps(scales[i]);
+            for(j = i*COMPRESSION_BLOCK; j+8 <= end; j+=8){
+                sum = _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_loadl_epi64((__m128i*)&q8[j])));
+                _mm256_storeu_ps(&output[j],_mm256_add_ps(_mm256_loadu_ps(&output[j]),_mm256_mul_ps(scale,sum)));
+            }
+            for(; j < end; j++){
+                output[j]+=scales[i]*q8[j];
+            }
+        }
+    }
+    
+    else if(type == COMPRESSION_1BIT){
+        for(i = 0; i < n_blocks; i++){
+            end = (i+1)*COMPRESSION_BLOCK < size ? (i+1)*COMPRESSION_BLOCK : size;
+            scale = _mm256_set1_ps(scales[i]);
+            minus = _mm256_set1_ps(-scales[i]);
+            // the blocks start at multiples of 8 values, so each byte of bits is in a single block
+            for(j = i*COMPRESSION_BLOCK; j+8 <= end; j+=8){
+                byte = _mm256_and_si256(_mm256_set1_epi32(bits[j>>3]),mask);
+                sum = _mm256_blendv_ps(minus,scale,_mm256_castsi256_ps(_mm256_cmpeq_epi32(byte,mask)));
+                _mm256_storeu_ps(&output[j],_mm256_add_ps(_mm256_loadu_ps(&output[j]),sum));
+            }
+            for(; j < end; j++){
+                output[j]+=(bits[j>>3]>>(j&7))&1 ? scales[i] : -scales[i];
+            }
+        }
+    }
+    
+    else
+        decompress_add_scalar(type,input,output,size);
+}
+#endif
+
+/* This function adds a compressed vector to an array, so the server can sum the vectors of the clients
+ * without decompressing them first. The compressed vector is checked against its size
+ * 
+ * Input:
+ *             @ int type:= the compression
+ *             @ void* input:= the compressed vector, dimensions: bytes
+ *             @ long long int bytes:= the bytes of the compressed vector
+ *             @ float* output:= the array, dimensions: size
+ *             @ int size:= the floats of the vector
+ * */
+void decompress_add(int type, void* input, long long int bytes, float* output, int size){
+    int i, k = type == COMPRESSION_TOPK && bytes >= (long long int)sizeof(int) ? *(int*)input : 0;
+    unsigned int* indices = (unsigned int*)((int*)input+1);
+    if((type == COMPRESSION_TOPK && (k < 1 || k > size || bytes != (long long int)sizeof(int)+(long long int)(sizeof(unsigned int)+sizeof(float))*k)) || (type != COMPRESSION_TOPK && bytes != compressed_size(type,size,0))){
+        fprintf(stderr,"Error: the compressed vector has %lld bytes, it doesn't match a vector of %d floats\n",bytes,size);
+        exit(1);
+    }
+    for(i = 0; i < k; i++){
+        if(indices[i] >= (unsigned int)size){
+            fprintf(stderr,"Error: the compressed vector has an index out of range\n");
+            exit(1);
+        }
+    }
+    #ifdef COMPRESSION_X86
+    if(get_sgemm_instruction_set() >= SGEMM_AVX2 && __builtin_cpu_supports("f16c")){
+        decompress_add_avx2(type,input,output,size);
+        return;
+    }
+    #endif
+    decompress_add_scalar(type,input,output,size);
+}
@@ -0,0 +1,40 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+#ifndef __COMPRESSION_H__
+#define __COMPRESSION_H__
+
+compressor* create_compressor(int type, int size, float ratio);
+void free_compressor(compressor* c);
+int topk_count(int size, float ratio);
+long long int compressed_size(int type, int size, float ratio);
+float compressor_uniform(unsigned int seed, unsigned int i);
+float kth_largest(float* values, int n, int k);
+long long int compress_vector(compressor* c, float* vector, void* output);
+void decompress_add_scalar(int type, void* input, float* output, int size);
+void decompress_add(int type, void* input, long long int bytes, float* output, int size);
+
+#endif
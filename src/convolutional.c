@@ -854,3 +854,210 @@ void transposed_convolutional_back_prop_edge_popup_for_input(float* input, float
     }
 }
 
+
+/* This function unrolls the patches of an input tensor seen by a kernel, each row of col
+ * is a patch ordered as the kernels (channels, kernel rows, kernel cols), the patches are ordered by output position
+ * 
+ * Input:
+ *             @ float* input:= the input tensor, dimensions: channels*input_i*input_j
+ *             @ int channels:= the depth of the input and the kernel
+ *             @ int input_i:= the number of rows of each feature map of the input
+ *             @ int input_j:= the number of columns of each feature map of the input
+ *             @ int kernel_i:= the number of rows of each channel of the kernel
+ *             @ int kernel_j:= the number of columns of each channel of the kernel
+ *             @ int stride:= the stride used by the kernel on the feature maps of the inputs
+ *             @ float* col:= the unrolled patches, dimensions: ((input_i-kernel_i)/stride + 1)*((input_j-kernel_j)/stride + 1)*channels*kernel_i*kernel_j
+ * */
+void im2col(float* input, int channels, int input_i, int input_j, int kernel_i, int kernel_j, int stride, float* col){
+    int oi,oj,i,c;
+    int output_i = (input_i-kernel_i)/stride + 1;
+    int output_j = (input_j-kernel_j)/stride + 1;
+    for(oi = 0; oi < output_i; oi++){
+        for(oj = 0; oj < output_j; oj++){
+            for(c = 0; c < channels; c++){
+                for(i = 0; i < kernel_i; i++){
+                    copy_array(&input[c*input_i*input_j + (oi*stride+i)*input_j + oj*stride],col,kernel_j);
+                    col+=kernel_j;
+                }
+            }
+        }
+    }
+}
+
+/* This function is the inverse of im2col, each patch of col is added to the input tensor
+ * 
+ * Input:
+ *             @ float* col:= the unrolled patches, dimensions: ((input_i-kernel_i)/stride + 1)*((input_j-kernel_j)/stride + 1)*channels*kernel_i*kernel_j
+ *             @ int channels:= the depth of the input and the kernel
+ *             @ int input_i:= the number of rows of each feature map of the input
+ *             @ int input_j:= the number of columns of each feature map of the input
+ *             @ int kernel_i:= the number of rows of each channel of the kernel
+ *             @ int kernel_j:= the number of columns of each channel of the kernel
+ *             @ int stride:= the stride used by the kernel on the feature maps of the inputs
+ *             @ float* input:= the input tensor where the patches are summed, dimensions: channels*input_i*input_j
+ * */
+void col2im(float* col, int channels, int input_i, int input_j, int kernel_i, int kernel_j, int stride, float* input){
+    int oi,oj,i,j,c;
+    int output_i = (input_i-kernel_i)/stride + 1;
+    int output_j = (input_j-kernel_j)/stride + 1;
+    float* x;
+    for(oi = 0; oi < output_i; oi++){
+        for(oj = 0; oj < output_j; oj++){
+            for(c = 0; c < channels; c++){
+                for(i = 0; i < kernel_i; i++){
+                    x = &input[c*input_i*input_j + (oi*stride+i)*input_j + oj*stride];
+                    for(j = 0; j < kernel_j; j++){
+                        x[j] += col[j];
+                    }
+                    col+=kernel_j;
+                }
+            }
+        }
+    }
+}
+
+/* This function returns the number of floats used by convolutional_feed_forward_im2col and convolutional_back_prop_im2col
+ * 
+ * Input:
+ *             @ int channels:= the depth of the input and the kernel
+ *             @ int input_i:= the number of rows of each feature map of the input
+ *             @ int input_j:= the number of columns of each feature map of the input
+ *             @ int kernel_i:= the number of rows of each channel of the kernel
+ *             @ int kernel_j:= the number of columns of each channel of the kernel
+ *             @ int n_kernels:= the number of kernels
+ *             @ int stride:= the stride used by the kernel on the feature maps of the inputs
+ * */
+int im2col_workspace_size(int channels, int input_i, int input_j, int kernel_i, int kernel_j, int n_kernels, int stride){
+    int patches = ((input_i-kernel_i)/stride + 1)*((input_j-kernel_j)/stride + 1);
+    int patch_size = channels*kernel_i*kernel_j;
+    return 2*patches*patch_size + 2*n_kernels*patch_size + n_kernels*patches;
+}
+
+/* This function computes the feed forward of all the kernels of a convolutional layer with a single matrix multiplication
+ * between the kernels and the patches of the input unrolled by im2col. The output has the same stride and padding of convolutional_feed_forward
+ * 
+ * Input:
+ *             @ float* input:= a tensor of input of 3 dimensions: channels, rows and cols
+ *                              dimensions: channels*input_i*input_j
+ *             @ float** kernel:= the kernels of the layer, dimensions: n_kernels*channels*kernel_i*kernel_j
+ *             @ int n_kernels:= the number of kernels
+ *             @ int input_i := the number of rows of each feature map of the previous layer (input)
+ *             @ int input_j:= the number of columns of each feature map of the previous layer (input)
+ *             @ int kernel_i:= the number of rows of each channel of the kernel
+ *             @ int kernel_j:= the number of columns of each channel of the kernel
+ *             @ float* bias:= the biases of the kernels, dimensions: n_kernels
+ *             @ int channels:= the depth of the input and the kernel
+ *             @ float* output:= the feature maps computed, dimensions: n_kernels*((input_i-kernel_i)/stride + 1 +2*padding)*((input_j-kernel_j)/stride + 1 +2*padding)
+ *             @ int stride:= the stride used by the kernel on the feature maps of the inputs
+ *             @ int padding:= the optional padding added to the output
+ *             @ float* workspace:= a buffer of im2col_workspace_size(channels,input_i,input_j,kernel_i,kernel_j,n_kernels,stride) floats
+ * */
+void convolutional_feed_forward_im2col(float* input, float** kernel, int n_kernels, int input_i, int input_j, int kernel_i, int kernel_j, float* bias, int channels, float* output, int stride, int padding, float* workspace){
+    int k,oi,oj;
+    int patches_i = (input_i-kernel_i)/stride + 1;
+    int patches_j = (input_j-kernel_j)/stride + 1;
+    int patches = patches_i*patches_j;
+    int patch_size = channels*kernel_i*kernel_j;
+    int output_i = patches_i + 2*padding;
+    int output_j = patches_j + 2*padding;
+    float* col = workspace;
+    float* kernels = col + patches*patch_size;
+    float* out = kernels + n_kernels*patch_size;
+    
+    im2col(input,channels,input_i,input_j,kernel_i,kernel_j,stride,col);
+    for(k = 0; k < n_kernels; k++){
+        copy_array(kernel[k],&kernels[k*patch_size],patch_size);
+    }
+    
+    if(!padding){
+        sgemm_nt(n_kernels,patches,patch_size,kernels,patch_size,col,patch_size,output,patches);
+        for(k = 0; k < n_kernels; k++){
+            for(oi = 0; oi < patches; oi++){
+                output[k*patches+oi] += bias[k];
+            }
+        }
+        return;
+    }
+    
+    memset(out,0,sizeof(float)*(n_kernels*patches));
+    sgemm_nt(n_kernels,patches,patch_size,kernels,patch_size,col,patch_size,out,patches);
+    for(k = 0; k < n_kernels; k++){
+        for(oi = 0; oi < patches_i; oi++){
+            for(oj = 0; oj < patches_j; oj++){
+                output[k*output_i*output_j + (oi+padding)*output_j + oj+padding] += out[k*patches + oi*patches_j + oj];
+                output[k*output_i*output_j + (oi+padding)*output_j + oj+padding] += bias[k];
+            }
+        }
+    }
+}
+
+/* This function computes the back propagation of all the kernels of a convolutional layer with matrix multiplications
+ * on the patches of the input unrolled by im2col. The errors are summed to input_error, kernel_error and bias_error
+ * as convolutional_back_prop does for each kernel
+ * 
+ * Input:
+ *             @ float* input:= a tensor of input of 3 dimensions: channels, rows and cols
+ *                              dimensions: channels*input_i*input_j
+ *             @ float** kernel:= the kernels of the layer, dimensions: n_kernels*channels*kernel_i*kernel_j
+ *             @ int n_kernels:= the number of kernels
+ *             @ int input_i := the number of rows of each feature map of the previous layer (input)
+ *             @ int input_j:= the number of columns of each feature map of the previous layer (input)
+ *             @ int kernel_i:= the number of rows of each channel of the kernel
+ *             @ int kernel_j:= the number of columns of each channel of the kernel
+ *             @ int channels:= the depth of the input and the kernel
+ *             @ float* output_error:= the errors of the feature maps, dimensions: n_kernels*((input_i-kernel_i)/stride + 1 +2*padding)*((input_j-kernel_j)/stride + 1 +2*padding)
+ *             @ float* input_error:= the error of the previous layer, dimensions: channels*input_i*input_j
+ *             @ float** kernel_error:= the errors of the kernels, dimensions: n_kernels*channels*kernel_i*kernel_j
+ *             @ float* bias_error:= the errors of the biases, dimensions: n_kernels
+ *             @ int stride:= the stride used by the kernel on the feature maps of the inputs
+ *             @ int padding:= the optional padding added to the output
+ *             @ float* workspace:= a buffer of im2col_workspace_size(channels,input_i,input_j,kernel_i,kernel_j,n_kernels,stride) floats
+ * */
+void convolutional_back_prop_im2col(float* input, float** kernel, int n_kernels, int input_i, int input_j, int kernel_i, int kernel_j, int channels, float* output_error, float* input_error, float** kernel_error, float* bias_error, int stride, int padding, float* workspace){
+    int k,oi,oj,q;
+    int patches_i = (input_i-kernel_i)/stride + 1;
+    int patches_j = (input_j-kernel_j)/stride + 1;
+    int patches = patches_i*patches_j;
+    int patch_size = channels*kernel_i*kernel_j;
+    int output_i = patches_i + 2*padding;
+    int output_j = patches_j + 2*padding;
+    float* col = workspace;
+    float* kernels = col + patches*patch_size;
+    float* error = kernels + n_kernels*patch_size;
+    float* col_error = error + n_kernels*patches;
+    float* kernels_error = col_error + patches*patch_size;
+    
+    im2col(input,channels,input_i,input_j,kernel_i,kernel_j,stride,col);
+    for(k = 0; k < n_kernels; k++){
+        copy_array(kernel[k],&kernels[k*patch_size],patch_size);
+    }
+    
+    if(!padding){
+        error = output_error;
+    }
+    else{
+        for(k = 0; k < n_kernels; k++){
+            for(oi = 0; oi < patches_i; oi++){
+                copy_array(&output_error[k*output_i*output_j + (oi+padding)*output_j + padding],&error[k*patches + oi*patches_j],patches_j);
+            }
+        }
+    }
+    
+    for(k = 0; k < n_kernels; k++){
+        for(oj = 0; oj < patches; oj++){
+            bias_error[k] += error[k*patches+oj];
+        }
+    }
+    
+    memset(kernels_error,0,sizeof(float)*(n_kernels*patch_size));
+    sgemm_nn(n_kernels,patch_size,patches,error,patches,col,patch_size,kernels_error,patch_size);
+    for(k = 0; k < n_kernels; k++){
+        for(q = 0; q < patch_size; q++){
+            kernel_error[k][q] += kernels_error[k*patch_size+q];
+        }
+    }
+    
+    memset(col_error,0,sizeof(float)*(patches*patch_size));
+    sgemm_tn(patches,patch_size,n_kernels,error,patches,kernels,patch_size,col_error,patch_size);
+    col2im(col_error,channels,input_i,input_j,kernel_i,kernel_j,stride,input_error);
+}
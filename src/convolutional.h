@@ -42,4 +42,10 @@ void transposed_convolutional_back_prop_edge_popup(float* input, float* kernel,
 void transposed_convolutional_back_prop_edge_popup_ff_gd_bp(float* input, float** kernel, int input_i, int input_j, int kernel_i, int kernel_j, float* bias, int channels, float* output_error, int stride, int padding, int* indices, int n_kernels, int last_n, float* bias_error, float** kernel_error);
 void transposed_convolutional_back_prop_edge_popup_for_input(float* input, float** kernel, int input_i, int input_j, int kernel_i, int kernel_j, float bias, int channels, float* output_error,float* input_error, float* kernel_error, float* bias_error, int stride, int padding, float* score_error, int* indices, int n_kernels, int last_n);
 
+void im2col(float* input, int channels, int input_i, int input_j, int kernel_i, int kernel_j, int stride, float* col);
+void col2im(float* col, int channels, int input_i, int input_j, int kernel_i, int kernel_j, int stride, float* input);
+int im2col_workspace_size(int channels, int input_i, int input_j, int kernel_i, int kernel_j, int n_kernels, int stride);
+void convolutional_feed_forward_im2col(float* input, float** kernel, int n_kernels, int input_i, int input_j, int kernel_i, int kernel_j, float* bias, int channels, float* output, int stride, int padding, float* workspace);
+void convolutional_back_prop_im2col(float* input, float** kernel, int n_kernels, int input_i, int input_j, int kernel_i, int kernel_j, int channels, float* output_error, float* input_error, float** kernel_error, float* bias_error, int stride, int padding, float* workspace);
+
 #endif
@@ -116,6 +116,13 @@ cl* convolutional(int channels, int input_rows, int input_cols, int kernel_rows,
     c->normalization_flag = normalization_flag;
     c->activation_flag = activation_flag;
     c->pooling_flag = pooling_flag;
+    c->convolution_algorithm = AUTO_CONVOLUTION;
+    c->convolution_workspace = NULL;
+    c->winograd_tile = winograd_tile_size((input_rows-kernel_rows)/stride1_rows + 1,(input_cols-kernel_cols)/stride1_cols + 1);
+    c->winograd_cache_flag = 0;
+    c->winograd_kernels = NULL;
+    c->winograd_kernels_bp = NULL;
+    c->winograd_workspace = NULL;
     c->kernels = (float**)malloc(sizeof(float*)*n_kernels);
     c->d_kernels = (float**)malloc(sizeof(float*)*n_kernels);
     c->ex_d_kernels_diff_grad = (float**)malloc(sizeof(float*)*n_kernels);
@@ -293,6 +300,10 @@ void free_convolutional(cl* c){
     free(c->d1_scores);
     free(c->d2_scores);
     free(c->d3_scores);
+    free(c->convolution_workspace);
+    free(c->winograd_kernels);
+    free(c->winograd_kernels_bp);
+    free(c->winograd_workspace);
     if(c->normalization_flag == GROUP_NORMALIZATION){
         for(i = 0; i < c->n_kernels/c->group_norm_channels; i++){
             free_batch_normalization(c->group_norm[i]);
@@ -964,6 +975,7 @@ void copy_cl_params(cl* f, float** kernels, float* biases){
         }
         f->biases[i] = biases[i];
     }
+    f->winograd_cache_flag = 0;
 }
 
 /* This function loads a convolutional layer from a .bin file from fr
@@ -1756,6 +1768,7 @@ cl* copy_cl(cl* f){
     copy_int_array(f->used_kernels,copy->used_kernels,f->n_kernels);
     copy->feed_forward_flag = f->feed_forward_flag;
     copy->training_mode = f->training_mode;
+    copy->convolution_algorithm = f->convolution_algorithm;
     return copy;
 }
 
@@ -1775,6 +1788,7 @@ cl* reset_cl(cl* f){
         return NULL;
     
     int i,j;
+    reset_cl_except_partial_derivatives(f);
     if(f->convolutional_flag == CONVOLUTION || f->convolutional_flag == TRANSPOSED_CONVOLUTION){
         for(i = 0; i < f->n_kernels; i++){
             for(j = 0; j < f->channels*f->kernel_rows*f->kernel_cols; j++){
@@ -1784,6 +1798,38 @@ cl* reset_cl(cl* f){
             f->d_biases[i] = 0;
         }
     }
+    
+    if(f->normalization_flag == GROUP_NORMALIZATION){
+        for(i = 0; i < f->n_kernels/f->group_norm_channels; i++){
+            for(j = 0; j < f->group_norm[i]->vector_dim; j++){
+                f->group_norm[i]->d_gamma[j] = 0;
+                f->group_norm[i]->d_beta[j] = 0;
+            }
+        }
+    }
+    
+    if(f->training_mode == EDGE_POPUP){
+        for(i = 0; i < f->n_kernels*f->channels*f->kernel_cols*f->kernel_rows; i++){
+            f->d_scores[i] = 0;
+        }
+    }
+    return f;
+}
+
+/* this function resets all the arrays of a convolutional layer like reset_cl,
+ * except for the partial derivatives d_kernels, d_biases, d_scores and the ones of the group normalization
+ * that are left untouched
+ * 
+ * Input:
+ * 
+ *             @ cl* f:= a cl* f layer
+ * 
+ * */
+cl* reset_cl_except_partial_derivatives(cl* f){
+    if(f == NULL)
+        return NULL;
+    
+    int i;
     for(i = 0; i < f->n_kernels*f->rows1*f->cols1; i++){
         f->pre_activation[i] = 0;
         f->post_activation[i] = 0;
@@ -1804,13 +1850,12 @@ cl* reset_cl(cl* f){
     
     if(f->normalization_flag == GROUP_NORMALIZATION){
         for(i = 0; i < f->n_kernels/f->group_norm_channels; i++){
-            reset_bn(f->group_norm[i]);
+            reset_bn_except_partial_derivatives(f->group_norm[i]);
         }
     }
     
     if(f->training_mode == EDGE_POPUP){
         for(i = 0; i < f->n_kernels*f->channels*f->kernel_cols*f->kernel_rows; i++){
-            f->d_scores[i] = 0;
             f->indices[i] = i;
         }
         for(i = 0; i < f->n_kernels; i++){
@@ -1895,6 +1940,7 @@ void paste_cl(cl* f, cl* copy){
         copy_array(f->d2_scores,copy->d2_scores,f->n_kernels*f->channels*f->kernel_rows*f->kernel_cols);
         copy_array(f->d3_scores,copy->d3_scores,f->n_kernels*f->channels*f->kernel_rows*f->kernel_cols);
     }
+    copy->winograd_cache_flag = 0;
     return;
 }
 
@@ -1929,6 +1975,7 @@ void paste_w_cl(cl* f, cl* copy){
         copy_int_array(f->used_kernels,copy->used_kernels,f->n_kernels);
         copy_array(f->scores,copy->scores,f->n_kernels*f->channels*f->kernel_rows*f->kernel_cols);
     }
+    copy->winograd_cache_flag = 0;
     return;
 }
 
@@ -1987,6 +2034,7 @@ void slow_paste_cl(cl* f, cl* copy,float tau){
             copy->used_kernels[(int)(copy->indices[i]/(copy->channels*copy->kernel_rows*copy->kernel_cols))] = 1;
          }
      }
+    copy->winograd_cache_flag = 0;
     return;
 }
 
@@ -2035,6 +2083,7 @@ void memcopy_vector_to_params_cl(cl* f, float* vector){
             memcpy(f->group_norm[i]->beta,&vector[f->n_kernels*f->channels*f->kernel_rows*f->kernel_cols+f->n_kernels+(f->n_kernels/f->group_norm_channels+i)*f->group_norm[i]->vector_dim],f->group_norm[i]->vector_dim*sizeof(float));
         }
     }
+    f->winograd_cache_flag = 0;
 }
 
 
@@ -2120,6 +2169,48 @@ void memcopy_derivative_params_to_vector_cl(cl* f, float* vector){
     }
 }
 
+/* this function stores the arrays of the partial derivatives of a cl structure that are summed over a batch
+ * 
+ * Inputs:
+ * 
+ * 
+ *                 @ cl* f:= the convolutional layer
+ *                 @ float** segments:= where the arrays are stored, if NULL the arrays are only counted
+ *                 @ int* sizes:= where the sizes of the arrays are stored
+ * 
+ * Output:
+ *                 @ int:= the number of arrays
+ * */
+int get_partial_derivatives_segments_cl(cl* f, float** segments, int* sizes){
+    int i,n = 0;
+    if(f->convolutional_flag != CONVOLUTION && f->convolutional_flag != TRANSPOSED_CONVOLUTION)
+        return 0;
+    for(i = 0; i < f->n_kernels; i++,n++){
+        if(segments != NULL){
+            segments[n] = f->d_kernels[i];
+            sizes[n] = f->channels*f->kernel_rows*f->kernel_cols;
+        }
+    }
+    if(segments != NULL){
+        segments[n] = f->d_biases;
+        sizes[n] = f->n_kernels;
+        segments[n+1] = f->d_scores;
+        sizes[n+1] = f->n_kernels*f->channels*f->kernel_rows*f->kernel_cols;
+    }
+    n+=2;
+    if(f->normalization_flag == GROUP_NORMALIZATION){
+        for(i = 0; i < f->n_kernels/f->group_norm_channels; i++,n+=2){
+            if(segments != NULL){
+                segments[n] = f->group_norm[i]->d_gamma;
+                sizes[n] = f->group_norm[i]->vector_dim;
+                segments[n+1] = f->group_norm[i]->d_beta;
+                sizes[n+1] = f->group_norm[i]->vector_dim;
+            }
+        }
+    }
+    return n;
+}
+
 /* setting the biases to 0
  * 
  * Input:
@@ -2294,3 +2385,220 @@ void reinitialize_scores_cl(cl* f, float percentage, float goodness){
         }
     }
 }
+
+/* This function returns a cl* layer that shares the kernels, the biases, the scores
+ * and the optimizer arrays (d1,d2,d3 and ex_d) with the layer f. The arrays used during the feed forward,
+ * the back propagation and the partial derivatives are owned by the new layer, so the partial derivatives
+ * of the shared layer must be summed to f before updating it. The returned layer must be deallocated
+ * with free_shared_cl.
+ * 
+ * Input:
+ * 
+ *             @ cl* f:= the convolutional layer that owns the parameters
+ * 
+ * */
+cl* share_cl(cl* f){
+    if(f == NULL)
+        return NULL;
+    cl* c = convolutional(f->channels,f->input_rows,f->input_cols,f->kernel_rows,f->kernel_cols,f->n_kernels,f->stride1_rows,f->stride1_cols,f->padding1_rows,f->padding1_cols,f->stride2_rows,f->stride2_cols,f->padding2_rows,f->padding2_cols,f->pooling_rows,f->pooling_cols,f->normalization_flag,f->activation_flag,f->pooling_flag,f->group_norm_channels, f->convolutional_flag,f->layer);
+    
+    int i;
+    for(i = 0; i < f->n_kernels; i++){
+        free(c->kernels[i]);
+        free(c->ex_d_kernels_diff_grad[i]);
+        free(c->d1_kernels[i]);
+        free(c->d2_kernels[i]);
+        free(c->d3_kernels[i]);
+        c->kernels[i] = f->kernels[i];
+        c->ex_d_kernels_diff_grad[i] = f->ex_d_kernels_diff_grad[i];
+        c->d1_kernels[i] = f->d1_kernels[i];
+        c->d2_kernels[i] = f->d2_kernels[i];
+        c->d3_kernels[i] = f->d3_kernels[i];
+    }
+    
+    free(c->biases);
+    free(c->ex_d_biases_diff_grad);
+    free(c->d1_biases);
+    free(c->d2_biases);
+    free(c->d3_biases);
+    free(c->scores);
+    free(c->ex_d_scores_diff_grad);
+    free(c->d1_scores);
+    free(c->d2_scores);
+    free(c->d3_scores);
+    c->biases = f->biases;
+    c->ex_d_biases_diff_grad = f->ex_d_biases_diff_grad;
+    c->d1_biases = f->d1_biases;
+    c->d2_biases = f->d2_biases;
+    c->d3_biases = f->d3_biases;
+    c->scores = f->scores;
+    c->ex_d_scores_diff_grad = f->ex_d_scores_diff_grad;
+    c->d1_scores = f->d1_scores;
+    c->d2_scores = f->d2_scores;
+    c->d3_scores = f->d3_scores;
+    
+    if(f->normalization_flag == GROUP_NORMALIZATION){
+        for(i = 0; i < f->n_kernels/f->group_norm_channels; i++){
+            free_batch_normalization(c->group_norm[i]);
+            c->group_norm[i] = share_bn(f->group_norm[i]);
+        }
+    }
+    
+    copy_int_array(f->indices,c->indices,f->n_kernels*f->channels*f->kernel_cols*f->kernel_rows);
+    copy_int_array(f->used_kernels,c->used_kernels,f->n_kernels);
+    c->feed_forward_flag = f->feed_forward_flag;
+    c->training_mode = f->training_mode;
+    c->k_percentage = f->k_percentage;
+    c->n_best_w = f->n_best_w;
+    c->convolution_algorithm = f->convolution_algorithm;
+    return c;
+}
+
+/* This function deallocates a cl* layer created with share_cl, the shared arrays are not freed
+ * 
+ * Input:
+ * 
+ *             @ cl* c:= the shared convolutional layer
+ * 
+ * */
+void free_shared_cl(cl* c){
+    if(c == NULL)
+        return;
+    
+    int i;
+    for(i = 0; i < c->n_kernels; i++){
+        c->kernels[i] = NULL;
+        c->ex_d_kernels_diff_grad[i] = NULL;
+        c->d1_kernels[i] = NULL;
+        c->d2_kernels[i] = NULL;
+        c->d3_kernels[i] = NULL;
+    }
+    
+    c->biases = NULL;
+    c->ex_d_biases_diff_grad = NULL;
+    c->d1_biases = NULL;
+    c->d2_biases = NULL;
+    c->d3_biases = NULL;
+    c->scores = NULL;
+    c->ex_d_scores_diff_grad = NULL;
+    c->d1_scores = NULL;
+    c->d2_scores = NULL;
+    c->d3_scores = NULL;
+    
+    if(c->normalization_flag == GROUP_NORMALIZATION){
+        for(i = 0; i < c->n_kernels/c->group_norm_channels; i++){
+            free_shared_bn(c->group_norm[i]);
+            c->group_norm[i] = NULL;
+        }
+    }
+    free_convolutional(c);
+}
+
+/* This function sets the algorithm used by the feed forward and the back propagation of the convolution
+ * (only for CONVOLUTION layers with FULLY_FEED_FORWARD, the other layers use always the direct loops).
+ * AUTO_CONVOLUTION uses winograd for 3*3 kernels with stride 1 and im2col otherwise
+ * 
+ * Input:
+ *             @ cl* c:= the convolutional layer
+ *             @ int algorithm:= AUTO_CONVOLUTION, DIRECT_CONVOLUTION, IM2COL_CONVOLUTION or WINOGRAD_CONVOLUTION
+ * */
+void set_convolution_algorithm(cl* c, int algorithm){
+    if(algorithm != AUTO_CONVOLUTION && algorithm != DIRECT_CONVOLUTION && algorithm != IM2COL_CONVOLUTION && algorithm != WINOGRAD_CONVOLUTION){
+        fprintf(stderr,"Error: the convolution algorithm must be AUTO_CONVOLUTION, DIRECT_CONVOLUTION, IM2COL_CONVOLUTION or WINOGRAD_CONVOLUTION\n");
+        exit(1);
+    }
+    if(algorithm == WINOGRAD_CONVOLUTION && (c->kernel_rows != 3 || c->kernel_cols != 3 || c->stride1_rows != 1)){
+        fprintf(stderr,"Error: the winograd convolution can be used only with 3*3 kernels and stride 1, layer: %d\n",c->layer);
+        exit(1);
+    }
+    c->convolution_algorithm = algorithm;
+}
+
+/* This function returns the algorithm used by the convolution of the layer, resolving AUTO_CONVOLUTION
+ * 
+ * Input:
+ *             @ cl* c:= the convolutional layer
+ * */
+int get_convolution_algorithm(cl* c){
+    if(c->convolution_algorithm != AUTO_CONVOLUTION)
+        return c->convolution_algorithm;
+    if(c->kernel_rows == 3 && c->kernel_cols == 3 && c->stride1_rows == 1)
+        return WINOGRAD_CONVOLUTION;
+    return IM2COL_CONVOLUTION;
+}
+
+/* This function computes the winograd transformations of the kernels of the layer if they are not
+ * computed yet from the current kernels, the transformations are invalidated by update_model and by the functions that paste the kernels
+ * 
+ * Input:
+ *             @ cl* c:= the convolutional layer
+ * */
+void update_winograd_kernels(cl* c){
+    if(c->winograd_kernels == NULL){
+        c->winograd_kernels = (float*)malloc(sizeof(float)*winograd_kernels_size(c->n_kernels,c->channels,c->winograd_tile));
+        c->winograd_kernels_bp = (float*)malloc(sizeof(float)*winograd_kernels_size(c->n_kernels,c->channels,c->winograd_tile));
+        c->winograd_workspace = (float*)malloc(sizeof(float)*winograd_workspace_size(c->channels,c->input_rows,c->input_cols,c->n_kernels,c->winograd_tile));
+        c->winograd_cache_flag = 0;
+    }
+    if(c->winograd_cache_flag)
+        return;
+    winograd_kernel_transform(c->kernels,c->n_kernels,c->channels,c->winograd_tile,0,c->winograd_kernels);
+    winograd_kernel_transform(c->kernels,c->n_kernels,c->channels,c->winograd_tile,1,c->winograd_kernels_bp);
+    c->winograd_cache_flag = 1;
+}
+
+/* This function returns the workspace used by the im2col convolution of the layer, allocating it the first time
+ * 
+ * Input:
+ *             @ cl* c:= the convolutional layer
+ * */
+float* get_convolution_workspace(cl* c){
+    if(c->convolution_workspace == NULL)
+        c->convolution_workspace = (float*)malloc(sizeof(float)*im2col_workspace_size(c->channels,c->input_rows,c->input_cols,c->kernel_rows,c->kernel_cols,c->n_kernels,c->stride1_rows));
+    return c->convolution_workspace;
+}
+
+/* This function computes the convolution of all the kernels of c applied to input, the result is summed in c->pre_activation
+ * 
+ * Input:
+ *             @ cl* c:= the convolutional layer
+ *             @ float* input:= the input of the layer, dimensions: c->channels*c->input_rows*c->input_cols
+ * */
+void convolutional_layer_feed_forward(cl* c, float* input){
+    int i,algorithm = get_convolution_algorithm(c);
+    if(algorithm == WINOGRAD_CONVOLUTION){
+        update_winograd_kernels(c);
+        convolutional_feed_forward_winograd(input, c->winograd_kernels, c->n_kernels, c->input_rows, c->input_cols, c->biases, c->channels, c->pre_activation, c->padding1_rows, c->winograd_tile, c->winograd_workspace);
+        return;
+    }
+    if(algorithm == IM2COL_CONVOLUTION){
+        convolutional_feed_forward_im2col(input, c->kernels, c->n_kernels, c->input_rows, c->input_cols, c->kernel_rows, c->kernel_cols, c->biases, c->channels, c->pre_activation, c->stride1_rows, c->padding1_rows, get_convolution_workspace(c));
+        return;
+    }
+    for(i = 0; i < c->n_kernels; i++){
+        convolutional_feed_forward(input, c->kernels[i], c->input_rows, c->input_cols, c->kernel_rows, c->kernel_cols, c->biases[i], c->channels, &c->pre_activation[i*c->rows1*c->cols1], c->stride1_rows, c->padding1_rows);
+    }
+}
+
+/* This function computes the back propagation of the convolution of all the kernels of c using c->temp as error of the output,
+ * the errors are summed in c->error2, c->d_kernels and c->d_biases
+ * 
+ * Input:
+ *             @ cl* c:= the convolutional layer
+ *             @ float* input:= the input of the layer used in the feed forward, dimensions: c->channels*c->input_rows*c->input_cols
+ * */
+void convolutional_layer_back_prop(cl* c, float* input){
+    int i,algorithm = get_convolution_algorithm(c);
+    if(algorithm == WINOGRAD_CONVOLUTION){
+        update_winograd_kernels(c);
+        convolutional_back_prop_winograd(input, c->winograd_kernels_bp, c->n_kernels, c->input_rows, c->input_cols, c->channels, c->temp, c->error2, c->d_kernels, c->d_biases, c->padding1_rows, c->winograd_tile, c->winograd_workspace);
+        return;
+    }
+    if(algorithm == IM2COL_CONVOLUTION){
+        convolutional_back_prop_im2col(input, c->kernels, c->n_kernels, c->input_rows, c->input_cols, c->kernel_rows, c->kernel_cols, c->channels, c->temp, c->error2, c->d_kernels, c->d_biases, c->stride1_rows, c->padding1_rows, get_convolution_workspace(c));
+        return;
+    }
+    for(i = 0; i < c->n_kernels; i++){
+        convolutional_back_prop(input, c->kernels[i], c->input_rows,c->input_cols,c->kernel_rows,c->kernel_cols,c->biases[i],c->channels,&c->temp[i*c->rows1*c->cols1],c->error2,c->d_kernels[i], &c->d_biases[i], c->stride1_rows, c->padding1_rows);
+    }
+}
@@ -33,12 +33,14 @@ cl* load_cl(FILE* fr);
 cl* copy_cl(cl* f);
 void paste_cl(cl* f, cl* copy);
 cl* reset_cl(cl* f);
+cl* reset_cl_except_partial_derivatives(cl* f);
 unsigned long long int size_of_cls(cl* f);
 void slow_paste_cl(cl* f, cl* copy,float tau);
 int get_array_size_params_cl(cl* f);
 void memcopy_params_to_vector_cl(cl* f, float* vector);
 void memcopy_vector_to_params_cl(cl* f, float* vector);
 void memcopy_derivative_params_to_vector_cl(cl* f, float* vector);
+int get_partial_derivatives_segments_cl(cl* f, float** segments, int* sizes);
 void memcopy_vector_to_derivative_params_cl(cl* f, float* vector);
 void set_convolutional_biases_to_zero(cl* c);
 void set_convolutional_unused_weights_to_zero(cl* c);
@@ -51,5 +53,13 @@ void sum_score_cl(cl* input1, cl* input2, cl* output);
 void dividing_score_cl(cl* c,float value);
 void reset_score_cl(cl* f);
 void reinitialize_scores_cl(cl* f, float percentage, float goodness);
+cl* share_cl(cl* f);
+void free_shared_cl(cl* c);
+void set_convolution_algorithm(cl* c, int algorithm);
+int get_convolution_algorithm(cl* c);
+void update_winograd_kernels(cl* c);
+float* get_convolution_workspace(cl* c);
+void convolutional_layer_feed_forward(cl* c, float* input);
+void convolutional_layer_back_prop(cl* c, float* input);
 
 #endif
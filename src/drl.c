@@ -176,10 +176,10 @@ ddpg* init_ddpg(model* m1, model* m2, model* m3, model* m4, int batch_size, int
         d->tm2[i] = copy_model(m2);
         d->tm3[i] = copy_model(m3);
         d->tm4[i] = copy_model(m4);
-        d->bm1[i] = copy_model(m1);
-        d->bm2[i] = copy_model(m2);
-        d->bm3[i] = copy_model(m3);
-        d->bm4[i] = copy_model(m4);
+        d->bm1[i] = share_model(m1);
+        d->bm2[i] = share_model(m2);
+        d->bm3[i] = share_model(m3);
+        d->bm4[i] = share_model(m4);
         d->tm1_output_array[i] = d->tm1[i]->output_layer;
         d->tm2_output_array[i] = d->tm2[i]->output_layer;
         d->tm3_output_array[i] = d->tm3[i]->output_layer;
@@ -310,9 +310,9 @@ void ddpg_train(ddpg* d){
     model_tensor_input_bp_multicore(d->bm3,1,1,d->m1_output,d->actions,d->batch_size,d->threads,ret_err3,d->m3_output,ret_err2);
     model_tensor_input_bp_multicore(d->bm2,1,1,d->m1_input,d->buff1,d->batch_size,d->threads,ret_err,d->m2_output,ret_err2);
     
-    sum_models_partial_derivatives(d->m2,d->bm2,d->batch_size);
-    sum_models_partial_derivatives(d->m3,d->bm3,d->batch_size);
-    sum_models_partial_derivatives(d->m4,d->bm4,d->batch_size);
+    sum_models_partial_derivatives_multicore(d->m2,d->bm2,d->batch_size,1,d->threads);
+    sum_models_partial_derivatives_multicore(d->m3,d->bm3,d->batch_size,1,d->threads);
+    sum_models_partial_derivatives_multicore(d->m4,d->bm4,d->batch_size,1,d->threads);
     
     update_model(d->m4,d->lr1,d->momentum1,d->batch_size,d->gradient_descent_flag1,&d->m4->beta1_adam,&d->m4->beta2_adam,d->regularization1,d->n_weights1,d->lambda1,&d->t1);
     d->t1--;
@@ -323,15 +323,6 @@ void ddpg_train(ddpg* d){
     reset_model(d->m2);
     reset_model(d->m3);
     reset_model(d->m4);
-    for(i = 0; i < d->batch_size; i++){
-        reset_model(d->bm2[i]);
-        reset_model(d->bm3[i]);
-        reset_model(d->bm4[i]);
-        paste_model(d->m2,d->bm2[i]);
-        paste_model(d->m3,d->bm3[i]);
-        paste_model(d->m4,d->bm4[i]);
-    }
-    
     model_tensor_input_ff_multicore(d->bm1,1,1,d->m1_input,d->buff1,d->batch_size,d->threads);
     model_tensor_input_ff_multicore(d->bm2,1,1,d->m1_input,d->buff1,d->batch_size,d->threads);
     model_tensor_input_ff_multicore(d->bm3,1,1,d->m1_output,d->bm1_output_array,d->batch_size,d->threads);
@@ -351,16 +342,14 @@ void ddpg_train(ddpg* d){
     model_tensor_input_bp_multicore(d->bm3,1,1,d->m1_output,d->bm1_output_array,d->batch_size,d->threads,ret_err3,d->m3_output,ret_err2);
     model_tensor_input_bp_multicore(d->bm1,1,1,d->m1_input,d->buff1,d->batch_size,d->threads,ret_err2,d->m1_output,ret_err);
     
-    sum_models_partial_derivatives(d->m1,d->bm1,d->batch_size);
+    sum_models_partial_derivatives_multicore(d->m1,d->bm1,d->batch_size,1,d->threads);
     update_model(d->m1,d->lr2,d->momentum2,d->batch_size,d->gradient_descent_flag2,&d->m1->beta1_adam,&d->m1->beta2_adam,d->regularization2,d->n_weights2,d->lambda2,&d->t2);
     
     reset_model(d->m1);
     for(i = 0; i < d->batch_size; i++){
-        reset_model(d->bm1[i]);
         reset_model(d->bm2[i]);
         reset_model(d->bm3[i]);
         reset_model(d->bm4[i]);
-        paste_model(d->m1,d->bm1[i]);
         slow_paste_model(d->m1,d->tm1[i],d->tau);
         slow_paste_model(d->m2,d->tm2[i],d->tau);
         slow_paste_model(d->m3,d->tm3[i],d->tau);
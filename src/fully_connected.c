@@ -40,11 +40,9 @@ SOFTWARE.
  *         @ int output_size:= the size of the float* output vector
  * */
 void fully_connected_feed_forward(float* input, float* output, float* weight,float* bias, int input_size, int output_size){
-    int i,j;
+    int j;
+    sgemv(output_size,input_size,weight,input_size,input,output);
     for(j = 0; j < output_size; j++){
-        for(i = 0; i < input_size; i++){
-            output[j] += input[i]*weight[j*input_size+i];
-        }
         output[j] += bias[j];
     }
 }
@@ -96,12 +94,10 @@ void fully_connected_feed_forward_edge_popup(float* input, float* output, float*
  *         @ int output_size:= the size of the float* output_error vector
  * */
 void fully_connected_back_prop(float* input, float* output_error, float* weight,float* input_error, float* weight_error,float* bias_error, int input_size, int output_size){
-    int i,j;
+    int j;
+    sger(output_size,input_size,output_error,input,weight_error,input_size);
+    sgemv_t(output_size,input_size,weight,input_size,output_error,input_error);
     for(j = 0; j < output_size; j++){
-        for(i = 0; i < input_size; i++){
-            weight_error[j*input_size+i] += output_error[j]*input[i];
-            input_error[i] += output_error[j]*weight[j*input_size+i];
-        }
         bias_error[j] += output_error[j];
     }
 }
@@ -181,3 +177,124 @@ void fully_connected_back_prop_edge_popup_ff_gd_bp(float* input, float* output_e
 
 
 
+
+
+/* This function computes the output of the current layer for a whole batch of inputs
+ * using the weights that connect the two layers and the biases of the output layer.
+ * The outputs are computed by sgemm_nt, each output is computed with the same operations
+ * of fully_connected_feed_forward, so the results are the same
+ * 
+ * Input:
+ *         @ float* input:= the inputs of the batch
+ *                          dimensions: batch_size*input_size
+ *         @ float* output:= the outputs of the batch, that must be filled
+ *                           dimensions: batch_size*output_size
+ *         @ float* weight:= a vector of weight which connects the current layer with the prvious one
+ *                           dimensions: output_size*input_size
+ *         @ float* bias:= a vector of bias of the current layer
+ *                         dimensions: output_size
+ *         @ int input_size:= the size of each input
+ *         @ int output_size:= the size of each output
+ *         @ int batch_size:= the number of instances of the batch
+ * */
+void fully_connected_feed_forward_batch(float* input, float* output, float* weight,float* bias, int input_size, int output_size, int batch_size){
+    int j,b;
+    sgemm_nt(batch_size,output_size,input_size,input,input_size,weight,input_size,output,output_size);
+    for(b = 0; b < batch_size; b++){
+        for(j = 0; j < output_size; j++){
+            output[b*output_size+j] += bias[j];
+        }
+    }
+}
+
+/* This function computes the error of the previous layer and the error of the weights and biases
+ * for a whole batch, the partial derivatives of the weights and biases are summed over the batch
+ * in the order of the instances, so they are the same you would get summing the partial derivatives
+ * of batch_size layers computed with fully_connected_back_prop
+ * 
+ * Input:
+ *         @ float* input:= the inputs of the batch
+ *                          dimensions: batch_size*input_size
+ *         @ float* output_error:= the errors of the current layer
+ *                                 dimensions: batch_size*output_size
+ *         @ float* weight:= a vector of weight which connects the current layer with the prvious one
+ *                           dimensions: output_size*input_size
+ *         @ float* input_error:= the errors of the previous layer that must be filled
+ *                                dimensions: batch_size*input_size
+ *         @ float* weight_error:= a vector of error of the of the weights of the two layers that must be filled
+ *                                 dimensions: output_size*input_size
+ *         @ float* bias_error:= a vector of error of the of the biases of the current layer that must be filled
+ *                               dimensions: output_size
+ *         @ int input_size:= the size of each input
+ *         @ int output_size:= the size of each output error
+ *         @ int batch_size:= the number of instances of the batch
+ * */
+void fully_connected_back_prop_batch(float* input, float* output_error, float* weight,float* input_error, float* weight_error,float* bias_error, int input_size, int output_size, int batch_size){
+    int j,b;
+    sgemm_tn(output_size,input_size,batch_size,output_error,output_size,input,input_size,weight_error,input_size);
+    sgemm_nn(batch_size,input_size,output_size,output_error,output_size,weight,input_size,input_error,input_size);
+    for(j = 0; j < output_size; j++){
+        for(b = 0; b < batch_size; b++){
+            bias_error[j] += output_error[b*output_size+j];
+        }
+    }
+}
+
+/* This function computes the feed forward of fully_connected_feed_forward_batch with the weights
+ * stored in 16 bits, the products are accumulated in float
+ * 
+ * Input:
+ *         @ float* input:= the inputs of the batch
+ *                          dimensions: batch_size*input_size
+ *         @ float* output:= the outputs of the batch, that must be filled
+ *                           dimensions: batch_size*output_size
+ *         @ unsigned short* weight:= the 16 bits weights
+ *                           dimensions: output_size*input_size
+ *         @ float* bias:= a vector of bias of the current layer
+ *                         dimensions: output_size
+ *         @ int input_size:= the size of each input
+ *         @ int output_size:= the size of each output
+ *         @ int batch_size:= the number of instances of the batch
+ *         @ int precision:= BF16_PRECISION or FP16_PRECISION
+ * */
+void fully_connected_feed_forward_batch_half(float* input, float* output, unsigned short* weight,float* bias, int input_size, int output_size, int batch_size, int precision){
+    int j,b;
+    sgemm_nt_half(batch_size,output_size,input_size,input,input_size,weight,input_size,precision,output,output_size);
+    for(b = 0; b < batch_size; b++){
+        for(j = 0; j < output_size; j++){
+            output[b*output_size+j] += bias[j];
+        }
+    }
+}
+
+/* This function computes the back propagation of fully_connected_back_prop_batch with the weights
+ * stored in 16 bits, the partial derivatives are float
+ * 
+ * Input:
+ *         @ float* input:= the inputs of the batch
+ *                          dimensions: batch_size*input_size
+ *         @ float* output_error:= the errors of the current layer
+ *                                 dimensions: batch_size*output_size
+ *         @ unsigned short* weight:= the 16 bits weights
+ *                           dimensions: output_size*input_size
+ *         @ float* input_error:= the errors of the previous layer that must be filled
+ *                                dimensions: batch_size*input_size
+ *         @ float* weight_error:= a vector of error of the of the weights of the two layers that must be filled
+ *                                 dimensions: output_size*input_size
+ *         @ float* bias_error:= a vector of error of the of the biases of the current layer that must be filled
+ *                               dimensions: output_size
+ *         @ int input_size:= the size of each input
+ *         @ int output_size:= the size of each output error
+ *         @ int batch_size:= the number of instances of the batch
+ *         @ int precision:= BF16_PRECISION or FP16_PRECISION
+ * */
+void fully_connected_back_prop_batch_half(float* input, float* output_error, unsigned short* weight,float* input_error, float* weight_error,float* bias_error, int input_size, int output_size, int batch_size, int precision){
+    int j,b;
+    sgemm_tn(output_size,input_size,batch_size,output_error,output_size,input,input_size,weight_error,input_size);
+    sgemm_nn_half(batch_size,input_size,output_size,output_error,output_size,weight,input_size,precision,input_error,input_size);
+    for(j = 0; j < output_size; j++){
+        for(b = 0; b < batch_size; b++){
+            bias_error[j] += output_error[b*output_size+j];
+        }
+    }
+}
@@ -30,6 +30,10 @@ void fully_connected_back_prop(float* input, float* output_error, float* weight,
 void fully_connected_back_prop_edge_popup(float* input, float* output_error, float* weight,float* input_error, float* weight_error,float* bias_error, int input_size, int output_size,float* score_error, int* indices, int last_n);
 void fully_connected_feed_forward_edge_popup(float* input, float* output, float* weight,float* bias, int input_size, int output_size, int* indices, int last_n);
 void fully_connected_back_prop_edge_popup_ff_gd_bp(float* input, float* output_error, float* weight,float* input_error, float* weight_error,float* bias_error, int input_size, int output_size,float* score_error, int* indices, int last_n);
+void fully_connected_feed_forward_batch(float* input, float* output, float* weight,float* bias, int input_size, int output_size, int batch_size);
+void fully_connected_back_prop_batch(float* input, float* output_error, float* weight,float* input_error, float* weight_error,float* bias_error, int input_size, int output_size, int batch_size);
+void fully_connected_feed_forward_batch_half(float* input, float* output, unsigned short* weight,float* bias, int input_size, int output_size, int batch_size, int precision);
+void fully_connected_back_prop_batch_half(float* input, float* output_error, unsigned short* weight,float* input_error, float* weight_error,float* bias_error, int input_size, int output_size, int batch_size, int precision);
 void paste_w_fcl(fcl* f,fcl* copy);
 
 #endif
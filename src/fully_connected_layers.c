@@ -1049,38 +1049,62 @@ fcl* reset_fcl(fcl* f){
     if(f == NULL)
         return NULL;
     int i;
+    reset_fcl_except_partial_derivatives(f);
     for(i = 0; i < f->output*f->input; i++){
-        if(i < f->output){
-            f->pre_activation[i] = 0;
-            f->post_activation[i] = 0;
-            f->post_normalization[i] = 0;
+        if(i < f->output)
             f->d_biases[i] = 0;
-            if(f->dropout_flag)
-                f->dropout_mask[i] = 1;
-            f->dropout_temp[i] = 0;
-            f->temp[i] = 0;
-            f->temp3[i] = 0;
-            
-        }
-        if(i < f->input){
-            f->temp2[i] = 0;
-            f->error2[i] = 0;
-        }
         f->d_weights[i] = 0;
-        
-        if(f->training_mode == EDGE_POPUP){
-            f->indices[i] = i;
+        if(f->training_mode == EDGE_POPUP)
             f->d_scores[i] = 0;
+    }
+    
+    if(f->normalization_flag == LAYER_NORMALIZATION){
+        for(i = 0; i < f->layer_norm->vector_dim; i++){
+            f->layer_norm->d_gamma[i] = 0;
+            f->layer_norm->d_beta[i] = 0;
         }
     }
+    return f;
+}
+
+/* this function resets all the arrays of a fully-connected layer like reset_fcl,
+ * except for the partial derivatives d_weights, d_biases, d_scores and the ones of the layer normalization
+ * that are left untouched
+ * 
+ * Input:
+ * 
+ *             @ fcl* f:= a fcl* f layer
+ * 
+ * */
+fcl* reset_fcl_except_partial_derivatives(fcl* f){
+    if(f == NULL)
+        return NULL;
+    int i;
+    for(i = 0; i < f->output; i++){
+        f->pre_activation[i] = 0;
+        f->post_activation[i] = 0;
+        f->post_normalization[i] = 0;
+        if(f->dropout_flag)
+            f->dropout_mask[i] = 1;
+        f->dropout_temp[i] = 0;
+        f->temp[i] = 0;
+        f->temp3[i] = 0;
+    }
+    for(i = 0; i < f->input; i++){
+        f->temp2[i] = 0;
+        f->error2[i] = 0;
+    }
     if(f->training_mode == EDGE_POPUP){
+        for(i = 0; i < f->output*f->input; i++){
+            f->indices[i] = i;
+        }
         quick_sort(f->scores,f->indices,0,f->output*f->input-1);
         free(f->active_output_neurons);
         f->active_output_neurons = get_used_outputs(f,NULL,FCLS,f->output);
     }
     
     if(f->normalization_flag == LAYER_NORMALIZATION)
-        reset_bn(f->layer_norm);
+        reset_bn_except_partial_derivatives(f->layer_norm);
     return f;
 }
 
@@ -1288,6 +1312,41 @@ void memcopy_derivative_params_to_vector(fcl* f, float* vector){
     memcpy(&vector[f->input*f->output],f->d_biases,f->output*sizeof(float));
 }
 
+/* this function stores the arrays of the partial derivatives of a fcl structure that are summed over a batch
+ * 
+ * Inputs:
+ * 
+ * 
+ *                 @ fcl* f:= the fully-connecteed layer
+ *                 @ float** segments:= where the arrays are stored, if NULL the arrays are only counted
+ *                 @ int* sizes:= where the sizes of the arrays are stored
+ * 
+ * Output:
+ *                 @ int:= the number of arrays
+ * */
+int get_partial_derivatives_segments(fcl* f, float** segments, int* sizes){
+    int n = 0;
+    if(segments != NULL){
+        segments[0] = f->d_weights;
+        sizes[0] = f->input*f->output;
+        segments[1] = f->d_biases;
+        sizes[1] = f->output;
+        segments[2] = f->d_scores;
+        sizes[2] = f->input*f->output;
+    }
+    n = 3;
+    if(f->normalization_flag == LAYER_NORMALIZATION){
+        if(segments != NULL){
+            segments[n] = f->layer_norm->d_gamma;
+            sizes[n] = f->layer_norm->vector_dim;
+            segments[n+1] = f->layer_norm->d_beta;
+            sizes[n+1] = f->layer_norm->vector_dim;
+        }
+        n+=2;
+    }
+    return n;
+}
+
 /* setting the biases to 0
  * Inpout:
  *             @ fcl* f:= the fully connected layer
@@ -1524,3 +1583,98 @@ void reinitialize_scores_fcl(fcl* f, float percentage, float goodness){
             f->weights[f->indices[i]] = random_general_gaussian(0, (float)f->input);
     }
 }
+
+/* This function creates a fcl* layer that shares the weights, the biases, the scores
+ * and the optimizer arrays (d1,d2,d3 and ex_d) with the layer f. The arrays used during the feed forward,
+ * the back propagation and the partial derivatives are owned by the new layer, so the partial derivatives
+ * of the shared layer must be summed to f before updating it. The returned layer must be deallocated
+ * with free_shared_fcl.
+ * 
+ * Input:
+ * 
+ *             @ fcl* f:= the fully-connected layer that owns the parameters
+ * 
+ * */
+fcl* share_fcl(fcl* f){
+    if(f == NULL)
+        return NULL;
+    fcl* s = fully_connected(f->input, f->output,f->layer, f->dropout_flag,f->activation_flag,f->dropout_threshold,f->n_groups,f->normalization_flag);
+    
+    free(s->weights);
+    free(s->ex_d_weights_diff_grad);
+    free(s->d1_weights);
+    free(s->d2_weights);
+    free(s->d3_weights);
+    free(s->biases);
+    free(s->ex_d_biases_diff_grad);
+    free(s->d1_biases);
+    free(s->d2_biases);
+    free(s->d3_biases);
+    free(s->scores);
+    free(s->ex_d_scores_diff_grad);
+    free(s->d1_scores);
+    free(s->d2_scores);
+    free(s->d3_scores);
+    s->weights = f->weights;
+    s->ex_d_weights_diff_grad = f->ex_d_weights_diff_grad;
+    s->d1_weights = f->d1_weights;
+    s->d2_weights = f->d2_weights;
+    s->d3_weights = f->d3_weights;
+    s->biases = f->biases;
+    s->ex_d_biases_diff_grad = f->ex_d_biases_diff_grad;
+    s->d1_biases = f->d1_biases;
+    s->d2_biases = f->d2_biases;
+    s->d3_biases = f->d3_biases;
+    s->scores = f->scores;
+    s->ex_d_scores_diff_grad = f->ex_d_scores_diff_grad;
+    s->d1_scores = f->d1_scores;
+    s->d2_scores = f->d2_scores;
+    s->d3_scores = f->d3_scores;
+    
+    if(f->normalization_flag == LAYER_NORMALIZATION){
+        free_batch_normalization(s->layer_norm);
+        s->layer_norm = share_bn(f->layer_norm);
+    }
+    
+    copy_int_array(f->indices,s->indices,f->input*f->output);
+    copy_int_array(f->active_output_neurons,s->active_output_neurons,f->output);
+    s->training_mode = f->training_mode;
+    s->feed_forward_flag = f->feed_forward_flag;
+    s->k_percentage = f->k_percentage;
+    s->n_best_w = f->n_best_w;
+    return s;
+}
+
+/* This function deallocates a fcl* layer created with share_fcl, the shared arrays are not freed
+ * 
+ * Input:
+ * 
+ *             @ fcl* f:= the shared fully-connected layer
+ * 
+ * */
+void free_shared_fcl(fcl* f){
+    if(f == NULL)
+        return;
+    
+    f->weights = NULL;
+    f->ex_d_weights_diff_grad = NULL;
+    f->d1_weights = NULL;
+    f->d2_weights = NULL;
+    f->d3_weights = NULL;
+    f->biases = NULL;
+    f->ex_d_biases_diff_grad = NULL;
+    f->d1_biases = NULL;
+    f->d2_biases = NULL;
+    f->d3_biases = NULL;
+    f->scores = NULL;
+    f->ex_d_scores_diff_grad = NULL;
+    f->d1_scores = NULL;
+    f->d2_scores = NULL;
+    f->d3_scores = NULL;
+    
+    if(f->normalization_flag == LAYER_NORMALIZATION){
+        free_shared_bn(f->layer_norm);
+        f->layer_norm = NULL;
+    }
+    free_fully_connected(f);
+}
@@ -33,12 +33,14 @@ fcl* load_fcl(FILE* fr);
 fcl* copy_fcl(fcl* f);
 void paste_fcl(fcl* f, fcl* copy);
 fcl* reset_fcl(fcl* f);
+fcl* reset_fcl_except_partial_derivatives(fcl* f);
 unsigned long long int size_of_fcls(fcl* f);
 void slow_paste_fcl(fcl* f,fcl* copy, float tau);
 int get_array_size_params(fcl* f);
 void memcopy_params_to_vector(fcl* f, float* vector);
 void memcopy_vector_to_params(fcl* f, float* vector);
 void memcopy_derivative_params_to_vector(fcl* f, float* vector);
+int get_partial_derivatives_segments(fcl* f, float** segments, int* sizes);
 void memcopy_vector_to_derivative_params(fcl* f, float* vector);
 void set_fully_connected_biases_to_zero(fcl* f);
 void set_fully_connected_unused_weights_to_zero(fcl* f);
@@ -52,5 +54,7 @@ void dividing_score_fcl(fcl* f, float value);
 void set_fcl_only_dropout(fcl* f);
 void reset_score_fcl(fcl* f);
 void reinitialize_scores_fcl(fcl* f, float percentage, float goodness);
+fcl* share_fcl(fcl* f);
+void free_shared_fcl(fcl* f);
 
 #endif
@@ -24,6 +24,11 @@ SOFTWARE.
 
 #include "llab.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define GD_X86
+#endif
+
 /* This function update a parameter p using the nesterov momentum
  * 
  * Input:
@@ -136,3 +141,323 @@ void adamod(float* p,float* delta1, float* delta2, float dp, float lr, float b1,
         n = (*delta3);
     (*p) -= n*m;
 }
+
+
+/* The span kernels below update a whole array of params in a single pass: the gradient clipping (clip) and the
+ * l2 regularization (l2) are applied to each partial derivative in the same pass, the partial derivatives are not written back.
+ * The vectorized kernels do the same operations of the scalar algorithms above in the same order, without fused multiply add,
+ * so they give the same bits. The instruction set is the one chosen for the sgemm kernels (see get_sgemm_instruction_set)
+ * 
+ * Common Input:
+ *                @ float* p:= the params that must be updated, dimensions: n
+ *                @ float* d:= the sum of the partial derivatives of p over the whole mini batch, dimensions: n
+ *                @ int n:= the number of params
+ *                @ float clip:= the factor of the gradient clipping, 1 if there is no clipping
+ *                @ float l2:= lambda/total_number_weights of the l2 regularization, 0 if there is no regularization
+ * */
+
+/* This function returns the partial derivative dp after the gradient clipping and the l2 regularization
+ * 
+ * Input:
+ *                @ float dp:= the partial derivative
+ *                @ float p:= the param
+ *                @ float clip:= the factor of the gradient clipping
+ *                @ float l2:= lambda/total_number_weights
+ * */
+float clipped_l2_gradient(float dp, float p, float clip, float l2){
+    if(clip != 1)
+        dp*=clip;
+    if(l2 != 0)
+        dp += l2*p;
+    return dp;
+}
+
+void nesterov_momentum_span_scalar(float* p, float* d, float* delta, int n, float lr, float m, int mini_batch_size, float clip, float l2){
+    int i;
+    for(i = 0; i < n; i++){
+        nesterov_momentum(&p[i],lr,m,mini_batch_size,clipped_l2_gradient(d[i],p[i],clip,l2),&delta[i]);
+    }
+}
+
+void adam_algorithm_span_scalar(float* p, float* d, float* delta1, float* delta2, int n, float lr, float b1, float b2, float bb1, float bb2, float epsilon, int mini_batch_size, float clip, float l2){
+    int i;
+    for(i = 0; i < n; i++){
+        adam_algorithm(&p[i],&delta1[i],&delta2[i],clipped_l2_gradient(d[i],p[i],clip,l2),lr,b1,b2,bb1,bb2,epsilon,mini_batch_size);
+    }
+}
+
+void radam_algorithm_span_scalar(float* p, float* d, float* delta1, float* delta2, int n, float lr, float b1, float b2, float bb1, float bb2, float epsilon, int mini_batch_size, unsigned long long int t, float clip, float l2){
+    int i;
+    for(i = 0; i < n; i++){
+        radam_algorithm(&p[i],&delta1[i],&delta2[i],clipped_l2_gradient(d[i],p[i],clip,l2),lr,b1,b2,bb1,bb2,epsilon,mini_batch_size,t);
+    }
+}
+
+void adamod_span_scalar(float* p, float* d, float* delta1, float* delta2, float* delta3, int n, float lr, float b1, float b2, float bb1, float bb2, float epsilon, int mini_batch_size, float b3, float clip, float l2){
+    int i;
+    for(i = 0; i < n; i++){
+        adamod(&p[i],&delta1[i],&delta2[i],clipped_l2_gradient(d[i],p[i],clip,l2),lr,b1,b2,bb1,bb2,epsilon,mini_batch_size,b3,&delta3[i]);
+    }
+}
+
+float sum_of_squares_span_scalar(float* d, int n){
+    int i;
+    float sum = 0;
+    for(i = 0; i < n; i++){
+        sum += d[i]*d[i];
+    }
+    return sum;
+}
+
+#ifdef GD_X86
+
+__attribute__((target("avx")))
+__m256 clipped_l2_gradient_avx(__m256 dp, __m256 p, float clip, float l2){
+    if(clip != 1)
+        dp = _mm256_mul_ps(dp,_mm256_set1_ps(clip));
+    if(l2 != 0)
+        dp = _mm256_add_ps(dp,_mm256_mul_ps(_mm256_set1_ps(l2),p));
+    return dp;
+}
+
+__attribute__((target("avx")))
+void nesterov_momentum_span_avx(float* p, float* d, float* delta, int n, float lr, float m, int mini_batch_size, float clip, float l2){
+    int i;
+    __m256 vm = _mm256_set1_ps(m), vlr = _mm256_set1_ps(lr), vmm = _mm256_set1_ps(m*m), vmlr = _mm256_set1_ps((1+m)*lr), vbatch = _mm256_set1_ps((float)mini_batch_size);
+    for(i = 0; i+8 <= n; i+=8){
+        __m256 vp = _mm256_loadu_ps(&p[i]);
+        __m256 temp = _mm256_loadu_ps(&delta[i]);
+        __m256 dp = _mm256_div_ps(clipped_l2_gradient_avx(_mm256_loadu_ps(&d[i]),vp,clip,l2),vbatch);
+        _mm256_storeu_ps(&delta[i],_mm256_sub_ps(_mm256_mul_ps(vm,temp),_mm256_mul_ps(vlr,dp)));
+        _mm256_storeu_ps(&p[i],_mm256_add_ps(vp,_mm256_sub_ps(_mm256_mul_ps(vmm,temp),_mm256_mul_ps(vmlr,dp))));
+    }
+    nesterov_momentum_span_scalar(&p[i],&d[i],&delta[i],n-i,lr,m,mini_batch_size,clip,l2);
+}
+
+__attribute__((target("avx")))
+void adam_algorithm_span_avx(float* p, float* d, float* delta1, float* delta2, int n, float lr, float b1, float b2, float bb1, float bb2, float epsilon, int mini_batch_size, float clip, float l2){
+    int i;
+    __m256 vb1 = _mm256_set1_ps(b1), vb2 = _mm256_set1_ps(b2), vc1 = _mm256_set1_ps(1-b1), vc2 = _mm256_set1_ps(1-b2);
+    __m256 vbb1 = _mm256_set1_ps(1-bb1), vbb2 = _mm256_set1_ps(1-bb2), vlr = _mm256_set1_ps(lr), veps = _mm256_set1_ps(epsilon), vbatch = _mm256_set1_ps((float)mini_batch_size);
+    for(i = 0; i+8 <= n; i+=8){
+        __m256 vp = _mm256_loadu_ps(&p[i]);
+        __m256 temp = _mm256_div_ps(clipped_l2_gradient_avx(_mm256_loadu_ps(&d[i]),vp,clip,l2),vbatch);
+        __m256 m1 = _mm256_add_ps(_mm256_mul_ps(vb1,_mm256_loadu_ps(&delta1[i])),_mm256_mul_ps(vc1,temp));
+        __m256 m2 = _mm256_add_ps(_mm256_mul_ps(vb2,_mm256_loadu_ps(&delta2[i])),_mm256_mul_ps(vc2,_mm256_mul_ps(temp,temp)));
+        _mm256_storeu_ps(&delta1[i],m1);
+        _mm256_storeu_ps(&delta2[i],m2);
+        __m256 num = _mm256_div_ps(_mm256_mul_ps(vlr,m1),vbb1);
+        __m256 den = _mm256_add_ps(_mm256_sqrt_ps(_mm256_div_ps(m2,vbb2)),veps);
+        _mm256_storeu_ps(&p[i],_mm256_sub_ps(vp,_mm256_div_ps(num,den)));
+    }
+    adam_algorithm_span_scalar(&p[i],&d[i],&delta1[i],&delta2[i],n-i,lr,b1,b2,bb1,bb2,epsilon,mini_batch_size,clip,l2);
+}
+
+__attribute__((target("avx")))
+void radam_algorithm_span_avx(float* p, float* d, float* delta1, float* delta2, int n, float lr, float b1, float b2, float bb1, float bb2, float epsilon, int mini_batch_size, unsigned long long int t, float clip, float l2){
+    int i;
+    float p_inf = 2/(1-b2)-1;
+    long double p_t = p_inf-(long double)2*t*bb2/(1-bb2);
+    float r_t = 0;
+    if(p_t > RADAM_THRESHOLD)
+        r_t = sqrtf(((p_t-4)*(p_t-2)*p_inf)/((p_inf-4)*(p_inf-2)*p_t));
+    __m256 vb1 = _mm256_set1_ps(b1), vb2 = _mm256_set1_ps(b2), vc1 = _mm256_set1_ps(1-b1), vc2 = _mm256_set1_ps(1-b2);
+    __m256 vbb1 = _mm256_set1_ps(1-bb1), vbb2 = _mm256_set1_ps(1-bb2), vlr = _mm256_set1_ps(lr), vlr_rt = _mm256_set1_ps(lr*r_t), vbatch = _mm256_set1_ps((float)mini_batch_size);
+    for(i = 0; i+8 <= n; i+=8){
+        __m256 vp = _mm256_loadu_ps(&p[i]);
+        __m256 temp = _mm256_div_ps(clipped_l2_gradient_avx(_mm256_loadu_ps(&d[i]),vp,clip,l2),vbatch);
+        __m256 m1 = _mm256_add_ps(_mm256_mul_ps(vb1,_mm256_loadu_ps(&delta1[i])),_mm256_mul_ps(vc1,temp));
+        __m256 m2 = _mm256_add_ps(_mm256_mul_ps(vb2,_mm256_loadu_ps(&delta2[i])),_mm256_mul_ps(vc2,_mm256_mul_ps(temp,temp)));
+        _mm256_storeu_ps(&delta1[i],m1);
+        _mm256_storeu_ps(&delta2[i],m2);
+        __m256 m_t_hat = _mm256_div_ps(m1,vbb1);
+        if(p_t > RADAM_THRESHOLD)
+            vp = _mm256_sub_ps(vp,_mm256_div_ps(_mm256_mul_ps(vlr_rt,m_t_hat),_mm256_sqrt_ps(_mm256_div_ps(m2,vbb2))));
+        else
+            vp = _mm256_sub_ps(vp,_mm256_mul_ps(vlr,m_t_hat));
+        _mm256_storeu_ps(&p[i],vp);
+    }
+    radam_algorithm_span_scalar(&p[i],&d[i],&delta1[i],&delta2[i],n-i,lr,b1,b2,bb1,bb2,epsilon,mini_batch_size,t,clip,l2);
+}
+
+__attribute__((target("avx")))
+void adamod_span_avx(float* p, float* d, float* delta1, float* delta2, float* delta3, int n, float lr, float b1, float b2, float bb1, float bb2, float epsilon, int mini_batch_size, float b3, float clip, float l2){
+    int i;
+    __m256 vb1 = _mm256_set1_ps(b1), vb2 = _mm256_set1_ps(b2), vb3 = _mm256_set1_ps(b3), vc1 = _mm256_set1_ps(1-b1), vc2 = _mm256_set1_ps(1-b2), vc3 = _mm256_set1_ps(1-b3);
+    __m256 vbb1 = _mm256_set1_ps(1-bb1), vbb2 = _mm256_set1_ps(1-bb2), vlr = _mm256_set1_ps(lr), veps = _mm256_set1_ps(epsilon), vbatch = _mm256_set1_ps((float)mini_batch_size);
+    for(i = 0; i+8 <= n; i+=8){
+        __m256 vp = _mm256_loadu_ps(&p[i]);
+        __m256 temp = _mm256_div_ps(clipped_l2_gradient_avx(_mm256_loadu_ps(&d[i]),vp,clip,l2),vbatch);
+        __m256 m1 = _mm256_add_ps(_mm256_mul_ps(vb1,_mm256_loadu_ps(&delta1[i])),_mm256_mul_ps(vc1,temp));
+        __m256 m2 = _mm256_add_ps(_mm256_mul_ps(vb2,_mm256_loadu_ps(&delta2[i])),_mm256_mul_ps(vc2,_mm256_mul_ps(temp,temp)));
+        _mm256_storeu_ps(&delta1[i],m1);
+        _mm256_storeu_ps(&delta2[i],m2);
+        __m256 m = _mm256_div_ps(m1,vbb1);
+        __m256 v = _mm256_div_ps(m2,vbb2);
+        __m256 lr_v = _mm256_div_ps(vlr,_mm256_add_ps(_mm256_sqrt_ps(v),veps));
+        __m256 m3 = _mm256_add_ps(_mm256_mul_ps(vb3,_mm256_loadu_ps(&delta3[i])),_mm256_mul_ps(vc3,lr_v));
+        _mm256_storeu_ps(&delta3[i],m3);
+        // n = min(delta3,n) as in adamod
+        lr_v = _mm256_min_ps(m3,lr_v);
+        _mm256_storeu_ps(&p[i],_mm256_sub_ps(vp,_mm256_mul_ps(lr_v,m)));
+    }
+    adamod_span_scalar(&p[i],&d[i],&delta1[i],&delta2[i],&delta3[i],n-i,lr,b1,b2,bb1,bb2,epsilon,mini_batch_size,b3,clip,l2);
+}
+
+__attribute__((target("avx")))
+float sum_of_squares_span_avx(float* d, int n){
+    int i;
+    float lanes[8];
+    float sum = 0;
+    __m256 acc = _mm256_setzero_ps();
+    for(i = 0; i+8 <= n; i+=8){
+        __m256 v = _mm256_loadu_ps(&d[i]);
+        acc = _mm256_add_ps(acc,_mm256_mul_ps(v,v));
+    }
+    sum = sum_of_squares_span_scalar(&d[i],n-i);
+    _mm256_storeu_ps(lanes,acc);
+    for(i = 0; i < 8; i++){
+        sum += lanes[i];
+    }
+    return sum;
+}
+
+#endif
+
+/* This function returns 1 if the span kernels can use avx, 0 otherwise*/
+int gd_span_avx(){
+    #ifdef GD_X86
+    return get_sgemm_instruction_set() >= SGEMM_AVX2;
+    #else
+    return 0;
+    #endif
+}
+
+/* This function updates n params with the nesterov momentum in a single pass
+ * 
+ * Input:
+ *                @ float* delta:= the delta parameters of momentum, dimensions: n
+ *                @ float lr:= the learning rate
+ *                @ float m:= the momentum
+ *                @ int mini_batch_size:= the size of the mini batch
+ * */
+void nesterov_momentum_span(float* p, float* d, float* delta, int n, float lr, float m, int mini_batch_size, float clip, float l2){
+    #ifdef GD_X86
+    if(gd_span_avx()){
+        nesterov_momentum_span_avx(p,d,delta,n,lr,m,mini_batch_size,clip,l2);
+        return;
+    }
+    #endif
+    nesterov_momentum_span_scalar(p,d,delta,n,lr,m,mini_batch_size,clip,l2);
+}
+
+/* This function updates n params with the adam optimization algorithm in a single pass,
+ * see adam_algorithm for the other inputs
+ * 
+ * Input:
+ *                @ float* delta1:= the parameters m of the adam algorithm, dimensions: n
+ *                @ float* delta2:= the parameters v of the adam algorithm, dimensions: n
+ * */
+void adam_algorithm_span(float* p, float* d, float* delta1, float* delta2, int n, float lr, float b1, float b2, float bb1, float bb2, float epsilon, int mini_batch_size, float clip, float l2){
+    #ifdef GD_X86
+    if(gd_span_avx()){
+        adam_algorithm_span_avx(p,d,delta1,delta2,n,lr,b1,b2,bb1,bb2,epsilon,mini_batch_size,clip,l2);
+        return;
+    }
+    #endif
+    adam_algorithm_span_scalar(p,d,delta1,delta2,n,lr,b1,b2,bb1,bb2,epsilon,mini_batch_size,clip,l2);
+}
+
+/* This function updates n params with the radam optimization algorithm in a single pass,
+ * the rectification term depends only on t and it is computed once, see radam_algorithm for the other inputs
+ * 
+ * Input:
+ *                @ float* delta1:= the parameters m of the adam algorithm, dimensions: n
+ *                @ float* delta2:= the parameters v of the adam algorithm, dimensions: n
+ * */
+void radam_algorithm_span(float* p, float* d, float* delta1, float* delta2, int n, float lr, float b1, float b2, float bb1, float bb2, float epsilon, int mini_batch_size, unsigned long long int t, float clip, float l2){
+    #ifdef GD_X86
+    if(gd_span_avx()){
+        radam_algorithm_span_avx(p,d,delta1,delta2,n,lr,b1,b2,bb1,bb2,epsilon,mini_batch_size,t,clip,l2);
+        return;
+    }
+    #endif
+    radam_algorithm_span_scalar(p,d,delta1,delta2,n,lr,b1,b2,bb1,bb2,epsilon,mini_batch_size,t,clip,l2);
+}
+
+/* This function updates n params with the adam diff grad optimization algorithm in a single pass,
+ * the friction needs an exponential for each param so this kernel is not vectorized, see adam_diff_grad_algorithm for the other inputs
+ * 
+ * Input:
+ *                @ float* delta1:= the parameters m of the adam algorithm, dimensions: n
+ *                @ float* delta2:= the parameters v of the adam algorithm, dimensions: n
+ *                @ float* ex_d:= the last partial derivatives, dimensions: n
+ * */
+void adam_diff_grad_algorithm_span(float* p, float* d, float* delta1, float* delta2, float* ex_d, int n, float lr, float b1, float b2, float bb1, float bb2, float epsilon, int mini_batch_size, float clip, float l2){
+    int i;
+    for(i = 0; i < n; i++){
+        adam_diff_grad_algorithm(&p[i],&delta1[i],&delta2[i],clipped_l2_gradient(d[i],p[i],clip,l2),lr,b1,b2,bb1,bb2,epsilon,mini_batch_size,&ex_d[i]);
+    }
+}
+
+/* This function updates n params with the adamod optimization algorithm in a single pass,
+ * see adamod for the other inputs
+ * 
+ * Input:
+ *                @ float* delta1:= the parameters m of the adam algorithm, dimensions: n
+ *                @ float* delta2:= the parameters v of the adam algorithm, dimensions: n
+ *                @ float* delta3:= the exponential average of the learning rates, dimensions: n
+ * */
+void adamod_span(float* p, float* d, float* delta1, float* delta2, float* delta3, int n, float lr, float b1, float b2, float bb1, float bb2, float epsilon, int mini_batch_size, float b3, float clip, float l2){
+    #ifdef GD_X86
+    if(gd_span_avx()){
+        adamod_span_avx(p,d,delta1,delta2,delta3,n,lr,b1,b2,bb1,bb2,epsilon,mini_batch_size,b3,clip,l2);
+        return;
+    }
+    #endif
+    adamod_span_scalar(p,d,delta1,delta2,delta3,n,lr,b1,b2,bb1,bb2,epsilon,mini_batch_size,b3,clip,l2);
+}
+
+/* This function returns the sum of the squares of n partial derivatives, used by the gradient clipping
+ * 
+ * Input:
+ *                @ float* d:= the partial derivatives, dimensions: n
+ *                @ int n:= the number of partial derivatives
+ * */
+float sum_of_squares_span(float* d, int n){
+    #ifdef GD_X86
+    if(gd_span_avx())
+        return sum_of_squares_span_avx(d,n);
+    #endif
+    return sum_of_squares_span_scalar(d,n);
+}
+
+/* This function updates a span of a params_arena with the optimizer of the step,
+ * the clipping and the l2 regularization are applied only if the flags of the span ask for them
+ * 
+ * Input:
+ *                @ params_arena* a:= the arena
+ *                @ optimizer_step* s:= the hyperparameters of the step
+ *                @ optimizer_span* span:= the span of the arena
+ * */
+void update_params_span(params_arena* a, optimizer_step* s, optimizer_span* span){
+    int o = span->offset, n = span->size;
+    float clip = (span->flags & OPTIMIZER_SPAN_NORM) ? s->clip : 1;
+    float l2 = (span->flags & OPTIMIZER_SPAN_L2) ? s->l2 : 0;
+    float* p = &a->slots[ARENA_PARAMS][o];
+    float* d = &a->slots[ARENA_DERIVATIVES][o];
+    float* d1 = &a->slots[ARENA_D1][o];
+    float* d2 = &a->slots[ARENA_D2][o];
+    float* d3 = &a->slots[ARENA_D3][o];
+    float* ex = &a->slots[ARENA_EX_D_DIFF_GRAD][o];
+    if(s->gradient_descent_flag == NESTEROV)
+        nesterov_momentum_span(p,d,d1,n,s->lr,s->momentum,s->mini_batch_size,clip,l2);
+    else if(s->gradient_descent_flag == ADAM)
+        adam_algorithm_span(p,d,d1,d2,n,s->lr,s->beta1,s->beta2,s->b1,s->b2,EPSILON_ADAM,s->mini_batch_size,clip,l2);
+    else if(s->gradient_descent_flag == RADAM)
+        radam_algorithm_span(p,d,d1,d2,n,s->lr,s->beta1,s->beta2,s->b1,s->b2,EPSILON_ADAM,s->mini_batch_size,s->t,clip,l2);
+    else if(s->gradient_descent_flag == DIFF_GRAD)
+        adam_diff_grad_algorithm_span(p,d,d1,d2,ex,n,s->lr,s->beta1,s->beta2,s->b1,s->b2,EPSILON_ADAM,s->mini_batch_size,clip,l2);
+    else if(s->gradient_descent_flag == ADAMOD)
+        adamod_span(p,d,d1,d2,d3,n,s->lr,s->beta1,s->beta2,s->b1,s->b2,EPSILON_ADAM,s->mini_batch_size,s->beta3,clip,l2);
+}
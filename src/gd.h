@@ -30,5 +30,19 @@ void adam_algorithm(float* p,float* delta1, float* delta2, float dp, float lr, f
 void radam_algorithm(float* p,float* delta1, float* delta2, float dp, float lr, float b1, float b2, float bb1, float bb2, float epsilon, int mini_batch_size, unsigned long long int t);
 void adam_diff_grad_algorithm(float* p,float* delta1, float* delta2, float dp, float lr, float b1, float b2, float bb1, float bb2, float epsilon, int mini_batch_size, float* ex_d);
 void adamod(float* p,float* delta1, float* delta2, float dp, float lr, float b1, float b2, float bb1, float bb2, float epsilon, int mini_batch_size, float b3, float* delta3);
+float clipped_l2_gradient(float dp, float p, float clip, float l2);
+void nesterov_momentum_span_scalar(float* p, float* d, float* delta, int n, float lr, float m, int mini_batch_size, float clip, float l2);
+void adam_algorithm_span_scalar(float* p, float* d, float* delta1, float* delta2, int n, float lr, float b1, float b2, float bb1, float bb2, float epsilon, int mini_batch_size, float clip, float l2);
+void radam_algorithm_span_scalar(float* p, float* d, float* delta1, float* delta2, int n, float lr, float b1, float b2, float bb1, float bb2, float epsilon, int mini_batch_size, unsigned long long int t, float clip, float l2);
+void adamod_span_scalar(float* p, float* d, float* delta1, float* delta2, float* delta3, int n, float lr, float b1, float b2, float bb1, float bb2, float epsilon, int mini_batch_size, float b3, float clip, float l2);
+float sum_of_squares_span_scalar(float* d, int n);
+int gd_span_avx();
+void nesterov_momentum_span(float* p, float* d, float* delta, int n, float lr, float m, int mini_batch_size, float clip, float l2);
+void adam_algorithm_span(float* p, float* d, float* delta1, float* delta2, int n, float lr, float b1, float b2, float bb1, float bb2, float epsilon, int mini_batch_size, float clip, float l2);
+void radam_algorithm_span(float* p, float* d, float* delta1, float* delta2, int n, float lr, float b1, float b2, float bb1, float bb2, float epsilon, int mini_batch_size, unsigned long long int t, float clip, float l2);
+void adam_diff_grad_algorithm_span(float* p, float* d, float* delta1, float* delta2, float* ex_d, int n, float lr, float b1, float b2, float bb1, float bb2, float epsilon, int mini_batch_size, float clip, float l2);
+void adamod_span(float* p, float* d, float* delta1, float* delta2, float* delta3, int n, float lr, float b1, float b2, float bb1, float bb2, float epsilon, int mini_batch_size, float b3, float clip, float l2);
+float sum_of_squares_span(float* d, int n);
+void update_params_span(params_arena* a, optimizer_step* s, optimizer_span* span);
 
 #endif
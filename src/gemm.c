@@ -0,0 +1,779 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "llab.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SGEMM_X86
+#endif
+
+/* The sgemm kernels of this file compute C += op(A)*op(B) on row major matrices. There are two kind of kernels:
+ * 
+ * - the dot kernels (sgemm_nt) compute a tile of 2*4 dot products, the products are vectorized along k
+ *   and the lanes are reduced at the end, this is the form used by the feed forward of the fully connected layers
+ * - the update kernels (sgemm_nn, sgemm_tn) load a tile of 4 rows of C and update it with a broadcast
+ *   of A times a row of B for each k, this is the form used by the errors and the partial derivatives.
+ *   The rows left when m is not a multiple of 4 (the only row of sgemv_t and sger) are updated by the row kernels,
+ *   that keep 4 vectors of the same row instead of 4 rows, so no product is computed for nothing
+ * 
+ * Each element of C is computed always with the same sequence of operations whatever tile it belongs to
+ * and whatever m is, so the same instance gives the same result computed alone (m = 1) or inside a batch.
+ * sgemm_tn never fuses the multiplications with the additions: the k products are rounded and summed one at a time,
+ * so summing the partial derivatives of a batch with sgemm_tn gives the same bits of summing the partial derivatives
+ * of each instance computed with k = 1
+ * */
+
+int sgemm_instruction_set = SGEMM_AUTO;
+// the detected instruction set (SGEMM_AUTO until the first call) and the one used by the kernels, they are computed once
+// because get_sgemm_instruction_set is called by each sgemm and each lstm cell
+int sgemm_detected_instruction_set = SGEMM_AUTO;
+int sgemm_used_instruction_set = SGEMM_AUTO;
+
+
+/* This function returns the best instruction set supported by the cpu for the sgemm kernels
+ * 
+ * Output:
+ *         @ int:= SGEMM_AVX512, SGEMM_AVX2, SGEMM_SSE2 or SGEMM_SCALAR
+ * */
+int sgemm_detect_instruction_set(){
+    #ifdef SGEMM_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f"))
+        return SGEMM_AVX512;
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return SGEMM_AVX2;
+    if(__builtin_cpu_supports("sse2"))
+        return SGEMM_SSE2;
+    #endif
+    return SGEMM_SCALAR;
+}
+
+/* This function forces the instruction set used by the sgemm kernels. If the cpu does not support it
+ * the best supported instruction set is used
+ * 
+ * Input:
+ *         @ int instruction_set:= SGEMM_AUTO, SGEMM_SCALAR, SGEMM_SSE2, SGEMM_AVX2 or SGEMM_AVX512
+ * */
+void set_sgemm_instruction_set(int instruction_set){
+    if(instruction_set < SGEMM_AUTO || instruction_set > SGEMM_AVX512){
+        fprintf(stderr,"Error: unknown instruction set for the sgemm kernels\n");
+        exit(1);
+    }
+    if(sgemm_detected_instruction_set == SGEMM_AUTO)
+        sgemm_detected_instruction_set = sgemm_detect_instruction_set();
+    sgemm_instruction_set = instruction_set;
+    if(sgemm_instruction_set == SGEMM_AUTO || sgemm_instruction_set > sgemm_detected_instruction_set)
+        sgemm_used_instruction_set = sgemm_detected_instruction_set;
+    else
+        sgemm_used_instruction_set = sgemm_instruction_set;
+}
+
+/* This function returns the instruction set used by the sgemm kernels
+ * 
+ * Output:
+ *         @ int:= SGEMM_AVX512, SGEMM_AVX2, SGEMM_SSE2 or SGEMM_SCALAR
+ * */
+int get_sgemm_instruction_set(){
+    if(sgemm_used_instruction_set == SGEMM_AUTO)
+        set_sgemm_instruction_set(sgemm_instruction_set);
+    return sgemm_used_instruction_set;
+}
+
+/* scalar kernels*/
+
+void sgemm_nt_kernel_scalar(int k, float** a, float** b, float* c){
+    int r,q,p;
+    float sum;
+    for(r = 0; r < 2; r++){
+        for(q = 0; q < 4; q++){
+            sum = 0;
+            for(p = 0; p < k; p++){
+                sum += a[r][p]*b[q][p];
+            }
+            c[r*4+q] = sum;
+        }
+    }
+}
+
+void sgemm_update_kernel_scalar(int k, float** a, int a_stride, float* b, int ldb, float** c, int nc){
+    int r,q,p;
+    for(r = 0; r < 4; r++){
+        for(p = 0; p < k; p++){
+            for(q = 0; q < nc; q++){
+                c[r][q] += a[r][p*a_stride]*b[p*ldb+q];
+            }
+        }
+    }
+}
+
+void sgemm_update_row_kernel_scalar(int k, float* a, int a_stride, float* b, int ldb, float* c, int nc){
+    int q,p;
+    for(p = 0; p < k; p++){
+        for(q = 0; q < nc; q++){
+            c[q] += a[p*a_stride]*b[p*ldb+q];
+        }
+    }
+}
+
+#ifdef SGEMM_X86
+
+/* sse2 kernels, sse2 has not fused multiply add, so the same kernel is used by sgemm_nn and sgemm_tn*/
+
+__attribute__((target("sse2")))
+float sgemm_hsum_sse2(__m128 v){
+    v = _mm_add_ps(v,_mm_movehl_ps(v,v));
+    v = _mm_add_ss(v,_mm_shuffle_ps(v,v,1));
+    return _mm_cvtss_f32(v);
+}
+
+__attribute__((target("sse2")))
+void sgemm_nt_kernel_sse2(int k, float** a, float** b, float* c){
+    int p,r,q;
+    __m128 c00 = _mm_setzero_ps(), c01 = _mm_setzero_ps(), c02 = _mm_setzero_ps(), c03 = _mm_setzero_ps();
+    __m128 c10 = _mm_setzero_ps(), c11 = _mm_setzero_ps(), c12 = _mm_setzero_ps(), c13 = _mm_setzero_ps();
+    __m128 x0,x1,y;
+    for(p = 0; p+4 <= k; p+=4){
+        x0 = _mm_loadu_ps(a[0]+p);
+        x1 = _mm_loadu_ps(a[1]+p);
+        y = _mm_loadu_ps(b[0]+p);
+        c00 = _mm_add_ps(c00,_mm_mul_ps(x0,y));
+        c10 = _mm_add_ps(c10,_mm_mul_ps(x1,y));
+        y = _mm_loadu_ps(b[1]+p);
+        c01 = _mm_add_ps(c01,_mm_mul_ps(x0,y));
+        c11 = _mm_add_ps(c11,_mm_mul_ps(x1,y));
+        y = _mm_loadu_ps(b[2]+p);
+        c02 = _mm_add_ps(c02,_mm_mul_ps(x0,y));
+        c12 = _mm_add_ps(c12,_mm_mul_ps(x1,y));
+        y = _mm_loadu_ps(b[3]+p);
+        c03 = _mm_add_ps(c03,_mm_mul_ps(x0,y));
+        c13 = _mm_add_ps(c13,_mm_mul_ps(x1,y));
+    }
+    c[0] = sgemm_hsum_sse2(c00);
+    c[1] = sgemm_hsum_sse2(c01);
+    c[2] = sgemm_hsum_sse2(c02);
+    c[3] = sgemm_hsum_sse2(c03);
+    c[4] = sgemm_hsum_sse2(c10);
+    c[5] = sgemm_hsum_sse2(c11);
+    c[6] = sgemm_hsum_sse2(c12);
+    c[7] = sgemm_hsum_sse2(c13);
+    for(; p < k; p++){
+        for(r = 0; r < 2; r++){
+            for(q = 0; q < 4; q++){
+                c[r*4+q] += a[r][p]*b[q][p];
+            }
+        }
+    }
+}
+
+__attribute__((target("sse2")))
+void sgemm_update_kernel_sse2(int k, float** a, int a_stride, float* b, int ldb, float** c, int nc){
+    int p;
+    if(nc < 8){
+        sgemm_update_kernel_scalar(k,a,a_stride,b,ldb,c,nc);
+        return;
+    }
+    __m128 c00 = _mm_loadu_ps(c[0]), c01 = _mm_loadu_ps(c[0]+4);
+    __m128 c10 = _mm_loadu_ps(c[1]), c11 = _mm_loadu_ps(c[1]+4);
+    __m128 c20 = _mm_loadu_ps(c[2]), c21 = _mm_loadu_ps(c[2]+4);
+    __m128 c30 = _mm_loadu_ps(c[3]), c31 = _mm_loadu_ps(c[3]+4);
+    __m128 x,y0,y1;
+    for(p = 0; p < k; p++){
+        y0 = _mm_loadu_ps(b+p*ldb);
+        y1 = _mm_loadu_ps(b+p*ldb+4);
+        x = _mm_set1_ps(a[0][p*a_stride]);
+        c00 = _mm_add_ps(c00,_mm_mul_ps(x,y0));
+        c01 = _mm_add_ps(c01,_mm_mul_ps(x,y1));
+        x = _mm_set1_ps(a[1][p*a_stride]);
+        c10 = _mm_add_ps(c10,_mm_mul_ps(x,y0));
+        c11 = _mm_add_ps(c11,_mm_mul_ps(x,y1));
+        x = _mm_set1_ps(a[2][p*a_stride]);
+        c20 = _mm_add_ps(c20,_mm_mul_ps(x,y0));
+        c21 = _mm_add_ps(c21,_mm_mul_ps(x,y1));
+        x = _mm_set1_ps(a[3][p*a_stride]);
+        c30 = _mm_add_ps(c30,_mm_mul_ps(x,y0));
+        c31 = _mm_add_ps(c31,_mm_mul_ps(x,y1));
+    }
+    _mm_storeu_ps(c[0],c00);
+    _mm_storeu_ps(c[0]+4,c01);
+    _mm_storeu_ps(c[1],c10);
+    _mm_storeu_ps(c[1]+4,c11);
+    _mm_storeu_ps(c[2],c20);
+    _mm_storeu_ps(c[2]+4,c21);
+    _mm_storeu_ps(c[3],c30);
+    _mm_storeu_ps(c[3]+4,c31);
+}
+
+__attribute__((target("sse2")))
+void sgemm_update_row_kernel_sse2(int k, float* a, int a_stride, float* b, int ldb, float* c, int nc){
+    int p;
+    if(nc < 16){
+        sgemm_update_row_kernel_scalar(k,a,a_stride,b,ldb,c,nc);
+        return;
+    }
+    __m128 c0 = _mm_loadu_ps(c), c1 = _mm_loadu_ps(c+4), c2 = _mm_loadu_ps(c+8), c3 = _mm_loadu_ps(c+12);
+    __m128 x;
+    for(p = 0; p < k; p++){
+        x = _mm_set1_ps(a[p*a_stride]);
+        c0 = _mm_add_ps(c0,_mm_mul_ps(x,_mm_loadu_ps(b+p*ldb)));
+        c1 = _mm_add_ps(c1,_mm_mul_ps(x,_mm_loadu_ps(b+p*ldb+4)));
+        c2 = _mm_add_ps(c2,_mm_mul_ps(x,_mm_loadu_ps(b+p*ldb+8)));
+        c3 = _mm_add_ps(c3,_mm_mul_ps(x,_mm_loadu_ps(b+p*ldb+12)));
+    }
+    _mm_storeu_ps(c,c0);
+    _mm_storeu_ps(c+4,c1);
+    _mm_storeu_ps(c+8,c2);
+    _mm_storeu_ps(c+12,c3);
+}
+
+/* avx2 kernels*/
+
+__attribute__((target("avx2")))
+float sgemm_hsum_avx2(__m256 v){
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v),_mm256_extractf128_ps(v,1));
+    s = _mm_add_ps(s,_mm_movehl_ps(s,s));
+    s = _mm_add_ss(s,_mm_shuffle_ps(s,s,1));
+    return _mm_cvtss_f32(s);
+}
+
+__attribute__((target("avx2")))
+__m256i sgemm_mask_avx2(int n){
+    return _mm256_cmpgt_epi32(_mm256_set1_epi32(n),_mm256_setr_epi32(0,1,2,3,4,5,6,7));
+}
+
+__attribute__((target("avx2,fma")))
+void sgemm_nt_kernel_avx2(int k, float** a, float** b, float* c){
+    int p;
+    __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps(), c02 = _mm256_setzero_ps(), c03 = _mm256_setzero_ps();
+    __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps(), c12 = _mm256_setzero_ps(), c13 = _mm256_setzero_ps();
+    __m256 x0,x1,y;
+    __m256i mask;
+    for(p = 0; p+8 <= k; p+=8){
+        x0 = _mm256_loadu_ps(a[0]+p);
+        x1 = _mm256_loadu_ps(a[1]+p);
+        y = _mm256_loadu_ps(b[0]+p);
+        c00 = _mm256_fmadd_ps(x0,y,c00);
+        c10 = _mm256_fmadd_ps(x1,y,c10);
+        y = _mm256_loadu_ps(b[1]+p);
+        c01 = _mm256_fmadd_ps(x0,y,c01);
+        c11 = _mm256_fmadd_ps(x1,y,c11);
+        y = _mm256_loadu_ps(b[2]+p);
+        c02 = _mm256_fmadd_ps(x0,y,c02);
+        c12 = _mm256_fmadd_ps(x1,y,c12);
+        y = _mm256_loadu_ps(b[3]+p);
+        c03 = _mm256_fmadd_ps(x0,y,c03);
+        c13 = _mm256_fmadd_ps(x1,y,c13);
+    }
+    if(p < k){
+        mask = sgemm_mask_avx2(k-p);
+        x0 = _mm256_maskload_ps(a[0]+p,mask);
+        x1 = _mm256_maskload_ps(a[1]+p,mask);
+        y = _mm256_maskload_ps(b[0]+p,mask);
+        c00 = _mm256_fmadd_ps(x0,y,c00);
+        c10 = _mm256_fmadd_ps(x1,y,c10);
+        y = _mm256_maskload_ps(b[1]+p,mask);
+        c01 = _mm256_fmadd_ps(x0,y,c01);
+        c11 = _mm256_fmadd_ps(x1,y,c11);
+        y = _mm256_maskload_ps(b[2]+p,mask);
+        c02 = _mm256_fmadd_ps(x0,y,c02);
+        c12 = _mm256_fmadd_ps(x1,y,c12);
+        y = _mm256_maskload_ps(b[3]+p,mask);
+        c03 = _mm256_fmadd_ps(x0,y,c03);
+        c13 = _mm256_fmadd_ps(x1,y,c13);
+    }
+    c[0] = sgemm_hsum_avx2(c00);
+    c[1] = sgemm_hsum_avx2(c01);
+    c[2] = sgemm_hsum_avx2(c02);
+    c[3] = sgemm_hsum_avx2(c03);
+    c[4] = sgemm_hsum_avx2(c10);
+    c[5] = sgemm_hsum_avx2(c11);
+    c[6] = sgemm_hsum_avx2(c12);
+    c[7] = sgemm_hsum_avx2(c13);
+}
+
+/* fused = 1 for sgemm_nn, the sgemm_tn kernel is compiled without fma, so the compiler can't contract the products*/
+#define SGEMM_UPDATE_KERNEL_AVX2(name,target_flags,madd)\
+__attribute__((target(target_flags)))\
+void name(int k, float** a, int a_stride, float* b, int ldb, float** c, int nc){\
+    int p;\
+    __m256 c00,c01,c10,c11,c20,c21,c30,c31,x,y0,y1;\
+    __m256i mask0,mask1;\
+    if(nc == 16){\
+        c00 = _mm256_loadu_ps(c[0]); c01 = _mm256_loadu_ps(c[0]+8);\
+        c10 = _mm256_loadu_ps(c[1]); c11 = _mm256_loadu_ps(c[1]+8);\
+        c20 = _mm256_loadu_ps(c[2]); c21 = _mm256_loadu_ps(c[2]+8);\
+        c30 = _mm256_loadu_ps(c[3]); c31 = _mm256_loadu_ps(c[3]+8);\
+        for(p = 0; p < k; p++){\
+            y0 = _mm256_loadu_ps(b+p*ldb);\
+            y1 = _mm256_loadu_ps(b+p*ldb+8);\
+            x = _mm256_set1_ps(a[0][p*a_stride]); c00 = madd(x,y0,c00); c01 = madd(x,y1,c01);\
+            x = _mm256_set1_ps(a[1][p*a_stride]); c10 = madd(x,y0,c10); c11 = madd(x,y1,c11);\
+            x = _mm256_set1_ps(a[2][p*a_stride]); c20 = madd(x,y0,c20); c21 = madd(x,y1,c21);\
+            x = _mm256_set1_ps(a[3][p*a_stride]); c30 = madd(x,y0,c30); c31 = madd(x,y1,c31);\
+        }\
+        _mm256_storeu_ps(c[0],c00); _mm256_storeu_ps(c[0]+8,c01);\
+        _mm256_storeu_ps(c[1],c10); _mm256_storeu_ps(c[1]+8,c11);\
+        _mm256_storeu_ps(c[2],c20); _mm256_storeu_ps(c[2]+8,c21);\
+        _mm256_storeu_ps(c[3],c30); _mm256_storeu_ps(c[3]+8,c31);\
+        return;\
+    }\
+    mask0 = sgemm_mask_avx2(nc);\
+    mask1 = sgemm_mask_avx2(nc-8);\
+    c00 = _mm256_maskload_ps(c[0],mask0); c01 = _mm256_maskload_ps(c[0]+8,mask1);\
+    c10 = _mm256_maskload_ps(c[1],mask0); c11 = _mm256_maskload_ps(c[1]+8,mask1);\
+    c20 = _mm256_maskload_ps(c[2],mask0); c21 = _mm256_maskload_ps(c[2]+8,mask1);\
+    c30 = _mm256_maskload_ps(c[3],mask0); c31 = _mm256_maskload_ps(c[3]+8,mask1);\
+    for(p = 0; p < k; p++){\
+        y0 = _mm256_maskload_ps(b+p*ldb,mask0);\
+        y1 = _mm256_maskload_ps(b+p*ldb+8,mask1);\
+        x = _mm256_set1_ps(a[0][p*a_stride]); c00 = madd(x,y0,c00); c01 = madd(x,y1,c01);\
+        x = _mm256_set1_ps(a[1][p*a_stride]); c10 = madd(x,y0,c10); c11 = madd(x,y1,c11);\
+        x = _mm256_set1_ps(a[2][p*a_stride]); c20 = madd(x,y0,c20); c21 = madd(x,y1,c21);\
+        x = _mm256_set1_ps(a[3][p*a_stride]); c30 = madd(x,y0,c30); c31 = madd(x,y1,c31);\
+    }\
+    _mm256_maskstore_ps(c[0],mask0,c00); _mm256_maskstore_ps(c[0]+8,mask1,c01);\
+    _mm256_maskstore_ps(c[1],mask0,c10); _mm256_maskstore_ps(c[1]+8,mask1,c11);\
+    _mm256_maskstore_ps(c[2],mask0,c20); _mm256_maskstore_ps(c[2]+8,mask1,c21);\
+    _mm256_maskstore_ps(c[3],mask0,c30); _mm256_maskstore_ps(c[3]+8,mask1,c31);\
+}
+
+/* the row kernels update 32 columns of a single row of C*/
+#define SGEMM_UPDATE_ROW_KERNEL_AVX2(name,target_flags,madd)\
+__attribute__((target(target_flags)))\
+void name(int k, float* a, int a_stride, float* b, int ldb, float* c, int nc){\
+    int p;\
+    __m256 c0,c1,c2,c3,x;\
+    __m256i mask0 = sgemm_mask_avx2(nc), mask1 = sgemm_mask_avx2(nc-8), mask2 = sgemm_mask_avx2(nc-16), mask3 = sgemm_mask_avx2(nc-24);\
+    c0 = _mm256_maskload_ps(c,mask0); c1 = _mm256_maskload_ps(c+8,mask1);\
+    c2 = _mm256_maskload_ps(c+16,mask2); c3 = _mm256_maskload_ps(c+24,mask3);\
+    for(p = 0; p < k; p++){\
+        x = _mm256_set1_ps(a[p*a_stride]);\
+        c0 = madd(x,_mm256_maskload_ps(b+p*ldb,mask0),c0);\
+        c1 = madd(x,_mm256_maskload_ps(b+p*ldb+8,mask1),c1);\
+        c2 = madd(x,_mm256_maskload_ps(b+p*ldb+16,mask2),c2);\
+        c3 = madd(x,_mm256_maskload_ps(b+p*ldb+24,mask3),c3);\
+    }\
+    _mm256_maskstore_ps(c,mask0,c0); _mm256_maskstore_ps(c+8,mask1,c1);\
+    _mm256_maskstore_ps(c+16,mask2,c2); _mm256_maskstore_ps(c+24,mask3,c3);\
+}
+
+#define SGEMM_FMADD_AVX2(x,y,c) _mm256_fmadd_ps(x,y,c)
+#define SGEMM_MULADD_AVX2(x,y,c) _mm256_add_ps(c,_mm256_mul_ps(x,y))
+
+SGEMM_UPDATE_KERNEL_AVX2(sgemm_nn_kernel_avx2,"avx2,fma",SGEMM_FMADD_AVX2)
+SGEMM_UPDATE_KERNEL_AVX2(sgemm_tn_kernel_avx2,"avx2",SGEMM_MULADD_AVX2)
+SGEMM_UPDATE_ROW_KERNEL_AVX2(sgemm_nn_row_kernel_avx2,"avx2,fma",SGEMM_FMADD_AVX2)
+SGEMM_UPDATE_ROW_KERNEL_AVX2(sgemm_tn_row_kernel_avx2,"avx2",SGEMM_MULADD_AVX2)
+
+/* avx512 kernels*/
+
+__attribute__((target("avx512f")))
+void sgemm_nt_kernel_avx512(int k, float** a, float** b, float* c){
+    int p;
+    __m512 c00 = _mm512_setzero_ps(), c01 = _mm512_setzero_ps(), c02 = _mm512_setzero_ps(), c03 = _mm512_setzero_ps();
+    __m512 c10 = _mm512_setzero_ps(), c11 = _mm512_setzero_ps(), c12 = _mm512_setzero_ps(), c13 = _mm512_setzero_ps();
+    __m512 x0,x1,y;
+    __mmask16 mask;
+    for(p = 0; p+16 <= k; p+=16){
+        x0 = _mm512_loadu_ps(a[0]+p);
+        x1 = _mm512_loadu_ps(a[1]+p);
+        y = _mm512_loadu_ps(b[0]+p);
+        c00 = _mm512_fmadd_ps(x0,y,c00);
+        c10 = _mm512_fmadd_ps(x1,y,c10);
+        y = _mm512_loadu_ps(b[1]+p);
+        c01 = _mm512_fmadd_ps(x0,y,c01);
+        c11 = _mm512_fmadd_ps(x1,y,c11);
+        y = _mm512_loadu_ps(b[2]+p);
+        c02 = _mm512_fmadd_ps(x0,y,c02);
+        c12 = _mm512_fmadd_ps(x1,y,c12);
+        y = _mm512_loadu_ps(b[3]+p);
+        c03 = _mm512_fmadd_ps(x0,y,c03);
+        c13 = _mm512_fmadd_ps(x1,y,c13);
+    }
+    if(p < k){
+        mask = (__mmask16)((1u << (k-p))-1);
+        x0 = _mm512_maskz_loadu_ps(mask,a[0]+p);
+        x1 = _mm512_maskz_loadu_ps(mask,a[1]+p);
+        y = _mm512_maskz_loadu_ps(mask,b[0]+p);
+        c00 = _mm512_fmadd_ps(x0,y,c00);
+        c10 = _mm512_fmadd_ps(x1,y,c10);
+        y = _mm512_maskz_loadu_ps(mask,b[1]+p);
+        c01 = _mm512_fmadd_ps(x0,y,c01);
+        c11 = _mm512_fmadd_ps(x1,y,c11);
+        y = _mm512_maskz_loadu_ps(mask,b[2]+p);
+        c02 = _mm512_fmadd_ps(x0,y,c02);
+        c12 = _mm512_fmadd_ps(x1,y,c12);
+        y = _mm512_maskz_loadu_ps(mask,b[3]+p);
+        c03 = _mm512_fmadd_ps(x0,y,c03);
+        c13 = _mm512_fmadd_ps(x1,y,c13);
+    }
+    c[0] = _mm512_reduce_add_ps(c00);
+    c[1] = _mm512_reduce_add_ps(c01);
+    c[2] = _mm512_reduce_add_ps(c02);
+    c[3] = _mm512_reduce_add_ps(c03);
+    c[4] = _mm512_reduce_add_ps(c10);
+    c[5] = _mm512_reduce_add_ps(c11);
+    c[6] = _mm512_reduce_add_ps(c12);
+    c[7] = _mm512_reduce_add_ps(c13);
+}
+
+__attribute__((target("avx512f")))
+__mmask16 sgemm_mask_avx512(int n){
+    if(n >= 16)
+        return (__mmask16)0xFFFF;
+    if(n <= 0)
+        return (__mmask16)0;
+    return (__mmask16)((1u << n)-1);
+}
+
+/* avx512f has fma, the rounding versions of mul and add are builtins the compiler doesn't contract*/
+#define SGEMM_FMADD_AVX512(x,y,c) _mm512_fmadd_ps(x,y,c)
+#define SGEMM_MULADD_AVX512(x,y,c) _mm512_add_round_ps(c,_mm512_mul_round_ps(x,y,_MM_FROUND_CUR_DIRECTION),_MM_FROUND_CUR_DIRECTION)
+
+#define SGEMM_UPDATE_KERNEL_AVX512(name,madd)\
+__attribute__((target("avx512f")))\
+void name(int k, float** a, int a_stride, float* b, int ldb, float** c, int nc){\
+    int p;\
+    __m512 c00,c01,c10,c11,c20,c21,c30,c31,x,y0,y1;\
+    __mmask16 mask0 = sgemm_mask_avx512(nc), mask1 = sgemm_mask_avx512(nc-16);\
+    c00 = _mm512_maskz_loadu_ps(mask0,c[0]); c01 = _mm512_maskz_loadu_ps(mask1,c[0]+16);\
+    c10 = _mm512_maskz_loadu_ps(mask0,c[1]); c11 = _mm512_maskz_loadu_ps(mask1,c[1]+16);\
+    c20 = _mm512_maskz_loadu_ps(mask0,c[2]); c21 = _mm512_maskz_loadu_ps(mask1,c[2]+16);\
+    c30 = _mm512_maskz_loadu_ps(mask0,c[3]); c31 = _mm512_maskz_loadu_ps(mask1,c[3]+16);\
+    for(p = 0; p < k; p++){\
+        y0 = _mm512_maskz_loadu_ps(mask0,b+p*ldb);\
+        y1 = _mm512_maskz_loadu_ps(mask1,b+p*ldb+16);\
+        x = _mm512_set1_ps(a[0][p*a_stride]); c00 = madd(x,y0,c00); c01 = madd(x,y1,c01);\
+        x = _mm512_set1_ps(a[1][p*a_stride]); c10 = madd(x,y0,c10); c11 = madd(x,y1,c11);\
+        x = _mm512_set1_ps(a[2][p*a_stride]); c20 = madd(x,y0,c20); c21 = madd(x,y1,c21);\
+        x = _mm512_set1_ps(a[3][p*a_stride]); c30 = madd(x,y0,c30); c31 = madd(x,y1,c31);\
+    }\
+    _mm512_mask_storeu_ps(c[0],mask0,c00); _mm512_mask_storeu_ps(c[0]+16,mask1,c01);\
+    _mm512_mask_storeu_ps(c[1],mask0,c10); _mm512_mask_storeu_ps(c[1]+16,mask1,c11);\
+    _mm512_mask_storeu_ps(c[2],mask0,c20); _mm512_mask_storeu_ps(c[2]+16,mask1,c21);\
+    _mm512_mask_storeu_ps(c[3],mask0,c30); _mm512_mask_storeu_ps(c[3]+16,mask1,c31);\
+}
+
+/* the row kernels update 64 columns of a single row of C*/
+#define SGEMM_UPDATE_ROW_KERNEL_AVX512(name,madd)\
+__attribute__((target("avx512f")))\
+void name(int k, float* a, int a_stride, float* b, int ldb, float* c, int nc){\
+    int p;\
+    __m512 c0,c1,c2,c3,x;\
+    __mmask16 mask0 = sgemm_mask_avx512(nc), mask1 = sgemm_mask_avx512(nc-16), mask2 = sgemm_mask_avx512(nc-32), mask3 = sgemm_mask_avx512(nc-48);\
+    c0 = _mm512_maskz_loadu_ps(mask0,c); c1 = _mm512_maskz_loadu_ps(mask1,c+16);\
+    c2 = _mm512_maskz_loadu_ps(mask2,c+32); c3 = _mm512_maskz_loadu_ps(mask3,c+48);\
+    for(p = 0; p < k; p++){\
+        x = _mm512_set1_ps(a[p*a_stride]);\
+        c0 = madd(x,_mm512_maskz_loadu_ps(mask0,b+p*ldb),c0);\
+        c1 = madd(x,_mm512_maskz_loadu_ps(mask1,b+p*ldb+16),c1);\
+        c2 = madd(x,_mm512_maskz_loadu_ps(mask2,b+p*ldb+32),c2);\
+        c3 = madd(x,_mm512_maskz_loadu_ps(mask3,b+p*ldb+48),c3);\
+    }\
+    _mm512_mask_storeu_ps(c,mask0,c0); _mm512_mask_storeu_ps(c+16,mask1,c1);\
+    _mm512_mask_storeu_ps(c+32,mask2,c2); _mm512_mask_storeu_ps(c+48,mask3,c3);\
+}
+
+SGEMM_UPDATE_KERNEL_AVX512(sgemm_nn_kernel_avx512,SGEMM_FMADD_AVX512)
+SGEMM_UPDATE_KERNEL_AVX512(sgemm_tn_kernel_avx512,SGEMM_MULADD_AVX512)
+SGEMM_UPDATE_ROW_KERNEL_AVX512(sgemm_nn_row_kernel_avx512,SGEMM_FMADD_AVX512)
+SGEMM_UPDATE_ROW_KERNEL_AVX512(sgemm_tn_row_kernel_avx512,SGEMM_MULADD_AVX512)
+
+#endif
+
+/* This function computes C += A*B^T, each element of C is the dot product between a row of A and a row of B.
+ * The rows of B are split in blocks of about SGEMM_L2_FLOATS floats, each block is reused by all the rows of A
+ * 
+ * Input:
+ *         @ int m:= the rows of A and C
+ *         @ int n:= the rows of B and the columns of C
+ *         @ int k:= the columns of A and B
+ *         @ float* a:= the matrix A, dimensions: m*lda
+ *         @ int lda:= the leading dimension of A
+ *         @ float* b:= the matrix B, dimensions: n*ldb
+ *         @ int ldb:= the leading dimension of B
+ *         @ float* c:= the matrix C, dimensions: m*ldc
+ *         @ int ldc:= the leading dimension of C
+ * */
+void sgemm_nt(int m, int n, int k, float* a, int lda, float* b, int ldb, float* c, int ldc){
+    if(m <= 0 || n <= 0 || k <= 0)
+        return;
+    int i,j,j0,j_end,r,q,block = SGEMM_L2_FLOATS/k;
+    int instruction_set = get_sgemm_instruction_set();
+    float* ar[2];
+    float* br[4];
+    float tile[8];
+    block -= block%4;
+    if(block < 4)
+        block = 4;
+    for(j0 = 0; j0 < n; j0+=block){
+        j_end = j0+block < n ? j0+block : n;
+        for(i = 0; i < m; i+=2){
+            ar[0] = a+i*lda;
+            ar[1] = i+1 < m ? a+(i+1)*lda : ar[0];
+            for(j = j0; j < j_end; j+=4){
+                for(q = 0; q < 4; q++){
+                    br[q] = j+q < j_end ? b+(j+q)*ldb : b+j*ldb;
+                }
+                #ifdef SGEMM_X86
+                if(instruction_set == SGEMM_AVX512)
+                    sgemm_nt_kernel_avx512(k,ar,br,tile);
+                else if(instruction_set == SGEMM_AVX2)
+                    sgemm_nt_kernel_avx2(k,ar,br,tile);
+                else if(instruction_set == SGEMM_SSE2)
+                    sgemm_nt_kernel_sse2(k,ar,br,tile);
+                else
+                #endif
+                sgemm_nt_kernel_scalar(k,ar,br,tile);
+                for(r = 0; r < 2 && i+r < m; r++){
+                    for(q = 0; q < 4 && j+q < j_end; q++){
+                        c[(i+r)*ldc+j+q] += tile[r*4+q];
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* This function computes C += A*B where A is read as a m*k matrix with a_row_stride between its rows
+ * and a_k_stride between its columns, so it is used both by sgemm_nn and sgemm_tn.
+ * The columns of C are split in blocks such that the same columns of B (k*block) stay in cache
+ * while all the rows of C are updated
+ * 
+ * Input:
+ *         @ int fused:= 1 if the products can be fused with the additions, 0 otherwise
+ *         @ int m:= the rows of C
+ *         @ int n:= the columns of B and C
+ *         @ int k:= the columns of op(A) and the rows of B
+ *         @ float* a:= the matrix A
+ *         @ int a_row_stride:= the distance between two rows of op(A)
+ *         @ int a_k_stride:= the distance between two columns of op(A)
+ *         @ float* b:= the matrix B, dimensions: k*ldb
+ *         @ int ldb:= the leading dimension of B
+ *         @ float* c:= the matrix C, dimensions: m*ldc
+ *         @ int ldc:= the leading dimension of C
+ * */
+void sgemm_update(int fused, int m, int n, int k, float* a, int a_row_stride, int a_k_stride, float* b, int ldb, float* c, int ldc){
+    if(m <= 0 || n <= 0 || k <= 0)
+        return;
+    int i,j,j0,j_end,r,nc,width,block;
+    int instruction_set = get_sgemm_instruction_set();
+    float* ar[4];
+    float* cr[4];
+    if(instruction_set == SGEMM_AVX512)
+        width = 32;
+    else if(instruction_set == SGEMM_AVX2)
+        width = 16;
+    else
+        width = 8;
+    block = SGEMM_L2_FLOATS/k;
+    block -= block%width;
+    if(block < width)
+        block = width;
+    for(j0 = 0; j0 < n; j0+=block){
+        j_end = j0+block < n ? j0+block : n;
+        for(i = 0; i+4 <= m; i+=4){
+            for(j = j0; j < j_end; j+=width){
+                nc = j_end-j < width ? j_end-j : width;
+                for(r = 0; r < 4; r++){
+                    ar[r] = a+(i+r)*a_row_stride;
+                    cr[r] = c+(i+r)*ldc+j;
+                }
+                #ifdef SGEMM_X86
+                if(instruction_set == SGEMM_AVX512 && fused)
+                    sgemm_nn_kernel_avx512(k,ar,a_k_stride,b+j,ldb,cr,nc);
+                else if(instruction_set == SGEMM_AVX512)
+                    sgemm_tn_kernel_avx512(k,ar,a_k_stride,b+j,ldb,cr,nc);
+                else if(instruction_set == SGEMM_AVX2 && fused)
+                    sgemm_nn_kernel_avx2(k,ar,a_k_stride,b+j,ldb,cr,nc);
+                else if(instruction_set == SGEMM_AVX2)
+                    sgemm_tn_kernel_avx2(k,ar,a_k_stride,b+j,ldb,cr,nc);
+                else if(instruction_set == SGEMM_SSE2)
+                    sgemm_update_kernel_sse2(k,ar,a_k_stride,b+j,ldb,cr,nc);
+                else
+                #endif
+                sgemm_update_kernel_scalar(k,ar,a_k_stride,b+j,ldb,cr,nc);
+            }
+        }
+        // the last m%4 rows, one at a time
+        for(; i < m; i++){
+            for(j = j0; j < j_end; j+=2*width){
+                nc = j_end-j < 2*width ? j_end-j : 2*width;
+                #ifdef SGEMM_X86
+                if(instruction_set == SGEMM_AVX512 && fused)
+                    sgemm_nn_row_kernel_avx512(k,a+i*a_row_stride,a_k_stride,b+j,ldb,c+i*ldc+j,nc);
+                else if(instruction_set == SGEMM_AVX512)
+                    sgemm_tn_row_kernel_avx512(k,a+i*a_row_stride,a_k_stride,b+j,ldb,c+i*ldc+j,nc);
+                else if(instruction_set == SGEMM_AVX2 && fused)
+                    sgemm_nn_row_kernel_avx2(k,a+i*a_row_stride,a_k_stride,b+j,ldb,c+i*ldc+j,nc);
+                else if(instruction_set == SGEMM_AVX2)
+                    sgemm_tn_row_kernel_avx2(k,a+i*a_row_stride,a_k_stride,b+j,ldb,c+i*ldc+j,nc);
+                else if(instruction_set == SGEMM_SSE2)
+                    sgemm_update_row_kernel_sse2(k,a+i*a_row_stride,a_k_stride,b+j,ldb,c+i*ldc+j,nc);
+                else
+                #endif
+                sgemm_update_row_kernel_scalar(k,a+i*a_row_stride,a_k_stride,b+j,ldb,c+i*ldc+j,nc);
+            }
+        }
+    }
+}
+
+/* This function computes C += A*B
+ * 
+ * Input:
+ *         @ int m:= the rows of A and C
+ *         @ int n:= the columns of B and C
+ *         @ int k:= the columns of A and the rows of B
+ *         @ float* a:= the matrix A, dimensions: m*lda
+ *         @ int lda:= the leading dimension of A
+ *         @ float* b:= the matrix B, dimensions: k*ldb
+ *         @ int ldb:= the leading dimension of B
+ *         @ float* c:= the matrix C, dimensions: m*ldc
+ *         @ int ldc:= the leading dimension of C
+ * */
+void sgemm_nn(int m, int n, int k, float* a, int lda, float* b, int ldb, float* c, int ldc){
+    sgemm_update(1,m,n,k,a,lda,1,b,ldb,c,ldc);
+}
+
+/* This function computes C += A^T*B, the k products of each element are added to C one at a time
+ * in the order of the rows of A and B, and they are never fused with the additions
+ * 
+ * Input:
+ *         @ int m:= the columns of A and the rows of C
+ *         @ int n:= the columns of B and C
+ *         @ int k:= the rows of A and B
+ *         @ float* a:= the matrix A, dimensions: k*lda
+ *         @ int lda:= the leading dimension of A
+ *         @ float* b:= the matrix B, dimensions: k*ldb
+ *         @ int ldb:= the leading dimension of B
+ *         @ float* c:= the matrix C, dimensions: m*ldc
+ *         @ int ldc:= the leading dimension of C
+ * */
+void sgemm_tn(int m, int n, int k, float* a, int lda, float* b, int ldb, float* c, int ldc){
+    sgemm_update(0,m,n,k,a,1,lda,b,ldb,c,ldc);
+}
+
+/* This function computes C += A*B^T with B stored in 16 bits (bfloat16 or half precision).
+ * Blocks of B of at most HALF_PANEL_FLOATS floats are widened in a panel that stays in cache
+ * and multiplied with sgemm_nt, so B is read from memory only once and in 16 bits
+ * 
+ * Input:
+ *         @ int m:= the rows of A and C
+ *         @ int n:= the rows of B and the columns of C
+ *         @ int k:= the columns of A and B
+ *         @ float* a:= the matrix A, dimensions: m*lda
+ *         @ int lda:= the leading dimension of A
+ *         @ unsigned short* b:= the matrix B, dimensions: n*ldb
+ *         @ int ldb:= the leading dimension of B
+ *         @ int precision:= BF16_PRECISION or FP16_PRECISION
+ *         @ float* c:= the matrix C, dimensions: m*ldc
+ *         @ int ldc:= the leading dimension of C
+ * */
+void sgemm_nt_half(int m, int n, int k, float* a, int lda, unsigned short* b, int ldb, int precision, float* c, int ldc){
+    float panel[HALF_PANEL_FLOATS];
+    int i,j,p,kc,nr,rows;
+    for(p = 0; p < k; p+=kc){
+        kc = k-p < HALF_PANEL_FLOATS ? k-p : HALF_PANEL_FLOATS;
+        rows = HALF_PANEL_FLOATS/kc;
+        for(j = 0; j < n; j+=nr){
+            nr = n-j < rows ? n-j : rows;
+            for(i = 0; i < nr; i++){
+                half_to_float_array(precision,&b[(j+i)*ldb+p],&panel[i*kc],kc);
+            }
+            sgemm_nt(m,nr,kc,&a[p],lda,panel,kc,&c[j],ldc);
+        }
+    }
+}
+
+/* This function computes C += A*B with B stored in 16 bits (bfloat16 or half precision), see sgemm_nt_half
+ * 
+ * Input:
+ *         @ int m:= the rows of A and C
+ *         @ int n:= the columns of B and C
+ *         @ int k:= the columns of A and the rows of B
+ *         @ float* a:= the matrix A, dimensions: m*lda
+ *         @ int lda:= the leading dimension of A
+ *         @ unsigned short* b:= the matrix B, dimensions: k*ldb
+ *         @ int ldb:= the leading dimension of B
+ *         @ int precision:= BF16_PRECISION or FP16_PRECISION
+ *         @ float* c:= the matrix C, dimensions: m*ldc
+ *         @ int ldc:= the leading dimension of C
+ * */
+void sgemm_nn_half(int m, int n, int k, float* a, int lda, unsigned short* b, int ldb, int precision, float* c, int ldc){
+    float panel[HALF_PANEL_FLOATS];
+    int i,p,q,nc,kr,rows;
+    for(q = 0; q < n; q+=nc){
+        nc = n-q < HALF_PANEL_FLOATS ? n-q : HALF_PANEL_FLOATS;
+        rows = HALF_PANEL_FLOATS/nc;
+        for(p = 0; p < k; p+=kr){
+            kr = k-p < rows ? k-p : rows;
+            for(i = 0; i < kr; i++){
+                half_to_float_array(precision,&b[(p+i)*ldb+q],&panel[i*nc],nc);
+            }
+            sgemm_nn(m,nc,kr,&a[p],lda,panel,nc,&c[q],ldc);
+        }
+    }
+}
+
+/* This function computes y += A*x
+ * 
+ * Input:
+ *         @ int n:= the rows of A and the size of y
+ *         @ int k:= the columns of A and the size of x
+ *         @ float* a:= the matrix A, dimensions: n*lda
+ *         @ int lda:= the leading dimension of A
+ *         @ float* x:= the vector x, dimensions: k
+ *         @ float* y:= the vector y, dimensions: n
+ * */
+void sgemv(int n, int k, float* a, int lda, float* x, float* y){
+    sgemm_nt(1,n,k,x,k,a,lda,y,n);
+}
+
+/* This function computes y += A^T*x
+ * 
+ * Input:
+ *         @ int n:= the rows of A and the size of x
+ *         @ int k:= the columns of A and the size of y
+ *         @ float* a:= the matrix A, dimensions: n*lda
+ *         @ int lda:= the leading dimension of A
+ *         @ float* x:= the vector x, dimensions: n
+ *         @ float* y:= the vector y, dimensions: k
+ * */
+void sgemv_t(int n, int k, float* a, int lda, float* x, float* y){
+    sgemm_nn(1,k,n,x,n,a,lda,y,k);
+}
+
+/* This function computes A += x*y^T
+ * 
+ * Input:
+ *         @ int m:= the rows of A and the size of x
+ *         @ int n:= the columns of A and the size of y
+ *         @ float* x:= the vector x, dimensions: m
+ *         @ float* y:= the vector y, dimensions: n
+ *         @ float* a:= the matrix A, dimensions: m*lda
+ *         @ int lda:= the leading dimension of A
+ * */
+void sger(int m, int n, float* x, float* y, float* a, int lda){
+    sgemm_tn(m,n,1,x,m,y,n,a,lda);
+}
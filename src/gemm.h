@@ -0,0 +1,44 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __GEMM_H__
+#define __GEMM_H__
+
+int sgemm_detect_instruction_set();
+void set_sgemm_instruction_set(int instruction_set);
+int get_sgemm_instruction_set();
+void sgemm_nt_kernel_scalar(int k, float** a, float** b, float* c);
+void sgemm_update_kernel_scalar(int k, float** a, int a_stride, float* b, int ldb, float** c, int nc);
+void sgemm_update_row_kernel_scalar(int k, float* a, int a_stride, float* b, int ldb, float* c, int nc);
+void sgemm_nt(int m, int n, int k, float* a, int lda, float* b, int ldb, float* c, int ldc);
+void sgemm_update(int fused, int m, int n, int k, float* a, int a_row_stride, int a_k_stride, float* b, int ldb, float* c, int ldc);
+void sgemm_nn(int m, int n, int k, float* a, int lda, float* b, int ldb, float* c, int ldc);
+void sgemm_tn(int m, int n, int k, float* a, int lda, float* b, int ldb, float* c, int ldc);
+void sgemm_nt_half(int m, int n, int k, float* a, int lda, unsigned short* b, int ldb, int precision, float* c, int ldc);
+void sgemm_nn_half(int m, int n, int k, float* a, int lda, unsigned short* b, int ldb, int precision, float* c, int ldc);
+void sgemv(int n, int k, float* a, int lda, float* x, float* y);
+void sgemv_t(int n, int k, float* a, int lda, float* x, float* y);
+void sger(int m, int n, float* x, float* y, float* a, int lda);
+
+#endif
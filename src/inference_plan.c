@@ -0,0 +1,592 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+#include "llab.h"
+
+/* An inference plan is a model compiled for the feed forward: the sla matrix is walked once by compile_model
+ * and each layer becomes a step that computes the whole layer in place of the ff_* functions:
+ * the biases and the activation are computed in a single pass over the output of the gemm, the activation of a
+ * convolution followed by max pooling is computed after the pooling when it doesn't change the result, the dropout
+ * of DROPOUT_TEST is a scaling of the output and the input of a residual layer is summed with the activation of rl->cl_output.
+ * The outputs of the steps are stored in a few buffers: a buffer is reused as soon as the last step that reads its value is done.
+ * Nothing is allocated and the model is not reset between two feed forwards, only the means and the variances of the normalizations are cleared. The plan reads the parameters of the model,
+ * so it sees the updates of the weights, but it must be compiled again if the arrays of the model are reallocated
+ * */
+
+/* This function computes output = activation(input+bias) in a single pass
+ * 
+ * Input:
+ *             @ float* input:= the input, dimensions: size
+ *             @ float* bias:= the biases, dimensions: size
+ *             @ float* output:= the output, can be input, dimensions: size
+ *             @ int size:= the size of the arrays
+ *             @ int activation_flag:= SIGMOID, RELU, ELU, TANH, LEAKY_RELU or NO_ACTIVATION
+ * */
+void add_bias_activation(float* input, float* bias, float* output, int size, int activation_flag){
+    int i;
+    if(activation_flag == SIGMOID){
+        for(i = 0; i < size; i++){
+            output[i] = sigmoid(input[i]+bias[i]);
+        }
+    }
+    else if(activation_flag == RELU){
+        for(i = 0; i < size; i++){
+            output[i] = relu(input[i]+bias[i]);
+        }
+    }
+    else if(activation_flag == ELU){
+        for(i = 0; i < size; i++){
+            output[i] = elu(input[i]+bias[i],ELU_THRESHOLD);
+        }
+    }
+    else if(activation_flag == TANH){
+        for(i = 0; i < size; i++){
+            output[i] = tanhh(input[i]+bias[i]);
+        }
+    }
+    else if(activation_flag == LEAKY_RELU){
+        for(i = 0; i < size; i++){
+            output[i] = leaky_relu(input[i]+bias[i]);
+        }
+    }
+    else{
+        for(i = 0; i < size; i++){
+            output[i] = input[i]+bias[i];
+        }
+    }
+}
+
+/* This function computes output = activation(input+bias) in a single pass with the same bias for each value
+ * 
+ * Input:
+ *             @ float* input:= the input, dimensions: size
+ *             @ float bias:= the bias
+ *             @ float* output:= the output, can be input, dimensions: size
+ *             @ int size:= the size of the arrays
+ *             @ int activation_flag:= SIGMOID, RELU, ELU, TANH, LEAKY_RELU or NO_ACTIVATION
+ * */
+void add_scalar_bias_activation(float* input, float bias, float* output, int size, int activation_flag){
+    int i;
+    if(activation_flag == SIGMOID){
+        for(i = 0; i < size; i++){
+            output[i] = sigmoid(input[i]+bias);
+        }
+    }
+    else if(activation_flag == RELU){
+        for(i = 0; i < size; i++){
+            output[i] = relu(input[i]+bias);
+        }
+    }
+    else if(activation_flag == ELU){
+        for(i = 0; i < size; i++){
+            output[i] = elu(input[i]+bias,ELU_THRESHOLD);
+        }
+    }
+    else if(activation_flag == TANH){
+        for(i = 0; i < size; i++){
+            output[i] = tanhh(input[i]+bias);
+        }
+    }
+    else if(activation_flag == LEAKY_RELU){
+        for(i = 0; i < size; i++){
+            output[i] = leaky_relu(input[i]+bias);
+        }
+    }
+    else{
+        for(i = 0; i < size; i++){
+            output[i] = input[i]+bias;
+        }
+    }
+}
+
+/* This function says if the activation of a convolutional layer can be computed after the pooling:
+ * the max pooling commutes with relu and leaky relu, that are monotonic and 0 in the 0s of the padding
+ * 
+ * Input:
+ *             @ cl* c:= the convolutional layer
+ * 
+ * Output:
+ *             @ int:= 1 if the activation can be computed after the pooling, 0 otherwise
+ * */
+int plan_fuses_pooling(cl* c){
+    return c->convolutional_flag == CONVOLUTION && c->pooling_flag == MAX_POOLING && c->normalization_flag == NO_NORMALIZATION && (c->activation_flag == RELU || c->activation_flag == LEAKY_RELU);
+}
+
+/* This function returns the floats of the workspace used by a step
+ * 
+ * Input:
+ *             @ plan_step* s:= the step
+ * 
+ * Output:
+ *             @ int:= the floats of the workspace
+ * */
+int plan_step_workspace(plan_step* s){
+    int size = 0,patches,patch_size,map;
+    cl* c = s->c;
+    if(s->type == PLAN_FULLY_CONNECTED && s->f->normalization_flag == LAYER_NORMALIZATION)
+        return s->f->output;
+    if(s->type != PLAN_CONVOLUTION || c->convolutional_flag != CONVOLUTION)
+        return 0;
+    map = c->n_kernels*c->rows1*c->cols1;
+    if(c->normalization_flag || c->pooling_flag)
+        size += map;
+    if(c->normalization_flag && c->pooling_flag)
+        size += map;
+    if(get_convolution_algorithm(c) == IM2COL_CONVOLUTION){
+        patches = ((c->input_rows-c->kernel_rows)/c->stride1_rows+1)*((c->input_cols-c->kernel_cols)/c->stride1_rows+1);
+        patch_size = c->channels*c->kernel_rows*c->kernel_cols;
+        size += patches*patch_size + c->n_kernels*patch_size + c->n_kernels*patches;
+    }
+    return size;
+}
+
+/* This function computes the pooling of the feature maps of a convolutional layer
+ * 
+ * Input:
+ *             @ cl* c:= the convolutional layer
+ *             @ float* input:= the feature maps, dimensions: c->n_kernels*rows*cols
+ *             @ int rows:= the rows of each feature map
+ *             @ int cols:= the columns of each feature map
+ *             @ float* output:= the output, dimensions: c->n_kernels*c->rows2*c->cols2
+ * */
+void plan_pooling(cl* c, float* input, int rows, int cols, float* output){
+    int i;
+    if(c->padding2_rows)
+        memset(output,0,sizeof(float)*c->n_kernels*c->rows2*c->cols2);
+    for(i = 0; i < c->n_kernels; i++){
+        if(c->pooling_flag == MAX_POOLING)
+            max_pooling_feed_forward(&input[i*rows*cols],&output[i*c->rows2*c->cols2],rows,cols,c->pooling_rows,c->pooling_cols,c->stride2_rows,c->padding2_rows);
+        else
+            avarage_pooling_feed_forward(&input[i*rows*cols],&output[i*c->rows2*c->cols2],rows,cols,c->pooling_rows,c->pooling_cols,c->stride2_rows,c->padding2_rows);
+    }
+}
+
+/* This function computes a fully-connected step
+ * 
+ * Input:
+ *             @ inference_plan* p:= the plan
+ *             @ plan_step* s:= the step
+ *             @ float* input:= the input, dimensions: s->f->input
+ *             @ float* output:= the output, dimensions: s->f->output
+ * */
+void plan_fully_connected_step(inference_plan* p, plan_step* s, float* input, float* output){
+    fcl* f = s->f;
+    float* y = output;
+    if(f->normalization_flag == LAYER_NORMALIZATION)
+        y = p->workspace;
+    memset(y,0,sizeof(float)*f->output);
+    sgemv(f->output,f->input,f->weights,f->input,input,y);
+    if(f->activation_flag == SOFTMAX){
+        add_bias_activation(y,f->biases,y,f->output,NO_ACTIVATION);
+        softmax(y,y,f->output);
+    }
+    else
+        add_bias_activation(y,f->biases,y,f->output,f->activation_flag);
+    if(f->normalization_flag == LAYER_NORMALIZATION){
+        memset(f->layer_norm->mean,0,sizeof(float)*f->layer_norm->vector_dim);
+        memset(f->layer_norm->var,0,sizeof(float)*f->layer_norm->vector_dim);
+        channel_normalization_feed_forward(f->layer_norm->batch_size,y,f->layer_norm->temp_vectors,f->layer_norm->vector_dim,f->layer_norm->gamma,f->layer_norm->beta,f->layer_norm->mean,f->layer_norm->var,output,f->layer_norm->epsilon,0,0,f->layer_norm->vector_dim,1,NULL);
+    }
+    if(s->scale != 1)
+        mul_value(output,s->scale,output,f->output);
+}
+
+/* This function computes a convolutional step, the activation is computed only on the output without the padding
+ * and the padding is 0, as for the convolutional layers
+ * 
+ * Input:
+ *             @ inference_plan* p:= the plan
+ *             @ plan_step* s:= the step
+ *             @ float* input:= the input, dimensions: s->c->channels*s->c->input_rows*s->c->input_cols
+ *             @ float* output:= the output, dimensions: s->size
+ * */
+void plan_convolutional_step(inference_plan* p, plan_step* s, float* input, float* output){
+    cl* c = s->c;
+    int i,j,k,patches_i,patches_j,patches,patch_size,pad = c->padding1_rows,map = c->rows1*c->cols1;
+    int activation_flag = s->fused_pooling ? NO_ACTIVATION : c->activation_flag;
+    float* workspace = p->workspace;
+    float* pre = output;
+    float* norm = output;
+    float* col;
+    float* kernels;
+    float* gemm;
+    
+    if(c->convolutional_flag == NO_CONVOLUTION){
+        if(c->pooling_flag)
+            plan_pooling(c,input,c->input_rows,c->input_cols,output);
+        else
+            copy_array(input,output,s->size);
+        return;
+    }
+    
+    if(c->normalization_flag || c->pooling_flag){
+        pre = workspace;
+        workspace += c->n_kernels*map;
+    }
+    if(c->normalization_flag && c->pooling_flag){
+        norm = workspace;
+        workspace += c->n_kernels*map;
+    }
+    
+    if(get_convolution_algorithm(c) == IM2COL_CONVOLUTION){
+        patches_i = (c->input_rows-c->kernel_rows)/c->stride1_rows+1;
+        patches_j = (c->input_cols-c->kernel_cols)/c->stride1_rows+1;
+        patches = patches_i*patches_j;
+        patch_size = c->channels*c->kernel_rows*c->kernel_cols;
+        col = workspace;
+        kernels = col + patches*patch_size;
+        gemm = kernels + c->n_kernels*patch_size;
+        im2col(input,c->channels,c->input_rows,c->input_cols,c->kernel_rows,c->kernel_cols,c->stride1_rows,col);
+        for(k = 1; k < c->n_kernels && c->kernels[k] == c->kernels[0]+k*patch_size; k++);
+        if(k == c->n_kernels)
+            kernels = c->kernels[0];
+        else{
+            for(k = 0; k < c->n_kernels; k++){
+                copy_array(c->kernels[k],&kernels[k*patch_size],patch_size);
+            }
+        }
+        memset(gemm,0,sizeof(float)*c->n_kernels*patches);
+        sgemm_nt(c->n_kernels,patches,patch_size,kernels,patch_size,col,patch_size,gemm,patches);
+        if(pad)
+            memset(pre,0,sizeof(float)*c->n_kernels*map);
+        for(k = 0; k < c->n_kernels; k++){
+            for(i = 0; i < patches_i; i++){
+                add_scalar_bias_activation(&gemm[k*patches+i*patches_j],c->biases[k],&pre[k*map+(i+pad)*c->cols1+pad],patches_j,activation_flag);
+            }
+        }
+    }
+    
+    else{
+        memset(pre,0,sizeof(float)*c->n_kernels*map);
+        if(get_convolution_algorithm(c) == WINOGRAD_CONVOLUTION){
+            update_winograd_kernels(c);
+            convolutional_feed_forward_winograd(input,c->winograd_kernels,c->n_kernels,c->input_rows,c->input_cols,c->biases,c->channels,pre,pad,c->winograd_tile,c->winograd_workspace);
+        }
+        else{
+            for(k = 0; k < c->n_kernels; k++){
+                convolutional_feed_forward(input,c->kernels[k],c->input_rows,c->input_cols,c->kernel_rows,c->kernel_cols,c->biases[k],c->channels,&pre[k*map],c->stride1_rows,pad);
+            }
+        }
+        for(k = 0; k < c->n_kernels && activation_flag; k++){
+            for(i = pad; i < c->rows1-pad; i++){
+                add_scalar_bias_activation(&pre[k*map+i*c->cols1+pad],0,&pre[k*map+i*c->cols1+pad],c->cols1-2*pad,activation_flag);
+            }
+        }
+    }
+    
+    if(c->normalization_flag == LOCAL_RESPONSE_NORMALIZATION){
+        if(pad)
+            memset(norm,0,sizeof(float)*c->n_kernels*map);
+        for(k = 0; k < c->n_kernels; k++){
+            for(i = pad; i < c->rows1-pad; i++){
+                for(j = pad; j < c->cols1-pad; j++){
+                    local_response_normalization_feed_forward(pre,norm,k,i,j,c->n_kernels,c->rows1,c->cols1,N_NORMALIZATION,BETA_NORMALIZATION,ALPHA_NORMALIZATION,K_NORMALIZATION,c->used_kernels);
+                }
+            }
+        }
+    }
+    else if(c->normalization_flag == GROUP_NORMALIZATION){
+        if(pad)
+            memset(norm,0,sizeof(float)*c->n_kernels*map);
+        for(k = 0; k < c->n_kernels/c->group_norm_channels; k++){
+            memset(c->group_norm[k]->mean,0,sizeof(float)*c->group_norm[k]->vector_dim);
+            memset(c->group_norm[k]->var,0,sizeof(float)*c->group_norm[k]->vector_dim);
+        }
+        group_normalization_feed_forward(pre,c->n_kernels,c->rows1,c->cols1,c->group_norm_channels,c->group_norm_channels,c->group_norm,pad,c->padding1_cols,norm,c->used_kernels);
+    }
+    
+    if(c->pooling_flag){
+        plan_pooling(c,c->normalization_flag ? norm : pre,c->rows1,c->cols1,output);
+        for(k = 0; k < c->n_kernels && s->fused_pooling; k++){
+            for(i = c->padding2_rows; i < c->rows2-c->padding2_rows; i++){
+                add_scalar_bias_activation(&output[k*c->rows2*c->cols2+i*c->cols2+c->padding2_rows],0,&output[k*c->rows2*c->cols2+i*c->cols2+c->padding2_rows],c->cols2-2*c->padding2_rows,c->activation_flag);
+            }
+        }
+    }
+}
+
+/* This function returns the value read by a step
+ * 
+ * Input:
+ *             @ inference_plan* p:= the plan
+ *             @ int step:= the step that computed the value, or PLAN_INPUT
+ *             @ float* input:= the input of the plan
+ * 
+ * Output:
+ *             @ float*:= the value
+ * */
+float* get_plan_value(inference_plan* p, int step, float* input){
+    if(step == PLAN_INPUT)
+        return input;
+    return p->buffers[p->steps[step].buffer];
+}
+
+/* This function computes the feed forward of a compiled model, the output is p->output_layer
+ * 
+ * Input:
+ *             @ inference_plan* p:= the plan
+ *             @ float* input:= the input, with the dimensions given to compile_model
+ * */
+void plan_tensor_input_ff(inference_plan* p, float* input){
+    if(p == NULL)
+        return;
+    int i;
+    plan_step* s;
+    for(i = 0; i < p->n_steps; i++){
+        s = &p->steps[i];
+        if(s->type == PLAN_FULLY_CONNECTED)
+            plan_fully_connected_step(p,s,get_plan_value(p,s->input,input),p->buffers[s->buffer]);
+        else if(s->type == PLAN_CONVOLUTION)
+            plan_convolutional_step(p,s,get_plan_value(p,s->input,input),p->buffers[s->buffer]);
+        else
+            add_bias_activation(get_plan_value(p,s->residual,input),get_plan_value(p,s->input,input),p->buffers[s->buffer],s->size,s->r->cl_output->activation_flag);
+    }
+}
+
+/* This function adds a step to a plan
+ * 
+ * Input:
+ *             @ inference_plan* p:= the plan, with space for the step
+ *             @ int type:= PLAN_FULLY_CONNECTED, PLAN_CONVOLUTION or PLAN_RESIDUAL
+ *             @ int input:= the step whose output is read, or PLAN_INPUT
+ *             @ int size:= the floats of the output
+ *             @ fcl* f:= the fully-connected layer, or NULL
+ *             @ cl* c:= the convolutional layer, or NULL
+ *             @ rl* r:= the residual layer, or NULL
+ * 
+ * Output:
+ *             @ plan_step*:= the step
+ * */
+plan_step* add_plan_step(inference_plan* p, int type, int input, int size, fcl* f, cl* c, rl* r){
+    plan_step* s = &p->steps[p->n_steps];
+    memset(s,0,sizeof(plan_step));
+    s->type = type;
+    s->input = input;
+    s->residual = PLAN_INPUT;
+    s->size = size;
+    s->scale = 1;
+    s->f = f;
+    s->c = c;
+    s->r = r;
+    if(c != NULL)
+        s->fused_pooling = plan_fuses_pooling(c);
+    p->n_steps++;
+    return s;
+}
+
+/* This function adds the step of a convolutional layer to a plan, checking that it can be compiled
+ * 
+ * Input:
+ *             @ inference_plan* p:= the plan
+ *             @ cl* c:= the convolutional layer
+ *             @ int input:= the step whose output is read, or PLAN_INPUT
+ *             @ int input_size:= the floats of the input
+ * */
+void add_plan_convolutional_step(inference_plan* p, cl* c, int input, int input_size){
+    if(c->channels*c->input_rows*c->input_cols != input_size){
+        fprintf(stderr,"Error: the input of the convolutional layer %d has %d floats instead of %d\n",c->layer,input_size,c->channels*c->input_rows*c->input_cols);
+        exit(1);
+    }
+    if(c->convolutional_flag == TRANSPOSED_CONVOLUTION || c->feed_forward_flag != FULLY_FEED_FORWARD || c->activation_flag == SOFTMAX){
+        fprintf(stderr,"Error: only the convolutional layers with CONVOLUTION or NO_CONVOLUTION, FULLY_FEED_FORWARD and without softmax can be compiled\n");
+        exit(1);
+    }
+    if(c->pooling_flag)
+        add_plan_step(p,PLAN_CONVOLUTION,input,c->n_kernels*c->rows2*c->cols2,NULL,c,NULL);
+    else
+        add_plan_step(p,PLAN_CONVOLUTION,input,c->n_kernels*c->rows1*c->cols1,NULL,c,NULL);
+}
+
+/* This function assigns the buffers to the outputs of the steps of a plan and allocates them:
+ * a buffer is free after the last step that reads its value, the step takes the smallest free buffer
+ * that is large enough, or the largest free buffer that is enlarged, or a new buffer. The output of the last step is never freed
+ * 
+ * Input:
+ *             @ inference_plan* p:= the plan with the steps
+ * */
+void allocate_plan_buffers(inference_plan* p){
+    int i,j,b;
+    int* last_use = (int*)malloc(sizeof(int)*p->n_steps);
+    int* values = (int*)malloc(sizeof(int)*p->n_steps);// the value held by each buffer, -1 if it is free
+    p->buffer_sizes = (int*)calloc(p->n_steps,sizeof(int));
+    p->n_buffers = 0;
+    
+    for(i = 0; i < p->n_steps; i++){
+        last_use[i] = i;
+        if(p->steps[i].input != PLAN_INPUT)
+            last_use[p->steps[i].input] = i;
+        if(p->steps[i].residual != PLAN_INPUT)
+            last_use[p->steps[i].residual] = i;
+    }
+    last_use[p->n_steps-1] = p->n_steps;
+    
+    for(i = 0; i < p->n_steps; i++){
+        for(j = 0, b = -1; j < p->n_buffers; j++){
+            if(values[j] != -1)
+                continue;
+            if(b == -1 || (p->buffer_sizes[j] >= p->steps[i].size && (p->buffer_sizes[b] < p->steps[i].size || p->buffer_sizes[j] < p->buffer_sizes[b])) || (p->buffer_sizes[b] < p->steps[i].size && p->buffer_sizes[j] > p->buffer_sizes[b]))
+                b = j;
+        }
+        if(b == -1){
+            b = p->n_buffers;
+            p->n_buffers++;
+        }
+        if(p->buffer_sizes[b] < p->steps[i].size)
+            p->buffer_sizes[b] = p->steps[i].size;
+        values[b] = i;
+        p->steps[i].buffer = b;
+        
+        if(p->steps[i].input != PLAN_INPUT && last_use[p->steps[i].input] == i)
+            values[p->steps[p->steps[i].input].buffer] = -1;
+        if(p->steps[i].residual != PLAN_INPUT && last_use[p->steps[i].residual] == i)
+            values[p->steps[p->steps[i].residual].buffer] = -1;
+    }
+    
+    p->buffers = (float**)malloc(sizeof(float*)*p->n_buffers);
+    for(i = 0; i < p->n_buffers; i++){
+        p->buffers[i] = (float*)calloc(p->buffer_sizes[i],sizeof(float));
+    }
+    free(last_use);
+    free(values);
+}
+
+/* This function compiles a model for the feed forward, see plan_tensor_input_ff.
+ * The model can have fully-connected layers with FULLY_FEED_FORWARD, NO_DROPOUT or DROPOUT_TEST, with or without layer normalization,
+ * convolutional layers with CONVOLUTION or NO_CONVOLUTION, FULLY_FEED_FORWARD, any normalization and pooling, and residual layers.
+ * As in model_tensor_input_ff the DROPOUT_TEST of a layer is applied to the input of the next layer, so it is ignored on the last layer
+ * 
+ * Input:
+ *             @ model* m:= the model
+ *             @ int tensor_depth:= the depth of the input
+ *             @ int tensor_i:= the rows of the input
+ *             @ int tensor_j:= the columns of the input
+ * 
+ * Output:
+ *             @ inference_plan*:= the plan
+ * */
+inference_plan* compile_model(model* m, int tensor_depth, int tensor_i, int tensor_j){
+    if(m == NULL)
+        return NULL;
+    int i,z,count,k1 = 0,k2 = 0,k3 = 0,value = PLAN_INPUT,rl_input = PLAN_INPUT,size = tensor_depth*tensor_i*tensor_j;
+    fcl* f;
+    rl* r;
+    plan_step* s;
+    inference_plan* p = (inference_plan*)calloc(1,sizeof(inference_plan));
+    p->steps = (plan_step*)malloc(sizeof(plan_step)*2*m->layers);
+    p->input = size;
+    
+    for(i = 0; i < m->layers && m->sla[i][0]; i++){
+        if(m->layers > 1 && m->sla[i][1]){
+            fprintf(stderr,"Error: only the models with a layer for each row of sla can be compiled\n");
+            exit(1);
+        }
+        
+        if(m->sla[i][0] == FCLS){
+            f = m->fcls[k1];
+            if(f->input != size){
+                fprintf(stderr,"Error: the input of the fully-connected layer %d has %d floats instead of %d\n",f->layer,size,f->input);
+                exit(1);
+            }
+            if(f->feed_forward_flag != FULLY_FEED_FORWARD || f->dropout_flag == DROPOUT){
+                fprintf(stderr,"Error: only the fully-connected layers with FULLY_FEED_FORWARD and NO_DROPOUT or DROPOUT_TEST can be compiled\n");
+                exit(1);
+            }
+            if(f->activation_flag == SOFTMAX && i != m->layers-1 && m->sla[i+1][0] != 0){
+                fprintf(stderr,"Error: the softmax can be applied only on the last fully-connected layers\n");
+                exit(1);
+            }
+            s = add_plan_step(p,PLAN_FULLY_CONNECTED,value,f->output,f,NULL,NULL);
+            if(f->dropout_flag == DROPOUT_TEST && i != m->layers-1 && m->sla[i+1][0] != 0)
+                s->scale = f->dropout_threshold;
+            k1++;
+        }
+        
+        else if(m->sla[i][0] == CLS){
+            add_plan_convolutional_step(p,m->cls[k2],value,size);
+            k2++;
+        }
+        
+        else{
+            count = 0;
+            for(z = 0; z < m->n_rl && count <= k3; z++){
+                count+=m->rls[z]->n_cl;
+            }
+            z--;
+            count-=m->rls[z]->n_cl;
+            r = m->rls[z];
+            if(k3-count == 0)
+                rl_input = value;
+            add_plan_convolutional_step(p,r->cls[k3-count],value,size);
+            if(k3-count == r->n_cl-1){
+                if(r->cl_output->activation_flag == SOFTMAX || p->steps[p->n_steps-1].size != r->channels*r->input_rows*r->input_cols){
+                    fprintf(stderr,"Error: the residual layer of the convolutional layer %d can't be compiled\n",r->cls[k3-count]->layer);
+                    exit(1);
+                }
+                s = add_plan_step(p,PLAN_RESIDUAL,p->n_steps-1,p->steps[p->n_steps-1].size,NULL,NULL,r);
+                s->residual = rl_input;
+            }
+            k3++;
+        }
+        
+        value = p->n_steps-1;
+        size = p->steps[value].size;
+    }
+    
+    if(!p->n_steps){
+        fprintf(stderr,"Error: the model has no layers\n");
+        exit(1);
+    }
+    
+    p->output = size;
+    allocate_plan_buffers(p);
+    p->output_layer = p->buffers[p->steps[p->n_steps-1].buffer];
+    for(i = 0; i < p->n_steps; i++){
+        if(plan_step_workspace(&p->steps[i]) > p->workspace_size)
+            p->workspace_size = plan_step_workspace(&p->steps[i]);
+    }
+    if(p->workspace_size)
+        p->workspace = (float*)calloc(p->workspace_size,sizeof(float));
+    return p;
+}
+
+/* This function frees a plan, the model is not freed
+ * 
+ * Input:
+ *             @ inference_plan* p:= the plan
+ * */
+void free_inference_plan(inference_plan* p){
+    if(p == NULL)
+        return;
+    int i;
+    for(i = 0; i < p->n_buffers; i++){
+        free(p->buffers[i]);
+    }
+    free(p->buffers);
+    free(p->buffer_sizes);
+    free(p->steps);
+    free(p->workspace);
+    free(p);
+}
@@ -0,0 +1,45 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+#ifndef __INFERENCE_PLAN_H__
+#define __INFERENCE_PLAN_H__
+
+void add_bias_activation(float* input, float* bias, float* output, int size, int activation_flag);
+void add_scalar_bias_activation(float* input, float bias, float* output, int size, int activation_flag);
+int plan_fuses_pooling(cl* c);
+int plan_step_workspace(plan_step* s);
+void plan_pooling(cl* c, float* input, int rows, int cols, float* output);
+void plan_fully_connected_step(inference_plan* p, plan_step* s, float* input, float* output);
+void plan_convolutional_step(inference_plan* p, plan_step* s, float* input, float* output);
+float* get_plan_value(inference_plan* p, int step, float* input);
+void plan_tensor_input_ff(inference_plan* p, float* input);
+plan_step* add_plan_step(inference_plan* p, int type, int input, int size, fcl* f, cl* c, rl* r);
+void add_plan_convolutional_step(inference_plan* p, cl* c, int input, int input_size);
+void allocate_plan_buffers(inference_plan* p);
+inference_plan* compile_model(model* m, int tensor_depth, int tensor_i, int tensor_j);
+void free_inference_plan(inference_plan* p);
+
+#endif
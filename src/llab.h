@@ -38,6 +38,13 @@ SOFTWARE.
 #include <unistd.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/uio.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sched.h>
 
 #define N_NORMALIZATION 5
 #define BETA_NORMALIZATION 0.75
@@ -56,6 +63,11 @@ SOFTWARE.
 #define BNS 4
 #define LSTMS 1
 
+#define LSTM_CELL 0
+#define GRU_CELL 1
+#define LSTM_GATES 4
+#define GRU_GATES 3
+
 #define NO_ACTIVATION 0
 #define SIGMOID 1
 #define RELU 2
@@ -92,12 +104,20 @@ SOFTWARE.
 #define CONVOLUTION 2
 #define TRANSPOSED_CONVOLUTION 3
 
+#define AUTO_CONVOLUTION 0
+#define DIRECT_CONVOLUTION 1
+#define IM2COL_CONVOLUTION 2
+#define WINOGRAD_CONVOLUTION 3
+
 #define BATCH_NORMALIZATION_TRAINING_MODE 1
 #define BATCH_NORMALIZATION_FINAL_MODE 2
 
 #define STATEFUL 1
 #define STATELESS 2
 
+#define TBPTT_STORE 0
+#define TBPTT_CHECKPOINT 1
+
 #define LEAKY_RELU_THRESHOLD 0.1
 #define ELU_THRESHOLD 1
 
@@ -124,6 +144,72 @@ SOFTWARE.
 
 #define ONLY_DROPOUT 5
 
+#define SGEMM_AUTO 0
+#define SGEMM_SCALAR 1
+#define SGEMM_SSE2 2
+#define SGEMM_AVX2 3
+#define SGEMM_AVX512 4
+#define SGEMM_L2_FLOATS 32768 // floats of the right operand kept in cache by each block of the sgemm kernels
+
+#define ARENA_SLOTS 6 // params, partial derivatives, d1, d2, d3, ex_d_diff_grad
+#define ARENA_PARAMS 0
+#define ARENA_DERIVATIVES 1
+#define ARENA_D1 2
+#define ARENA_D2 3
+#define ARENA_D3 4
+#define ARENA_EX_D_DIFF_GRAD 5
+#define ARENA_ALIGNMENT 64 // bytes, each slot of an arena starts on a cache line
+
+#define FP32_PRECISION 0 // the activations and the copies of the weights of a batched model are stored as float
+#define BF16_PRECISION 1 // ... as bfloat16 (8 bits of exponent, 7 bits of mantissa), the master weights stay float
+#define FP16_PRECISION 2 // ... as ieee half precision (5 bits of exponent, 10 bits of mantissa), the master weights stay float
+#define HALF_PANEL_FLOATS 8192 // floats of a 16 bits right operand widened at once by sgemm_nt_half and sgemm_nn_half
+#define BMODEL_SCRATCH 5 // pre_activation, post_activation, dropout_temp, temp and temp3 of a batched model
+#define LOSS_SCALE_GROWTH 2 // the loss scale is multiplied by it after growth_interval steps without overflows
+#define LOSS_SCALE_BACKOFF 0.5 // the loss scale is multiplied by it after an overflow
+#define LOSS_SCALE_MIN 1 // the loss scale never goes below it
+#define QUANTIZED_MAX 127 // the int8 weights and inputs of a quantized model are in [-QUANTIZED_MAX,QUANTIZED_MAX]
+#define QUANTIZED_SHIFT 128 // the int8 inputs are shifted by it to unsigned bytes by the vnni kernels of qgemm_nt and qgemm_packed
+#define QGEMM_COLUMNS 16 // the rows of the right operand packed by qgemm_pack_b are padded to a multiple of it
+#define QGEMM_GROUPS 64 // groups of 4 columns of the left operand widened at once by the avx2 kernel of qgemm_packed
+#define QLAYER_SHAPE 23 // the integer fields of a qlayer saved in a .qbin file
+
+#define PLAN_FULLY_CONNECTED 1 // matrix vector product, biases, activation, layer normalization and dropout scaling of a fcl
+#define PLAN_CONVOLUTION 2 // convolution, biases, activation, normalization and pooling of a cl
+#define PLAN_RESIDUAL 3 // sum of the input of a rl with the output of its last cl and activation of rl->cl_output
+#define PLAN_INPUT -1 // the value read by a step is the input of the plan
+
+#define RING_SEGMENT 16384 // floats sent by each write of a ring all-reduce, the received segments are summed while the next ones arrive
+#define RING_CONNECTION_ATTEMPTS 200 // attempts to connect to the next worker of the ring
+#define RING_CONNECTION_DELAY 50000 // microseconds between two attempts
+
+#define MESSAGE_MAGIC 0x42414c4c // the first field of a message_header, "LLAB"
+#define MESSAGE_VECTOR 1 // the payload of the message is a float vector
+#define MESSAGE_CLOSE 2 // the sender closes the connection, no payload
+#define MESSAGE_HELLO 3 // the compression asked by a client and the one accepted by the server, 2 floats: type and ratio
+#define MESSAGE_COMPRESSED 4 // the payload is a vector compressed by compress_vector
+#define MESSAGE_PULL 5 // a client of a parameter server asks the params, no payload
+#define MESSAGE_PUSH 6 // a client of a parameter server sends the partial derivatives computed with the params of the version in the step
+#define MESSAGE_SOCKET_BUFFER 4194304 // bytes of the kernel send and receive buffers of the sockets
+
+#define COMPRESSION_NONE 0 // the vectors are sent as floats
+#define COMPRESSION_FP16 1 // half precision floats
+#define COMPRESSION_INT8 2 // 8 bits stochastic quantization with a scale each COMPRESSION_BLOCK floats
+#define COMPRESSION_1BIT 3 // 1 bit stochastic quantization with a scale each COMPRESSION_BLOCK floats
+#define COMPRESSION_TOPK 4 // the values with the largest magnitude and their indices
+#define COMPRESSION_BLOCK 256 // floats sharing the scale of COMPRESSION_INT8 and COMPRESSION_1BIT
+#define COMPRESSION_SAMPLE 8192 // the values sampled to estimate the threshold of COMPRESSION_TOPK
+#define COMPRESSION_FP16_MAX 65504 // the largest finite half precision float, COMPRESSION_FP16 clamps the values to it
+
+#define PARAMETER_SERVER_ASYNC -1 // staleness of a parameter server without bound: the clients never wait
+
+#define SHARED_TRAINER_PAGE 4096 // bytes, the regions and the shards of a shared_trainer segment start on a page, placed by the first process writing them
+
+#define OPTIMIZER_CHUNK 16384 // floats of the arena updated by each task of update_params_arena_multicore
+#define OPTIMIZER_SPAN_UPDATE 1 // the span is updated by the optimizer
+#define OPTIMIZER_SPAN_L2 2 // the l2 regularization is added to the partial derivatives of the span
+#define OPTIMIZER_SPAN_NORM 4 // the span is part of the norm of the gradient clipping and it is clipped
+
 // Neat hyperparams
 #define SPECIES_THERESHOLD 3
 #define INITIAL_POPULATION 100
@@ -264,6 +350,13 @@ typedef struct cl { //convolutional-layers
     float* d1_scores;//for edge-popup algorithm,n_kernels*channels*kernel_rows*kernel_cols
     float* d2_scores;//for edge-popup algorithm,n_kernels*channels*kernel_rows*kernel_cols
     float* d3_scores;//for edge-popup algorithm,n_kernels*channels*kernel_rows*kernel_cols
+    int convolution_algorithm;//AUTO_CONVOLUTION, DIRECT_CONVOLUTION, IM2COL_CONVOLUTION, WINOGRAD_CONVOLUTION
+    float* convolution_workspace;//allocated at the first use of IM2COL_CONVOLUTION, im2col_workspace_size floats
+    int winograd_tile;//2 for F(2x2,3x3), 4 for F(4x4,3x3)
+    int winograd_cache_flag;//1 if winograd_kernels and winograd_kernels_bp are computed from the current kernels
+    float* winograd_kernels;//allocated at the first use of WINOGRAD_CONVOLUTION, winograd_kernels_size floats
+    float* winograd_kernels_bp;//allocated at the first use of WINOGRAD_CONVOLUTION, winograd_kernels_size floats
+    float* winograd_workspace;//allocated at the first use of WINOGRAD_CONVOLUTION, winograd_workspace_size floats
     
 } cl;
 
@@ -274,8 +367,10 @@ typedef struct rl { //residual-layers
     cl** cls;
 } rl;
 
-typedef struct lstm { //long short term memory layers
+typedef struct lstm { //long short term memory layers, or gated recurrent units when cell_type = GRU_CELL
     int size,layer,dropout_flag_up, dropout_flag_right, window, residual_flag, norm_flag, n_grouped_cell;//dropout flag = 1 if dropout must be applied
+    int cell_type;// LSTM_CELL or GRU_CELL
+    int n_gates;// LSTM_GATES (f,i,o,c) or GRU_GATES (z,r,n), every 4 below is n_gates
     float** w;// 4 x size*size
     float** u;// 4 x size*size
     float** d_w;// 4 x size*size
@@ -294,17 +389,30 @@ typedef struct lstm { //long short term memory layers
     float** d1_biases; //4 x size
     float** d2_biases; //4 x size
     float** d3_biases; //4 x size
-    float*** lstm_z; //window x 4 x size
+    float*** lstm_z; //window x 4 x size, for a gru the activated z,r,n gates
     float** lstm_hidden; //window x size
-    float** lstm_cell; //window x size
+    float** lstm_cell; //window x size, for a gru the recurrent part of the n gate before the reset, Un*h
     float* dropout_mask_up;//size
     float* dropout_mask_right;//size
     float** out_up;//window x size
+    float* x_window;//window x size, the inputs of the window packed in a matrix
+    float* zx;//window x 4*size, w*x+b of the 4 gates for the whole window
+    float* h_right;//size, the hidden state coming from the left cell after the dropout
+    float* h_window;//window x size (2*window x size for a gru), workspace of the back propagation: the hidden states used by the recurrent products, then the errors of the inputs
+    float* bp_temp;//4*size, workspace of the back propagation
+    float** dfioc;//4 x size, the errors of the first timestep written by the back propagation, see bp_lstm_window and bp_gru_window
     float dropout_threshold_up;
     float dropout_threshold_right;
     bn** bns;//window/n_grouped_cell
 } lstm;
 
+typedef struct params_arena {// one contiguous aligned buffer for each slot, the layers point inside it
+    int size;// floats of each slot
+    int params_size;// the first params_size floats of each slot are the weights and biases, the others are scores, layer normalization and so on
+    float* memory;// ARENA_SLOTS slots, each one aligned to ARENA_ALIGNMENT bytes
+    float* slots[ARENA_SLOTS];
+} params_arena;
+
 typedef struct model {
     int layers, n_rl, n_cl, n_fcl,error_flag,output_dimension;
     float error_threshold1;
@@ -320,8 +428,32 @@ typedef struct model {
     fcl** fcls; // fcls = fully-connected-layers
     int** sla; //layers*layers, 1 for fcls, 2 for cls, 3 for rls, sla = sequential layers array
     float* output_layer;// will be the last array
+    params_arena* arena;// NULL if each layer owns its params, see make_model_contiguous
+    int shared_params_flag;// 1 if the params belong to another model, see share_model
 } model;
 
+typedef struct bmodel {// batched execution of a model, the weights are shared with m and the activations are batch_size*features
+    int batch_size;
+    model* m;// the model that owns weights, partial derivatives and the optimizer arrays
+    model** prefix;// batch_size, the convolutional and residual layers of m sharing the params with m, NULL if m starts with a fully-connected layer
+    float* input;// batch_size*fcls[0]->input
+    float* error;// batch_size*fcls[n_fcl-1]->output
+    float** error_rows;// batch_size, the rows of error2[0] passed to the prefix models
+    float** outputs;// n_fcl, the output of each fully-connected layer (one among pre_activation, post_activation, dropout_temp)
+    float** pre_activation;// n_fcl x batch_size*output
+    float** post_activation;// n_fcl x batch_size*output
+    float** dropout_mask;// n_fcl x batch_size*output
+    float** dropout_temp;// n_fcl x batch_size*output
+    float** temp;// n_fcl x batch_size*output
+    float** temp3;// n_fcl x batch_size*output
+    float** error2;// n_fcl x batch_size*input
+    int precision;// FP32_PRECISION, BF16_PRECISION or FP16_PRECISION, see batch_model_precision
+    unsigned short** weights_half;// n_fcl x output*input, 16 bits copy of the weights of m used by the gemms, NULL with FP32_PRECISION
+    unsigned short** pre_activation_half;// n_fcl x batch_size*output, the pre activations kept for the back propagation (all the layers but the last), NULL with FP32_PRECISION
+    unsigned short** outputs_half;// n_fcl x batch_size*output, the outputs kept for the back propagation (all the layers but the last), NULL with FP32_PRECISION
+    float** scratch;// 2*BMODEL_SCRATCH x batch_size*output, the float arrays shared by the layers but the last one with 16 bits precision, NULL with FP32_PRECISION
+} bmodel;
+
 typedef struct rmodel {
     int layers, n_lstm, window, hidden_state_mode, error_flag, output_dimension;
     float error_threshold1;
@@ -334,8 +466,46 @@ typedef struct rmodel {
     float** error;
     lstm** lstms;
     int** sla;
+    params_arena* arena;// NULL if each layer owns its params, see make_rmodel_contiguous
+    int shared_params_flag;// 1 if the params belong to another rmodel, see share_rmodel
+    float** error_window;// window x size, workspace of bp_rmodel_workspace
+    float** error_window2;// window x size, workspace of bp_rmodel_workspace
 } rmodel;
 
+typedef struct brmodel {// batched execution of a rmodel, the weights are shared with m and the states of the batch are (window*batch_size)*size matrices, the row t*batch_size+b is the timestep t of the sequence b
+    int batch_size, window, size, layers, ff_flag;// ff_flag is 1 after a feed forward, used to carry the states in STATEFUL mode
+    rmodel* m;// the rmodel that owns weights, partial derivatives and the optimizer arrays
+    float* input;// (window*batch_size)*size
+    float* error;// (window*batch_size)*size
+    float* input_error;// (window*batch_size)*size, the error of the inputs after the back propagation
+    float** hidden_states;// layers x batch_size*size, the hidden states before the first timestep
+    float** cell_states;// layers x batch_size*size, the cell states before the first timestep
+    float** hidden_states_error;// layers x batch_size*size, dL/dh of the hidden states before the first timestep
+    float** cell_states_error;// layers x batch_size*size, dL/dc of the cell states before the first timestep
+    float** z;// layers x (window*batch_size)*4*size, the pre activated outputs, each row is z_f, z_i, z_o, z_c
+    float** dz;// layers x (window*batch_size)*4*size, dL/dz
+    float** hidden;// layers x (window*batch_size)*size
+    float** cell;// layers x (window*batch_size)*size
+    float** h_right;// layers x (window*batch_size)*size, the hidden states passed to the next timestep after the dropout
+    float** out_up;// layers x (window*batch_size)*size, the hidden states passed to the next layer after the dropout
+    float** d_out_up;// layers x (window*batch_size)*size, dL/d out_up
+    float** dropout_mask_up;// layers x batch_size*size
+    float** dropout_mask_right;// layers x batch_size*size
+    float* dh;// batch_size*size
+    float* dc;// batch_size*size
+} brmodel;
+
+typedef struct srmodel {// streaming of long sequences through a STATEFUL rmodel in chunks of window timesteps, with truncated back propagation through time: k1 = window, k2 = n_chunks*window
+    int batch_size, n_chunks, memory_flag, head, count;// memory_flag: TBPTT_STORE or TBPTT_CHECKPOINT, head: the slot of the next chunk, count: the chunks available for the back propagation
+    rmodel* m;// the rmodel that owns weights, partial derivatives and the optimizer arrays
+    brmodel** chunks;// n_chunks with TBPTT_STORE (the activations of the last chunks), 1 with TBPTT_CHECKPOINT (the activations are recomputed)
+    float** inputs;// n_chunks x (window*batch_size)*size, the inputs of the last chunks, only with TBPTT_CHECKPOINT
+    float*** hidden_states;// n_chunks x layers x batch_size*size, the hidden states before the last chunks, only with TBPTT_CHECKPOINT
+    float*** cell_states;// n_chunks x layers x batch_size*size, the cell states before the last chunks, only with TBPTT_CHECKPOINT
+    float** hidden_states_carry;// layers x batch_size*size, the hidden states after the last chunk
+    float** cell_states_carry;// layers x batch_size*size, the cell states after the last chunk
+} srmodel;
+
 typedef struct recurrent_enc_dec {
     rmodel* encoder;
     rmodel* decoder;
@@ -343,13 +513,41 @@ typedef struct recurrent_enc_dec {
     float beta1_adam;
     float beta2_adam;
     float beta3_adamod;
-    float* flatten_fcl_input;//encoder->size*(encoder->window+1)
+    float* flatten_fcl_input;//encoder->size*(encoder->window+1), the outputs of the encoder (the values of the attention)
     float** output_encoder;//encoder->window x encoder->size
-    float** hiddens;//decoder->window x encoder->size
+    float** hiddens;//decoder->window x encoder->size, the queries of the attention, contiguous
     float** output_error_encoder;//encoder->window x decoder->size
-    float** softmax_array;//decoder->window x encoder->window
+    float** softmax_array;//decoder->window x encoder->window, contiguous
+    float* attention_keys;//encoder->window, the values projected by the attention weights, see attention.c
+    float* attention_scores;//decoder->window*encoder->window, the scores after the tanh
+    float* attention_scores_error;//decoder->window*encoder->window
+    float* attention_contexts_error;//decoder->window*encoder->size
+    float* attention_values_error;//encoder->window*encoder->size
+    float* attention_query_error;//encoder->size
+    float* attention_temp;//encoder->window
 }recurrent_enc_dec;
 
+typedef struct rstep {// a rmodel computed one timestep at a time, only the states after the last timestep are kept, see rmodel_step
+    int t;// the timesteps computed since the last reset
+    rmodel* m;
+    float** hidden_states;// layers x size, the hidden states after the last timestep
+    float** cell_states;// layers x size, the cell states after the last timestep
+    float** outputs;// layers x size, the outputs of the layers after the dropout and the residual connections
+    float** zx;// layers x 4*size, w*x+b of the 4 gates
+    float*** z;// layers x 4 x size, the pre activated outputs
+    float* h_right;// size, the hidden state passed to the next timestep after the dropout
+} rstep;
+
+typedef struct edstep {// a recurrent_enc_dec decoded one timestep at a time, see decode_recurrent_enc_dec_step
+    recurrent_enc_dec* rec;
+    rstep* decoder;// the decoder computed one timestep at a time
+    float* encoder_outputs;// (encoder->window+1)*encoder->size, the cached outputs of the encoder followed by the query of the attention
+    float* keys;// encoder->window, the keys of the attention computed once for each sequence
+    float* scores;// encoder->window, the scores of the attention
+    float* attention;// encoder->window, the softmax of the scores
+    float* input;// decoder->size, the context of the attention followed by the input of the decoder
+} edstep;
+
 typedef struct vaemodel{
     int latent_size;
     float* z;
@@ -404,6 +602,192 @@ typedef struct thread_args_server {
     struct sockaddr_in* client_addr;
 } thread_args_server;
 
+typedef struct thread_args_reduction {
+    float** sum;// the arrays where the partial derivatives are summed
+    float*** replicas;// replicas[i] are the arrays of the partial derivatives of the i-th replica
+    int* sizes;
+    int n_segments,n_replicas,reset_flag;
+    long long int start,end;// the shard of the concatenated arrays handled by the thread
+} thread_args_reduction;
+
+typedef struct optimizer_span {// a piece of the slots of a params_arena updated in a single sweep
+    int offset,size,flags;// flags: OPTIMIZER_SPAN_UPDATE | OPTIMIZER_SPAN_L2 | OPTIMIZER_SPAN_NORM
+} optimizer_span;
+
+typedef struct optimizer_step {// the hyperparameters of a single step of the optimizer
+    int gradient_descent_flag, mini_batch_size;
+    float lr, momentum, beta1, beta2, beta3;
+    float b1, b2;// beta1^t, beta2^t
+    float l2;// lambda/total_number_weights, 0 if there is no l2 regularization
+    float clip;// threshold/||DL/Dw|| of the gradient clipping, 1 if the gradient is not clipped
+    unsigned long long int t;
+} optimizer_step;
+
+typedef struct thread_args_optimizer {
+    params_arena* arena;
+    optimizer_step* step;
+    optimizer_span span;// the piece of the arena handled by the thread
+    float sum;// the sum of the squared partial derivatives of the piece, computed by params_norm_thread
+} thread_args_optimizer;
+
+typedef struct loss_scaler {// dynamic loss scaling of mixed precision training, see mixed_precision.c
+    float scale;// the errors of the outputs are multiplied by scale and the partial derivatives divided by scale
+    int growth_interval;// scale grows after growth_interval steps without overflows
+    int good_steps;// steps without overflows since the last change of scale
+    int skipped_steps;// the steps skipped because of an overflow
+} loss_scaler;
+
+typedef struct qlayer {// a fully-connected or convolutional layer with int8 weights, see quantized_model.c
+    int layer_type;// FCLS or CLS
+    int convolutional_flag;// CONVOLUTION or NO_CONVOLUTION (only pooling) for the convolutional layers
+    int activation_flag, pooling_flag;
+    int input, output;// floats of the input and of the output of the layer
+    int n_rows, n_cols;// the weights are n_rows x n_cols: output x input or n_kernels x channels*kernel_rows*kernel_cols
+    int channels, input_rows, input_cols, kernel_rows, kernel_cols, stride1, padding1, rows1, cols1;
+    int pooling_rows, pooling_cols, stride2, padding2, rows2, cols2;
+    float input_scale;// the input x is quantized as round(x/input_scale), calibrated on a sample set
+    float output_scale;// the output is multiplied by it, the dropout_threshold of DROPOUT_TEST, 1 otherwise
+    signed char* weights;// n_rows*n_cols
+    float* weight_scales;// n_rows, the row r of the weights is weights[r*n_cols+j]*weight_scales[r]
+    int* weight_sums;// n_rows, the sums of the rows of weights, not saved
+    float* biases;// n_rows
+} qlayer;
+
+typedef struct qmodel {// the int8 inference copy of a sequential model, see quantized_model.c
+    int n_layers, input, output;
+    qlayer** layers;
+    float* buffer1;// the outputs of the even layers
+    float* buffer2;// the outputs of the odd layers
+    float* conv_output;// the output of a convolution before the pooling
+    signed char* quantized_input;
+    signed char* packed_col;// the patches of a quantized input unrolled and packed by im2col_int8_packed
+    int* accumulators;// the int32 results of qgemm_nt
+    float* output_layer;// buffer1 or buffer2, the output of the last layer
+} qmodel;
+
+typedef struct plan_step {// a fused step of an inference_plan, see inference_plan.c
+    int type;// PLAN_FULLY_CONNECTED, PLAN_CONVOLUTION or PLAN_RESIDUAL
+    int input;// the step whose output is read, or PLAN_INPUT
+    int residual;// the step whose output is summed by PLAN_RESIDUAL (the input of the rl), or PLAN_INPUT
+    int buffer;// the buffer of the output
+    int size;// floats of the output
+    int fused_pooling;// 1 if the activation of a cl is computed after the max pooling
+    float scale;// the output of a fcl is multiplied by it, the dropout_threshold of DROPOUT_TEST, 1 otherwise
+    fcl* f;
+    cl* c;
+    rl* r;
+} plan_step;
+
+typedef struct inference_plan {// a model compiled for the feed forward, see inference_plan.c
+    int n_steps, n_buffers, input, output, workspace_size;
+    plan_step* steps;
+    float** buffers;// the outputs of the steps, a buffer is reused when its value is not read anymore
+    int* buffer_sizes;
+    float* workspace;// im2col, gemm and pre pooling arrays of a step
+    float* output_layer;// the buffer of the last step
+} inference_plan;
+
+typedef struct message_header {// the header of a framed message sent by server.c and client.c, see message.c
+    unsigned int magic;// MESSAGE_MAGIC
+    unsigned int type;// MESSAGE_VECTOR, MESSAGE_COMPRESSED, MESSAGE_HELLO, MESSAGE_PULL, MESSAGE_PUSH or MESSAGE_CLOSE
+    unsigned int step;// the step of the training, the answer to a message has the same step
+    unsigned int checksum;// crc32c of the payload
+    unsigned long long int length;// bytes of the payload
+} message_header;
+
+typedef struct compressor {// the compression of the vectors sent by a client, see compression.c
+    int type;// COMPRESSION_NONE, COMPRESSION_FP16, COMPRESSION_INT8, COMPRESSION_1BIT or COMPRESSION_TOPK
+    int size;// floats of the vectors
+    float ratio;// the fraction of the values sent by COMPRESSION_TOPK
+    unsigned long long int seed;// the state of the random numbers of the stochastic rounding
+    float* residual;// what the previous compressions lost, added to the next vector (error feedback)
+    float* workspace;// size floats
+} compressor;
+
+typedef struct ring {// a worker of a ring all-reduce over tcp, see ring_all_reduce.c
+    int rank, n_workers;
+    int listen_socket;
+    int next_socket;// the connection to the worker rank+1
+    int previous_socket;// the connection from the worker rank-1
+    float* segment;// RING_SEGMENT floats received before being summed
+    pthread_t thread;// the all-reduce started by ring_all_reduce_start
+    float* vector;// the vector of the all-reduce started by ring_all_reduce_start
+    int size;
+} ring;
+
+typedef struct parameter_server {// an asynchronous parameter server with bounded staleness, see parameter_server.c
+    model* m;// the model updated by the pushes of the clients
+    int size;// floats of the params
+    int n_clients;
+    int staleness;// the pushes a client can be ahead of the slowest client, 0 is synchronous, PARAMETER_SERVER_ASYNC no bound
+    float lr, momentum, b1, b2;
+    int mini_batch_size, gradient_descent_flag;
+    unsigned long long int t;
+    unsigned int version;// the updates applied to the params
+    int* clocks;// the pushes of each client
+    int* active;// 0 once the client closed the connection
+    int max_gap;// the largest gap between a client and the slowest one seen by a pull
+    unsigned long long int total_staleness;// sum of the staleness of the pushes
+    pthread_mutex_t lock;
+    pthread_cond_t clock_changed;
+} parameter_server;
+
+typedef struct thread_args_parameter_server {
+    parameter_server* ps;
+    int idx, client_desc;
+} thread_args_parameter_server;
+
+typedef struct shared_trainer_header {// the beginning of the shared memory segment of a shared_trainer
+    pthread_barrier_t barrier;// shared between the processes
+    int n_workers;
+    int size;// floats of each region
+    long long int stride;// floats between two regions
+} shared_trainer_header;
+
+typedef struct shared_trainer {// a worker of the data parallel training of a model between processes of one host, see shared_trainer.c
+    char* name;// the name of the POSIX shared memory segment
+    pid_t owner;// the process that created the segment, free_shared_trainer called by it removes the segment
+    int rank;// -1 until join_shared_trainer
+    int n_workers;
+    int size;// floats of the arena slots of the model
+    long long int stride;// floats between two regions, a multiple of a page
+    long long int start, end;// the shard summed and updated by this worker
+    size_t length;// bytes of the segment
+    shared_trainer_header* header;
+    float* regions;// ARENA_SLOTS regions (the master params, the summed partial derivatives and the optimizer arrays) and the partial derivatives of each worker
+    params_arena master;// its slots are the first ARENA_SLOTS regions
+    optimizer_span* spans;// the spans of the update inside the shard
+    int n_spans;
+} shared_trainer;
+
+typedef struct thread_pool_task {
+    void* (*function)(void*);
+    void* args;
+} thread_pool_task;
+
+typedef struct thread_pool_queue {
+    pthread_mutex_t lock;
+    thread_pool_task* tasks;
+    int size,head,tail;// the queued tasks are tasks[head:tail]
+} thread_pool_queue;
+
+typedef struct thread_args_pool {
+    struct thread_pool* pool;
+    int index;
+} thread_args_pool;
+
+typedef struct thread_pool {
+    int threads,next_queue,shutdown;
+    int queued,pending;// tasks not taken yet, tasks not finished yet
+    pthread_t* workers;
+    thread_args_pool* workers_args;
+    thread_pool_queue* queues;// queues[0] belongs to the thread that waits, queues[i] to workers[i-1]
+    pthread_mutex_t lock;
+    pthread_cond_t work_available;
+    pthread_cond_t work_done;
+    struct thread_pool* next;// the next shared pool, see get_shared_thread_pool
+} thread_pool;
+
 typedef struct ddpg {
     int batch_size,regularization1,regularization2,n_weights1,n_weights2,index,m1_input,m1_output,m2_output,m3_output;
     int gradient_descent_flag1, gradient_descent_flag2,threads,max_frames,buff_size;
@@ -461,9 +845,13 @@ typedef struct training{
     float** floats;
 }training;
 
+#include "attention.h"
+#include "batch_model.h"
 #include "batch_norm_layers.h"
+#include "batch_rmodel.h"
 #include "client.h"
 #include "clipping_gradient.h"
+#include "compression.h"
 #include "convolutional.h"
 #include "convolutional_layers.h"
 #include "dictionary.h"
@@ -471,7 +859,11 @@ typedef struct training{
 #include "fully_connected.h"
 #include "fully_connected_layers.h"
 #include "gd.h"
+#include "gemm.h"
+#include "inference_plan.h"
 #include "math_functions.h"
+#include "message.h"
+#include "mixed_precision.h"
 #include "model.h"
 #include "multi_core_model.h"
 #include "multi_core_recurrent_enc_dec.h"
@@ -479,15 +871,24 @@ typedef struct training{
 #include "multi_core_vae_model.h"
 #include "neat_functions.h"
 #include "normalization.h"
+#include "parameter_server.h"
+#include "params_arena.h"
 #include "parser.h"
+#include "quantized_model.h"
 #include "recurrent.h"
 #include "recurrent_encoder_decoder.h"
 #include "recurrent_layers.h"
 #include "residual_layers.h"
+#include "ring_all_reduce.h"
 #include "rmodel.h"
+#include "rmodel_step.h"
 #include "server.h"
+#include "shared_trainer.h"
+#include "stream_rmodel.h"
+#include "thread_pool.h"
 #include "training.h"
 #include "utils.h"
 #include "vae_model.h"
+#include "winograd.h"
 
 #endif
@@ -41,7 +41,7 @@ void derivative_softmax_array(int* input, float* output,float* softmax_arr,float
     
     for(j = 0; j < size; j++){
         for(i = 0; i < size; i++){
-            if(input[i] && input[j]){
+            if(input == NULL || (input[i] && input[j])){
                 if (i == j)
                     output[j] += (softmax_arr[i]*(1-softmax_arr[j]))*error[i];
                 else
@@ -0,0 +1,257 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+#include "llab.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MESSAGE_X86
+#endif
+
+/* The framed messages of server.c and client.c: a message_header (magic, type, step, crc32c checksum and length of the payload)
+ * followed by the payload. The header and the payload are written and read with loops until all the bytes are transferred,
+ * a single read or write of a socket can move only a part of a large vector. The reads block until the data arrives,
+ * so an idle connection doesn't use the cpu, and a closed connection is reported to the caller.
+ * The fields of the header are in the byte order of the machine, as the floats of the payload
+ * */
+
+unsigned int crc32c_table[256];
+// the table is built once by the first thread that needs it, the server receives from several threads at the same time
+pthread_once_t crc32c_table_once = PTHREAD_ONCE_INIT;
+
+/* This function reads size bytes from a socket or a pipe, waiting for all of them
+ * 
+ * Input:
+ *             @ int fd:= the socket or the pipe
+ *             @ void* buffer:= where the bytes are written, dimensions: size
+ *             @ long long int size:= the bytes to read
+ * 
+ * Output:
+ *             @ int:= 0 if the bytes are read, -1 if the connection is closed or there is an error
+ * */
+int read_all(int fd, void* buffer, long long int size){
+    long long int n, done = 0;
+    while(done < size){
+        n = read(fd,(char*)buffer+done,size-done);
+        if(n == -1 && errno == EINTR)
+            continue;
+        if(n <= 0)
+            return -1;
+        done+=n;
+    }
+    return 0;
+}
+
+/* This function writes size bytes on a socket or a pipe, waiting for all of them.
+ * A socket closed by the other side doesn't raise SIGPIPE
+ * 
+ * Input:
+ *             @ int fd:= the socket or the pipe
+ *             @ void* buffer:= the bytes, dimensions: size
+ *             @ long long int size:= the bytes to write
+ * 
+ * Output:
+ *             @ int:= 0 if the bytes are written, -1 if the connection is closed or there is an error
+ * */
+int write_all(int fd, void* buffer, long long int size){
+    long long int n, done = 0;
+    while(done < size){
+        n = send(fd,(char*)buffer+done,size-done,MSG_NOSIGNAL);
+        if(n == -1 && errno == ENOTSOCK)
+            n = write(fd,(char*)buffer+done,size-done);
+        if(n == -1 && errno == EINTR)
+            continue;
+        if(n <= 0)
+            return -1;
+        done+=n;
+    }
+    return 0;
+}
+
+/* This function sets the options of a connected tcp socket used to send vectors: no Nagle delay for the small messages
+ * and MESSAGE_SOCKET_BUFFER bytes for the kernel buffers
+ * 
+ * Input:
+ *             @ int fd:= the socket
+ * */
+void set_socket_options(int fd){
+    int c = 1, size = MESSAGE_SOCKET_BUFFER;
+    setsockopt(fd,IPPROTO_TCP,TCP_NODELAY,&c,sizeof(int));
+    setsockopt(fd,SOL_SOCKET,SO_SNDBUF,&size,sizeof(int));
+    setsockopt(fd,SOL_SOCKET,SO_RCVBUF,&size,sizeof(int));
+}
+
+/* This function builds the table of crc32c_scalar, it is called once with pthread_once*/
+void crc32c_init_table(){
+    int i,j;
+    unsigned int value;
+    for(i = 0; i < 256; i++){
+        value = i;
+        for(j = 0; j < 8; j++){
+            value = value&1 ? (value>>1)^0x82f63b78 : value>>1;
+        }
+        crc32c_table[i] = value;
+    }
+}
+
+/* This function computes the crc32c (castagnoli polynomial) of a buffer one byte at a time
+ * 
+ * Input:
+ *             @ unsigned int crc:= the crc of the previous bytes, 0 for the first ones
+ *             @ void* buffer:= the bytes, dimensions: size
+ *             @ long long int size:= the bytes
+ * 
+ * Output:
+ *             @ unsigned int:= the crc
+ * */
+unsigned int crc32c_scalar(unsigned int crc, void* buffer, long long int size){
+    long long int i;
+    unsigned char* bytes = (unsigned char*)buffer;
+    pthread_once(&crc32c_table_once,crc32c_init_table);
+    crc = ~crc;
+    for(i = 0; i < size; i++){
+        crc = crc32c_table[(crc^bytes[i])&0xff]^(crc>>8);
+    }
+    return ~crc;
+}
+
+#ifdef MESSAGE_X86
+__attribute__((target("sse4.2")))
+unsigned int crc32c_sse42(unsigned int crc, void* buffer, long long int size){
+    long long int i = 0;
+    unsigned long long int value, c = ~crc;
+    unsigned char* bytes = (unsigned char*)buffer;
+    #if defined(__x86_64__)
+    for(; i+8 <= size; i+=8){
+        memcpy(&value,&bytes[i],8);
+        c = _mm_crc32_u64(c,value);
+    }
+    #endif
+    for(; i < size; i++){
+        c = _mm_crc32_u8((unsigned int)c,bytes[i]);
+    }
+    return ~(unsigned int)c;
+}
+#endif
+
+/* This function computes the checksum of the payload of a message, the crc32c with the crc32 instruction of sse4.2 if available
+ * 
+ * Input:
+ *             @ void* buffer:= the bytes, dimensions: size
+ *             @ long long int size:= the bytes
+ * 
+ * Output:
+ *             @ unsigned int:= the checksum
+ * */
+unsigned int message_checksum(void* buffer, long long int size){
+    #ifdef MESSAGE_X86
+    if(get_sgemm_instruction_set() >= SGEMM_SSE2 && __builtin_cpu_supports("sse4.2"))
+        return crc32c_sse42(0,buffer,size);
+    #endif
+    return crc32c_scalar(0,buffer,size);
+}
+
+/* This function sends a message: the header and the payload are passed to the kernel together
+ * and the writes are repeated until all the bytes are sent
+ * 
+ * Input:
+ *             @ int fd:= the socket
+ *             @ int type:= MESSAGE_VECTOR or MESSAGE_CLOSE
+ *             @ unsigned int step:= the step of the message
+ *             @ void* payload:= the payload, can be NULL if length is 0, dimensions: length
+ *             @ long long int length:= the bytes of the payload
+ * 
+ * Output:
+ *             @ int:= 0 if the message is sent, -1 if the connection is closed or there is an error
+ * */
+int send_message(int fd, int type, unsigned int step, void* payload, long long int length){
+    long long int n, sent = 0, size = sizeof(message_header)+length;
+    message_header header;
+    struct iovec io[2];
+    struct msghdr msg;
+    memset(&header,0,sizeof(message_header));
+    header.magic = MESSAGE_MAGIC;
+    header.type = type;
+    header.step = step;
+    header.checksum = message_checksum(payload,length);
+    header.length = length;
+    while(sent < size){
+        memset(&msg,0,sizeof(msg));
+        msg.msg_iov = io;
+        if(sent < (long long int)sizeof(message_header)){
+            io[0].iov_base = (char*)&header+sent;
+            io[0].iov_len = sizeof(message_header)-sent;
+            io[1].iov_base = payload;
+            io[1].iov_len = length;
+            msg.msg_iovlen = length ? 2 : 1;
+        }
+        else{
+            io[0].iov_base = (char*)payload+sent-sizeof(message_header);
+            io[0].iov_len = size-sent;
+            msg.msg_iovlen = 1;
+        }
+        n = sendmsg(fd,&msg,MSG_NOSIGNAL);
+        if(n == -1 && errno == EINTR)
+            continue;
+        if(n <= 0)
+            return -1;
+        sent+=n;
+    }
+    return 0;
+}
+
+/* This function receives a message, waiting for all its bytes. The header is checked: a wrong magic number,
+ * a payload larger than max_length or a wrong checksum are errors. After an error the stream can't be trusted
+ * anymore (the next header can't be found), so the caller must drop the connection, the process goes on
+ * 
+ * Input:
+ *             @ int fd:= the socket
+ *             @ message_header* header:= where the header is written
+ *             @ void* payload:= where the payload is written, dimensions: max_length
+ *             @ long long int max_length:= the maximum bytes of the payload
+ * 
+ * Output:
+ *             @ int:= 0 if the message is received, -1 if the connection is closed or there is an error
+ * */
+int recv_message(int fd, message_header* header, void* payload, long long int max_length){
+    if(read_all(fd,header,sizeof(message_header)) == -1)
+        return -1;
+    if(header->magic != MESSAGE_MAGIC){
+        fprintf(stderr,"Error: the message has a wrong magic number, the other side doesn't use the same protocol\n");
+        return -1;
+    }
+    if(header->length > (unsigned long long int)max_length){
+        fprintf(stderr,"Error: the message has %llu bytes, but at most %lld bytes are expected\n",header->length,max_length);
+        return -1;
+    }
+    if(read_all(fd,payload,header->length) == -1)
+        return -1;
+    if(message_checksum(payload,header->length) != header->checksum){
+        fprintf(stderr,"Error: the message of the step %u is corrupted, wrong checksum\n",header->step);
+        return -1;
+    }
+    return 0;
+}
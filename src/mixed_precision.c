@@ -0,0 +1,421 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include "llab.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MIXED_PRECISION_X86
+#endif
+
+/* Mixed precision training: the batched models (bmodel) can keep the copies of the weights used by the gemms
+ * and the activations stored for the back propagation in 16 bits (bfloat16 or ieee half precision), while the master
+ * weights, the partial derivatives and the arrays of the optimizers stay float, as every accumulation.
+ * The errors of the outputs are multiplied by a loss scale before the back propagation and the partial derivatives are divided
+ * by it before the update, so the small errors are not flushed to zero. The checkpoints are always saved as float
+ * */
+
+/* This function converts a float to bfloat16, rounding to the nearest even
+ * 
+ * Input:
+ *             @ float x:= the float
+ * 
+ * Output:
+ *             @ unsigned short:= the bfloat16
+ * */
+unsigned short float_to_bf16(float x){
+    unsigned int u;
+    memcpy(&u,&x,sizeof(float));
+    if((u & 0x7fffffff) > 0x7f800000)
+        return (unsigned short)((u >> 16) | 0x40);// quiet nan
+    u += 0x7fff + ((u >> 16) & 1);
+    return (unsigned short)(u >> 16);
+}
+
+/* This function converts a bfloat16 to float
+ * 
+ * Input:
+ *             @ unsigned short x:= the bfloat16
+ * 
+ * Output:
+ *             @ float:= the float
+ * */
+float bf16_to_float(unsigned short x){
+    unsigned int u = ((unsigned int)x) << 16;
+    float f;
+    memcpy(&f,&u,sizeof(float));
+    return f;
+}
+
+/* This function converts a float to ieee half precision, rounding to the nearest even.
+ * The floats out of range become infinities, the small ones subnormals or zero
+ * 
+ * Input:
+ *             @ float x:= the float
+ * 
+ * Output:
+ *             @ unsigned short:= the half precision float
+ * */
+unsigned short float_to_fp16(float x){
+    unsigned int u,sign;
+    float f;
+    memcpy(&u,&x,sizeof(float));
+    sign = (u >> 16) & 0x8000;
+    u &= 0x7fffffff;
+    if(u > 0x7f800000)// quiet nan, the high bits of the payload are kept as f16c does
+        return (unsigned short)(sign | 0x7e00 | ((u >> 13) & 0x3ff));
+    if(u == 0x7f800000)
+        return (unsigned short)(sign | 0x7c00);
+    if(u >= 0x477ff000)// rounds to inf
+        return (unsigned short)(sign | 0x7c00);
+    if(u < 0x38800000){// subnormal or zero, x*2^24 rounded to the nearest even
+        memcpy(&f,&u,sizeof(float));
+        return (unsigned short)(sign | (unsigned int)lrintf(f*16777216.0f));
+    }
+    u += 0xc8000fff + ((u >> 13) & 1);// exponent rebias and rounding
+    return (unsigned short)(sign | (u >> 13));
+}
+
+/* This function converts an ieee half precision float to float
+ * 
+ * Input:
+ *             @ unsigned short x:= the half precision float
+ * 
+ * Output:
+ *             @ float:= the float
+ * */
+float fp16_to_float(unsigned short x){
+    unsigned int sign = ((unsigned int)(x & 0x8000)) << 16, e = (x >> 10) & 0x1f, m = x & 0x3ff, u;
+    float f;
+    if(e == 0){
+        f = (float)m/16777216.0f;
+        return sign ? -f : f;
+    }
+    if(e == 31)
+        u = sign | 0x7f800000 | (m << 13);
+    else
+        u = sign | ((e + 112) << 23) | (m << 13);
+    memcpy(&f,&u,sizeof(float));
+    return f;
+}
+
+void float_to_bf16_array_scalar(float* x, unsigned short* y, int size){
+    int i;
+    for(i = 0; i < size; i++){
+        y[i] = float_to_bf16(x[i]);
+    }
+}
+
+void bf16_to_float_array_scalar(unsigned short* x, float* y, int size){
+    int i;
+    for(i = 0; i < size; i++){
+        y[i] = bf16_to_float(x[i]);
+    }
+}
+
+void float_to_fp16_array_scalar(float* x, unsigned short* y, int size){
+    int i;
+    for(i = 0; i < size; i++){
+        y[i] = float_to_fp16(x[i]);
+    }
+}
+
+void fp16_to_float_array_scalar(unsigned short* x, float* y, int size){
+    int i;
+    for(i = 0; i < size; i++){
+        y[i] = fp16_to_float(x[i]);
+    }
+}
+
+#ifdef MIXED_PRECISION_X86
+
+/* the same rounding of float_to_bf16, 8 floats at a time*/
+__attribute__((target("avx2")))
+void float_to_bf16_array_avx2(float* x, unsigned short* y, int size){
+    int i;
+    __m256i u,nan,r;
+    __m256 v;
+    const __m256i bias = _mm256_set1_epi32(0x7fff);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i quiet = _mm256_set1_epi32(0x40);
+    for(i = 0; i+8 <= size; i+=8){
+        v = _mm256_loadu_ps(&x[i]);
+        u = _mm256_castps_si256(v);
+        nan = _mm256_castps_si256(_mm256_cmp_ps(v,v,_CMP_UNORD_Q));
+        r = _mm256_add_epi32(u,_mm256_add_epi32(bias,_mm256_and_si256(_mm256_srli_epi32(u,16),one)));
+        r = _mm256_blendv_epi8(_mm256_srli_epi32(r,16),_mm256_or_si256(_mm256_srli_epi32(u,16),quiet),nan);
+        _mm_storeu_si128((__m128i*)&y[i],_mm_packus_epi32(_mm256_castsi256_si128(r),_mm256_extracti128_si256(r,1)));
+    }
+    float_to_bf16_array_scalar(&x[i],&y[i],size-i);
+}
+
+__attribute__((target("avx2")))
+void bf16_to_float_array_avx2(unsigned short* x, float* y, int size){
+    int i;
+    for(i = 0; i+8 <= size; i+=8){
+        _mm256_storeu_ps(&y[i],_mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i*)&x[i])),16)));
+    }
+    bf16_to_float_array_scalar(&x[i],&y[i],size-i);
+}
+
+__attribute__((target("avx2,f16c")))
+void float_to_fp16_array_f16c(float* x, unsigned short* y, int size){
+    int i;
+    for(i = 0; i+8 <= size; i+=8){
+        _mm_storeu_si128((__m128i*)&y[i],_mm256_cvtps_ph(_mm256_loadu_ps(&x[i]),_MM_FROUND_TO_NEAREST_INT));
+    }
+    float_to_fp16_array_scalar(&x[i],&y[i],size-i);
+}
+
+__attribute__((target("avx2,f16c")))
+void fp16_to_float_array_f16c(unsigned short* x, float* y, int size){
+    int i;
+    for(i = 0; i+8 <= size; i+=8){
+        _mm256_storeu_ps(&y[i],_mm256_cvtph_ps(_mm_loadu_si128((__m128i*)&x[i])));
+    }
+    fp16_to_float_array_scalar(&x[i],&y[i],size-i);
+}
+
+#endif
+
+/* This function converts an array of floats to bfloat16, with avx2 if the cpu supports it
+ * 
+ * Input:
+ *             @ float* x:= the floats, dimensions: size
+ *             @ unsigned short* y:= where the bfloat16 are stored, dimensions: size
+ *             @ int size:= the size of the arrays
+ * */
+void float_to_bf16_array(float* x, unsigned short* y, int size){
+    #ifdef MIXED_PRECISION_X86
+    if(get_sgemm_instruction_set() >= SGEMM_AVX2){
+        float_to_bf16_array_avx2(x,y,size);
+        return;
+    }
+    #endif
+    float_to_bf16_array_scalar(x,y,size);
+}
+
+/* This function converts an array of bfloat16 to floats, with avx2 if the cpu supports it
+ * 
+ * Input:
+ *             @ unsigned short* x:= the bfloat16, dimensions: size
+ *             @ float* y:= where the floats are stored, dimensions: size
+ *             @ int size:= the size of the arrays
+ * */
+void bf16_to_float_array(unsigned short* x, float* y, int size){
+    #ifdef MIXED_PRECISION_X86
+    if(get_sgemm_instruction_set() >= SGEMM_AVX2){
+        bf16_to_float_array_avx2(x,y,size);
+        return;
+    }
+    #endif
+    bf16_to_float_array_scalar(x,y,size);
+}
+
+/* This function converts an array of floats to half precision, with f16c if the cpu supports it
+ * 
+ * Input:
+ *             @ float* x:= the floats, dimensions: size
+ *             @ unsigned short* y:= where the half precision floats are stored, dimensions: size
+ *             @ int size:= the size of the arrays
+ * */
+void float_to_fp16_array(float* x, unsigned short* y, int size){
+    #ifdef MIXED_PRECISION_X86
+    if(get_sgemm_instruction_set() >= SGEMM_AVX2 && __builtin_cpu_supports("f16c")){
+        float_to_fp16_array_f16c(x,y,size);
+        return;
+    }
+    #endif
+    float_to_fp16_array_scalar(x,y,size);
+}
+
+/* This function converts an array of half precision floats to floats, with f16c if the cpu supports it
+ * 
+ * Input:
+ *             @ unsigned short* x:= the half precision floats, dimensions: size
+ *             @ float* y:= where the floats are stored, dimensions: size
+ *             @ int size:= the size of the arrays
+ * */
+void fp16_to_float_array(unsigned short* x, float* y, int size){
+    #ifdef MIXED_PRECISION_X86
+    if(get_sgemm_instruction_set() >= SGEMM_AVX2 && __builtin_cpu_supports("f16c")){
+        fp16_to_float_array_f16c(x,y,size);
+        return;
+    }
+    #endif
+    fp16_to_float_array_scalar(x,y,size);
+}
+
+/* This function converts an array of floats to 16 bits
+ * 
+ * Input:
+ *             @ int precision:= BF16_PRECISION or FP16_PRECISION
+ *             @ float* x:= the floats, dimensions: size
+ *             @ unsigned short* y:= where the 16 bits floats are stored, dimensions: size
+ *             @ int size:= the size of the arrays
+ * */
+void float_to_half_array(int precision, float* x, unsigned short* y, int size){
+    if(precision == BF16_PRECISION)
+        float_to_bf16_array(x,y,size);
+    else if(precision == FP16_PRECISION)
+        float_to_fp16_array(x,y,size);
+    else{
+        fprintf(stderr,"Error: unknown 16 bits precision\n");
+        exit(1);
+    }
+}
+
+/* This function converts an array of 16 bits floats to floats
+ * 
+ * Input:
+ *             @ int precision:= BF16_PRECISION or FP16_PRECISION
+ *             @ unsigned short* x:= the 16 bits floats, dimensions: size
+ *             @ float* y:= where the floats are stored, dimensions: size
+ *             @ int size:= the size of the arrays
+ * */
+void half_to_float_array(int precision, unsigned short* x, float* y, int size){
+    if(precision == BF16_PRECISION)
+        bf16_to_float_array(x,y,size);
+    else if(precision == FP16_PRECISION)
+        fp16_to_float_array(x,y,size);
+    else{
+        fprintf(stderr,"Error: unknown 16 bits precision\n");
+        exit(1);
+    }
+}
+
+/* This function creates a dynamic loss scaler
+ * 
+ * Input:
+ *             @ float scale:= the initial loss scale, for example 65536
+ *             @ int growth_interval:= the number of steps without overflows after which the scale grows, for example 2000
+ * 
+ * Output:
+ *             @ loss_scaler*:= the loss scaler
+ * */
+loss_scaler* init_loss_scaler(float scale, int growth_interval){
+    if(scale < LOSS_SCALE_MIN || growth_interval < 1){
+        fprintf(stderr,"Error: the loss scale must be >= %d and the growth interval > 0\n",LOSS_SCALE_MIN);
+        exit(1);
+    }
+    loss_scaler* s = (loss_scaler*)malloc(sizeof(loss_scaler));
+    s->scale = scale;
+    s->growth_interval = growth_interval;
+    s->good_steps = 0;
+    s->skipped_steps = 0;
+    return s;
+}
+
+/* This function frees a loss scaler
+ * 
+ * Input:
+ *             @ loss_scaler* s:= the loss scaler
+ * */
+void free_loss_scaler(loss_scaler* s){
+    free(s);
+}
+
+/* This function multiplies the error of the outputs by the loss scale, before the back propagation
+ * 
+ * Input:
+ *             @ loss_scaler* s:= the loss scaler
+ *             @ float* error:= the error, dimensions: size
+ *             @ int size:= the size of the error
+ * */
+void scale_loss_error(loss_scaler* s, float* error, int size){
+    mul_value(error,s->scale,error,size);
+}
+
+/* This function divides the partial derivatives of a list of tensors by the loss scale and updates the scale.
+ * If a partial derivative is not finite all the partial derivatives are set to 0, the scale is reduced and the
+ * optimizer step must be skipped, otherwise after growth_interval good steps the scale grows
+ * 
+ * Input:
+ *             @ loss_scaler* s:= the loss scaler
+ *             @ float*** tensors:= n*ARENA_SLOTS, the slots of the tensors as filled by get_arena_tensors_model
+ *             @ int* sizes:= n, the sizes of the tensors
+ *             @ int n:= the number of tensors
+ * 
+ * Output:
+ *             @ int:= 1 if the optimizer step can be done, 0 if it must be skipped
+ * */
+int unscale_partial_derivatives(loss_scaler* s, float*** tensors, int* sizes, int n){
+    int i,j,finite = 1;
+    float inv = 1.0/s->scale;
+    float* d;
+    for(i = 0; i < n && finite; i++){
+        d = *tensors[i*ARENA_SLOTS+ARENA_DERIVATIVES];
+        for(j = 0; j < sizes[i]; j++){
+            if(!isfinite(d[j])){
+                finite = 0;
+                break;
+            }
+        }
+    }
+    
+    for(i = 0; i < n; i++){
+        d = *tensors[i*ARENA_SLOTS+ARENA_DERIVATIVES];
+        if(finite)
+            mul_value(d,inv,d,sizes[i]);
+        else
+            memset(d,0,sizeof(float)*sizes[i]);
+    }
+    
+    if(!finite){
+        s->scale *= LOSS_SCALE_BACKOFF;
+        if(s->scale < LOSS_SCALE_MIN)
+            s->scale = LOSS_SCALE_MIN;
+        s->good_steps = 0;
+        s->skipped_steps++;
+        return 0;
+    }
+    s->good_steps++;
+    if(s->good_steps == s->growth_interval){
+        s->scale *= LOSS_SCALE_GROWTH;
+        s->good_steps = 0;
+    }
+    return 1;
+}
+
+/* This function divides the partial derivatives of a model by the loss scale, see unscale_partial_derivatives.
+ * It must be called after the back propagation (and the sum of the partial derivatives of the batch) and before the update
+ * 
+ * Input:
+ *             @ loss_scaler* s:= the loss scaler
+ *             @ model* m:= the model
+ * 
+ * Output:
+ *             @ int:= 1 if the optimizer step can be done, 0 if it must be skipped
+ * */
+int unscale_model_partial_derivatives(loss_scaler* s, model* m){
+    int n = get_arena_tensors_model(m,NULL,NULL,NULL);
+    float*** tensors = (float***)malloc(sizeof(float**)*n*ARENA_SLOTS);
+    int* sizes = (int*)malloc(sizeof(int)*n);
+    get_arena_tensors_model(m,tensors,sizes,NULL);
+    int ret = unscale_partial_derivatives(s,tensors,sizes,n);
+    free(tensors);
+    free(sizes);
+    return ret;
+}
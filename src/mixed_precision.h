@@ -0,0 +1,49 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef __MIXED_PRECISION_H__
+#define __MIXED_PRECISION_H__
+
+unsigned short float_to_bf16(float x);
+float bf16_to_float(unsigned short x);
+unsigned short float_to_fp16(float x);
+float fp16_to_float(unsigned short x);
+void float_to_bf16_array_scalar(float* x, unsigned short* y, int size);
+void bf16_to_float_array_scalar(unsigned short* x, float* y, int size);
+void float_to_fp16_array_scalar(float* x, unsigned short* y, int size);
+void fp16_to_float_array_scalar(unsigned short* x, float* y, int size);
+void float_to_bf16_array(float* x, unsigned short* y, int size);
+void bf16_to_float_array(unsigned short* x, float* y, int size);
+void float_to_fp16_array(float* x, unsigned short* y, int size);
+void fp16_to_float_array(unsigned short* x, float* y, int size);
+void float_to_half_array(int precision, float* x, unsigned short* y, int size);
+void half_to_float_array(int precision, unsigned short* x, float* y, int size);
+loss_scaler* init_loss_scaler(float scale, int growth_interval);
+void free_loss_scaler(loss_scaler* s);
+void scale_loss_error(loss_scaler* s, float* error, int size);
+int unscale_partial_derivatives(loss_scaler* s, float*** tensors, int* sizes, int n);
+int unscale_model_partial_derivatives(loss_scaler* s, model* m);
+
+#endif
@@ -235,6 +235,9 @@ model* network(int layers, int n_rl, int n_cl, int n_fcl, rl** rls, cl** cls, fc
         else
             m->output_layer = m->rls[m->n_rl-1]->cl_output->pre_activation;
     }
+    
+    m->arena = NULL;
+    m->shared_params_flag = 0;
         
     return m;
 }
@@ -248,8 +251,14 @@ model* network(int layers, int n_rl, int n_cl, int n_fcl, rl** rls, cl** cls, fc
 void free_model(model* m){
     if(m == NULL)
         return;
+    if(m->shared_params_flag){
+        free_shared_model(m);
+        return;
+    }
     int i;
     
+    free_model_arena(m);
+    
     for(i = 0; i < m->n_rl; i++){
         free_residual(m->rls[i]);
     }
@@ -314,6 +323,116 @@ model* copy_model(model* m){
     return copy;
 }
 
+/* This function creates a replica of m that shares the weights, the biases and the optimizer arrays with m.
+ * The replica owns only the arrays used during the feed forward, the back propagation and its partial derivatives,
+ * so it can be used as a batch replica: after the partial derivatives of the replicas are summed in m
+ * and m is updated, the replicas see the new weights and paste_model(m,replica) doesn't copy anything.
+ * The winograd kernels of a replica are invalidated by reset_model (also when called by sum_models_partial_derivatives_multicore)
+ * and by paste_model, so one of them must be called between the update of m and the next feed forward of the replica.
+ * If m must be contiguous (see make_model_contiguous) it must be made contiguous before creating its replicas.
+ * The replica must not be updated and can be deallocated with free_model or free_shared_model
+ * 
+ * Input:
+ *         
+ *             @ model* m:= the model that owns the params
+ * 
+ * */
+model* share_model(model* m){
+    if(m == NULL)
+        return NULL;
+    int i;
+    
+    fcl** fcls = NULL;
+    if(m->fcls!=NULL)
+        fcls = (fcl**)malloc(sizeof(fcl*)*m->n_fcl);
+    cl** cls = NULL;
+    if(m->cls!=NULL)
+        cls = (cl**)malloc(sizeof(cl*)*m->n_cl);
+    rl** rls = NULL;
+    if(m->rls!=NULL)
+        rls = (rl**)malloc(sizeof(rl*)*m->n_rl);
+    for(i = 0; i < m->n_fcl; i++){
+        fcls[i] = share_fcl(m->fcls[i]);
+    }
+    for(i = 0; i < m->n_cl; i++){
+        cls[i] = share_cl(m->cls[i]);
+    }
+    for(i = 0; i < m->n_rl; i++){
+        rls[i] = share_rl(m->rls[i]);
+    }
+    model* s = network(m->layers, m->n_rl, m->n_cl, m->n_fcl, rls, cls, fcls);
+    if(m->error!=NULL)
+        set_model_error(s,m->error_flag,m->error_threshold1,m->error_threshold2,m->error_gamma,m->error_alpha,m->output_dimension);
+    
+    s->beta1_adam = m->beta1_adam;
+    s->beta2_adam = m->beta2_adam;
+    s->beta3_adamod = m->beta3_adamod;
+    s->shared_params_flag = 1;
+    return s;
+}
+
+/* This function frees the space allocated by a model created with share_model, the shared arrays are not freed
+ * 
+ * Input:
+ *         
+ *             @ model* m:= the shared model
+ * 
+ * */
+void free_shared_model(model* m){
+    if(m == NULL)
+        return;
+    int i;
+    
+    for(i = 0; i < m->n_rl; i++){
+        free_shared_rl(m->rls[i]);
+    }
+    free(m->rls);
+    for(i = 0; i < m->n_cl; i++){
+        free_shared_cl(m->cls[i]);
+    }
+    free(m->cls);
+    for(i = 0; i < m->n_fcl; i++){
+        free_shared_fcl(m->fcls[i]);
+    }
+    free(m->fcls);
+    for(i = 0; i < m->layers; i++){
+        free(m->sla[i]);
+    }
+    free(m->sla);
+    free(m->error);
+    free(m->error_alpha);
+    free(m);
+}
+
+/* This function returns 1 if s has been created with share_model(m), 0 otherwise
+ * 
+ * Input:
+ *         
+ *             @ model* m:= the model that could own the params
+ *             @ model* s:= the model that could share the params of m
+ * 
+ * */
+int model_shares_params(model* m, model* s){
+    if(m == NULL || s == NULL || !s->shared_params_flag || m->n_fcl != s->n_fcl || m->n_cl != s->n_cl || m->n_rl != s->n_rl)
+        return 0;
+    int i,j;
+    for(i = 0; i < m->n_fcl; i++){
+        if(m->fcls[i]->weights != s->fcls[i]->weights)
+            return 0;
+    }
+    for(i = 0; i < m->n_cl; i++){
+        if(m->cls[i]->biases != s->cls[i]->biases)
+            return 0;
+    }
+    for(i = 0; i < m->n_rl; i++){
+        for(j = 0; j < m->rls[i]->n_cl; j++){
+            if(m->rls[i]->cls[j]->biases != s->rls[i]->cls[j]->biases)
+                return 0;
+        }
+    }
+    return 1;
+}
+
 
 
 /* This function copies a model using the paste function for the layers
@@ -328,6 +447,15 @@ model* copy_model(model* m){
 void paste_model(model* m, model* copy){
     if(m == NULL)
         return;
+    if(model_shares_params(m,copy)){
+        invalidate_model_winograd_kernels(copy);
+        return;
+    }
+    if(model_state_lives_in_arena(m) && same_params_arena(m->arena,copy->arena)){
+        paste_params_arena(m->arena,copy->arena);
+        invalidate_model_winograd_kernels(copy);
+        return;
+    }
     int i;
     for(i = 0; i < m->n_fcl; i++){
         paste_fcl(m->fcls[i],copy->fcls[i]);
@@ -398,6 +526,10 @@ void slow_paste_model(model* m, model* copy, float tau){
 model* reset_model(model* m){
     if(m == NULL)
         return NULL;
+    if(m->arena != NULL){
+        reset_params_arena_partial_derivatives(m->arena);
+        return reset_model_except_partial_derivatives(m);
+    }
     int i;
     for(i = 0; i < m->n_fcl; i++){
         reset_fcl(m->fcls[i]);
@@ -417,6 +549,35 @@ model* reset_model(model* m){
     return m;
 }
 
+/* This function resets a model like reset_model, except for the partial derivatives of the layers
+ * that are left untouched, it is used when the partial derivatives are zeroed by someone else
+ * (for example sum_models_partial_derivatives_multicore)
+ * */
+model* reset_model_except_partial_derivatives(model* m){
+    if(m == NULL)
+        return NULL;
+    int i;
+    // the params could have been updated by the model that owns them
+    if(m->shared_params_flag)
+        invalidate_model_winograd_kernels(m);
+    for(i = 0; i < m->n_fcl; i++){
+        reset_fcl_except_partial_derivatives(m->fcls[i]);
+    }
+    for(i = 0; i < m->n_cl; i++){
+        reset_cl_except_partial_derivatives(m->cls[i]);
+    }
+    for(i = 0; i < m->n_rl; i++){
+        reset_rl_except_partial_derivatives(m->rls[i]);
+    }
+    
+    if(m->error != NULL){
+        for(i = 0; i < m->output_dimension; i++){
+            m->error[i] = 0;
+        }
+    }
+    return m;
+}
+
 
 /* this function compute the space allocated by the arrays of m
  * 
@@ -968,9 +1129,7 @@ void ff_fcl_cl(fcl* f1, cl* f2){
         if(f1->dropout_flag == NO_DROPOUT){
             if(f2->convolutional_flag == CONVOLUTION){
                 if(f2->feed_forward_flag == FULLY_FEED_FORWARD){
-                    for(i = 0; i < f2->n_kernels; i++){
-                        convolutional_feed_forward(f1->post_normalization, f2->kernels[i], f2->input_rows, f2->input_cols, f2->kernel_rows, f2->kernel_cols, f2->biases[i], f2->channels, &f2->pre_activation[i*f2->rows1*f2->cols1], f2->stride1_rows, f2->padding1_rows);
-                    }
+                    convolutional_layer_feed_forward(f2,f1->post_normalization);
                 }
                 else if(f2->feed_forward_flag == EDGE_POPUP){
                     convolutional_feed_forward_edge_popup(f1->post_normalization,f2->kernels, f2->input_rows, f2->input_cols, f2->kernel_rows, f2->kernel_cols, f2->biases, f2->channels, f2->pre_activation, f2->stride1_rows, f2->padding1_rows,f2->indices,f2->n_kernels,f2->n_kernels*f2->channels*f2->kernel_rows*f2->kernel_cols*f2->k_percentage);
@@ -995,9 +1154,7 @@ void ff_fcl_cl(fcl* f1, cl* f2){
             if(f1->dropout_flag == DROPOUT){
                 if(f2->convolutional_flag == CONVOLUTION){
                     if(f2->feed_forward_flag == FULLY_FEED_FORWARD){
-                        for(i = 0; i < f2->n_kernels; i++){
-                            convolutional_feed_forward(f1->dropout_temp, f2->kernels[i], f2->input_rows, f2->input_cols, f2->kernel_rows, f2->kernel_cols, f2->biases[i], f2->channels, &f2->pre_activation[i*f2->rows1*f2->cols1], f2->stride1_rows, f2->padding1_rows);
-                        }
+                        convolutional_layer_feed_forward(f2,f1->dropout_temp);
                     }
                     else if(f2->feed_forward_flag == EDGE_POPUP){
                         convolutional_feed_forward_edge_popup(f1->dropout_temp,f2->kernels, f2->input_rows, f2->input_cols, f2->kernel_rows, f2->kernel_cols, f2->biases, f2->channels, f2->pre_activation, f2->stride1_rows, f2->padding1_rows,f2->indices,f2->n_kernels,f2->n_kernels*f2->channels*f2->kernel_rows*f2->kernel_cols*f2->k_percentage);
@@ -1024,9 +1181,7 @@ void ff_fcl_cl(fcl* f1, cl* f2){
                 mul_value(f1->post_normalization,f1->dropout_threshold,f1->dropout_temp,f1->output);
                 if(f2->convolutional_flag == CONVOLUTION){
                     if(f2->feed_forward_flag == FULLY_FEED_FORWARD){
-                        for(i = 0; i < f2->n_kernels; i++){
-                            convolutional_feed_forward(f1->dropout_temp, f2->kernels[i], f2->input_rows, f2->input_cols, f2->kernel_rows, f2->kernel_cols, f2->biases[i], f2->channels, &f2->pre_activation[i*f2->rows1*f2->cols1], f2->stride1_rows, f2->padding1_rows);
-                        }
+                        convolutional_layer_feed_forward(f2,f1->dropout_temp);
                     }
                     else if(f2->feed_forward_flag == EDGE_POPUP){
                         convolutional_feed_forward_edge_popup(f1->dropout_temp,f2->kernels, f2->input_rows, f2->input_cols, f2->kernel_rows, f2->kernel_cols, f2->biases, f2->channels, f2->pre_activation, f2->stride1_rows, f2->padding1_rows,f2->indices,f2->n_kernels,f2->n_kernels*f2->channels*f2->kernel_rows*f2->kernel_cols*f2->k_percentage);
@@ -1057,9 +1212,7 @@ void ff_fcl_cl(fcl* f1, cl* f2){
         if(f1->dropout_flag == NO_DROPOUT){
             if(f2->convolutional_flag == CONVOLUTION){
                 if(f2->feed_forward_flag == FULLY_FEED_FORWARD){
-                    for(i = 0; i < f2->n_kernels; i++){
-                        convolutional_feed_forward(f1->pre_activation, f2->kernels[i], f2->input_rows, f2->input_cols, f2->kernel_rows, f2->kernel_cols, f2->biases[i], f2->channels, &f2->pre_activation[i*f2->rows1*f2->cols1], f2->stride1_rows, f2->padding1_rows);
-                    }
+                    convolutional_layer_feed_forward(f2,f1->pre_activation);
                 }
                 else if(f2->feed_forward_flag == EDGE_POPUP){
                     convolutional_feed_forward_edge_popup(f1->pre_activation,f2->kernels, f2->input_rows, f2->input_cols, f2->kernel_rows, f2->kernel_cols, f2->biases, f2->channels, f2->pre_activation, f2->stride1_rows, f2->padding1_rows,f2->indices,f2->n_kernels,f2->n_kernels*f2->channels*f2->kernel_rows*f2->kernel_cols*f2->k_percentage);
@@ -1084,9 +1237,7 @@ void ff_fcl_cl(fcl* f1, cl* f2){
             if(f1->dropout_flag == DROPOUT){
                 if(f2->convolutional_flag == CONVOLUTION){
                     if(f2->feed_forward_flag == FULLY_FEED_FORWARD){
-                        for(i = 0; i < f2->n_kernels; i++){
-                            convolutional_feed_forward(f1->dropout_temp, f2->kernels[i], f2->input_rows, f2->input_cols, f2->kernel_rows, f2->kernel_cols, f2->biases[i], f2->channels, &f2->pre_activation[i*f2->rows1*f2->cols1], f2->stride1_rows, f2->padding1_rows);
-                        }
+                        convolutional_layer_feed_forward(f2,f1->dropout_temp);
                     }
                     else if(f2->feed_forward_flag == EDGE_POPUP){
                         convolutional_feed_forward_edge_popup(f1->dropout_temp,f2->kernels, f2->input_rows, f2->input_cols, f2->kernel_rows, f2->kernel_cols, f2->biases, f2->channels, f2->pre_activation, f2->stride1_rows, f2->padding1_rows,f2->indices,f2->n_kernels,f2->n_kernels*f2->channels*f2->kernel_rows*f2->kernel_cols*f2->k_percentage);
@@ -1113,9 +1264,7 @@ void ff_fcl_cl(fcl* f1, cl* f2){
                 mul_value(f1->pre_activation,f1->dropout_threshold,f1->dropout_temp,f1->output);
                 if(f2->convolutional_flag == CONVOLUTION){
                     if(f2->feed_forward_flag == FULLY_FEED_FORWARD){
-                        for(i = 0; i < f2->n_kernels; i++){
-                            convolutional_feed_forward(f1->dropout_temp, f2->kernels[i], f2->input_rows, f2->input_cols, f2->kernel_rows, f2->kernel_cols, f2->biases[i], f2->channels, &f2->pre_activation[i*f2->rows1*f2->cols1], f2->stride1_rows, f2->padding1_rows);
-                        }
+                        convolutional_layer_feed_forward(f2,f1->dropout_temp);
                     }
                     else if(f2->feed_forward_flag == EDGE_POPUP){
                         convolutional_feed_forward_edge_popup(f1->dropout_temp,f2->kernels, f2->input_rows, f2->input_cols, f2->kernel_rows, f2->kernel_cols, f2->biases, f2->channels, f2->pre_activation, f2->stride1_rows, f2->padding1_rows,f2->indices,f2->n_kernels,f2->n_kernels*f2->channels*f2->kernel_rows*f2->kernel_cols*f2->k_percentage);
@@ -1146,9 +1295,7 @@ void ff_fcl_cl(fcl* f1, cl* f2){
         if(f1->dropout_flag == NO_DROPOUT){
             if(f2->convolutional_flag == CONVOLUTION){
                 if(f2->feed_forward_flag == FULLY_FEED_FORWARD){
-                    for(i = 0; i < f2->n_kernels; i++){
-                        convolutional_feed_forward(f1->post_activation, f2->kernels[i], f2->input_rows, f2->input_cols, f2->kernel_rows, f2->kernel_cols, f2->biases[i], f2->channels, &f2->pre_activation[i*f2->rows1*f2->cols1], f2->stride1_rows, f2->padding1_rows);
-                    }
+                    convolutional_layer_feed_forward(f2,f1->post_activation);
                 }
                 
                 else if(f2->feed_forward_flag == EDGE_POPUP){
@@ -1177,9 +1324,7 @@ void ff_fcl_cl(fcl* f1, cl* f2){
             if(f1->dropout_flag == DROPOUT){
                 if(f2->convolutional_flag == CONVOLUTION){
                     if(f2->feed_forward_flag == FULLY_FEED_FORWARD){
-                        for(i = 0; i < f2->n_kernels; i++){
-                            convolutional_feed_forward(f1->dropout_temp, f2->kernels[i], f2->input_rows, f2->input_cols, f2->kernel_rows, f2->kernel_cols, f2->biases[i], f2->channels, &f2->pre_activation[i*f2->rows1*f2->cols1], f2->stride1_rows, f2->padding1_rows);
-                        }
+                        convolutional_layer_feed_forward(f2,f1->dropout_temp);
                     }
                     else if(f2->feed_forward_flag == EDGE_POPUP){
                         convolutional_feed_forward_edge_popup(f1->dropout_temp,f2->kernels, f2->input_rows, f2->input_cols, f2->kernel_rows, f2->kernel_cols, f2->biases, f2->channels, f2->pre_activation, f2->stride1_rows, f2->padding1_rows,f2->indices,f2->n_kernels,f2->n_kernels*f2->channels*f2->kernel_rows*f2->kernel_cols*f2->k_percentage);
@@ -1204,9 +1349,7 @@ void ff_fcl_cl(fcl* f1, cl* f2){
                 mul_value(f1->post_activation,f1->dropout_threshold,f1->dropout_temp,f1->output);
                 if(f2->convolutional_flag == CONVOLUTION){
                     if(f2->feed_forward_flag == FULLY_FEED_FORWARD){
-                        for(i = 0; i < f2->n_kernels; i++){
-                            convolutional_feed_forward(f1->dropout_temp, f2->kernels[i], f2->input_rows, f2->input_cols, f2->kernel_rows, f2->kernel_cols, f2->biases[i], f2->channels, &f2->pre_activation[i*f2->rows1*f2->cols1], f2->stride1_rows, f2->padding1_rows);
-                        }
+                        convolutional_layer_feed_forward(f2,f1->dropout_temp);
                     }
                     else if(f2->feed_forward_flag == EDGE_POPUP){
                         convolutional_feed_forward_edge_popup(f1->dropout_temp,f2->kernels, f2->input_rows, f2->input_cols, f2->kernel_rows, f2->kernel_cols, f2->biases, f2->channels, f2->pre_activation, f2->stride1_rows, f2->padding1_rows,f2->indices,f2->n_kernels,f2->n_kernels*f2->channels*f2->kernel_rows*f2->kernel_cols*f2->k_percentage);
@@ -1572,9 +1715,7 @@ void ff_cl_cl(cl* f1, cl* f2){
     if(f1->pooling_flag){
         if(f2->convolutional_flag == CONVOLUTION){
             if(f2->feed_forward_flag == FULLY_FEED_FORWARD){
-                for(i = 0; i < f2->n_kernels; i++){
-                    convolutional_feed_forward(f1->post_pooling, f2->kernels[i], f2->input_rows, f2->input_cols, f2->kernel_rows, f2->kernel_cols, f2->biases[i], f2->channels, &f2->pre_activation[i*f2->rows1*f2->cols1], f2->stride1_rows, f2->padding1_rows);
-                }
+                convolutional_layer_feed_forward(f2,f1->post_pooling);
             }
             
             else if(f2->feed_forward_flag == EDGE_POPUP){
@@ -1603,9 +1744,7 @@ void ff_cl_cl(cl* f1, cl* f2){
     else if(f1->normalization_flag){
         if(f2->convolutional_flag == CONVOLUTION){
             if(f2->feed_forward_flag == FULLY_FEED_FORWARD){
-                for(i = 0; i < f2->n_kernels; i++){
-                    convolutional_feed_forward(f1->post_normalization, f2->kernels[i], f2->input_rows, f2->input_cols, f2->kernel_rows, f2->kernel_cols, f2->biases[i], f2->channels, &f2->pre_activation[i*f2->rows1*f2->cols1], f2->stride1_rows, f2->padding1_rows);
-                }
+                convolutional_layer_feed_forward(f2,f1->post_normalization);
             }
             else if(f2->feed_forward_flag == EDGE_POPUP){
                 convolutional_feed_forward_edge_popup(f1->post_normalization, f2->kernels, f2->input_rows, f2->input_cols, f2->kernel_rows, f2->kernel_cols, f2->biases, f2->channels, f2->pre_activation, f2->stride1_rows, f2->padding1_rows,f2->indices,f2->n_kernels,f2->n_kernels*f2->channels*f2->kernel_rows*f2->kernel_cols*f2->k_percentage);
@@ -1631,9 +1770,7 @@ void ff_cl_cl(cl* f1, cl* f2){
     else if(f1->activation_flag){
         if(f2->convolutional_flag == CONVOLUTION){
             if(f2->feed_forward_flag == FULLY_FEED_FORWARD){
-                for(i = 0; i < f2->n_kernels; i++){
-                    convolutional_feed_forward(f1->post_activation, f2->kernels[i], f2->input_rows, f2->input_cols, f2->kernel_rows, f2->kernel_cols, f2->biases[i], f2->channels, &f2->pre_activation[i*f2->rows1*f2->cols1], f2->stride1_rows, f2->padding1_rows);
-                }
+                convolutional_layer_feed_forward(f2,f1->post_activation);
             }
             else if(f2->feed_forward_flag == EDGE_POPUP){
                 convolutional_feed_forward_edge_popup(f1->post_activation, f2->kernels, f2->input_rows, f2->input_cols, f2->kernel_rows, f2->kernel_cols, f2->biases, f2->channels, f2->pre_activation, f2->stride1_rows, f2->padding1_rows,f2->indices,f2->n_kernels,f2->n_kernels*f2->channels*f2->kernel_rows*f2->kernel_cols*f2->k_percentage);
@@ -1659,9 +1796,7 @@ void ff_cl_cl(cl* f1, cl* f2){
     else{
         if(f2->convolutional_flag == CONVOLUTION){
             if(f2->feed_forward_flag == FULLY_FEED_FORWARD){
-                for(i = 0; i < f2->n_kernels; i++){
-                    convolutional_feed_forward(f1->pre_activation, f2->kernels[i], f2->input_rows, f2->input_cols, f2->kernel_rows, f2->kernel_cols, f2->biases[i], f2->channels, &f2->pre_activation[i*f2->rows1*f2->cols1], f2->stride1_rows, f2->padding1_rows);
-                }
+                convolutional_layer_feed_forward(f2,f1->pre_activation);
             }
             else if(f2->feed_forward_flag == EDGE_POPUP){
                 convolutional_feed_forward_edge_popup(f1->pre_activation, f2->kernels, f2->input_rows, f2->input_cols, f2->kernel_rows, f2->kernel_cols, f2->biases, f2->channels, f2->pre_activation, f2->stride1_rows, f2->padding1_rows,f2->indices,f2->n_kernels,f2->n_kernels*f2->channels*f2->kernel_rows*f2->kernel_cols*f2->k_percentage);
@@ -2224,9 +2359,7 @@ float* bp_fcl_cl(fcl* f1, cl* f2, float* error){
         /* computing the weight and bias derivatives for f2 applied to f1 output*/
         if(f1->dropout_flag){
             if((f2->training_mode == GRADIENT_DESCENT && f2->feed_forward_flag == FULLY_FEED_FORWARD) || f2->training_mode == FREEZE_TRAINING){
-                for(i = 0; i < f2->n_kernels; i++){
-                    convolutional_back_prop(f1->dropout_temp, f2->kernels[i], f2->input_rows,f2->input_cols,f2->kernel_rows,f2->kernel_cols,f2->biases[i],f2->channels,&f2->temp[i*f2->rows1*f2->cols1],f2->error2,f2->d_kernels[i], &f2->d_biases[i], f2->stride1_rows, f2->padding1_rows);                
-                }
+                convolutional_layer_back_prop(f2,f1->dropout_temp);
             }
             
             else if(f2->training_mode == GRADIENT_DESCENT && f2->feed_forward_flag == EDGE_POPUP){
@@ -2248,9 +2381,7 @@ float* bp_fcl_cl(fcl* f1, cl* f2, float* error){
             
             if(f1->normalization_flag){
                 if((f2->training_mode == GRADIENT_DESCENT && f2->feed_forward_flag == FULLY_FEED_FORWARD) || f2->training_mode == FREEZE_TRAINING){
-                    for(i = 0; i < f2->n_kernels; i++){
-                        convolutional_back_prop(f1->post_normalization, f2->kernels[i], f2->input_rows,f2->input_cols,f2->kernel_rows,f2->kernel_cols,f2->biases[i],f2->channels,&f2->temp[i*f2->rows1*f2->cols1],f2->error2,f2->d_kernels[i], &f2->d_biases[i], f2->stride1_rows, f2->padding1_rows);                
-                    }
+                    convolutional_layer_back_prop(f2,f1->post_normalization);
                 }
                 
                 else if(f2->training_mode == GRADIENT_DESCENT && f2->feed_forward_flag == EDGE_POPUP){
@@ -2271,9 +2402,7 @@ float* bp_fcl_cl(fcl* f1, cl* f2, float* error){
             
             else if(f1->activation_flag){
                 if((f2->training_mode == GRADIENT_DESCENT && f2->feed_forward_flag == FULLY_FEED_FORWARD) || f2->training_mode == FREEZE_TRAINING){
-                    for(i = 0; i < f2->n_kernels; i++){
-                        convolutional_back_prop(f1->post_activation, f2->kernels[i], f2->input_rows,f2->input_cols,f2->kernel_rows,f2->kernel_cols,f2->biases[i],f2->channels,&f2->temp[i*f2->rows1*f2->cols1],f2->error2,f2->d_kernels[i], &f2->d_biases[i], f2->stride1_rows, f2->padding1_rows);                
-                    }
+                    convolutional_layer_back_prop(f2,f1->post_activation);
                 }
                 
                 else if(f2->training_mode == GRADIENT_DESCENT && f2->feed_forward_flag == EDGE_POPUP){
@@ -2294,9 +2423,7 @@ float* bp_fcl_cl(fcl* f1, cl* f2, float* error){
             
             else{
                 if((f2->training_mode == GRADIENT_DESCENT && f2->feed_forward_flag == FULLY_FEED_FORWARD) || f2->training_mode == FREEZE_TRAINING){
-                    for(i = 0; i < f2->n_kernels; i++){
-                        convolutional_back_prop(f1->pre_activation, f2->kernels[i], f2->input_rows,f2->input_cols,f2->kernel_rows,f2->kernel_cols,f2->biases[i],f2->channels,&f2->temp[i*f2->rows1*f2->cols1],f2->error2,f2->d_kernels[i], &f2->d_biases[i], f2->stride1_rows, f2->padding1_rows);                
-                    }
+                    convolutional_layer_back_prop(f2,f1->pre_activation);
                 }
                 
                 else if(f2->training_mode == GRADIENT_DESCENT && f2->feed_forward_flag == EDGE_POPUP){
@@ -2722,16 +2849,14 @@ float* bp_cl_cl(cl* f1, cl* f2, float* error){
         /* computing the weight and bias derivatives for f2 applied to f1 output*/
         
         if((f2->training_mode == GRADIENT_DESCENT && f2->feed_forward_flag == FULLY_FEED_FORWARD) || f2->training_mode == FREEZE_TRAINING){
-            for(i = 0; i < f2->n_kernels; i++){
-                if(f1->pooling_flag)
-                    convolutional_back_prop(f1->post_pooling, f2->kernels[i], f2->input_rows,f2->input_cols,f2->kernel_rows,f2->kernel_cols,f2->biases[i],f2->channels,&f2->temp[i*f2->rows1*f2->cols1],f2->error2,f2->d_kernels[i], &f2->d_biases[i], f2->stride1_rows, f2->padding1_rows);                
-                else if(f1->normalization_flag)
-                    convolutional_back_prop(f1->post_normalization, f2->kernels[i], f2->input_rows,f2->input_cols,f2->kernel_rows,f2->kernel_cols,f2->biases[i],f2->channels,&f2->temp[i*f2->rows1*f2->cols1],f2->error2,f2->d_kernels[i], &f2->d_biases[i], f2->stride1_rows, f2->padding1_rows);                
-                else if(f1->activation_flag)
-                    convolutional_back_prop(f1->post_activation, f2->kernels[i], f2->input_rows,f2->input_cols,f2->kernel_rows,f2->kernel_cols,f2->biases[i],f2->channels,&f2->temp[i*f2->rows1*f2->cols1],f2->error2,f2->d_kernels[i], &f2->d_biases[i], f2->stride1_rows, f2->padding1_rows);                
-                else
-                    convolutional_back_prop(f1->pre_activation, f2->kernels[i], f2->input_rows,f2->input_cols,f2->kernel_rows,f2->kernel_cols,f2->biases[i],f2->channels,&f2->temp[i*f2->rows1*f2->cols1],f2->error2,f2->d_kernels[i], &f2->d_biases[i], f2->stride1_rows, f2->padding1_rows);                
-            }
+            if(f1->pooling_flag)
+                convolutional_layer_back_prop(f2,f1->post_pooling);
+            else if(f1->normalization_flag)
+                convolutional_layer_back_prop(f2,f1->post_normalization);
+            else if(f1->activation_flag)
+                convolutional_layer_back_prop(f2,f1->post_activation);
+            else
+                convolutional_layer_back_prop(f2,f1->pre_activation);
         }
         
         else if(f2->training_mode == GRADIENT_DESCENT && f2->feed_forward_flag == EDGE_POPUP){
@@ -3202,7 +3327,6 @@ void model_tensor_input_ff(model* m, int tensor_depth, int tensor_i, int tensor_
     
     /* Setting the input inside a convolutional structure*/
     cl* temp = (cl*)malloc(sizeof(cl));
-    temp->post_activation = (float*)malloc(sizeof(float)*tensor_depth*tensor_i*tensor_j);
     temp->normalization_flag = NO_NORMALIZATION;
     temp->pooling_flag = NO_POOLING;
     temp->activation_flag = SIGMOID;
@@ -3513,7 +3637,6 @@ float* model_tensor_input_bp(model* m, int tensor_depth, int tensor_i, int tenso
     
     /* Setting the input inside a convolutional structure*/
     cl* temp = (cl*)malloc(sizeof(cl));
-    temp->post_activation = (float*)malloc(sizeof(float)*tensor_depth*tensor_i*tensor_j);
     temp->normalization_flag = NO_NORMALIZATION;
     temp->pooling_flag = NO_POOLING;
     temp->activation_flag = SIGMOID;
@@ -3877,11 +4000,20 @@ int count_weights(model* m){
  *                @ int total_number_weights:= the number of total weights of the network (for l2 regularization)
  *                @ float lambda:= a float value for l2 regularization
  *                @ unsigned long long int* t:= the number of time that radam has been used
+ * 
+ * If the model has an arena (see make_model_contiguous) the update is done by update_model_multicore with a single sweep,
+ * the params are the same but the l2 regularization is not added to the partial derivatives
  * */
 void update_model(model* m, float lr, float momentum, int mini_batch_size, int gradient_descent_flag, float* b1, float* b2, int regularization, int total_number_weights, float lambda, unsigned long long int* t){
     if(m == NULL)
         return;
     
+    // with the arena the l2 regularization and the optimizer are applied with a single sweep
+    if(fused_update_supported_model(m)){
+        update_model_multicore(m,lr,momentum,mini_batch_size,gradient_descent_flag,b1,b2,regularization,total_number_weights,lambda,t,0,1);
+        return;
+    }
+    
     lambda*=(float)mini_batch_size;
     
     if(regularization == L2_REGULARIZATION){
@@ -3930,7 +4062,7 @@ void update_model(model* m, float lr, float momentum, int mini_batch_size, int g
         (*b2)*=m->beta2_adam;
     }
     
-
+    invalidate_model_winograd_kernels(m);
 }
 
 /* This function sum the partial derivatives in model m1 and m2 in m3
@@ -3947,6 +4079,10 @@ void sum_model_partial_derivatives(model* m, model* m2, model* m3){
         fprintf(stderr,"Error: passed NULL pointer as values in sum_model_partial_derivatives\n");
         exit(1);
     }
+    if(same_params_arena(m->arena,m2->arena) && same_params_arena(m->arena,m3->arena)){
+        sum_params_arena_partial_derivatives(m->arena,m2->arena,m3->arena);
+        return;
+    }
     sum_fully_connected_layers_partial_derivatives(m,m2,m3);
     sum_convolutional_layers_partial_derivatives(m,m2,m3);
     sum_residual_layers_partial_derivatives(m,m2,m3);
@@ -3986,6 +4122,11 @@ int get_array_size_params_model(model* f){
  *                 @ float* vector:= the vector where is copyed everything
  * */
 void memcopy_vector_to_params_model(model* f, float* vector){
+    if(f->arena != NULL){
+        copy_array(vector,f->arena->slots[ARENA_PARAMS],f->arena->params_size);
+        invalidate_model_winograd_kernels(f);
+        return;
+    }
     int sum = 0,i;
     for(i = 0; i < f->n_fcl; i++){
         memcopy_vector_to_params(f->fcls[i],&vector[sum]);
@@ -4011,6 +4152,10 @@ void memcopy_vector_to_params_model(model* f, float* vector){
  *                 @ float* vector:= the vector where is copyed everything
  * */
 void memcopy_params_to_vector_model(model* f, float* vector){
+    if(f->arena != NULL){
+        copy_array(f->arena->slots[ARENA_PARAMS],vector,f->arena->params_size);
+        return;
+    }
     int sum = 0,i;
     for(i = 0; i < f->n_fcl; i++){
         memcopy_params_to_vector(f->fcls[i],&vector[sum]);
@@ -4035,6 +4180,10 @@ void memcopy_params_to_vector_model(model* f, float* vector){
  *                 @ float* vector:= the vector where is copyed everything
  * */
 void memcopy_vector_to_derivative_params_model(model* f, float* vector){
+    if(f->arena != NULL){
+        copy_array(vector,f->arena->slots[ARENA_DERIVATIVES],f->arena->params_size);
+        return;
+    }
     int sum = 0,i;
     for(i = 0; i < f->n_fcl; i++){
         memcopy_vector_to_derivative_params(f->fcls[i],&vector[sum]);
@@ -4060,6 +4209,10 @@ void memcopy_vector_to_derivative_params_model(model* f, float* vector){
  *                 @ float* vector:= the vector where is copyed everything
  * */
 void memcopy_derivative_params_to_vector_model(model* f, float* vector){
+    if(f->arena != NULL){
+        copy_array(f->arena->slots[ARENA_DERIVATIVES],vector,f->arena->params_size);
+        return;
+    }
     int sum = 0,i;
     for(i = 0; i < f->n_fcl; i++){
         memcopy_derivative_params_to_vector(f->fcls[i],&vector[sum]);
@@ -4075,6 +4228,42 @@ void memcopy_derivative_params_to_vector_model(model* f, float* vector){
     }
 }
 
+/* this function stores the arrays of the partial derivatives of a model that are summed over a batch,
+ * two models with the same structure get their arrays in the same order
+ * 
+ * Inputs:
+ * 
+ * 
+ *                 @ model* f:= the model
+ *                 @ float** segments:= where the arrays are stored, if NULL the arrays are only counted
+ *                 @ int* sizes:= where the sizes of the arrays are stored
+ * 
+ * Output:
+ *                 @ int:= the number of arrays
+ * */
+int get_partial_derivatives_segments_model(model* f, float** segments, int* sizes){
+    int n = 0,i;
+    for(i = 0; i < f->n_fcl; i++){
+        if(segments != NULL)
+            n += get_partial_derivatives_segments(f->fcls[i],&segments[n],&sizes[n]);
+        else
+            n += get_partial_derivatives_segments(f->fcls[i],NULL,NULL);
+    }
+    for(i = 0; i < f->n_cl; i++){
+        if(segments != NULL)
+            n += get_partial_derivatives_segments_cl(f->cls[i],&segments[n],&sizes[n]);
+        else
+            n += get_partial_derivatives_segments_cl(f->cls[i],NULL,NULL);
+    }
+    for(i = 0; i < f->n_rl; i++){
+        if(segments != NULL)
+            n += get_partial_derivatives_segments_rl(f->rls[i],&segments[n],&sizes[n]);
+        else
+            n += get_partial_derivatives_segments_rl(f->rls[i],NULL,NULL);
+    }
+    return n;
+}
+
 /* Setting the params for the loss computation
  * 
  * Inputs:
@@ -4381,6 +4570,46 @@ void set_model_training_gd(model* m){
     }
 }
 
+/* This function sets the algorithm used by the convolutions of all the convolutional layers of the model
+ * 
+ * Inputs:
+ * 
+ *             @ model* m:= the model
+ *             @ int algorithm:= AUTO_CONVOLUTION, DIRECT_CONVOLUTION, IM2COL_CONVOLUTION or WINOGRAD_CONVOLUTION
+ * */
+void set_model_convolution_algorithm(model* m, int algorithm){
+    int i,j;
+    for(i = 0; i < m->n_cl; i++){
+        set_convolution_algorithm(m->cls[i],algorithm);
+    }
+    
+    for(i = 0; i < m->n_rl; i++){
+        for(j = 0; j < m->rls[i]->n_cl; j++){
+            set_convolution_algorithm(m->rls[i]->cls[j],algorithm);
+        }
+    }
+}
+
+/* This function invalidates the winograd transformations of the kernels of all the convolutional layers of the model,
+ * they are computed again from the kernels at the next feed forward
+ * 
+ * Inputs:
+ * 
+ *             @ model* m:= the model
+ * */
+void invalidate_model_winograd_kernels(model* m){
+    int i,j;
+    for(i = 0; i < m->n_cl; i++){
+        m->cls[i]->winograd_cache_flag = 0;
+    }
+    
+    for(i = 0; i < m->n_rl; i++){
+        for(j = 0; j < m->rls[i]->n_cl; j++){
+            m->rls[i]->cls[j]->winograd_cache_flag = 0;
+        }
+    }
+}
+
 /* this function sum up all the scores in each layer of the input model1 and 2 in the output model
  * 
  * 
@@ -28,6 +28,9 @@ SOFTWARE.
 model* network(int layers, int n_rl, int n_cl, int n_fcl, rl** rls, cl** cls, fcl** fcls);
 void free_model(model* m);
 model* copy_model(model* m);
+model* share_model(model* m);
+void free_shared_model(model* m);
+int model_shares_params(model* m, model* s);
 void save_model(model* m, int n);
 void heavy_save_model(model* m, int n);
 model* load_model(char* file);
@@ -43,6 +46,7 @@ float* bp_cl_fcl(cl* f1, fcl* f2, float* error);
 void model_tensor_input_ff(model* m, int tensor_depth, int tensor_i, int tensor_j, float* input);
 float* model_tensor_input_bp(model* m, int tensor_depth, int tensor_i, int tensor_j, float* input, float* error, int error_dimension);
 model* reset_model(model* m);
+model* reset_model_except_partial_derivatives(model* m);
 void update_model(model* m, float lr, float momentum, int mini_batch_size, int gradient_descent_flag, float* b1, float* b2, int regularization, int total_number_weights, float lambda, unsigned long long int* t);
 void sum_model_partial_derivatives(model* m, model* m2, model* m3);
 unsigned long long int size_of_model(model* m);
@@ -54,6 +58,7 @@ void memcopy_vector_to_params_model(model* f, float* vector);
 void memcopy_params_to_vector_model(model* f, float* vector);
 void memcopy_vector_to_derivative_params_model(model* f, float* vector);
 void memcopy_derivative_params_to_vector_model(model* f, float* vector);
+int get_partial_derivatives_segments_model(model* f, float** segments, int* sizes);
 void set_model_error(model* m, int error_flag, float threshold1, float threshold2, float gamma, float* alpha, int output_dimension);
 void mse_model_error(model* m, float* output);
 void cross_entropy_model_error(model* m, float* output);
@@ -68,6 +73,8 @@ void sum_models_partial_derivatives(model* sum_m, model** models, int n_models);
 void set_model_biases_to_zero(model* m);
 void set_model_training_edge_popup(model* m, float k_percentage);
 void set_model_training_gd(model* m);
+void set_model_convolution_algorithm(model* m, int algorithm);
+void invalidate_model_winograd_kernels(model* m);
 void set_model_unused_weights_to_zero(model* m);
 void get_subnetwork_from_edge_popup(model* m);
 void paste_w_model(model* m, model* copy);
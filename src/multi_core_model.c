@@ -44,6 +44,33 @@ void* model_thread_bp(void* _args) {
     return _args;
 }
 
+void* model_thread_reset(void* _args) {
+    
+    // depacking args
+    reset_model_except_partial_derivatives((model*) _args);
+    return _args;
+}
+
+void* partial_derivatives_reduction_thread(void* _args) {
+    
+    // depacking args
+    thread_args_reduction* args = (thread_args_reduction*) _args;
+    long long int offset;
+    int s,i,a,b;
+    for(s = 0, offset = 0; s < args->n_segments && offset < args->end; offset += args->sizes[s], s++){
+        if(offset+args->sizes[s] <= args->start)
+            continue;
+        a = args->start > offset ? args->start-offset : 0;
+        b = args->end < offset+args->sizes[s] ? args->end-offset : args->sizes[s];
+        for(i = 0; i < args->n_replicas; i++){
+            sum1D(&args->replicas[i][s][a],&args->sum[s][a],&args->sum[s][a],b-a);
+            if(args->reset_flag)
+                memset(&args->replicas[i][s][a],0,sizeof(float)*(b-a));
+        }
+    }
+    return _args;
+}
+
 void* model_thread_ff_bp(void* _args) {
     
     // depacking args
@@ -72,28 +99,21 @@ void* model_thread_ff_bp(void* _args) {
  * 
  * */
 void model_tensor_input_ff_multicore(model** m, int depth, int rows, int cols, float** inputs, int mini_batch_size, int threads){
-    pthread_t thread[threads];
-    thread_args_model* args[threads];
-    
-    int i,j;
-    
-    for(i = 0; i < mini_batch_size; i+=threads){
-        for(j = 0; j < threads && j+i < mini_batch_size; j++){
-            args[j] = (thread_args_model*)malloc(sizeof(thread_args_model));
-            args[j]->m = m[i+j];
-            args[j]->channels = depth;
-            args[j]->rows = rows;
-            args[j]->cols = cols;
-            args[j]->input = inputs[i+j];
-            pthread_create(thread+j, NULL, model_thread_ff, args[j]);
-            
-            }
-                
-        for(j = 0; j < threads && j+i < mini_batch_size; j++) {
-            pthread_join(thread[j], NULL);
-            free(args[j]);
-        }
+    thread_pool* pool = get_shared_thread_pool(threads);
+    thread_args_model* args = (thread_args_model*)malloc(sizeof(thread_args_model)*mini_batch_size);
+    
+    int i;
+    
+    for(i = 0; i < mini_batch_size; i++){
+        args[i].m = m[i];
+        args[i].channels = depth;
+        args[i].rows = rows;
+        args[i].cols = cols;
+        args[i].input = inputs[i];
+        thread_pool_submit(pool,model_thread_ff,&args[i]);
     }
+    thread_pool_wait(pool);
+    free(args);
 
 }
 
@@ -116,34 +136,27 @@ void model_tensor_input_ff_multicore(model** m, int depth, int rows, int cols, f
  * 
  * */
 void model_tensor_input_bp_multicore(model** m, int depth, int rows, int cols, float** inputs, int mini_batch_size, int threads,float** errors, int error_dimension, float** returning_error){
-    pthread_t thread[threads];
-    thread_args_model* args[threads];
-    
-    int i,j;
-    
-    for(i = 0; i < mini_batch_size; i+=threads){
-        for(j = 0; j < threads && j+i < mini_batch_size; j++){
-            args[j] = (thread_args_model*)malloc(sizeof(thread_args_model));
-            args[j]->m = m[i+j];
-            args[j]->channels = depth;
-            args[j]->rows = rows;
-            args[j]->cols = cols;
-            args[j]->input = inputs[i+j];
-            args[j]->error = errors[i+j];
-            args[j]->error_dimension = error_dimension;
-            if(returning_error == NULL)
-            args[j]->returning_error = NULL;
-            else
-            args[j]->returning_error = &returning_error[i+j];            
-            pthread_create(thread+j, NULL, model_thread_bp, args[j]);
-            
-            }
-                
-        for(j = 0; j < threads && j+i < mini_batch_size; j++) {
-            pthread_join(thread[j], NULL);
-            free(args[j]);
-        }
+    thread_pool* pool = get_shared_thread_pool(threads);
+    thread_args_model* args = (thread_args_model*)malloc(sizeof(thread_args_model)*mini_batch_size);
+    
+    int i;
+    
+    for(i = 0; i < mini_batch_size; i++){
+        args[i].m = m[i];
+        args[i].channels = depth;
+        args[i].rows = rows;
+        args[i].cols = cols;
+        args[i].input = inputs[i];
+        args[i].error = errors[i];
+        args[i].error_dimension = error_dimension;
+        if(returning_error == NULL)
+        args[i].returning_error = NULL;
+        else
+        args[i].returning_error = &returning_error[i];            
+        thread_pool_submit(pool,model_thread_bp,&args[i]);
     }
+    thread_pool_wait(pool);
+    free(args);
 
 }
 
@@ -165,31 +178,300 @@ void model_tensor_input_bp_multicore(model** m, int depth, int rows, int cols, f
  * 
  * */
 void ff_error_bp_model_multicore(model** m, int depth, int rows, int cols, float** inputs, int mini_batch_size, int threads,float** outputs, float** returning_error){
-    pthread_t thread[threads];
-    thread_args_model* args[threads];
-    
-    int i,j;
-    
-    for(i = 0; i < mini_batch_size; i+=threads){
-        for(j = 0; j < threads && j+i < mini_batch_size; j++){
-            args[j] = (thread_args_model*)malloc(sizeof(thread_args_model));
-            args[j]->m = m[i+j];
-            args[j]->channels = depth;
-            args[j]->rows = rows;
-            args[j]->cols = cols;
-            args[j]->input = inputs[i+j];
-            args[j]->error = outputs[i+j];
-            if(returning_error != NULL)
-                args[j]->returning_error = &returning_error[i+j];
+    thread_pool* pool = get_shared_thread_pool(threads);
+    thread_args_model* args = (thread_args_model*)malloc(sizeof(thread_args_model)*mini_batch_size);
+    
+    int i;
+    
+    for(i = 0; i < mini_batch_size; i++){
+        args[i].m = m[i];
+        args[i].channels = depth;
+        args[i].rows = rows;
+        args[i].cols = cols;
+        args[i].input = inputs[i];
+        args[i].error = outputs[i];
+        if(returning_error != NULL)
+            args[i].returning_error = &returning_error[i];
+        else
+            args[i].returning_error = NULL;
+        thread_pool_submit(pool,model_thread_ff_bp,&args[i]);
+    }
+    thread_pool_wait(pool);
+    free(args);
+}
+
+/* This function sums the partial derivatives of n_replicas replicas in the arrays of sum with the shared thread pool.
+ * The arrays are seen as a single concatenated vector that is split in shards, each thread sums all the replicas
+ * for its own shard, in the order of the replicas, so the result is the same of the serial sum.
+ * If reset_flag is set the partial derivatives of the replicas are zeroed right after they have been summed,
+ * and reset_function is run on each element of reset_args in the same wave of tasks, in this way
+ * the reset of the replicas doesn't need another pass over their partial derivatives
+ * 
+ * Inputs:
+ * 
+ *             @ float** sum:= the arrays where the partial derivatives are summed, dimensions: n_segments*sizes[i]
+ *             @ float*** replicas:= the arrays of the replicas, dimensions: n_replicas*n_segments*sizes[i]
+ *             @ int* sizes:= the sizes of the arrays, dimensions: n_segments
+ *             @ int n_segments:= the number of arrays
+ *             @ int n_replicas:= the number of replicas
+ *             @ int reset_flag:= 1 to zero the partial derivatives of the replicas
+ *             @ void* (*reset_function)(void*):= the function that resets everything else of a replica, can be NULL
+ *             @ void** reset_args:= the replicas passed to reset_function, dimensions: n_replicas
+ *             @ int threads:= the number of threads you want to use
+ * 
+ * */
+void sum_partial_derivatives_multicore(float** sum, float*** replicas, int* sizes, int n_segments, int n_replicas, int reset_flag, void* (*reset_function)(void*), void** reset_args, int threads){
+    thread_pool* pool = get_shared_thread_pool(threads);
+    long long int total = 0, shard;
+    int i,n_shards;
+    for(i = 0; i < n_segments; i++){
+        total += sizes[i];
+    }
+    // a few shards per thread balance the load, but a shard shouldn't be too small
+    shard = (total+threads*4-1)/(threads*4);
+    if(shard < 4096)
+        shard = 4096;
+    n_shards = (total+shard-1)/shard;
+    thread_args_reduction* args = (thread_args_reduction*)malloc(sizeof(thread_args_reduction)*(n_shards+1));
+    
+    for(i = 0; i < n_shards; i++){
+        args[i].sum = sum;
+        args[i].replicas = replicas;
+        args[i].sizes = sizes;
+        args[i].n_segments = n_segments;
+        args[i].n_replicas = n_replicas;
+        args[i].reset_flag = reset_flag;
+        args[i].start = i*shard;
+        args[i].end = (i+1)*shard < total ? (i+1)*shard : total;
+        thread_pool_submit(pool,partial_derivatives_reduction_thread,&args[i]);
+    }
+    if(reset_flag && reset_function != NULL){
+        for(i = 0; i < n_replicas; i++){
+            thread_pool_submit(pool,reset_function,reset_args[i]);
+        }
+    }
+    thread_pool_wait(pool);
+    free(args);
+}
+
+/* This function sums the partial derivatives of a batch of models in sum_m with the shared thread pool,
+ * the result is the same of sum_models_partial_derivatives. With reset_flag the models are also resetted,
+ * as reset_model would do, in the same pass
+ * 
+ * Inputs:
+ * 
+ *             @ model* sum_m:= where are summed up the partial derivatives
+ *             @ model** models:= the models of the batch, dimensions: n_models
+ *             @ int n_models:= the number of models
+ *             @ int reset_flag:= 1 to reset the models of the batch
+ *             @ int threads:= the number of threads you want to use
+ * 
+ * */
+void sum_models_partial_derivatives_multicore(model* sum_m, model** models, int n_models, int reset_flag, int threads){
+    int i,n,arena_flag = 1;
+    for(i = 0; i < n_models; i++){
+        arena_flag = arena_flag && same_params_arena(sum_m->arena,models[i]->arena);
+    }
+    // with the arenas all the partial derivatives are a single contiguous segment
+    n = arena_flag ? 1 : get_partial_derivatives_segments_model(sum_m,NULL,NULL);
+    int* sizes = (int*)malloc(sizeof(int)*n);
+    float** sum = (float**)malloc(sizeof(float*)*n);
+    float*** replicas = (float***)malloc(sizeof(float**)*n_models);
+    if(arena_flag){
+        sum[0] = sum_m->arena->slots[ARENA_DERIVATIVES];
+        sizes[0] = sum_m->arena->size;
+    }
+    else
+        get_partial_derivatives_segments_model(sum_m,sum,sizes);
+    for(i = 0; i < n_models; i++){
+        replicas[i] = (float**)malloc(sizeof(float*)*n);
+        if(arena_flag)
+            replicas[i][0] = models[i]->arena->slots[ARENA_DERIVATIVES];
+        else
+            get_partial_derivatives_segments_model(models[i],replicas[i],sizes);
+    }
+    sum_partial_derivatives_multicore(sum,replicas,sizes,n,n_models,reset_flag,model_thread_reset,(void**)models,threads);
+    for(i = 0; i < n_models; i++){
+        free(replicas[i]);
+    }
+    free(replicas);
+    free(sum);
+    free(sizes);
+}
+
+void* params_norm_thread(void* _args) {
+    
+    // depacking args
+    thread_args_optimizer* args = (thread_args_optimizer*) _args;
+    args->sum = sum_of_squares_span(&args->arena->slots[ARENA_DERIVATIVES][args->span.offset],args->span.size);
+    return _args;
+}
+
+void* params_update_thread(void* _args) {
+    
+    // depacking args
+    thread_args_optimizer* args = (thread_args_optimizer*) _args;
+    update_params_span(args->arena,args->step,&args->span);
+    return _args;
+}
+
+/* This function updates the spans of an arena with a single sweep for each span: the gradient clipping, the l2 regularization
+ * and the optimizer are applied to each param in the same pass. The spans are split in chunks of OPTIMIZER_CHUNK params
+ * that are given to the shared thread pool. If s->clip is > 0 it is used as threshold, the norm of the partial derivatives of the
+ * spans with OPTIMIZER_SPAN_NORM is computed before the update (chunk by chunk and then summed in the chunk order,
+ * so the result doesn't depend on the number of threads) and s->clip becomes the clipping factor.
+ * The partial derivatives are left untouched
+ * 
+ * Inputs:
+ * 
+ *             @ params_arena* a:= the arena
+ *             @ optimizer_span* spans:= the spans, dimensions: n_spans
+ *             @ int n_spans:= the number of spans
+ *             @ optimizer_step* s:= the hyperparameters of the step
+ *             @ int threads:= the number of threads you want to use, with 1 everything runs in the calling thread
+ * 
+ * */
+void update_params_arena_multicore(params_arena* a, optimizer_span* spans, int n_spans, optimizer_step* s, int threads){
+    int i,j,n = 0;
+    float threshold = s->clip, sum = 0;
+    for(i = 0; i < n_spans; i++){
+        n += (spans[i].size+OPTIMIZER_CHUNK-1)/OPTIMIZER_CHUNK;
+    }
+    if(!n)
+        return;
+    thread_args_optimizer* args = (thread_args_optimizer*)malloc(sizeof(thread_args_optimizer)*n);
+    for(i = 0, n = 0; i < n_spans; i++){
+        for(j = 0; j < spans[i].size; j+=OPTIMIZER_CHUNK, n++){
+            args[n].arena = a;
+            args[n].step = s;
+            args[n].span.offset = spans[i].offset+j;
+            args[n].span.size = spans[i].size-j < OPTIMIZER_CHUNK ? spans[i].size-j : OPTIMIZER_CHUNK;
+            args[n].span.flags = spans[i].flags;
+            args[n].sum = 0;
+        }
+    }
+    thread_pool* pool = threads > 1 ? get_shared_thread_pool(threads) : NULL;
+    
+    s->clip = 1;
+    if(threshold > 0){
+        for(i = 0; i < n; i++){
+            if(!(args[i].span.flags & OPTIMIZER_SPAN_NORM))
+                continue;
+            if(pool == NULL)
+                params_norm_thread(&args[i]);
             else
-                args[j]->returning_error = NULL;
-            pthread_create(thread+j, NULL, model_thread_ff_bp, args[j]);
-            
-            }
-                
-        for(j = 0; j < threads && j+i < mini_batch_size; j++) {
-            pthread_join(thread[j], NULL);
-            free(args[j]);
+                thread_pool_submit(pool,params_norm_thread,&args[i]);
         }
+        if(pool != NULL)
+            thread_pool_wait(pool);
+        for(i = 0; i < n; i++){
+            sum += args[i].sum;
+        }
+        sum = sqrtf(sum);
+        if(sum >= threshold)
+            s->clip = threshold/sum;
+    }
+    
+    for(i = 0; i < n; i++){
+        if(!(args[i].span.flags & OPTIMIZER_SPAN_UPDATE))
+            continue;
+        if(pool == NULL)
+            params_update_thread(&args[i]);
+        else
+            thread_pool_submit(pool,params_update_thread,&args[i]);
     }
+    if(pool != NULL)
+        thread_pool_wait(pool);
+    free(args);
+}
+
+/* This function builds the optimizer_step of update_model and update_rmodel
+ * 
+ * Inputs:
+ * 
+ *             @ optimizer_step* s:= the step that is filled
+ *             @ float lr:= the learning rate
+ *             @ float momentum:= the momentum
+ *             @ int mini_batch_size:= the size of the mini batch
+ *             @ int gradient_descent_flag:= NESTEROV, ADAM, RADAM, DIFF_GRAD, ADAMOD
+ *             @ float b1:= BETA1_ADAM^t
+ *             @ float b2:= BETA2_ADAM^t
+ *             @ int regularization:= NO_REGULARIZATION or L2_REGULARIZATION
+ *             @ int total_number_weights:= the number of weights for the l2 regularization
+ *             @ float lambda:= the lambda of the l2 regularization
+ *             @ unsigned long long int t:= the step of radam
+ *             @ float beta1_adam:= the beta1 of the model
+ *             @ float beta2_adam:= the beta2 of the model
+ *             @ float beta3_adamod:= the beta3 of the model
+ *             @ float clipping_threshold:= the threshold of the gradient clipping, 0 for no clipping
+ * 
+ * */
+void set_optimizer_step(optimizer_step* s, float lr, float momentum, int mini_batch_size, int gradient_descent_flag, float b1, float b2, int regularization, int total_number_weights, float lambda, unsigned long long int t, float beta1_adam, float beta2_adam, float beta3_adamod, float clipping_threshold){
+    s->gradient_descent_flag = gradient_descent_flag;
+    s->mini_batch_size = mini_batch_size;
+    s->lr = lr;
+    s->momentum = momentum;
+    s->beta1 = beta1_adam;
+    s->beta2 = beta2_adam;
+    s->beta3 = beta3_adamod;
+    s->b1 = b1;
+    s->b2 = b2;
+    s->l2 = 0;
+    if(regularization == L2_REGULARIZATION)
+        s->l2 = (lambda*(float)mini_batch_size)/(float)total_number_weights;
+    s->clip = clipping_threshold;
+    s->t = t;
+}
+
+/* This function updates the model with a single sweep over its arena using the shared thread pool,
+ * the gradient clipping (if clipping_threshold > 0) and the l2 regularization are fused in the same sweep.
+ * Without clipping the params are the same of update_model, with clipping they are the same of clipping_gradient + update_model
+ * up to the summation order of the norm. If the model can't be updated in a single sweep (see fused_update_supported_model)
+ * clipping_gradient and update_model are used. The partial derivatives are not modified. See update_model for the other inputs
+ * 
+ * Inputs:
+ * 
+ *             @ float clipping_threshold:= the threshold of the gradient clipping, 0 for no clipping
+ *             @ int threads:= the number of threads you want to use
+ * 
+ * */
+void update_model_multicore(model* m, float lr, float momentum, int mini_batch_size, int gradient_descent_flag, float* b1, float* b2, int regularization, int total_number_weights, float lambda, unsigned long long int* t, float clipping_threshold, int threads){
+    if(m == NULL)
+        return;
+    if(!fused_update_supported_model(m)){
+        if(clipping_threshold > 0)
+            clipping_gradient(m,clipping_threshold);
+        update_model(m,lr,momentum,mini_batch_size,gradient_descent_flag,b1,b2,regularization,total_number_weights,lambda,t);
+        return;
+    }
+    optimizer_step s;
+    int n = get_update_spans_model(m,NULL);
+    optimizer_span* spans = (optimizer_span*)malloc(sizeof(optimizer_span)*(n+1));
+    n = get_update_spans_model(m,spans);
+    set_optimizer_step(&s,lr,momentum,mini_batch_size,gradient_descent_flag,(*b1),(*b2),regularization,total_number_weights,lambda,(*t),m->beta1_adam,m->beta2_adam,m->beta3_adamod,clipping_threshold);
+    update_params_arena_multicore(m->arena,spans,n,&s,threads);
+    free(spans);
+    update_optimizer_counters(gradient_descent_flag,b1,b2,t,m->beta1_adam,m->beta2_adam);
+    invalidate_model_winograd_kernels(m);
+}
+
+/* This function updates BETA1_ADAM^t, BETA2_ADAM^t and t after an update as update_model does
+ * 
+ * Inputs:
+ * 
+ *             @ int gradient_descent_flag:= NESTEROV, ADAM, RADAM, DIFF_GRAD, ADAMOD
+ *             @ float* b1:= BETA1_ADAM^t
+ *             @ float* b2:= BETA2_ADAM^t
+ *             @ unsigned long long int* t:= the step of radam
+ *             @ float beta1_adam:= the beta1 of the model
+ *             @ float beta2_adam:= the beta2 of the model
+ * 
+ * */
+void update_optimizer_counters(int gradient_descent_flag, float* b1, float* b2, unsigned long long int* t, float beta1_adam, float beta2_adam){
+    if(gradient_descent_flag != ADAM && gradient_descent_flag != RADAM && gradient_descent_flag != DIFF_GRAD && gradient_descent_flag != ADAMOD)
+        return;
+    (*b1)*=beta1_adam;
+    (*b2)*=beta2_adam;
+    if(gradient_descent_flag == RADAM)
+        (*t)++;
 }
@@ -31,5 +31,15 @@ void model_tensor_input_ff_multicore(model** m, int depth, int rows, int cols, f
 void model_tensor_input_bp_multicore(model** m, int depth, int rows, int cols, float** inputs, int mini_batch_size, int threads,float** errors, int error_dimension, float** returning_error);
 void ff_error_bp_model_multicore(model** m, int depth, int rows, int cols, float** inputs, int mini_batch_size, int threads,float** outputs, float** returning_error);
 void* model_thread_ff_bp(void* _args);
+void* model_thread_reset(void* _args);
+void* partial_derivatives_reduction_thread(void* _args);
+void sum_partial_derivatives_multicore(float** sum, float*** replicas, int* sizes, int n_segments, int n_replicas, int reset_flag, void* (*reset_function)(void*), void** reset_args, int threads);
+void sum_models_partial_derivatives_multicore(model* sum_m, model** models, int n_models, int reset_flag, int threads);
+void* params_norm_thread(void* _args);
+void* params_update_thread(void* _args);
+void update_params_arena_multicore(params_arena* a, optimizer_span* spans, int n_spans, optimizer_step* s, int threads);
+void set_optimizer_step(optimizer_step* s, float lr, float momentum, int mini_batch_size, int gradient_descent_flag, float b1, float b2, int regularization, int total_number_weights, float lambda, unsigned long long int t, float beta1_adam, float beta2_adam, float beta3_adamod, float clipping_threshold);
+void update_model_multicore(model* m, float lr, float momentum, int mini_batch_size, int gradient_descent_flag, float* b1, float* b2, int regularization, int total_number_weights, float lambda, unsigned long long int* t, float clipping_threshold, int threads);
+void update_optimizer_counters(int gradient_descent_flag, float* b1, float* b2, unsigned long long int* t, float beta1_adam, float beta2_adam);
 
 #endif
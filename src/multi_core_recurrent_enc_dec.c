@@ -48,6 +48,13 @@ void* recurrent_enc_dec_thread_bp(void* _args) {
     return _args;
 }
 
+void* recurrent_enc_dec_thread_reset(void* _args) {
+    
+    // depacking args
+    reset_recurrent_enc_dec_except_partial_derivatives((recurrent_enc_dec*) _args);
+    return _args;
+}
+
 /* This functions computes the feed forward of a rmodel for a batch of instances of the dataset
  * 
  * Inputs:
@@ -63,28 +70,21 @@ void* recurrent_enc_dec_thread_bp(void* _args) {
  * 
  * */
 void ff_recurrent_enc_dec_multicore(float*** hidden_states, float*** cell_states, float*** input_model1, float*** input_model2, recurrent_enc_dec** m, int mini_batch_size, int threads){
-    pthread_t thread[threads];
-    thread_args_enc_dec_model* args[threads];
+    thread_pool* pool = get_shared_thread_pool(threads);
+    thread_args_enc_dec_model* args = (thread_args_enc_dec_model*)malloc(sizeof(thread_args_enc_dec_model)*mini_batch_size);
     
-    int i,j;
+    int i;
     
-    for(i = 0; i < mini_batch_size; i+=threads){
-        for(j = 0; j < threads && j+i < mini_batch_size; j++){
-            args[j] = (thread_args_enc_dec_model*)malloc(sizeof(thread_args_enc_dec_model));
-            args[j]->m = m[i+j];
-            args[j]->hidden_states = hidden_states[i+j];
-            args[j]->cell_states = cell_states[i+j];
-            args[j]->input_model1 = input_model1[i+j];
-            args[j]->input_model2 = input_model2[i+j];
-            pthread_create(thread+j, NULL, recurrent_enc_dec_thread_ff, args[j]);
-            
-            }
-                
-        for(j = 0; j < threads && j+i < mini_batch_size; j++) {
-            pthread_join(thread[j], NULL);
-            free(args[j]);
-        }
+    for(i = 0; i < mini_batch_size; i++){
+        args[i].m = m[i];
+        args[i].hidden_states = hidden_states[i];
+        args[i].cell_states = cell_states[i];
+        args[i].input_model1 = input_model1[i];
+        args[i].input_model2 = input_model2[i];
+        thread_pool_submit(pool,recurrent_enc_dec_thread_ff,&args[i]);
     }
+    thread_pool_wait(pool);
+    free(args);
 
 }
 
@@ -107,37 +107,62 @@ void ff_recurrent_enc_dec_multicore(float*** hidden_states, float*** cell_states
  * 
  * */
 void bp_recurrent_enc_dec_multicore(float*** hidden_states, float*** cell_states, float*** input_model1,float*** input_model2, recurrent_enc_dec** m, float*** error_model, int mini_batch_size, int threads, float**** returning_error, float*** returning_input_error1,float*** returning_input_error2){
-    pthread_t thread[threads];
-    thread_args_enc_dec_model* args[threads];
+    thread_pool* pool = get_shared_thread_pool(threads);
+    thread_args_enc_dec_model* args = (thread_args_enc_dec_model*)malloc(sizeof(thread_args_enc_dec_model)*mini_batch_size);
     
-    int i,j;
+    int i;
     
-    for(i = 0; i < mini_batch_size; i+=threads){
-        for(j = 0; j < threads && j+i < mini_batch_size; j++){
-            args[j] = (thread_args_enc_dec_model*)malloc(sizeof(thread_args_enc_dec_model));
-            args[j]->m = m[i+j];
-            args[j]->hidden_states = hidden_states[i+j];
-            args[j]->cell_states = cell_states[i+j];
-            args[j]->input_model1 = input_model1[i+j];
-            args[j]->input_model2 = input_model2[i+j];
-            args[j]->error_model = error_model[i+j];
-            args[j]->returning_error = &returning_error[i+j];
-            if(returning_input_error1 != NULL)
-            args[j]->ret_input_error1 = &returning_input_error1[i+j];
-            else
-            args[j]->ret_input_error1 = NULL;
-            if(returning_input_error2 != NULL)
-            args[j]->ret_input_error2 = &returning_input_error2[i+j];
-            else
-            args[j]->ret_input_error2 = NULL;
-            pthread_create(thread+j, NULL, recurrent_enc_dec_thread_bp, args[j]);
-            
-            }
-                
-        for(j = 0; j < threads && j+i < mini_batch_size; j++) {
-            pthread_join(thread[j], NULL);
-            free(args[j]);
-        }
+    for(i = 0; i < mini_batch_size; i++){
+        args[i].m = m[i];
+        args[i].hidden_states = hidden_states[i];
+        args[i].cell_states = cell_states[i];
+        args[i].input_model1 = input_model1[i];
+        args[i].input_model2 = input_model2[i];
+        args[i].error_model = error_model[i];
+        args[i].returning_error = &returning_error[i];
+        if(returning_input_error1 != NULL)
+        args[i].ret_input_error1 = &returning_input_error1[i];
+        else
+        args[i].ret_input_error1 = NULL;
+        if(returning_input_error2 != NULL)
+        args[i].ret_input_error2 = &returning_input_error2[i];
+        else
+        args[i].ret_input_error2 = NULL;
+        thread_pool_submit(pool,recurrent_enc_dec_thread_bp,&args[i]);
     }
+    thread_pool_wait(pool);
+    free(args);
+
+}
 
+/* This function sums the partial derivatives of a batch of recurrent encoder decoders in sum_m with the shared thread pool,
+ * the result is the same of sum_recurrent_enc_decs_partial_derivatives. With reset_flag the recurrent encoder decoders of the batch are also resetted,
+ * as reset_recurrent_enc_dec would do, in the same pass
+ * 
+ * Inputs:
+ * 
+ *             @ recurrent_enc_dec* sum_m:= where are summed up the partial derivatives
+ *             @ recurrent_enc_dec** models:= the recurrent encoder decoders of the batch, dimensions: n_models
+ *             @ int n_models:= the number of recurrent encoder decoders
+ *             @ int reset_flag:= 1 to reset the recurrent encoder decoders of the batch
+ *             @ int threads:= the number of threads you want to use
+ * 
+ * */
+void sum_recurrent_enc_decs_partial_derivatives_multicore(recurrent_enc_dec* sum_m, recurrent_enc_dec** models, int n_models, int reset_flag, int threads){
+    int i,n = get_partial_derivatives_segments_recurrent_enc_dec(sum_m,NULL,NULL);
+    int* sizes = (int*)malloc(sizeof(int)*n);
+    float** sum = (float**)malloc(sizeof(float*)*n);
+    float*** replicas = (float***)malloc(sizeof(float**)*n_models);
+    get_partial_derivatives_segments_recurrent_enc_dec(sum_m,sum,sizes);
+    for(i = 0; i < n_models; i++){
+        replicas[i] = (float**)malloc(sizeof(float*)*n);
+        get_partial_derivatives_segments_recurrent_enc_dec(models[i],replicas[i],sizes);
+    }
+    sum_partial_derivatives_multicore(sum,replicas,sizes,n,n_models,reset_flag,recurrent_enc_dec_thread_reset,(void**)models,threads);
+    for(i = 0; i < n_models; i++){
+        free(replicas[i]);
+    }
+    free(replicas);
+    free(sum);
+    free(sizes);
 }
@@ -29,5 +29,7 @@ void* recurrent_enc_dec_thread_ff(void* _args);
 void* recurrent_enc_dec_thread_bp(void* _args);
 void ff_recurrent_enc_dec_multicore(float*** hidden_states, float*** cell_states, float*** input_model1, float*** input2_model, recurrent_enc_dec** m, int mini_batch_size, int threads);
 void bp_recurrent_enc_dec_multicore(float*** hidden_states, float*** cell_states, float*** input_model1,float*** input_model2, recurrent_enc_dec** m, float*** error_model, int mini_batch_size, int threads, float**** returning_error, float*** returning_input_error1,float*** returning_input_error2);
+void* recurrent_enc_dec_thread_reset(void* _args);
+void sum_recurrent_enc_decs_partial_derivatives_multicore(recurrent_enc_dec* sum_m, recurrent_enc_dec** models, int n_models, int reset_flag, int threads);
 
 #endif
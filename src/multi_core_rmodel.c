@@ -37,13 +37,22 @@ void* rmodel_thread_bp(void* _args) {
     
     // depacking args
     thread_args_rmodel* args = (thread_args_rmodel*) _args;
-    if(args->ret_input_error != NULL)
+    if(args->returning_error == NULL)
+    bp_rmodel_workspace(args->hidden_states,args->cell_states,args->input_model,args->error_model,args->m,args->ret_input_error == NULL ? NULL : args->ret_input_error[0],NULL,NULL);
+    else if(args->ret_input_error != NULL)
     args->returning_error[0] = bp_rmodel(args->hidden_states,args->cell_states,args->input_model,args->error_model,args->m,args->ret_input_error[0]);
     else
     args->returning_error[0] = bp_rmodel(args->hidden_states,args->cell_states,args->input_model,args->error_model,args->m,NULL);
     return _args;
 }
 
+void* rmodel_thread_reset(void* _args) {
+    
+    // depacking args
+    reset_rmodel_except_partial_derivatives((rmodel*) _args);
+    return _args;
+}
+
 /* This functions computes the feed forward of a rmodel for a batch of instances of the dataset
  * 
  * Inputs:
@@ -58,27 +67,20 @@ void* rmodel_thread_bp(void* _args) {
  * 
  * */
 void ff_rmodel_lstm_multicore(float*** hidden_states, float*** cell_states, float*** input_model, rmodel** m, int mini_batch_size, int threads){
-    pthread_t thread[threads];
-    thread_args_rmodel* args[threads];
+    thread_pool* pool = get_shared_thread_pool(threads);
+    thread_args_rmodel* args = (thread_args_rmodel*)malloc(sizeof(thread_args_rmodel)*mini_batch_size);
     
-    int i,j;
+    int i;
     
-    for(i = 0; i < mini_batch_size; i+=threads){
-        for(j = 0; j < threads && j+i < mini_batch_size; j++){
-            args[j] = (thread_args_rmodel*)malloc(sizeof(thread_args_rmodel));
-            args[j]->m = m[i+j];
-            args[j]->hidden_states = hidden_states[i+j];
-            args[j]->cell_states = cell_states[i+j];
-            args[j]->input_model = input_model[i+j];
-            pthread_create(thread+j, NULL, rmodel_thread_ff, args[j]);
-            
-            }
-                
-        for(j = 0; j < threads && j+i < mini_batch_size; j++) {
-            pthread_join(thread[j], NULL);
-            free(args[j]);
-        }
+    for(i = 0; i < mini_batch_size; i++){
+        args[i].m = m[i];
+        args[i].hidden_states = hidden_states[i];
+        args[i].cell_states = cell_states[i];
+        args[i].input_model = input_model[i];
+        thread_pool_submit(pool,rmodel_thread_ff,&args[i]);
     }
+    thread_pool_wait(pool);
+    free(args);
 
 }
 
@@ -94,37 +96,110 @@ void ff_rmodel_lstm_multicore(float*** hidden_states, float*** cell_states, floa
  *             @ float*** error_model:= the errors of each instance of the batch, dimensions: mini_batch_size*window*m[0]->size
  *             @ int mini_batch_size:= the batch size used
  *             @ int threads:= the number of threads you want to use
- *             @ float**** returning_error:= where will be stored the errors, dimensions:= mini_batch_size*m[0]->layers*4*m[0]->size, must be allocated only the batch size
- *             @ float*** returning_input_error:= where will be stored the errors of the input of the model, dimensions:= mini_batch_size*m[0]->window*m[0]->size
+ *             @ float**** returning_error:= where will be stored the errors, dimensions:= mini_batch_size*m[0]->layers*4*m[0]->size, must be allocated only the batch size,
+ *                                          can be NULL: then each rmodel is back propagated with bp_rmodel_workspace, nothing is allocated and
+ *                                          the errors of the first timestep are left in m[i]->lstms[j]->dfioc
+ *             @ float*** returning_input_error:= where will be stored the errors of the input of the model, dimensions:= mini_batch_size*m[0]->window*m[0]->size,
+ *                                          if returning_error is NULL also the rows must be already allocated
  * 
  * */
 void bp_rmodel_lstm_multicore(float*** hidden_states, float*** cell_states, float*** input_model, rmodel** m, float*** error_model, int mini_batch_size, int threads, float**** returning_error, float*** returning_input_error){
-    pthread_t thread[threads];
-    thread_args_rmodel* args[threads];
+    thread_pool* pool = get_shared_thread_pool(threads);
+    thread_args_rmodel* args = (thread_args_rmodel*)malloc(sizeof(thread_args_rmodel)*mini_batch_size);
     
-    int i,j;
+    int i;
     
-    for(i = 0; i < mini_batch_size; i+=threads){
-        for(j = 0; j < threads && j+i < mini_batch_size; j++){
-            args[j] = (thread_args_rmodel*)malloc(sizeof(thread_args_rmodel));
-            args[j]->m = m[i+j];
-            args[j]->hidden_states = hidden_states[i+j];
-            args[j]->cell_states = cell_states[i+j];
-            args[j]->input_model = input_model[i+j];
-            args[j]->error_model = error_model[i+j];
-            args[j]->returning_error = &returning_error[i+j];
-            if(returning_input_error != NULL)
-            args[j]->ret_input_error = &returning_input_error[i+j];
-            else
-            args[j]->ret_input_error = NULL;
-            pthread_create(thread+j, NULL, rmodel_thread_bp, args[j]);
-            
-            }
-                
-        for(j = 0; j < threads && j+i < mini_batch_size; j++) {
-            pthread_join(thread[j], NULL);
-            free(args[j]);
-        }
+    for(i = 0; i < mini_batch_size; i++){
+        args[i].m = m[i];
+        args[i].hidden_states = hidden_states[i];
+        args[i].cell_states = cell_states[i];
+        args[i].input_model = input_model[i];
+        args[i].error_model = error_model[i];
+        if(returning_error != NULL)
+        args[i].returning_error = &returning_error[i];
+        else
+        args[i].returning_error = NULL;
+        if(returning_input_error != NULL)
+        args[i].ret_input_error = &returning_input_error[i];
+        else
+        args[i].ret_input_error = NULL;
+        thread_pool_submit(pool,rmodel_thread_bp,&args[i]);
     }
+    thread_pool_wait(pool);
+    free(args);
+
+}
 
+/* This function sums the partial derivatives of a batch of rmodels in sum_m with the shared thread pool,
+ * the result is the same of sum_rmodels_partial_derivatives. With reset_flag the rmodels are also resetted,
+ * as reset_rmodel would do, in the same pass
+ * 
+ * Inputs:
+ * 
+ *             @ rmodel* sum_m:= where are summed up the partial derivatives
+ *             @ rmodel** models:= the rmodels of the batch, dimensions: n_models
+ *             @ int n_models:= the number of rmodels
+ *             @ int reset_flag:= 1 to reset the rmodels of the batch
+ *             @ int threads:= the number of threads you want to use
+ * 
+ * */
+void sum_rmodels_partial_derivatives_multicore(rmodel* sum_m, rmodel** models, int n_models, int reset_flag, int threads){
+    int i,n,arena_flag = 1;
+    for(i = 0; i < n_models; i++){
+        arena_flag = arena_flag && same_params_arena(sum_m->arena,models[i]->arena);
+    }
+    // with the arenas all the partial derivatives are a single contiguous segment
+    n = arena_flag ? 1 : get_partial_derivatives_segments_rmodel(sum_m,NULL,NULL);
+    int* sizes = (int*)malloc(sizeof(int)*n);
+    float** sum = (float**)malloc(sizeof(float*)*n);
+    float*** replicas = (float***)malloc(sizeof(float**)*n_models);
+    if(arena_flag){
+        sum[0] = sum_m->arena->slots[ARENA_DERIVATIVES];
+        sizes[0] = sum_m->arena->size;
+    }
+    else
+        get_partial_derivatives_segments_rmodel(sum_m,sum,sizes);
+    for(i = 0; i < n_models; i++){
+        replicas[i] = (float**)malloc(sizeof(float*)*n);
+        if(arena_flag)
+            replicas[i][0] = models[i]->arena->slots[ARENA_DERIVATIVES];
+        else
+            get_partial_derivatives_segments_rmodel(models[i],replicas[i],sizes);
+    }
+    sum_partial_derivatives_multicore(sum,replicas,sizes,n,n_models,reset_flag,rmodel_thread_reset,(void**)models,threads);
+    for(i = 0; i < n_models; i++){
+        free(replicas[i]);
+    }
+    free(replicas);
+    free(sum);
+    free(sizes);
+}
+
+/* This function updates the rmodel with a single sweep over its arena using the shared thread pool,
+ * see update_model_multicore. If the rmodel can't be updated in a single sweep clipping_gradient_rmodel and update_rmodel are used.
+ * See update_rmodel for the other inputs
+ * 
+ * Inputs:
+ * 
+ *             @ float clipping_threshold:= the threshold of the gradient clipping, 0 for no clipping
+ *             @ int threads:= the number of threads you want to use
+ * 
+ * */
+void update_rmodel_multicore(rmodel* m, float lr, float momentum, int mini_batch_size, int gradient_descent_flag, float* b1, float* b2, int regularization, int total_number_weights, float lambda, unsigned long long int* t, float clipping_threshold, int threads){
+    if(m == NULL)
+        return;
+    if(!fused_update_supported_rmodel(m)){
+        if(clipping_threshold > 0)
+            clipping_gradient_rmodel(m,clipping_threshold);
+        update_rmodel(m,lr,momentum,mini_batch_size,gradient_descent_flag,b1,b2,regularization,total_number_weights,lambda,t);
+        return;
+    }
+    optimizer_step s;
+    int n = get_update_spans_rmodel(m,NULL);
+    optimizer_span* spans = (optimizer_span*)malloc(sizeof(optimizer_span)*(n+1));
+    n = get_update_spans_rmodel(m,spans);
+    set_optimizer_step(&s,lr,momentum,mini_batch_size,gradient_descent_flag,(*b1),(*b2),regularization,total_number_weights,lambda,(*t),m->beta1_adam,m->beta2_adam,m->beta3_adamod,clipping_threshold);
+    update_params_arena_multicore(m->arena,spans,n,&s,threads);
+    free(spans);
+    update_optimizer_counters(gradient_descent_flag,b1,b2,t,m->beta1_adam,m->beta2_adam);
 }
@@ -28,6 +28,9 @@ SOFTWARE.
 void* rmodel_thread_ff(void* _args);
 void* rmodel_thread_bp(void* _args);
 void ff_rmodel_lstm_multicore(float*** hidden_states, float*** cell_states, float*** input_model, rmodel** m, int mini_batch_size, int threads);
+void* rmodel_thread_reset(void* _args);
+void sum_rmodels_partial_derivatives_multicore(rmodel* sum_m, rmodel** models, int n_models, int reset_flag, int threads);
+void update_rmodel_multicore(rmodel* m, float lr, float momentum, int mini_batch_size, int gradient_descent_flag, float* b1, float* b2, int regularization, int total_number_weights, float lambda, unsigned long long int* t, float clipping_threshold, int threads);
 void bp_rmodel_lstm_multicore(float*** hidden_states, float*** cell_states, float*** input_model, rmodel** m, float*** error_model, int mini_batch_size, int threads, float**** returning_error, float*** returning_input_error);
 
 #endif
@@ -42,6 +42,13 @@ void* vae_model_thread_bp(void* _args) {
 }
 
 
+void* vae_model_thread_reset(void* _args) {
+    
+    // depacking args
+    reset_vae_model_except_partial_derivatives((vaemodel*) _args);
+    return _args;
+}
+
 /* This functions computes the feed forward of a vae model for a batch of instances of the dataset
  * 
  * Inputs:
@@ -58,28 +65,21 @@ void* vae_model_thread_bp(void* _args) {
  * 
  * */
 void vae_model_tensor_input_ff_multicore(vaemodel** m, int depth, int rows, int cols, float** inputs, int mini_batch_size, int threads){
-    pthread_t thread[threads];
-    thread_args_vae_model* args[threads];
+    thread_pool* pool = get_shared_thread_pool(threads);
+    thread_args_vae_model* args = (thread_args_vae_model*)malloc(sizeof(thread_args_vae_model)*mini_batch_size);
     
-    int i,j;
+    int i;
     
-    for(i = 0; i < mini_batch_size; i+=threads){
-        for(j = 0; j < threads && j+i < mini_batch_size; j++){
-            args[j] = (thread_args_vae_model*)malloc(sizeof(thread_args_vae_model));
-            args[j]->vm = m[i+j];
-            args[j]->channels = depth;
-            args[j]->rows = rows;
-            args[j]->cols = cols;
-            args[j]->input = inputs[i+j];
-            pthread_create(thread+j, NULL, vae_model_thread_ff, args[j]);
-            
-            }
-                
-        for(j = 0; j < threads && j+i < mini_batch_size; j++) {
-            pthread_join(thread[j], NULL);
-            free(args[j]);
-        }
+    for(i = 0; i < mini_batch_size; i++){
+        args[i].vm = m[i];
+        args[i].channels = depth;
+        args[i].rows = rows;
+        args[i].cols = cols;
+        args[i].input = inputs[i];
+        thread_pool_submit(pool,vae_model_thread_ff,&args[i]);
     }
+    thread_pool_wait(pool);
+    free(args);
 
 }
 
@@ -102,30 +102,55 @@ void vae_model_tensor_input_ff_multicore(vaemodel** m, int depth, int rows, int
  * 
  * */
 void vae_model_tensor_input_bp_multicore(vaemodel** m, int depth, int rows, int cols, float** inputs, int mini_batch_size, int threads,float** errors, int error_dimension, float** returning_error){
-    pthread_t thread[threads];
-    thread_args_vae_model* args[threads];
+    thread_pool* pool = get_shared_thread_pool(threads);
+    thread_args_vae_model* args = (thread_args_vae_model*)malloc(sizeof(thread_args_vae_model)*mini_batch_size);
     
-    int i,j;
+    int i;
     
-    for(i = 0; i < mini_batch_size; i+=threads){
-        for(j = 0; j < threads && j+i < mini_batch_size; j++){
-            args[j] = (thread_args_vae_model*)malloc(sizeof(thread_args_vae_model));
-            args[j]->vm = m[i+j];
-            args[j]->channels = depth;
-            args[j]->rows = rows;
-            args[j]->cols = cols;
-            args[j]->input = inputs[i+j];
-            args[j]->error = errors[i+j];
-            args[j]->error_dimension = error_dimension;
-            args[j]->returning_error = &returning_error[i+j];
-            pthread_create(thread+j, NULL, vae_model_thread_bp, args[j]);
-            
-            }
-                
-        for(j = 0; j < threads && j+i < mini_batch_size; j++) {
-            pthread_join(thread[j], NULL);
-            free(args[j]);
-        }
+    for(i = 0; i < mini_batch_size; i++){
+        args[i].vm = m[i];
+        args[i].channels = depth;
+        args[i].rows = rows;
+        args[i].cols = cols;
+        args[i].input = inputs[i];
+        args[i].error = errors[i];
+        args[i].error_dimension = error_dimension;
+        args[i].returning_error = &returning_error[i];
+        thread_pool_submit(pool,vae_model_thread_bp,&args[i]);
     }
+    thread_pool_wait(pool);
+    free(args);
 
 } 
+
+/* This function sums the partial derivatives of a batch of vae models in sum_m with the shared thread pool,
+ * the result is the same of summing them one by one with sum_vae_model_partial_derivatives. With reset_flag the vae models of the batch are also resetted,
+ * as reset_vae_model would do, in the same pass
+ * 
+ * Inputs:
+ * 
+ *             @ vaemodel* sum_m:= where are summed up the partial derivatives
+ *             @ vaemodel** models:= the vae models of the batch, dimensions: n_models
+ *             @ int n_models:= the number of vae models
+ *             @ int reset_flag:= 1 to reset the vae models of the batch
+ *             @ int threads:= the number of threads you want to use
+ * 
+ * */
+void sum_vae_models_partial_derivatives_multicore(vaemodel* sum_m, vaemodel** models, int n_models, int reset_flag, int threads){
+    int i,n = get_partial_derivatives_segments_vae_model(sum_m,NULL,NULL);
+    int* sizes = (int*)malloc(sizeof(int)*n);
+    float** sum = (float**)malloc(sizeof(float*)*n);
+    float*** replicas = (float***)malloc(sizeof(float**)*n_models);
+    get_partial_derivatives_segments_vae_model(sum_m,sum,sizes);
+    for(i = 0; i < n_models; i++){
+        replicas[i] = (float**)malloc(sizeof(float*)*n);
+        get_partial_derivatives_segments_vae_model(models[i],replicas[i],sizes);
+    }
+    sum_partial_derivatives_multicore(sum,replicas,sizes,n,n_models,reset_flag,vae_model_thread_reset,(void**)models,threads);
+    for(i = 0; i < n_models; i++){
+        free(replicas[i]);
+    }
+    free(replicas);
+    free(sum);
+    free(sizes);
+}
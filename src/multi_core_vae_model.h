@@ -29,5 +29,7 @@ void* vae_model_thread_ff(void* _args);
 void* vae_model_thread_bp(void* _args);
 void vae_model_tensor_input_ff_multicore(vaemodel** m, int depth, int rows, int cols, float** inputs, int mini_batch_size, int threads);
 void vae_model_tensor_input_bp_multicore(vaemodel** m, int depth, int rows, int cols, float** inputs, int mini_batch_size, int threads,float** errors, int error_dimension, float** returning_error);
+void* vae_model_thread_reset(void* _args);
+void sum_vae_models_partial_derivatives_multicore(vaemodel* sum_m, vaemodel** models, int n_models, int reset_flag, int threads);
 
 #endif
@@ -0,0 +1,294 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+#include "llab.h"
+
+/* Asynchronous parameter server with bounded staleness (stale synchronous parallel):
+ * the server owns the model, each client pulls the params, computes the partial derivatives and pushes them,
+ * without waiting for the other clients. Each push is applied at once with update_model.
+ * The clock of a client is the number of its pushes: a pull waits only if the client is more than staleness pushes
+ * ahead of the slowest client still connected, so a slow client stalls the others only after staleness steps
+ * (staleness = 0 is synchronous, PARAMETER_SERVER_ASYNC never waits).
+ * The partial derivatives of a push were computed on params that are now behind by some updates (the staleness of the push),
+ * the learning rate of the push is divided by 1 + that staleness, so the stale partial derivatives move the params less.
+ * The messages are the framed messages of message.c: MESSAGE_PULL is answered with a MESSAGE_VECTOR of the params
+ * with the version in the step, MESSAGE_PUSH has the partial derivatives and the version they were computed on.
+ * */
+
+/* This function creates a parameter server
+ * 
+ * Input:
+ *             @ model* m:= the model, it is updated by the server and not freed by free_parameter_server
+ *             @ int n_clients:= the clients accepted by run_parameter_server
+ *             @ int staleness:= the pushes a client can be ahead of the slowest one, >= 0 or PARAMETER_SERVER_ASYNC
+ *             @ float lr:= the learning rate
+ *             @ float momentum:= the momentum
+ *             @ int mini_batch_size:= the instances of each push
+ *             @ int gradient_descent_flag:= NESTEROV, ADAM, RADAM, DIFF_GRAD or ADAMOD
+ * 
+ * Output:
+ *             @ parameter_server*:= the server
+ * */
+parameter_server* create_parameter_server(model* m, int n_clients, int staleness, float lr, float momentum, int mini_batch_size, int gradient_descent_flag){
+    if(m == NULL || n_clients < 1 || (staleness < 0 && staleness != PARAMETER_SERVER_ASYNC)){
+        fprintf(stderr,"Error: a parameter server needs a model, at least a client and a staleness >= 0\n");
+        exit(1);
+    }
+    parameter_server* ps = (parameter_server*)calloc(1,sizeof(parameter_server));
+    ps->m = m;
+    ps->size = get_array_size_params_model(m);
+    ps->n_clients = n_clients;
+    ps->staleness = staleness;
+    ps->lr = lr;
+    ps->momentum = momentum;
+    ps->mini_batch_size = mini_batch_size;
+    ps->gradient_descent_flag = gradient_descent_flag;
+    ps->b1 = m->beta1_adam;
+    ps->b2 = m->beta2_adam;
+    ps->t = 1;
+    ps->clocks = (int*)calloc(n_clients,sizeof(int));
+    ps->active = (int*)malloc(sizeof(int)*n_clients);
+    pthread_mutex_init(&ps->lock,NULL);
+    pthread_cond_init(&ps->clock_changed,NULL);
+    return ps;
+}
+
+/* This function frees a parameter server, not its model
+ * 
+ * Input:
+ *             @ parameter_server* ps:= the server
+ * */
+void free_parameter_server(parameter_server* ps){
+    if(ps == NULL)
+        return;
+    pthread_mutex_destroy(&ps->lock);
+    pthread_cond_destroy(&ps->clock_changed);
+    free(ps->clocks);
+    free(ps->active);
+    free(ps);
+}
+
+/* This function returns the clock of the slowest client still connected, must be called with the lock
+ * 
+ * Input:
+ *             @ parameter_server* ps:= the server
+ * 
+ * Output:
+ *             @ int:= the clock, INT_MAX if no client is connected
+ * */
+int parameter_server_min_clock(parameter_server* ps){
+    int i, min = INT_MAX;
+    for(i = 0; i < ps->n_clients; i++){
+        if(ps->active[i] && ps->clocks[i] < min)
+            min = ps->clocks[i];
+    }
+    return min;
+}
+
+/* This function is the thread of a client of a parameter server: it answers the pulls with the params
+ * (waiting if the client is too far ahead) and applies the pushes to the model, until the client closes the connection
+ * 
+ * Input:
+ * 
+ *                 @ void* _args:= a thread_args_parameter_server*
+ * */
+void* parameter_server_thread(void* _args){
+    thread_args_parameter_server* args = (thread_args_parameter_server*)_args;
+    parameter_server* ps = args->ps;
+    float* buff = (float*)malloc(sizeof(float)*ps->size);
+    long long int bytes = sizeof(float)*(long long int)ps->size;
+    unsigned int version, staleness;
+    message_header header;
+    
+    while(recv_message(args->client_desc,&header,buff,bytes) != -1 && header.type != MESSAGE_CLOSE){
+        if(header.type == MESSAGE_PULL){
+            pthread_mutex_lock(&ps->lock);
+            while(ps->staleness != PARAMETER_SERVER_ASYNC && ps->clocks[args->idx]-parameter_server_min_clock(ps) > ps->staleness){
+                pthread_cond_wait(&ps->clock_changed,&ps->lock);
+            }
+            if(ps->clocks[args->idx]-parameter_server_min_clock(ps) > ps->max_gap)
+                ps->max_gap = ps->clocks[args->idx]-parameter_server_min_clock(ps);
+            memcopy_params_to_vector_model(ps->m,buff);
+            version = ps->version;
+            pthread_mutex_unlock(&ps->lock);
+            if(send_message(args->client_desc,MESSAGE_VECTOR,version,buff,bytes) == -1)
+                break;
+        }
+        else if(header.type == MESSAGE_PUSH && header.length == (unsigned long long int)bytes){
+            pthread_mutex_lock(&ps->lock);
+            staleness = ps->version-header.step;
+            ps->total_staleness+=staleness;
+            memcopy_vector_to_derivative_params_model(ps->m,buff);
+            update_model(ps->m,ps->lr/(1+staleness),ps->momentum,ps->mini_batch_size,ps->gradient_descent_flag,&ps->b1,&ps->b2,NO_REGULARIZATION,0,0,&ps->t);
+            reset_model(ps->m);
+            ps->version++;
+            ps->clocks[args->idx]++;
+            pthread_cond_broadcast(&ps->clock_changed);
+            pthread_mutex_unlock(&ps->lock);
+        }
+        else{
+            fprintf(stderr,"Error: the client %d sent a message of type %u with %llu bytes, it is disconnected\n",args->idx,header.type,header.length);
+            break;
+        }
+    }
+    
+    // the client doesn't hold back the others anymore
+    pthread_mutex_lock(&ps->lock);
+    ps->active[args->idx] = 0;
+    pthread_cond_broadcast(&ps->clock_changed);
+    pthread_mutex_unlock(&ps->lock);
+    close(args->client_desc);
+    free(buff);
+    return NULL;
+}
+
+/* This function runs a parameter server: it accepts ps->n_clients connections on a port
+ * and serves each client with a thread, it returns when all the clients closed their connection
+ * 
+ * Input:
+ *             @ parameter_server* ps:= the server
+ *             @ int port:= the port
+ * */
+void run_parameter_server(parameter_server* ps, int port){
+    int i, listen_fd = ring_listen(port);
+    pthread_t* threads = (pthread_t*)malloc(sizeof(pthread_t)*ps->n_clients);
+    thread_args_parameter_server* args = (thread_args_parameter_server*)malloc(sizeof(thread_args_parameter_server)*ps->n_clients);
+    for(i = 0; i < ps->n_clients; i++){
+        ps->clocks[i] = 0;
+        ps->active[i] = 1;
+    }
+    for(i = 0; i < ps->n_clients; i++){
+        args[i].ps = ps;
+        args[i].idx = i;
+        args[i].client_desc = accept(listen_fd,NULL,NULL);
+        if(args[i].client_desc == -1){
+            if(errno == EINTR){
+                i--;
+                continue;
+            }
+            fprintf(stderr,"Error: accept failed\n");
+            exit(1);
+        }
+        set_socket_options(args[i].client_desc);
+        pthread_create(&threads[i],NULL,parameter_server_thread,&args[i]);
+    }
+    for(i = 0; i < ps->n_clients; i++){
+        pthread_join(threads[i],NULL);
+    }
+    close(listen_fd);
+    free(threads);
+    free(args);
+}
+
+/* This function connects a client to a parameter server, trying again until the server is listening
+ * 
+ * Input:
+ *             @ char* address:= the ip address of the server
+ *             @ int port:= the port of the server
+ * 
+ * Output:
+ *             @ int:= the socket
+ * */
+int parameter_server_connect(char* address, int port){
+    int fd = ring_connect(address,port);
+    set_socket_options(fd);
+    return fd;
+}
+
+/* This function pulls the params from a parameter server, it waits if the client is too far ahead of the others
+ * 
+ * Input:
+ *             @ int fd:= the socket of parameter_server_connect
+ *             @ float* params:= where the params are copied, dimensions: size
+ *             @ int size:= the floats of the params
+ * 
+ * Output:
+ *             @ unsigned int:= the version of the params, to be pushed with the partial derivatives computed on them
+ * */
+unsigned int parameter_server_pull(int fd, float* params, int size){
+    message_header header;
+    long long int bytes = sizeof(float)*(long long int)size;
+    if(send_message(fd,MESSAGE_PULL,0,NULL,0) == -1 || recv_message(fd,&header,params,bytes) == -1 || header.type != MESSAGE_VECTOR || header.length != (unsigned long long int)bytes){
+        fprintf(stderr,"Error: the parameter server didn't send the params\n");
+        exit(1);
+    }
+    return header.step;
+}
+
+/* This function pushes the partial derivatives to a parameter server
+ * 
+ * Input:
+ *             @ int fd:= the socket of parameter_server_connect
+ *             @ unsigned int version:= the version of the params used for the partial derivatives
+ *             @ float* derivatives:= the partial derivatives, dimensions: size
+ *             @ int size:= the floats of the partial derivatives
+ * */
+void parameter_server_push(int fd, unsigned int version, float* derivatives, int size){
+    if(send_message(fd,MESSAGE_PUSH,version,derivatives,sizeof(float)*(long long int)size) == -1){
+        fprintf(stderr,"Error: can't push to the parameter server\n");
+        exit(1);
+    }
+}
+
+/* This function pulls the params of a model from a parameter server
+ * 
+ * Input:
+ *             @ int fd:= the socket of parameter_server_connect
+ *             @ model* m:= the model, with the same structure of the model of the server
+ *             @ float* vector:= a buffer, dimensions: get_array_size_params_model(m)
+ * 
+ * Output:
+ *             @ unsigned int:= the version of the params
+ * */
+unsigned int parameter_server_pull_model(int fd, model* m, float* vector){
+    unsigned int version = parameter_server_pull(fd,vector,get_array_size_params_model(m));
+    memcopy_vector_to_params_model(m,vector);
+    return version;
+}
+
+/* This function pushes the partial derivatives of a model to a parameter server and resets the model
+ * 
+ * Input:
+ *             @ int fd:= the socket of parameter_server_connect
+ *             @ model* m:= the model
+ *             @ unsigned int version:= the version returned by the pull of the params used
+ *             @ float* vector:= a buffer, dimensions: get_array_size_params_model(m)
+ * */
+void parameter_server_push_model(int fd, model* m, unsigned int version, float* vector){
+    memcopy_derivative_params_to_vector_model(m,vector);
+    parameter_server_push(fd,version,vector,get_array_size_params_model(m));
+    reset_model(m);
+}
+
+/* This function closes the connection with a parameter server
+ * 
+ * Input:
+ *             @ int fd:= the socket of parameter_server_connect
+ * */
+void parameter_server_close(int fd){
+    send_message(fd,MESSAGE_CLOSE,0,NULL,0);
+    close(fd);
+}
@@ -0,0 +1,42 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+#ifndef __PARAMETER_SERVER_H__
+#define __PARAMETER_SERVER_H__
+
+parameter_server* create_parameter_server(model* m, int n_clients, int staleness, float lr, float momentum, int mini_batch_size, int gradient_descent_flag);
+void free_parameter_server(parameter_server* ps);
+int parameter_server_min_clock(parameter_server* ps);
+void* parameter_server_thread(void* _args);
+void run_parameter_server(parameter_server* ps, int port);
+int parameter_server_connect(char* address, int port);
+unsigned int parameter_server_pull(int fd, float* params, int size);
+void parameter_server_push(int fd, unsigned int version, float* derivatives, int size);
+unsigned int parameter_server_pull_model(int fd, model* m, float* vector);
+void parameter_server_push_model(int fd, model* m, unsigned int version, float* vector);
+void parameter_server_close(int fd);
+
+#endif
@@ -0,0 +1,738 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include "llab.h"
+
+/* This function stores the 6 slots of a tensor (params, partial derivatives, d1, d2, d3, ex_d_diff_grad)
+ * in the position n of tensors and sizes. If one of the slots is not allocated the tensor can't
+ * be moved in an arena: if required the program exits, otherwise the tensor is skipped
+ * 
+ * Inputs:
+ * 
+ *             @ float*** tensors:= n_tensors*ARENA_SLOTS, where the addresses of the slots are stored, if NULL the tensor is only counted
+ *             @ int* sizes:= n_tensors, where the size of the tensor is stored
+ *             @ int n:= the position of the tensor
+ *             @ int size:= the number of floats of each slot of the tensor
+ *             @ int required:= 1 if the tensor must be allocated, 0 otherwise
+ *             @ float** params:= the address of the params pointer
+ *             @ float** d:= the address of the partial derivatives pointer
+ *             @ float** d1:= the address of the d1 pointer
+ *             @ float** d2:= the address of the d2 pointer
+ *             @ float** d3:= the address of the d3 pointer
+ *             @ float** ex:= the address of the ex_d_diff_grad pointer
+ * 
+ * Output:
+ *             @ int:= 1 if the tensor has been stored, 0 otherwise
+ * */
+int set_arena_tensor(float*** tensors, int* sizes, int n, int size, int required, float** params, float** d, float** d1, float** d2, float** d3, float** ex){
+    if(*params == NULL || *d == NULL || *d1 == NULL || *d2 == NULL || *d3 == NULL || *ex == NULL){
+        if(required){
+            fprintf(stderr,"Error: the params of a layer can't be moved in an arena because some of their arrays are not allocated\n");
+            exit(1);
+        }
+        return 0;
+    }
+    if(tensors != NULL){
+        tensors[n*ARENA_SLOTS+ARENA_PARAMS] = params;
+        tensors[n*ARENA_SLOTS+ARENA_DERIVATIVES] = d;
+        tensors[n*ARENA_SLOTS+ARENA_D1] = d1;
+        tensors[n*ARENA_SLOTS+ARENA_D2] = d2;
+        tensors[n*ARENA_SLOTS+ARENA_D3] = d3;
+        tensors[n*ARENA_SLOTS+ARENA_EX_D_DIFF_GRAD] = ex;
+        sizes[n] = size;
+    }
+    return 1;
+}
+
+/* This function stores the tensors of a bn layer starting from the position n: gamma then beta
+ * 
+ * Inputs:
+ * 
+ *             @ bn* b:= the batch normalized layer
+ *             @ float*** tensors:= where the addresses of the slots are stored, if NULL the tensors are only counted
+ *             @ int* sizes:= where the sizes of the tensors are stored
+ *             @ int n:= the position of the first tensor
+ *             @ int required:= 1 if the tensors must be allocated, 0 otherwise
+ * 
+ * Output:
+ *             @ int:= the number of tensors stored
+ * */
+int get_arena_tensors_bn(bn* b, float*** tensors, int* sizes, int n, int required){
+    int count = n;
+    count += set_arena_tensor(tensors,sizes,count,b->vector_dim,required,&b->gamma,&b->d_gamma,&b->d1_gamma,&b->d2_gamma,&b->d3_gamma,&b->ex_d_gamma_diff_grad);
+    count += set_arena_tensor(tensors,sizes,count,b->vector_dim,required,&b->beta,&b->d_beta,&b->d1_beta,&b->d2_beta,&b->d3_beta,&b->ex_d_beta_diff_grad);
+    return count-n;
+}
+
+/* This function stores the tensors of a fcl layer starting from the position n.
+ * The params tensors (weights and biases) follow the order of memcopy_params_to_vector,
+ * the tail tensors are the scores and the layer normalization
+ * 
+ * Inputs:
+ * 
+ *             @ fcl* f:= the fully-connected layer
+ *             @ float*** tensors:= where the addresses of the slots are stored, if NULL the tensors are only counted
+ *             @ int* sizes:= where the sizes of the tensors are stored
+ *             @ int n:= the position of the first tensor
+ *             @ int tail_flag:= 0 for the params tensors, 1 for the tail tensors
+ * 
+ * Output:
+ *             @ int:= the number of tensors stored
+ * */
+int get_arena_tensors_fcl(fcl* f, float*** tensors, int* sizes, int n, int tail_flag){
+    int count = n;
+    if(!tail_flag){
+        count += set_arena_tensor(tensors,sizes,count,f->input*f->output,1,&f->weights,&f->d_weights,&f->d1_weights,&f->d2_weights,&f->d3_weights,&f->ex_d_weights_diff_grad);
+        count += set_arena_tensor(tensors,sizes,count,f->output,1,&f->biases,&f->d_biases,&f->d1_biases,&f->d2_biases,&f->d3_biases,&f->ex_d_biases_diff_grad);
+    }
+    else{
+        count += set_arena_tensor(tensors,sizes,count,f->input*f->output,0,&f->scores,&f->d_scores,&f->d1_scores,&f->d2_scores,&f->d3_scores,&f->ex_d_scores_diff_grad);
+        if(f->normalization_flag == LAYER_NORMALIZATION && f->layer_norm != NULL)
+            count += get_arena_tensors_bn(f->layer_norm,tensors,sizes,count,0);
+    }
+    return count-n;
+}
+
+/* This function stores the tensors of a cl layer starting from the position n.
+ * The params tensors (kernels, biases, group normalization gammas and betas) follow the order of memcopy_params_to_vector_cl,
+ * the tail tensors are the scores
+ * 
+ * Inputs:
+ * 
+ *             @ cl* c:= the convolutional layer
+ *             @ float*** tensors:= where the addresses of the slots are stored, if NULL the tensors are only counted
+ *             @ int* sizes:= where the sizes of the tensors are stored
+ *             @ int n:= the position of the first tensor
+ *             @ int tail_flag:= 0 for the params tensors, 1 for the tail tensors
+ * 
+ * Output:
+ *             @ int:= the number of tensors stored
+ * */
+int get_arena_tensors_cl(cl* c, float*** tensors, int* sizes, int n, int tail_flag){
+    int i,count = n, kernel_size = c->channels*c->kernel_rows*c->kernel_cols;
+    if(!tail_flag){
+        for(i = 0; i < c->n_kernels; i++){
+            count += set_arena_tensor(tensors,sizes,count,kernel_size,1,&c->kernels[i],&c->d_kernels[i],&c->d1_kernels[i],&c->d2_kernels[i],&c->d3_kernels[i],&c->ex_d_kernels_diff_grad[i]);
+        }
+        count += set_arena_tensor(tensors,sizes,count,c->n_kernels,1,&c->biases,&c->d_biases,&c->d1_biases,&c->d2_biases,&c->d3_biases,&c->ex_d_biases_diff_grad);
+        if(c->normalization_flag == GROUP_NORMALIZATION){
+            for(i = 0; i < c->n_kernels/c->group_norm_channels; i++){
+                bn* b = c->group_norm[i];
+                count += set_arena_tensor(tensors,sizes,count,b->vector_dim,1,&b->gamma,&b->d_gamma,&b->d1_gamma,&b->d2_gamma,&b->d3_gamma,&b->ex_d_gamma_diff_grad);
+            }
+            for(i = 0; i < c->n_kernels/c->group_norm_channels; i++){
+                bn* b = c->group_norm[i];
+                count += set_arena_tensor(tensors,sizes,count,b->vector_dim,1,&b->beta,&b->d_beta,&b->d1_beta,&b->d2_beta,&b->d3_beta,&b->ex_d_beta_diff_grad);
+            }
+        }
+    }
+    else{
+        count += set_arena_tensor(tensors,sizes,count,c->n_kernels*kernel_size,0,&c->scores,&c->d_scores,&c->d1_scores,&c->d2_scores,&c->d3_scores,&c->ex_d_scores_diff_grad);
+    }
+    return count-n;
+}
+
+/* This function stores the tensors of a rl layer starting from the position n.
+ * The params tensors are the ones of the convolutional layers in order,
+ * the tail tensors are the tail of the convolutional layers and all the tensors of cl_output
+ * 
+ * Inputs:
+ * 
+ *             @ rl* r:= the residual layer
+ *             @ float*** tensors:= where the addresses of the slots are stored, if NULL the tensors are only counted
+ *             @ int* sizes:= where the sizes of the tensors are stored
+ *             @ int n:= the position of the first tensor
+ *             @ int tail_flag:= 0 for the params tensors, 1 for the tail tensors
+ * 
+ * Output:
+ *             @ int:= the number of tensors stored
+ * */
+int get_arena_tensors_rl(rl* r, float*** tensors, int* sizes, int n, int tail_flag){
+    int i,count = n;
+    for(i = 0; i < r->n_cl; i++){
+        count += get_arena_tensors_cl(r->cls[i],tensors,sizes,count,tail_flag);
+    }
+    if(tail_flag && r->cl_output != NULL){
+        count += get_arena_tensors_cl(r->cl_output,tensors,sizes,count,0);
+        count += get_arena_tensors_cl(r->cl_output,tensors,sizes,count,1);
+    }
+    return count-n;
+}
+
+/* This function stores the tensors of a lstm layer starting from the position n.
+ * The params tensors are w[i] and u[i] interleaved, the 4 biases and the group normalization gammas and betas
+ * as in memcopy_params_to_vector_lstm, there are no tail tensors
+ * 
+ * Inputs:
+ * 
+ *             @ lstm* l:= the lstm layer
+ *             @ float*** tensors:= where the addresses of the slots are stored, if NULL the tensors are only counted
+ *             @ int* sizes:= where the sizes of the tensors are stored
+ *             @ int n:= the position of the first tensor
+ *             @ int tail_flag:= 0 for the params tensors, 1 for the tail tensors
+ * 
+ * Output:
+ *             @ int:= the number of tensors stored
+ * */
+int get_arena_tensors_lstm(lstm* l, float*** tensors, int* sizes, int n, int tail_flag){
+    int i,count = n;
+    if(tail_flag)
+        return 0;
+    for(i = 0; i < l->n_gates; i++){
+        count += set_arena_tensor(tensors,sizes,count,l->size*l->size,1,&l->w[i],&l->d_w[i],&l->d1_w[i],&l->d2_w[i],&l->d3_w[i],&l->ex_d_w_diff_grad[i]);
+        count += set_arena_tensor(tensors,sizes,count,l->size*l->size,1,&l->u[i],&l->d_u[i],&l->d1_u[i],&l->d2_u[i],&l->d3_u[i],&l->ex_d_u_diff_grad[i]);
+    }
+    for(i = 0; i < l->n_gates; i++){
+        count += set_arena_tensor(tensors,sizes,count,l->size,1,&l->biases[i],&l->d_biases[i],&l->d1_biases[i],&l->d2_biases[i],&l->d3_biases[i],&l->ex_d_biases_diff_grad[i]);
+    }
+    if(l->norm_flag == GROUP_NORMALIZATION){
+        for(i = 0; i < l->window/l->n_grouped_cell; i++){
+            bn* b = l->bns[i];
+            count += set_arena_tensor(tensors,sizes,count,b->vector_dim,1,&b->gamma,&b->d_gamma,&b->d1_gamma,&b->d2_gamma,&b->d3_gamma,&b->ex_d_gamma_diff_grad);
+        }
+        for(i = 0; i < l->window/l->n_grouped_cell; i++){
+            bn* b = l->bns[i];
+            count += set_arena_tensor(tensors,sizes,count,b->vector_dim,1,&b->beta,&b->d_beta,&b->d1_beta,&b->d2_beta,&b->d3_beta,&b->ex_d_beta_diff_grad);
+        }
+    }
+    return count-n;
+}
+
+/* This function stores all the tensors of a model: first the params tensors of the fully-connected,
+ * convolutional and residual layers (the same order of memcopy_params_to_vector_model), then the tail tensors
+ * 
+ * Inputs:
+ * 
+ *             @ model* m:= the model
+ *             @ float*** tensors:= where the addresses of the slots are stored, if NULL the tensors are only counted
+ *             @ int* sizes:= where the sizes of the tensors are stored
+ *             @ int* n_params_tensors:= where the number of params tensors is stored, can be NULL
+ * 
+ * Output:
+ *             @ int:= the number of tensors
+ * */
+int get_arena_tensors_model(model* m, float*** tensors, int* sizes, int* n_params_tensors){
+    int i,j,n = 0;
+    for(j = 0; j < 2; j++){
+        if(j == 1 && n_params_tensors != NULL)
+            (*n_params_tensors) = n;
+        for(i = 0; i < m->n_fcl; i++){
+            n += get_arena_tensors_fcl(m->fcls[i],tensors,sizes,n,j);
+        }
+        for(i = 0; i < m->n_cl; i++){
+            n += get_arena_tensors_cl(m->cls[i],tensors,sizes,n,j);
+        }
+        for(i = 0; i < m->n_rl; i++){
+            n += get_arena_tensors_rl(m->rls[i],tensors,sizes,n,j);
+        }
+    }
+    return n;
+}
+
+/* This function stores all the tensors of a rmodel, the lstm layers in order
+ * 
+ * Inputs:
+ * 
+ *             @ rmodel* m:= the rmodel
+ *             @ float*** tensors:= where the addresses of the slots are stored, if NULL the tensors are only counted
+ *             @ int* sizes:= where the sizes of the tensors are stored
+ *             @ int* n_params_tensors:= where the number of params tensors is stored, can be NULL
+ * 
+ * Output:
+ *             @ int:= the number of tensors
+ * */
+int get_arena_tensors_rmodel(rmodel* m, float*** tensors, int* sizes, int* n_params_tensors){
+    int i,n = 0;
+    for(i = 0; i < m->n_lstm; i++){
+        n += get_arena_tensors_lstm(m->lstms[i],tensors,sizes,n,0);
+    }
+    if(n_params_tensors != NULL)
+        (*n_params_tensors) = n;
+    return n;
+}
+
+/* This function allocates an arena for the tensors and moves them inside it:
+ * each slot of each tensor is copied in the arena, the old array is freed and
+ * the pointer of the layer is set to the position inside the arena.
+ * The tensors are laid one after the other in the same order in every slot
+ * 
+ * Inputs:
+ * 
+ *             @ float*** tensors:= n_tensors*ARENA_SLOTS, the addresses of the slots
+ *             @ int* sizes:= n_tensors, the sizes of the tensors
+ *             @ int n_tensors:= the number of tensors
+ *             @ int n_params_tensors:= the first n_params_tensors are the params region of the arena
+ * 
+ * Output:
+ *             @ params_arena*:= the arena
+ * */
+params_arena* params_arena_init(float*** tensors, int* sizes, int n_tensors, int n_params_tensors){
+    int i,j,offset,stride,floats_per_line = ARENA_ALIGNMENT/sizeof(float);
+    void* memory = NULL;
+    params_arena* a = (params_arena*)malloc(sizeof(params_arena));
+    a->size = 0;
+    a->params_size = 0;
+    for(i = 0; i < n_tensors; i++){
+        a->size += sizes[i];
+        if(i < n_params_tensors)
+            a->params_size += sizes[i];
+    }
+    stride = ((a->size+floats_per_line-1)/floats_per_line)*floats_per_line;
+    if(stride == 0)
+        stride = floats_per_line;
+    if(posix_memalign(&memory,ARENA_ALIGNMENT,sizeof(float)*stride*ARENA_SLOTS)){
+        fprintf(stderr,"Error: not enough memory to allocate the params arena\n");
+        exit(1);
+    }
+    a->memory = (float*)memory;
+    memset(a->memory,0,sizeof(float)*stride*ARENA_SLOTS);
+    for(j = 0; j < ARENA_SLOTS; j++){
+        a->slots[j] = &a->memory[j*stride];
+    }
+    
+    for(i = 0, offset = 0; i < n_tensors; offset+=sizes[i], i++){
+        for(j = 0; j < ARENA_SLOTS; j++){
+            copy_array(*tensors[i*ARENA_SLOTS+j],&a->slots[j][offset],sizes[i]);
+            free(*tensors[i*ARENA_SLOTS+j]);
+            *tensors[i*ARENA_SLOTS+j] = &a->slots[j][offset];
+        }
+    }
+    return a;
+}
+
+/* This function sets to NULL the pointers of the layers that live inside an arena,
+ * after it the layers can be freed with the usual functions
+ * 
+ * Inputs:
+ * 
+ *             @ float*** tensors:= n_tensors*ARENA_SLOTS, the addresses of the slots
+ *             @ int n_tensors:= the number of tensors
+ * */
+void detach_params_arena(float*** tensors, int n_tensors){
+    int i;
+    for(i = 0; i < n_tensors*ARENA_SLOTS; i++){
+        *tensors[i] = NULL;
+    }
+}
+
+/* This function frees the space allocated by an arena
+ * 
+ * Inputs:
+ * 
+ *             @ params_arena* a:= the arena
+ * */
+void free_params_arena(params_arena* a){
+    if(a == NULL)
+        return;
+    free(a->memory);
+    free(a);
+}
+
+/* This function moves weights, biases, partial derivatives and the optimizer arrays (d1, d2, d3, ex_d_diff_grad)
+ * of all the layers of a model in a params_arena: each slot becomes a single aligned contiguous buffer
+ * with the layers pointing inside it. The first arena->params_size floats of each slot follow the layout
+ * of memcopy_params_to_vector_model, so copy, paste, sum and the distributed training can work on a single sweep.
+ * The model must own its layers (no share_* layers inside it) and must be made contiguous before
+ * sharing its layers with other structures (batch_model, share_model_prefix ...), the arena is freed by free_model
+ * 
+ * Inputs:
+ * 
+ *             @ model* m:= the model
+ * */
+void make_model_contiguous(model* m){
+    if(m == NULL || m->arena != NULL)
+        return;
+    if(m->shared_params_flag){
+        fprintf(stderr,"Error: the params of this model belong to another model, make that one contiguous\n");
+        exit(1);
+    }
+    int n_params_tensors;
+    int n = get_arena_tensors_model(m,NULL,NULL,NULL);
+    float*** tensors = (float***)malloc(sizeof(float**)*n*ARENA_SLOTS);
+    int* sizes = (int*)malloc(sizeof(int)*n);
+    get_arena_tensors_model(m,tensors,sizes,&n_params_tensors);
+    m->arena = params_arena_init(tensors,sizes,n,n_params_tensors);
+    if(m->arena->params_size != get_array_size_params_model(m)){
+        fprintf(stderr,"Error: the params region of the arena doesn't match the params of the model\n");
+        exit(1);
+    }
+    free(tensors);
+    free(sizes);
+}
+
+/* This function moves the params of all the lstm layers of a rmodel in a params_arena,
+ * see make_model_contiguous. The arena is freed by free_rmodel
+ * 
+ * Inputs:
+ * 
+ *             @ rmodel* m:= the rmodel
+ * */
+void make_rmodel_contiguous(rmodel* m){
+    if(m == NULL || m->arena != NULL)
+        return;
+    if(m->shared_params_flag){
+        fprintf(stderr,"Error: the params of this rmodel belong to another rmodel, make that one contiguous\n");
+        exit(1);
+    }
+    int n_params_tensors;
+    int n = get_arena_tensors_rmodel(m,NULL,NULL,NULL);
+    float*** tensors = (float***)malloc(sizeof(float**)*n*ARENA_SLOTS);
+    int* sizes = (int*)malloc(sizeof(int)*n);
+    get_arena_tensors_rmodel(m,tensors,sizes,&n_params_tensors);
+    m->arena = params_arena_init(tensors,sizes,n,n_params_tensors);
+    free(tensors);
+    free(sizes);
+}
+
+/* This function moves the params of the encoder and of the decoder of a vaemodel
+ * each one in its own params_arena, see make_model_contiguous
+ * 
+ * Inputs:
+ * 
+ *             @ vaemodel* vm:= the variational autoencoder
+ * */
+void make_vae_model_contiguous(vaemodel* vm){
+    if(vm == NULL)
+        return;
+    make_model_contiguous(vm->encoder);
+    make_model_contiguous(vm->decoder);
+}
+
+/* This function detaches the layers of a model from its arena and frees the arena,
+ * the layers are left without params, it is called by free_model
+ * 
+ * Inputs:
+ * 
+ *             @ model* m:= the model
+ * */
+void free_model_arena(model* m){
+    if(m == NULL || m->arena == NULL)
+        return;
+    int n = get_arena_tensors_model(m,NULL,NULL,NULL);
+    float*** tensors = (float***)malloc(sizeof(float**)*n*ARENA_SLOTS);
+    int* sizes = (int*)malloc(sizeof(int)*n);
+    get_arena_tensors_model(m,tensors,sizes,NULL);
+    detach_params_arena(tensors,n);
+    free_params_arena(m->arena);
+    m->arena = NULL;
+    free(tensors);
+    free(sizes);
+}
+
+/* This function detaches the layers of a rmodel from its arena and frees the arena,
+ * the layers are left without params, it is called by free_rmodel
+ * 
+ * Inputs:
+ * 
+ *             @ rmodel* m:= the rmodel
+ * */
+void free_rmodel_arena(rmodel* m){
+    if(m == NULL || m->arena == NULL)
+        return;
+    int n = get_arena_tensors_rmodel(m,NULL,NULL,NULL);
+    float*** tensors = (float***)malloc(sizeof(float**)*n*ARENA_SLOTS);
+    int* sizes = (int*)malloc(sizeof(int)*n);
+    get_arena_tensors_rmodel(m,tensors,sizes,NULL);
+    detach_params_arena(tensors,n);
+    free_params_arena(m->arena);
+    m->arena = NULL;
+    free(tensors);
+    free(sizes);
+}
+
+/* This function moves a slot of the arena of a model in another buffer (for example a shared memory segment),
+ * the layers are pointed inside the new buffer. With memory = NULL the slot goes back to the memory of the arena.
+ * The buffer is not freed by free_model, to use the model after the buffer is released the slot must be moved back
+ * 
+ * Inputs:
+ * 
+ *             @ model* m:= the model, made contiguous
+ *             @ int slot:= ARENA_PARAMS, ARENA_DERIVATIVES, ARENA_D1, ARENA_D2, ARENA_D3 or ARENA_EX_D_DIFF_GRAD
+ *             @ float* memory:= the new buffer, dimensions: m->arena->size, or NULL
+ *             @ int copy_flag:= 1 to copy the slot in the new buffer, 0 to leave the buffer as it is
+ * */
+void move_model_arena_slot(model* m, int slot, float* memory, int copy_flag){
+    if(m == NULL || m->arena == NULL){
+        fprintf(stderr,"Error: the model must be made contiguous before moving its arena\n");
+        exit(1);
+    }
+    // the same stride of params_arena_init
+    int i,offset,floats_per_line = ARENA_ALIGNMENT/sizeof(float);
+    int stride = ((m->arena->size+floats_per_line-1)/floats_per_line)*floats_per_line;
+    if(stride == 0)
+        stride = floats_per_line;
+    if(memory == NULL)
+        memory = &m->arena->memory[slot*stride];
+    if(memory == m->arena->slots[slot])
+        return;
+    int n = get_arena_tensors_model(m,NULL,NULL,NULL);
+    float*** tensors = (float***)malloc(sizeof(float**)*n*ARENA_SLOTS);
+    int* sizes = (int*)malloc(sizeof(int)*n);
+    get_arena_tensors_model(m,tensors,sizes,NULL);
+    if(copy_flag)
+        copy_array(m->arena->slots[slot],memory,m->arena->size);
+    for(i = 0, offset = 0; i < n; offset+=sizes[i], i++){
+        *tensors[i*ARENA_SLOTS+slot] = &memory[offset];
+    }
+    m->arena->slots[slot] = memory;
+    if(slot == ARENA_PARAMS)
+        invalidate_model_winograd_kernels(m);
+    free(tensors);
+    free(sizes);
+}
+
+/* This function returns 1 if the two arenas can be used in a single sweep (same sizes), 0 otherwise
+ * 
+ * Inputs:
+ * 
+ *             @ params_arena* a1:= the first arena, can be NULL
+ *             @ params_arena* a2:= the second arena, can be NULL
+ * */
+int same_params_arena(params_arena* a1, params_arena* a2){
+    if(a1 == NULL || a2 == NULL)
+        return 0;
+    return a1->size == a2->size && a1->params_size == a2->params_size;
+}
+
+/* This function returns 1 if all the state pasted by paste_model lives inside the arena of m,
+ * so that a model can be pasted with paste_params_arena. The layers with edge-popup or normalization
+ * have other arrays (indices, running means ...) that must be pasted layer by layer
+ * 
+ * Inputs:
+ * 
+ *             @ model* m:= the model
+ * */
+int model_state_lives_in_arena(model* m){
+    if(m == NULL || m->arena == NULL)
+        return 0;
+    int i,j;
+    for(i = 0; i < m->n_fcl; i++){
+        if(m->fcls[i]->training_mode == EDGE_POPUP || m->fcls[i]->feed_forward_flag == EDGE_POPUP || m->fcls[i]->normalization_flag == LAYER_NORMALIZATION)
+            return 0;
+    }
+    for(i = 0; i < m->n_cl; i++){
+        if(m->cls[i]->feed_forward_flag == EDGE_POPUP || m->cls[i]->normalization_flag == GROUP_NORMALIZATION)
+            return 0;
+    }
+    for(i = 0; i < m->n_rl; i++){
+        for(j = 0; j < m->rls[i]->n_cl; j++){
+            if(m->rls[i]->cls[j]->feed_forward_flag == EDGE_POPUP || m->rls[i]->cls[j]->normalization_flag == GROUP_NORMALIZATION)
+                return 0;
+        }
+    }
+    return 1;
+}
+
+/* This function returns 1 if all the state pasted by paste_rmodel lives inside the arena of m, see model_state_lives_in_arena
+ * 
+ * Inputs:
+ * 
+ *             @ rmodel* m:= the rmodel
+ * */
+int rmodel_state_lives_in_arena(rmodel* m){
+    if(m == NULL || m->arena == NULL)
+        return 0;
+    int i;
+    for(i = 0; i < m->n_lstm; i++){
+        if(m->lstms[i]->norm_flag == GROUP_NORMALIZATION)
+            return 0;
+    }
+    return 1;
+}
+
+/* This function copies all the slots of an arena into another one with the same size
+ * 
+ * Inputs:
+ * 
+ *             @ params_arena* a:= the source arena
+ *             @ params_arena* copy:= the destination arena
+ * */
+void paste_params_arena(params_arena* a, params_arena* copy){
+    int j;
+    for(j = 0; j < ARENA_SLOTS; j++){
+        copy_array(a->slots[j],copy->slots[j],a->size);
+    }
+}
+
+/* This function sums the partial derivatives slot of a1 and a2 in a3 with a single sweep
+ * 
+ * Inputs:
+ * 
+ *             @ params_arena* a1:= the first arena
+ *             @ params_arena* a2:= the second arena
+ *             @ params_arena* a3:= the output arena
+ * */
+void sum_params_arena_partial_derivatives(params_arena* a1, params_arena* a2, params_arena* a3){
+    sum1D(a1->slots[ARENA_DERIVATIVES],a2->slots[ARENA_DERIVATIVES],a3->slots[ARENA_DERIVATIVES],a1->size);
+}
+
+/* This function zeroes the partial derivatives slot of an arena
+ * 
+ * Inputs:
+ * 
+ *             @ params_arena* a:= the arena
+ * */
+void reset_params_arena_partial_derivatives(params_arena* a){
+    memset(a->slots[ARENA_DERIVATIVES],0,sizeof(float)*a->size);
+}
+
+/* This function returns 1 if update_model can update m with a single sweep over its arena,
+ * the layers trained with edge-popup update the scores and are left to the layer by layer update
+ * 
+ * Inputs:
+ * 
+ *             @ model* m:= the model
+ * */
+int fused_update_supported_model(model* m){
+    if(!model_state_lives_in_arena(m))
+        return 0;
+    int i,j;
+    for(i = 0; i < m->n_cl; i++){
+        if(m->cls[i]->training_mode == EDGE_POPUP)
+            return 0;
+    }
+    for(i = 0; i < m->n_rl; i++){
+        for(j = 0; j < m->rls[i]->n_cl; j++){
+            if(m->rls[i]->cls[j]->training_mode == EDGE_POPUP)
+                return 0;
+        }
+    }
+    return 1;
+}
+
+/* This function returns 1 if update_rmodel can update m with a single sweep over its arena
+ * 
+ * Inputs:
+ * 
+ *             @ rmodel* m:= the rmodel
+ * */
+int fused_update_supported_rmodel(rmodel* m){
+    return rmodel_state_lives_in_arena(m);
+}
+
+/* This function appends a span to spans, merging it with the last one if they are adjacent and have the same flags.
+ * returns the new number of spans
+ * 
+ * Inputs:
+ * 
+ *             @ optimizer_span* spans:= the spans, can be NULL, in that case the spans are only counted (without merging)
+ *             @ int n:= the number of spans already inside spans
+ *             @ int offset:= the offset of the span from the params slot of the arena
+ *             @ int size:= the size of the span
+ *             @ int flags:= OPTIMIZER_SPAN_UPDATE | OPTIMIZER_SPAN_L2 | OPTIMIZER_SPAN_NORM
+ * */
+int add_optimizer_span(optimizer_span* spans, int n, int offset, int size, int flags){
+    if(!flags || !size)
+        return n;
+    if(spans == NULL)
+        return n+1;
+    if(n && spans[n-1].flags == flags && spans[n-1].offset+spans[n-1].size == offset){
+        spans[n-1].size+=size;
+        return n;
+    }
+    spans[n].offset = offset;
+    spans[n].size = size;
+    spans[n].flags = flags;
+    return n+1;
+}
+
+/* This function appends the spans of a convolutional layer living in the arena a
+ * 
+ * Inputs:
+ * 
+ *             @ cl* c:= the convolutional layer
+ *             @ params_arena* a:= the arena
+ *             @ optimizer_span* spans:= the spans, can be NULL
+ *             @ int n:= the number of spans already inside spans
+ * */
+int get_update_spans_cl(cl* c, params_arena* a, optimizer_span* spans, int n){
+    int flags = 0, trainable = c->convolutional_flag == CONVOLUTION && c->training_mode == GRADIENT_DESCENT;
+    if(trainable)
+        flags |= OPTIMIZER_SPAN_UPDATE | OPTIMIZER_SPAN_L2;
+    if(c->convolutional_flag == CONVOLUTION || c->convolutional_flag == TRANSPOSED_CONVOLUTION)
+        flags |= OPTIMIZER_SPAN_NORM;
+    n = add_optimizer_span(spans,n,c->kernels[0]-a->slots[ARENA_PARAMS],c->n_kernels*c->channels*c->kernel_rows*c->kernel_cols,flags);
+    if(trainable)
+        n = add_optimizer_span(spans,n,c->biases-a->slots[ARENA_PARAMS],c->n_kernels,OPTIMIZER_SPAN_UPDATE);
+    return n;
+}
+
+/* This function fills spans with the spans of the arena of m that update_model must touch,
+ * the span flags follow update_model, add_l2_* and clipping_gradient. Returns the number of spans
+ * 
+ * Inputs:
+ * 
+ *             @ model* m:= the model, fused_update_supported_model(m) must be 1
+ *             @ optimizer_span* spans:= the spans, can be NULL, in that case the spans are only counted
+ * */
+int get_update_spans_model(model* m, optimizer_span* spans){
+    int i,j,n = 0,flags;
+    params_arena* a = m->arena;
+    for(i = 0; i < m->n_fcl; i++){
+        fcl* f = m->fcls[i];
+        int trainable = f->training_mode != FREEZE_TRAINING && f->feed_forward_flag != ONLY_DROPOUT;
+        flags = 0;
+        if(trainable)
+            flags |= OPTIMIZER_SPAN_UPDATE | OPTIMIZER_SPAN_L2;
+        if(f->feed_forward_flag != ONLY_DROPOUT)
+            flags |= OPTIMIZER_SPAN_NORM;
+        n = add_optimizer_span(spans,n,f->weights-a->slots[ARENA_PARAMS],f->input*f->output,flags);
+        if(trainable)
+            n = add_optimizer_span(spans,n,f->biases-a->slots[ARENA_PARAMS],f->output,OPTIMIZER_SPAN_UPDATE);
+    }
+    for(i = 0; i < m->n_cl; i++){
+        n = get_update_spans_cl(m->cls[i],a,spans,n);
+    }
+    for(i = 0; i < m->n_rl; i++){
+        for(j = 0; j < m->rls[i]->n_cl; j++){
+            n = get_update_spans_cl(m->rls[i]->cls[j],a,spans,n);
+        }
+    }
+    return n;
+}
+
+/* This function fills spans with the spans of the arena of m that update_rmodel must touch,
+ * see get_update_spans_model
+ * 
+ * Inputs:
+ * 
+ *             @ rmodel* m:= the rmodel, fused_update_supported_rmodel(m) must be 1
+ *             @ optimizer_span* spans:= the spans, can be NULL
+ * */
+int get_update_spans_rmodel(rmodel* m, optimizer_span* spans){
+    int i,j,n = 0;
+    params_arena* a = m->arena;
+    for(i = 0; i < m->n_lstm; i++){
+        lstm* l = m->lstms[i];
+        for(j = 0; j < l->n_gates; j++){
+            n = add_optimizer_span(spans,n,l->w[j]-a->slots[ARENA_PARAMS],l->size*l->size,OPTIMIZER_SPAN_UPDATE | OPTIMIZER_SPAN_L2 | OPTIMIZER_SPAN_NORM);
+            n = add_optimizer_span(spans,n,l->u[j]-a->slots[ARENA_PARAMS],l->size*l->size,OPTIMIZER_SPAN_UPDATE | OPTIMIZER_SPAN_L2 | OPTIMIZER_SPAN_NORM);
+        }
+        for(j = 0; j < l->n_gates; j++){
+            n = add_optimizer_span(spans,n,l->biases[j]-a->slots[ARENA_PARAMS],l->size,OPTIMIZER_SPAN_UPDATE);
+        }
+    }
+    return n;
+}
@@ -0,0 +1,59 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef __PARAMS_ARENA_H__
+#define __PARAMS_ARENA_H__
+
+int set_arena_tensor(float*** tensors, int* sizes, int n, int size, int required, float** params, float** d, float** d1, float** d2, float** d3, float** ex);
+int get_arena_tensors_bn(bn* b, float*** tensors, int* sizes, int n, int required);
+int get_arena_tensors_fcl(fcl* f, float*** tensors, int* sizes, int n, int tail_flag);
+int get_arena_tensors_cl(cl* c, float*** tensors, int* sizes, int n, int tail_flag);
+int get_arena_tensors_rl(rl* r, float*** tensors, int* sizes, int n, int tail_flag);
+int get_arena_tensors_lstm(lstm* l, float*** tensors, int* sizes, int n, int tail_flag);
+int get_arena_tensors_model(model* m, float*** tensors, int* sizes, int* n_params_tensors);
+int get_arena_tensors_rmodel(rmodel* m, float*** tensors, int* sizes, int* n_params_tensors);
+params_arena* params_arena_init(float*** tensors, int* sizes, int n_tensors, int n_params_tensors);
+void detach_params_arena(float*** tensors, int n_tensors);
+void free_params_arena(params_arena* a);
+void make_model_contiguous(model* m);
+void make_rmodel_contiguous(rmodel* m);
+void make_vae_model_contiguous(vaemodel* vm);
+void free_model_arena(model* m);
+void free_rmodel_arena(rmodel* m);
+void move_model_arena_slot(model* m, int slot, float* memory, int copy_flag);
+int same_params_arena(params_arena* a1, params_arena* a2);
+int model_state_lives_in_arena(model* m);
+int rmodel_state_lives_in_arena(rmodel* m);
+void paste_params_arena(params_arena* a, params_arena* copy);
+void sum_params_arena_partial_derivatives(params_arena* a1, params_arena* a2, params_arena* a3);
+void reset_params_arena_partial_derivatives(params_arena* a);
+int fused_update_supported_model(model* m);
+int fused_update_supported_rmodel(rmodel* m);
+int add_optimizer_span(optimizer_span* spans, int n, int offset, int size, int flags);
+int get_update_spans_cl(cl* c, params_arena* a, optimizer_span* spans, int n);
+int get_update_spans_model(model* m, optimizer_span* spans);
+int get_update_spans_rmodel(rmodel* m, optimizer_span* spans);
+
+#endif
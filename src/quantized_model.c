@@ -0,0 +1,1303 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+#include "llab.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define QUANTIZED_X86
+#endif
+
+/* Post-training int8 quantization of the sequential models used for inference (model_tensor_input_ff with DROPOUT_TEST).
+ * The weights of each fully-connected layer and of each kernel are quantized with a scale for each output channel,
+ * the input of each layer is quantized with a single scale calibrated on a sample set with the float model.
+ * The products are accumulated in int32 by qgemm_nt (fully-connected layers) or qgemm_packed (convolutions)
+ * and dequantized with input_scale*weight_scales[r], then the biases, the activations and the poolings
+ * are computed in float as the float model does.
+ * The normalizations of this library (layer, group and local response) use the statistics of each instance, so
+ * they can't be folded into the weights: the models with normalizations, residual layers, transposed convolutions
+ * or edge popup can't be quantized
+ * */
+
+/* This function quantizes an array with a single scale, rounding to the nearest even and
+ * saturating to [-QUANTIZED_MAX,QUANTIZED_MAX]
+ * 
+ * Input:
+ *             @ float* x:= the array, dimensions: size
+ *             @ signed char* q:= the quantized array, dimensions: size
+ *             @ float inverse_scale:= 1/scale
+ *             @ int size:= the size of the arrays
+ * */
+void quantize_array_scalar(float* x, signed char* q, float inverse_scale, int size){
+    int i;
+    float y;
+    for(i = 0; i < size; i++){
+        y = x[i]*inverse_scale;
+        if(y > QUANTIZED_MAX)
+            y = QUANTIZED_MAX;
+        else if(y < -QUANTIZED_MAX)
+            y = -QUANTIZED_MAX;
+        q[i] = (signed char)nearbyintf(y);
+    }
+}
+
+#ifdef QUANTIZED_X86
+__attribute__((target("avx2")))
+void quantize_array_avx2(float* x, signed char* q, float inverse_scale, int size){
+    int i;
+    __m256 s = _mm256_set1_ps(inverse_scale);
+    __m256 hi = _mm256_set1_ps(QUANTIZED_MAX);
+    __m256 lo = _mm256_set1_ps(-QUANTIZED_MAX);
+    __m256i order = _mm256_setr_epi32(0,4,1,5,2,6,3,7);
+    __m256i a,b,c,d;
+    for(i = 0; i+32 <= size; i+=32){
+        a = _mm256_cvtps_epi32(_mm256_max_ps(_mm256_min_ps(_mm256_mul_ps(_mm256_loadu_ps(x+i),s),hi),lo));
+        b = _mm256_cvtps_epi32(_mm256_max_ps(_mm256_min_ps(_mm256_mul_ps(_mm256_loadu_ps(x+i+8),s),hi),lo));
+        c = _mm256_cvtps_epi32(_mm256_max_ps(_mm256_min_ps(_mm256_mul_ps(_mm256_loadu_ps(x+i+16),s),hi),lo));
+        d = _mm256_cvtps_epi32(_mm256_max_ps(_mm256_min_ps(_mm256_mul_ps(_mm256_loadu_ps(x+i+24),s),hi),lo));
+        a = _mm256_packs_epi16(_mm256_packs_epi32(a,b),_mm256_packs_epi32(c,d));
+        _mm256_storeu_si256((__m256i*)(q+i),_mm256_permutevar8x32_epi32(a,order));
+    }
+    quantize_array_scalar(x+i,q+i,inverse_scale,size-i);
+}
+#endif
+
+/* This function quantizes an array with a single scale, rounding to the nearest even and
+ * saturating to [-QUANTIZED_MAX,QUANTIZED_MAX]
+ * 
+ * Input:
+ *             @ float* x:= the array, dimensions: size
+ *             @ signed char* q:= the quantized array, dimensions: size
+ *             @ float inverse_scale:= 1/scale
+ *             @ int size:= the size of the arrays
+ * */
+void quantize_array(float* x, signed char* q, float inverse_scale, int size){
+    #ifdef QUANTIZED_X86
+    if(get_sgemm_instruction_set() >= SGEMM_AVX2){
+        quantize_array_avx2(x,q,inverse_scale,size);
+        return;
+    }
+    #endif
+    quantize_array_scalar(x,q,inverse_scale,size);
+}
+
+/* This function quantizes each row of a matrix with its own scale, max|row|/QUANTIZED_MAX
+ * 
+ * Input:
+ *             @ float* w:= the matrix, dimensions: rows*cols
+ *             @ int rows:= the rows of the matrix
+ *             @ int cols:= the columns of the matrix
+ *             @ signed char* q:= the quantized matrix, dimensions: rows*cols
+ *             @ float* scales:= the scales of the rows, dimensions: rows
+ * */
+void quantize_rows(float* w, int rows, int cols, signed char* q, float* scales){
+    int i,j;
+    float max;
+    for(i = 0; i < rows; i++){
+        max = 0;
+        for(j = 0; j < cols; j++){
+            if(fabsf(w[i*cols+j]) > max)
+                max = fabsf(w[i*cols+j]);
+        }
+        scales[i] = max > 0 ? max/QUANTIZED_MAX : 1;
+        quantize_array_scalar(&w[i*cols],&q[i*cols],1/scales[i],cols);
+    }
+}
+
+/* This function unrolls the patches of a quantized input tensor as im2col does for the floats, and packs them
+ * as qgemm_pack_b does (the patches are the rows of B)
+ * 
+ * Input:
+ *             @ signed char* input:= the tensor, dimensions: channels*input_i*input_j
+ *             @ int channels:= the depth of the input and the kernel
+ *             @ int input_i:= the number of rows of each feature map of the input
+ *             @ int input_j:= the number of columns of each feature map of the input
+ *             @ int kernel_i:= the number of rows of each channel of the kernel
+ *             @ int kernel_j:= the number of columns of each channel of the kernel
+ *             @ int stride:= the stride used by the kernel on the feature maps of the inputs
+ *             @ signed char* packed:= the packed patches, dimensions: qgemm_packed_size(patches,channels*kernel_i*kernel_j)
+ *                                    where patches is ((input_i-kernel_i)/stride + 1)*((input_j-kernel_j)/stride + 1)
+ * */
+void im2col_int8_packed(signed char* input, int channels, int input_i, int input_j, int kernel_i, int kernel_j, int stride, signed char* packed){
+    int oi,oj,i,j,c,p = 0;
+    int output_i = (input_i-kernel_i)/stride + 1;
+    int output_j = (input_j-kernel_j)/stride + 1;
+    int n_padded = (output_i*output_j+QGEMM_COLUMNS-1)/QGEMM_COLUMNS*QGEMM_COLUMNS;
+    signed char* x;
+    signed char* y;
+    memset(packed,0,qgemm_packed_size(output_i*output_j,channels*kernel_i*kernel_j));
+    for(c = 0; c < channels; c++){
+        for(i = 0; i < kernel_i; i++){
+            for(j = 0; j < kernel_j; j++, p++){
+                y = packed + (p/4)*n_padded*4 + p%4;
+                for(oi = 0; oi < output_i; oi++){
+                    x = &input[c*input_i*input_j + (oi*stride+i)*input_j + j];
+                    for(oj = 0; oj < output_j; oj++){
+                        y[(oi*output_j+oj)*4] = x[oj*stride];
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* This function computes C = A*B^T with int8 matrices and int32 results
+ * 
+ * Input:
+ *             @ int m:= the rows of A and C
+ *             @ int n:= the rows of B and the columns of C
+ *             @ int k:= the columns of A and B
+ *             @ signed char* a:= the matrix A, dimensions: m*lda
+ *             @ int lda:= the leading dimension of A
+ *             @ signed char* b:= the matrix B, dimensions: n*ldb
+ *             @ int ldb:= the leading dimension of B
+ *             @ int* c:= the matrix C, dimensions: m*ldc
+ *             @ int ldc:= the leading dimension of C
+ * */
+void qgemm_nt_scalar(int m, int n, int k, signed char* a, int lda, signed char* b, int ldb, int* c, int ldc){
+    int i,j,p,sum;
+    for(i = 0; i < m; i++){
+        for(j = 0; j < n; j++){
+            sum = 0;
+            for(p = 0; p < k; p++){
+                sum += a[i*lda+p]*b[j*ldb+p];
+            }
+            c[i*ldc+j] = sum;
+        }
+    }
+}
+
+#ifdef QUANTIZED_X86
+/* 16 bytes are widened to int16 and multiplied with vpmaddwd, the sums of 2 products are exact in int32.
+ * vpmaddubsw would handle 32 bytes but it saturates the sums of 2 products to int16, and 2*127*128 doesn't fit
+ * */
+__attribute__((target("avx2")))
+void qgemm_nt_avx2(int m, int n, int k, signed char* a, int lda, signed char* b, int ldb, int* c, int ldc){
+    int i,j,p,q,r;
+    int sums[4];
+    signed char* bj;
+    signed char* ai;
+    __m256i x,acc0,acc1,acc2,acc3;
+    __m128i s;
+    for(j = 0; j < n; j++){
+        bj = b+j*ldb;
+        for(i = 0; i+4 <= m; i+=4){
+            ai = a+i*lda;
+            acc0 = acc1 = acc2 = acc3 = _mm256_setzero_si256();
+            for(p = 0; p+16 <= k; p+=16){
+                x = _mm256_cvtepi8_epi16(_mm_loadu_si128((__m128i*)(bj+p)));
+                acc0 = _mm256_add_epi32(acc0,_mm256_madd_epi16(x,_mm256_cvtepi8_epi16(_mm_loadu_si128((__m128i*)(ai+p)))));
+                acc1 = _mm256_add_epi32(acc1,_mm256_madd_epi16(x,_mm256_cvtepi8_epi16(_mm_loadu_si128((__m128i*)(ai+lda+p)))));
+                acc2 = _mm256_add_epi32(acc2,_mm256_madd_epi16(x,_mm256_cvtepi8_epi16(_mm_loadu_si128((__m128i*)(ai+2*lda+p)))));
+                acc3 = _mm256_add_epi32(acc3,_mm256_madd_epi16(x,_mm256_cvtepi8_epi16(_mm_loadu_si128((__m128i*)(ai+3*lda+p)))));
+            }
+            acc0 = _mm256_hadd_epi32(_mm256_hadd_epi32(acc0,acc1),_mm256_hadd_epi32(acc2,acc3));
+            s = _mm_add_epi32(_mm256_castsi256_si128(acc0),_mm256_extracti128_si256(acc0,1));
+            _mm_storeu_si128((__m128i*)sums,s);
+            for(r = 0; r < 4; r++){
+                for(q = p; q < k; q++){
+                    sums[r] += ai[r*lda+q]*bj[q];
+                }
+                c[(i+r)*ldc+j] = sums[r];
+            }
+        }
+        for(; i < m; i++){
+            ai = a+i*lda;
+            acc0 = _mm256_setzero_si256();
+            for(p = 0; p+16 <= k; p+=16){
+                x = _mm256_cvtepi8_epi16(_mm_loadu_si128((__m128i*)(bj+p)));
+                acc0 = _mm256_add_epi32(acc0,_mm256_madd_epi16(x,_mm256_cvtepi8_epi16(_mm_loadu_si128((__m128i*)(ai+p)))));
+            }
+            s = _mm_add_epi32(_mm256_castsi256_si128(acc0),_mm256_extracti128_si256(acc0,1));
+            s = _mm_hadd_epi32(s,s);
+            s = _mm_hadd_epi32(s,s);
+            r = _mm_cvtsi128_si32(s);
+            for(q = p; q < k; q++){
+                r += ai[q]*bj[q];
+            }
+            c[i*ldc+j] = r;
+        }
+    }
+}
+
+/* vpdpbusd multiplies unsigned by signed bytes, so the row of B is shifted by QUANTIZED_SHIFT (xor 0x80)
+ * and QUANTIZED_SHIFT*a_sums is subtracted from the results. The last bytes of a row are masked
+ * */
+__attribute__((target("avx512f,avx512bw,avx512vnni")))
+void qgemm_nt_vnni(int m, int n, int k, signed char* a, int lda, int* a_sums, signed char* b, int ldb, int* c, int ldc){
+    int i,j,p;
+    signed char* bj;
+    signed char* ai;
+    __mmask64 mask;
+    __m512i x,acc0,acc1,acc2,acc3;
+    __m512i shift = _mm512_set1_epi8((char)0x80);
+    for(j = 0; j < n; j++){
+        bj = b+j*ldb;
+        for(i = 0; i+4 <= m; i+=4){
+            ai = a+i*lda;
+            acc0 = acc1 = acc2 = acc3 = _mm512_setzero_si512();
+            for(p = 0; p < k; p+=64){
+                mask = k-p >= 64 ? ~(__mmask64)0 : (((__mmask64)1) << (k-p))-1;
+                x = _mm512_xor_si512(_mm512_maskz_loadu_epi8(mask,bj+p),shift);
+                acc0 = _mm512_dpbusd_epi32(acc0,x,_mm512_maskz_loadu_epi8(mask,ai+p));
+                acc1 = _mm512_dpbusd_epi32(acc1,x,_mm512_maskz_loadu_epi8(mask,ai+lda+p));
+                acc2 = _mm512_dpbusd_epi32(acc2,x,_mm512_maskz_loadu_epi8(mask,ai+2*lda+p));
+                acc3 = _mm512_dpbusd_epi32(acc3,x,_mm512_maskz_loadu_epi8(mask,ai+3*lda+p));
+            }
+            c[i*ldc+j] = _mm512_reduce_add_epi32(acc0) - QUANTIZED_SHIFT*a_sums[i];
+            c[(i+1)*ldc+j] = _mm512_reduce_add_epi32(acc1) - QUANTIZED_SHIFT*a_sums[i+1];
+            c[(i+2)*ldc+j] = _mm512_reduce_add_epi32(acc2) - QUANTIZED_SHIFT*a_sums[i+2];
+            c[(i+3)*ldc+j] = _mm512_reduce_add_epi32(acc3) - QUANTIZED_SHIFT*a_sums[i+3];
+        }
+        for(; i < m; i++){
+            ai = a+i*lda;
+            acc0 = _mm512_setzero_si512();
+            for(p = 0; p < k; p+=64){
+                mask = k-p >= 64 ? ~(__mmask64)0 : (((__mmask64)1) << (k-p))-1;
+                x = _mm512_xor_si512(_mm512_maskz_loadu_epi8(mask,bj+p),shift);
+                acc0 = _mm512_dpbusd_epi32(acc0,x,_mm512_maskz_loadu_epi8(mask,ai+p));
+            }
+            c[i*ldc+j] = _mm512_reduce_add_epi32(acc0) - QUANTIZED_SHIFT*a_sums[i];
+        }
+    }
+}
+#endif
+
+/* This function computes C = A*B^T with int8 matrices and int32 results, with the vnni instructions
+ * if the cpu has them and get_sgemm_instruction_set() is SGEMM_AVX512, with avx2 from SGEMM_AVX2.
+ * The results are exact
+ * 
+ * Input:
+ *             @ int m:= the rows of A and C
+ *             @ int n:= the rows of B and the columns of C
+ *             @ int k:= the columns of A and B
+ *             @ signed char* a:= the matrix A, dimensions: m*lda
+ *             @ int lda:= the leading dimension of A
+ *             @ int* a_sums:= the sums of the rows of A, dimensions: m, used only by the vnni kernel to remove the shift of B
+ *             @ signed char* b:= the matrix B, dimensions: n*ldb, the values must be in [-QUANTIZED_MAX,QUANTIZED_MAX]
+ *             @ int ldb:= the leading dimension of B
+ *             @ int* c:= the matrix C, dimensions: m*ldc
+ *             @ int ldc:= the leading dimension of C
+ * */
+void qgemm_nt(int m, int n, int k, signed char* a, int lda, int* a_sums, signed char* b, int ldb, int* c, int ldc){
+    #ifdef QUANTIZED_X86
+    int instruction_set = get_sgemm_instruction_set();
+    if(instruction_set == SGEMM_AVX512 && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vnni")){
+        qgemm_nt_vnni(m,n,k,a,lda,a_sums,b,ldb,c,ldc);
+        return;
+    }
+    if(instruction_set >= SGEMM_AVX2){
+        qgemm_nt_avx2(m,n,k,a,lda,b,ldb,c,ldc);
+        return;
+    }
+    #endif
+    qgemm_nt_scalar(m,n,k,a,lda,b,ldb,c,ldc);
+}
+
+/* This function packs B for qgemm_packed: the columns of B^T are padded to a multiple of QGEMM_COLUMNS with zeros,
+ * the rows of B^T are padded to a multiple of 4 with zeros and each group of 4 rows is interleaved,
+ * so the 4 values of a column of each group are contiguous
+ * 
+ * Input:
+ *             @ int n:= the rows of B
+ *             @ int k:= the columns of B
+ *             @ signed char* b:= the matrix B, dimensions: n*ldb
+ *             @ int ldb:= the leading dimension of B
+ *             @ signed char* packed:= the packed matrix, dimensions: qgemm_packed_size(n,k)
+ * */
+void qgemm_pack_b(int n, int k, signed char* b, int ldb, signed char* packed){
+    int j,p,n_padded = (n+QGEMM_COLUMNS-1)/QGEMM_COLUMNS*QGEMM_COLUMNS;
+    memset(packed,0,qgemm_packed_size(n,k));
+    for(j = 0; j < n; j++){
+        for(p = 0; p < k; p++){
+            packed[(p/4)*n_padded*4 + j*4 + p%4] = b[j*ldb+p];
+        }
+    }
+}
+
+/* This function returns the bytes of B packed by qgemm_pack_b
+ * 
+ * Input:
+ *             @ int n:= the rows of B
+ *             @ int k:= the columns of B
+ * 
+ * Output:
+ *             @ int:= the bytes of the packed matrix
+ * */
+int qgemm_packed_size(int n, int k){
+    return (n+QGEMM_COLUMNS-1)/QGEMM_COLUMNS*QGEMM_COLUMNS*((k+3)/4*4);
+}
+
+/* This function computes C = A*B^T with int8 matrices and int32 results, B packed by qgemm_pack_b
+ * 
+ * Input:
+ *             @ int m:= the rows of A and C
+ *             @ int n:= the rows of B and the columns of C
+ *             @ int k:= the columns of A and B
+ *             @ signed char* a:= the matrix A, dimensions: m*lda
+ *             @ int lda:= the leading dimension of A
+ *             @ signed char* packed:= the matrix B packed by qgemm_pack_b
+ *             @ int* c:= the matrix C, dimensions: m*ldc
+ *             @ int ldc:= the leading dimension of C
+ * */
+void qgemm_packed_scalar(int m, int n, int k, signed char* a, int lda, signed char* packed, int* c, int ldc){
+    int i,j,p,n_padded = (n+QGEMM_COLUMNS-1)/QGEMM_COLUMNS*QGEMM_COLUMNS;
+    for(i = 0; i < m; i++){
+        for(j = 0; j < n; j++){
+            c[i*ldc+j] = 0;
+        }
+        for(p = 0; p < k; p++){
+            for(j = 0; j < n; j++){
+                c[i*ldc+j] += a[i*lda+p]*packed[(p/4)*n_padded*4 + j*4 + p%4];
+            }
+        }
+    }
+}
+
+#ifdef QUANTIZED_X86
+/* The 4 values of a row of A of each group are widened to int16 and broadcasted once for each block of QGEMM_GROUPS groups,
+ * each 16 bytes of B (4 columns of a group) are widened to int16 and multiplied with vpmaddwd, so the pairs of sums
+ * of 4 columns are added at the end. The rows after the last one of A are computed with the last one and not stored
+ * */
+__attribute__((target("avx2")))
+void qgemm_packed_avx2(int m, int n, int k, signed char* a, int lda, signed char* packed, int* c, int ldc){
+    int i,j,q,q0,q1,r,t,quad,groups = (k+3)/4,n_padded = (n+QGEMM_COLUMNS-1)/QGEMM_COLUMNS*QGEMM_COLUMNS;
+    int sums[8];
+    signed char* b;
+    signed char* rows[4];
+    __m256i x0,x1,w,acc[8];
+    __m256i broadcasts[QGEMM_GROUPS*4];
+    for(i = 0; i < m; i+=4){
+        for(r = 0; r < 4; r++){
+            rows[r] = a + (i+r < m ? i+r : m-1)*lda;
+        }
+        for(q0 = 0; q0 < groups; q0 = q1){
+            q1 = q0+QGEMM_GROUPS < groups ? q0+QGEMM_GROUPS : groups;
+            for(q = q0; q < q1; q++){
+                for(r = 0; r < 4; r++){
+                    quad = 0;
+                    memcpy(&quad,rows[r]+q*4,q*4+4 <= k ? 4 : k-q*4);
+                    broadcasts[(q-q0)*4+r] = _mm256_broadcastq_epi64(_mm_cvtepi8_epi16(_mm_cvtsi32_si128(quad)));
+                }
+            }
+            for(j = 0; j < n; j+=8){
+                for(r = 0; r < 8; r++){
+                    acc[r] = _mm256_setzero_si256();
+                }
+                for(q = q0; q < q1; q++){
+                    b = packed + q*n_padded*4 + j*4;
+                    x0 = _mm256_cvtepi8_epi16(_mm_loadu_si128((__m128i*)b));
+                    x1 = _mm256_cvtepi8_epi16(_mm_loadu_si128((__m128i*)(b+16)));
+                    for(r = 0; r < 4; r++){
+                        w = broadcasts[(q-q0)*4+r];
+                        acc[2*r] = _mm256_add_epi32(acc[2*r],_mm256_madd_epi16(x0,w));
+                        acc[2*r+1] = _mm256_add_epi32(acc[2*r+1],_mm256_madd_epi16(x1,w));
+                    }
+                }
+                for(r = 0; r < 4 && i+r < m; r++){
+                    x0 = _mm256_permute4x64_epi64(_mm256_hadd_epi32(acc[2*r],acc[2*r+1]),0xd8);
+                    _mm256_storeu_si256((__m256i*)sums,x0);
+                    for(t = 0; t < 8 && j+t < n; t++){
+                        if(q0)
+                            c[(i+r)*ldc+j+t] += sums[t];
+                        else
+                            c[(i+r)*ldc+j+t] = sums[t];
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* vpdpbusd multiplies unsigned by signed bytes, so B is shifted by QUANTIZED_SHIFT (xor 0x80) and QUANTIZED_SHIFT*a_sums
+ * is subtracted from the results, the 4 values of a row of A of each group are broadcasted.
+ * The rows after the last one of A are computed with the last one and not stored
+ * */
+__attribute__((target("avx512f,avx512bw,avx512vnni")))
+void qgemm_packed_vnni(int m, int n, int k, signed char* a, int lda, int* a_sums, signed char* packed, int* c, int ldc){
+    int i,j,q,r,full = k/4,n_padded = (n+QGEMM_COLUMNS-1)/QGEMM_COLUMNS*QGEMM_COLUMNS;
+    int quad[4],tail[4];
+    signed char* rows[4];
+    __mmask16 mask;
+    __m512i x,acc0,acc1,acc2,acc3;
+    __m512i shift = _mm512_set1_epi8((char)0x80);
+    for(i = 0; i < m; i+=4){
+        for(r = 0; r < 4; r++){
+            rows[r] = a + (i+r < m ? i+r : m-1)*lda;
+            tail[r] = 0;
+            memcpy(&tail[r],rows[r]+full*4,k%4);
+        }
+        for(j = 0; j < n; j+=16){
+            acc0 = acc1 = acc2 = acc3 = _mm512_setzero_si512();
+            for(q = 0; q < full; q++){
+                x = _mm512_xor_si512(_mm512_loadu_si512(packed + q*n_padded*4 + j*4),shift);
+                memcpy(quad,rows[0]+q*4,4);
+                memcpy(quad+1,rows[1]+q*4,4);
+                memcpy(quad+2,rows[2]+q*4,4);
+                memcpy(quad+3,rows[3]+q*4,4);
+                acc0 = _mm512_dpbusd_epi32(acc0,x,_mm512_set1_epi32(quad[0]));
+                acc1 = _mm512_dpbusd_epi32(acc1,x,_mm512_set1_epi32(quad[1]));
+                acc2 = _mm512_dpbusd_epi32(acc2,x,_mm512_set1_epi32(quad[2]));
+                acc3 = _mm512_dpbusd_epi32(acc3,x,_mm512_set1_epi32(quad[3]));
+            }
+            if(k%4){
+                x = _mm512_xor_si512(_mm512_loadu_si512(packed + q*n_padded*4 + j*4),shift);
+                acc0 = _mm512_dpbusd_epi32(acc0,x,_mm512_set1_epi32(tail[0]));
+                acc1 = _mm512_dpbusd_epi32(acc1,x,_mm512_set1_epi32(tail[1]));
+                acc2 = _mm512_dpbusd_epi32(acc2,x,_mm512_set1_epi32(tail[2]));
+                acc3 = _mm512_dpbusd_epi32(acc3,x,_mm512_set1_epi32(tail[3]));
+            }
+            mask = n-j >= 16 ? (__mmask16)0xffff : (__mmask16)((1 << (n-j))-1);
+            _mm512_mask_storeu_epi32(c+i*ldc+j,mask,_mm512_sub_epi32(acc0,_mm512_set1_epi32(QUANTIZED_SHIFT*a_sums[i])));
+            if(i+1 < m)
+                _mm512_mask_storeu_epi32(c+(i+1)*ldc+j,mask,_mm512_sub_epi32(acc1,_mm512_set1_epi32(QUANTIZED_SHIFT*a_sums[i+1])));
+            if(i+2 < m)
+                _mm512_mask_storeu_epi32(c+(i+2)*ldc+j,mask,_mm512_sub_epi32(acc2,_mm512_set1_epi32(QUANTIZED_SHIFT*a_sums[i+2])));
+            if(i+3 < m)
+                _mm512_mask_storeu_epi32(c+(i+3)*ldc+j,mask,_mm512_sub_epi32(acc3,_mm512_set1_epi32(QUANTIZED_SHIFT*a_sums[i+3])));
+        }
+    }
+}
+#endif
+
+/* This function computes C = A*B^T with int8 matrices and int32 results, B packed by qgemm_pack_b,
+ * with the same instructions of qgemm_nt. The results are exact
+ * 
+ * Input:
+ *             @ int m:= the rows of A and C
+ *             @ int n:= the rows of B and the columns of C
+ *             @ int k:= the columns of A and B
+ *             @ signed char* a:= the matrix A, dimensions: m*lda
+ *             @ int lda:= the leading dimension of A
+ *             @ int* a_sums:= the sums of the rows of A, dimensions: m, used only by the vnni kernel to remove the shift of B
+ *             @ signed char* packed:= the matrix B packed by qgemm_pack_b, the values must be in [-QUANTIZED_MAX,QUANTIZED_MAX]
+ *             @ int* c:= the matrix C, dimensions: m*ldc
+ *             @ int ldc:= the leading dimension of C
+ * */
+void qgemm_packed(int m, int n, int k, signed char* a, int lda, int* a_sums, signed char* packed, int* c, int ldc){
+    #ifdef QUANTIZED_X86
+    int instruction_set = get_sgemm_instruction_set();
+    if(instruction_set == SGEMM_AVX512 && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vnni")){
+        qgemm_packed_vnni(m,n,k,a,lda,a_sums,packed,c,ldc);
+        return;
+    }
+    if(instruction_set >= SGEMM_AVX2){
+        qgemm_packed_avx2(m,n,k,a,lda,packed,c,ldc);
+        return;
+    }
+    #endif
+    qgemm_packed_scalar(m,n,k,a,lda,packed,c,ldc);
+}
+
+/* This function computes the activation of a quantized layer
+ * 
+ * Input:
+ *             @ float* input:= the pre activation, dimensions: size
+ *             @ float* output:= the post activation, can be input, dimensions: size
+ *             @ int size:= the size of the arrays
+ *             @ int activation_flag:= the activation of the layer
+ * */
+void quantized_activation(float* input, float* output, int size, int activation_flag){
+    if(activation_flag == SIGMOID)
+        sigmoid_array(input,output,size);
+    else if(activation_flag == RELU)
+        relu_array(input,output,size);
+    else if(activation_flag == ELU)
+        elu_array(input,output,size,ELU_THRESHOLD);
+    else if(activation_flag == SOFTMAX)
+        softmax(input,output,size);
+    else if(activation_flag == TANH)
+        tanhh_array(input,output,size);
+    else if(activation_flag == LEAKY_RELU)
+        leaky_relu_array(input,output,size);
+    else if(input != output)
+        copy_array(input,output,size);
+}
+
+/* This function computes the sums of the rows of the weights of a quantized layer
+ * 
+ * Input:
+ *             @ qlayer* l:= the layer
+ * */
+void set_qlayer_weight_sums(qlayer* l){
+    int i,j;
+    for(i = 0; i < l->n_rows; i++){
+        l->weight_sums[i] = 0;
+        for(j = 0; j < l->n_cols; j++){
+            l->weight_sums[i] += l->weights[i*l->n_cols+j];
+        }
+    }
+}
+
+/* This function allocates a quantized layer, the weights are not set
+ * 
+ * Input:
+ *             @ int layer_type:= FCLS or CLS
+ *             @ int n_rows:= the rows of the weights
+ *             @ int n_cols:= the columns of the weights
+ * 
+ * Output:
+ *             @ qlayer*:= the layer
+ * */
+qlayer* allocate_qlayer(int layer_type, int n_rows, int n_cols){
+    qlayer* l = (qlayer*)calloc(1,sizeof(qlayer));
+    l->layer_type = layer_type;
+    l->n_rows = n_rows;
+    l->n_cols = n_cols;
+    l->output_scale = 1;
+    if(n_rows && n_cols){
+        l->weights = (signed char*)calloc(n_rows*n_cols,sizeof(signed char));
+        l->weight_scales = (float*)calloc(n_rows,sizeof(float));
+        l->weight_sums = (int*)calloc(n_rows,sizeof(int));
+        l->biases = (float*)calloc(n_rows,sizeof(float));
+    }
+    return l;
+}
+
+/* This function quantizes a fully-connected layer
+ * 
+ * Input:
+ *             @ fcl* f:= the layer, FULLY_FEED_FORWARD without normalization
+ *             @ float input_scale:= the scale of the input
+ *             @ float output_scale:= the output is multiplied by it
+ * 
+ * Output:
+ *             @ qlayer*:= the quantized layer
+ * */
+qlayer* quantize_fcl(fcl* f, float input_scale, float output_scale){
+    qlayer* l = allocate_qlayer(FCLS,f->output,f->input);
+    l->activation_flag = f->activation_flag;
+    l->input = f->input;
+    l->output = f->output;
+    l->input_scale = input_scale;
+    l->output_scale = output_scale;
+    quantize_rows(f->weights,f->output,f->input,l->weights,l->weight_scales);
+    copy_array(f->biases,l->biases,f->output);
+    set_qlayer_weight_sums(l);
+    return l;
+}
+
+/* This function quantizes a convolutional layer
+ * 
+ * Input:
+ *             @ cl* c:= the layer, CONVOLUTION or NO_CONVOLUTION without normalization
+ *             @ float input_scale:= the scale of the input
+ * 
+ * Output:
+ *             @ qlayer*:= the quantized layer
+ * */
+qlayer* quantize_cl(cl* c, float input_scale){
+    int i,patch_size = c->channels*c->kernel_rows*c->kernel_cols;
+    qlayer* l;
+    if(c->convolutional_flag == CONVOLUTION)
+        l = allocate_qlayer(CLS,c->n_kernels,patch_size);
+    else
+        l = allocate_qlayer(CLS,0,0);
+    l->convolutional_flag = c->convolutional_flag;
+    l->activation_flag = c->activation_flag;
+    l->pooling_flag = c->pooling_flag;
+    l->channels = c->channels;
+    l->input_rows = c->input_rows;
+    l->input_cols = c->input_cols;
+    l->kernel_rows = c->kernel_rows;
+    l->kernel_cols = c->kernel_cols;
+    l->stride1 = c->stride1_rows;
+    l->padding1 = c->padding1_rows;
+    l->rows1 = c->rows1;
+    l->cols1 = c->cols1;
+    l->pooling_rows = c->pooling_rows;
+    l->pooling_cols = c->pooling_cols;
+    l->stride2 = c->stride2_rows;
+    l->padding2 = c->padding2_rows;
+    l->rows2 = c->rows2;
+    l->cols2 = c->cols2;
+    l->input = c->channels*c->input_rows*c->input_cols;
+    if(c->pooling_flag)
+        l->output = c->n_kernels*c->rows2*c->cols2;
+    else
+        l->output = c->n_kernels*c->rows1*c->cols1;
+    l->input_scale = input_scale;
+    if(c->convolutional_flag == CONVOLUTION){
+        for(i = 0; i < c->n_kernels; i++){
+            quantize_rows(c->kernels[i],1,patch_size,&l->weights[i*patch_size],&l->weight_scales[i]);
+        }
+        copy_array(c->biases,l->biases,c->n_kernels);
+        set_qlayer_weight_sums(l);
+    }
+    return l;
+}
+
+/* This function frees a quantized layer
+ * 
+ * Input:
+ *             @ qlayer* l:= the layer
+ * */
+void free_qlayer(qlayer* l){
+    if(l == NULL)
+        return;
+    free(l->weights);
+    free(l->weight_scales);
+    free(l->weight_sums);
+    free(l->biases);
+    free(l);
+}
+
+/* This function returns the float output of a layer of a sequential model computed by model_tensor_input_ff
+ * 
+ * Input:
+ *             @ model* m:= the model
+ *             @ int layer_type:= FCLS or CLS
+ *             @ int index:= the index of the layer in m->fcls or m->cls
+ *             @ int* size:= where the size of the output is stored
+ * 
+ * Output:
+ *             @ float*:= the output
+ * */
+float* get_quantizable_layer_output(model* m, int layer_type, int index, int* size){
+    if(layer_type == FCLS){
+        (*size) = m->fcls[index]->output;
+        if(m->fcls[index]->activation_flag)
+            return m->fcls[index]->post_activation;
+        return m->fcls[index]->pre_activation;
+    }
+    if(m->cls[index]->pooling_flag){
+        (*size) = m->cls[index]->n_kernels*m->cls[index]->rows2*m->cls[index]->cols2;
+        return m->cls[index]->post_pooling;
+    }
+    (*size) = m->cls[index]->n_kernels*m->cls[index]->rows1*m->cls[index]->cols1;
+    if(m->cls[index]->activation_flag)
+        return m->cls[index]->post_activation;
+    return m->cls[index]->pre_activation;
+}
+
+/* This function checks that a model is a sequence of fully-connected and convolutional layers that can be quantized
+ * 
+ * Input:
+ *             @ model* m:= the model
+ * 
+ * Output:
+ *             @ int:= the number of layers
+ * */
+int check_quantizable_model(model* m){
+    int i,k1 = 0,k2 = 0;
+    for(i = 0; i < m->layers && m->sla[i][0]; i++){
+        if((m->layers > 1 && m->sla[i][1]) || m->sla[i][0] == RLS){
+            fprintf(stderr,"Error: only the sequences of fully-connected and convolutional layers can be quantized\n");
+            exit(1);
+        }
+        if(m->sla[i][0] == FCLS){
+            if(m->fcls[k1]->feed_forward_flag != FULLY_FEED_FORWARD || m->fcls[k1]->normalization_flag != NO_NORMALIZATION || m->fcls[k1]->dropout_flag == DROPOUT){
+                fprintf(stderr,"Error: the fully-connected layers can be quantized only with FULLY_FEED_FORWARD, NO_NORMALIZATION and NO_DROPOUT or DROPOUT_TEST\n");
+                exit(1);
+            }
+            k1++;
+        }
+        else{
+            if(m->cls[k2]->convolutional_flag == TRANSPOSED_CONVOLUTION || m->cls[k2]->feed_forward_flag != FULLY_FEED_FORWARD || m->cls[k2]->normalization_flag != NO_NORMALIZATION || m->cls[k2]->activation_flag == SOFTMAX){
+                fprintf(stderr,"Error: the convolutional layers can be quantized only with CONVOLUTION or NO_CONVOLUTION, FULLY_FEED_FORWARD and NO_NORMALIZATION\n");
+                exit(1);
+            }
+            k2++;
+        }
+    }
+    if(!i){
+        fprintf(stderr,"Error: the model has no layers\n");
+        exit(1);
+    }
+    return i;
+}
+
+/* This function returns the largest absolute value of an array
+ * 
+ * Input:
+ *             @ float* x:= the array, dimensions: size
+ *             @ int size:= the size of the array
+ * 
+ * Output:
+ *             @ float:= max|x|
+ * */
+float max_abs_array(float* x, int size){
+    int i;
+    float max = 0;
+    for(i = 0; i < size; i++){
+        if(fabsf(x[i]) > max)
+            max = fabsf(x[i]);
+    }
+    return max;
+}
+
+/* This function quantizes a sequential model for inference, the scales of the inputs of the layers are the largest
+ * absolute values of the inputs computed by model_tensor_input_ff on the samples. The model is reset after the calibration.
+ * As in model_tensor_input_ff the DROPOUT_TEST of a layer is applied to the input of the next layer, so it is ignored on the last layer
+ * 
+ * Input:
+ *             @ model* m:= the model, a sequence of fully-connected and convolutional layers without normalization
+ *             @ float** samples:= the calibration inputs, dimensions: n_samples x tensor_depth*tensor_i*tensor_j
+ *             @ int n_samples:= the number of samples
+ *             @ int tensor_depth:= the depth of the inputs
+ *             @ int tensor_i:= the rows of the inputs
+ *             @ int tensor_j:= the columns of the inputs
+ * 
+ * Output:
+ *             @ qmodel*:= the quantized model
+ * */
+qmodel* quantize_model(model* m, float** samples, int n_samples, int tensor_depth, int tensor_i, int tensor_j){
+    if(m == NULL || samples == NULL || n_samples <= 0)
+        return NULL;
+    int i,j,size,k1,k2,n = check_quantizable_model(m);
+    float value;
+    float* output;
+    float* max = (float*)calloc(n,sizeof(float));
+    float* output_scales = (float*)malloc(sizeof(float)*n);
+    qlayer** layers = (qlayer**)malloc(sizeof(qlayer*)*n);
+    
+    for(i = 0, k1 = 0; i < n; i++){
+        output_scales[i] = 1;
+        if(m->sla[i][0] == FCLS){
+            if(m->fcls[k1]->dropout_flag == DROPOUT_TEST && i < n-1)
+                output_scales[i] = m->fcls[k1]->dropout_threshold;
+            k1++;
+        }
+    }
+    
+    for(j = 0; j < n_samples; j++){
+        reset_model(m);
+        model_tensor_input_ff(m,tensor_depth,tensor_i,tensor_j,samples[j]);
+        value = max_abs_array(samples[j],tensor_depth*tensor_i*tensor_j);
+        if(value > max[0])
+            max[0] = value;
+        for(i = 0, k1 = 0, k2 = 0; i < n-1; i++){
+            if(m->sla[i][0] == FCLS){
+                output = get_quantizable_layer_output(m,FCLS,k1,&size);
+                k1++;
+            }
+            else{
+                output = get_quantizable_layer_output(m,CLS,k2,&size);
+                k2++;
+            }
+            value = max_abs_array(output,size)*output_scales[i];
+            if(value > max[i+1])
+                max[i+1] = value;
+        }
+    }
+    reset_model(m);
+    
+    for(i = 0, k1 = 0, k2 = 0; i < n; i++){
+        if(max[i] == 0)
+            max[i] = QUANTIZED_MAX;
+        if(m->sla[i][0] == FCLS){
+            layers[i] = quantize_fcl(m->fcls[k1],max[i]/QUANTIZED_MAX,output_scales[i]);
+            k1++;
+        }
+        else{
+            layers[i] = quantize_cl(m->cls[k2],max[i]/QUANTIZED_MAX);
+            k2++;
+        }
+    }
+    
+    free(max);
+    free(output_scales);
+    return create_qmodel(layers,n);
+}
+
+/* This function creates a quantized model from its layers, allocating the buffers of the feed forward
+ * 
+ * Input:
+ *             @ qlayer** layers:= the layers, they are owned by the model
+ *             @ int n_layers:= the number of layers
+ * 
+ * Output:
+ *             @ qmodel*:= the quantized model
+ * */
+qmodel* create_qmodel(qlayer** layers, int n_layers){
+    int i,patches,max_floats = 0,max_conv = 0,max_input = 0,max_packed = 0,max_accumulators = 0;
+    qlayer* l;
+    for(i = 0; i < n_layers; i++){
+        l = layers[i];
+        if(i && layers[i-1]->output != l->input){
+            fprintf(stderr,"Error: the sizes between the quantized layers %d and %d don't match\n",i-1,i);
+            exit(1);
+        }
+        if(l->input > max_floats)
+            max_floats = l->input;
+        if(l->output > max_floats)
+            max_floats = l->output;
+        if(l->n_rows && l->n_cols && l->input > max_input)
+            max_input = l->input;
+        if(l->layer_type == FCLS && l->output > max_accumulators)
+            max_accumulators = l->output;
+        if(l->layer_type == CLS && l->convolutional_flag == CONVOLUTION){
+            patches = ((l->input_rows-l->kernel_rows)/l->stride1+1)*((l->input_cols-l->kernel_cols)/l->stride1+1);
+            if(qgemm_packed_size(patches,l->n_cols) > max_packed)
+                max_packed = qgemm_packed_size(patches,l->n_cols);
+            if(patches*l->n_rows > max_accumulators)
+                max_accumulators = patches*l->n_rows;
+            if(l->pooling_flag && l->n_rows*l->rows1*l->cols1 > max_conv)
+                max_conv = l->n_rows*l->rows1*l->cols1;
+        }
+    }
+    
+    qmodel* m = (qmodel*)calloc(1,sizeof(qmodel));
+    m->n_layers = n_layers;
+    m->layers = layers;
+    m->input = layers[0]->input;
+    m->output = layers[n_layers-1]->output;
+    m->buffer1 = (float*)calloc(max_floats,sizeof(float));
+    m->buffer2 = (float*)calloc(max_floats,sizeof(float));
+    if(max_conv)
+        m->conv_output = (float*)calloc(max_conv,sizeof(float));
+    if(max_input)
+        m->quantized_input = (signed char*)calloc(max_input,sizeof(signed char));
+    if(max_packed)
+        m->packed_col = (signed char*)calloc(max_packed,sizeof(signed char));
+    if(max_accumulators)
+        m->accumulators = (int*)calloc(max_accumulators,sizeof(int));
+    if(n_layers%2)
+        m->output_layer = m->buffer1;
+    else
+        m->output_layer = m->buffer2;
+    return m;
+}
+
+/* This function frees a quantized model
+ * 
+ * Input:
+ *             @ qmodel* m:= the quantized model
+ * */
+void free_qmodel(qmodel* m){
+    if(m == NULL)
+        return;
+    int i;
+    for(i = 0; i < m->n_layers; i++){
+        free_qlayer(m->layers[i]);
+    }
+    free(m->layers);
+    free(m->buffer1);
+    free(m->buffer2);
+    free(m->conv_output);
+    free(m->quantized_input);
+    free(m->packed_col);
+    free(m->accumulators);
+    free(m);
+}
+
+/* This function computes the feed forward of a convolutional quantized layer, the activation is applied
+ * only to the output without the padding and the padding is 0, as for the convolutional layers
+ * 
+ * Input:
+ *             @ qmodel* m:= the quantized model, with the buffers
+ *             @ qlayer* l:= the convolutional layer
+ *             @ float* input:= the input, dimensions: l->input
+ *             @ float* output:= the output, dimensions: l->output
+ * */
+void qlayer_convolutional_feed_forward(qmodel* m, qlayer* l, float* input, float* output){
+    int i,oi,oj,rows = l->input_rows,cols = l->input_cols;
+    int patches_i = (l->input_rows-l->kernel_rows)/l->stride1+1;
+    int patches_j = (l->input_cols-l->kernel_cols)/l->stride1+1;
+    int patches = patches_i*patches_j;
+    float scale;
+    float* conv = input;
+    float* row;
+    int* acc;
+    
+    if(l->convolutional_flag == CONVOLUTION){
+        conv = l->pooling_flag ? m->conv_output : output;
+        rows = l->rows1;
+        cols = l->cols1;
+        quantize_array(input,m->quantized_input,1/l->input_scale,l->input);
+        im2col_int8_packed(m->quantized_input,l->channels,l->input_rows,l->input_cols,l->kernel_rows,l->kernel_cols,l->stride1,m->packed_col);
+        qgemm_packed(l->n_rows,patches,l->n_cols,l->weights,l->n_cols,l->weight_sums,m->packed_col,m->accumulators,patches);
+        if(l->padding1)
+            memset(conv,0,sizeof(float)*l->n_rows*l->rows1*l->cols1);
+        for(i = 0; i < l->n_rows; i++){
+            scale = l->input_scale*l->weight_scales[i];
+            for(oi = 0; oi < patches_i; oi++){
+                acc = &m->accumulators[i*patches+oi*patches_j];
+                row = &conv[i*l->rows1*l->cols1+(oi+l->padding1)*l->cols1+l->padding1];
+                for(oj = 0; oj < patches_j; oj++){
+                    row[oj] = acc[oj]*scale+l->biases[i];
+                }
+                quantized_activation(row,row,patches_j,l->activation_flag);
+            }
+        }
+    }
+    
+    if(l->pooling_flag){
+        if(l->padding2)
+            memset(output,0,sizeof(float)*l->output);
+        for(i = 0; i < l->output/(l->rows2*l->cols2); i++){
+            if(l->pooling_flag == MAX_POOLING)
+                max_pooling_feed_forward(&conv[i*rows*cols],&output[i*l->rows2*l->cols2],rows,cols,l->pooling_rows,l->pooling_cols,l->stride2,l->padding2);
+            else
+                avarage_pooling_feed_forward(&conv[i*rows*cols],&output[i*l->rows2*l->cols2],rows,cols,l->pooling_rows,l->pooling_cols,l->stride2,l->padding2);
+        }
+    }
+    else if(l->convolutional_flag != CONVOLUTION)
+        copy_array(input,output,l->output);
+}
+
+/* This function computes the feed forward of a quantized layer
+ * 
+ * Input:
+ *             @ qmodel* m:= the quantized model, with the buffers
+ *             @ qlayer* l:= the layer
+ *             @ float* input:= the input, dimensions: l->input
+ *             @ float* output:= the output, dimensions: l->output
+ * */
+void qlayer_feed_forward(qmodel* m, qlayer* l, float* input, float* output){
+    int i;
+    if(l->layer_type == CLS){
+        qlayer_convolutional_feed_forward(m,l,input,output);
+        return;
+    }
+    quantize_array(input,m->quantized_input,1/l->input_scale,l->input);
+    qgemm_nt(l->n_rows,1,l->n_cols,l->weights,l->n_cols,l->weight_sums,m->quantized_input,l->n_cols,m->accumulators,1);
+    for(i = 0; i < l->output; i++){
+        output[i] = m->accumulators[i]*l->input_scale*l->weight_scales[i]+l->biases[i];
+    }
+    quantized_activation(output,output,l->output,l->activation_flag);
+    if(l->output_scale != 1)
+        mul_value(output,l->output_scale,output,l->output);
+}
+
+/* This function computes the feed forward of a quantized model, the output is m->output_layer
+ * 
+ * Input:
+ *             @ qmodel* m:= the quantized model
+ *             @ float* input:= the input, with the dimensions of the samples used by quantize_model
+ * */
+void qmodel_tensor_input_ff(qmodel* m, float* input){
+    if(m == NULL)
+        return;
+    int i;
+    for(i = 0; i < m->n_layers; i++){
+        if(i%2){
+            qlayer_feed_forward(m,m->layers[i],input,m->buffer2);
+            input = m->buffer2;
+        }
+        else{
+            qlayer_feed_forward(m,m->layers[i],input,m->buffer1);
+            input = m->buffer1;
+        }
+    }
+}
+
+/* This function returns the bytes of the parameters of a quantized model
+ * 
+ * Input:
+ *             @ qmodel* m:= the quantized model
+ * 
+ * Output:
+ *             @ unsigned long long int:= the bytes of the weights, of the scales and of the biases
+ * */
+unsigned long long int size_of_qmodel(qmodel* m){
+    if(m == NULL)
+        return 0;
+    int i;
+    unsigned long long int sum = 0;
+    for(i = 0; i < m->n_layers; i++){
+        sum += (unsigned long long int)m->layers[i]->n_rows*m->layers[i]->n_cols*sizeof(signed char);
+        sum += (unsigned long long int)m->layers[i]->n_rows*2*sizeof(float);
+    }
+    return sum;
+}
+
+/* This function copies the integer fields of a quantized layer, from layer_type to cols2, in an array
+ * 
+ * Input:
+ *             @ qlayer* l:= the layer
+ *             @ int* shape:= the array, dimensions: QLAYER_SHAPE
+ * */
+void get_qlayer_shape(qlayer* l, int* shape){
+    int values[QLAYER_SHAPE] = {l->layer_type, l->convolutional_flag, l->activation_flag, l->pooling_flag, l->input, l->output, l->n_rows, l->n_cols,
+                                l->channels, l->input_rows, l->input_cols, l->kernel_rows, l->kernel_cols, l->stride1, l->padding1, l->rows1, l->cols1,
+                                l->pooling_rows, l->pooling_cols, l->stride2, l->padding2, l->rows2, l->cols2};
+    memcpy(shape,values,sizeof(int)*QLAYER_SHAPE);
+}
+
+/* This function sets the integer fields of a quantized layer, from layer_type to cols2, from an array
+ * 
+ * Input:
+ *             @ qlayer* l:= the layer
+ *             @ int* shape:= the array filled by get_qlayer_shape, dimensions: QLAYER_SHAPE
+ * */
+void set_qlayer_shape(qlayer* l, int* shape){
+    l->layer_type = shape[0];
+    l->convolutional_flag = shape[1];
+    l->activation_flag = shape[2];
+    l->pooling_flag = shape[3];
+    l->input = shape[4];
+    l->output = shape[5];
+    l->n_rows = shape[6];
+    l->n_cols = shape[7];
+    l->channels = shape[8];
+    l->input_rows = shape[9];
+    l->input_cols = shape[10];
+    l->kernel_rows = shape[11];
+    l->kernel_cols = shape[12];
+    l->stride1 = shape[13];
+    l->padding1 = shape[14];
+    l->rows1 = shape[15];
+    l->cols1 = shape[16];
+    l->pooling_rows = shape[17];
+    l->pooling_cols = shape[18];
+    l->stride2 = shape[19];
+    l->padding2 = shape[20];
+    l->rows2 = shape[21];
+    l->cols2 = shape[22];
+}
+
+/* This function saves a quantized layer appending it on a .qbin file with name n.qbin
+ * 
+ * Input:
+ *             @ qlayer* l:= the layer
+ *             @ int n:= the name of the qbin file where the layer is saved
+ * */
+void save_qlayer(qlayer* l, int n){
+    if(l == NULL)
+        return;
+    int i;
+    int shape[QLAYER_SHAPE];
+    FILE* fw;
+    char* s = (char*)malloc(sizeof(char)*256);
+    char* t = ".qbin";
+    s = itoa(n,s);
+    s = strcat(s,t);
+    
+    fw = fopen(s,"a+");
+    
+    if(fw == NULL){
+        fprintf(stderr,"Error: error during the opening of the file %s\n",s);
+        exit(1);
+    }
+    
+    get_qlayer_shape(l,shape);
+    i = fwrite(shape,sizeof(int),QLAYER_SHAPE,fw);
+    
+    if(i != QLAYER_SHAPE){
+        fprintf(stderr,"Error: an error occurred saving a quantized layer\n");
+        exit(1);
+    }
+    
+    i = fwrite(&l->input_scale,sizeof(float),1,fw);
+    
+    if(i != 1){
+        fprintf(stderr,"Error: an error occurred saving a quantized layer\n");
+        exit(1);
+    }
+    
+    i = fwrite(&l->output_scale,sizeof(float),1,fw);
+    
+    if(i != 1){
+        fprintf(stderr,"Error: an error occurred saving a quantized layer\n");
+        exit(1);
+    }
+    
+    if(l->n_rows && l->n_cols){
+        i = fwrite(l->weights,sizeof(signed char),l->n_rows*l->n_cols,fw);
+        
+        if(i != l->n_rows*l->n_cols){
+            fprintf(stderr,"Error: an error occurred saving a quantized layer\n");
+            exit(1);
+        }
+        
+        i = fwrite(l->weight_scales,sizeof(float),l->n_rows,fw);
+        
+        if(i != l->n_rows){
+            fprintf(stderr,"Error: an error occurred saving a quantized layer\n");
+            exit(1);
+        }
+        
+        i = fwrite(l->biases,sizeof(float),l->n_rows,fw);
+        
+        if(i != l->n_rows){
+            fprintf(stderr,"Error: an error occurred saving a quantized layer\n");
+            exit(1);
+        }
+    }
+    
+    i = fclose(fw);
+    
+    if(i!=0){
+        fprintf(stderr,"Error: an error occurred closing the file %s\n",s);
+        exit(1);
+    }
+    
+    free(s);
+}
+
+/* This function loads a quantized layer from a file
+ * 
+ * Input:
+ *             @ FILE* fr:= the file
+ * 
+ * Output:
+ *             @ qlayer*:= the layer
+ * */
+qlayer* load_qlayer(FILE* fr){
+    if(fr == NULL)
+        return NULL;
+    int i;
+    int shape[QLAYER_SHAPE];
+    qlayer* l;
+    
+    i = fread(shape,sizeof(int),QLAYER_SHAPE,fr);
+    
+    if(i != QLAYER_SHAPE || shape[6] < 0 || shape[7] < 0){
+        fprintf(stderr,"Error: an error occurred loading a quantized layer\n");
+        exit(1);
+    }
+    
+    l = allocate_qlayer(shape[0],shape[6],shape[7]);
+    set_qlayer_shape(l,shape);
+    
+    i = fread(&l->input_scale,sizeof(float),1,fr);
+    
+    if(i != 1){
+        fprintf(stderr,"Error: an error occurred loading a quantized layer\n");
+        exit(1);
+    }
+    
+    i = fread(&l->output_scale,sizeof(float),1,fr);
+    
+    if(i != 1){
+        fprintf(stderr,"Error: an error occurred loading a quantized layer\n");
+        exit(1);
+    }
+    
+    if(l->n_rows && l->n_cols){
+        i = fread(l->weights,sizeof(signed char),l->n_rows*l->n_cols,fr);
+        
+        if(i != l->n_rows*l->n_cols){
+            fprintf(stderr,"Error: an error occurred loading a quantized layer\n");
+            exit(1);
+        }
+        
+        i = fread(l->weight_scales,sizeof(float),l->n_rows,fr);
+        
+        if(i != l->n_rows){
+            fprintf(stderr,"Error: an error occurred loading a quantized layer\n");
+            exit(1);
+        }
+        
+        i = fread(l->biases,sizeof(float),l->n_rows,fr);
+        
+        if(i != l->n_rows){
+            fprintf(stderr,"Error: an error occurred loading a quantized layer\n");
+            exit(1);
+        }
+        
+        set_qlayer_weight_sums(l);
+    }
+    
+    return l;
+}
+
+/* This function saves a quantized model on a .qbin file with name n.qbin:
+ * the int8 weights, a float scale and a float bias for each output channel
+ * 
+ * Input:
+ *             @ qmodel* m:= the quantized model
+ *             @ int n:= the name of the qbin file
+ * */
+void save_qmodel(qmodel* m, int n){
+    if(m == NULL)
+        return;
+    int i;
+    FILE* fw;
+    char* s = (char*)malloc(sizeof(char)*256);
+    char* t = ".qbin";
+    s = itoa(n,s);
+    s = strcat(s,t);
+    
+    fw = fopen(s,"w");
+    
+    if(fw == NULL){
+        fprintf(stderr,"Error: error during the opening of the file %s\n",s);
+        exit(1);
+    }
+    
+    i = fwrite(&m->n_layers,sizeof(int),1,fw);
+    
+    if(i != 1){
+        fprintf(stderr,"Error: an error occurred saving the quantized model\n");
+        exit(1);
+    }
+    
+    i = fclose(fw);
+    
+    if(i!=0){
+        fprintf(stderr,"Error: an error occurred closing the file %s\n",s);
+        exit(1);
+    }
+    
+    for(i = 0; i < m->n_layers; i++){
+        save_qlayer(m->layers[i],n);
+    }
+    
+    free(s);
+}
+
+/* This function loads a quantized model saved by save_qmodel
+ * 
+ * Input:
+ *             @ char* file:= the name of the file
+ * 
+ * Output:
+ *             @ qmodel*:= the quantized model
+ * */
+qmodel* load_qmodel(char* file){
+    if(file == NULL)
+        return NULL;
+    int i,n_layers = 0;
+    FILE* fr = fopen(file,"r");
+    
+    if(fr == NULL){
+        fprintf(stderr,"Error: error during the opening of the file %s\n",file);
+        exit(1);
+    }
+    
+    i = fread(&n_layers,sizeof(int),1,fr);
+    
+    if(i != 1 || n_layers <= 0){
+        fprintf(stderr,"Error: an error occurred loading the quantized model\n");
+        exit(1);
+    }
+    
+    qlayer** layers = (qlayer**)malloc(sizeof(qlayer*)*n_layers);
+    for(i = 0; i < n_layers; i++){
+        layers[i] = load_qlayer(fr);
+    }
+    
+    i = fclose(fr);
+    
+    if(i!=0){
+        fprintf(stderr,"Error: an error occurred closing the file %s\n",file);
+        exit(1);
+    }
+    
+    return create_qmodel(layers,n_layers);
+}
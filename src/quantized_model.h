@@ -0,0 +1,63 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+#ifndef __QUANTIZED_MODEL_H__
+#define __QUANTIZED_MODEL_H__
+
+void quantize_array_scalar(float* x, signed char* q, float inverse_scale, int size);
+void quantize_array(float* x, signed char* q, float inverse_scale, int size);
+void quantize_rows(float* w, int rows, int cols, signed char* q, float* scales);
+void im2col_int8_packed(signed char* input, int channels, int input_i, int input_j, int kernel_i, int kernel_j, int stride, signed char* packed);
+void qgemm_nt_scalar(int m, int n, int k, signed char* a, int lda, signed char* b, int ldb, int* c, int ldc);
+void qgemm_nt(int m, int n, int k, signed char* a, int lda, int* a_sums, signed char* b, int ldb, int* c, int ldc);
+void qgemm_pack_b(int n, int k, signed char* b, int ldb, signed char* packed);
+int qgemm_packed_size(int n, int k);
+void qgemm_packed_scalar(int m, int n, int k, signed char* a, int lda, signed char* packed, int* c, int ldc);
+void qgemm_packed(int m, int n, int k, signed char* a, int lda, int* a_sums, signed char* packed, int* c, int ldc);
+void quantized_activation(float* input, float* output, int size, int activation_flag);
+void set_qlayer_weight_sums(qlayer* l);
+qlayer* allocate_qlayer(int layer_type, int n_rows, int n_cols);
+qlayer* quantize_fcl(fcl* f, float input_scale, float output_scale);
+qlayer* quantize_cl(cl* c, float input_scale);
+void free_qlayer(qlayer* l);
+float* get_quantizable_layer_output(model* m, int layer_type, int index, int* size);
+int check_quantizable_model(model* m);
+float max_abs_array(float* x, int size);
+qmodel* quantize_model(model* m, float** samples, int n_samples, int tensor_depth, int tensor_i, int tensor_j);
+qmodel* create_qmodel(qlayer** layers, int n_layers);
+void free_qmodel(qmodel* m);
+void qlayer_convolutional_feed_forward(qmodel* m, qlayer* l, float* input, float* output);
+void qlayer_feed_forward(qmodel* m, qlayer* l, float* input, float* output);
+void qmodel_tensor_input_ff(qmodel* m, float* input);
+unsigned long long int size_of_qmodel(qmodel* m);
+void get_qlayer_shape(qlayer* l, int* shape);
+void set_qlayer_shape(qlayer* l, int* shape);
+void save_qlayer(qlayer* l, int n);
+qlayer* load_qlayer(FILE* fr);
+void save_qmodel(qmodel* m, int n);
+qmodel* load_qmodel(char* file);
+
+#endif
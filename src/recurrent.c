@@ -24,6 +24,11 @@ SOFTWARE.
 
 #include "llab.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define RECURRENT_X86
+#endif
+
 /* this function computes the feed forward of an lstm cell. The cell is computed to be with size*size dimensions, different from the m*n dimension (you can pad to match the
  * 2 dimensions)
  * 
@@ -45,11 +50,7 @@ SOFTWARE.
 void lstm_ff(float* x, float* h, float* c, float* cell_state, float* hidden_state, float** w, float** u, float** b, float** z, int size){
     
     int i,j;
-    
-    float* f_t = (float*)malloc(sizeof(float)*size);
-    float* i_t = (float*)malloc(sizeof(float)*size);
-    float* o_t = (float*)malloc(sizeof(float)*size);
-    float* tanhh_zc = (float*)malloc(sizeof(float)*size);
+    float f_t,i_t,o_t,tanhh_zc;
     
     for(i = 0; i < size; i++){
         for(j = 0; j < size; j++){
@@ -64,28 +65,279 @@ void lstm_ff(float* x, float* h, float* c, float* cell_state, float* hidden_stat
         z[2][i] += b[2][i];
         z[3][i] += b[3][i];
         
+        f_t = sigmoid(z[0][i]); //f_t
+        i_t = sigmoid(z[1][i]); //i_t
+        o_t = sigmoid(z[2][i]); //o_t
+        tanhh_zc = tanhh(z[3][i]); //tanhh(z_c)
         
+        cell_state[i] = tanhh_zc*i_t + c[i]*f_t; /*cell state of output we calculate c is the previous c state*/
         
-        
-        f_t[i] = sigmoid(z[0][i]); //f_t
-        i_t[i] = sigmoid(z[1][i]); //i_t
-        o_t[i] = sigmoid(z[2][i]); //o_t
-        tanhh_zc[i] = tanhh(z[3][i]); //tanhh(z_c)
-        
-        
-        cell_state[i] = tanhh_zc[i]*i_t[i] + c[i]*f_t[i]; /*cell state of output we calculate c is the previous c state*/
-        
-        
-        hidden_state[i] = o_t[i]*tanhh(cell_state[i]); /*hidden state of output we calculate*/
-        
-        
+        hidden_state[i] = o_t*tanhh(cell_state[i]); /*hidden state of output we calculate*/
+    }
+}
 
-        
+/* this function computes the input projections w*x+b of the 4 gates of an lstm cell for all the timesteps of a window
+ * with a single batched gemm for each gate. Only the recurrent part u*h remains sequential (see lstm_ff_fused).
+ * The output is packed: row t of zx contains z_f, z_i, z_o, z_c of the timestep t one after the other
+ * 
+ * Input:
+ * 
+ *             @ float* x_window:= the inputs coming from below, dimensions: window*size
+ *             @ int window:= the number of timesteps
+ *             @ int size:= the size of the cell
+ *             @ float** w:= the weights w
+ *             @ float** b:= the biases b
+ *             @ float* zx:= the pre activated input projections, dimensions: window*4*size
+ * 
+ * */
+void lstm_input_projections(float* x_window, int window, int size, float** w, float** b, float* zx){
+    recurrent_input_projections(x_window,window,size,LSTM_GATES,w,b,zx);
+}
+
+/* this function computes the input projections w*x+b of the n_gates gates of a recurrent cell (lstm or gru)
+ * for all the timesteps of a window, see lstm_input_projections.
+ * Row t of zx contains the n_gates pre activated gates of the timestep t one after the other
+ * 
+ * Input:
+ * 
+ *             @ float* x_window:= the inputs coming from below, dimensions: window*size
+ *             @ int window:= the number of timesteps
+ *             @ int size:= the size of the cell
+ *             @ int n_gates:= LSTM_GATES or GRU_GATES
+ *             @ float** w:= the weights w
+ *             @ float** b:= the biases b
+ *             @ float* zx:= the pre activated input projections, dimensions: window*n_gates*size
+ * 
+ * */
+void recurrent_input_projections(float* x_window, int window, int size, int n_gates, float** w, float** b, float* zx){
+    int i,k;
+    for(i = 0; i < window; i++){
+        for(k = 0; k < n_gates; k++){
+            copy_array(b[k],&zx[i*n_gates*size+k*size],size);
+        }
+    }
+    for(k = 0; k < n_gates; k++){
+        sgemm_nt(window,size,size,x_window,size,w[k],size,&zx[k*size],n_gates*size);
+    }
+}
+
+/* this function computes the gate nonlinearities and the new states of an lstm cell, given the pre activated outputs z
+ * 
+ * Input:
+ * 
+ *             @ float** z:= the pre activated outputs
+ *             @ float* c:= the last cell state
+ *             @ float* cell_state:= the current cell state
+ *             @ float* hidden_state:= the current hidden state
+ *             @ int size:= the size of the cell
+ * 
+ * */
+void lstm_gates_scalar(float** z, float* c, float* cell_state, float* hidden_state, int size){
+    int i;
+    for(i = 0; i < size; i++){
+        cell_state[i] = tanhh(z[3][i])*sigmoid(z[1][i]) + c[i]*sigmoid(z[0][i]);
+        hidden_state[i] = sigmoid(z[2][i])*tanhh(cell_state[i]);
+    }
+}
+
+#ifdef RECURRENT_X86
+
+/* exp(x) for 8 floats, the range is reduced with x = n*ln(2) + r and exp(r) is a polynomial of degree 5 (cephes expf)*/
+__attribute__((target("avx2,fma")))
+__m256 exp_avx2(__m256 x){
+    __m256 fx,r,y;
+    __m256i n;
+    x = _mm256_min_ps(x,_mm256_set1_ps(88.3762626647949f));
+    x = _mm256_max_ps(x,_mm256_set1_ps(-88.3762626647949f));
+    fx = _mm256_round_ps(_mm256_mul_ps(x,_mm256_set1_ps(1.44269504088896341f)),_MM_FROUND_TO_NEAREST_INT|_MM_FROUND_NO_EXC);
+    r = _mm256_fnmadd_ps(fx,_mm256_set1_ps(0.693359375f),x);
+    r = _mm256_fnmadd_ps(fx,_mm256_set1_ps(-2.12194440e-4f),r);
+    y = _mm256_set1_ps(1.9875691500E-4f);
+    y = _mm256_fmadd_ps(y,r,_mm256_set1_ps(1.3981999507E-3f));
+    y = _mm256_fmadd_ps(y,r,_mm256_set1_ps(8.3334519073E-3f));
+    y = _mm256_fmadd_ps(y,r,_mm256_set1_ps(4.1665795894E-2f));
+    y = _mm256_fmadd_ps(y,r,_mm256_set1_ps(1.6666665459E-1f));
+    y = _mm256_fmadd_ps(y,r,_mm256_set1_ps(5.0000001201E-1f));
+    y = _mm256_fmadd_ps(y,_mm256_mul_ps(r,r),_mm256_add_ps(r,_mm256_set1_ps(1.0f)));
+    n = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(fx),_mm256_set1_epi32(127)),23);
+    return _mm256_mul_ps(y,_mm256_castsi256_ps(n));
+}
+
+__attribute__((target("avx2,fma")))
+__m256 sigmoid_avx2(__m256 x){
+    __m256 one = _mm256_set1_ps(1.0f);
+    return _mm256_div_ps(one,_mm256_add_ps(one,exp_avx2(_mm256_sub_ps(_mm256_setzero_ps(),x))));
+}
+
+/* tanh(x) = 1 - 2/(exp(2x)+1), it saturates to +-1 instead of overflowing*/
+__attribute__((target("avx2,fma")))
+__m256 tanhh_avx2(__m256 x){
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 e = exp_avx2(_mm256_add_ps(x,x));
+    return _mm256_sub_ps(one,_mm256_div_ps(_mm256_set1_ps(2.0f),_mm256_add_ps(e,one)));
+}
+
+__attribute__((target("avx2,fma")))
+void lstm_gates_avx2(float** z, float* c, float* cell_state, float* hidden_state, int size){
+    int i;
+    __m256 vc;
+    for(i = 0; i+8 <= size; i+=8){
+        vc = _mm256_add_ps(_mm256_mul_ps(tanhh_avx2(_mm256_loadu_ps(&z[3][i])),sigmoid_avx2(_mm256_loadu_ps(&z[1][i]))),_mm256_mul_ps(_mm256_loadu_ps(&c[i]),sigmoid_avx2(_mm256_loadu_ps(&z[0][i]))));
+        _mm256_storeu_ps(&cell_state[i],vc);
+        _mm256_storeu_ps(&hidden_state[i],_mm256_mul_ps(sigmoid_avx2(_mm256_loadu_ps(&z[2][i])),tanhh_avx2(vc)));
+    }
+    for(; i < size; i++){
+        cell_state[i] = tanhh(z[3][i])*sigmoid(z[1][i]) + c[i]*sigmoid(z[0][i]);
+        hidden_state[i] = sigmoid(z[2][i])*tanhh(cell_state[i]);
+    }
+}
+
+#endif
+
+/* this function computes the gate nonlinearities and the new states of an lstm cell, see lstm_gates_scalar.
+ * The nonlinearities are vectorized when the cpu supports avx2 (the instruction set is the one chosen
+ * for the sgemm kernels, see get_sgemm_instruction_set)
+ * 
+ * Input:
+ * 
+ *             @ float** z:= the pre activated outputs
+ *             @ float* c:= the last cell state
+ *             @ float* cell_state:= the current cell state
+ *             @ float* hidden_state:= the current hidden state
+ *             @ int size:= the size of the cell
+ * 
+ * */
+void lstm_gates(float** z, float* c, float* cell_state, float* hidden_state, int size){
+    #ifdef RECURRENT_X86
+    if(get_sgemm_instruction_set() >= SGEMM_AVX2){
+        lstm_gates_avx2(z,c,cell_state,hidden_state,size);
+        return;
+    }
+    #endif
+    lstm_gates_scalar(z,c,cell_state,hidden_state,size);
+}
+
+/* this function computes the feed forward of an lstm cell given the input projections computed by lstm_input_projections.
+ * It allocates nothing: the 4 recurrent products u*h are added to the packed input projections and then lstm_gates is called
+ * 
+ * Input:
+ * 
+ *             @ float* zx:= the input projections w*x+b of this timestep, dimensions: 4*size
+ *             @ float* h:= the last hidden state
+ *             @ float* c:= the last cell state
+ *             @ float* cell_state:= the current cell state
+ *             @ float* hidden_state:= the current hidden_state
+ *             @ float** u:= the weights u
+ *             @ float** z:= the pre_activated outputs, they are overwritten
+ *             @ int size:= the size of the cell
+ * 
+ * */
+void lstm_ff_fused(float* zx, float* h, float* c, float* cell_state, float* hidden_state, float** u, float** z, int size){
+    int k;
+    for(k = 0; k < 4; k++){
+        copy_array(&zx[k*size],z[k],size);
+        sgemv(size,size,u[k],size,h,z[k]);
+    }
+    lstm_gates(z,c,cell_state,hidden_state,size);
+}
+
+
+/* this function computes the gate nonlinearities and the new hidden state of a gru cell.
+ * On input z[0] and z[1] are the pre activated update and reset gates, z[2] is w*x+b of the candidate gate
+ * and unh is the recurrent part u*h of the candidate gate. On output z contains the activated gates z,r,n
+ * 
+ * Input:
+ * 
+ *             @ float** z:= the gates, dimensions: 3*size
+ *             @ float* unh:= the recurrent part of the candidate gate, dimensions: size
+ *             @ float* h:= the last hidden state
+ *             @ float* hidden_state:= the current hidden state
+ *             @ int size:= the size of the cell
+ * 
+ * */
+void gru_gates_scalar(float** z, float* unh, float* h, float* hidden_state, int size){
+    int i;
+    for(i = 0; i < size; i++){
+        z[0][i] = sigmoid(z[0][i]);
+        z[1][i] = sigmoid(z[1][i]);
+        z[2][i] = tanhh(z[2][i] + z[1][i]*unh[i]);
+        hidden_state[i] = z[2][i] + z[0][i]*(h[i]-z[2][i]);
+    }
+}
+
+#ifdef RECURRENT_X86
+
+__attribute__((target("avx2,fma")))
+void gru_gates_avx2(float** z, float* unh, float* h, float* hidden_state, int size){
+    int i;
+    __m256 vz,vr,vn;
+    for(i = 0; i+8 <= size; i+=8){
+        vz = sigmoid_avx2(_mm256_loadu_ps(&z[0][i]));
+        vr = sigmoid_avx2(_mm256_loadu_ps(&z[1][i]));
+        vn = tanhh_avx2(_mm256_fmadd_ps(vr,_mm256_loadu_ps(&unh[i]),_mm256_loadu_ps(&z[2][i])));
+        _mm256_storeu_ps(&z[0][i],vz);
+        _mm256_storeu_ps(&z[1][i],vr);
+        _mm256_storeu_ps(&z[2][i],vn);
+        _mm256_storeu_ps(&hidden_state[i],_mm256_fmadd_ps(vz,_mm256_sub_ps(_mm256_loadu_ps(&h[i]),vn),vn));
+    }
+    for(; i < size; i++){
+        z[0][i] = sigmoid(z[0][i]);
+        z[1][i] = sigmoid(z[1][i]);
+        z[2][i] = tanhh(z[2][i] + z[1][i]*unh[i]);
+        hidden_state[i] = z[2][i] + z[0][i]*(h[i]-z[2][i]);
+    }
+}
+
+#endif
+
+/* this function computes the gate nonlinearities and the new hidden state of a gru cell, see gru_gates_scalar.
+ * The nonlinearities are vectorized when the cpu supports avx2
+ * 
+ * Input:
+ * 
+ *             @ float** z:= the gates, dimensions: 3*size
+ *             @ float* unh:= the recurrent part of the candidate gate, dimensions: size
+ *             @ float* h:= the last hidden state
+ *             @ float* hidden_state:= the current hidden state
+ *             @ int size:= the size of the cell
+ * 
+ * */
+void gru_gates(float** z, float* unh, float* h, float* hidden_state, int size){
+    #ifdef RECURRENT_X86
+    if(get_sgemm_instruction_set() >= SGEMM_AVX2){
+        gru_gates_avx2(z,unh,h,hidden_state,size);
+        return;
+    }
+    #endif
+    gru_gates_scalar(z,unh,h,hidden_state,size);
+}
+
+/* this function computes the feed forward of a gru cell given the input projections computed by recurrent_input_projections.
+ * It allocates nothing: the 3 recurrent products u*h are computed with sgemv, the one of the candidate gate is stored
+ * in unh because the reset gate is applied after the product and it is needed again by the back propagation
+ * 
+ * Input:
+ * 
+ *             @ float* zx:= the input projections w*x+b of this timestep, dimensions: 3*size
+ *             @ float* h_right:= the last hidden state after the dropout, used by the recurrent products
+ *             @ float* h:= the last hidden state
+ *             @ float* unh:= where the recurrent part of the candidate gate is stored, dimensions: size
+ *             @ float* hidden_state:= the current hidden_state
+ *             @ float** u:= the weights u
+ *             @ float** z:= the activated gates z,r,n, they are overwritten
+ *             @ int size:= the size of the cell
+ * 
+ * */
+void gru_ff_fused(float* zx, float* h_right, float* h, float* unh, float* hidden_state, float** u, float** z, int size){
+    int k;
+    for(k = 0; k < GRU_GATES; k++){
+        copy_array(&zx[k*size],z[k],size);
     }
-    free(f_t);
-    free(i_t);
-    free(o_t);
-    free(tanhh_zc);
+    sgemv(size,size,u[0],size,h_right,z[0]);
+    sgemv(size,size,u[1],size,h_right,z[1]);
+    memset(unh,0,sizeof(float)*size);
+    sgemv(size,size,u[2],size,h_right,unh);
+    gru_gates(z,unh,h,hidden_state,size);
 }
 
 
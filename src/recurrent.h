@@ -26,6 +26,14 @@ SOFTWARE.
 #define __RECURRENT_H__
 
 void lstm_ff(float* x, float* h, float* c, float* cell_state, float* hidden_state, float** w, float** u, float** b, float** z, int size);
+void lstm_input_projections(float* x_window, int window, int size, float** w, float** b, float* zx);
+void recurrent_input_projections(float* x_window, int window, int size, int n_gates, float** w, float** b, float* zx);
+void lstm_gates_scalar(float** z, float* c, float* cell_state, float* hidden_state, int size);
+void lstm_gates(float** z, float* c, float* cell_state, float* hidden_state, int size);
+void lstm_ff_fused(float* zx, float* h, float* c, float* cell_state, float* hidden_state, float** u, float** z, int size);
+void gru_gates_scalar(float** z, float* unh, float* h, float* hidden_state, int size);
+void gru_gates(float** z, float* unh, float* h, float* hidden_state, int size);
+void gru_ff_fused(float* zx, float* h_right, float* h, float* unh, float* hidden_state, float** u, float** z, int size);
 float** lstm_bp(int flag, int size, float** dw,float** du, float** db, float** w, float** u, float** z, float* dy, float* x_t, float* c_t, float* h_minus, float* c_minus, float** z_up, float** dfioc_up, float** z_plus, float** dfioc_plus, float** w_up, float* dropout_mask,float* dropout_mask_plus);
 
 #endif
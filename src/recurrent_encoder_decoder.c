@@ -59,6 +59,13 @@ recurrent_enc_dec* recurrent_enc_dec_network(rmodel* encoder, rmodel* decoder){
         exit(1);
     }
     
+    for(i = 0; i < encoder->n_lstm; i++){
+        if(encoder->lstms[i]->cell_type != LSTM_CELL || decoder->lstms[i]->cell_type != LSTM_CELL){
+            fprintf(stderr,"Error: the recurrent encoder decoder supports only lstm cells, layer: %d\n",i);
+            exit(1);
+        }
+    }
+    
     if(decoder->lstms[0]->size < encoder->lstms[0]->size){
         fprintf(stderr,"Error: the decoder size must be >= of encoder size\n");
         exit(1);
@@ -79,19 +86,29 @@ recurrent_enc_dec* recurrent_enc_dec_network(rmodel* encoder, rmodel* decoder){
     r->flatten_fcl_input = (float*)malloc(sizeof(float)*(encoder->window+1)*encoder->lstms[0]->size);
     r->output_encoder = (float**)malloc(sizeof(float*)*encoder->window);
     r->hiddens = (float**)malloc(sizeof(float*)*decoder->window);
-    r->output_error_encoder = (float**)malloc(sizeof(float)*encoder->window);
-    r->softmax_array = (float**)calloc(decoder->window,sizeof(float));
+    r->output_error_encoder = (float**)malloc(sizeof(float*)*encoder->window);
+    r->softmax_array = (float**)calloc(decoder->window,sizeof(float*));
 
     for(i = 0; i < encoder->window; i++){
         r->output_encoder[i] = (float*)calloc(encoder->lstms[0]->size,sizeof(float));
         r->output_error_encoder[i] = (float*)calloc(decoder->lstms[0]->size,sizeof(float));
     }
     
-    for(i = 0; i < decoder->window; i++){
-        r->hiddens[i] = (float*)calloc(encoder->lstms[0]->size,sizeof(float));
-        r->softmax_array[i] = (float*)calloc(encoder->window,sizeof(float));
+    r->hiddens[0] = (float*)calloc(decoder->window*encoder->lstms[0]->size,sizeof(float));
+    r->softmax_array[0] = (float*)calloc(decoder->window*encoder->window,sizeof(float));
+    for(i = 1; i < decoder->window; i++){
+        r->hiddens[i] = &r->hiddens[0][i*encoder->lstms[0]->size];
+        r->softmax_array[i] = &r->softmax_array[0][i*encoder->window];
     }
     
+    r->attention_keys = (float*)calloc(encoder->window,sizeof(float));
+    r->attention_scores = (float*)calloc(decoder->window*encoder->window,sizeof(float));
+    r->attention_scores_error = (float*)calloc(decoder->window*encoder->window,sizeof(float));
+    r->attention_contexts_error = (float*)calloc(decoder->window*encoder->lstms[0]->size,sizeof(float));
+    r->attention_values_error = (float*)calloc(encoder->window*encoder->lstms[0]->size,sizeof(float));
+    r->attention_query_error = (float*)calloc(encoder->lstms[0]->size,sizeof(float));
+    r->attention_temp = (float*)calloc(encoder->window,sizeof(float));
+    
     r->beta1_adam = BETA1_ADAM;
     r->beta2_adam = BETA2_ADAM;
     r->beta3_adamod = BETA3_ADAMOD;
@@ -120,14 +137,22 @@ void free_recurrent_enc_dec(recurrent_enc_dec* r){
     int i;
     for(i = 0; i < window2; i++){
         free_model(r->m[i]);
-        free(r->hiddens[i]);
     }
+    free(r->hiddens[0]);
     free(r->hiddens);
     free(r->m);
     free_matrix(r->output_encoder,window1);
     free_matrix(r->output_error_encoder,window1);
-    free_matrix(r->softmax_array,window2);
+    free(r->softmax_array[0]);
+    free(r->softmax_array);
     free(r->flatten_fcl_input);
+    free(r->attention_keys);
+    free(r->attention_scores);
+    free(r->attention_scores_error);
+    free(r->attention_contexts_error);
+    free(r->attention_values_error);
+    free(r->attention_query_error);
+    free(r->attention_temp);
     free(r);
     return;
 }
@@ -144,7 +169,7 @@ void free_recurrent_enc_dec(recurrent_enc_dec* r){
  * */
 recurrent_enc_dec* copy_recurrent_enc_dec(recurrent_enc_dec* r){
     rmodel* encoder = copy_rmodel(r->encoder);
-    rmodel* decoder = copy_rmodel(r->encoder);
+    rmodel* decoder = copy_rmodel(r->decoder);
     recurrent_enc_dec* r2 = recurrent_enc_dec_network(encoder,decoder);
     int i;
     for(i = 0; i < r->decoder->window; i++){
@@ -226,10 +251,62 @@ void slow_paste_recurrent_enc_dec(recurrent_enc_dec* r, recurrent_enc_dec* copy,
 void reset_recurrent_enc_dec(recurrent_enc_dec* r){
     reset_rmodel(r->encoder);
     reset_rmodel(r->decoder);
-    int i,j;
+    int i;
     for(i = 0; i < r->decoder->window; i++){
         reset_model(r->m[i]);
     }
+    reset_recurrent_enc_dec_arrays(r);
+}
+
+/* this function resets the recurrent encoder decoder structure like reset_recurrent_enc_dec, except for the partial derivatives
+ * of encoder, decoder and r->m[0] that are left untouched (the partial derivatives of the other r->m are summed in r->m[0]
+ * by the back propagation, so they are resetted)
+ * 
+ * Inputs:
+ * 
+ *                 @ recurrent_enc_dec* r := the recurrent encoder decoder structure
+ * */
+void reset_recurrent_enc_dec_except_partial_derivatives(recurrent_enc_dec* r){
+    reset_rmodel_except_partial_derivatives(r->encoder);
+    reset_rmodel_except_partial_derivatives(r->decoder);
+    int i;
+    reset_model_except_partial_derivatives(r->m[0]);
+    for(i = 1; i < r->decoder->window; i++){
+        reset_model(r->m[i]);
+    }
+    reset_recurrent_enc_dec_arrays(r);
+}
+
+/* this function stores the arrays of the partial derivatives of a recurrent encoder decoder that are summed over a batch,
+ * the ones of the encoder, of the decoder and of r->m[0]
+ * 
+ * Inputs:
+ * 
+ * 
+ *                 @ recurrent_enc_dec* r:= the recurrent encoder decoder structure
+ *                 @ float** segments:= where the arrays are stored, if NULL the arrays are only counted
+ *                 @ int* sizes:= where the sizes of the arrays are stored
+ * 
+ * Output:
+ *                 @ int:= the number of arrays
+ * */
+int get_partial_derivatives_segments_recurrent_enc_dec(recurrent_enc_dec* r, float** segments, int* sizes){
+    if(segments == NULL)
+        return get_partial_derivatives_segments_rmodel(r->encoder,NULL,NULL)+get_partial_derivatives_segments_rmodel(r->decoder,NULL,NULL)+get_partial_derivatives_segments_model(r->m[0],NULL,NULL);
+    int n = get_partial_derivatives_segments_rmodel(r->encoder,segments,sizes);
+    n += get_partial_derivatives_segments_rmodel(r->decoder,&segments[n],&sizes[n]);
+    return n+get_partial_derivatives_segments_model(r->m[0],&segments[n],&sizes[n]);
+}
+
+/* this function resets the arrays of the recurrent encoder decoder structure that don't belong
+ * to the encoder, the decoder or the models
+ * 
+ * Inputs:
+ * 
+ *                 @ recurrent_enc_dec* r := the recurrent encoder decoder structure
+ * */
+void reset_recurrent_enc_dec_arrays(recurrent_enc_dec* r){
+    int i,j;
     for(i = 0; i < r->encoder->window; i++){
         for(j = 0; j < r->encoder->lstms[0]->size; j++){
             r->output_encoder[i][j] = 0;
@@ -372,9 +449,13 @@ void ff_decoder_lstm(float** hidden_states, float** cell_states, float** input_m
     float* dropout_output = (float*)malloc(sizeof(float)*lstms[0]->size); //here we store the modified output by dropout coming from an lstm cell in vertical
     float* dropout_output2 = (float*)malloc(sizeof(float)*lstms[0]->size); //here we store the modified output by dropout coming from an lstm cell in orizontal
     
-    int i,j,k;
+    int i,j;
     
     float temp_drp_value;
+    
+    // the outputs of the encoder are projected once by the attention for all the timesteps
+    attention_keys(rec->flatten_fcl_input,rec->m[0]->fcls[0]->weights,rec->m[0]->fcls[0]->biases,rec->attention_keys,rec->encoder->window,rec->encoder->lstms[0]->size);
+    
     /*feed_forward_passage*/
     
     for(i = 0; i < window; i++){
@@ -394,16 +475,7 @@ void ff_decoder_lstm(float** hidden_states, float** cell_states, float** input_m
                         mul_value(dropout_output2,lstms[j]->dropout_threshold_right,dropout_output2,lstms[j]->size);
                     
                     copy_array(rec->encoder->lstms[rec->encoder->n_lstm-1]->lstm_hidden[rec->encoder->window-1],rec->hiddens[i],rec->encoder->lstms[0]->size);
-                    copy_array(rec->encoder->lstms[rec->encoder->n_lstm-1]->lstm_hidden[rec->encoder->window-1],&rec->flatten_fcl_input[rec->encoder->window*rec->encoder->lstms[0]->size],rec->encoder->lstms[0]->size);
-                    model_tensor_input_ff(rec->m[i],rec->encoder->lstms[0]->size*(rec->encoder->window+1),1,1,rec->flatten_fcl_input);
-                    softmax(rec->m[i]->fcls[0]->post_activation,rec->softmax_array[i],rec->encoder->window);
-                    
-                    for(k = 0; k < rec->encoder->window; k++){
-                        float* temp_prod = (float*)calloc(rec->encoder->lstms[0]->size,sizeof(float));
-                        mul_value(&rec->flatten_fcl_input[k*rec->encoder->lstms[0]->size],rec->softmax_array[i][k],temp_prod,rec->encoder->lstms[0]->size);
-                        sum1D(input_model[i],temp_prod,input_model[i],rec->encoder->lstms[0]->size);
-                        free(temp_prod);
-                    }
+                    attention_feed_forward(rec->attention_keys,rec->flatten_fcl_input,rec->hiddens[i],rec->m[0]->fcls[0]->weights,&rec->attention_scores[i*rec->encoder->window],rec->softmax_array[i],input_model[i],rec->encoder->window,rec->encoder->lstms[0]->size);
                     
                     lstm_ff(input_model[i], dropout_output2, cell_states[j], lstms[j]->lstm_cell[i], lstms[j]->lstm_hidden[i], lstms[j]->w, lstms[j]->u, lstms[j]->biases, lstms[j]->lstm_z[i], lstms[j]->size);
                 }
@@ -417,16 +489,7 @@ void ff_decoder_lstm(float** hidden_states, float** cell_states, float** input_m
                     
                     
                     copy_array(dropout_output,rec->hiddens[i],rec->encoder->lstms[0]->size);
-                    copy_array(dropout_output,&rec->flatten_fcl_input[rec->encoder->window*rec->encoder->lstms[0]->size],rec->encoder->lstms[0]->size);
-                    model_tensor_input_ff(rec->m[i],rec->encoder->lstms[0]->size*(rec->encoder->window+1),1,1,rec->flatten_fcl_input);
-                    softmax(rec->m[i]->fcls[0]->post_activation,rec->softmax_array[i],rec->encoder->window);
-                    
-                    for(k = 0; k < rec->encoder->window; k++){
-                        float* temp_prod = (float*)calloc(rec->encoder->lstms[0]->size,sizeof(float));
-                        mul_value(&rec->flatten_fcl_input[k*rec->encoder->lstms[0]->size],rec->softmax_array[i][k],temp_prod,rec->encoder->lstms[0]->size);
-                        sum1D(input_model[i],temp_prod,input_model[i],rec->encoder->lstms[0]->size);
-                        free(temp_prod);
-                    }
+                    attention_feed_forward(rec->attention_keys,rec->flatten_fcl_input,rec->hiddens[i],rec->m[0]->fcls[0]->weights,&rec->attention_scores[i*rec->encoder->window],rec->softmax_array[i],input_model[i],rec->encoder->window,rec->encoder->lstms[0]->size);
                    
                     lstm_ff(input_model[i], dropout_output2, lstms[j]->lstm_cell[i-1], lstms[j]->lstm_cell[i], lstms[j]->lstm_hidden[i], lstms[j]->w, lstms[j]->u, lstms[j]->biases, lstms[j]->lstm_z[i], lstms[j]->size);
                 }
@@ -454,10 +517,13 @@ void ff_decoder_lstm(float** hidden_states, float** cell_states, float** input_m
                     if(lstms[j]->dropout_flag_right == DROPOUT_TEST)
                         mul_value(dropout_output2,lstms[j]->dropout_threshold_right,dropout_output2,lstms[j]->size);
                         
-                    lstm_ff(dropout_output, dropout_output2, cell_states[j], lstms[j]->lstm_cell[i], lstms[j]->lstm_hidden[i], lstms[j]->w, lstms[j]->u, lstms[j]->biases, lstms[j]->lstm_z[i], lstms[j]->size);
+                    lstm_ff(dropout_output, dropout_output2, lstms[j]->lstm_cell[i-1], lstms[j]->lstm_cell[i], lstms[j]->lstm_hidden[i], lstms[j]->w, lstms[j]->u, lstms[j]->biases, lstms[j]->lstm_z[i], lstms[j]->size);
                 }
             }
             
+            // the inputs of the lstms are kept for the back propagation, see bp_decoder_lstm
+            copy_array(j == 0 ? input_model[i] : dropout_output,&lstms[j]->x_window[i*lstms[j]->size],lstms[j]->size);
+            
             /* the dropout is applied to each lstm_hidden to feed the deeper lstm cell in vertical, as input*/
             if(i == 0)
                 if(lstms[j]->dropout_flag_up == DROPOUT)
@@ -482,496 +548,77 @@ void ff_decoder_lstm(float** hidden_states, float** cell_states, float** input_m
     
 }
 
-/* this function returns the error dfioc and set the error of input_error through a back propagation passage
- * the dfioc returning error has this dimensions: m->layers*4*m->size (for the decoder)
+/* this function computes the back propagation of the lstms of the decoder without allocating anything. The output of the last lstm
+ * at the timestep i is the query of the attention of the timestep i+1, whose context is the input of the first lstm, so the lstms
+ * are back propagated together one timestep at a time with bp_lstm_timestep, from the last timestep to the first one, and the partial
+ * derivatives of w and u are computed at the end with bp_lstm_window_weights (the inputs are the ones stored in x_window by ff_decoder_lstm).
+ * &l->bp_temp[3*size] holds the error of the output of each lstm at the current timestep. The errors of the first timestep are left
+ * in l->dfioc and the errors of the hidden and cell states passed to the first timestep in l->bp_temp and &l->bp_temp[size],
+ * the errors of the values of the attention and of the first query are summed in rec->output_error_encoder
  * 
  * Inputs:
  * 
  * 
  *             @ float** hidden_states:= the hidden sates passed to each first orizontal cell, dimensions:m->layer*m->size
  *             @ float** cell_states:= the cell sates passed to each first orizontal cell, dimensions:m->layer*m->size
- *             @ float** input_model:= the input passed to the model, dimensions: m->window*m->size
- *             @ float** error_model:= the error of the model, dimensions: m->window*m->size
+ *             @ float** error_model:= the error of the outputs of the last lstm, dimensions: m->window*m->size
  *             @ int window:= the window of the lstms cells
- *                @ int size:= the size of lstms cells
  *                @ int layers:= the number of lastms cells
  *                @ lstm** lstms:= the lstms cells
- *             @ float** input_error:= the error of the inputs of this model, dimensions: m->window*m->size, must be initialized only with m->window, in this case should be always initialized and not set to null
+ *             @ float** input_error:= where the errors of the inputs of the first lstm are written, dimensions: m->window*m->size
  *              @ recurrent_enc_dec* rec:= the recurrent encoder decoder structure
  * 
  * */
-float*** bp_decoder_lstm(float** hidden_states, float** cell_states, float** input_model, float** error_model, int window, int size,int layers,lstm** lstms, float** input_error, recurrent_enc_dec* rec){
-
-   /* backpropagation passage*/
-
-    int i,j,k,z,lstm_bp_flag;
-    
-    float* dropout_output = (float*)malloc(sizeof(float)*lstms[0]->size); //here we store the modified output by dropout coming from an lstm cell
-    float* dropout_output2 = (float*)malloc(sizeof(float)*lstms[0]->size);
-    float* dx; //here we store the modified output by dropout coming from the last lstm cell
-    float* dz = (float*)calloc(lstms[0]->size,sizeof(float)); //for residual dx
-    float*** matrix = (float***)malloc(sizeof(float**)*layers);
-    float** temp;
-    float* array_now ;
-    
-    for(i = 0; i < layers; i++){
-        matrix[i] = NULL;
-    }
-    
-    /*with i = 0 we should handle the h minus and c minus that are given by the params passed to the function*/
-    for(i = window-1; i > 0; i--){
+void bp_decoder_lstm(float** hidden_states, float** cell_states, float** error_model, int window, int layers, lstm** lstms, float** input_error, recurrent_enc_dec* rec){
+    int i,j,k,size = lstms[0]->size, encoder_size = rec->encoder->lstms[0]->size, encoder_window = rec->encoder->window;
+    float* error;
+    float* dx;
+    lstm* l;
+    
+    for(j = 0; j < layers; j++){
+        memset(lstms[j]->bp_temp,0,sizeof(float)*2*size);
+    }
+    
+    for(i = window-1; i >= 0; i--){
+        // the output of the last lstm is the query of the attention of the next timestep
+        error = &lstms[layers-1]->bp_temp[3*size];
+        copy_array(error_model[i],error,size);
+        if(i < window-1)
+            sum1D(error,rec->attention_query_error,error,encoder_size);
+        
         for(j = layers-1; j >= 0; j--){
-            
-            dx = (float*)calloc(lstms[0]->size,sizeof(float));
-            if(i < window-1 && j == layers-1)
-                sum1D(dx,&array_now[rec->encoder->window*rec->encoder->lstms[0]->size],dx,rec->encoder->lstms[0]->size);
-            
-            if(j < layers-1 && lstms[j+1]->residual_flag == LSTM_RESIDUAL)
-                sum1D(dx,dz,dx,lstms[0]->size);
-                
-            if(j == layers-1 && i == window-1)
-                lstm_bp_flag = 0;
-            else if(j != layers-1 && i == window-1)
-                lstm_bp_flag = 1;
-                
-            else if(j == layers-1 && i != window-1)
-                lstm_bp_flag = 2;
-                
-            else
-                lstm_bp_flag = 3;
-            
-            
-            if(j == layers-1)
-                
-                get_dropout_array(lstms[j]->size,lstms[j]->dropout_mask_up,error_model[i],dx);
-
-            if(j == layers-1){
-                
-                if(j != 0)
-                    get_dropout_array(lstms[j]->size,lstms[j-1]->dropout_mask_up,lstms[j-1]->lstm_hidden[i],dropout_output);
-                get_dropout_array(lstms[j]->size,lstms[j]->dropout_mask_right,lstms[j]->lstm_hidden[i-1],dropout_output2);
-                
-                
-                if(j != 0){
-                    if(i == window-1)
-                        temp = lstm_bp(lstm_bp_flag,lstms[j]->size, lstms[j]->d_w,lstms[j]->d_u, lstms[j]->d_biases, lstms[j]->w, lstms[j]->u, lstms[j]->lstm_z[i], dx,dropout_output,lstms[j]->lstm_cell[i],dropout_output2,lstms[j]->lstm_cell[i-1], NULL, NULL, NULL, NULL,NULL,lstms[j]->dropout_mask_up,lstms[j]->dropout_mask_right);
-                    else
-                        temp = lstm_bp(lstm_bp_flag,lstms[j]->size,  lstms[j]->d_w,lstms[j]->d_u, lstms[j]->d_biases, lstms[j]->w, lstms[j]->u, lstms[j]->lstm_z[i], dx,dropout_output,lstms[j]->lstm_cell[i],dropout_output2,lstms[j]->lstm_cell[i-1], NULL, NULL, lstms[j]->lstm_z[i+1],matrix[j],NULL,lstms[j]->dropout_mask_up,lstms[j]->dropout_mask_right);
-                }
-                
-                else{
-                    if(i == window-1)
-                        temp = lstm_bp(lstm_bp_flag,lstms[j]->size, lstms[j]->d_w,lstms[j]->d_u, lstms[j]->d_biases, lstms[j]->w, lstms[j]->u, lstms[j]->lstm_z[i], dx,input_model[i],lstms[j]->lstm_cell[i],dropout_output2,lstms[j]->lstm_cell[i-1], NULL, NULL, NULL, NULL,NULL,lstms[j]->dropout_mask_up,lstms[j]->dropout_mask_right);
-                    else
-                        temp = lstm_bp(lstm_bp_flag,lstms[j]->size,  lstms[j]->d_w,lstms[j]->d_u, lstms[j]->d_biases, lstms[j]->w, lstms[j]->u, lstms[j]->lstm_z[i], dx,input_model[i],lstms[j]->lstm_cell[i],dropout_output2,lstms[j]->lstm_cell[i-1], NULL, NULL, lstms[j]->lstm_z[i+1],matrix[j],NULL,lstms[j]->dropout_mask_up,lstms[j]->dropout_mask_right);
-                    
-                }
-                
-                
-                if(matrix[j] != NULL)
-                    free_matrix(matrix[j],4);
-                
-                matrix[j] = temp;
-
-            }
-            
-            else if(j != layers-1 && j != 0){
-                
-                
-                get_dropout_array(lstms[j]->size,lstms[j-1]->dropout_mask_up,lstms[j-1]->lstm_hidden[i],dropout_output);
-                get_dropout_array(lstms[j]->size,lstms[j]->dropout_mask_right,lstms[j]->lstm_hidden[i-1],dropout_output2);
-
-                
-                if(i == window-1)
-                    temp = lstm_bp(lstm_bp_flag,lstms[j]->size, lstms[j]->d_w,lstms[j]->d_u,lstms[j]->d_biases,lstms[j]->w,lstms[j]->u,lstms[j]->lstm_z[i], dx, dropout_output,lstms[j]->lstm_cell[i],dropout_output2,lstms[j]->lstm_cell[i-1], lstms[j+1]->lstm_z[i], matrix[j+1], NULL,NULL,lstms[j+1]->w,lstms[j]->dropout_mask_up,lstms[j]->dropout_mask_right);
-                    
-                else
-                    temp = lstm_bp(lstm_bp_flag,lstms[j]->size, lstms[j]->d_w,lstms[j]->d_u,lstms[j]->d_biases,lstms[j]->w,lstms[j]->u,lstms[j]->lstm_z[i], dx, dropout_output,lstms[j]->lstm_cell[i],dropout_output2,lstms[j]->lstm_cell[i-1], lstms[j+1]->lstm_z[i], matrix[j+1], lstms[j]->lstm_z[i+1],matrix[j],lstms[j+1]->w,lstms[j]->dropout_mask_up,lstms[j]->dropout_mask_right);
-                if(matrix[j]!= NULL)
-                    free_matrix(matrix[j],4);
-                
-                
-                matrix[j] = temp;
-                
-                
+            l = lstms[j];
+            error = &l->bp_temp[3*size];
+            bp_lstm_timestep(hidden_states[j],cell_states[j],error,l,i);
+            
+            // the error of the input of this lstm is the error of the output of the lstm below
+            dx = j ? &lstms[j-1]->bp_temp[3*size] : input_error[i];
+            memset(dx,0,sizeof(float)*size);
+            for(k = 0; k < LSTM_GATES; k++){
+                sgemv_t(size,size,l->w[k],size,&l->zx[(i*LSTM_GATES+k)*size],dx);
             }
-            
-            else{
-                
-                get_dropout_array(lstms[j]->size,lstms[j]->dropout_mask_right,lstms[j]->lstm_hidden[i-1],dropout_output2);
-
-                if(i == window-1)
-                    temp = lstm_bp(lstm_bp_flag,lstms[j]->size, lstms[j]->d_w,lstms[j]->d_u,lstms[j]->d_biases,lstms[j]->w,lstms[j]->u,lstms[j]->lstm_z[i], dx, input_model[i],lstms[j]->lstm_cell[i],dropout_output2,lstms[j]->lstm_cell[i-1], lstms[j+1]->lstm_z[i], matrix[j+1], NULL,NULL,lstms[j+1]->w,lstms[j]->dropout_mask_up,lstms[j]->dropout_mask_right);
-                
-                else
-                    temp = lstm_bp(lstm_bp_flag,lstms[j]->size, lstms[j]->d_w,lstms[j]->d_u,lstms[j]->d_biases,lstms[j]->w,lstms[j]->u,lstms[j]->lstm_z[i], dx, input_model[i],lstms[j]->lstm_cell[i],dropout_output2,lstms[j]->lstm_cell[i-1], lstms[j+1]->lstm_z[i], matrix[j+1], lstms[j+1]->lstm_z[i],matrix[j],lstms[j+1]->w,lstms[j]->dropout_mask_up,lstms[j]->dropout_mask_right);
-                
-                if(matrix[j]!= NULL)
-                    free_matrix(matrix[j],4);
-                
-                matrix[j] = temp;
-                
-            }
-            
-            copy_array(dx,dz,lstms[0]->size);
-            free(dx);
-            
-            if(!j && input_error != NULL){
-                input_error[i] = lstm_dinput(i,lstms[j]->size,matrix[j],lstms[j]);
-                if(lstms[j]->residual_flag == LSTM_RESIDUAL)
-                    sum1D(input_error[i],dz,input_error[i],lstms[j]->size);
-            
-                float* temp_prod2 = (float*)calloc(rec->encoder->window,sizeof(float));
-                float* temp_prod3 = (float*)calloc(rec->encoder->window,sizeof(float));
-                for(k = 0; k < rec->encoder->window; k++){
-                    float* temp_prod = (float*)calloc(rec->encoder->lstms[0]->size,sizeof(float));
-                    mul_value(input_error[i],rec->softmax_array[i][k],temp_prod,rec->encoder->lstms[0]->size);
-                    sum1D(rec->output_error_encoder[k],temp_prod,rec->output_error_encoder[k],rec->encoder->lstms[0]->size);
-                    free(temp_prod);
-                    
-                    for(z = 0; z < rec->encoder->lstms[0]->size; z++){
-                        temp_prod2[k] += rec->flatten_fcl_input[k*rec->encoder->lstms[0]->size+z]*input_error[i][z];
-                    }
-                }
-                derivative_softmax_array(NULL,temp_prod3,rec->softmax_array[i],temp_prod2,rec->encoder->window);
-                copy_array(rec->encoder->lstms[rec->encoder->n_lstm-1]->lstm_hidden[rec->encoder->window-1],&rec->flatten_fcl_input[rec->encoder->window*rec->encoder->lstms[0]->size],rec->encoder->lstms[0]->size);
-                array_now = model_tensor_input_bp(rec->m[i],(rec->encoder->window+1)*rec->encoder->lstms[0]->size,1,1,rec->flatten_fcl_input,temp_prod3,rec->encoder->window);
-                free(temp_prod2);
-                free(temp_prod3);
-                for(k = 0; k < rec->encoder->window; k++){
-                    sum1D(&array_now[k*rec->encoder->lstms[0]->size],rec->output_error_encoder[k],rec->output_error_encoder[k],rec->encoder->lstms[0]->size);
-                }
-                sum1D(&array_now[k*rec->encoder->lstms[0]->size],rec->output_error_encoder[k-1],rec->output_error_encoder[k-1],rec->encoder->lstms[0]->size);
-                
-            }
-            
+            if(l->residual_flag == LSTM_RESIDUAL)
+                sum1D(dx,error,dx,size);
         }
         
+        // the error of the context of the attention
+        copy_array(input_error[i],&rec->attention_contexts_error[i*encoder_size],encoder_size);
+        memset(rec->attention_query_error,0,sizeof(float)*encoder_size);
+        attention_back_prop(rec->flatten_fcl_input,rec->m[0]->fcls[0]->weights,&rec->attention_scores[i*encoder_window],rec->softmax_array[i],&rec->attention_contexts_error[i*encoder_size],&rec->attention_scores_error[i*encoder_window],rec->attention_query_error,encoder_window,encoder_size);
     }
     
-    i = 0;
-    /* computing back propagation just for the first lstm layers with hidden states defined by the previous batch*/
-    for(j = layers-1; j >= 0; j--){
-            
-        dx = (float*)calloc(lstms[0]->size,sizeof(float));
-        
-        if(i < window-1 && j == layers-1)
-            sum1D(dx,&array_now[rec->encoder->window*rec->encoder->lstms[0]->size],dx,rec->encoder->lstms[0]->size);
-        
-        if(j < layers-1 && lstms[j+1]->residual_flag == LSTM_RESIDUAL)
-            sum1D(dx,dz,dx,lstms[0]->size);
-        if(j == layers-1 && i == window-1)
-            lstm_bp_flag = 0;
-        else if(j != layers-1 && i == window-1)
-            lstm_bp_flag = 1;
-            
-        else if(j == layers-1 && i != window-1)
-            lstm_bp_flag = 2;
-            
-        else
-            lstm_bp_flag = 3;
-        
-        
-        if(j == layers-1)
-            
-            get_dropout_array(lstms[j]->size,lstms[j]->dropout_mask_up,error_model[i],dx);
-
-        if(j == layers-1){
-            
-            if(j != 0)
-                get_dropout_array(lstms[j]->size,lstms[j-1]->dropout_mask_up,lstms[j-1]->lstm_hidden[i],dropout_output);
-            get_dropout_array(lstms[j]->size,lstms[j]->dropout_mask_right,hidden_states[j],dropout_output2);
-            
-            if(j != 0)
-                temp = lstm_bp(lstm_bp_flag,lstms[j]->size, lstms[j]->d_w,lstms[j]->d_u, lstms[j]->d_biases, lstms[j]->w, lstms[j]->u, lstms[j]->lstm_z[i], dx,dropout_output,lstms[j]->lstm_cell[i],dropout_output2,cell_states[j], NULL, NULL, lstms[j]->lstm_z[i+1],matrix[j],NULL,lstms[j]->dropout_mask_up,lstms[j]->dropout_mask_right);
-            else
-                temp = lstm_bp(lstm_bp_flag,lstms[j]->size, lstms[j]->d_w,lstms[j]->d_u, lstms[j]->d_biases, lstms[j]->w, lstms[j]->u, lstms[j]->lstm_z[i], dx,input_model[i],lstms[j]->lstm_cell[i],dropout_output2,cell_states[j], NULL, NULL, lstms[j]->lstm_z[i+1],matrix[j],NULL,lstms[j]->dropout_mask_up,lstms[j]->dropout_mask_right);
-            
-            if(matrix[j] != NULL)
-                free_matrix(matrix[j],4);
-            matrix[j] = temp;
-            
-        }
-        
-        else if(j != layers-1 && j != 0){
-            
-            get_dropout_array(lstms[j]->size,lstms[j-1]->dropout_mask_up,lstms[j-1]->lstm_hidden[i],dropout_output);
-            get_dropout_array(lstms[j]->size,lstms[j]->dropout_mask_right,hidden_states[j],dropout_output2);
-            
-
-            temp = lstm_bp(lstm_bp_flag,lstms[j]->size, lstms[j]->d_w,lstms[j]->d_u,lstms[j]->d_biases,lstms[j]->w,lstms[j]->u,lstms[j]->lstm_z[i], dx, dropout_output,lstms[j]->lstm_cell[i],dropout_output2,cell_states[j], lstms[j+1]->lstm_z[i], matrix[j+1], lstms[j]->lstm_z[i+1],matrix[j],lstms[j+1]->w,lstms[j]->dropout_mask_up,lstms[j]->dropout_mask_right);
-            if(matrix[j] != NULL)
-                free_matrix(matrix[j],4);
-            matrix[j] = temp;
-        }
-        
-        else{
-            
-            get_dropout_array(lstms[j]->size,lstms[j]->dropout_mask_right,hidden_states[j],dropout_output2);
-            
-            temp = lstm_bp(lstm_bp_flag,lstms[j]->size, lstms[j]->d_w,lstms[j]->d_u,lstms[j]->d_biases,lstms[j]->w,lstms[j]->d_u,lstms[j]->lstm_z[i], dx, input_model[i],lstms[j]->lstm_cell[i],dropout_output2,cell_states[j], lstms[j+1]->lstm_z[i], matrix[j+1], lstms[j]->lstm_z[i+1],matrix[j],lstms[j+1]->w,lstms[j]->dropout_mask_up,lstms[j]->dropout_mask_right);
-            if(matrix[j] != NULL)
-                free_matrix(matrix[j],4);
-            matrix[j] = temp;
-            
-        }
-        copy_array(dx,dz,lstms[0]->size);
-        free(dx);
-        
-        if(!j && input_error != NULL){
-            input_error[i] = lstm_dinput(i,lstms[j]->size,matrix[j],lstms[j]);
-            if(lstms[j]->residual_flag == LSTM_RESIDUAL)
-                sum1D(input_error[i],dz,input_error[i],lstms[j]->size);
-        
-            float* temp_prod2 = (float*)calloc(rec->encoder->window,sizeof(float));
-            float* temp_prod3 = (float*)calloc(rec->encoder->window,sizeof(float));
-            for(k = 0; k < rec->encoder->window; k++){
-                float* temp_prod = (float*)calloc(rec->encoder->lstms[0]->size,sizeof(float));
-                mul_value(input_error[i],rec->softmax_array[i][k],temp_prod,rec->encoder->lstms[0]->size);
-                sum1D(rec->output_error_encoder[k],temp_prod,rec->output_error_encoder[k],rec->encoder->lstms[0]->size);
-                free(temp_prod);
-                
-                for(z = 0; z < rec->encoder->lstms[0]->size; z++){
-                    temp_prod2[k] += rec->flatten_fcl_input[k*rec->encoder->lstms[0]->size+z]*input_error[i][z];
-                }
-            }
-            derivative_softmax_array(NULL,temp_prod3,rec->softmax_array[i],temp_prod2,rec->encoder->window);
-            copy_array(lstms[layers-1]->lstm_hidden[i-1],&rec->flatten_fcl_input[rec->encoder->window*rec->encoder->lstms[0]->size],rec->encoder->lstms[0]->size);
-            array_now = model_tensor_input_bp(rec->m[i],(rec->encoder->window+1)*rec->encoder->lstms[0]->size,1,1,rec->flatten_fcl_input,temp_prod3,rec->encoder->window);
-            free(temp_prod2);
-            free(temp_prod3);
-            for(k = 0; k < rec->encoder->window; k++){
-                sum1D(&array_now[k*rec->encoder->lstms[0]->size],rec->output_error_encoder[k],rec->output_error_encoder[k],rec->encoder->lstms[0]->size);
-            }
-        }
-    }
+    // the first query of the attention is the last output of the encoder
+    sum1D(rec->output_error_encoder[encoder_window-1],rec->attention_query_error,rec->output_error_encoder[encoder_window-1],encoder_size);
     
-    free(dropout_output);
-    free(dropout_output2);
-    free(dz);
-    return matrix;
-    
-}
-
-/* this function returns the error dfioc and set the error of input_error through a back propagation passage
- * the dfioc returning error has this dimensions: m->layers*4*m->size (for the encoder)
- * 
- * Inputs:
- * 
- * 
- *             @ float** hidden_states:= the hidden sates passed to each first orizontal cell, dimensions:m->layer*m->size
- *             @ float** cell_states:= the cell sates passed to each first orizontal cell, dimensions:m->layer*m->size
- *             @ float** input_model:= the input passed to the model, dimensions: m->window*m->size
- *             @ float** error_model:= the error of the model, dimensions: m->window*m->size
- *             @ int window:= the window of the lstms cells
- *                @ int size:= the size of lstms cells
- *                @ int layers:= the number of lastms cells
- *                @ lstm** lstms:= the lstms cells
- *             @ float** input_error:= the error of the inputs of this model, dimensions: m->window*m->size, must be initialized only with m->window
- *             @ float** dfioc:= the dfioc given from the decoder
- *             @ float** dropout_mask_dec:= the dropout mask right given by the decoder
- *             @ lstm** first_dec_orizontal:= the lstms of the decoder
- * 
- * */
-float*** bp_encoder_lstm(float** hidden_states, float** cell_states, float** input_model, float** error_model, int window, int size,int layers,lstm** lstms, float** input_error, float*** dfioc, float** dropout_mask_dec, lstm** first_dec_orizontal){
-
-   /* backpropagation passage*/
-
-    int i,j, lstm_bp_flag;
-    
-    float* dropout_output = (float*)malloc(sizeof(float)*lstms[0]->size); //here we store the modified output by dropout coming from an lstm cell
-    float* dropout_output2 = (float*)malloc(sizeof(float)*lstms[0]->size);
-    float* dx; //here we store the modified output by dropout coming from the last lstm cell
-    float* dz = (float*)calloc(lstms[0]->size,sizeof(float)); //for residual dx
-    float*** matrix = (float***)malloc(sizeof(float**)*layers);
-    float** temp;
-    
-    for(i = 0; i < layers; i++){
-        matrix[i] = NULL;
-    }
-    /*with i = 0 we should handle the h minus and c minus that are given by the params passed to the function*/
-    for(i = window-1; i > 0; i--){
-        for(j = layers-1; j >= 0; j--){
-            
-            dx = (float*)calloc(lstms[0]->size,sizeof(float));
-            if(j < layers-1 && lstms[j+1]->residual_flag == LSTM_RESIDUAL)
-                sum1D(dx,dz,dx,lstms[0]->size);
-                
-            if(j == layers-1 && i == window-1)
-                lstm_bp_flag = 2;
-            else if(j != layers-1 && i == window-1)
-                lstm_bp_flag = 3;
-                
-            else if(j == layers-1 && i != window-1)
-                lstm_bp_flag = 2;
-                
-            else
-                lstm_bp_flag = 3;
-            
-            
-            if(j == layers-1)
-                
-                get_dropout_array(lstms[j]->size,lstms[j]->dropout_mask_up,error_model[i],dx);
-
-            if(j == layers-1){
-                
-                if(j != 0)
-                    get_dropout_array(lstms[j]->size,lstms[j-1]->dropout_mask_up,lstms[j-1]->lstm_hidden[i],dropout_output);
-                
-                get_dropout_array(lstms[j]->size,lstms[j]->dropout_mask_right,lstms[j]->lstm_hidden[i-1],dropout_output2);
-                
-                if(j != 0){
-                    if(i == window-1)
-                        temp = lstm_bp(lstm_bp_flag,lstms[j]->size, lstms[j]->d_w,lstms[j]->d_u, lstms[j]->d_biases, lstms[j]->w, lstms[j]->u, lstms[j]->lstm_z[i], dx,dropout_output,lstms[j]->lstm_cell[i],dropout_output2,lstms[j]->lstm_cell[i-1], NULL, NULL, first_dec_orizontal[j]->lstm_z[0], dfioc[j],NULL,lstms[j]->dropout_mask_up,dropout_mask_dec[j]);
-                    else
-                        temp = lstm_bp(lstm_bp_flag,lstms[j]->size,  lstms[j]->d_w,lstms[j]->d_u, lstms[j]->d_biases, lstms[j]->w, lstms[j]->u, lstms[j]->lstm_z[i], dx,dropout_output,lstms[j]->lstm_cell[i],dropout_output2,lstms[j]->lstm_cell[i-1], NULL, NULL, lstms[j]->lstm_z[i+1],matrix[j],NULL,lstms[j]->dropout_mask_up,lstms[j]->dropout_mask_right);
-                }
-                
-                else{
-                    if(i == window-1)
-                        temp = lstm_bp(lstm_bp_flag,lstms[j]->size, lstms[j]->d_w,lstms[j]->d_u, lstms[j]->d_biases, lstms[j]->w, lstms[j]->u, lstms[j]->lstm_z[i], dx,input_model[i],lstms[j]->lstm_cell[i],dropout_output2,lstms[j]->lstm_cell[i-1], NULL, NULL, first_dec_orizontal[j]->lstm_z[0], dfioc[j],NULL,lstms[j]->dropout_mask_up,dropout_mask_dec[j]);
-                    else
-                        temp = lstm_bp(lstm_bp_flag,lstms[j]->size,  lstms[j]->d_w,lstms[j]->d_u, lstms[j]->d_biases, lstms[j]->w, lstms[j]->u, lstms[j]->lstm_z[i], dx,input_model[i],lstms[j]->lstm_cell[i],dropout_output2,lstms[j]->lstm_cell[i-1], NULL, NULL, lstms[j]->lstm_z[i+1],matrix[j],NULL,lstms[j]->dropout_mask_up,lstms[j]->dropout_mask_right);
-                    
-                }
-                
-                
-                if(matrix[j] != NULL)
-                    free_matrix(matrix[j],4);
-                
-                matrix[j] = temp;
-
-            }
-            
-            else if(j != layers-1 && j != 0){
-                
-                
-                get_dropout_array(lstms[j]->size,lstms[j-1]->dropout_mask_up,lstms[j-1]->lstm_hidden[i],dropout_output);
-                get_dropout_array(lstms[j]->size,lstms[j]->dropout_mask_right,lstms[j]->lstm_hidden[i-1],dropout_output2);
-                
-                if(i == window-1)
-                    temp = lstm_bp(lstm_bp_flag,lstms[j]->size, lstms[j]->d_w,lstms[j]->d_u,lstms[j]->d_biases,lstms[j]->w,lstms[j]->u,lstms[j]->lstm_z[i], dx, dropout_output,lstms[j]->lstm_cell[i],dropout_output2,lstms[j]->lstm_cell[i-1], lstms[j+1]->lstm_z[i], matrix[j+1], first_dec_orizontal[j]->lstm_z[0],dfioc[j],lstms[j+1]->w,lstms[j]->dropout_mask_up,dropout_mask_dec[j]);
-                    
-                else
-                    temp = lstm_bp(lstm_bp_flag,lstms[j]->size, lstms[j]->d_w,lstms[j]->d_u,lstms[j]->d_biases,lstms[j]->w,lstms[j]->u,lstms[j]->lstm_z[i], dx, dropout_output,lstms[j]->lstm_cell[i],dropout_output2,lstms[j]->lstm_cell[i-1], lstms[j+1]->lstm_z[i], matrix[j+1], lstms[j]->lstm_z[i+1],matrix[j],lstms[j+1]->w,lstms[j]->dropout_mask_up,lstms[j]->dropout_mask_right);
-                if(matrix[j]!= NULL)
-                    free_matrix(matrix[j],4);
-                
-                matrix[j] = temp;
-                
-                
-            }
-            
-            else{
-                
-                get_dropout_array(lstms[j]->size,lstms[j]->dropout_mask_right,lstms[j]->lstm_hidden[i-1],dropout_output2);
-                
-
-                if(i == window-1)
-                    temp = lstm_bp(lstm_bp_flag,lstms[j]->size, lstms[j]->d_w,lstms[j]->d_u,lstms[j]->d_biases,lstms[j]->w,lstms[j]->u,lstms[j]->lstm_z[i], dx, input_model[i],lstms[j]->lstm_cell[i],dropout_output2,lstms[j]->lstm_cell[i-1], lstms[j+1]->lstm_z[i], matrix[j+1], first_dec_orizontal[j]->lstm_z[0],dfioc[j],lstms[j+1]->w,lstms[j]->dropout_mask_up,dropout_mask_dec[j]);
-                
-                else
-                    temp = lstm_bp(lstm_bp_flag,lstms[j]->size, lstms[j]->d_w,lstms[j]->d_u,lstms[j]->d_biases,lstms[j]->w,lstms[j]->u,lstms[j]->lstm_z[i], dx, input_model[i],lstms[j]->lstm_cell[i],dropout_output2,lstms[j]->lstm_cell[i-1], lstms[j+1]->lstm_z[i], matrix[j+1], lstms[j]->lstm_z[i+1],matrix[j],lstms[j+1]->w,lstms[j]->dropout_mask_up,lstms[j]->dropout_mask_right);
-                
-                if(matrix[j]!= NULL)
-                    free_matrix(matrix[j],4);
-                
-                matrix[j] = temp;
-                
-            }
-            
-            copy_array(dx,dz,lstms[0]->size);
-            free(dx);
-            
-            if(!j && input_error != NULL){
-                input_error[i] = lstm_dinput(i,lstms[j]->size,matrix[j],lstms[j]);
-                if(lstms[j]->residual_flag == LSTM_RESIDUAL)
-                    sum1D(input_error[i],dz,input_error[i],lstms[j]->size);
-            }
-            
-            
-            
-        }
-        
+    memset(rec->attention_values_error,0,sizeof(float)*encoder_window*encoder_size);
+    attention_weights_back_prop(rec->flatten_fcl_input,rec->hiddens[0],rec->softmax_array[0],rec->attention_contexts_error,rec->attention_scores_error,rec->m[0]->fcls[0]->weights,rec->m[0]->fcls[0]->d_weights,rec->m[0]->fcls[0]->d_biases,rec->attention_values_error,rec->attention_temp,encoder_window,encoder_size,window);
+    for(k = 0; k < encoder_window; k++){
+        sum1D(rec->output_error_encoder[k],&rec->attention_values_error[k*encoder_size],rec->output_error_encoder[k],encoder_size);
     }
     
-    i = 0;
-    /* computing back propagation just for the first lstm layers with hidden states defined by the previous batch*/
-    for(j = layers-1; j >= 0; j--){
-            
-        dx = (float*)calloc(lstms[0]->size,sizeof(float));
-        if(j < layers-1 && lstms[j+1]->residual_flag == LSTM_RESIDUAL)
-            sum1D(dx,dz,dx,lstms[0]->size);
-        if(j == layers-1 && i == window-1)
-            lstm_bp_flag = 0;
-        else if(j != layers-1 && i == window-1)
-            lstm_bp_flag = 1;
-            
-        else if(j == layers-1 && i != window-1)
-            lstm_bp_flag = 2;
-            
-        else
-            lstm_bp_flag = 3;
-        
-        
-        if(j == layers-1)
-            
-            get_dropout_array(lstms[j]->size,lstms[j]->dropout_mask_up,error_model[i],dx);
-
-        if(j == layers-1){
-            
-            if(j != 0)
-                get_dropout_array(lstms[j]->size,lstms[j-1]->dropout_mask_up,lstms[j-1]->lstm_hidden[i],dropout_output);
-            get_dropout_array(lstms[j]->size,lstms[j]->dropout_mask_right,hidden_states[j],dropout_output2);
-            
-            if(j != 0)
-                temp = lstm_bp(lstm_bp_flag,lstms[j]->size, lstms[j]->d_w,lstms[j]->d_u, lstms[j]->d_biases, lstms[j]->w, lstms[j]->u, lstms[j]->lstm_z[i], dx,dropout_output,lstms[j]->lstm_cell[i],dropout_output2,cell_states[j], NULL, NULL, lstms[j]->lstm_z[i+1],matrix[j],NULL,lstms[j]->dropout_mask_up,lstms[j]->dropout_mask_right);
-            else
-                temp = lstm_bp(lstm_bp_flag,lstms[j]->size, lstms[j]->d_w,lstms[j]->d_u, lstms[j]->d_biases, lstms[j]->w, lstms[j]->u, lstms[j]->lstm_z[i], dx,input_model[i],lstms[j]->lstm_cell[i],dropout_output2,cell_states[j], NULL, NULL, lstms[j]->lstm_z[i+1],matrix[j],NULL,lstms[j]->dropout_mask_up,lstms[j]->dropout_mask_right);
-            
-            if(matrix[j] != NULL)
-                free_matrix(matrix[j],4);
-            matrix[j] = temp;
-            
-        }
-        
-        else if(j != layers-1 && j != 0){
-            
-            get_dropout_array(lstms[j]->size,lstms[j-1]->dropout_mask_up,lstms[j-1]->lstm_hidden[i],dropout_output);
-            get_dropout_array(lstms[j]->size,lstms[j]->dropout_mask_right,hidden_states[j],dropout_output2);
-            
-
-            temp = lstm_bp(lstm_bp_flag,lstms[j]->size, lstms[j]->d_w,lstms[j]->d_u,lstms[j]->d_biases,lstms[j]->w,lstms[j]->u,lstms[j]->lstm_z[i], dx, dropout_output,lstms[j]->lstm_cell[i],dropout_output2,cell_states[j], lstms[j+1]->lstm_z[i], matrix[j+1], lstms[j]->lstm_z[i+1],matrix[j],lstms[j+1]->w,lstms[j]->dropout_mask_up,lstms[j]->dropout_mask_right);
-            if(matrix[j] != NULL)
-                free_matrix(matrix[j],4);
-            matrix[j] = temp;
-        }
-        
-        else{
-            
-            get_dropout_array(lstms[j]->size,lstms[j]->dropout_mask_right,hidden_states[j],dropout_output2);
-            
-            temp = lstm_bp(lstm_bp_flag,lstms[j]->size, lstms[j]->d_w,lstms[j]->d_u,lstms[j]->d_biases,lstms[j]->w,lstms[j]->d_u,lstms[j]->lstm_z[i], dx, input_model[i],lstms[j]->lstm_cell[i],dropout_output2,cell_states[j], lstms[j+1]->lstm_z[i], matrix[j+1], lstms[j]->lstm_z[i+1],matrix[j],lstms[j+1]->w,lstms[j]->dropout_mask_up,lstms[j]->dropout_mask_right);
-            if(matrix[j] != NULL)
-                free_matrix(matrix[j],4);
-            matrix[j] = temp;
-            
-        }
-        copy_array(dx,dz,lstms[0]->size);
-        free(dx);
-        
-        if(!j && input_error != NULL){
-            input_error[i] = lstm_dinput(i,lstms[j]->size,matrix[j],lstms[j]);
-            if(lstms[j]->residual_flag == LSTM_RESIDUAL)
-                sum1D(input_error[i],dz,input_error[i],lstms[j]->size);
-        }
+    for(j = 0; j < layers; j++){
+        bp_lstm_window_weights(lstms[j]);
     }
-    
-    free(dropout_output);
-    free(dropout_output2);
-    free(dz);
-    return matrix;
-    
 }
 
 /* This function computes the feed forward of a recurrent_enc_dec with group normalization params (for decoder)
@@ -1022,101 +669,56 @@ void ff_recurrent_dec(float** hidden_states, float** cell_states, float** input_
 
 
 
-/* This function computes the backpropagation of a recurrent_enc_dec with grouped normalization layers (for decoder)
+/* This function computes the backpropagation of the decoder of a recurrent_enc_dec with grouped normalization layers without allocating anything:
+ * the lstms between two normalizations are back propagated together by bp_decoder_lstm and the errors passed between them live in the workspace
+ * of the decoder (error_window, error_window2). The errors of the first timestep of each lstm are left in dfioc and the errors of the states
+ * passed to the first timestep in bp_temp, see bp_decoder_lstm
  * 
  *  * Inputs:
  * 
  * 
  *             @ float** hidden_states:= the hidden sates passed to each first orizontal cell, dimensions:m->layer*m->size
  *             @ float** cell_states:= the cell sates passed to each first orizontal cell, dimensions:m->layer*m->size
- *             @ float** input_model:= the input passed to the model, dimensions: m->window*m->size
  *             @ float** error_model:= the error of the model, dimensions: m->window*m->size
  *             @ recurrent_enc_dec* rec:= the recurrent enc dec model
- *             @ float** input_error:= the error of the inputs of this model, dimensions: m->window*m->size, must be initialized only with m->window
+ *             @ float** input_error:= where the errors of the inputs of the decoder are written, dimensions: m->window*m->size, can be NULL
  * 
  * */
-float*** bp_recurrent_dec(float** hidden_states, float** cell_states, float** input_model, float** error_model, recurrent_enc_dec* rec, float** input_error){
+void bp_recurrent_dec(float** hidden_states, float** cell_states, float** error_model, recurrent_enc_dec* rec, float** input_error){
     if(rec->decoder == NULL)
-        return NULL;
-    float*** ret = (float***)malloc(sizeof(float**)*rec->decoder->layers);//Storing all the returned values of bp of lstms
-    float*** ret2;//to handle the returned values of bp of lstms
-    float** input_error3 = (float**)malloc(sizeof(float*)*rec->decoder->window);//input error for lstms
-    float** error2_model = (float**)malloc(sizeof(float*)*rec->decoder->window);//error propagated
-    int i,j,ret_count = rec->decoder->layers-1,z;
-    float** temp = (float**)malloc(sizeof(float*)*rec->decoder->window);// inputs of lstms
-    for(i = 0; i < rec->decoder->window; i++){
-        error2_model[i] = (float*)calloc(rec->decoder->lstms[0]->size,sizeof(float));
-        copy_array(error_model[i],error2_model[i],rec->decoder->lstms[0]->size);
-    }
-    int flagg = 0;
-    int k = 0;
-    while(k > -1){
-        int flag = 0;
-        for(k = ret_count; k >= 0; k--){
-            if(rec->decoder->lstms[k]->norm_flag == GROUP_NORMALIZATION){
-                if(flagg) flagg = 0;
-                else{
-                    flag = 1;
-                    break;
-                }
-            }
-        }
-        if(flag){
-            int n_cells = ret_count-k;
-            flagg = 1;
-            if(n_cells){
-                for(j = 0; j < rec->decoder->lstms[k]->window/rec->decoder->lstms[k]->n_grouped_cell; j++){
-                    for(z = 0; z < rec->decoder->lstms[k]->n_grouped_cell; z++){
-                        temp[j*rec->decoder->lstms[k]->n_grouped_cell+z] = rec->decoder->lstms[k]->bns[j]->outputs[z];
-                    }
-                }
-                ret2 = bp_decoder_lstm(&hidden_states[k+1],&cell_states[k+1],temp,error2_model,rec->decoder->window,rec->decoder->lstms[0]->size,n_cells,&rec->decoder->lstms[k+1],input_error3,rec);
-                for(j = 0; j < rec->decoder->window; j++){
-                    copy_array(input_error3[j],error2_model[j],rec->decoder->lstms[0]->size);
-                    free(input_error3[j]);
-                }
-                for(j = ret_count; j > ret_count-n_cells; j--){
-                    ret[j] = ret2[n_cells-1-(ret_count-j)];
-                }
-                free(ret2);
-            }
-            for(j = 0; j < rec->decoder->lstms[k]->window/rec->decoder->lstms[k]->n_grouped_cell;j++){
-                batch_normalization_back_prop(rec->decoder->lstms[k]->n_grouped_cell,&rec->decoder->lstms[k]->out_up[j*rec->decoder->lstms[k]->n_grouped_cell],rec->decoder->lstms[k]->bns[j]->temp_vectors,rec->decoder->lstms[k]->bns[j]->vector_dim,rec->decoder->lstms[k]->bns[j]->gamma,rec->decoder->lstms[k]->bns[j]->beta,rec->decoder->lstms[k]->bns[j]->mean,rec->decoder->lstms[k]->bns[j]->var,&error2_model[j*rec->decoder->lstms[k]->n_grouped_cell],rec->decoder->lstms[k]->bns[j]->d_gamma,rec->decoder->lstms[k]->bns[j]->d_beta,rec->decoder->lstms[k]->bns[j]->error2,rec->decoder->lstms[k]->bns[j]->temp1,rec->decoder->lstms[k]->bns[j]->temp2,rec->decoder->lstms[k]->bns[j]->epsilon);
+        return;
+    int i,z,first,last;
+    rmodel* m = rec->decoder;
+    float** error = error_model;
+    float** next;
+    lstm* l;
+    for(last = m->layers-1; last >= 0; last = first-1){
+        l = m->lstms[last];
+        if(l->norm_flag == GROUP_NORMALIZATION){
+            for(i = 0; i < l->window/l->n_grouped_cell; i++){
+                batch_normalization_back_prop(l->n_grouped_cell,&l->out_up[i*l->n_grouped_cell],l->bns[i]->temp_vectors,l->bns[i]->vector_dim,l->bns[i]->gamma,l->bns[i]->beta,l->bns[i]->mean,l->bns[i]->var,&error[i*l->n_grouped_cell],l->bns[i]->d_gamma,l->bns[i]->d_beta,l->bns[i]->error2,l->bns[i]->temp1,l->bns[i]->temp2,l->bns[i]->epsilon);
             }
-            
-            for(j = 0; j < rec->decoder->window/rec->decoder->lstms[k]->n_grouped_cell; j++){
-                for(z = 0; z < rec->decoder->lstms[k]->n_grouped_cell; z++){
-                    copy_array(rec->decoder->lstms[k]->bns[j]->error2[z],error2_model[j*rec->decoder->lstms[k]->n_grouped_cell+z],rec->decoder->lstms[0]->size);
+            next = error == m->error_window ? m->error_window2 : m->error_window;
+            for(i = 0; i < l->window/l->n_grouped_cell; i++){
+                for(z = 0; z < l->n_grouped_cell; z++){
+                    copy_array(l->bns[i]->error2[z],next[i*l->n_grouped_cell+z],l->size);
                 }
             }
-            
-            if(n_cells)
-                ret_count = k;
+            error = next;
         }
         
-        else{
-            int n_cells = ret_count-k;
-            int k2 = k;
-            if(k < 0) k = 0;
-            ret2 = bp_decoder_lstm(&hidden_states[k],&cell_states[k],input_model,error2_model,rec->decoder->window,rec->decoder->lstms[0]->size,n_cells,&rec->decoder->lstms[k],input_error,rec);
-            k = k2;
-
-            for(j = ret_count; j > k; j--){
-                ret[j] = ret2[j];
-            }    
-            free(ret2);
-        }
+        // the lstms from the one after the previous normalization to this one are computed together by ff_decoder_lstm
+        for(first = last; first > 0 && m->lstms[first-1]->norm_flag != GROUP_NORMALIZATION; first--);
+        next = first == 0 && input_error != NULL ? input_error : (error == m->error_window ? m->error_window2 : m->error_window);
+        bp_decoder_lstm(&hidden_states[first],&cell_states[first],error,m->window,last-first+1,&m->lstms[first],next,rec);
+        error = next;
     }
-    
-    free_matrix(error2_model,rec->decoder->window);
-    free(input_error3);
-    free(temp);
-    return ret;
-    
 }
 
 
-/* This function computes the backpropagation of a recurrent_enc_dec with grouped normalization layers (for decoder)
+/* This function computes the backpropagation of the encoder of a recurrent_enc_dec with bp_rmodel_workspace,
+ * the last hidden and cell states of the encoder are the first states of the decoder, so their errors are carried
+ * from the first timestep of the decoder
  * 
  *  * Inputs:
  * 
@@ -1127,88 +729,30 @@ float*** bp_recurrent_dec(float** hidden_states, float** cell_states, float** in
  *             @ float** error_model:= the error of the model, dimensions: m->window*m->size
  *             @ recurrent_enc_dec* rec:= the recurrent enc dec model
  *             @ float** input_error:= the error of the inputs of this model, dimensions: m->window*m->size, must be initialized only with m->window
+ *             @ float** hidden_states_error:= dL/dh of the hidden states passed to the decoder, dimensions: m->layers*m->size, can be NULL
+ *             @ float** cell_states_error:= dL/dc of the cell states passed to the decoder, dimensions: m->layers*m->size, can be NULL
  * 
  * */
-float*** bp_recurrent_enc(float** hidden_states, float** cell_states, float** input_model, float** error_model, recurrent_enc_dec* rec, float** input_error, float*** dfioc, float** dropout_mask_dec, lstm** first_dec_orizontal){
+float*** bp_recurrent_enc(float** hidden_states, float** cell_states, float** input_model, float** error_model, recurrent_enc_dec* rec, float** input_error, float** hidden_states_error, float** cell_states_error){
     if(rec->encoder == NULL)
         return NULL;
-    float*** ret = (float***)malloc(sizeof(float**)*rec->encoder->layers);//Storing all the returned values of bp of lstms
-    float*** ret2;//to handle the returned values of bp of lstms
-    float** input_error3 = (float**)malloc(sizeof(float*)*rec->encoder->window);//input error for lstms
-    float** error2_model = (float**)malloc(sizeof(float*)*rec->encoder->window);//error propagated
-    int i,j,ret_count = rec->encoder->layers-1,z;
-    int flag_time = 1;
-    float** temp = (float**)malloc(sizeof(float*)*rec->encoder->window);// inputs of lstms
-    for(i = 0; i < rec->decoder->window; i++){
-        error2_model[i] = (float*)calloc(rec->encoder->lstms[0]->size,sizeof(float));
-        copy_array(error_model[i],error2_model[i],rec->encoder->lstms[0]->size);
-    }
-    int flagg = 0;
-    int k = 0;
-    while(k > -1){
-        int flag = 0;
-        for(k = ret_count; k >= 0; k--){
-            if(rec->encoder->lstms[k]->norm_flag == GROUP_NORMALIZATION){
-                if(flagg) flagg = 0;
-                else{
-                    flag = 1;
-                    break;
-                }
-            }
-        }
-        if(flag){
-            int n_cells = ret_count-k;
-            flagg = 1;
-            if(n_cells){
-                for(j = 0; j < rec->encoder->lstms[k]->window/rec->encoder->lstms[k]->n_grouped_cell; j++){
-                    for(z = 0; z < rec->encoder->lstms[k]->n_grouped_cell; z++){
-                        temp[j*rec->encoder->lstms[k]->n_grouped_cell+z] = rec->encoder->lstms[k]->bns[j]->outputs[z];
-                    }
-                }
-                ret2 = bp_encoder_lstm(&hidden_states[k+1],&cell_states[k+1],temp,error2_model,rec->encoder->window,rec->encoder->lstms[0]->size,n_cells,&rec->encoder->lstms[k+1],input_error3,&dfioc[k+1],&dropout_mask_dec[k+1],&first_dec_orizontal[k+1]);
-                
-                for(j = 0; j < rec->encoder->window; j++){
-                    copy_array(input_error3[j],error2_model[j],rec->encoder->lstms[0]->size);
-                    free(input_error3[j]);
-                }
-                for(j = ret_count; j > ret_count-n_cells; j--){
-                    ret[j] = ret2[n_cells-1-(ret_count-j)];
-                }
-                free(ret2);
-            }
-            for(j = 0; j < rec->encoder->lstms[k]->window/rec->encoder->lstms[k]->n_grouped_cell;j++){
-                batch_normalization_back_prop(rec->encoder->lstms[k]->n_grouped_cell,&rec->encoder->lstms[k]->out_up[j*rec->encoder->lstms[k]->n_grouped_cell],rec->encoder->lstms[k]->bns[j]->temp_vectors,rec->encoder->lstms[k]->bns[j]->vector_dim,rec->encoder->lstms[k]->bns[j]->gamma,rec->encoder->lstms[k]->bns[j]->beta,rec->encoder->lstms[k]->bns[j]->mean,rec->encoder->lstms[k]->bns[j]->var,&error2_model[j*rec->encoder->lstms[k]->n_grouped_cell],rec->encoder->lstms[k]->bns[j]->d_gamma,rec->encoder->lstms[k]->bns[j]->d_beta,rec->encoder->lstms[k]->bns[j]->error2,rec->encoder->lstms[k]->bns[j]->temp1,rec->encoder->lstms[k]->bns[j]->temp2,rec->encoder->lstms[k]->bns[j]->epsilon);
-            }
-            
-            for(j = 0; j < rec->encoder->window/rec->encoder->lstms[k]->n_grouped_cell; j++){
-                for(z = 0; z < rec->encoder->lstms[k]->n_grouped_cell; z++){
-                    copy_array(rec->encoder->lstms[k]->bns[j]->error2[z],error2_model[j*rec->encoder->lstms[k]->n_grouped_cell+z],rec->encoder->lstms[0]->size);
-                }
-            }
-            
-            if(n_cells)
-                ret_count = k;
+    int i,j;
+    rmodel* m = rec->encoder;
+    float*** ret = (float***)malloc(sizeof(float**)*m->layers);//the dfioc of the first timestep of each layer
+    if(input_error != NULL){
+        for(i = 0; i < m->window; i++){
+            input_error[i] = (float*)malloc(sizeof(float)*m->lstms[0]->size);
         }
-        
-        else{
-            int n_cells = ret_count-k;
-            int k2 = k;
-            if(k < 0) k = 0;
-            ret2 = bp_encoder_lstm(&hidden_states[k],&cell_states[k],input_model,error2_model,rec->encoder->window,rec->encoder->lstms[0]->size,n_cells,&rec->encoder->lstms[k],input_error,&dfioc[k],&dropout_mask_dec[k],&first_dec_orizontal[k]);
-            k = k2;
-
-            for(j = ret_count; j > k; j--){
-                ret[j] = ret2[j];
-            }    
-            free(ret2);
+    }
+    bp_rmodel_workspace(hidden_states,cell_states,input_model,error_model,m,input_error,hidden_states_error,cell_states_error);
+    for(i = 0; i < m->layers; i++){
+        ret[i] = (float**)malloc(sizeof(float*)*4);
+        for(j = 0; j < 4; j++){
+            ret[i][j] = (float*)malloc(sizeof(float)*m->lstms[i]->size);
+            copy_array(m->lstms[i]->dfioc[j],ret[i][j],m->lstms[i]->size);
         }
     }
-    
-    free_matrix(error2_model,rec->encoder->window);
-    free(input_error3);
-    free(temp);
     return ret;
-    
 }
 
 /* this function computes the toal feedforward of a recurrent enc dec structure
@@ -1237,7 +781,7 @@ void ff_recurrent_enc_dec(float** hidden_states, float** cell_states, float** in
         hiddens[i] = (float*)calloc(rec->decoder->lstms[0]->size,sizeof(float));
         cells[i] = (float*)calloc(rec->decoder->lstms[0]->size,sizeof(float));
         copy_array(rec->encoder->lstms[i]->lstm_hidden[rec->encoder->window-1],hiddens[i],rec->encoder->lstms[i]->size);
-        copy_array(rec->encoder->lstms[i]->lstm_cell[rec->encoder->window-1],hiddens[i],rec->encoder->lstms[i]->size);
+        copy_array(rec->encoder->lstms[i]->lstm_cell[rec->encoder->window-1],cells[i],rec->encoder->lstms[i]->size);
     }
     
     float** input = (float**)malloc(sizeof(float*)*rec->decoder->window);
@@ -1279,39 +823,39 @@ float*** bp_recurrent_enc_dec(float** hidden_states, float** cell_states, float*
         hiddens[i] = (float*)calloc(rec->decoder->lstms[0]->size,sizeof(float));
         cells[i] = (float*)calloc(rec->decoder->lstms[0]->size,sizeof(float));
         copy_array(rec->encoder->lstms[i]->lstm_hidden[rec->encoder->window-1],hiddens[i],rec->encoder->lstms[i]->size);
-        copy_array(rec->encoder->lstms[i]->lstm_cell[rec->encoder->window-1],hiddens[i],rec->encoder->lstms[i]->size);
+        copy_array(rec->encoder->lstms[i]->lstm_cell[rec->encoder->window-1],cells[i],rec->encoder->lstms[i]->size);
     }
     
-    float** input = (float**)malloc(sizeof(float*)*rec->decoder->window);
-    float** input_error = (float**)malloc(sizeof(float*)*rec->decoder->window);
-    
-    for(i = 0; i < rec->decoder->window; i++){
-        input[i] = (float*)calloc(rec->decoder->lstms[0]->size,sizeof(float));
-        copy_array(input_model2[i],&input[i][rec->encoder->lstms[0]->size],rec->decoder->lstms[0]->size-rec->encoder->lstms[0]->size);
+    float** input_error = NULL;
+    if(input_error2 != NULL){
+        input_error = (float**)malloc(sizeof(float*)*rec->decoder->window);
+        for(i = 0; i < rec->decoder->window; i++){
+            input_error[i] = (float*)malloc(sizeof(float)*rec->decoder->lstms[0]->size);
+        }
     }
     
-    float*** dfioc = bp_recurrent_dec(hiddens,cells,input,error_model,rec,input_error);
-    float** dropout_mask = (float**)malloc(sizeof(float*)*rec->decoder->n_lstm);
+    bp_recurrent_dec(hiddens,cells,error_model,rec,input_error);
+    
+    // the errors of the first states of the decoder are the errors of the last states of the encoder
+    float** hiddens_error = (float**)malloc(sizeof(float*)*rec->decoder->n_lstm);
+    float** cells_error = (float**)malloc(sizeof(float*)*rec->decoder->n_lstm);
     for(i = 0; i < rec->decoder->n_lstm; i++){
-        dropout_mask[i] = rec->decoder->lstms[i]->dropout_mask_right;
+        hiddens_error[i] = rec->decoder->lstms[i]->bp_temp;
+        cells_error[i] = &rec->decoder->lstms[i]->bp_temp[rec->decoder->lstms[i]->size];
     }
-    float*** dfioc2 = bp_recurrent_enc(hidden_states,cell_states,input_model1,rec->output_error_encoder,rec,input_error1,dfioc,dropout_mask,rec->decoder->lstms);
+    float*** dfioc2 = bp_recurrent_enc(hidden_states,cell_states,input_model1,rec->output_error_encoder,rec,input_error1,hiddens_error,cells_error);
     
-    if(input_error2[i] != NULL)
-    for(i = 0; i < rec->decoder->window; i++){
-        copy_array(&input_error[i][rec->encoder->lstms[0]->size],input_error2[i],rec->decoder->lstms[0]->size-rec->encoder->lstms[0]->size);
+    if(input_error2 != NULL){
+        for(i = 0; i < rec->decoder->window; i++){
+            copy_array(&input_error[i][rec->encoder->lstms[0]->size],input_error2[i],rec->decoder->lstms[0]->size-rec->encoder->lstms[0]->size);
+        }
+        free_matrix(input_error,rec->decoder->window);
     }
     
     free_matrix(hiddens,rec->encoder->n_lstm);
     free_matrix(cells,rec->encoder->n_lstm);
-    free_matrix(input,rec->decoder->window);
-    free_matrix(input_error,rec->decoder->window);
-    for(i = 0; i < rec->decoder->n_lstm; i++){
-        free_matrix(dfioc[i],4);
-    }
-    free(dfioc);
-    
-    sum_models_partial_derivatives(rec->m[0],&rec->m[1],rec->decoder->window-1);
+    free(hiddens_error);
+    free(cells_error);
     
     return dfioc2;
     
@@ -39,6 +39,47 @@ SOFTWARE.
  * 
  * */
 lstm* recurrent_lstm(int size, int dropout_flag1, float dropout_threshold1, int dropout_flag2, float dropout_threshold2, int layer, int window, int residual_flag, int norm_flag, int n_grouped_cell){
+    return recurrent_cell(LSTM_CELL,size,dropout_flag1,dropout_threshold1,dropout_flag2,dropout_threshold2,layer,window,residual_flag,norm_flag,n_grouped_cell);
+}
+
+/* This function returns a gated recurrent unit layer stored in a lstm structure with cell_type = GRU_CELL.
+ * The gru has 3 gates (update z, reset r, candidate n) instead of 4 and no cell state:
+ * 
+ * z = sigmoid(Wz*x + bz + Uz*h), r = sigmoid(Wr*x + br + Ur*h), n = tanh(Wn*x + bn + r*(Un*h))
+ * h' = (1-z)*n + z*h
+ * 
+ * so it owns 6 size*size matrices instead of 8. It can be mixed with lstm layers inside the same rmodel
+ * and supports the same residual, dropout and group normalization flags
+ * 
+ * Inputs:
+ * 
+ *             @ int size:= the size of each hidden layer inside the gru structure
+ *             @ int dropout_flag1:= the dropout flag for the y output of the cell
+ *             @ float dropout_threshold1:= the dropout_threshold for the y output
+ *             @ int dropout_flag2:= the dropout flag for the hidden output to the next cell
+ *             @ float dropout_threshold2:= the dropout threshold for the hidden state of the cell
+ *             @ int layer:= the vertical layer of the gru cell
+ *                @ int window:= the number of unrolled cell in orizontal
+ * 
+ * */
+lstm* recurrent_gru(int size, int dropout_flag1, float dropout_threshold1, int dropout_flag2, float dropout_threshold2, int layer, int window, int residual_flag, int norm_flag, int n_grouped_cell){
+    return recurrent_cell(GRU_CELL,size,dropout_flag1,dropout_threshold1,dropout_flag2,dropout_threshold2,layer,window,residual_flag,norm_flag,n_grouped_cell);
+}
+
+/* This function returns a recurrent layer of the given cell type, see recurrent_lstm and recurrent_gru
+ * 
+ * Inputs:
+ * 
+ *             @ int cell_type:= LSTM_CELL or GRU_CELL
+ *             @ the others:= the same of recurrent_lstm
+ * 
+ * */
+lstm* recurrent_cell(int cell_type, int size, int dropout_flag1, float dropout_threshold1, int dropout_flag2, float dropout_threshold2, int layer, int window, int residual_flag, int norm_flag, int n_grouped_cell){
+    if(cell_type != LSTM_CELL && cell_type != GRU_CELL){
+        fprintf(stderr,"Error: the cell type must be LSTM_CELL or GRU_CELL\n");
+        exit(1);
+    }
+    
     if(layer < 0 || size <= 0){
         fprintf(stderr,"Error: the layer flag must be >= 0 and size param should be > 0\n");
         exit(1);
@@ -57,34 +98,45 @@ lstm* recurrent_lstm(int size, int dropout_flag1, float dropout_threshold1, int
     }
     int i,j;
     lstm* lstml = (lstm*)malloc(sizeof(lstm));
+    lstml->cell_type = cell_type;
+    lstml->n_gates = cell_type == GRU_CELL ? GRU_GATES : LSTM_GATES;
     lstml->layer = layer;
     lstml->size = size;
     lstml->dropout_flag_up = dropout_flag1;
     lstml->dropout_flag_right = dropout_flag2;
-    lstml->w = (float**)malloc(sizeof(float*)*4);
-    lstml->u = (float**)malloc(sizeof(float*)*4);
-    lstml->d_w = (float**)malloc(sizeof(float*)*4);
-    lstml->ex_d_w_diff_grad = (float**)malloc(sizeof(float*)*4);
-    lstml->d1_w = (float**)malloc(sizeof(float*)*4);
-    lstml->d2_w = (float**)malloc(sizeof(float*)*4);
-    lstml->d3_w = (float**)malloc(sizeof(float*)*4);
-    lstml->d_u = (float**)malloc(sizeof(float*)*4);
-    lstml->ex_d_u_diff_grad = (float**)malloc(sizeof(float*)*4);
-    lstml->d1_u = (float**)malloc(sizeof(float*)*4);
-    lstml->d2_u = (float**)malloc(sizeof(float*)*4);
-    lstml->d3_u = (float**)malloc(sizeof(float*)*4);
-    lstml->biases = (float**)malloc(sizeof(float*)*4);
-    lstml->d_biases = (float**)malloc(sizeof(float*)*4);
-    lstml->ex_d_biases_diff_grad = (float**)malloc(sizeof(float*)*4);
-    lstml->d1_biases = (float**)malloc(sizeof(float*)*4);
-    lstml->d2_biases = (float**)malloc(sizeof(float*)*4);
-    lstml->d3_biases = (float**)malloc(sizeof(float*)*4);
+    lstml->w = (float**)malloc(sizeof(float*)*lstml->n_gates);
+    lstml->u = (float**)malloc(sizeof(float*)*lstml->n_gates);
+    lstml->d_w = (float**)malloc(sizeof(float*)*lstml->n_gates);
+    lstml->ex_d_w_diff_grad = (float**)malloc(sizeof(float*)*lstml->n_gates);
+    lstml->d1_w = (float**)malloc(sizeof(float*)*lstml->n_gates);
+    lstml->d2_w = (float**)malloc(sizeof(float*)*lstml->n_gates);
+    lstml->d3_w = (float**)malloc(sizeof(float*)*lstml->n_gates);
+    lstml->d_u = (float**)malloc(sizeof(float*)*lstml->n_gates);
+    lstml->ex_d_u_diff_grad = (float**)malloc(sizeof(float*)*lstml->n_gates);
+    lstml->d1_u = (float**)malloc(sizeof(float*)*lstml->n_gates);
+    lstml->d2_u = (float**)malloc(sizeof(float*)*lstml->n_gates);
+    lstml->d3_u = (float**)malloc(sizeof(float*)*lstml->n_gates);
+    lstml->biases = (float**)malloc(sizeof(float*)*lstml->n_gates);
+    lstml->d_biases = (float**)malloc(sizeof(float*)*lstml->n_gates);
+    lstml->ex_d_biases_diff_grad = (float**)malloc(sizeof(float*)*lstml->n_gates);
+    lstml->d1_biases = (float**)malloc(sizeof(float*)*lstml->n_gates);
+    lstml->d2_biases = (float**)malloc(sizeof(float*)*lstml->n_gates);
+    lstml->d3_biases = (float**)malloc(sizeof(float*)*lstml->n_gates);
     lstml->lstm_z = (float***)malloc(sizeof(float**)*window);
     lstml->lstm_hidden = (float**)malloc(sizeof(float*)*window);
     lstml->out_up = (float**)malloc(sizeof(float*)*window);
     lstml->lstm_cell = (float**)malloc(sizeof(float*)*window);
     lstml->dropout_mask_up = (float*)malloc(sizeof(float)*size);
     lstml->dropout_mask_right = (float*)malloc(sizeof(float)*size);
+    lstml->x_window = (float*)calloc(window*size,sizeof(float));
+    lstml->zx = (float*)calloc(window*lstml->n_gates*size,sizeof(float));
+    lstml->h_right = (float*)calloc(size,sizeof(float));
+    lstml->h_window = (float*)calloc((cell_type == GRU_CELL ? 2 : 1)*window*size,sizeof(float));
+    lstml->bp_temp = (float*)calloc(4*size,sizeof(float));
+    lstml->dfioc = (float**)malloc(sizeof(float*)*4);
+    for(i = 0; i < 4; i++){
+        lstml->dfioc[i] = (float*)calloc(size,sizeof(float));
+    }
     lstml->dropout_threshold_up = dropout_threshold1;
     lstml->dropout_threshold_right = dropout_threshold2;
     lstml->residual_flag = residual_flag;
@@ -107,16 +159,16 @@ lstm* recurrent_lstm(int size, int dropout_flag1, float dropout_threshold1, int
         lstml->dropout_threshold_right = 0;
     
     for(i = 0; i < window; i++){
-        lstml->lstm_z[i] = (float**)malloc(sizeof(float*)*4);
+        lstml->lstm_z[i] = (float**)malloc(sizeof(float*)*lstml->n_gates);
         lstml->lstm_hidden[i] = (float*)calloc(size,sizeof(float));
         lstml->lstm_cell[i] = (float*)calloc(size,sizeof(float));
         lstml->out_up[i] = (float*)calloc(size,sizeof(float));
-        for(j = 0; j < 4; j++){
+        for(j = 0; j < lstml->n_gates; j++){
             lstml->lstm_z[i][j] = (float*)calloc(size,sizeof(float));
         }
     }
     
-    for(i = 0; i < 4; i++){
+    for(i = 0; i < lstml->n_gates; i++){
         lstml->w[i] = (float*)calloc(size*size,sizeof(float));
         lstml->u[i] = (float*)calloc(size*size,sizeof(float));
         for(j = 0; j < size*size; j++){
@@ -171,7 +223,7 @@ void free_recurrent_lstm(lstm* rlstm){
     int i,j;
     
     for(i = 0; i < rlstm->window; i++){
-        for(j = 0; j < 4; j++){
+        for(j = 0; j < rlstm->n_gates; j++){
             free(rlstm->lstm_z[i][j]);
         }
         free(rlstm->lstm_z[i]);
@@ -180,7 +232,7 @@ void free_recurrent_lstm(lstm* rlstm){
         free(rlstm->out_up[i]);
     }
     
-    for(i = 0; i < 4; i++){
+    for(i = 0; i < rlstm->n_gates; i++){
         free(rlstm->w[i]);
         free(rlstm->u[i]);
         free(rlstm->d_w[i]);
@@ -231,6 +283,12 @@ void free_recurrent_lstm(lstm* rlstm){
     free(rlstm->out_up);
     free(rlstm->dropout_mask_right);
     free(rlstm->dropout_mask_up);
+    free(rlstm->x_window);
+    free(rlstm->zx);
+    free(rlstm->h_right);
+    free(rlstm->h_window);
+    free(rlstm->bp_temp);
+    free_matrix(rlstm->dfioc,4);
     free(rlstm);
 
 }
@@ -261,6 +319,16 @@ void save_lstm(lstm* rlstm, int n){
         exit(1);
     }
     
+    if(rlstm->cell_type != LSTM_CELL){// negative tag before the residual flag, the lstm layers keep the old format
+        j = -rlstm->cell_type;
+        i = fwrite(&j,sizeof(int),1,fw);
+        
+        if(i != 1){
+            fprintf(stderr,"Error: an error occurred saving a lstm layer\n");
+            exit(1);
+        }
+    }
+    
     i = fwrite(&rlstm->residual_flag,sizeof(int),1,fw);
     
     if(i != 1){
@@ -332,7 +400,7 @@ void save_lstm(lstm* rlstm, int n){
     }
     
     
-    for(j = 0; j < 4; j++){
+    for(j = 0; j < rlstm->n_gates; j++){
         i = fwrite(rlstm->w[j],sizeof(float)*(rlstm->size)*(rlstm->size),1,fw);
     
         if(i != 1){
@@ -397,6 +465,16 @@ void heavy_save_lstm(lstm* rlstm, int n){
         exit(1);
     }
     
+    if(rlstm->cell_type != LSTM_CELL){// negative tag before the residual flag, the lstm layers keep the old format
+        j = -rlstm->cell_type;
+        i = fwrite(&j,sizeof(int),1,fw);
+        
+        if(i != 1){
+            fprintf(stderr,"Error: an error occurred saving a lstm layer\n");
+            exit(1);
+        }
+    }
+    
     i = fwrite(&rlstm->residual_flag,sizeof(int),1,fw);
     
     if(i != 1){
@@ -468,7 +546,7 @@ void heavy_save_lstm(lstm* rlstm, int n){
     }
     
     
-    for(j = 0; j < 4; j++){
+    for(j = 0; j < rlstm->n_gates; j++){
         i = fwrite(rlstm->w[j],sizeof(float)*(rlstm->size)*(rlstm->size),1,fw);
     
         if(i != 1){
@@ -601,11 +679,11 @@ lstm* load_lstm(FILE* fr){
         return NULL;
     int i,j;
     
-    int size = 0,layer = 0,dropout_flag_up = 0,dropout_flag_right = 0, window = 0, residual_flag = 0, norm_flag = 0, n_grouped_cell = 0;
+    int size = 0,layer = 0,dropout_flag_up = 0,dropout_flag_right = 0, window = 0, residual_flag = 0, norm_flag = 0, n_grouped_cell = 0, cell_type = LSTM_CELL, n_gates = LSTM_GATES;
     float dropout_threshold_right = 0,dropout_threshold_up = 0;
-    float** w = (float**)malloc(sizeof(float*)*4);
-    float** u = (float**)malloc(sizeof(float*)*4);
-    float** biases = (float**)malloc(sizeof(float*)*4);
+    float** w = (float**)malloc(sizeof(float*)*LSTM_GATES);
+    float** u = (float**)malloc(sizeof(float*)*LSTM_GATES);
+    float** biases = (float**)malloc(sizeof(float*)*LSTM_GATES);
     
     i = fread(&residual_flag,sizeof(int),1,fr);
     
@@ -614,6 +692,17 @@ lstm* load_lstm(FILE* fr){
         exit(1);
     }
     
+    if(residual_flag < 0){// a gru layer, the tag is followed by the residual flag
+        cell_type = -residual_flag;
+        n_gates = GRU_GATES;
+        i = fread(&residual_flag,sizeof(int),1,fr);
+        
+        if(i != 1){
+            fprintf(stderr,"Error: an error occurred loading a lstm layer\n");
+            exit(1);
+        }
+    }
+    
     i = fread(&norm_flag,sizeof(int),1,fr);
     
     if(i != 1){
@@ -677,7 +766,7 @@ lstm* load_lstm(FILE* fr){
         exit(1);
     }
     
-    for(j = 0; j < 4; j++){
+    for(j = 0; j < n_gates; j++){
         w[j] = (float*)malloc(sizeof(float)*size*size);
         u[j] = (float*)malloc(sizeof(float)*size*size);
         biases[j] = (float*)malloc(sizeof(float)*size);
@@ -712,8 +801,8 @@ lstm* load_lstm(FILE* fr){
         }
     }
     
-    lstm* l = recurrent_lstm(size,dropout_flag_up,dropout_threshold_up,dropout_flag_right,dropout_threshold_right,layer, window, residual_flag,norm_flag,n_grouped_cell);
-    for(i = 0; i < 4; i++){
+    lstm* l = recurrent_cell(cell_type,size,dropout_flag_up,dropout_threshold_up,dropout_flag_right,dropout_threshold_right,layer, window, residual_flag,norm_flag,n_grouped_cell);
+    for(i = 0; i < n_gates; i++){
         copy_array(w[i],l->w[i],size*size);
         copy_array(u[i],l->u[i],size*size);
         copy_array(biases[i],l->biases[i],size);
@@ -750,23 +839,23 @@ lstm* heavy_load_lstm(FILE* fr){
         return NULL;
     int i,j;
     
-    int size = 0,layer = 0,dropout_flag_up = 0,dropout_flag_right = 0, window = 0, residual_flag = 0, norm_flag = 0, n_grouped_cell = 0;
+    int size = 0,layer = 0,dropout_flag_up = 0,dropout_flag_right = 0, window = 0, residual_flag = 0, norm_flag = 0, n_grouped_cell = 0, cell_type = LSTM_CELL, n_gates = LSTM_GATES;
     float dropout_threshold_right = 0,dropout_threshold_up = 0;
-    float** w = (float**)malloc(sizeof(float*)*4);
-    float** d1_w = (float**)malloc(sizeof(float*)*4);
-    float** d2_w = (float**)malloc(sizeof(float*)*4);
-    float** d3_w = (float**)malloc(sizeof(float*)*4);
-    float** ex_d_w_diff_grad = (float**)malloc(sizeof(float*)*4);
-    float** u = (float**)malloc(sizeof(float*)*4);
-    float** d1_u = (float**)malloc(sizeof(float*)*4);
-    float** d2_u = (float**)malloc(sizeof(float*)*4);
-    float** d3_u = (float**)malloc(sizeof(float*)*4);
-    float** ex_d_u_diff_grad = (float**)malloc(sizeof(float*)*4);
-    float** biases = (float**)malloc(sizeof(float*)*4);
-    float** d1_biases = (float**)malloc(sizeof(float*)*4);
-    float** d2_biases = (float**)malloc(sizeof(float*)*4);
-    float** d3_biases = (float**)malloc(sizeof(float*)*4);
-    float** ex_d_biases_diff_grad = (float**)malloc(sizeof(float*)*4);
+    float** w = (float**)malloc(sizeof(float*)*LSTM_GATES);
+    float** d1_w = (float**)malloc(sizeof(float*)*LSTM_GATES);
+    float** d2_w = (float**)malloc(sizeof(float*)*LSTM_GATES);
+    float** d3_w = (float**)malloc(sizeof(float*)*LSTM_GATES);
+    float** ex_d_w_diff_grad = (float**)malloc(sizeof(float*)*LSTM_GATES);
+    float** u = (float**)malloc(sizeof(float*)*LSTM_GATES);
+    float** d1_u = (float**)malloc(sizeof(float*)*LSTM_GATES);
+    float** d2_u = (float**)malloc(sizeof(float*)*LSTM_GATES);
+    float** d3_u = (float**)malloc(sizeof(float*)*LSTM_GATES);
+    float** ex_d_u_diff_grad = (float**)malloc(sizeof(float*)*LSTM_GATES);
+    float** biases = (float**)malloc(sizeof(float*)*LSTM_GATES);
+    float** d1_biases = (float**)malloc(sizeof(float*)*LSTM_GATES);
+    float** d2_biases = (float**)malloc(sizeof(float*)*LSTM_GATES);
+    float** d3_biases = (float**)malloc(sizeof(float*)*LSTM_GATES);
+    float** ex_d_biases_diff_grad = (float**)malloc(sizeof(float*)*LSTM_GATES);
     
     i = fread(&residual_flag,sizeof(int),1,fr);
     
@@ -775,6 +864,17 @@ lstm* heavy_load_lstm(FILE* fr){
         exit(1);
     }
     
+    if(residual_flag < 0){// a gru layer, the tag is followed by the residual flag
+        cell_type = -residual_flag;
+        n_gates = GRU_GATES;
+        i = fread(&residual_flag,sizeof(int),1,fr);
+        
+        if(i != 1){
+            fprintf(stderr,"Error: an error occurred loading a lstm layer\n");
+            exit(1);
+        }
+    }
+    
     i = fread(&norm_flag,sizeof(int),1,fr);
     
     if(i != 1){
@@ -839,7 +939,7 @@ lstm* heavy_load_lstm(FILE* fr){
         exit(1);
     }
     
-    for(j = 0; j < 4; j++){
+    for(j = 0; j < n_gates; j++){
         w[j] = (float*)malloc(sizeof(float)*size*size);
         d1_w[j] = (float*)malloc(sizeof(float)*size*size);
         d2_w[j] = (float*)malloc(sizeof(float)*size*size);
@@ -965,8 +1065,8 @@ lstm* heavy_load_lstm(FILE* fr){
         }
     }
     
-    lstm* l = recurrent_lstm(size,dropout_flag_up,dropout_threshold_up,dropout_flag_right,dropout_threshold_right,layer, window, residual_flag,norm_flag,n_grouped_cell);
-    for(i = 0; i < 4; i++){
+    lstm* l = recurrent_cell(cell_type,size,dropout_flag_up,dropout_threshold_up,dropout_flag_right,dropout_threshold_right,layer, window, residual_flag,norm_flag,n_grouped_cell);
+    for(i = 0; i < n_gates; i++){
         copy_array(w[i],l->w[i],size*size);
         copy_array(d1_w[i],l->d1_w[i],size*size);
         copy_array(d2_w[i],l->d2_w[i],size*size);
@@ -1045,8 +1145,8 @@ lstm* copy_lstm(lstm* l){
         return NULL;
     int i;
     
-    lstm* copy = recurrent_lstm(l->size,l->dropout_flag_up,l->dropout_threshold_up,l->dropout_flag_right,l->dropout_threshold_right,l->layer, l->window,l->residual_flag,l->norm_flag,l->n_grouped_cell);
-    for(i = 0; i < 4; i++){
+    lstm* copy = recurrent_cell(l->cell_type,l->size,l->dropout_flag_up,l->dropout_threshold_up,l->dropout_flag_right,l->dropout_threshold_right,l->layer, l->window,l->residual_flag,l->norm_flag,l->n_grouped_cell);
+    for(i = 0; i < l->n_gates; i++){
         copy_array(l->w[i],copy->w[i],l->size*l->size);
         copy_array(l->d_w[i],copy->d_w[i],l->size*l->size);
         copy_array(l->ex_d_w_diff_grad[i],copy->ex_d_w_diff_grad[i],l->size*l->size);
@@ -1104,7 +1204,7 @@ void paste_lstm(lstm* l,lstm* copy){
         return;
         
     int i;
-    for(i = 0; i < 4; i++){
+    for(i = 0; i < l->n_gates; i++){
         copy_array(l->w[i],copy->w[i],l->size*l->size);
         copy_array(l->d_w[i],copy->d_w[i],l->size*l->size);
         copy_array(l->ex_d_w_diff_grad[i],copy->ex_d_w_diff_grad[i],l->size*l->size);
@@ -1148,7 +1248,7 @@ void paste_w_lstm(lstm* l,lstm* copy){
         return;
         
     int i;
-    for(i = 0; i < 4; i++){
+    for(i = 0; i < l->n_gates; i++){
         copy_array(l->w[i],copy->w[i],l->size*l->size);
         copy_array(l->u[i],copy->u[i],l->size*l->size);
         copy_array(l->biases[i],copy->biases[i],l->size);
@@ -1174,7 +1274,7 @@ void slow_paste_lstm(lstm* l,lstm* copy, float tau){
     if(l == NULL)
         return;
     int i,j;
-    for(i = 0; i < 4; i++){
+    for(i = 0; i < l->n_gates; i++){
         for(j = 0; j < l->size*l->size; j++){
             copy->w[i][j] = tau*l->w[i][j] + (1-tau)*copy->w[i][j];
             copy->d1_w[i][j] = tau*l->d1_w[i][j] + (1-tau)*copy->d1_w[i][j];
@@ -1219,22 +1319,46 @@ void slow_paste_lstm(lstm* l,lstm* copy, float tau){
 lstm* reset_lstm(lstm* f){
     if(f == NULL)
         return NULL;
-    int i,j,k;
-    for(i = 0; i < 4; i++){
+    int i,j;
+    reset_lstm_except_partial_derivatives(f);
+    for(i = 0; i < f->n_gates; i++){
         for(j = 0; j < f->size*f->size; j++){
             f->d_w[i][j] = 0;
             f->d_u[i][j] = 0;
-            if(j < f->size){
+            if(j < f->size)
                 f->d_biases[i][j] = 0;
-                if(!i){
-                    f->dropout_mask_up[j] = 1;
-                    f->dropout_mask_right[j] = 1;
-                }
+        }
+    }
+    
+    if(f->norm_flag == GROUP_NORMALIZATION){
+        for(i = 0; i < f->window/f->n_grouped_cell; i++){
+            for(j = 0; j < f->bns[i]->vector_dim; j++){
+                f->bns[i]->d_gamma[j] = 0;
+                f->bns[i]->d_beta[j] = 0;
             }
         }
     }
+    return f;
+}
+
+/* this function resets all the arrays of a lstm layer like reset_lstm, except for the partial derivatives
+ * d_w, d_u, d_biases and the ones of the group normalization that are left untouched
+ * 
+ * Input:
+ * 
+ *             @ lstm* f:= a lstm* f layer
+ * 
+ * */
+lstm* reset_lstm_except_partial_derivatives(lstm* f){
+    if(f == NULL)
+        return NULL;
+    int i,j,k;
+    for(j = 0; j < f->size; j++){
+        f->dropout_mask_up[j] = 1;
+        f->dropout_mask_right[j] = 1;
+    }
     for(i = 0; i < f->window; i++){
-        for(j = 0; j < 4; j++){
+        for(j = 0; j < f->n_gates; j++){
             for(k = 0; k < f->size; k++){
                 f->lstm_z[i][j][k] = 0;                        
                 f->lstm_hidden[i][k] = 0;
@@ -1246,7 +1370,7 @@ lstm* reset_lstm(lstm* f){
     
     if(f->norm_flag == GROUP_NORMALIZATION){
         for(i = 0; i < f->window/f->n_grouped_cell; i++){
-            reset_bn(f->bns[i]);
+            reset_bn_except_partial_derivatives(f->bns[i]);
         }
     }
     return f;
@@ -1269,7 +1393,7 @@ int get_array_size_params_lstm(lstm* f){
             sum+=f->bns[i]->vector_dim*2;
         }
     }
-    return sum+12*f->size*f->size+6*f->size;
+    return sum+3*f->n_gates*f->size*f->size+(3*f->n_gates/2)*f->size;
 }
 
 /* this function paste the weights and biases in a single vector
@@ -1282,22 +1406,22 @@ int get_array_size_params_lstm(lstm* f){
  * */
 void memcopy_vector_to_params_lstm(lstm* f, float* vector){
     int i;
-    for(i = 0; i < 4; i++){
+    for(i = 0; i < f->n_gates; i++){
         memcpy(f->w[i],&vector[(i*2)*f->size*f->size],f->size*f->size*sizeof(float));    
         memcpy(f->u[i],&vector[(i*2+1)*f->size*f->size],f->size*f->size*sizeof(float));    
     }
     
-    for(i = 0; i < 4; i++){
-        memcpy(f->biases[i],&vector[8*f->size*f->size+(i)*f->size],f->size*sizeof(float));        
+    for(i = 0; i < f->n_gates; i++){
+        memcpy(f->biases[i],&vector[2*f->n_gates*f->size*f->size+(i)*f->size],f->size*sizeof(float));        
     }
     
     if(f->norm_flag == GROUP_NORMALIZATION){
         for(i = 0; i < f->window/f->n_grouped_cell; i++){
-            memcpy(f->bns[i]->gamma,&vector[8*f->size*f->size+4*f->size+i*f->bns[i]->vector_dim],f->bns[i]->vector_dim*sizeof(float));
+            memcpy(f->bns[i]->gamma,&vector[2*f->n_gates*f->size*f->size+f->n_gates*f->size+i*f->bns[i]->vector_dim],f->bns[i]->vector_dim*sizeof(float));
         }
         
         for(i = 0; i < f->window/f->n_grouped_cell; i++){
-            memcpy(f->bns[i]->beta,&vector[8*f->size*f->size+4*f->size+(f->window/f->n_grouped_cell+i)*f->bns[i]->vector_dim],f->bns[i]->vector_dim*sizeof(float));
+            memcpy(f->bns[i]->beta,&vector[2*f->n_gates*f->size*f->size+f->n_gates*f->size+(f->window/f->n_grouped_cell+i)*f->bns[i]->vector_dim],f->bns[i]->vector_dim*sizeof(float));
         }
     }
 }
@@ -1313,22 +1437,22 @@ void memcopy_vector_to_params_lstm(lstm* f, float* vector){
  * */
 void memcopy_params_to_vector_lstm(lstm* f, float* vector){
     int i;
-    for(i = 0; i < 4; i++){
+    for(i = 0; i < f->n_gates; i++){
         memcpy(&vector[(i*2)*f->size*f->size],f->w[i],f->size*f->size*sizeof(float));    
         memcpy(&vector[(i*2+1)*f->size*f->size],f->u[i],f->size*f->size*sizeof(float));    
     }
     
-    for(i = 0; i < 4; i++){
-        memcpy(&vector[8*f->size*f->size+(i)*f->size],f->biases[i],f->size*sizeof(float));        
+    for(i = 0; i < f->n_gates; i++){
+        memcpy(&vector[2*f->n_gates*f->size*f->size+(i)*f->size],f->biases[i],f->size*sizeof(float));        
     }
     
     if(f->norm_flag == GROUP_NORMALIZATION){
         for(i = 0; i < f->window/f->n_grouped_cell; i++){
-            memcpy(&vector[8*f->size*f->size+4*f->size+i*f->bns[i]->vector_dim],f->bns[i]->gamma,f->bns[i]->vector_dim*sizeof(float));
+            memcpy(&vector[2*f->n_gates*f->size*f->size+f->n_gates*f->size+i*f->bns[i]->vector_dim],f->bns[i]->gamma,f->bns[i]->vector_dim*sizeof(float));
         }
         
         for(i = 0; i < f->window/f->n_grouped_cell; i++){
-            memcpy(&vector[8*f->size*f->size+4*f->size+(f->window/f->n_grouped_cell+i)*f->bns[i]->vector_dim],f->bns[i]->beta,f->bns[i]->vector_dim*sizeof(float));
+            memcpy(&vector[2*f->n_gates*f->size*f->size+f->n_gates*f->size+(f->window/f->n_grouped_cell+i)*f->bns[i]->vector_dim],f->bns[i]->beta,f->bns[i]->vector_dim*sizeof(float));
         }
     }
 }
@@ -1343,22 +1467,22 @@ void memcopy_params_to_vector_lstm(lstm* f, float* vector){
  * */
 void memcopy_vector_to_derivative_params_lstm(lstm* f, float* vector){
     int i;
-    for(i = 0; i < 4; i++){
+    for(i = 0; i < f->n_gates; i++){
         memcpy(f->d_w[i],&vector[(i*2)*f->size*f->size],f->size*f->size*sizeof(float));    
         memcpy(f->d_u[i],&vector[(i*2+1)*f->size*f->size],f->size*f->size*sizeof(float));    
     }
     
-    for(i = 0; i < 4; i++){
-        memcpy(f->d_biases[i],&vector[8*f->size*f->size+(i)*f->size],f->size*sizeof(float));        
+    for(i = 0; i < f->n_gates; i++){
+        memcpy(f->d_biases[i],&vector[2*f->n_gates*f->size*f->size+(i)*f->size],f->size*sizeof(float));        
     }
     
     if(f->norm_flag == GROUP_NORMALIZATION){
         for(i = 0; i < f->window/f->n_grouped_cell; i++){
-            memcpy(f->bns[i]->d_gamma,&vector[8*f->size*f->size+4*f->size+i*f->bns[i]->vector_dim],f->bns[i]->vector_dim*sizeof(float));
+            memcpy(f->bns[i]->d_gamma,&vector[2*f->n_gates*f->size*f->size+f->n_gates*f->size+i*f->bns[i]->vector_dim],f->bns[i]->vector_dim*sizeof(float));
         }
         
         for(i = 0; i < f->window/f->n_grouped_cell; i++){
-            memcpy(f->bns[i]->d_beta,&vector[8*f->size*f->size+4*f->size+(f->window/f->n_grouped_cell+i)*f->bns[i]->vector_dim],f->bns[i]->vector_dim*sizeof(float));
+            memcpy(f->bns[i]->d_beta,&vector[2*f->n_gates*f->size*f->size+f->n_gates*f->size+(f->window/f->n_grouped_cell+i)*f->bns[i]->vector_dim],f->bns[i]->vector_dim*sizeof(float));
         }
     }
 }
@@ -1374,22 +1498,156 @@ void memcopy_vector_to_derivative_params_lstm(lstm* f, float* vector){
  * */
 void memcopy_derivative_params_to_vector_lstm(lstm* f, float* vector){
     int i;
-    for(i = 0; i < 4; i++){
+    for(i = 0; i < f->n_gates; i++){
         memcpy(&vector[(i*2)*f->size*f->size],f->d_w[i],f->size*f->size*sizeof(float));    
         memcpy(&vector[(i*2+1)*f->size*f->size],f->d_u[i],f->size*f->size*sizeof(float));    
     }
     
-    for(i = 0; i < 4; i++){
-        memcpy(&vector[8*f->size*f->size+(i)*f->size],f->d_biases[i],f->size*sizeof(float));        
+    for(i = 0; i < f->n_gates; i++){
+        memcpy(&vector[2*f->n_gates*f->size*f->size+(i)*f->size],f->d_biases[i],f->size*sizeof(float));        
     }
     
     if(f->norm_flag == GROUP_NORMALIZATION){
         for(i = 0; i < f->window/f->n_grouped_cell; i++){
-            memcpy(&vector[8*f->size*f->size+4*f->size+i*f->bns[i]->vector_dim],f->bns[i]->d_gamma,f->bns[i]->vector_dim*sizeof(float));
+            memcpy(&vector[2*f->n_gates*f->size*f->size+f->n_gates*f->size+i*f->bns[i]->vector_dim],f->bns[i]->d_gamma,f->bns[i]->vector_dim*sizeof(float));
         }
         
         for(i = 0; i < f->window/f->n_grouped_cell; i++){
-            memcpy(&vector[8*f->size*f->size+4*f->size+(f->window/f->n_grouped_cell+i)*f->bns[i]->vector_dim],f->bns[i]->d_beta,f->bns[i]->vector_dim*sizeof(float));
+            memcpy(&vector[2*f->n_gates*f->size*f->size+f->n_gates*f->size+(f->window/f->n_grouped_cell+i)*f->bns[i]->vector_dim],f->bns[i]->d_beta,f->bns[i]->vector_dim*sizeof(float));
+        }
+    }
+}
+
+/* this function stores the arrays of the partial derivatives of a lstm structure that are summed over a batch
+ * 
+ * Inputs:
+ * 
+ * 
+ *                 @ lstm* f:= the lstm layer
+ *                 @ float** segments:= where the arrays are stored, if NULL the arrays are only counted
+ *                 @ int* sizes:= where the sizes of the arrays are stored
+ * 
+ * Output:
+ *                 @ int:= the number of arrays
+ * */
+int get_partial_derivatives_segments_lstm(lstm* f, float** segments, int* sizes){
+    int i,n = 0;
+    for(i = 0; i < f->n_gates; i++,n+=3){
+        if(segments != NULL){
+            segments[n] = f->d_w[i];
+            sizes[n] = f->size*f->size;
+            segments[n+1] = f->d_u[i];
+            sizes[n+1] = f->size*f->size;
+            segments[n+2] = f->d_biases[i];
+            sizes[n+2] = f->size;
+        }
+    }
+    if(f->norm_flag == GROUP_NORMALIZATION){
+        for(i = 0; i < f->window/f->n_grouped_cell; i++,n+=2){
+            if(segments != NULL){
+                segments[n] = f->bns[i]->d_gamma;
+                sizes[n] = f->bns[i]->vector_dim;
+                segments[n+1] = f->bns[i]->d_beta;
+                sizes[n+1] = f->bns[i]->vector_dim;
+            }
+        }
+    }
+    return n;
+}
+
+/* This function creates a lstm* layer that shares the weights, the biases and the optimizer arrays (d1,d2,d3 and ex_d)
+ * with the layer l. The arrays used during the feed forward, the back propagation and the partial derivatives
+ * are owned by the new layer, so the partial derivatives of the shared layer must be summed to l before updating it.
+ * The returned layer must be deallocated with free_shared_lstm.
+ * 
+ * Input:
+ * 
+ *             @ lstm* l:= the lstm layer that owns the parameters
+ * 
+ * */
+lstm* share_lstm(lstm* l){
+    if(l == NULL)
+        return NULL;
+    int i;
+    
+    lstm* s = recurrent_cell(l->cell_type,l->size,l->dropout_flag_up,l->dropout_threshold_up,l->dropout_flag_right,l->dropout_threshold_right,l->layer, l->window,l->residual_flag,l->norm_flag,l->n_grouped_cell);
+    for(i = 0; i < l->n_gates; i++){
+        free(s->w[i]);
+        free(s->ex_d_w_diff_grad[i]);
+        free(s->d1_w[i]);
+        free(s->d2_w[i]);
+        free(s->d3_w[i]);
+        free(s->u[i]);
+        free(s->ex_d_u_diff_grad[i]);
+        free(s->d1_u[i]);
+        free(s->d2_u[i]);
+        free(s->d3_u[i]);
+        free(s->biases[i]);
+        free(s->ex_d_biases_diff_grad[i]);
+        free(s->d1_biases[i]);
+        free(s->d2_biases[i]);
+        free(s->d3_biases[i]);
+        s->w[i] = l->w[i];
+        s->ex_d_w_diff_grad[i] = l->ex_d_w_diff_grad[i];
+        s->d1_w[i] = l->d1_w[i];
+        s->d2_w[i] = l->d2_w[i];
+        s->d3_w[i] = l->d3_w[i];
+        s->u[i] = l->u[i];
+        s->ex_d_u_diff_grad[i] = l->ex_d_u_diff_grad[i];
+        s->d1_u[i] = l->d1_u[i];
+        s->d2_u[i] = l->d2_u[i];
+        s->d3_u[i] = l->d3_u[i];
+        s->biases[i] = l->biases[i];
+        s->ex_d_biases_diff_grad[i] = l->ex_d_biases_diff_grad[i];
+        s->d1_biases[i] = l->d1_biases[i];
+        s->d2_biases[i] = l->d2_biases[i];
+        s->d3_biases[i] = l->d3_biases[i];
+    }
+    
+    if(l->norm_flag == GROUP_NORMALIZATION){
+        for(i = 0; i < l->window/l->n_grouped_cell; i++){
+            free_batch_normalization(s->bns[i]);
+            s->bns[i] = share_bn(l->bns[i]);
+        }
+    }
+    return s;
+}
+
+/* This function deallocates a lstm* layer created with share_lstm, the shared arrays are not freed
+ * 
+ * Input:
+ * 
+ *             @ lstm* l:= the shared lstm layer
+ * 
+ * */
+void free_shared_lstm(lstm* l){
+    if(l == NULL)
+        return;
+    int i;
+    
+    for(i = 0; i < l->n_gates; i++){
+        l->w[i] = NULL;
+        l->ex_d_w_diff_grad[i] = NULL;
+        l->d1_w[i] = NULL;
+        l->d2_w[i] = NULL;
+        l->d3_w[i] = NULL;
+        l->u[i] = NULL;
+        l->ex_d_u_diff_grad[i] = NULL;
+        l->d1_u[i] = NULL;
+        l->d2_u[i] = NULL;
+        l->d3_u[i] = NULL;
+        l->biases[i] = NULL;
+        l->ex_d_biases_diff_grad[i] = NULL;
+        l->d1_biases[i] = NULL;
+        l->d2_biases[i] = NULL;
+        l->d3_biases[i] = NULL;
+    }
+    
+    if(l->norm_flag == GROUP_NORMALIZATION){
+        for(i = 0; i < l->window/l->n_grouped_cell; i++){
+            free_shared_bn(l->bns[i]);
+            l->bns[i] = NULL;
         }
     }
+    free_recurrent_lstm(l);
 }
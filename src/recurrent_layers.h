@@ -26,6 +26,8 @@ SOFTWARE.
 #define __RECURRENT_LAYERS_H__
 
 lstm* recurrent_lstm(int size, int dropout_flag1, float dropout_threshold1, int dropout_flag2, float dropout_threshold2, int layer, int window, int residual_flag, int norm_flag, int n_grouped_cell);
+lstm* recurrent_gru(int size, int dropout_flag1, float dropout_threshold1, int dropout_flag2, float dropout_threshold2, int layer, int window, int residual_flag, int norm_flag, int n_grouped_cell);
+lstm* recurrent_cell(int cell_type, int size, int dropout_flag1, float dropout_threshold1, int dropout_flag2, float dropout_threshold2, int layer, int window, int residual_flag, int norm_flag, int n_grouped_cell);
 void free_recurrent_lstm(lstm* rlstm);
 void save_lstm(lstm* rlstm, int n);
 lstm* load_lstm(FILE* fr);
@@ -33,13 +35,17 @@ lstm* copy_lstm(lstm* l);
 void paste_lstm(lstm* l,lstm* copy);
 void slow_paste_lstm(lstm* l,lstm* copy, float tau);
 lstm* reset_lstm(lstm* f);
+lstm* reset_lstm_except_partial_derivatives(lstm* f);
 int get_array_size_params_lstm(lstm* f);
 void memcopy_vector_to_params_lstm(lstm* f, float* vector);
 void memcopy_params_to_vector_lstm(lstm* f, float* vector);
 void memcopy_vector_to_derivative_params_lstm(lstm* f, float* vector);
 void memcopy_derivative_params_to_vector_lstm(lstm* f, float* vector);
+int get_partial_derivatives_segments_lstm(lstm* f, float** segments, int* sizes);
 void paste_w_lstm(lstm* l,lstm* copy);
 void heavy_save_lstm(lstm* rlstm, int n);
 lstm* heavy_load_lstm(FILE* fr);
+lstm* share_lstm(lstm* l);
+void free_shared_lstm(lstm* l);
 
 #endif
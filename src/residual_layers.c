@@ -389,6 +389,28 @@ rl* reset_rl(rl* f){
     return f;
 }
 
+/* this function resets all the arrays of a residual layer like reset_rl,
+ * except for the partial derivatives of its convolutional layers that are left untouched
+ * 
+ * Input:
+ * 
+ *             @ rl* f:= a rl* f layer
+ * 
+ * */
+rl* reset_rl_except_partial_derivatives(rl* f){
+    if(f == NULL)
+        return NULL;
+    
+    int i;
+    for(i = 0; i < f->n_cl; i++){
+        reset_cl_except_partial_derivatives(f->cls[i]);
+    }
+    
+    reset_cl_except_partial_derivatives(f->cl_output);
+
+    return f;
+}
+
 
 /* this function compute the space allocated by the arrays of f
  * 
@@ -559,6 +581,30 @@ void memcopy_derivative_params_to_vector_rl(rl* f, float* vector){
     }
 }
 
+/* this function stores the arrays of the partial derivatives of the convolutional layers of a rl structure
+ * that are summed over a batch
+ * 
+ * Inputs:
+ * 
+ * 
+ *                 @ rl* f:= the residual layer
+ *                 @ float** segments:= where the arrays are stored, if NULL the arrays are only counted
+ *                 @ int* sizes:= where the sizes of the arrays are stored
+ * 
+ * Output:
+ *                 @ int:= the number of arrays
+ * */
+int get_partial_derivatives_segments_rl(rl* f, float** segments, int* sizes){
+    int n = 0,i;
+    for(i = 0; i < f->n_cl; i++){
+        if(segments != NULL)
+            n += get_partial_derivatives_segments_cl(f->cls[i],&segments[n],&sizes[n]);
+        else
+            n += get_partial_derivatives_segments_cl(f->cls[i],NULL,NULL);
+    }
+    return n;
+}
+
 /* setting the biases of convolutional layers inside residual ones to 0
  * 
  * Input:
@@ -707,3 +753,46 @@ void reinitialize_scores_rl(rl* f, float percentage, float goodness){
         reinitialize_scores_cl(f->cls[i],percentage,goodness);
     }
 }
+
+/* This function returns a rl* layer whose convolutional layers share the parameters
+ * with the convolutional layers of f (see share_cl). The returned layer must be deallocated with free_shared_rl
+ * 
+ * Input:
+ * 
+ *             @ rl* f:= the residual layer that owns the parameters
+ * 
+ * */
+rl* share_rl(rl* f){
+    if(f == NULL)
+        return NULL;
+    
+    int i;
+    cl** cls = (cl**)malloc(sizeof(cl*)*f->n_cl);
+    for(i = 0; i < f->n_cl; i++){
+        cls[i] = share_cl(f->cls[i]);
+    }
+    
+    rl* s = residual(f->channels, f->input_rows, f->input_cols, f->n_cl, cls);
+    s->cl_output->activation_flag = f->cl_output->activation_flag;
+    return s;
+}
+
+/* This function deallocates a rl* layer created with share_rl, the shared arrays are not freed
+ * 
+ * Input:
+ * 
+ *             @ rl* r:= the shared residual layer
+ * 
+ * */
+void free_shared_rl(rl* r){
+    if(r == NULL)
+        return;
+    int i;
+    for(i = 0; i < r->n_cl; i++){
+        free_shared_cl(r->cls[i]);
+    }
+    
+    free(r->cls);
+    free_convolutional(r->cl_output);
+    free(r);
+}
@@ -34,6 +34,7 @@ rl* heavy_load_rl(FILE* fr);
 rl* copy_rl(rl* f);
 void paste_rl(rl* f, rl* copy);
 rl* reset_rl(rl* f);
+rl* reset_rl_except_partial_derivatives(rl* f);
 unsigned long long int size_of_rls(rl* f);
 void slow_paste_rl(rl* f, rl* copy,float tau);
 int get_array_size_params_rl(rl* f);
@@ -41,6 +42,7 @@ void memcopy_vector_to_params_rl(rl* f, float* vector);
 void memcopy_params_to_vector_rl(rl* f, float* vector);
 void memcopy_vector_to_derivative_params_rl(rl* f, float* vector);
 void memcopy_derivative_params_to_vector_rl(rl* f, float* vector);
+int get_partial_derivatives_segments_rl(rl* f, float** segments, int* sizes);
 void set_residual_biases_to_zero(rl* r);
 int rl_adjusting_weights_after_edge_popup(rl* c, int* used_input, int* used_output);
 int* get_used_kernels_rl(rl* c, int* used_input);
@@ -50,5 +52,7 @@ void sum_score_rl(rl* input1, rl* input2, rl* output);
 void dividing_score_rl(rl* f, float value);
 void reset_score_rl(rl* f);
 void reinitialize_scores_rl(rl* f, float percentage, float goodness);
+rl* share_rl(rl* f);
+void free_shared_rl(rl* r);
 
 #endif
@@ -0,0 +1,333 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+#include "llab.h"
+
+/* Ring all-reduce for the data parallel training between processes (or machines):
+ * the n workers are connected in a ring, each worker sends to the next one and receives from the previous one.
+ * The vector is split in n chunks: in the n-1 steps of the reduce-scatter each worker sends a chunk and sums the chunk received
+ * in its own vector, then each worker has a chunk summed over all the workers, that is passed around the ring in the n-1 steps
+ * of the all-gather. Each worker sends and receives 2*(n-1)/n times the vector, regardless of the number of workers,
+ * instead of the n vectors received and sent by the server of server.c.
+ * In each step the chunk is sent in segments of RING_SEGMENT floats while the previous segments are received and summed,
+ * and ring_all_reduce_start runs the all-reduce in a thread so the worker can compute meanwhile.
+ * The sums of a chunk are always done in the same order, so all the workers get the same vector.
+ * */
+
+/* This function creates a socket listening on a port of all the addresses of this machine,
+ * the connections not accepted yet are queued (a full queue would delay the next connect by the syn timeout)
+ * 
+ * Input:
+ *             @ int port:= the port
+ * 
+ * Output:
+ *             @ int:= the socket
+ * */
+int ring_listen(int port){
+    int c = 1;
+    struct sockaddr_in addr;
+    int fd = socket(AF_INET,SOCK_STREAM,0);
+    if(fd == -1){
+        fprintf(stderr,"Error: can't create socket\n");
+        exit(1);
+    }
+    if(setsockopt(fd,SOL_SOCKET,SO_REUSEADDR,&c,sizeof(int)) == -1){
+        fprintf(stderr,"Error: setsockopt failed\n");
+        exit(1);
+    }
+    memset(&addr,0,sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(port);
+    if(bind(fd,(struct sockaddr*)&addr,sizeof(addr)) == -1){
+        fprintf(stderr,"Error: bind on port %d failed\n",port);
+        exit(1);
+    }
+    if(listen(fd,SOMAXCONN) == -1){
+        fprintf(stderr,"Error: listen failed\n");
+        exit(1);
+    }
+    return fd;
+}
+
+/* This function connects to a worker, trying again every RING_CONNECTION_DELAY microseconds
+ * until it is listening, for at most RING_CONNECTION_ATTEMPTS attempts
+ * 
+ * Input:
+ *             @ char* address:= the ip address of the worker
+ *             @ int port:= the port of the worker
+ * 
+ * Output:
+ *             @ int:= the socket
+ * */
+int ring_connect(char* address, int port){
+    int i,fd;
+    struct sockaddr_in addr;
+    memset(&addr,0,sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr(address);
+    addr.sin_port = htons(port);
+    for(i = 0; i < RING_CONNECTION_ATTEMPTS; i++){
+        fd = socket(AF_INET,SOCK_STREAM,0);
+        if(fd == -1){
+            fprintf(stderr,"Error: can't create socket\n");
+            exit(1);
+        }
+        if(connect(fd,(struct sockaddr*)&addr,sizeof(addr)) == 0)
+            return fd;
+        close(fd);
+        usleep(RING_CONNECTION_DELAY);
+    }
+    fprintf(stderr,"Error: can't connect to %s:%d\n",address,port);
+    exit(1);
+}
+
+/* This function creates a worker of a ring all-reduce: it listens on its port, connects to the next worker
+ * and accepts the connection of the previous one. All the workers must call it with the same addresses and ports
+ * 
+ * Input:
+ *             @ int rank:= the position of this worker in the ring, 0 <= rank < n_workers
+ *             @ int n_workers:= the number of workers
+ *             @ char** addresses:= the ip addresses of the workers, dimensions: n_workers
+ *             @ int* ports:= the ports of the workers, dimensions: n_workers
+ * 
+ * Output:
+ *             @ ring*:= the worker
+ * */
+ring* create_ring(int rank, int n_workers, char** addresses, int* ports){
+    if(n_workers < 1 || rank < 0 || rank >= n_workers){
+        fprintf(stderr,"Error: the rank must be >= 0 and < n_workers\n");
+        exit(1);
+    }
+    int previous_rank = -1, next = (rank+1)%n_workers;
+    ring* r = (ring*)calloc(1,sizeof(ring));
+    r->rank = rank;
+    r->n_workers = n_workers;
+    r->listen_socket = -1;
+    r->next_socket = -1;
+    r->previous_socket = -1;
+    if(n_workers == 1)
+        return r;
+    
+    r->segment = (float*)malloc(sizeof(float)*RING_SEGMENT);
+    r->listen_socket = ring_listen(ports[rank]);
+    r->next_socket = ring_connect(addresses[next],ports[next]);
+    if(write_all(r->next_socket,&rank,sizeof(int)) == -1){
+        fprintf(stderr,"Error: can't send the rank to the next worker\n");
+        exit(1);
+    }
+    do{
+        r->previous_socket = accept(r->listen_socket,NULL,NULL);
+    }while(r->previous_socket == -1 && errno == EINTR);
+    if(r->previous_socket == -1 || read_all(r->previous_socket,&previous_rank,sizeof(int)) == -1 || previous_rank != (rank-1+n_workers)%n_workers){
+        fprintf(stderr,"Error: the worker %d didn't get the connection of the worker %d\n",rank,(rank-1+n_workers)%n_workers);
+        exit(1);
+    }
+    set_socket_options(r->next_socket);
+    set_socket_options(r->previous_socket);
+    return r;
+}
+
+/* This function frees a worker and closes its connections,
+ * an all-reduce started with ring_all_reduce_start must be waited before
+ * 
+ * Input:
+ *             @ ring* r:= the worker
+ * */
+void free_ring(ring* r){
+    if(r == NULL)
+        return;
+    if(r->next_socket != -1)
+        close(r->next_socket);
+    if(r->previous_socket != -1)
+        close(r->previous_socket);
+    if(r->listen_socket != -1)
+        close(r->listen_socket);
+    free(r->segment);
+    free(r);
+}
+
+/* This function returns the first float of a chunk of a vector split among the workers
+ * 
+ * Input:
+ *             @ int size:= the floats of the vector
+ *             @ int n_workers:= the number of workers
+ *             @ int chunk:= the chunk, 0 <= chunk <= n_workers
+ * 
+ * Output:
+ *             @ int:= the first float of the chunk, size if chunk = n_workers
+ * */
+int ring_chunk(int size, int n_workers, int chunk){
+    return (int)((long long int)size*chunk/n_workers);
+}
+
+/* This function sends a chunk to the next worker and at the same time receives a chunk from the previous one.
+ * The sockets are polled, so neither of them waits for the other: the chunk is sent in segments of RING_SEGMENT floats and,
+ * with reduce_flag, each received segment is summed to receive_vector as soon as it is complete
+ * 
+ * Input:
+ *             @ ring* r:= the worker
+ *             @ float* send_vector:= the chunk sent, dimensions: send_size
+ *             @ int send_size:= the floats sent
+ *             @ float* receive_vector:= the chunk received, dimensions: receive_size
+ *             @ int receive_size:= the floats received
+ *             @ int reduce_flag:= 1 to sum the received floats to receive_vector, 0 to copy them
+ * */
+void ring_exchange(ring* r, float* send_vector, int send_size, float* receive_vector, int receive_size, int reduce_flag){
+    long long int n, sent = 0, received = 0, filled = 0, length = 0, offset = 0;
+    long long int send_bytes = sizeof(float)*(long long int)send_size, receive_bytes = sizeof(float)*(long long int)receive_size;
+    long long int segment_bytes = sizeof(float)*RING_SEGMENT;
+    struct pollfd fds[2];
+    fds[0].fd = r->next_socket;
+    fds[1].fd = r->previous_socket;
+    while(sent < send_bytes || received < receive_bytes){
+        fds[0].events = sent < send_bytes ? POLLOUT : 0;
+        fds[1].events = received < receive_bytes ? POLLIN : 0;
+        fds[0].revents = 0;
+        fds[1].revents = 0;
+        if(poll(fds,2,-1) == -1){
+            if(errno == EINTR)
+                continue;
+            fprintf(stderr,"Error: poll failed in the ring all-reduce\n");
+            exit(1);
+        }
+        
+        if(fds[0].revents & (POLLOUT | POLLERR | POLLHUP)){
+            n = send_bytes-sent < segment_bytes ? send_bytes-sent : segment_bytes;
+            n = send(r->next_socket,(char*)send_vector+sent,n,MSG_DONTWAIT | MSG_NOSIGNAL);
+            if(n == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR){
+                fprintf(stderr,"Error: the worker %d can't send to the next worker\n",r->rank);
+                exit(1);
+            }
+            if(n > 0)
+                sent+=n;
+        }
+        
+        if(fds[1].revents & (POLLIN | POLLERR | POLLHUP)){
+            if(reduce_flag){
+                length = receive_size-offset < RING_SEGMENT ? receive_size-offset : RING_SEGMENT;
+                n = recv(r->previous_socket,(char*)r->segment+filled,sizeof(float)*length-filled,MSG_DONTWAIT);
+            }
+            else
+                n = recv(r->previous_socket,(char*)receive_vector+received,receive_bytes-received,MSG_DONTWAIT);
+            if(n == 0 || (n == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)){
+                fprintf(stderr,"Error: the worker %d lost the connection with the previous worker\n",r->rank);
+                exit(1);
+            }
+            if(n > 0){
+                received+=n;
+                filled+=n;
+                if(reduce_flag && filled == (long long int)sizeof(float)*length){
+                    sum1D(r->segment,&receive_vector[offset],&receive_vector[offset],length);
+                    offset+=length;
+                    filled = 0;
+                }
+            }
+        }
+    }
+}
+
+/* This function sums a vector over all the workers of the ring, all the workers must call it
+ * with a vector of the same size. At the end each worker has the sum in vector
+ * 
+ * Input:
+ *             @ ring* r:= the worker
+ *             @ float* vector:= the vector, dimensions: size
+ *             @ int size:= the floats of the vector
+ * */
+void ring_all_reduce(ring* r, float* vector, int size){
+    int i, send, receive, n = r->n_workers;
+    // reduce-scatter: after the step i the chunk rank-i-1 has the sum of i+2 workers
+    for(i = 0; i < n-1; i++){
+        send = (r->rank-i+n)%n;
+        receive = (r->rank-i-1+n)%n;
+        ring_exchange(r,&vector[ring_chunk(size,n,send)],ring_chunk(size,n,send+1)-ring_chunk(size,n,send),&vector[ring_chunk(size,n,receive)],ring_chunk(size,n,receive+1)-ring_chunk(size,n,receive),1);
+    }
+    // all-gather: the chunk rank+1 has the sum of all the workers
+    for(i = 0; i < n-1; i++){
+        send = (r->rank-i+1+n)%n;
+        receive = (r->rank-i+n)%n;
+        ring_exchange(r,&vector[ring_chunk(size,n,send)],ring_chunk(size,n,send+1)-ring_chunk(size,n,send),&vector[ring_chunk(size,n,receive)],ring_chunk(size,n,receive+1)-ring_chunk(size,n,receive),0);
+    }
+}
+
+/* This function runs the all-reduce started by ring_all_reduce_start
+ * 
+ * Input:
+ *             @ void* _args:= the ring* worker
+ * */
+void* ring_all_reduce_thread(void* _args){
+    ring* r = (ring*)_args;
+    ring_all_reduce(r,r->vector,r->size);
+    return NULL;
+}
+
+/* This function starts ring_all_reduce in a thread and returns, the vector must not be used until ring_all_reduce_wait
+ * 
+ * Input:
+ *             @ ring* r:= the worker
+ *             @ float* vector:= the vector, dimensions: size
+ *             @ int size:= the floats of the vector
+ * */
+void ring_all_reduce_start(ring* r, float* vector, int size){
+    if(r->vector != NULL){
+        fprintf(stderr,"Error: an all-reduce of this worker is already running\n");
+        exit(1);
+    }
+    r->vector = vector;
+    r->size = size;
+    if(pthread_create(&r->thread,NULL,ring_all_reduce_thread,r)){
+        fprintf(stderr,"Error: can't create the thread of the all-reduce\n");
+        exit(1);
+    }
+}
+
+/* This function waits the all-reduce started by ring_all_reduce_start
+ * 
+ * Input:
+ *             @ ring* r:= the worker
+ * */
+void ring_all_reduce_wait(ring* r){
+    if(r->vector == NULL)
+        return;
+    pthread_join(r->thread,NULL);
+    r->vector = NULL;
+    r->size = 0;
+}
+
+/* This function sums the partial derivatives of a model over all the workers of the ring,
+ * after it each worker can call update_model and all the models stay equal
+ * 
+ * Input:
+ *             @ ring* r:= the worker
+ *             @ model* m:= the model
+ *             @ float* vector:= a vector for the partial derivatives, dimensions: get_array_size_params_model(m)
+ * */
+void ring_all_reduce_model(ring* r, model* m, float* vector){
+    memcopy_derivative_params_to_vector_model(m,vector);
+    ring_all_reduce(r,vector,get_array_size_params_model(m));
+    memcopy_vector_to_derivative_params_model(m,vector);
+}
@@ -0,0 +1,42 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+#ifndef __RING_ALL_REDUCE_H__
+#define __RING_ALL_REDUCE_H__
+
+int ring_listen(int port);
+int ring_connect(char* address, int port);
+ring* create_ring(int rank, int n_workers, char** addresses, int* ports);
+void free_ring(ring* r);
+int ring_chunk(int size, int n_workers, int chunk);
+void ring_exchange(ring* r, float* send_vector, int send_size, float* receive_vector, int receive_size, int reduce_flag);
+void ring_all_reduce(ring* r, float* vector, int size);
+void* ring_all_reduce_thread(void* _args);
+void ring_all_reduce_start(ring* r, float* vector, int size);
+void ring_all_reduce_wait(ring* r);
+void ring_all_reduce_model(ring* r, model* m, float* vector);
+
+#endif
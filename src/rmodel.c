@@ -102,6 +102,14 @@ rmodel* recurrent_network(int layers, int n_lstm, lstm** lstms, int window, int
     m->beta1_adam = BETA1_ADAM;
     m->beta2_adam = BETA2_ADAM;
     m->beta3_adamod = BETA3_ADAMOD;
+    m->arena = NULL;
+    m->shared_params_flag = 0;
+    m->error_window = (float**)malloc(sizeof(float*)*window);
+    m->error_window2 = (float**)malloc(sizeof(float*)*window);
+    for(i = 0; i < window; i++){
+        m->error_window[i] = (float*)calloc(lstms[0]->size,sizeof(float));
+        m->error_window2[i] = (float*)calloc(lstms[0]->size,sizeof(float));
+    }
         
     return m;
 }
@@ -115,8 +123,13 @@ rmodel* recurrent_network(int layers, int n_lstm, lstm** lstms, int window, int
 void free_rmodel(rmodel* m){
     if(m == NULL)
         return;
+    if(m->shared_params_flag){
+        free_shared_rmodel(m);
+        return;
+    }
     int i;
     
+    free_rmodel_arena(m);
     for(i = 0; i < m->n_lstm; i++){
         free_recurrent_lstm(m->lstms[i]);
     }
@@ -124,6 +137,8 @@ void free_rmodel(rmodel* m){
     for(i = 0; i < m->layers; i++){
         free(m->sla[i]);
     }
+    free_matrix(m->error_window,m->window);
+    free_matrix(m->error_window2,m->window);
     free(m->sla);
     free(m);
 }
@@ -154,6 +169,78 @@ rmodel* copy_rmodel(rmodel* m){
     return copy;
 }
 
+/* This function creates a replica of m that shares the weights, the biases and the optimizer arrays with m,
+ * see share_model. If m must be contiguous it must be made contiguous before creating its replicas.
+ * The replica must not be updated and can be deallocated with free_rmodel or free_shared_rmodel
+ * 
+ * Input:
+ *         
+ *             @ rmodel* m:= the rmodel that owns the params
+ * 
+ * */
+rmodel* share_rmodel(rmodel* m){
+    if(m == NULL)
+        return NULL;
+    int i;
+    
+    lstm** lstms = NULL;
+    if(m->lstms!=NULL)
+        lstms = (lstm**)malloc(sizeof(lstm*)*m->n_lstm);
+    for(i = 0; i < m->n_lstm; i++){
+        lstms[i] = share_lstm(m->lstms[i]);
+    }
+    rmodel* s = recurrent_network(m->layers, m->n_lstm,lstms, m->window, m->hidden_state_mode);
+    s->beta1_adam = m->beta1_adam;
+    s->beta2_adam = m->beta2_adam;
+    s->beta3_adamod = m->beta3_adamod;
+    s->shared_params_flag = 1;
+    return s;
+}
+
+/* This function frees the space allocated by a rmodel created with share_rmodel, the shared arrays are not freed
+ * 
+ * Input:
+ *         
+ *             @ rmodel* m:= the shared rmodel
+ * 
+ * */
+void free_shared_rmodel(rmodel* m){
+    if(m == NULL)
+        return;
+    int i;
+    
+    for(i = 0; i < m->n_lstm; i++){
+        free_shared_lstm(m->lstms[i]);
+    }
+    free(m->lstms);
+    for(i = 0; i < m->layers; i++){
+        free(m->sla[i]);
+    }
+    free_matrix(m->error_window,m->window);
+    free_matrix(m->error_window2,m->window);
+    free(m->sla);
+    free(m);
+}
+
+/* This function returns 1 if s has been created with share_rmodel(m), 0 otherwise
+ * 
+ * Input:
+ *         
+ *             @ rmodel* m:= the rmodel that could own the params
+ *             @ rmodel* s:= the rmodel that could share the params of m
+ * 
+ * */
+int rmodel_shares_params(rmodel* m, rmodel* s){
+    if(m == NULL || s == NULL || !s->shared_params_flag || m->n_lstm != s->n_lstm)
+        return 0;
+    int i;
+    for(i = 0; i < m->n_lstm; i++){
+        if(m->lstms[i]->w[0] != s->lstms[i]->w[0])
+            return 0;
+    }
+    return 1;
+}
+
 /* This function copies a rmodel using the paste function for the layers
  * see recurrent_layers.c file
  * 
@@ -166,6 +253,12 @@ rmodel* copy_rmodel(rmodel* m){
 void paste_rmodel(rmodel* m, rmodel* copy){
     if(m == NULL)
         return;
+    if(rmodel_shares_params(m,copy))
+        return;
+    if(rmodel_state_lives_in_arena(m) && same_params_arena(m->arena,copy->arena)){
+        paste_params_arena(m->arena,copy->arena);
+        return;
+    }
     int i;
     
     for(i = 0; i < m->n_lstm; i++){
@@ -219,6 +312,10 @@ void slow_paste_rmodel(rmodel* m, rmodel* copy, float tau){
 rmodel* reset_rmodel(rmodel* m){
     if(m == NULL)
         return NULL;
+    if(m->arena != NULL){
+        reset_params_arena_partial_derivatives(m->arena);
+        return reset_rmodel_except_partial_derivatives(m);
+    }
     int i;
     for(i = 0; i < m->n_lstm; i++){
         reset_lstm(m->lstms[i]);
@@ -226,6 +323,43 @@ rmodel* reset_rmodel(rmodel* m){
     return m;
 }
 
+/* This function resets a rmodel like reset_rmodel, except for the partial derivatives of the lstm layers
+ * that are left untouched (for example sum_rmodels_partial_derivatives_multicore zeroes them)
+ * */
+rmodel* reset_rmodel_except_partial_derivatives(rmodel* m){
+    if(m == NULL)
+        return NULL;
+    int i;
+    for(i = 0; i < m->n_lstm; i++){
+        reset_lstm_except_partial_derivatives(m->lstms[i]);
+    }
+    return m;
+}
+
+/* this function stores the arrays of the partial derivatives of a rmodel that are summed over a batch,
+ * two rmodels with the same structure get their arrays in the same order
+ * 
+ * Inputs:
+ * 
+ * 
+ *                 @ rmodel* m:= the rmodel
+ *                 @ float** segments:= where the arrays are stored, if NULL the arrays are only counted
+ *                 @ int* sizes:= where the sizes of the arrays are stored
+ * 
+ * Output:
+ *                 @ int:= the number of arrays
+ * */
+int get_partial_derivatives_segments_rmodel(rmodel* m, float** segments, int* sizes){
+    int n = 0,i;
+    for(i = 0; i < m->n_lstm; i++){
+        if(segments != NULL)
+            n += get_partial_derivatives_segments_lstm(m->lstms[i],&segments[n],&sizes[n]);
+        else
+            n += get_partial_derivatives_segments_lstm(m->lstms[i],NULL,NULL);
+    }
+    return n;
+}
+
 /* This function saves a rmodel(recurrent network) on a .bin file with name n.bin
  * 
  * Input:
@@ -522,94 +656,53 @@ rmodel* heavy_load_rmodel(char* file){
  * */
 void ff_rmodel_lstm(float** hidden_states, float** cell_states, float** input_model, int window, int size, int layers, lstm** lstms){    
     
-    //allocation of the resources
-
-    float* dropout_output = (float*)malloc(sizeof(float)*lstms[0]->size); //here we store the modified output by dropout coming from an lstm cell
-    float* dropout_output2 = (float*)malloc(sizeof(float)*lstms[0]->size); //here we store the modified output by dropout coming from an lstm cell
-    
     int i,j;
+    float* x;
+    float* c;
     
-    float temp_drp_value;
-    /*feed_forward_passage*/
+    /*feed_forward_passage, layer by layer: the input projections w*x+b of a layer are computed for the whole window
+     * with a single gemm for each gate, only the recurrent part u*h is computed timestep by timestep*/
     
-    for(i = 0; i < window; i++){
-        for(j = 0; j < layers; j++){
+    for(j = 0; j < layers; j++){
+        
+        if(lstms[j]->dropout_flag_right == DROPOUT)
+            set_dropout_mask(lstms[j]->size,lstms[j]->dropout_mask_right,lstms[j]->dropout_threshold_right);
+        if(lstms[j]->dropout_flag_up == DROPOUT)
+            set_dropout_mask(lstms[j]->size,lstms[j]->dropout_mask_up,lstms[j]->dropout_threshold_up);
+        
+        for(i = 0; i < window; i++){
+            x = j == 0 ? input_model[i] : lstms[j-1]->out_up[i]; //j = 0 means that we are at the first lstm_cell in vertical
+            copy_array(x,&lstms[j]->x_window[i*lstms[j]->size],lstms[j]->size);
+        }
+        
+        recurrent_input_projections(lstms[j]->x_window,window,lstms[j]->size,lstms[j]->n_gates,lstms[j]->w,lstms[j]->biases,lstms[j]->zx);
+        
+        for(i = 0; i < window; i++){
             
-            if(j == 0){ //j = 0 means that we are at the first lstm_cell in vertical
-                if(i == 0){//i = 0 means we are at the first lstm in orizontal
-                    //in this case the h-1 and c-1 come from the last mini_batch
-                    
-                    if(lstms[j]->dropout_flag_right == DROPOUT)
-                        set_dropout_mask(lstms[j]->size,lstms[j]->dropout_mask_right,lstms[j]->dropout_threshold_right);
-                   
-                    get_dropout_array(lstms[j]->size,lstms[j]->dropout_mask_right,hidden_states[j],dropout_output2);//dropout for h between recurrent connections
-                    
-                    
-                    if(lstms[j]->dropout_flag_right == DROPOUT_TEST)
-                        mul_value(dropout_output2,lstms[j]->dropout_threshold_right,dropout_output2,lstms[j]->size);
-                    
-                    lstm_ff(input_model[i], dropout_output2, cell_states[j], lstms[j]->lstm_cell[i], lstms[j]->lstm_hidden[i], lstms[j]->w, lstms[j]->u, lstms[j]->biases, lstms[j]->lstm_z[i], lstms[j]->size);
-                }
-
-                else{
-                    
-                    get_dropout_array(lstms[j]->size,lstms[j]->dropout_mask_right,lstms[j]->lstm_hidden[i-1],dropout_output2);//dropout for h between recurrent connections
-                    
-                    if(lstms[j]->dropout_flag_right == DROPOUT_TEST)
-                        mul_value(dropout_output2,lstms[j]->dropout_threshold_right,dropout_output2,lstms[j]->size);
-                        
-                    lstm_ff(input_model[i], dropout_output2, lstms[j]->lstm_cell[i-1], lstms[j]->lstm_cell[i], lstms[j]->lstm_hidden[i], lstms[j]->w, lstms[j]->u, lstms[j]->biases, lstms[j]->lstm_z[i], lstms[j]->size);
-                }
-            }
+            //i = 0 means we are at the first lstm in orizontal, in this case the h-1 and c-1 come from the last mini_batch
+            get_dropout_array(lstms[j]->size,lstms[j]->dropout_mask_right,i == 0 ? hidden_states[j] : lstms[j]->lstm_hidden[i-1],lstms[j]->h_right);//dropout for h between recurrent connections
             
+            if(lstms[j]->dropout_flag_right == DROPOUT_TEST)
+                mul_value(lstms[j]->h_right,lstms[j]->dropout_threshold_right,lstms[j]->h_right,lstms[j]->size);
+            
+            if(lstms[j]->cell_type == GRU_CELL)
+                gru_ff_fused(&lstms[j]->zx[i*GRU_GATES*lstms[j]->size], lstms[j]->h_right, i == 0 ? hidden_states[j] : lstms[j]->lstm_hidden[i-1], lstms[j]->lstm_cell[i], lstms[j]->lstm_hidden[i], lstms[j]->u, lstms[j]->lstm_z[i], lstms[j]->size);
             else{
-                
-                if(i == 0){//i = 0 and j != 0 means that we are at the first lstm in orizontal but not in vertical
-                    if(lstms[j]->dropout_flag_right == DROPOUT)
-                        set_dropout_mask(lstms[j]->size,lstms[j]->dropout_mask_right,lstms[j]->dropout_threshold_right);
-                   
-                    get_dropout_array(lstms[j]->size,lstms[j]->dropout_mask_right,hidden_states[j],dropout_output2);//dropout for h between recurrent connections
-                    
-                    if(lstms[j]->dropout_flag_right == DROPOUT_TEST)
-                        mul_value(dropout_output2,lstms[j]->dropout_threshold_right,dropout_output2,lstms[j]->size);
-                        
-                    lstm_ff(dropout_output, dropout_output2, cell_states[j], lstms[j]->lstm_cell[i], lstms[j]->lstm_hidden[i], lstms[j]->w, lstms[j]->u, lstms[j]->biases, lstms[j]->lstm_z[i], lstms[j]->size);
-                    
-                }    
-                else{
-                    
-                    
-                    get_dropout_array(lstms[j]->size,lstms[j]->dropout_mask_right,lstms[j]->lstm_hidden[i-1],dropout_output2);//dropout for h between recurrent connections
-                    
-                    if(lstms[j]->dropout_flag_right == DROPOUT_TEST)
-                        mul_value(dropout_output2,lstms[j]->dropout_threshold_right,dropout_output2,lstms[j]->size);
-                        
-                    lstm_ff(dropout_output, dropout_output2, cell_states[j], lstms[j]->lstm_cell[i], lstms[j]->lstm_hidden[i], lstms[j]->w, lstms[j]->u, lstms[j]->biases, lstms[j]->lstm_z[i], lstms[j]->size);
-                }
+                c = i == 0 ? cell_states[j] : lstms[j]->lstm_cell[i-1];
+                lstm_ff_fused(&lstms[j]->zx[i*LSTM_GATES*lstms[j]->size], lstms[j]->h_right, c, lstms[j]->lstm_cell[i], lstms[j]->lstm_hidden[i], lstms[j]->u, lstms[j]->lstm_z[i], lstms[j]->size);
             }
             
             /* the dropout is applied to each lstm_hidden to feed the deeper lstm cell in vertical, as input*/
-            if(i == 0)
-                if(lstms[j]->dropout_flag_up == DROPOUT)
-                    set_dropout_mask(lstms[j]->size,lstms[j]->dropout_mask_up,lstms[j]->dropout_threshold_up);
-            
-            get_dropout_array(lstms[j]->size,lstms[j]->dropout_mask_up,lstms[j]->lstm_hidden[i],dropout_output);
+            get_dropout_array(lstms[j]->size,lstms[j]->dropout_mask_up,lstms[j]->lstm_hidden[i],lstms[j]->out_up[i]);
             
             if(lstms[j]->dropout_flag_up == DROPOUT_TEST)
-                mul_value(dropout_output,lstms[j]->dropout_threshold_up,dropout_output,lstms[j]->size);
+                mul_value(lstms[j]->out_up[i],lstms[j]->dropout_threshold_up,lstms[j]->out_up[i],lstms[j]->size);
             
-            if(!j && lstms[j]->residual_flag == LSTM_RESIDUAL)
-                sum1D(dropout_output,input_model[i],dropout_output,lstms[j]->size);
-            else if(j && lstms[j]->residual_flag == LSTM_RESIDUAL)
-                sum1D(dropout_output,lstms[j-1]->out_up[i],dropout_output,lstms[j]->size);
-                
-            copy_array(dropout_output,lstms[j]->out_up[i],lstms[j]->size);
+            if(lstms[j]->residual_flag == LSTM_RESIDUAL)
+                sum1D(lstms[j]->out_up[i],&lstms[j]->x_window[i*lstms[j]->size],lstms[j]->out_up[i],lstms[j]->size);
         }
     }
     
-    free(dropout_output);
-    free(dropout_output2);
-    
 }
 
 
@@ -636,9 +729,10 @@ float*** bp_rmodel_lstm(float** hidden_states, float** cell_states, float** inpu
 
     int i,j, lstm_bp_flag;
     
-    float* dropout_output = (float*)malloc(sizeof(float)*lstms[0]->size); //here we store the modified output by dropout coming from an lstm cell
+    float* dropout_output = (float*)malloc(sizeof(float)*lstms[0]->size); //here we store the input of the lstm cell coming from the layer below (its out_up, with dropout and residual)
     float* dropout_output2 = (float*)malloc(sizeof(float)*lstms[0]->size);
     float* dx; //here we store the modified output by dropout coming from the last lstm cell
+    float* dx2;
     float* dz = (float*)calloc(lstms[0]->size,sizeof(float)); //for residual dx
     float*** matrix = (float***)malloc(sizeof(float**)*layers);
     float** temp;
@@ -673,7 +767,7 @@ float*** bp_rmodel_lstm(float** hidden_states, float** cell_states, float** inpu
             if(j == layers-1){
                 
                 if(j != 0)
-                    get_dropout_array(lstms[j]->size,lstms[j-1]->dropout_mask_up,lstms[j-1]->lstm_hidden[i],dropout_output);
+                    copy_array(lstms[j-1]->out_up[i],dropout_output,lstms[j]->size);
                 get_dropout_array(lstms[j]->size,lstms[j]->dropout_mask_right,lstms[j]->lstm_hidden[i-1],dropout_output2);
                 
                 
@@ -703,7 +797,7 @@ float*** bp_rmodel_lstm(float** hidden_states, float** cell_states, float** inpu
             else if(j != layers-1 && j != 0){
                 
                 
-                get_dropout_array(lstms[j]->size,lstms[j-1]->dropout_mask_up,lstms[j-1]->lstm_hidden[i],dropout_output);
+                copy_array(lstms[j-1]->out_up[i],dropout_output,lstms[j]->size);
                 get_dropout_array(lstms[j]->size,lstms[j]->dropout_mask_right,lstms[j]->lstm_hidden[i-1],dropout_output2);
 
                 
@@ -737,7 +831,18 @@ float*** bp_rmodel_lstm(float** hidden_states, float** cell_states, float** inpu
                 
             }
             
-            copy_array(dx,dz,lstms[0]->size);
+            /* dz is the error of the output of this layer (out_up), the residual connection passes it unchanged to the inputs*/
+            if(lstms[j]->residual_flag == LSTM_RESIDUAL){
+                if(j == layers-1)
+                    copy_array(error_model[i],dz,lstms[0]->size);
+                else{
+                    if(lstms[j+1]->residual_flag != LSTM_RESIDUAL)
+                        memset(dz,0,sizeof(float)*lstms[0]->size);
+                    dx2 = lstm_dinput(i,lstms[j]->size,matrix[j+1],lstms[j+1]);
+                    sum1D(dz,dx2,dz,lstms[0]->size);
+                    free(dx2);
+                }
+            }
             free(dx);
             
             if(!j && input_error != NULL){
@@ -776,7 +881,7 @@ float*** bp_rmodel_lstm(float** hidden_states, float** cell_states, float** inpu
         if(j == layers-1){
             
             if(j != 0)
-                get_dropout_array(lstms[j]->size,lstms[j-1]->dropout_mask_up,lstms[j-1]->lstm_hidden[i],dropout_output);
+                copy_array(lstms[j-1]->out_up[i],dropout_output,lstms[j]->size);
             get_dropout_array(lstms[j]->size,lstms[j]->dropout_mask_right,hidden_states[j],dropout_output2);
             
             if(j != 0)
@@ -792,7 +897,7 @@ float*** bp_rmodel_lstm(float** hidden_states, float** cell_states, float** inpu
         
         else if(j != layers-1 && j != 0){
             
-            get_dropout_array(lstms[j]->size,lstms[j-1]->dropout_mask_up,lstms[j-1]->lstm_hidden[i],dropout_output);
+            copy_array(lstms[j-1]->out_up[i],dropout_output,lstms[j]->size);
             get_dropout_array(lstms[j]->size,lstms[j]->dropout_mask_right,hidden_states[j],dropout_output2);
             
 
@@ -806,13 +911,24 @@ float*** bp_rmodel_lstm(float** hidden_states, float** cell_states, float** inpu
             
             get_dropout_array(lstms[j]->size,lstms[j]->dropout_mask_right,hidden_states[j],dropout_output2);
             
-            temp = lstm_bp(lstm_bp_flag,lstms[j]->size, lstms[j]->d_w,lstms[j]->d_u,lstms[j]->d_biases,lstms[j]->w,lstms[j]->d_u,lstms[j]->lstm_z[i], dx, input_model[i],lstms[j]->lstm_cell[i],dropout_output2,cell_states[j], lstms[j+1]->lstm_z[i], matrix[j+1], lstms[j]->lstm_z[i+1],matrix[j],lstms[j+1]->w,lstms[j]->dropout_mask_up,lstms[j]->dropout_mask_right);
+            temp = lstm_bp(lstm_bp_flag,lstms[j]->size, lstms[j]->d_w,lstms[j]->d_u,lstms[j]->d_biases,lstms[j]->w,lstms[j]->u,lstms[j]->lstm_z[i], dx, input_model[i],lstms[j]->lstm_cell[i],dropout_output2,cell_states[j], lstms[j+1]->lstm_z[i], matrix[j+1], lstms[j]->lstm_z[i+1],matrix[j],lstms[j+1]->w,lstms[j]->dropout_mask_up,lstms[j]->dropout_mask_right);
             if(matrix[j] != NULL)
                 free_matrix(matrix[j],4);
             matrix[j] = temp;
             
         }
-        copy_array(dx,dz,lstms[0]->size);
+        /* dz is the error of the output of this layer (out_up), the residual connection passes it unchanged to the inputs*/
+        if(lstms[j]->residual_flag == LSTM_RESIDUAL){
+            if(j == layers-1)
+                copy_array(error_model[i],dz,lstms[0]->size);
+            else{
+                if(lstms[j+1]->residual_flag != LSTM_RESIDUAL)
+                    memset(dz,0,sizeof(float)*lstms[0]->size);
+                dx2 = lstm_dinput(i,lstms[j]->size,matrix[j+1],lstms[j+1]);
+                sum1D(dz,dx2,dz,lstms[0]->size);
+                free(dx2);
+            }
+        }
         free(dx);
         
         if(!j && input_error != NULL){
@@ -830,6 +946,219 @@ float*** bp_rmodel_lstm(float** hidden_states, float** cell_states, float** inpu
 }
 
 
+/* this function computes the back propagation of an lstm layer through the whole window without allocating anything.
+ * The sequential part is only the recurrence of the hidden and cell states (bp_lstm_timestep): the errors of the 4 pre activated gates
+ * of each timestep are stored in zx and the partial derivatives of w and u are computed at the end with a single gemm
+ * for each gate (bp_lstm_window_weights), the same for the errors of the inputs (the inputs are the ones stored in x_window by the feed forward).
+ * The errors of the first timestep are written in l->dfioc with the same layout of the matrix returned by lstm_bp
+ * (df, di, do, dc), so they can be passed to lstm_dh, while the errors of the hidden state and of the cell state passed
+ * to the first timestep are left in l->bp_temp and &l->bp_temp[size]
+ * 
+ * Inputs:
+ * 
+ *             @ float* hidden_state:= the hidden state passed to the first orizontal cell, dimensions: size
+ *             @ float* cell_state:= the cell state passed to the first orizontal cell, dimensions: size
+ *             @ float** error_model:= the error of the outputs of the layer, dimensions: window*size
+ *             @ lstm* l:= the lstm layer
+ *             @ float** input_error:= where the errors of the inputs are written, dimensions: window*size, can be NULL
+ *             @ float* hidden_state_error:= dL/dh of the hidden state after the last timestep, dimensions: size, can be NULL
+ *             @ float* cell_state_error:= dL/dc of the cell state after the last timestep, dimensions: size, can be NULL
+ * 
+ * */
+void bp_lstm_window(float* hidden_state, float* cell_state, float** error_model, lstm* l, float** input_error, float* hidden_state_error, float* cell_state_error){
+    int i,k,size = l->size, window = l->window, n = LSTM_GATES*size;
+    
+    if(hidden_state_error != NULL)
+        copy_array(hidden_state_error,l->bp_temp,size);
+    else
+        memset(l->bp_temp,0,sizeof(float)*size);
+    if(cell_state_error != NULL)
+        copy_array(cell_state_error,&l->bp_temp[size],size);
+    else
+        memset(&l->bp_temp[size],0,sizeof(float)*size);
+    
+    for(i = window-1; i >= 0; i--){
+        bp_lstm_timestep(hidden_state,cell_state,error_model[i],l,i);
+    }
+    
+    bp_lstm_window_weights(l);
+    
+    if(input_error != NULL){
+        memset(l->h_window,0,sizeof(float)*window*size);
+        for(k = 0; k < LSTM_GATES; k++){
+            sgemm_nn(window,size,size,&l->zx[k*size],n,l->w[k],size,l->h_window,size);
+        }
+        for(i = 0; i < window; i++){
+            copy_array(&l->h_window[i*size],input_error[i],size);
+            if(l->residual_flag == LSTM_RESIDUAL)
+                sum1D(input_error[i],error_model[i],input_error[i],size);
+        }
+    }
+}
+
+/* this function computes the back propagation of the timestep i of an lstm layer without allocating anything:
+ * l->bp_temp and &l->bp_temp[size] hold dL/dh and dL/dc of the states of the timestep i (coming from the timestep i+1)
+ * and are updated with the ones of the states of the timestep i-1. The errors of the 4 pre activated gates are written
+ * in &l->zx[i*4*size], the hidden state passed to the timestep after the dropout in &l->h_window[i*size], so that
+ * bp_lstm_window_weights can compute the partial derivatives of w and u once all the timesteps are done
+ * 
+ * Inputs:
+ * 
+ *             @ float* hidden_state:= the hidden state passed to the first orizontal cell, dimensions: size
+ *             @ float* cell_state:= the cell state passed to the first orizontal cell, dimensions: size
+ *             @ float* error:= the error of the output of the layer at the timestep i, dimensions: size
+ *             @ lstm* l:= the lstm layer
+ *             @ int i:= the timestep
+ * 
+ * */
+void bp_lstm_timestep(float* hidden_state, float* cell_state, float* error, lstm* l, int i){
+    int k,size = l->size, n = LSTM_GATES*size;
+    float f,in,o,g,tc,dc;
+    float* h = i == 0 ? hidden_state : l->lstm_hidden[i-1];
+    float* c = i == 0 ? cell_state : l->lstm_cell[i-1];
+    float* a = &l->zx[i*n];
+    float** z = l->lstm_z[i];
+    float* dh = l->bp_temp;
+    float* dc_plus = &l->bp_temp[size];
+    float* dh_right = &l->bp_temp[2*size];
+    
+    get_dropout_array(size,l->dropout_mask_right,h,&l->h_window[i*size]);
+    if(l->dropout_flag_right == DROPOUT_TEST)
+        mul_value(&l->h_window[i*size],l->dropout_threshold_right,&l->h_window[i*size],size);
+    
+    for(k = 0; k < size; k++){
+        f = sigmoid(z[0][k]);
+        in = sigmoid(z[1][k]);
+        o = sigmoid(z[2][k]);
+        g = tanhh(z[3][k]);
+        tc = tanhh(l->lstm_cell[i][k]);
+        dh[k] += error[k]*l->dropout_mask_up[k];
+        dc = dh[k]*o*(1-tc*tc) + dc_plus[k];
+        a[k] = dc*c[k]*f*(1-f);
+        a[size+k] = dc*g*in*(1-in);
+        a[2*size+k] = dh[k]*tc*o*(1-o);
+        a[3*size+k] = dc*in*(1-g*g);
+        l->d_biases[0][k] += a[k];
+        l->d_biases[1][k] += a[size+k];
+        l->d_biases[2][k] += a[2*size+k];
+        l->d_biases[3][k] += a[3*size+k];
+        if(i == 0){
+            l->dfioc[0][k] = dc*c[k];
+            l->dfioc[1][k] = dc*g;
+            l->dfioc[2][k] = dh[k]*tc;
+            l->dfioc[3][k] = dc;
+        }
+        dc_plus[k] = dc*f;
+    }
+    
+    memset(dh_right,0,sizeof(float)*size);
+    for(k = 0; k < LSTM_GATES; k++){
+        sgemv_t(size,size,l->u[k],size,&a[k*size],dh_right);
+    }
+    if(l->dropout_flag_right == DROPOUT_TEST)
+        mul_value(dh_right,l->dropout_threshold_right,dh_right,size);
+    get_dropout_array(size,l->dropout_mask_right,dh_right,dh);
+}
+
+/* this function sums to the partial derivatives of w and u of an lstm layer the ones of the whole window,
+ * from the errors of the gates and the hidden states written by bp_lstm_timestep and the inputs in x_window
+ * 
+ * Inputs:
+ * 
+ *             @ lstm* l:= the lstm layer
+ * 
+ * */
+void bp_lstm_window_weights(lstm* l){
+    int k,size = l->size, window = l->window, n = LSTM_GATES*size;
+    for(k = 0; k < LSTM_GATES; k++){
+        sgemm_tn(size,size,window,&l->zx[k*size],n,l->x_window,size,l->d_w[k],size);
+        sgemm_tn(size,size,window,&l->zx[k*size],n,l->h_window,size,l->d_u[k],size);
+    }
+}
+
+/* this function computes the back propagation of a gru layer through the whole window without allocating anything,
+ * see bp_lstm_window. The errors of the first timestep are written in l->dfioc: the rows 0,1,2 are the errors
+ * of the pre activated gates z,r,n and the row 3 is the error of the hidden state passed to the first timestep
+ * 
+ * Inputs:
+ * 
+ *             @ float* hidden_state:= the hidden state passed to the first orizontal cell, dimensions: size
+ *             @ float** error_model:= the error of the outputs of the layer, dimensions: window*size
+ *             @ lstm* l:= the gru layer
+ *             @ float** input_error:= where the errors of the inputs are written, dimensions: window*size, can be NULL
+ *             @ float* hidden_state_error:= dL/dh of the hidden state after the last timestep, dimensions: size, can be NULL
+ * 
+ * */
+void bp_gru_window(float* hidden_state, float** error_model, lstm* l, float** input_error, float* hidden_state_error){
+    int i,k,size = l->size, window = l->window, n = GRU_GATES*size;
+    float dz,dn,an;
+    float* h;
+    float* a;
+    float* dh = l->bp_temp;
+    float* dh_right = &l->bp_temp[size];
+    float* un_error = &l->h_window[window*size];// the error of u*h of the candidate gate, after the reset gate
+    
+    if(hidden_state_error != NULL)
+        copy_array(hidden_state_error,dh,size);
+    else
+        memset(dh,0,sizeof(float)*size);
+    for(i = window-1; i >= 0; i--){
+        h = i == 0 ? hidden_state : l->lstm_hidden[i-1];
+        a = &l->zx[i*n];
+        get_dropout_array(size,l->dropout_mask_right,h,&l->h_window[i*size]);
+        if(l->dropout_flag_right == DROPOUT_TEST)
+            mul_value(&l->h_window[i*size],l->dropout_threshold_right,&l->h_window[i*size],size);
+        
+        for(k = 0; k < size; k++){
+            dh[k] += error_model[i][k]*l->dropout_mask_up[k];
+            dz = dh[k]*(h[k]-l->lstm_z[i][2][k]);
+            dn = dh[k]*(1-l->lstm_z[i][0][k]);
+            an = dn*(1-l->lstm_z[i][2][k]*l->lstm_z[i][2][k]);
+            a[k] = dz*l->lstm_z[i][0][k]*(1-l->lstm_z[i][0][k]);
+            a[size+k] = an*l->lstm_cell[i][k]*l->lstm_z[i][1][k]*(1-l->lstm_z[i][1][k]);
+            a[2*size+k] = an;
+            un_error[i*size+k] = an*l->lstm_z[i][1][k];
+            l->d_biases[0][k] += a[k];
+            l->d_biases[1][k] += a[size+k];
+            l->d_biases[2][k] += an;
+            dh[k]*=l->lstm_z[i][0][k];
+        }
+        
+        memset(dh_right,0,sizeof(float)*size);
+        sgemv_t(size,size,l->u[0],size,a,dh_right);
+        sgemv_t(size,size,l->u[1],size,&a[size],dh_right);
+        sgemv_t(size,size,l->u[2],size,&un_error[i*size],dh_right);
+        if(l->dropout_flag_right == DROPOUT_TEST)
+            mul_value(dh_right,l->dropout_threshold_right,dh_right,size);
+        get_dropout_array(size,l->dropout_mask_right,dh_right,dh_right);
+        sum1D(dh,dh_right,dh,size);
+    }
+    
+    for(k = 0; k < GRU_GATES; k++){
+        sgemm_tn(size,size,window,&l->zx[k*size],n,l->x_window,size,l->d_w[k],size);
+    }
+    sgemm_tn(size,size,window,l->zx,n,l->h_window,size,l->d_u[0],size);
+    sgemm_tn(size,size,window,&l->zx[size],n,l->h_window,size,l->d_u[1],size);
+    sgemm_tn(size,size,window,un_error,size,l->h_window,size,l->d_u[2],size);
+    
+    if(input_error != NULL){
+        memset(l->h_window,0,sizeof(float)*window*size);
+        for(k = 0; k < GRU_GATES; k++){
+            sgemm_nn(window,size,size,&l->zx[k*size],n,l->w[k],size,l->h_window,size);
+        }
+        for(i = 0; i < window; i++){
+            copy_array(&l->h_window[i*size],input_error[i],size);
+            if(l->residual_flag == LSTM_RESIDUAL)
+                sum1D(input_error[i],error_model[i],input_error[i],size);
+        }
+    }
+    
+    for(k = 0; k < GRU_GATES; k++){
+        copy_array(&l->zx[k*size],l->dfioc[k],size);
+    }
+    copy_array(dh,l->dfioc[3],size);
+}
+
 /* This function returs the total number of weights in the rmodel m
  * 
  * Input
@@ -839,13 +1168,10 @@ float*** bp_rmodel_lstm(float** hidden_states, float** cell_states, float** inpu
  * */
 int count_weights_rmodel(rmodel* m){
     int i,sum = 0;
-    sum+=m->n_lstm*m->lstms[0]->size*m->lstms[0]->size*8;
-    for(i = 0; i < m->layers; i++){
-        if(m->lstms[i]->norm_flag == GROUP_NORMALIZATION){
-            sum+=(m->lstms[i]->window/m->lstms[i]->n_grouped_cell)*m->lstms[i]->bns[0]->vector_dim;
-        }
+    for(i = 0; i < m->n_lstm; i++){
+        sum+=2*m->lstms[i]->n_gates*m->lstms[i]->size*m->lstms[i]->size;
     }
-    return m->n_lstm*m->lstms[0]->size*m->lstms[0]->size*8;
+    return sum;
 }
 
 
@@ -864,11 +1190,20 @@ int count_weights_rmodel(rmodel* m){
  *                @ int total_number_weights:= the number of total weights of the network (for l2 regularization)
  *                @ float lambda:= a float value for l2 regularization
  *                @ unsigned long long int* t:= the number of time radam has been used
+ * 
+ * If the rmodel has an arena (see make_rmodel_contiguous) the update is done by update_rmodel_multicore with a single sweep,
+ * the params are the same but the l2 regularization is not added to the partial derivatives
  * */
 void update_rmodel(rmodel* m, float lr, float momentum, int mini_batch_size, int gradient_descent_flag, float* b1, float* b2, int regularization, int total_number_weights, float lambda, unsigned long long int* t){
     if(m == NULL)
         return;
     
+    // with the arena the l2 regularization and the optimizer are applied with a single sweep
+    if(fused_update_supported_rmodel(m)){
+        update_rmodel_multicore(m,lr,momentum,mini_batch_size,gradient_descent_flag,b1,b2,regularization,total_number_weights,lambda,t,0,1);
+        return;
+    }
+    
     int i,count = 0,count2 = 0,j,k = 0;
     
     for(i = 0; i < m->layers; i++){
@@ -959,6 +1294,10 @@ void sum_rmodel_partial_derivatives(rmodel* m, rmodel* m2, rmodel* m3){
         fprintf(stderr,"Error: passed NULL pointer as values in sum_model_partial_derivatives\n");
         exit(1);
     }
+    if(same_params_arena(m->arena,m2->arena) && same_params_arena(m->arena,m3->arena)){
+        sum_params_arena_partial_derivatives(m->arena,m2->arena,m3->arena);
+        return;
+    }
     sum_lstm_layers_partial_derivatives(m,m2,m3);
 }
 
@@ -1011,7 +1350,7 @@ float* lstm_dinput(int index, int output, float** returning_error, lstm* lstms){
     dot1D(temp,temp2,temp,output);
     for(k = 0; k < output; k++){
         for(k2 = 0; k2 < output; k2++){
-            temp3[k2] = lstms->w[3][k*output+k2]*temp[k];
+            temp3[k2] += lstms->w[3][k*output+k2]*temp[k];
         }
     }
     
@@ -1024,7 +1363,7 @@ float* lstm_dinput(int index, int output, float** returning_error, lstm* lstms){
     dot1D(returning_error[2],temp2,temp,output);
     for(k = 0; k < output; k++){
         for(k2 = 0; k2 < output; k2++){
-            temp3[k2] = lstms->w[2][k*output+k2]*temp[k];
+            temp3[k2] += lstms->w[2][k*output+k2]*temp[k];
         }
     }
     
@@ -1037,7 +1376,7 @@ float* lstm_dinput(int index, int output, float** returning_error, lstm* lstms){
     dot1D(returning_error[1],temp2,temp,output);
     for(k = 0; k < output; k++){
         for(k2 = 0; k2 < output; k2++){
-            temp3[k2] = lstms->w[1][k*output+k2]*temp[k];
+            temp3[k2] += lstms->w[1][k*output+k2]*temp[k];
         }
     }
     
@@ -1050,7 +1389,7 @@ float* lstm_dinput(int index, int output, float** returning_error, lstm* lstms){
     dot1D(returning_error[0],temp2,temp,output);
     for(k = 0; k < output; k++){
         for(k2 = 0; k2 < output; k2++){
-            temp3[k2] = lstms->w[0][k*output+k2]*temp[k];
+            temp3[k2] += lstms->w[0][k*output+k2]*temp[k];
         }
     }
     
@@ -1095,7 +1434,7 @@ float* lstm_dh(int index, int output, float** returning_error, lstm* lstms){
     dot1D(temp,temp2,temp,output);
     for(k = 0; k < output; k++){
         for(k2 = 0; k2 < output; k2++){
-            temp3[k2] = lstms->u[3][k*output+k2]*temp[k];
+            temp3[k2] += lstms->u[3][k*output+k2]*temp[k];
         }
     }
     
@@ -1108,7 +1447,7 @@ float* lstm_dh(int index, int output, float** returning_error, lstm* lstms){
     dot1D(returning_error[2],temp2,temp,output);
     for(k = 0; k < output; k++){
         for(k2 = 0; k2 < output; k2++){
-            temp3[k2] = lstms->u[2][k*output+k2]*temp[k];
+            temp3[k2] += lstms->u[2][k*output+k2]*temp[k];
         }
     }
     
@@ -1121,7 +1460,7 @@ float* lstm_dh(int index, int output, float** returning_error, lstm* lstms){
     dot1D(returning_error[1],temp2,temp,output);
     for(k = 0; k < output; k++){
         for(k2 = 0; k2 < output; k2++){
-            temp3[k2] = lstms->u[1][k*output+k2]*temp[k];
+            temp3[k2] += lstms->u[1][k*output+k2]*temp[k];
         }
     }
     
@@ -1134,7 +1473,7 @@ float* lstm_dh(int index, int output, float** returning_error, lstm* lstms){
     dot1D(returning_error[0],temp2,temp,output);
     for(k = 0; k < output; k++){
         for(k2 = 0; k2 < output; k2++){
-            temp3[k2] = lstms->u[0][k*output+k2]*temp[k];
+            temp3[k2] += lstms->u[0][k*output+k2]*temp[k];
         }
     }
     
@@ -1213,81 +1552,74 @@ void ff_rmodel(float** hidden_states, float** cell_states, float** input_model,
 float*** bp_rmodel(float** hidden_states, float** cell_states, float** input_model, float** error_model, rmodel* m, float** input_error){
     if(m == NULL)
         return NULL;
-    float*** ret = (float***)malloc(sizeof(float**)*m->layers);//Storing all the returned values of bp of lstms
-    float*** ret2;//to handle the returned values of bp of lstms
-    float** input_error3 = (float**)malloc(sizeof(float*)*m->window);//input error for lstms
-    float** error2_model = (float**)malloc(sizeof(float*)*m->window);//error propagated
-    int i,j,ret_count = m->layers-1,z;
-    float** temp = (float**)malloc(sizeof(float*)*m->window);// inputs of lstms
-    for(i = 0; i < m->window; i++){
-        error2_model[i] = (float*)calloc(m->lstms[0]->size,sizeof(float));
-        copy_array(error_model[i],error2_model[i],m->lstms[0]->size);
-    }
-    int flagg = 0;
-    int k = 0;
-    while(k > -1){
-        int flag = 0;
-        for(k = ret_count; k >= 0; k--){
-            if(m->lstms[k]->norm_flag == GROUP_NORMALIZATION){
-                if(flagg) flagg = 0;
-                else{
-                    flag = 1;
-                    break;
-                }
-            }
+    int i;
+    float*** ret = (float***)malloc(sizeof(float**)*m->layers);
+    if(input_error != NULL){
+        for(i = 0; i < m->window; i++){
+            input_error[i] = (float*)malloc(sizeof(float)*m->lstms[0]->size);
         }
-        if(flag){
-            int n_cells = ret_count-k;
-            flagg = 1;
-            if(n_cells){
-                for(j = 0; j < m->lstms[k]->window/m->lstms[k]->n_grouped_cell; j++){
-                    for(z = 0; z < m->lstms[k]->n_grouped_cell; z++){
-                        temp[j*m->lstms[k]->n_grouped_cell+z] = m->lstms[k]->bns[j]->outputs[z];
-                    }
-                }
-                ret2 = bp_rmodel_lstm(&hidden_states[k+1],&cell_states[k+1],temp,error2_model,m->window,m->lstms[0]->size,n_cells,&m->lstms[k+1],input_error3);
-                for(j = 0; j < m->window; j++){
-                    copy_array(input_error3[j],error2_model[j],m->lstms[0]->size);
-                    free(input_error3[j]);
-                }
-                for(j = ret_count; j > ret_count-n_cells; j--){
-                    ret[j] = ret2[n_cells-1-(ret_count-j)];
-                }
-                free(ret2);
-            }
-            for(j = 0; j < m->lstms[k]->window/m->lstms[k]->n_grouped_cell;j++){
-                batch_normalization_back_prop(m->lstms[k]->n_grouped_cell,&m->lstms[k]->out_up[j*m->lstms[k]->n_grouped_cell],m->lstms[k]->bns[j]->temp_vectors,m->lstms[k]->bns[j]->vector_dim,m->lstms[k]->bns[j]->gamma,m->lstms[k]->bns[j]->beta,m->lstms[k]->bns[j]->mean,m->lstms[k]->bns[j]->var,&error2_model[j*m->lstms[k]->n_grouped_cell],m->lstms[k]->bns[j]->d_gamma,m->lstms[k]->bns[j]->d_beta,m->lstms[k]->bns[j]->error2,m->lstms[k]->bns[j]->temp1,m->lstms[k]->bns[j]->temp2,m->lstms[k]->bns[j]->epsilon);
+    }
+    bp_rmodel_workspace(hidden_states,cell_states,input_model,error_model,m,input_error,NULL,NULL);
+    for(i = 0; i < m->layers; i++){
+        ret[i] = (float**)malloc(sizeof(float*)*4);
+        ret[i][0] = (float*)malloc(sizeof(float)*m->lstms[i]->size);
+        ret[i][1] = (float*)malloc(sizeof(float)*m->lstms[i]->size);
+        ret[i][2] = (float*)malloc(sizeof(float)*m->lstms[i]->size);
+        ret[i][3] = (float*)malloc(sizeof(float)*m->lstms[i]->size);
+        copy_array(m->lstms[i]->dfioc[0],ret[i][0],m->lstms[i]->size);
+        copy_array(m->lstms[i]->dfioc[1],ret[i][1],m->lstms[i]->size);
+        copy_array(m->lstms[i]->dfioc[2],ret[i][2],m->lstms[i]->size);
+        copy_array(m->lstms[i]->dfioc[3],ret[i][3],m->lstms[i]->size);
+    }
+    return ret;
+}
+
+/* This function computes the backpropagation of a rmodel like bp_rmodel, but it doesn't allocate anything:
+ * the layers are back propagated one at a time from the top with bp_lstm_window and bp_gru_window, the errors
+ * passed between the layers live in the workspace of the rmodel (error_window, error_window2) and the errors
+ * of the first timestep of each layer are left in m->lstms[i]->dfioc (what bp_rmodel returns)
+ * 
+ * Inputs:
+ * 
+ *             @ float** hidden_states:= the hidden sates passed to each first orizontal cell, dimensions:m->layer*m->size
+ *             @ float** cell_states:= the cell sates passed to each first orizontal cell, dimensions:m->layer*m->size
+ *             @ float** input_model:= the input passed to the model, dimensions: m->window*m->size
+ *             @ float** error_model:= the error of the model, dimensions: m->window*m->size
+ *             @ rmodel* m:= the recurrent model
+ *             @ float** input_error:= where the errors of the inputs of this model are written, dimensions: m->window*m->size, can be NULL
+ *             @ float** hidden_states_error:= dL/dh of the hidden states after the last timestep, dimensions: m->layers*m->size, can be NULL
+ *             @ float** cell_states_error:= dL/dc of the cell states after the last timestep, dimensions: m->layers*m->size, can be NULL
+ * 
+ * */
+void bp_rmodel_workspace(float** hidden_states, float** cell_states, float** input_model, float** error_model, rmodel* m, float** input_error, float** hidden_states_error, float** cell_states_error){
+    if(m == NULL)
+        return;
+    int i,j,z;
+    float** error = error_model;
+    float** next;
+    lstm* l;
+    for(j = m->layers-1; j >= 0; j--){
+        l = m->lstms[j];
+        if(l->norm_flag == GROUP_NORMALIZATION){
+            for(i = 0; i < l->window/l->n_grouped_cell; i++){
+                batch_normalization_back_prop(l->n_grouped_cell,&l->out_up[i*l->n_grouped_cell],l->bns[i]->temp_vectors,l->bns[i]->vector_dim,l->bns[i]->gamma,l->bns[i]->beta,l->bns[i]->mean,l->bns[i]->var,&error[i*l->n_grouped_cell],l->bns[i]->d_gamma,l->bns[i]->d_beta,l->bns[i]->error2,l->bns[i]->temp1,l->bns[i]->temp2,l->bns[i]->epsilon);
             }
-            
-            for(j = 0; j < m->window/m->lstms[k]->n_grouped_cell; j++){
-                for(z = 0; z < m->lstms[k]->n_grouped_cell; z++){
-                    copy_array(m->lstms[k]->bns[j]->error2[z],error2_model[j*m->lstms[k]->n_grouped_cell+z],m->lstms[0]->size);
+            next = error == m->error_window ? m->error_window2 : m->error_window;
+            for(i = 0; i < l->window/l->n_grouped_cell; i++){
+                for(z = 0; z < l->n_grouped_cell; z++){
+                    copy_array(l->bns[i]->error2[z],next[i*l->n_grouped_cell+z],l->size);
                 }
             }
-            
-            if(n_cells)
-                ret_count = k;
+            error = next;
         }
         
-        else{
-            int n_cells = ret_count-k;
-            int k2 = k;
-            if(k < 0) k = 0;
-            ret2 = bp_rmodel_lstm(&hidden_states[k],&cell_states[k],input_model,error2_model,m->window,m->lstms[0]->size,n_cells,&m->lstms[k],input_error);
-            k = k2;
-
-            for(j = ret_count; j > k; j--){
-                ret[j] = ret2[j];
-            }    
-            free(ret2);
-        }
+        next = j == 0 ? input_error : (error == m->error_window ? m->error_window2 : m->error_window);
+        if(l->cell_type == GRU_CELL)
+            bp_gru_window(hidden_states[j],error,l,next,hidden_states_error == NULL ? NULL : hidden_states_error[j]);
+        else
+            bp_lstm_window(hidden_states[j],cell_states[j],error,l,next,hidden_states_error == NULL ? NULL : hidden_states_error[j],cell_states_error == NULL ? NULL : cell_states_error[j]);
+        error = next;
     }
-    
-    free_matrix(error2_model,m->window);
-    free(input_error3);
-    free(temp);
-    return ret;
-    
 }
 
 
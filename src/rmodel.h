@@ -28,15 +28,24 @@ SOFTWARE.
 rmodel* recurrent_network(int layers, int n_lstm, lstm** lstms, int window, int hidden_state_mode);
 void free_rmodel(rmodel* m);
 rmodel* copy_rmodel(rmodel* m);
+rmodel* share_rmodel(rmodel* m);
+void free_shared_rmodel(rmodel* m);
+int rmodel_shares_params(rmodel* m, rmodel* s);
 void paste_rmodel(rmodel* m, rmodel* copy);
 void slow_paste_rmodel(rmodel* m, rmodel* copy, float tau);
 rmodel* reset_rmodel(rmodel* m);
+rmodel* reset_rmodel_except_partial_derivatives(rmodel* m);
+int get_partial_derivatives_segments_rmodel(rmodel* m, float** segments, int* sizes);
 void save_rmodel(rmodel* m, int n);
 void heavy_save_rmodel(rmodel* m, int n);
 rmodel* load_rmodel(char* file);
 rmodel* heavy_load_rmodel(char* file);
 void ff_rmodel_lstm(float** hidden_states, float** cell_states, float** input_model, int window, int size, int layers, lstm** lstms);
 float*** bp_rmodel_lstm(float** hidden_states, float** cell_states, float** input_model, float** error_model, int window, int size,int layers,lstm** lstms, float** input_error);
+void bp_lstm_window(float* hidden_state, float* cell_state, float** error_model, lstm* l, float** input_error, float* hidden_state_error, float* cell_state_error);
+void bp_lstm_timestep(float* hidden_state, float* cell_state, float* error, lstm* l, int i);
+void bp_lstm_window_weights(lstm* l);
+void bp_gru_window(float* hidden_state, float** error_model, lstm* l, float** input_error, float* hidden_state_error);
 int count_weights_rmodel(rmodel* m);
 void update_rmodel(rmodel* m, float lr, float momentum, int mini_batch_size, int gradient_descent_flag, float* b1, float* b2, int regularization, int total_number_weights, float lambda, unsigned long long int* t);
 void sum_rmodel_partial_derivatives(rmodel* m, rmodel* m2, rmodel* m3);
@@ -44,6 +53,7 @@ float* lstm_dinput(int index, int output, float** returning_error, lstm* lstms);
 float* lstm_dh(int index, int output, float** returning_error, lstm* lstms);
 void ff_rmodel(float** hidden_states, float** cell_states, float** input_model, rmodel* m);
 float*** bp_rmodel(float** hidden_states, float** cell_states, float** input_model, float** error_model, rmodel* m, float** input_error);
+void bp_rmodel_workspace(float** hidden_states, float** cell_states, float** input_model, float** error_model, rmodel* m, float** input_error, float** hidden_states_error, float** cell_states_error);
 void paste_w_rmodel(rmodel* m, rmodel* copy);
 void sum_rmodels_partial_derivatives(rmodel* m, rmodel** m2, int n_models);
 
@@ -0,0 +1,267 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include "llab.h"
+
+/* This function creates the state used to compute a rmodel one timestep at a time, for example for online forecasting.
+ * Only the hidden and cell states after the last timestep are kept, so each timestep costs O(layers*size*size)
+ * instead of the O(window*layers*size*size) of ff_rmodel, and rmodel_step allocates nothing.
+ * The states are set to zero
+ * 
+ * Input:
+ *             
+ *             @ rmodel* m:= the rmodel, it is not copied
+ * 
+ * */
+rstep* rmodel_step_state(rmodel* m){
+    if(m == NULL)
+        return NULL;
+    
+    int i,j;
+    
+    for(i = 0; i < m->layers; i++){
+        if(m->lstms[i]->norm_flag == GROUP_NORMALIZATION){
+            fprintf(stderr,"Error: the group normalization of a rmodel can't be computed one timestep at a time, layer: %d\n",i);
+            exit(1);
+        }
+    }
+    
+    rstep* s = (rstep*)malloc(sizeof(rstep));
+    s->m = m;
+    s->t = 0;
+    s->hidden_states = (float**)malloc(sizeof(float*)*m->layers);
+    s->cell_states = (float**)malloc(sizeof(float*)*m->layers);
+    s->outputs = (float**)malloc(sizeof(float*)*m->layers);
+    s->zx = (float**)malloc(sizeof(float*)*m->layers);
+    s->z = (float***)malloc(sizeof(float**)*m->layers);
+    s->h_right = (float*)calloc(m->lstms[0]->size,sizeof(float));
+    for(i = 0; i < m->layers; i++){
+        s->hidden_states[i] = (float*)calloc(m->lstms[i]->size,sizeof(float));
+        s->cell_states[i] = (float*)calloc(m->lstms[i]->size,sizeof(float));
+        s->outputs[i] = (float*)calloc(m->lstms[i]->size,sizeof(float));
+        s->zx[i] = (float*)calloc(4*m->lstms[i]->size,sizeof(float));
+        s->z[i] = (float**)malloc(sizeof(float*)*4);
+        for(j = 0; j < 4; j++){
+            s->z[i][j] = (float*)calloc(m->lstms[i]->size,sizeof(float));
+        }
+    }
+    return s;
+}
+
+/* This function frees the space allocated by a rmodel step state, the rmodel is not deallocated
+ * 
+ * Input:
+ *             @ rstep* s:= the state
+ * 
+ * */
+void free_rmodel_step_state(rstep* s){
+    if(s == NULL)
+        return;
+    int i;
+    for(i = 0; i < s->m->layers; i++){
+        free(s->hidden_states[i]);
+        free(s->cell_states[i]);
+        free(s->outputs[i]);
+        free(s->zx[i]);
+        free_matrix(s->z[i],4);
+    }
+    free(s->hidden_states);
+    free(s->cell_states);
+    free(s->outputs);
+    free(s->zx);
+    free(s->z);
+    free(s->h_right);
+    free(s);
+}
+
+/* This function starts a new sequence for a rmodel step state
+ * 
+ * Input:
+ *             @ rstep* s:= the state
+ *             @ float** hidden_states:= the hidden states before the first timestep, dimensions: layers x size, if NULL they are set to zero
+ *             @ float** cell_states:= the cell states before the first timestep, dimensions: layers x size, if NULL they are set to zero
+ * 
+ * */
+void reset_rmodel_step_state(rstep* s, float** hidden_states, float** cell_states){
+    if(s == NULL)
+        return;
+    int i;
+    for(i = 0; i < s->m->layers; i++){
+        if(hidden_states != NULL)
+            copy_array(hidden_states[i],s->hidden_states[i],s->m->lstms[i]->size);
+        else
+            memset(s->hidden_states[i],0,sizeof(float)*s->m->lstms[i]->size);
+        if(cell_states != NULL)
+            copy_array(cell_states[i],s->cell_states[i],s->m->lstms[i]->size);
+        else
+            memset(s->cell_states[i],0,sizeof(float)*s->m->lstms[i]->size);
+    }
+    s->t = 0;
+}
+
+/* This function computes the next timestep of a rmodel, as ff_rmodel would do for that timestep of the window,
+ * and updates the states. The dropout masks of the lstms are used as they are (they are not drawn)
+ * 
+ * Input:
+ *             @ rstep* s:= the state
+ *             @ float* x:= the input of the timestep, dimensions: size
+ * 
+ * Output:
+ *             @ float*:= the output of the last layer, owned by the state and overwritten by the next timestep
+ * 
+ * */
+float* rmodel_step(rstep* s, float* x){
+    int j;
+    float* in;
+    lstm* l;
+    
+    for(j = 0; j < s->m->layers; j++){
+        l = s->m->lstms[j];
+        in = j == 0 ? x : s->outputs[j-1];
+        
+        recurrent_input_projections(in,1,l->size,l->n_gates,l->w,l->biases,s->zx[j]);
+        
+        get_dropout_array(l->size,l->dropout_mask_right,s->hidden_states[j],s->h_right);//dropout for h between recurrent connections
+        if(l->dropout_flag_right == DROPOUT_TEST)
+            mul_value(s->h_right,l->dropout_threshold_right,s->h_right,l->size);
+        
+        // the new states overwrite the previous ones, a gru has no cell state and uses it for u*h of the candidate gate
+        if(l->cell_type == GRU_CELL)
+            gru_ff_fused(s->zx[j],s->h_right,s->hidden_states[j],s->cell_states[j],s->hidden_states[j],l->u,s->z[j],l->size);
+        else
+            lstm_ff_fused(s->zx[j],s->h_right,s->cell_states[j],s->cell_states[j],s->hidden_states[j],l->u,s->z[j],l->size);
+        
+        get_dropout_array(l->size,l->dropout_mask_up,s->hidden_states[j],s->outputs[j]);
+        if(l->dropout_flag_up == DROPOUT_TEST)
+            mul_value(s->outputs[j],l->dropout_threshold_up,s->outputs[j],l->size);
+        if(l->residual_flag == LSTM_RESIDUAL)
+            sum1D(s->outputs[j],in,s->outputs[j],l->size);
+    }
+    
+    s->t++;
+    return s->outputs[s->m->layers-1];
+}
+
+/* This function creates the state used to decode a recurrent_enc_dec one timestep at a time. The encoder is computed
+ * once for each sequence by encode_recurrent_enc_dec_step, and its outputs are cached for the attention of all the
+ * timesteps decoded by decode_recurrent_enc_dec_step, that allocates nothing
+ * 
+ * Input:
+ *             
+ *             @ recurrent_enc_dec* rec:= the recurrent encoder decoder, it is not copied
+ * 
+ * */
+edstep* recurrent_enc_dec_step_state(recurrent_enc_dec* rec){
+    if(rec == NULL)
+        return NULL;
+    edstep* s = (edstep*)malloc(sizeof(edstep));
+    s->rec = rec;
+    s->decoder = rmodel_step_state(rec->decoder);
+    s->encoder_outputs = (float*)calloc((rec->encoder->window+1)*rec->encoder->lstms[0]->size,sizeof(float));
+    s->keys = (float*)calloc(rec->encoder->window,sizeof(float));
+    s->scores = (float*)calloc(rec->encoder->window,sizeof(float));
+    s->attention = (float*)calloc(rec->encoder->window,sizeof(float));
+    s->input = (float*)calloc(rec->decoder->lstms[0]->size,sizeof(float));
+    return s;
+}
+
+/* This function frees the space allocated by a recurrent_enc_dec step state, the recurrent_enc_dec is not deallocated
+ * 
+ * Input:
+ *             @ edstep* s:= the state
+ * 
+ * */
+void free_recurrent_enc_dec_step_state(edstep* s){
+    if(s == NULL)
+        return;
+    free_rmodel_step_state(s->decoder);
+    free(s->encoder_outputs);
+    free(s->keys);
+    free(s->scores);
+    free(s->attention);
+    free(s->input);
+    free(s);
+}
+
+/* This function computes the encoder of a recurrent_enc_dec for a new sequence, as ff_recurrent_enc_dec does,
+ * caches its outputs for the attention and sets the states of the decoder with the last states of the encoder
+ * 
+ * Input:
+ *             @ edstep* s:= the state
+ *             @ float** hidden_states:= the hidden states for encoder size rec->encoder->n_lstm*rec->encoder->lstms[0]->size
+ *             @ float** cell_states:= the cell states for the encoder size rec->encoder->n_lstm*rec->encoder->lstms[0]->size
+ *             @ float** input_model1:= the inputs for the encoder size rec->encoder->window*rec->encder->lstms[0]->size
+ * 
+ * */
+void encode_recurrent_enc_dec_step(edstep* s, float** hidden_states, float** cell_states, float** input_model1){
+    if(s == NULL)
+        return;
+    int i;
+    recurrent_enc_dec* rec = s->rec;
+    int encoder_size = rec->encoder->lstms[0]->size;
+    
+    ff_rmodel(hidden_states,cell_states,input_model1,rec->encoder);
+    
+    for(i = 0; i < rec->encoder->window; i++){
+        copy_array(rec->encoder->lstms[rec->encoder->n_lstm-1]->lstm_hidden[i],&s->encoder_outputs[i*encoder_size],encoder_size);
+    }
+    // the first query of the attention is the last hidden state of the encoder
+    copy_array(rec->encoder->lstms[rec->encoder->n_lstm-1]->lstm_hidden[rec->encoder->window-1],&s->encoder_outputs[rec->encoder->window*encoder_size],encoder_size);
+    attention_keys(s->encoder_outputs,rec->m[0]->fcls[0]->weights,rec->m[0]->fcls[0]->biases,s->keys,rec->encoder->window,encoder_size);
+    
+    reset_rmodel_step_state(s->decoder,NULL,NULL);
+    for(i = 0; i < rec->encoder->n_lstm; i++){
+        copy_array(rec->encoder->lstms[i]->lstm_hidden[rec->encoder->window-1],s->decoder->hidden_states[i],rec->encoder->lstms[i]->size);
+        copy_array(rec->encoder->lstms[i]->lstm_cell[rec->encoder->window-1],s->decoder->cell_states[i],rec->encoder->lstms[i]->size);
+    }
+}
+
+/* This function decodes the next timestep of a recurrent_enc_dec after encode_recurrent_enc_dec_step,
+ * as ff_recurrent_enc_dec would do for that timestep of the decoder window.
+ * The attention weights are shared by all the timesteps, so the decoding is not limited to rec->decoder->window timesteps
+ * 
+ * Input:
+ *             @ edstep* s:= the state
+ *             @ float* input_model2:= the input of the decoder for this timestep, dimensions: rec->decoder->lstms[0]->size-rec->encoder->lstms[0]->size
+ * 
+ * Output:
+ *             @ float*:= the output of the decoder, owned by the state and overwritten by the next timestep
+ * 
+ * */
+float* decode_recurrent_enc_dec_step(edstep* s, float* input_model2){
+    recurrent_enc_dec* rec = s->rec;
+    int encoder_size = rec->encoder->lstms[0]->size, decoder_size = rec->decoder->lstms[0]->size, window = rec->encoder->window;
+    
+    // attention over the cached outputs of the encoder
+    memset(s->input,0,sizeof(float)*encoder_size);
+    attention_feed_forward(s->keys,s->encoder_outputs,&s->encoder_outputs[window*encoder_size],rec->m[0]->fcls[0]->weights,s->scores,s->attention,s->input,window,encoder_size);
+    copy_array(input_model2,&s->input[encoder_size],decoder_size-encoder_size);
+    
+    float* y = rmodel_step(s->decoder,s->input);
+    
+    // the next query of the attention is the output of the decoder
+    copy_array(y,&s->encoder_outputs[window*encoder_size],encoder_size);
+    return y;
+}
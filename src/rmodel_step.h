@@ -0,0 +1,38 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef __RMODEL_STEP_H__
+#define __RMODEL_STEP_H__
+
+rstep* rmodel_step_state(rmodel* m);
+void free_rmodel_step_state(rstep* s);
+void reset_rmodel_step_state(rstep* s, float** hidden_states, float** cell_states);
+float* rmodel_step(rstep* s, float* x);
+edstep* recurrent_enc_dec_step_state(recurrent_enc_dec* rec);
+void free_recurrent_enc_dec_step_state(edstep* s);
+void encode_recurrent_enc_dec_step(edstep* s, float** hidden_states, float** cell_states, float** input_model1);
+float* decode_recurrent_enc_dec_step(edstep* s, float* input_model2);
+
+#endif
@@ -23,20 +23,70 @@ SOFTWARE.
 */
 
 #include "llab.h"
+
+/* This function is the thread of a client: it reads the vector of the parent process from the pipe, sends it to the client
+ * as a framed message, waits the answer of the client and writes it on the pipe to the parent process.
+ * The client opens the connection with a MESSAGE_HELLO asking for a compression of its vectors (see compression.c),
+ * the thread answers with the compression accepted and adds the compressed vectors of the client to a zeroed array
+ * before writing them on the pipe, so the parent process always reads dense vectors.
+ * The thread waits on blocking reads and ends when the parent process closes the pipe or the client closes the connection
+ * 
+ * Input:
+ * 
+ *                 @ void* _args:= a thread_args_server*
+ * */
 void* server_thread(void* _args) {
     
     // depacking args
     thread_args_server* args = (thread_args_server*) _args;
     float* buff = (float*)calloc(args->buffer_size,sizeof(float));
-    int ret;
-    while(1){
-        while(read(args->reading_pipe, buff, sizeof(float)*args->buffer_size) == 0);// waiting for parent process
-        ret = write(args->client_desc,buff, sizeof(float)*args->buffer_size);// writing to client
-        while(read(args->client_desc, buff, sizeof(float)*args->buffer_size) == 0);// waiting for client
-        ret = write(args->writing_pipe,buff, sizeof(float)*args->buffer_size);// writing to parent process
+    long long int bytes = sizeof(float)*(long long int)args->buffer_size, max_bytes = bytes;
+    unsigned int step = 0;
+    int type = COMPRESSION_NONE, connected = 1;
+    float hello[2];
+    void* compressed = NULL;
+    message_header header;
+    
+    // negotiating the compression of the vectors of the client
+    if(recv_message(args->client_desc,&header,hello,sizeof(hello)) == -1 || header.type != MESSAGE_HELLO || header.length != sizeof(hello))
+        connected = 0;
+    else{
+        if(hello[0] >= COMPRESSION_FP16 && hello[0] <= COMPRESSION_TOPK && (hello[0] != COMPRESSION_TOPK || (hello[1] > 0 && hello[1] <= 1)))
+            type = (int)hello[0];
+        hello[0] = type;
+        if(send_message(args->client_desc,MESSAGE_HELLO,0,hello,sizeof(hello)) == -1)
+            connected = 0;
+        if(type != COMPRESSION_NONE){
+            if(compressed_size(type,args->buffer_size,hello[1]) > max_bytes)
+                max_bytes = compressed_size(type,args->buffer_size,hello[1]);
+            compressed = malloc(max_bytes);
+        }
     }
     
+    for(; connected; step++){
+        if(read_all(args->reading_pipe,buff,bytes) == -1)// waiting for parent process
+            break;
+        if(send_message(args->client_desc,MESSAGE_VECTOR,step,buff,bytes) == -1)// writing to client
+            break;
+        if(recv_message(args->client_desc,&header,type == COMPRESSION_NONE ? (void*)buff : compressed,max_bytes) == -1 || header.type == MESSAGE_CLOSE)// waiting for client, a corrupted message drops only this client
+            break;
+        if(header.step != step || header.type != (type == COMPRESSION_NONE ? MESSAGE_VECTOR : MESSAGE_COMPRESSED) || (type == COMPRESSION_NONE && header.length != (unsigned long long int)bytes)){
+            fprintf(stderr,"Error: the client %d answered to the step %u with %llu bytes of type %u, instead of the step %u, it is disconnected\n",args->idx,header.step,header.length,header.type,step);
+            break;
+        }
+        if(type != COMPRESSION_NONE){
+            memset(buff,0,bytes);
+            decompress_add(type,compressed,header.length,buff,args->buffer_size);
+        }
+        if(write_all(args->writing_pipe,buff,bytes) == -1)// writing to parent process
+            break;
+    }
+    send_message(args->client_desc,MESSAGE_CLOSE,step,NULL,0);
+    close(args->client_desc);
+    free(args->client_addr);
+    free(args);
     free(buff);
+    free(compressed);
     
     return NULL;
 }
@@ -111,8 +161,15 @@ int run_server(int port, int max_num_conn, int* reading_pipes, int* writing_pipe
     int i = 0;
     while(1){
         client_addr = calloc(1,sizeof(struct sockaddr_in));
-        client_desc = accept(socket_desc,(struct sockaddr*)&client_addr,(socklen_t*)&sockaddr_len);
-        if((client_desc == 1 && errno == EINTR)) continue;
+        client_desc = accept(socket_desc,(struct sockaddr*)client_addr,(socklen_t*)&sockaddr_len);
+        if(client_desc == -1){
+            free(client_addr);
+            if(errno == EINTR)
+                continue;
+            fprintf(stderr,"Error: accept failed\n");
+            exit(1);
+        }
+        set_socket_options(client_desc);
         thread_args_server* thread = (thread_args_server*)malloc(sizeof(thread_args_server));
         thread->idx = i;
         thread->client_desc = client_desc;
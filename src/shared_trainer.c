@@ -0,0 +1,317 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+#define _GNU_SOURCE
+#include "llab.h"
+
+/* Data parallel training between the processes of a single host through a POSIX shared memory segment,
+ * without sockets and pipes. The segment has ARENA_SLOTS regions with the master copy of the arena of the model
+ * (the params, the summed partial derivatives and the arrays of the optimizer) followed by a region for each worker.
+ * Each worker moves the params slot of its model on the master params, so the params are never copied,
+ * and its partial derivatives slot on its own region, so the back propagation writes directly in the segment.
+ * A step is: a barrier, each worker sums the partial derivatives of all the workers on its shard of the arena
+ * (zeroing them in the same pass) and updates the params of its shard, a barrier.
+ * The pages are placed on the numa node of the first process writing them: each worker writes first its own region
+ * and its shard of the master regions (join_shared_trainer), and with pinned workers the pages stay local
+ * to the worker that uses them the most.
+ * */
+
+/* This function creates the shared memory segment of a data parallel training, the workers join it
+ * with join_shared_trainer (after a fork, or after open_shared_trainer in other processes)
+ * 
+ * Input:
+ *             @ char* name:= the name of the segment, "/name"
+ *             @ int n_workers:= the workers that will join the training
+ *             @ model* m:= a model with the structure of the models of the workers, it is made contiguous
+ * 
+ * Output:
+ *             @ shared_trainer*:= the segment
+ * */
+shared_trainer* create_shared_trainer(char* name, int n_workers, model* m){
+    if(n_workers < 1 || m == NULL){
+        fprintf(stderr,"Error: a shared trainer needs a model and at least a worker\n");
+        exit(1);
+    }
+    make_model_contiguous(m);
+    if(!fused_update_supported_model(m)){
+        fprintf(stderr,"Error: the model can't be updated with a single sweep over its arena (edge popup or normalization layers)\n");
+        exit(1);
+    }
+    int fd, page = SHARED_TRAINER_PAGE/sizeof(float);
+    pthread_barrierattr_t attr;
+    shared_trainer* t = (shared_trainer*)calloc(1,sizeof(shared_trainer));
+    t->name = (char*)malloc(strlen(name)+1);
+    strcpy(t->name,name);
+    t->owner = getpid();
+    t->rank = -1;
+    t->n_workers = n_workers;
+    t->size = m->arena->size;
+    t->stride = ((t->size+page-1)/page)*page;
+    t->length = SHARED_TRAINER_PAGE+sizeof(float)*t->stride*(ARENA_SLOTS+n_workers);
+    
+    fd = shm_open(name,O_CREAT|O_EXCL|O_RDWR,0600);
+    if(fd == -1){
+        fprintf(stderr,"Error: can't create the shared memory segment %s\n",name);
+        exit(1);
+    }
+    // the pages are not touched here, see join_shared_trainer
+    if(ftruncate(fd,t->length) == -1){
+        fprintf(stderr,"Error: can't allocate %zu bytes of shared memory\n",t->length);
+        exit(1);
+    }
+    t->header = (shared_trainer_header*)mmap(NULL,t->length,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+    close(fd);
+    if(t->header == MAP_FAILED){
+        fprintf(stderr,"Error: can't map the shared memory segment %s\n",name);
+        exit(1);
+    }
+    t->header->n_workers = n_workers;
+    t->header->size = t->size;
+    t->header->stride = t->stride;
+    pthread_barrierattr_init(&attr);
+    pthread_barrierattr_setpshared(&attr,PTHREAD_PROCESS_SHARED);
+    pthread_barrier_init(&t->header->barrier,&attr,n_workers);
+    pthread_barrierattr_destroy(&attr);
+    set_shared_trainer_regions(t,m->arena->params_size);
+    return t;
+}
+
+/* This function maps the shared memory segment created by create_shared_trainer in another process
+ * 
+ * Input:
+ *             @ char* name:= the name of the segment
+ *             @ int params_size:= the floats of the params of the model, m->arena->params_size of a contiguous model
+ * 
+ * Output:
+ *             @ shared_trainer*:= the segment
+ * */
+shared_trainer* open_shared_trainer(char* name, int params_size){
+    struct stat st;
+    shared_trainer* t = (shared_trainer*)calloc(1,sizeof(shared_trainer));
+    int fd = shm_open(name,O_RDWR,0600);
+    if(fd == -1 || fstat(fd,&st) == -1){
+        fprintf(stderr,"Error: can't open the shared memory segment %s\n",name);
+        exit(1);
+    }
+    t->name = (char*)malloc(strlen(name)+1);
+    strcpy(t->name,name);
+    t->rank = -1;
+    t->length = st.st_size;
+    t->header = (shared_trainer_header*)mmap(NULL,t->length,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+    close(fd);
+    if(t->header == MAP_FAILED){
+        fprintf(stderr,"Error: can't map the shared memory segment %s\n",name);
+        exit(1);
+    }
+    t->n_workers = t->header->n_workers;
+    t->size = t->header->size;
+    t->stride = t->header->stride;
+    set_shared_trainer_regions(t,params_size);
+    return t;
+}
+
+/* This function points the regions and the master arena of a shared trainer inside its segment
+ * 
+ * Input:
+ *             @ shared_trainer* t:= the shared trainer
+ *             @ int params_size:= the floats of the params of the model
+ * */
+void set_shared_trainer_regions(shared_trainer* t, int params_size){
+    int j;
+    t->regions = (float*)((char*)t->header+SHARED_TRAINER_PAGE);
+    t->master.size = t->size;
+    t->master.params_size = params_size;
+    t->master.memory = NULL;
+    for(j = 0; j < ARENA_SLOTS; j++){
+        t->master.slots[j] = &t->regions[j*t->stride];
+    }
+}
+
+/* This function joins a worker to the training: the shard of the worker is initialized from its model
+ * (all the models must have the same params, for example created before the fork), then the params slot
+ * of the model is moved on the master params and the partial derivatives slot on the region of the worker.
+ * It returns when all the workers joined
+ * 
+ * Input:
+ *             @ shared_trainer* t:= the shared trainer, the one of create_shared_trainer (after a fork) or of open_shared_trainer
+ *             @ int rank:= the worker, 0 <= rank < n_workers
+ *             @ model* m:= the model of the worker, it is made contiguous
+ *             @ int pin_flag:= 1 to pin the worker on a cpu, the workers are spread over the cpus so the pages written first
+ *                              by a worker stay on its numa node
+ * */
+void join_shared_trainer(shared_trainer* t, int rank, model* m, int pin_flag){
+    if(rank < 0 || rank >= t->n_workers || t->rank != -1){
+        fprintf(stderr,"Error: rank %d is not a free worker of the shared trainer\n",rank);
+        exit(1);
+    }
+    int i, j, n, page = SHARED_TRAINER_PAGE/sizeof(float);
+    long long int shard, start, end;
+    cpu_set_t set;
+    
+    if(pin_flag){
+        n = sysconf(_SC_NPROCESSORS_ONLN);
+        CPU_ZERO(&set);
+        CPU_SET((int)((long long int)rank*n/t->n_workers),&set);
+        if(sched_setaffinity(0,sizeof(set),&set) == -1)
+            fprintf(stderr,"Warning: worker %d can't be pinned\n",rank);
+    }
+    
+    make_model_contiguous(m);
+    if(m->arena->size != t->size || m->arena->params_size != t->master.params_size){
+        fprintf(stderr,"Error: the model of the worker %d doesn't match the shared trainer\n",rank);
+        exit(1);
+    }
+    
+    // the shards start on a page
+    shard = ((t->size+t->n_workers-1)/t->n_workers+page-1)/page*page;
+    t->start = (long long int)rank*shard < t->size ? (long long int)rank*shard : t->size;
+    t->end = t->start+shard < t->size ? t->start+shard : t->size;
+    
+    // first touch: the shard of the master regions and the region of the worker
+    for(j = 0; j < ARENA_SLOTS; j++){
+        if(j == ARENA_DERIVATIVES)
+            memset(&t->master.slots[j][t->start],0,sizeof(float)*(t->end-t->start));
+        else
+            copy_array(&m->arena->slots[j][t->start],&t->master.slots[j][t->start],t->end-t->start);
+    }
+    move_model_arena_slot(m,ARENA_DERIVATIVES,&t->regions[(ARENA_SLOTS+rank)*t->stride],1);
+    
+    // the spans of the update inside the shard
+    n = get_update_spans_model(m,NULL);
+    optimizer_span* spans = (optimizer_span*)malloc(sizeof(optimizer_span)*(n+1));
+    n = get_update_spans_model(m,spans);
+    t->spans = (optimizer_span*)malloc(sizeof(optimizer_span)*(n+1));
+    for(i = 0, t->n_spans = 0; i < n; i++){
+        start = spans[i].offset > t->start ? spans[i].offset : t->start;
+        end = spans[i].offset+spans[i].size < t->end ? spans[i].offset+spans[i].size : t->end;
+        if(!(spans[i].flags & OPTIMIZER_SPAN_UPDATE) || start >= end)
+            continue;
+        t->spans[t->n_spans].offset = start;
+        t->spans[t->n_spans].size = end-start;
+        t->spans[t->n_spans].flags = spans[i].flags;
+        t->n_spans++;
+    }
+    free(spans);
+    
+    pthread_barrier_wait(&t->header->barrier);
+    move_model_arena_slot(m,ARENA_PARAMS,t->master.slots[ARENA_PARAMS],0);
+    t->rank = rank;
+}
+
+/* This function is the step of a worker after its back propagation: it waits for all the workers,
+ * sums the partial derivatives of its shard, updates the params of its shard and waits for all the workers again.
+ * Then the model of the worker has the updated params and its partial derivatives are zeroed,
+ * the layers can be resetted with reset_model_except_partial_derivatives. See update_model for the inputs
+ * 
+ * Input:
+ *             @ shared_trainer* t:= the shared trainer, joined
+ *             @ model* m:= the model of the worker
+ *             @ float lr:= the learning rate
+ *             @ float momentum:= the momentum
+ *             @ int mini_batch_size:= the instances of all the workers in this step
+ *             @ int gradient_descent_flag:= NESTEROV, ADAM, RADAM, DIFF_GRAD or ADAMOD
+ *             @ float* b1:= BETA1_ADAM^t, each worker has its own copy
+ *             @ float* b2:= BETA2_ADAM^t, each worker has its own copy
+ *             @ int regularization:= NO_REGULARIZATION or L2_REGULARIZATION
+ *             @ int total_number_weights:= the weights of the model for the l2 regularization
+ *             @ float lambda:= the lambda of the l2 regularization
+ *             @ unsigned long long int* t_radam:= the step of radam, each worker has its own copy
+ * */
+void shared_trainer_step(shared_trainer* t, model* m, float lr, float momentum, int mini_batch_size, int gradient_descent_flag, float* b1, float* b2, int regularization, int total_number_weights, float lambda, unsigned long long int* t_radam){
+    int i;
+    long long int n = t->end-t->start;
+    float* sum = &t->master.slots[ARENA_DERIVATIVES][t->start];
+    float* slab;
+    optimizer_step s;
+    
+    pthread_barrier_wait(&t->header->barrier);
+    for(i = 0; i < t->n_workers && n > 0; i++){
+        slab = &t->regions[(ARENA_SLOTS+i)*t->stride+t->start];
+        if(i == 0)
+            copy_array(slab,sum,n);
+        else
+            sum1D(sum,slab,sum,n);
+        memset(slab,0,sizeof(float)*n);
+    }
+    set_optimizer_step(&s,lr,momentum,mini_batch_size,gradient_descent_flag,(*b1),(*b2),regularization,total_number_weights,lambda,(*t_radam),m->beta1_adam,m->beta2_adam,m->beta3_adamod,0);
+    s.clip = 1;
+    for(i = 0; i < t->n_spans; i++){
+        update_params_span(&t->master,&s,&t->spans[i]);
+    }
+    pthread_barrier_wait(&t->header->barrier);
+    update_optimizer_counters(gradient_descent_flag,b1,b2,t_radam,m->beta1_adam,m->beta2_adam);
+    invalidate_model_winograd_kernels(m);
+}
+
+/* This function copies the master params in a model with the structure of the models of the workers
+ * 
+ * Input:
+ *             @ shared_trainer* t:= the shared trainer
+ *             @ model* m:= the model, made contiguous
+ * */
+void copy_shared_trainer_params(shared_trainer* t, model* m){
+    make_model_contiguous(m);
+    if(m->arena->size != t->size){
+        fprintf(stderr,"Error: the model doesn't match the shared trainer\n");
+        exit(1);
+    }
+    if(m->arena->slots[ARENA_PARAMS] != t->master.slots[ARENA_PARAMS]){
+        copy_array(t->master.slots[ARENA_PARAMS],m->arena->slots[ARENA_PARAMS],t->size);
+        invalidate_model_winograd_kernels(m);
+    }
+}
+
+/* This function moves the params and the partial derivatives of the model of a worker back in its own arena,
+ * with a copy of the master params, so the model can be used after free_shared_trainer
+ * 
+ * Input:
+ *             @ shared_trainer* t:= the shared trainer, joined
+ *             @ model* m:= the model of the worker
+ * */
+void leave_shared_trainer(shared_trainer* t, model* m){
+    move_model_arena_slot(m,ARENA_PARAMS,NULL,1);
+    move_model_arena_slot(m,ARENA_DERIVATIVES,NULL,1);
+    t->rank = -1;
+}
+
+/* This function unmaps the segment of a shared trainer, the process that created it also removes it
+ * (not its sons, that get a copy of the shared trainer with the fork). The models of the workers must be freed or must leave the training before
+ * 
+ * Input:
+ *             @ shared_trainer* t:= the shared trainer
+ * */
+void free_shared_trainer(shared_trainer* t){
+    if(t == NULL)
+        return;
+    if(t->owner == getpid())
+        pthread_barrier_destroy(&t->header->barrier);
+    munmap(t->header,t->length);
+    if(t->owner == getpid())
+        shm_unlink(t->name);
+    free(t->name);
+    free(t->spans);
+    free(t);
+}
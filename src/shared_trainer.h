@@ -0,0 +1,39 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+#ifndef __SHARED_TRAINER_H__
+#define __SHARED_TRAINER_H__
+
+shared_trainer* create_shared_trainer(char* name, int n_workers, model* m);
+shared_trainer* open_shared_trainer(char* name, int params_size);
+void set_shared_trainer_regions(shared_trainer* t, int params_size);
+void join_shared_trainer(shared_trainer* t, int rank, model* m, int pin_flag);
+void shared_trainer_step(shared_trainer* t, model* m, float lr, float momentum, int mini_batch_size, int gradient_descent_flag, float* b1, float* b2, int regularization, int total_number_weights, float lambda, unsigned long long int* t_radam);
+void copy_shared_trainer_params(shared_trainer* t, model* m);
+void leave_shared_trainer(shared_trainer* t, model* m);
+void free_shared_trainer(shared_trainer* t);
+
+#endif
@@ -0,0 +1,298 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include "llab.h"
+
+/* This function creates the structure used to stream arbitrarily long sequences through a STATEFUL rmodel
+ * in chunks of m->window timesteps, with truncated back propagation through time (k1 = m->window, k2 = n_chunks*m->window):
+ * each chunk is computed by ff_stream_rmodel starting from the states left by the previous chunk, and bp_stream_rmodel
+ * back propagates the errors of the last chunk through the last n_chunks chunks. The memory doesn't depend on the length
+ * of the sequences: with TBPTT_STORE the activations of the last n_chunks chunks are kept, with TBPTT_CHECKPOINT
+ * only their inputs and the states before each of them are kept, and the activations of the older chunks are recomputed
+ * during the back propagation, so the activations of only one chunk are stored.
+ * The batch_size sequences are computed in lockstep by batched rmodels (see batch_rmodel) and the partial derivatives
+ * are accumulated in m. The dropout masks are drawn for each sequence by reset_stream_rmodel_states
+ * 
+ * Input:
+ *             
+ *             @ rmodel* m:= the rmodel, it must be STATEFUL and it is not copied
+ *             @ int batch_size:= the number of sequences streamed together
+ *             @ int n_chunks:= the number of chunks crossed by the back propagation
+ *             @ int memory_flag:= TBPTT_STORE or TBPTT_CHECKPOINT
+ * 
+ * */
+srmodel* stream_rmodel(rmodel* m, int batch_size, int n_chunks, int memory_flag){
+    if(m == NULL || batch_size < 1 || n_chunks < 1){
+        fprintf(stderr,"Error: you need a rmodel, a batch size > 0 and a number of chunks > 0 to stream a rmodel\n");
+        exit(1);
+    }
+    if(m->hidden_state_mode != STATEFUL){
+        fprintf(stderr,"Error: only a STATEFUL rmodel can carry the states between the chunks of a stream\n");
+        exit(1);
+    }
+    if(memory_flag != TBPTT_STORE && memory_flag != TBPTT_CHECKPOINT){
+        fprintf(stderr,"Error: the memory flag of a stream must be TBPTT_STORE or TBPTT_CHECKPOINT\n");
+        exit(1);
+    }
+    
+    int i,j,n_brmodels = memory_flag == TBPTT_STORE ? n_chunks : 1;
+    
+    srmodel* sm = (srmodel*)malloc(sizeof(srmodel));
+    sm->m = m;
+    sm->batch_size = batch_size;
+    sm->n_chunks = n_chunks;
+    sm->memory_flag = memory_flag;
+    sm->inputs = NULL;
+    sm->hidden_states = NULL;
+    sm->cell_states = NULL;
+    sm->chunks = (brmodel**)malloc(sizeof(brmodel*)*n_brmodels);
+    for(i = 0; i < n_brmodels; i++){
+        sm->chunks[i] = batch_rmodel(m,batch_size);
+    }
+    
+    int size = sm->chunks[0]->size, n = batch_size*size;
+    
+    if(memory_flag == TBPTT_CHECKPOINT){
+        sm->inputs = (float**)malloc(sizeof(float*)*n_chunks);
+        sm->hidden_states = (float***)malloc(sizeof(float**)*n_chunks);
+        sm->cell_states = (float***)malloc(sizeof(float**)*n_chunks);
+        for(i = 0; i < n_chunks; i++){
+            sm->inputs[i] = (float*)calloc(m->window*n,sizeof(float));
+            sm->hidden_states[i] = (float**)malloc(sizeof(float*)*m->layers);
+            sm->cell_states[i] = (float**)malloc(sizeof(float*)*m->layers);
+            for(j = 0; j < m->layers; j++){
+                sm->hidden_states[i][j] = (float*)calloc(n,sizeof(float));
+                sm->cell_states[i][j] = (float*)calloc(n,sizeof(float));
+            }
+        }
+    }
+    
+    sm->hidden_states_carry = (float**)malloc(sizeof(float*)*m->layers);
+    sm->cell_states_carry = (float**)malloc(sizeof(float*)*m->layers);
+    for(j = 0; j < m->layers; j++){
+        sm->hidden_states_carry[j] = (float*)calloc(n,sizeof(float));
+        sm->cell_states_carry[j] = (float*)calloc(n,sizeof(float));
+    }
+    
+    reset_stream_rmodel_states(sm);
+    return sm;
+}
+
+/* This function frees the space allocated by a stream, the rmodel m is not deallocated
+ * 
+ * Input:
+ *             @ srmodel* sm:= the stream
+ * 
+ * */
+void free_stream_rmodel(srmodel* sm){
+    if(sm == NULL)
+        return;
+    int i,j;
+    for(i = 0; i < (sm->memory_flag == TBPTT_STORE ? sm->n_chunks : 1); i++){
+        free_batch_rmodel(sm->chunks[i]);
+    }
+    free(sm->chunks);
+    if(sm->memory_flag == TBPTT_CHECKPOINT){
+        for(i = 0; i < sm->n_chunks; i++){
+            for(j = 0; j < sm->m->layers; j++){
+                free(sm->hidden_states[i][j]);
+                free(sm->cell_states[i][j]);
+            }
+            free(sm->inputs[i]);
+            free(sm->hidden_states[i]);
+            free(sm->cell_states[i]);
+        }
+        free(sm->inputs);
+        free(sm->hidden_states);
+        free(sm->cell_states);
+    }
+    for(j = 0; j < sm->m->layers; j++){
+        free(sm->hidden_states_carry[j]);
+        free(sm->cell_states_carry[j]);
+    }
+    free(sm->hidden_states_carry);
+    free(sm->cell_states_carry);
+    free(sm);
+}
+
+/* This function resets the partial derivatives of the rmodel of a stream, after its update.
+ * The states and the chunks kept for the back propagation don't change
+ * 
+ * Input:
+ *             @ srmodel* sm:= the stream
+ * 
+ * */
+void reset_stream_rmodel(srmodel* sm){
+    if(sm == NULL)
+        return;
+    reset_rmodel(sm->m);
+}
+
+/* This function starts new sequences: the states are set to zero, the chunks kept for the back propagation
+ * are discarded and new dropout masks are drawn, they are used for all the chunks of the sequences
+ * 
+ * Input:
+ *             @ srmodel* sm:= the stream
+ * 
+ * */
+void reset_stream_rmodel_states(srmodel* sm){
+    if(sm == NULL)
+        return;
+    int i,j,k,n = sm->batch_size*sm->chunks[0]->size;
+    lstm* l;
+    
+    for(j = 0; j < sm->m->layers; j++){
+        memset(sm->hidden_states_carry[j],0,sizeof(float)*n);
+        memset(sm->cell_states_carry[j],0,sizeof(float)*n);
+        
+        l = sm->m->lstms[j];
+        for(k = 0; k < n; k++){
+            sm->chunks[0]->dropout_mask_up[j][k] = 1;
+            sm->chunks[0]->dropout_mask_right[j][k] = 1;
+        }
+        if(l->dropout_flag_right == DROPOUT)
+            set_dropout_mask(n,sm->chunks[0]->dropout_mask_right[j],l->dropout_threshold_right);
+        if(l->dropout_flag_up == DROPOUT)
+            set_dropout_mask(n,sm->chunks[0]->dropout_mask_up[j],l->dropout_threshold_up);
+        for(i = 1; i < (sm->memory_flag == TBPTT_STORE ? sm->n_chunks : 1); i++){
+            copy_array(sm->chunks[0]->dropout_mask_up[j],sm->chunks[i]->dropout_mask_up[j],n);
+            copy_array(sm->chunks[0]->dropout_mask_right[j],sm->chunks[i]->dropout_mask_right[j],n);
+        }
+    }
+    sm->head = 0;
+    sm->count = 0;
+}
+
+/* This function returns the output of the last layer at the timestep t of the last chunk for a sequence of the stream.
+ * With TBPTT_CHECKPOINT it is valid until bp_stream_rmodel
+ * 
+ * Input:
+ *             @ srmodel* sm:= the stream
+ *             @ int index:= the index of the sequence in the batch
+ *             @ int t:= the timestep of the chunk
+ * 
+ * */
+float* get_stream_rmodel_output(srmodel* sm, int index, int t){
+    int slot = (sm->head-1+sm->n_chunks)%sm->n_chunks;
+    return get_batch_rmodel_output(sm->chunks[sm->memory_flag == TBPTT_STORE ? slot : 0],index,t);
+}
+
+/* This function computes the feed forward of the next chunk of the sequences of a stream,
+ * starting from the states after the previous chunk
+ * 
+ * Input:
+ *             
+ *             @ srmodel* sm:= the stream
+ *             @ float*** inputs:= the inputs of the chunk, dimensions: batch_size*window*size
+ * 
+ * */
+void ff_stream_rmodel(srmodel* sm, float*** inputs){
+    if(sm == NULL)
+        return;
+    
+    int j,t,b,slot = sm->head;
+    brmodel* bm = sm->chunks[sm->memory_flag == TBPTT_STORE ? slot : 0];
+    int size = bm->size, n = sm->batch_size*size;
+    
+    for(j = 0; j < bm->layers; j++){
+        copy_array(sm->hidden_states_carry[j],bm->hidden_states[j],n);
+        copy_array(sm->cell_states_carry[j],bm->cell_states[j],n);
+    }
+    for(t = 0; t < bm->window; t++){
+        for(b = 0; b < sm->batch_size; b++){
+            copy_array(inputs[b][t],&bm->input[(t*sm->batch_size+b)*size],size);
+        }
+    }
+    
+    if(sm->memory_flag == TBPTT_CHECKPOINT){
+        copy_array(bm->input,sm->inputs[slot],bm->window*n);
+        for(j = 0; j < bm->layers; j++){
+            copy_array(bm->hidden_states[j],sm->hidden_states[slot][j],n);
+            copy_array(bm->cell_states[j],sm->cell_states[slot][j],n);
+        }
+    }
+    
+    ff_rmodel_batch_packed(bm);
+    
+    for(j = 0; j < bm->layers; j++){
+        copy_array(&bm->hidden[j][(bm->window-1)*n],sm->hidden_states_carry[j],n);
+        copy_array(&bm->cell[j][(bm->window-1)*n],sm->cell_states_carry[j],n);
+    }
+    
+    sm->head = (slot+1)%sm->n_chunks;
+    if(sm->count < sm->n_chunks)
+        sm->count++;
+}
+
+/* This function back propagates the errors of the outputs of the last chunk through the last n_chunks chunks
+ * (or less at the beginning of the sequences), the partial derivatives are accumulated in the rmodel.
+ * The older chunks keep the activations computed by ff_stream_rmodel with TBPTT_STORE, while with TBPTT_CHECKPOINT
+ * they are recomputed from their inputs and states with the current weights
+ * 
+ * Input:
+ *             
+ *             @ srmodel* sm:= the stream
+ *             @ float*** errors:= the errors of the outputs of the last chunk, dimensions: batch_size*window*size
+ * 
+ * */
+void bp_stream_rmodel(srmodel* sm, float*** errors){
+    if(sm == NULL)
+        return;
+    
+    int c,j,t,b,slot,size = sm->chunks[0]->size, n = sm->batch_size*size;
+    brmodel* bm;
+    brmodel* next = NULL;
+    
+    // from the last chunk to the oldest one, the errors of the states are carried backward
+    for(c = 0; c < sm->count; c++){
+        slot = (sm->head-1-c+sm->n_chunks)%sm->n_chunks;
+        bm = sm->chunks[sm->memory_flag == TBPTT_STORE ? slot : 0];
+        
+        if(sm->memory_flag == TBPTT_CHECKPOINT && c){
+            copy_array(sm->inputs[slot],bm->input,bm->window*n);
+            for(j = 0; j < bm->layers; j++){
+                copy_array(sm->hidden_states[slot][j],bm->hidden_states[j],n);
+                copy_array(sm->cell_states[slot][j],bm->cell_states[j],n);
+            }
+            ff_rmodel_batch_packed(bm);
+        }
+        
+        if(!c){
+            for(t = 0; t < bm->window; t++){
+                for(b = 0; b < sm->batch_size; b++){
+                    copy_array(errors[b][t],&bm->d_out_up[bm->layers-1][(t*sm->batch_size+b)*size],size);
+                }
+            }
+        }
+        else
+            memset(bm->d_out_up[bm->layers-1],0,sizeof(float)*bm->window*n);
+        
+        if(next == NULL)
+            bp_rmodel_batch_packed(bm,NULL,NULL);
+        else
+            bp_rmodel_batch_packed(bm,next->hidden_states_error,next->cell_states_error);
+        next = bm;
+    }
+}
@@ -0,0 +1,37 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef __STREAM_RMODEL_H__
+#define __STREAM_RMODEL_H__
+
+srmodel* stream_rmodel(rmodel* m, int batch_size, int n_chunks, int memory_flag);
+void free_stream_rmodel(srmodel* sm);
+void reset_stream_rmodel(srmodel* sm);
+void reset_stream_rmodel_states(srmodel* sm);
+float* get_stream_rmodel_output(srmodel* sm, int index, int t);
+void ff_stream_rmodel(srmodel* sm, float*** inputs);
+void bp_stream_rmodel(srmodel* sm, float*** errors);
+
+#endif
@@ -0,0 +1,294 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "llab.h"
+
+/* The thread pool keeps its workers alive between the calls, so the multicore functions
+ * don't create and join a thread for each instance of the batch. Each worker owns a queue of tasks,
+ * the submitted tasks are distributed round robin over the queues, a worker takes the last task of its own queue
+ * and when its queue is empty it steals the first task of the queues of the other threads, so a slow task
+ * doesn't stall the others. The thread that calls thread_pool_wait runs the tasks as well, so a pool
+ * of n threads has n-1 workers and a pool of 1 thread runs everything in the calling thread.
+ * A task must not call thread_pool_wait on the same pool, thread_pool_wait waits for all the submitted tasks
+ * */
+
+// the shared pools, one for each number of threads requested, linked by their next field
+thread_pool* shared_thread_pool = NULL;
+pthread_mutex_t shared_thread_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+/* This function creates a thread pool
+ * 
+ * Input:
+ *             @ int threads:= the number of threads of the pool, the calling thread included
+ * 
+ * Output:
+ *             @ thread_pool*:= the pool
+ * */
+thread_pool* thread_pool_init(int threads){
+    if(threads < 1){
+        fprintf(stderr,"Error: a thread pool needs at least 1 thread\n");
+        exit(1);
+    }
+    int i;
+    thread_pool* pool = (thread_pool*)malloc(sizeof(thread_pool));
+    pool->threads = threads;
+    pool->next_queue = 0;
+    pool->shutdown = 0;
+    pool->queued = 0;
+    pool->pending = 0;
+    pthread_mutex_init(&pool->lock,NULL);
+    pthread_cond_init(&pool->work_available,NULL);
+    pthread_cond_init(&pool->work_done,NULL);
+    pool->queues = (thread_pool_queue*)malloc(sizeof(thread_pool_queue)*threads);
+    for(i = 0; i < threads; i++){
+        pthread_mutex_init(&pool->queues[i].lock,NULL);
+        pool->queues[i].size = 16;
+        pool->queues[i].head = 0;
+        pool->queues[i].tail = 0;
+        pool->queues[i].tasks = (thread_pool_task*)malloc(sizeof(thread_pool_task)*pool->queues[i].size);
+    }
+    pool->workers = NULL;
+    pool->workers_args = NULL;
+    pool->next = NULL;
+    if(threads > 1){
+        pool->workers = (pthread_t*)malloc(sizeof(pthread_t)*(threads-1));
+        pool->workers_args = (thread_args_pool*)malloc(sizeof(thread_args_pool)*(threads-1));
+    }
+    for(i = 0; i < threads-1; i++){
+        pool->workers_args[i].pool = pool;
+        pool->workers_args[i].index = i+1;
+        if(pthread_create(&pool->workers[i],NULL,thread_pool_worker,&pool->workers_args[i])){
+            fprintf(stderr,"Error: pthread_create failed\n");
+            exit(1);
+        }
+    }
+    return pool;
+}
+
+/* This function stops the workers of a thread pool and frees the pool,
+ * the tasks still queued are run before the workers stop
+ * 
+ * Input:
+ *             @ thread_pool* pool:= the pool
+ * */
+void free_thread_pool(thread_pool* pool){
+    if(pool == NULL)
+        return;
+    int i;
+    thread_pool_wait(pool);
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->work_available);
+    pthread_mutex_unlock(&pool->lock);
+    for(i = 0; i < pool->threads-1; i++){
+        pthread_join(pool->workers[i],NULL);
+    }
+    for(i = 0; i < pool->threads; i++){
+        pthread_mutex_destroy(&pool->queues[i].lock);
+        free(pool->queues[i].tasks);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_available);
+    pthread_cond_destroy(&pool->work_done);
+    free(pool->queues);
+    free(pool->workers);
+    free(pool->workers_args);
+    free(pool);
+}
+
+/* This function adds a task to a thread pool, the task is run by one of the threads of the pool
+ * 
+ * Input:
+ *             @ thread_pool* pool:= the pool
+ *             @ void* (*function)(void*):= the function of the task
+ *             @ void* args:= the argument passed to function, it must be valid until thread_pool_wait returns
+ * */
+void thread_pool_submit(thread_pool* pool, void* (*function)(void*), void* args){
+    // counted before it can be taken, otherwise a worker could run it and bring pending to 0 while it is still counted nowhere,
+    // waking up the thread_pool_wait of another caller whose tasks are still running
+    __atomic_add_fetch(&pool->pending,1,__ATOMIC_SEQ_CST);
+    pthread_mutex_lock(&pool->lock);
+    thread_pool_queue* q = &pool->queues[pool->next_queue];
+    pool->next_queue = (pool->next_queue+1)%pool->threads;
+    pthread_mutex_unlock(&pool->lock);
+    
+    pthread_mutex_lock(&q->lock);
+    if(q->tail == q->size){
+        if(q->head > 0){
+            memmove(q->tasks,q->tasks+q->head,sizeof(thread_pool_task)*(q->tail-q->head));
+            q->tail -= q->head;
+            q->head = 0;
+        }
+        else{
+            q->size*=2;
+            q->tasks = (thread_pool_task*)realloc(q->tasks,sizeof(thread_pool_task)*q->size);
+        }
+    }
+    q->tasks[q->tail].function = function;
+    q->tasks[q->tail].args = args;
+    __atomic_add_fetch(&pool->queued,1,__ATOMIC_SEQ_CST);
+    q->tail++;
+    pthread_mutex_unlock(&q->lock);
+    
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_signal(&pool->work_available);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/* This function takes a task from the queues of a thread pool: the last task of the queue of the thread
+ * or, if it is empty, the first task of the queue of another thread
+ * 
+ * Input:
+ *             @ thread_pool* pool:= the pool
+ *             @ int index:= the index of the queue of the thread
+ *             @ thread_pool_task* task:= where the task is stored
+ * 
+ * Output:
+ *             @ int:= 1 if a task has been taken, 0 if all the queues are empty
+ * */
+int thread_pool_take_task(thread_pool* pool, int index, thread_pool_task* task){
+    int i,found = 0;
+    thread_pool_queue* q = &pool->queues[index];
+    pthread_mutex_lock(&q->lock);
+    if(q->tail > q->head){
+        q->tail--;
+        task[0] = q->tasks[q->tail];
+        found = 1;
+    }
+    pthread_mutex_unlock(&q->lock);
+    
+    for(i = 1; i < pool->threads && !found; i++){
+        q = &pool->queues[(index+i)%pool->threads];
+        pthread_mutex_lock(&q->lock);
+        if(q->tail > q->head){
+            task[0] = q->tasks[q->head];
+            q->head++;
+            found = 1;
+        }
+        pthread_mutex_unlock(&q->lock);
+    }
+    
+    if(found)
+        __atomic_sub_fetch(&pool->queued,1,__ATOMIC_SEQ_CST);
+    return found;
+}
+
+/* This function runs a task taken from a thread pool and wakes up the thread waiting
+ * in thread_pool_wait if it was the last one
+ * 
+ * Input:
+ *             @ thread_pool* pool:= the pool
+ *             @ thread_pool_task* task:= the task
+ * */
+void thread_pool_run_task(thread_pool* pool, thread_pool_task* task){
+    task->function(task->args);
+    if(__atomic_sub_fetch(&pool->pending,1,__ATOMIC_SEQ_CST) == 0){
+        pthread_mutex_lock(&pool->lock);
+        pthread_cond_broadcast(&pool->work_done);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+/* This function is the loop of a worker of a thread pool
+ * 
+ * Input:
+ *             @ void* _args:= a thread_args_pool*
+ * */
+void* thread_pool_worker(void* _args){
+    thread_args_pool* args = (thread_args_pool*)_args;
+    thread_pool* pool = args->pool;
+    thread_pool_task task;
+    while(1){
+        if(thread_pool_take_task(pool,args->index,&task)){
+            thread_pool_run_task(pool,&task);
+            continue;
+        }
+        pthread_mutex_lock(&pool->lock);
+        while(!pool->shutdown && __atomic_load_n(&pool->queued,__ATOMIC_SEQ_CST) <= 0)
+            pthread_cond_wait(&pool->work_available,&pool->lock);
+        if(pool->shutdown && __atomic_load_n(&pool->queued,__ATOMIC_SEQ_CST) <= 0){
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+/* This function waits until all the tasks submitted to a thread pool are done,
+ * meanwhile the calling thread runs the queued tasks as well
+ * 
+ * Input:
+ *             @ thread_pool* pool:= the pool
+ * */
+void thread_pool_wait(thread_pool* pool){
+    thread_pool_task task;
+    while(__atomic_load_n(&pool->pending,__ATOMIC_SEQ_CST) > 0){
+        if(thread_pool_take_task(pool,0,&task)){
+            thread_pool_run_task(pool,&task);
+            continue;
+        }
+        pthread_mutex_lock(&pool->lock);
+        while(__atomic_load_n(&pool->pending,__ATOMIC_SEQ_CST) > 0 && __atomic_load_n(&pool->queued,__ATOMIC_SEQ_CST) <= 0)
+            pthread_cond_wait(&pool->work_done,&pool->lock);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+/* This function returns the thread pool shared by the multicore functions of the library for a number of threads,
+ * a pool is created the first time its number of threads is requested and it lives until free_shared_thread_pool,
+ * so the callers that ask for different numbers of threads, even at the same time, never free a pool used by another caller
+ * 
+ * Input:
+ *             @ int threads:= the number of threads of the pool
+ * 
+ * Output:
+ *             @ thread_pool*:= the shared pool
+ * */
+thread_pool* get_shared_thread_pool(int threads){
+    thread_pool* pool;
+    pthread_mutex_lock(&shared_thread_pool_lock);
+    for(pool = shared_thread_pool; pool != NULL && pool->threads != threads; pool = pool->next);
+    if(pool == NULL){
+        pool = thread_pool_init(threads);
+        pool->next = shared_thread_pool;
+        shared_thread_pool = pool;
+    }
+    pthread_mutex_unlock(&shared_thread_pool_lock);
+    return pool;
+}
+
+/* This function stops and frees the thread pools shared by the multicore functions, if they exist.
+ * It must not be called while a multicore function is running
+ * */
+void free_shared_thread_pool(){
+    thread_pool* next;
+    pthread_mutex_lock(&shared_thread_pool_lock);
+    while(shared_thread_pool != NULL){
+        next = shared_thread_pool->next;
+        free_thread_pool(shared_thread_pool);
+        shared_thread_pool = next;
+    }
+    pthread_mutex_unlock(&shared_thread_pool_lock);
+}
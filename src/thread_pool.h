@@ -0,0 +1,38 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+thread_pool* thread_pool_init(int threads);
+void free_thread_pool(thread_pool* pool);
+void thread_pool_submit(thread_pool* pool, void* (*function)(void*), void* args);
+int thread_pool_take_task(thread_pool* pool, int index, thread_pool_task* task);
+void thread_pool_run_task(thread_pool* pool, thread_pool_task* task);
+void* thread_pool_worker(void* _args);
+void thread_pool_wait(thread_pool* pool);
+thread_pool* get_shared_thread_pool(int threads);
+void free_shared_thread_pool();
+
+#endif
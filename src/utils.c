@@ -896,7 +896,7 @@ void sum_residual_layers_partial_derivatives(model* m, model* m2, model* m3){
     int i,j,k,u,z,w;
     for(i = 0; i < m->n_rl; i++){
         for(j = 0; j < m->rls[i]->n_cl; j++){
-            if(m->rls[i]->cls[j]->convolutional_flag == CONVOLUTION){
+            if(m->rls[i]->cls[j]->convolutional_flag == CONVOLUTION || m->rls[i]->cls[j]->convolutional_flag == TRANSPOSED_CONVOLUTION){
                 for(k = 0; k < m->rls[i]->cls[j]->n_kernels; k++){
                     sum1D(m->rls[i]->cls[j]->d_kernels[k],m2->rls[i]->cls[j]->d_kernels[k],m3->rls[i]->cls[j]->d_kernels[k],m3->rls[i]->cls[j]->channels*m3->rls[i]->cls[j]->kernel_rows*m3->rls[i]->cls[j]->kernel_cols);
                 }
@@ -906,7 +906,7 @@ void sum_residual_layers_partial_derivatives(model* m, model* m2, model* m3){
 
                 if(m->rls[i]->cls[j]->normalization_flag == GROUP_NORMALIZATION){
                     for(k = 0; k < m->rls[i]->cls[j]->n_kernels/m->rls[i]->cls[j]->group_norm_channels; k++){
-                        sum1D(m->rls[i]->cls[j]->group_norm[k]->d_beta,m2->rls[i]->cls[j]->group_norm[k]->d_beta,m3->rls[i]->cls[j]->group_norm[k]->d_beta,m3->rls[i]->cls[j]->group_norm[k]->vector_dim);
+                        sum1D(m->rls[i]->cls[j]->group_norm[k]->d_gamma,m2->rls[i]->cls[j]->group_norm[k]->d_gamma,m3->rls[i]->cls[j]->group_norm[k]->d_gamma,m3->rls[i]->cls[j]->group_norm[k]->vector_dim);
                         sum1D(m->rls[i]->cls[j]->group_norm[k]->d_beta,m2->rls[i]->cls[j]->group_norm[k]->d_beta,m3->rls[i]->cls[j]->group_norm[k]->d_beta,m3->rls[i]->cls[j]->group_norm[k]->vector_dim);
                     }
                 }
@@ -1177,7 +1177,7 @@ void sum_convolutional_layers_partial_derivatives(model* m, model* m2, model* m3
     }
     int j,k,u,z,w;
     for(j = 0; j < m->n_cl; j++){
-        if(m->cls[j]->convolutional_flag == CONVOLUTION){
+        if(m->cls[j]->convolutional_flag == CONVOLUTION || m->cls[j]->convolutional_flag == TRANSPOSED_CONVOLUTION){
             for(k = 0; k < m->cls[j]->n_kernels; k++){
                 sum1D(m->cls[j]->d_kernels[k],m2->cls[j]->d_kernels[k],m3->cls[j]->d_kernels[k],m3->cls[j]->channels*m3->cls[j]->kernel_rows*m3->cls[j]->kernel_cols);
             }
@@ -1187,7 +1187,7 @@ void sum_convolutional_layers_partial_derivatives(model* m, model* m2, model* m3
 
             if(m->cls[j]->normalization_flag == GROUP_NORMALIZATION){
                 for(k = 0; k < m->cls[j]->n_kernels/m->cls[j]->group_norm_channels; k++){
-                    sum1D(m->cls[j]->group_norm[k]->d_beta,m2->cls[j]->group_norm[k]->d_beta,m3->cls[j]->group_norm[k]->d_beta,m3->cls[j]->group_norm[k]->vector_dim);
+                    sum1D(m->cls[j]->group_norm[k]->d_gamma,m2->cls[j]->group_norm[k]->d_gamma,m3->cls[j]->group_norm[k]->d_gamma,m3->cls[j]->group_norm[k]->vector_dim);
                     sum1D(m->cls[j]->group_norm[k]->d_beta,m2->cls[j]->group_norm[k]->d_beta,m3->cls[j]->group_norm[k]->d_beta,m3->cls[j]->group_norm[k]->vector_dim);
                 }
             }
@@ -1484,8 +1484,10 @@ void sum_fully_connected_layers_partial_derivatives(model* m, model* m2, model*
         sum1D(m->fcls[i]->d_weights,m2->fcls[i]->d_weights,m3->fcls[i]->d_weights,m->fcls[i]->input*m->fcls[i]->output);    
         sum1D(m->fcls[i]->d_biases,m2->fcls[i]->d_biases,m3->fcls[i]->d_biases,m->fcls[i]->output);    
         sum1D(m->fcls[i]->d_scores,m2->fcls[i]->d_scores,m3->fcls[i]->d_scores,m->fcls[i]->output*m->fcls[i]->input);    
-        if(m->fcls[i]->normalization_flag == LAYER_NORMALIZATION)
+        if(m->fcls[i]->normalization_flag == LAYER_NORMALIZATION){
             sum1D(m->fcls[i]->layer_norm->d_gamma,m2->fcls[i]->layer_norm->d_gamma,m3->fcls[i]->layer_norm->d_gamma,m->fcls[i]->layer_norm->vector_dim);
+            sum1D(m->fcls[i]->layer_norm->d_beta,m2->fcls[i]->layer_norm->d_beta,m3->fcls[i]->layer_norm->d_beta,m->fcls[i]->layer_norm->vector_dim);
+        }
     }
     
         
@@ -1603,7 +1605,7 @@ void add_l2_fully_connected_layer(model* m,int total_number_weights,float lambda
 void add_l2_lstm_layer(rmodel* m,int total_number_weights,float lambda){
     int j,k,u,z,w;
     for(j = 0; j < m->n_lstm; j++){
-        for(k = 0; k < 4; k++){
+        for(k = 0; k < m->lstms[j]->n_gates; k++){
             for(u = 0; u < m->lstms[j]->size*m->lstms[j]->size; u++){
                 ridge_regression(&m->lstms[j]->d_w[k][u],m->lstms[j]->w[k][u],lambda,total_number_weights);
                 ridge_regression(&m->lstms[j]->d_u[k][u],m->lstms[j]->u[k][u],lambda,total_number_weights);
@@ -1626,7 +1628,7 @@ void add_l2_lstm_layer(rmodel* m,int total_number_weights,float lambda){
 void update_lstm_layer_nesterov(rmodel* m, float lr, float momentum, int mini_batch_size){
     int i,j,k;
     for(i = 0; i < m->n_lstm; i++){
-        for(j = 0; j < 4; j++){
+        for(j = 0; j < m->lstms[i]->n_gates; j++){
             for(k = 0; k < m->lstms[i]->size*m->lstms[i]->size; k++){
                 nesterov_momentum(&m->lstms[i]->w[j][k],lr,momentum,mini_batch_size,m->lstms[i]->d_w[j][k],&m->lstms[i]->d1_w[j][k]);
                 nesterov_momentum(&m->lstms[i]->u[j][k],lr,momentum,mini_batch_size,m->lstms[i]->d_u[j][k],&m->lstms[i]->d1_u[j][k]);
@@ -1650,7 +1652,7 @@ void update_lstm_layer_nesterov(rmodel* m, float lr, float momentum, int mini_ba
 void update_lstm_layer_adam_diff_grad(rmodel* m,float lr,int mini_batch_size,float b1, float b2, float beta1_adam, float beta2_adam){
     int i,j,k;
     for(i = 0; i < m->n_lstm; i++){
-        for(j = 0; j < 4; j++){
+        for(j = 0; j < m->lstms[i]->n_gates; j++){
             for(k = 0; k < m->lstms[i]->size*m->lstms[i]->size; k++){
                 adam_diff_grad_algorithm(&m->lstms[i]->w[j][k],&m->lstms[i]->d1_w[j][k],&m->lstms[i]->d2_w[j][k],m->lstms[i]->d_w[j][k],lr,beta1_adam,beta2_adam,b1,b2,EPSILON_ADAM,mini_batch_size,&m->lstms[i]->ex_d_w_diff_grad[j][k]);
                 adam_diff_grad_algorithm(&m->lstms[i]->u[j][k],&m->lstms[i]->d1_u[j][k],&m->lstms[i]->d2_u[j][k],m->lstms[i]->d_u[j][k],lr,beta1_adam,beta2_adam,b1,b2,EPSILON_ADAM,mini_batch_size,&m->lstms[i]->ex_d_u_diff_grad[j][k]);
@@ -1674,7 +1676,7 @@ void update_lstm_layer_adam_diff_grad(rmodel* m,float lr,int mini_batch_size,flo
 void update_lstm_layer_adam(rmodel* m,float lr,int mini_batch_size,float b1, float b2, float beta1_adam, float beta2_adam){
     int i,j,k;
     for(i = 0; i < m->n_lstm; i++){
-        for(j = 0; j < 4; j++){
+        for(j = 0; j < m->lstms[i]->n_gates; j++){
             for(k = 0; k < m->lstms[i]->size*m->lstms[i]->size; k++){
                 adam_algorithm(&m->lstms[i]->w[j][k],&m->lstms[i]->d1_w[j][k],&m->lstms[i]->d2_w[j][k],m->lstms[i]->d_w[j][k],lr,beta1_adam,beta2_adam,b1,b2,EPSILON_ADAM,mini_batch_size);
                 adam_algorithm(&m->lstms[i]->u[j][k],&m->lstms[i]->d1_u[j][k],&m->lstms[i]->d2_u[j][k],m->lstms[i]->d_u[j][k],lr,beta1_adam,beta2_adam,b1,b2,EPSILON_ADAM,mini_batch_size);
@@ -1698,7 +1700,7 @@ void update_lstm_layer_adam(rmodel* m,float lr,int mini_batch_size,float b1, flo
 void update_lstm_layer_adamod(rmodel* m,float lr,int mini_batch_size,float b1, float b2, float beta1_adam, float beta2_adam, float beta3_adamod){
     int i,j,k;
     for(i = 0; i < m->n_lstm; i++){
-        for(j = 0; j < 4; j++){
+        for(j = 0; j < m->lstms[i]->n_gates; j++){
             for(k = 0; k < m->lstms[i]->size*m->lstms[i]->size; k++){
                 adamod(&m->lstms[i]->w[j][k],&m->lstms[i]->d1_w[j][k],&m->lstms[i]->d2_w[j][k],m->lstms[i]->d_w[j][k],lr,beta1_adam,beta2_adam,b1,b2,EPSILON_ADAM,mini_batch_size,beta3_adamod,&m->lstms[i]->d3_w[j][k]);
                 adamod(&m->lstms[i]->u[j][k],&m->lstms[i]->d1_u[j][k],&m->lstms[i]->d2_u[j][k],m->lstms[i]->d_u[j][k],lr,beta1_adam,beta2_adam,b1,b2,EPSILON_ADAM,mini_batch_size,beta3_adamod,&m->lstms[i]->d3_u[j][k]);
@@ -1721,7 +1723,7 @@ void update_lstm_layer_adamod(rmodel* m,float lr,int mini_batch_size,float b1, f
 void update_lstm_layer_radam(rmodel* m,float lr,int mini_batch_size,float b1, float b2, unsigned long long int t, float beta1_adam, float beta2_adam){
     int i,j,k;
     for(i = 0; i < m->n_lstm; i++){
-        for(j = 0; j < 4; j++){
+        for(j = 0; j < m->lstms[i]->n_gates; j++){
             for(k = 0; k < m->lstms[i]->size*m->lstms[i]->size; k++){
                 radam_algorithm(&m->lstms[i]->w[j][k],&m->lstms[i]->d1_w[j][k],&m->lstms[i]->d2_w[j][k],m->lstms[i]->d_w[j][k],lr,beta1_adam,beta2_adam,b1,b2,EPSILON_ADAM,mini_batch_size,t);
                 radam_algorithm(&m->lstms[i]->u[j][k],&m->lstms[i]->d1_u[j][k],&m->lstms[i]->d2_u[j][k],m->lstms[i]->d_u[j][k],lr,beta1_adam,beta2_adam,b1,b2,EPSILON_ADAM,mini_batch_size,t);
@@ -1749,7 +1751,7 @@ void sum_lstm_layers_partial_derivatives(rmodel* m, rmodel* m2, rmodel* m3){
     }
     int i,j;
     for(i = 0; i < m->n_lstm; i++){
-        for(j = 0; j < 4; j++){
+        for(j = 0; j < m->lstms[i]->n_gates; j++){
             sum1D(m->lstms[i]->d_w[j],m2->lstms[i]->d_w[j],m3->lstms[i]->d_w[j],m->lstms[i]->size*m->lstms[i]->size);
             sum1D(m->lstms[i]->d_u[j],m2->lstms[i]->d_u[j],m3->lstms[i]->d_u[j],m->lstms[i]->size*m->lstms[i]->size);
             sum1D(m->lstms[i]->d_biases[j],m2->lstms[i]->d_biases[j],m3->lstms[i]->d_biases[j],m->lstms[i]->size);
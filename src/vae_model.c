@@ -133,6 +133,43 @@ void reset_vae_model(vaemodel* vm){
     }
 }
 
+/* This function resets a vaemodel like reset_vae_model, except for the partial derivatives
+ * of the layers of encoder and decoder that are left untouched
+ * */
+void reset_vae_model_except_partial_derivatives(vaemodel* vm){
+    if(vm == NULL)
+        return;
+    int i;
+    reset_model_except_partial_derivatives(vm->encoder);
+    reset_model_except_partial_derivatives(vm->decoder);
+    for(i = 0; i < vm->latent_size; i++){
+        vm->dstd[i] = 0;
+        vm->dmean[i] = 0;
+        vm->z[i] = 0;
+        vm->input[i] = 0;
+    }
+}
+
+/* this function stores the arrays of the partial derivatives of a vaemodel that are summed over a batch,
+ * the ones of the encoder followed by the ones of the decoder
+ * 
+ * Inputs:
+ * 
+ * 
+ *                 @ vaemodel* vm:= the vae model
+ *                 @ float** segments:= where the arrays are stored, if NULL the arrays are only counted
+ *                 @ int* sizes:= where the sizes of the arrays are stored
+ * 
+ * Output:
+ *                 @ int:= the number of arrays
+ * */
+int get_partial_derivatives_segments_vae_model(vaemodel* vm, float** segments, int* sizes){
+    if(segments == NULL)
+        return get_partial_derivatives_segments_model(vm->encoder,NULL,NULL)+get_partial_derivatives_segments_model(vm->decoder,NULL,NULL);
+    int n = get_partial_derivatives_segments_model(vm->encoder,segments,sizes);
+    return n+get_partial_derivatives_segments_model(vm->decoder,&segments[n],&sizes[n]);
+}
+
 /* this function computes the space allocated by this structure
  * 
  * */
@@ -31,6 +31,8 @@ vaemodel* copy_vae_model(vaemodel* vm);
 void paste_vae_model(vaemodel* vm1, vaemodel* vm2);
 void slow_paste_vae_model(vaemodel* vm1, vaemodel* vm2, float tau);
 void reset_vae_model(vaemodel* vm);
+void reset_vae_model_except_partial_derivatives(vaemodel* vm);
+int get_partial_derivatives_segments_vae_model(vaemodel* vm, float** segments, int* sizes);
 unsigned long long int size_of_vae_model(vaemodel* vm);
 void save_vae_model(vaemodel* vm, int n, int m);
 vaemodel* load_vae_model(char* file1, char* file2);
@@ -0,0 +1,520 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "llab.h"
+
+/* Transformation matrices of F(2x2,3x3) and F(4x4,3x3) (Lavin and Gray, Fast Algorithms for Convolutional Neural Networks).
+ * For a tile of m*m outputs: Y = AT*[(G*g*GT) . (BT*d*B)]*A where g is a 3*3 kernel and d a (m+2)*(m+2) input tile*/
+
+const float winograd_f2_bt[16] = {1,0,-1,0,
+                                  0,1,1,0,
+                                  0,-1,1,0,
+                                  0,1,0,-1};
+const float winograd_f2_g[12] = {1,0,0,
+                                 0.5,0.5,0.5,
+                                 0.5,-0.5,0.5,
+                                 0,0,1};
+const float winograd_f2_at[8] = {1,1,1,0,
+                                 0,1,-1,-1};
+
+const float winograd_f4_bt[36] = {4,0,-5,0,1,0,
+                                  0,-4,-4,1,1,0,
+                                  0,4,-4,-1,1,0,
+                                  0,-2,-1,2,1,0,
+                                  0,2,-1,-2,1,0,
+                                  0,4,0,-5,0,1};
+const float winograd_f4_g[18] = {1.0/4,0,0,
+                                 -1.0/6,-1.0/6,-1.0/6,
+                                 -1.0/6,1.0/6,-1.0/6,
+                                 1.0/24,1.0/12,1.0/6,
+                                 1.0/24,-1.0/12,1.0/6,
+                                 0,0,1};
+const float winograd_f4_at[24] = {1,1,1,1,1,0,
+                                  0,1,-1,2,-2,0,
+                                  0,1,1,4,4,0,
+                                  0,1,-1,8,-8,1};
+
+/* This function returns the size of the output tiles used by the winograd convolution of a layer,
+ * F(4x4,3x3) does less multiplications but it is less accurate, so it is used only when the output is big enough
+ * 
+ * Input:
+ *             @ int output_i:= the rows of the output without padding
+ *             @ int output_j:= the columns of the output without padding
+ * */
+int winograd_tile_size(int output_i, int output_j){
+    if(output_i >= 8 && output_j >= 8)
+        return 4;
+    return 2;
+}
+
+/* This function returns the number of floats of the transformed kernels of a layer (for the feed forward or the back propagation)
+ * 
+ * Input:
+ *             @ int n_kernels:= the number of kernels
+ *             @ int channels:= the channels of each kernel
+ *             @ int m:= the tile size, 2 or 4
+ * */
+int winograd_kernels_size(int n_kernels, int channels, int m){
+    return (m+2)*(m+2)*n_kernels*channels;
+}
+
+/* This function returns the number of floats of the workspace used by convolutional_feed_forward_winograd and convolutional_back_prop_winograd
+ * 
+ * Input:
+ *             @ int channels:= the depth of the input
+ *             @ int input_i:= the rows of the input
+ *             @ int input_j:= the columns of the input
+ *             @ int n_kernels:= the number of kernels
+ *             @ int m:= the tile size, 2 or 4
+ * */
+int winograd_workspace_size(int channels, int input_i, int input_j, int n_kernels, int m){
+    int a2 = (m+2)*(m+2);
+    int tiles = ((input_i-2+m-1)/m)*((input_j-2+m-1)/m);
+    int tiles_bp = ((input_i+m-1)/m)*((input_j+m-1)/m);
+    return n_kernels*(input_i+2)*(input_j+2) + a2*tiles_bp*(n_kernels+channels) + a2*(tiles*channels+n_kernels*tiles+n_kernels*channels);
+}
+
+/* This function sets the transformation matrices of F(mxm,3x3)
+ * 
+ * Input:
+ *             @ int m:= the tile size, 2 or 4
+ *             @ float** bt:= where the pointer to BT is stored, dimensions: (m+2)*(m+2)
+ *             @ float** g:= where the pointer to G is stored, dimensions: (m+2)*3
+ *             @ float** at:= where the pointer to AT is stored, dimensions: m*(m+2)
+ * */
+void winograd_matrices(int m, float** bt, float** g, float** at){
+    if(m == 2){
+        (*bt) = (float*)winograd_f2_bt;
+        (*g) = (float*)winograd_f2_g;
+        (*at) = (float*)winograd_f2_at;
+    }
+    else if(m == 4){
+        (*bt) = (float*)winograd_f4_bt;
+        (*g) = (float*)winograd_f4_g;
+        (*at) = (float*)winograd_f4_at;
+    }
+    else{
+        fprintf(stderr,"Error: the winograd tile size must be 2 or 4\n");
+        exit(1);
+    }
+}
+
+/* This function computes BT*d on a column (or a row) of an input tile
+ * 
+ * Input:
+ *             @ int m:= the tile size, 2 or 4
+ *             @ float* d:= the m+2 values of the tile
+ *             @ int d_stride:= the distance between two values of d
+ *             @ float* r:= the m+2 transformed values
+ *             @ int r_stride:= the distance between two values of r
+ * */
+void winograd_input_transform_1d(int m, float* d, int d_stride, float* r, int r_stride){
+    float d0 = d[0], d1 = d[d_stride], d2 = d[2*d_stride], d3 = d[3*d_stride];
+    if(m == 2){
+        r[0] = d0-d2;
+        r[r_stride] = d1+d2;
+        r[2*r_stride] = d2-d1;
+        r[3*r_stride] = d1-d3;
+        return;
+    }
+    float d4 = d[4*d_stride], d5 = d[5*d_stride];
+    r[0] = 4*d0-5*d2+d4;
+    r[r_stride] = d3+d4-4*(d1+d2);
+    r[2*r_stride] = d4-d3+4*(d1-d2);
+    r[3*r_stride] = d4-d2+2*(d3-d1);
+    r[4*r_stride] = d4-d2+2*(d1-d3);
+    r[5*r_stride] = 4*d1-5*d3+d5;
+}
+
+/* This function computes AT*M on a column (or a row) of a tile of products
+ * 
+ * Input:
+ *             @ int m:= the tile size, 2 or 4
+ *             @ float* x:= the m+2 values of the tile
+ *             @ int x_stride:= the distance between two values of x
+ *             @ float* y:= the m transformed values
+ *             @ int y_stride:= the distance between two values of y
+ * */
+void winograd_output_transform_1d(int m, float* x, int x_stride, float* y, int y_stride){
+    float x0 = x[0], x1 = x[x_stride], x2 = x[2*x_stride], x3 = x[3*x_stride];
+    if(m == 2){
+        y[0] = x0+x1+x2;
+        y[y_stride] = x1-x2-x3;
+        return;
+    }
+    float x4 = x[4*x_stride], x5 = x[5*x_stride];
+    y[0] = x0+x1+x2+x3+x4;
+    y[y_stride] = x1-x2+2*(x3-x4);
+    y[2*y_stride] = x1+x2+4*(x3+x4);
+    y[3*y_stride] = x1-x2+8*(x3-x4)+x5;
+}
+
+/* This function computes A*dY on a column (or a row) of a tile of output errors, it is the transpose of winograd_output_transform_1d
+ * 
+ * Input:
+ *             @ int m:= the tile size, 2 or 4
+ *             @ float* y:= the m values of the tile
+ *             @ int y_stride:= the distance between two values of y
+ *             @ float* x:= the m+2 transformed values
+ *             @ int x_stride:= the distance between two values of x
+ * */
+void winograd_output_transform_1d_transposed(int m, float* y, int y_stride, float* x, int x_stride){
+    float y0 = y[0], y1 = y[y_stride];
+    if(m == 2){
+        x[0] = y0;
+        x[x_stride] = y0+y1;
+        x[2*x_stride] = y0-y1;
+        x[3*x_stride] = -y1;
+        return;
+    }
+    float y2 = y[2*y_stride], y3 = y[3*y_stride];
+    x[0] = y0;
+    x[x_stride] = y0+y1+y2+y3;
+    x[2*x_stride] = y0-y1+y2-y3;
+    x[3*x_stride] = y0+2*y1+4*y2+8*y3;
+    x[4*x_stride] = y0-2*y1+4*y2-8*y3;
+    x[5*x_stride] = y3;
+}
+
+/* This function computes G*g on a column (or a row) of a 3*3 kernel
+ * 
+ * Input:
+ *             @ int m:= the tile size, 2 or 4
+ *             @ float* w:= the 3 values of the kernel
+ *             @ int w_stride:= the distance between two values of w
+ *             @ float* u:= the m+2 transformed values
+ *             @ int u_stride:= the distance between two values of u
+ * */
+void winograd_kernel_transform_1d(int m, float* w, int w_stride, float* u, int u_stride){
+    float w0 = w[0], w1 = w[w_stride], w2 = w[2*w_stride];
+    if(m == 2){
+        u[0] = w0;
+        u[u_stride] = 0.5*(w0+w1+w2);
+        u[2*u_stride] = 0.5*(w0-w1+w2);
+        u[3*u_stride] = w2;
+        return;
+    }
+    u[0] = w0/4;
+    u[u_stride] = -(w0+w1+w2)/6;
+    u[2*u_stride] = -(w0-w1+w2)/6;
+    u[3*u_stride] = w0/24+w1/12+w2/6;
+    u[4*u_stride] = w0/24-w1/12+w2/6;
+    u[5*u_stride] = w2;
+}
+
+/* This function computes GT*dU on a column (or a row) of the errors of a transformed kernel, it is the transpose of winograd_kernel_transform_1d
+ * 
+ * Input:
+ *             @ int m:= the tile size, 2 or 4
+ *             @ float* u:= the m+2 values of the transformed errors
+ *             @ int u_stride:= the distance between two values of u
+ *             @ float* w:= the 3 errors of the kernel
+ *             @ int w_stride:= the distance between two values of w
+ * */
+void winograd_kernel_transform_1d_transposed(int m, float* u, int u_stride, float* w, int w_stride){
+    float u0 = u[0], u1 = u[u_stride], u2 = u[2*u_stride], u3 = u[3*u_stride];
+    if(m == 2){
+        w[0] = u0+0.5*(u1+u2);
+        w[w_stride] = 0.5*(u1-u2);
+        w[2*w_stride] = 0.5*(u1+u2)+u3;
+        return;
+    }
+    float u4 = u[4*u_stride], u5 = u[5*u_stride];
+    w[0] = u0/4-(u1+u2)/6+(u3+u4)/24;
+    w[w_stride] = (u2-u1)/6+(u3-u4)/12;
+    w[2*w_stride] = (u3+u4)/6-(u1+u2)/6+u5;
+}
+
+/* This function transforms the 3*3 kernels of a layer: U = G*g*GT
+ * 
+ * Input:
+ *             @ float** kernel:= the kernels, dimensions: n_kernels*channels*3*3
+ *             @ int n_kernels:= the number of kernels
+ *             @ int channels:= the channels of each kernel
+ *             @ int m:= the tile size, 2 or 4
+ *             @ int flip:= 0 for the feed forward, 1 for the error of the input: the kernel of channel c and output k is
+ *                          the kernel k of channel c rotated by 180 degrees
+ *             @ float* u:= the transformed kernels, dimensions: (m+2)*(m+2)*n_out*n_in,
+ *                          n_out = n_kernels, n_in = channels if flip = 0 else n_out = channels, n_in = n_kernels
+ * */
+void winograd_kernel_transform(float** kernel, int n_kernels, int channels, int m, int flip, float* u){
+    int k,c,i,a = m+2;
+    int n_out = flip ? channels : n_kernels;
+    int n_in = flip ? n_kernels : channels;
+    float w[9];
+    float tmp[18];
+    for(k = 0; k < n_kernels; k++){
+        for(c = 0; c < channels; c++){
+            for(i = 0; i < 9; i++){
+                w[i] = flip ? kernel[k][c*9+8-i] : kernel[k][c*9+i];
+            }
+            for(i = 0; i < 3; i++){
+                winograd_kernel_transform_1d(m,w+i,3,tmp+i,3);
+            }
+            for(i = 0; i < a; i++){
+                if(flip)
+                    winograd_kernel_transform_1d(m,tmp+i*3,1,&u[i*a*n_out*n_in + c*n_in + k],n_out*n_in);
+                else
+                    winograd_kernel_transform_1d(m,tmp+i*3,1,&u[i*a*n_out*n_in + k*n_in + c],n_out*n_in);
+            }
+        }
+    }
+}
+
+/* This function transforms the input tiles: V = BT*d*B, the tiles start every m rows and columns
+ * and the values outside the input are 0
+ * 
+ * Input:
+ *             @ float* input:= the input, dimensions: channels*input_i*input_j
+ *             @ int channels:= the depth of the input
+ *             @ int input_i:= the rows of the input
+ *             @ int input_j:= the columns of the input
+ *             @ int m:= the tile size, 2 or 4
+ *             @ int tiles_i:= the number of tiles along the rows
+ *             @ int tiles_j:= the number of tiles along the columns
+ *             @ int transposed:= 0 to store v as (m+2)*(m+2)*channels*(tiles_i*tiles_j), 1 as (m+2)*(m+2)*(tiles_i*tiles_j)*channels
+ *             @ float* v:= the transformed tiles, dimensions: (m+2)*(m+2)*channels*(tiles_i*tiles_j)
+ * */
+void winograd_input_transform(float* input, int channels, int input_i, int input_j, int m, int tiles_i, int tiles_j, int transposed, float* v){
+    int c,ti,tj,i,j,a = m+2,tiles = tiles_i*tiles_j;
+    float d[36];
+    float tmp[36];
+    float* x;
+    for(c = 0; c < channels; c++){
+        for(ti = 0; ti < tiles_i; ti++){
+            for(tj = 0; tj < tiles_j; tj++){
+                x = &input[c*input_i*input_j + ti*m*input_j + tj*m];
+                if(ti*m+a <= input_i && tj*m+a <= input_j){
+                    for(j = 0; j < a; j++){
+                        winograd_input_transform_1d(m,x+j,input_j,tmp+j,a);
+                    }
+                }
+                else{
+                    for(i = 0; i < a; i++){
+                        for(j = 0; j < a; j++){
+                            if(ti*m+i < input_i && tj*m+j < input_j)
+                                d[i*a+j] = x[i*input_j+j];
+                            else
+                                d[i*a+j] = 0;
+                        }
+                    }
+                    for(j = 0; j < a; j++){
+                        winograd_input_transform_1d(m,d+j,a,tmp+j,a);
+                    }
+                }
+                for(i = 0; i < a; i++){
+                    if(transposed)
+                        winograd_input_transform_1d(m,tmp+i*a,1,&v[i*a*channels*tiles + (ti*tiles_j+tj)*channels + c],channels*tiles);
+                    else
+                        winograd_input_transform_1d(m,tmp+i*a,1,&v[i*a*channels*tiles + c*tiles + ti*tiles_j+tj],channels*tiles);
+                }
+            }
+        }
+    }
+}
+
+/* This function transforms back the products of the tiles: Y = AT*M*A and sums the outputs inside
+ * output_i*output_j to the output
+ * 
+ * Input:
+ *             @ float* mm:= the products, dimensions: (m+2)*(m+2)*n_out*(tiles_i*tiles_j)
+ *             @ int n_out:= the number of feature maps of the output
+ *             @ int m:= the tile size, 2 or 4
+ *             @ int tiles_i:= the number of tiles along the rows
+ *             @ int tiles_j:= the number of tiles along the columns
+ *             @ float* output:= the output, dimensions: n_out*(output_i+2*padding)*(output_j+2*padding)
+ *             @ int output_i:= the rows of the output without padding
+ *             @ int output_j:= the columns of the output without padding
+ *             @ int padding:= the padding of the output
+ * */
+void winograd_output_transform(float* mm, int n_out, int m, int tiles_i, int tiles_j, float* output, int output_i, int output_j, int padding){
+    int k,ti,tj,i,j,a = m+2,tiles = tiles_i*tiles_j;
+    int rows = output_i+2*padding, cols = output_j+2*padding;
+    float tmp[24];
+    float y[16];
+    for(k = 0; k < n_out; k++){
+        for(ti = 0; ti < tiles_i; ti++){
+            for(tj = 0; tj < tiles_j; tj++){
+                for(j = 0; j < a; j++){
+                    winograd_output_transform_1d(m,&mm[j*n_out*tiles + k*tiles + ti*tiles_j+tj],a*n_out*tiles,tmp+j,a);
+                }
+                for(i = 0; i < m; i++){
+                    winograd_output_transform_1d(m,tmp+i*a,1,y+i*m,1);
+                }
+                for(i = 0; i < m && ti*m+i < output_i; i++){
+                    for(j = 0; j < m && tj*m+j < output_j; j++){
+                        output[k*rows*cols + (ti*m+i+padding)*cols + tj*m+j+padding] += y[i*m+j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* This function computes a 3*3 convolution with stride 1 of the input with winograd: the input tiles are transformed,
+ * for each of the (m+2)*(m+2) positions of the tiles the products between kernels and tiles are a matrix multiplication,
+ * and the products are transformed back and summed to the output
+ * 
+ * Input:
+ *             @ float* input:= the input, dimensions: n_in*input_i*input_j
+ *             @ float* u:= the transformed kernels, dimensions: (m+2)*(m+2)*n_out*n_in
+ *             @ int n_out:= the number of feature maps of the output
+ *             @ int n_in:= the number of channels of the input
+ *             @ int input_i:= the rows of the input
+ *             @ int input_j:= the columns of the input
+ *             @ int m:= the tile size, 2 or 4
+ *             @ float* output:= the output, dimensions: n_out*(input_i-2+2*padding)*(input_j-2+2*padding)
+ *             @ int padding:= the padding of the output
+ *             @ float* workspace:= dimensions: (m+2)*(m+2)*tiles*(n_in+n_out)
+ * */
+void winograd_convolution(float* input, float* u, int n_out, int n_in, int input_i, int input_j, int m, float* output, int padding, float* workspace){
+    int x,a2 = (m+2)*(m+2);
+    int tiles_i = (input_i-2+m-1)/m, tiles_j = (input_j-2+m-1)/m, tiles = tiles_i*tiles_j;
+    float* v = workspace;
+    float* mm = v + a2*tiles*n_in;
+    winograd_input_transform(input,n_in,input_i,input_j,m,tiles_i,tiles_j,0,v);
+    memset(mm,0,sizeof(float)*a2*n_out*tiles);
+    for(x = 0; x < a2; x++){
+        sgemm_nn(n_out,tiles,n_in,&u[x*n_out*n_in],n_in,&v[x*n_in*tiles],tiles,&mm[x*n_out*tiles],tiles);
+    }
+    winograd_output_transform(mm,n_out,m,tiles_i,tiles_j,output,input_i-2,input_j-2,padding);
+}
+
+/* This function computes the feed forward of all the 3*3 kernels with stride 1 of a convolutional layer with winograd,
+ * the output has the same padding of convolutional_feed_forward
+ * 
+ * Input:
+ *             @ float* input:= the input, dimensions: channels*input_i*input_j
+ *             @ float* u:= the kernels transformed by winograd_kernel_transform with flip = 0
+ *             @ int n_kernels:= the number of kernels
+ *             @ int input_i:= the rows of the input
+ *             @ int input_j:= the columns of the input
+ *             @ float* bias:= the biases, dimensions: n_kernels
+ *             @ int channels:= the depth of the input
+ *             @ float* output:= the output, dimensions: n_kernels*(input_i-2+2*padding)*(input_j-2+2*padding)
+ *             @ int padding:= the padding of the output
+ *             @ int m:= the tile size, 2 or 4
+ *             @ float* workspace:= a buffer of winograd_workspace_size(channels,input_i,input_j,n_kernels,m) floats
+ * */
+void convolutional_feed_forward_winograd(float* input, float* u, int n_kernels, int input_i, int input_j, float* bias, int channels, float* output, int padding, int m, float* workspace){
+    int k,i,j;
+    int output_i = input_i-2, output_j = input_j-2;
+    int rows = output_i+2*padding, cols = output_j+2*padding;
+    winograd_convolution(input,u,n_kernels,channels,input_i,input_j,m,output,padding,workspace);
+    for(k = 0; k < n_kernels; k++){
+        for(i = padding; i < rows-padding; i++){
+            for(j = padding; j < cols-padding; j++){
+                output[k*rows*cols + i*cols + j] += bias[k];
+            }
+        }
+    }
+}
+
+/* This function computes the back propagation of all the 3*3 kernels with stride 1 of a convolutional layer with winograd.
+ * The error of the input is the convolution of the output error padded with 2 zeros and the kernels rotated by 180 degrees,
+ * the error of the kernels is computed in the winograd domain: dU = (A*dY*AT) . (BT*d*B), dg = GT*dU*G
+ * 
+ * Input:
+ *             @ float* input:= the input, dimensions: channels*input_i*input_j
+ *             @ float* u_bp:= the kernels transformed by winograd_kernel_transform with flip = 1
+ *             @ int n_kernels:= the number of kernels
+ *             @ int input_i:= the rows of the input
+ *             @ int input_j:= the columns of the input
+ *             @ int channels:= the depth of the input
+ *             @ float* output_error:= the error of the output, dimensions: n_kernels*(input_i-2+2*padding)*(input_j-2+2*padding)
+ *             @ float* input_error:= the error of the input, dimensions: channels*input_i*input_j
+ *             @ float** kernel_error:= the errors of the kernels, dimensions: n_kernels*channels*3*3
+ *             @ float* bias_error:= the errors of the biases, dimensions: n_kernels
+ *             @ int padding:= the padding of the output
+ *             @ int m:= the tile size, 2 or 4
+ *             @ float* workspace:= a buffer of winograd_workspace_size(channels,input_i,input_j,n_kernels,m) floats
+ * */
+void convolutional_back_prop_winograd(float* input, float* u_bp, int n_kernels, int input_i, int input_j, int channels, float* output_error, float* input_error, float** kernel_error, float* bias_error, int padding, int m, float* workspace){
+    int k,c,i,j,x,ti,tj,a = m+2,a2 = (m+2)*(m+2);
+    int output_i = input_i-2, output_j = input_j-2;
+    int rows = output_i+2*padding, cols = output_j+2*padding;
+    int tiles_i = (output_i+m-1)/m, tiles_j = (output_j+m-1)/m, tiles = tiles_i*tiles_j;
+    int tiles_bp = ((input_i+m-1)/m)*((input_j+m-1)/m);
+    float* error = workspace;
+    float* v = error + n_kernels*(input_i+2)*(input_j+2) + a2*tiles_bp*(n_kernels+channels);
+    float* dm = v + a2*tiles*channels;
+    float* du = dm + a2*n_kernels*tiles;
+    float dy[16];
+    float tmp[24];
+    float dg[9];
+    
+    // error of the biases and output error padded with 2 zeros
+    memset(error,0,sizeof(float)*n_kernels*(input_i+2)*(input_j+2));
+    for(k = 0; k < n_kernels; k++){
+        for(i = 0; i < output_i; i++){
+            for(j = 0; j < output_j; j++){
+                bias_error[k] += output_error[k*rows*cols + (i+padding)*cols + j+padding];
+                error[k*(input_i+2)*(input_j+2) + (i+2)*(input_j+2) + j+2] = output_error[k*rows*cols + (i+padding)*cols + j+padding];
+            }
+        }
+    }
+    
+    // error of the input
+    winograd_convolution(error,u_bp,channels,n_kernels,input_i+2,input_j+2,m,input_error,0,error + n_kernels*(input_i+2)*(input_j+2));
+    
+    // error of the kernels
+    winograd_input_transform(input,channels,input_i,input_j,m,tiles_i,tiles_j,1,v);
+    for(k = 0; k < n_kernels; k++){
+        for(ti = 0; ti < tiles_i; ti++){
+            for(tj = 0; tj < tiles_j; tj++){
+                for(i = 0; i < m; i++){
+                    for(j = 0; j < m; j++){
+                        if(ti*m+i < output_i && tj*m+j < output_j)
+                            dy[i*m+j] = output_error[k*rows*cols + (ti*m+i+padding)*cols + tj*m+j+padding];
+                        else
+                            dy[i*m+j] = 0;
+                    }
+                }
+                for(j = 0; j < m; j++){
+                    winograd_output_transform_1d_transposed(m,dy+j,m,tmp+j,m);
+                }
+                for(i = 0; i < a; i++){
+                    winograd_output_transform_1d_transposed(m,tmp+i*m,1,&dm[i*a*n_kernels*tiles + k*tiles + ti*tiles_j+tj],n_kernels*tiles);
+                }
+            }
+        }
+    }
+    memset(du,0,sizeof(float)*a2*n_kernels*channels);
+    for(x = 0; x < a2; x++){
+        sgemm_nn(n_kernels,channels,tiles,&dm[x*n_kernels*tiles],tiles,&v[x*tiles*channels],channels,&du[x*n_kernels*channels],channels);
+    }
+    for(k = 0; k < n_kernels; k++){
+        for(c = 0; c < channels; c++){
+            for(j = 0; j < a; j++){
+                winograd_kernel_transform_1d_transposed(m,&du[j*n_kernels*channels + k*channels + c],a*n_kernels*channels,tmp+j,a);
+            }
+            for(i = 0; i < 3; i++){
+                winograd_kernel_transform_1d_transposed(m,tmp+i*a,1,dg+i*3,1);
+            }
+            for(i = 0; i < 9; i++){
+                kernel_error[k][c*9+i] += dg[i];
+            }
+        }
+    }
+}
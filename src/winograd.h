@@ -0,0 +1,44 @@
+/*
+MIT License
+
+Copyright (c) 2018 Viviano Riccardo
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files ((the "LICENSE")), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __WINOGRAD_H__
+#define __WINOGRAD_H__
+
+int winograd_tile_size(int output_i, int output_j);
+int winograd_kernels_size(int n_kernels, int channels, int m);
+int winograd_workspace_size(int channels, int input_i, int input_j, int n_kernels, int m);
+void winograd_matrices(int m, float** bt, float** g, float** at);
+void winograd_input_transform_1d(int m, float* d, int d_stride, float* r, int r_stride);
+void winograd_output_transform_1d(int m, float* x, int x_stride, float* y, int y_stride);
+void winograd_output_transform_1d_transposed(int m, float* y, int y_stride, float* x, int x_stride);
+void winograd_kernel_transform_1d(int m, float* w, int w_stride, float* u, int u_stride);
+void winograd_kernel_transform_1d_transposed(int m, float* u, int u_stride, float* w, int w_stride);
+void winograd_kernel_transform(float** kernel, int n_kernels, int channels, int m, int flip, float* u);
+void winograd_input_transform(float* input, int channels, int input_i, int input_j, int m, int tiles_i, int tiles_j, int transposed, float* v);
+void winograd_output_transform(float* mm, int n_out, int m, int tiles_i, int tiles_j, float* output, int output_i, int output_j, int padding);
+void winograd_convolution(float* input, float* u, int n_out, int n_in, int input_i, int input_j, int m, float* output, int padding, float* workspace);
+void convolutional_feed_forward_winograd(float* input, float* u, int n_kernels, int input_i, int input_j, float* bias, int channels, float* output, int padding, int m, float* workspace);
+void convolutional_back_prop_winograd(float* input, float* u_bp, int n_kernels, int input_i, int input_j, int channels, float* output_error, float* input_error, float** kernel_error, float* bias_error, int padding, int m, float* workspace);
+
+#endif
@@ -0,0 +1,128 @@
+#include <llab.h>
+#include <math.h>
+
+/* Accuracy test of the winograd convolution:
+ * for 3*3 kernels with stride 1 the feed forward, the error of the input, the errors of the kernels and the errors
+ * of the biases computed with WINOGRAD_CONVOLUTION are compared with the ones of DIRECT_CONVOLUTION.
+ * The layers are tested with and without padding, with F(2x2,3x3) (small outputs) and F(4x4,3x3) (outputs >= 8*8).
+ * Then a model is trained for some steps to check that the transformed kernels are computed again after update_model
+ * */
+
+#define TOLERANCE 0.0001
+
+float max_relative_error(float* a, float* b, int size){
+    int i;
+    float max = 0, norm = 0;
+    for(i = 0; i < size; i++){
+        if(fabs(b[i]) > norm)
+            norm = fabs(b[i]);
+    }
+    if(norm < 1)
+        norm = 1;
+    for(i = 0; i < size; i++){
+        if(fabs(a[i]-b[i])/norm > max)
+            max = fabs(a[i]-b[i])/norm;
+    }
+    return max;
+}
+
+float test_layer(int channels, int rows, int cols, int n_kernels, int padding){
+    int i,j,size;
+    float max = 0, e;
+    cl* c1 = convolutional(channels,rows,cols,3,3,n_kernels,1,1,padding,padding,1,1,0,0,1,1,NO_NORMALIZATION,NO_ACTIVATION,NO_POOLING,0,CONVOLUTION,0);
+    cl* c2 = copy_cl(c1);
+    float* input = (float*)malloc(sizeof(float)*channels*rows*cols);
+    for(i = 0; i < channels*rows*cols; i++){
+        input[i] = r2()-0.5;
+    }
+    for(i = 0; i < n_kernels; i++){
+        c1->biases[i] = r2()-0.5;
+        c2->biases[i] = c1->biases[i];
+    }
+    set_convolution_algorithm(c1,DIRECT_CONVOLUTION);
+    set_convolution_algorithm(c2,WINOGRAD_CONVOLUTION);
+    convolutional_layer_feed_forward(c1,input);
+    convolutional_layer_feed_forward(c2,input);
+    size = n_kernels*c1->rows1*c1->cols1;
+    e = max_relative_error(c2->pre_activation,c1->pre_activation,size);
+    if(e > max)
+        max = e;
+    for(i = 0; i < size; i++){
+        c1->temp[i] = r2()-0.5;
+        c2->temp[i] = c1->temp[i];
+    }
+    convolutional_layer_back_prop(c1,input);
+    convolutional_layer_back_prop(c2,input);
+    e = max_relative_error(c2->error2,c1->error2,channels*rows*cols);
+    if(e > max)
+        max = e;
+    e = max_relative_error(c2->d_biases,c1->d_biases,n_kernels);
+    if(e > max)
+        max = e;
+    for(j = 0; j < n_kernels; j++){
+        e = max_relative_error(c2->d_kernels[j],c1->d_kernels[j],channels*9);
+        if(e > max)
+            max = e;
+    }
+    printf("channels: %d, input: %d*%d, kernels: %d, padding: %d, tile: %d, max relative error: %f\n",channels,rows,cols,n_kernels,padding,c2->winograd_tile,max);
+    free(input);
+    free_convolutional(c1);
+    free_convolutional(c2);
+    return max;
+}
+
+int main(){
+    srand(time(NULL));
+    int i,step,failed = 0;
+    float max;
+    
+    // single layers
+    if(test_layer(1,5,5,1,0) > TOLERANCE) failed = 1;
+    if(test_layer(3,7,6,4,1) > TOLERANCE) failed = 1;
+    if(test_layer(4,10,10,8,0) > TOLERANCE) failed = 1;
+    if(test_layer(8,17,13,5,1) > TOLERANCE) failed = 1;
+    if(test_layer(16,32,32,16,1) > TOLERANCE) failed = 1;
+    
+    // cache invalidation with update_model
+    cl** cls = (cl**)malloc(sizeof(cl*));
+    fcl** fcls = (fcl**)malloc(sizeof(fcl*));
+    cls[0] = convolutional(2,12,12,3,3,4,1,1,1,1,2,2,0,0,2,2,NO_NORMALIZATION,RELU,MAX_POOLING,0,CONVOLUTION,0);
+    fcls[0] = fully_connected(4*6*6,10,1,NO_DROPOUT,SOFTMAX,0,0,NO_NORMALIZATION);
+    model* m = network(2,0,1,1,NULL,cls,fcls);
+    model* direct = copy_model(m);
+    set_model_convolution_algorithm(direct,DIRECT_CONVOLUTION);
+    float* input = (float*)malloc(sizeof(float)*2*12*12);
+    float* error = (float*)malloc(sizeof(float)*10);
+    float b1 = BETA1_ADAM, b2 = BETA2_ADAM;
+    unsigned long long int t = 1;
+    for(i = 0; i < 2*12*12; i++){
+        input[i] = r2();
+    }
+    for(step = 0; step < 5; step++){
+        model_tensor_input_ff(m,2,12,12,input);
+        model_tensor_input_ff(direct,2,12,12,input);
+        max = max_relative_error(m->cls[0]->pre_activation,direct->cls[0]->pre_activation,4*12*12);
+        printf("step: %d, max relative error of the model: %f\n",step,max);
+        if(max > TOLERANCE)
+            failed = 1;
+        for(i = 0; i < 10; i++){
+            error[i] = m->fcls[0]->post_activation[i] - (i == 3);
+        }
+        model_tensor_input_bp(m,2,12,12,input,error,10);
+        update_model(m,0.01,0.9,1,ADAM,&b1,&b2,NO_REGULARIZATION,0,0,&t);
+        reset_model(m);
+        paste_model(m,direct);
+        reset_model(direct);
+    }
+    free(input);
+    free(error);
+    free_model(m);
+    free_model(direct);
+    
+    if(failed){
+        printf("winograd test failed\n");
+        return 1;
+    }
+    printf("winograd test passed\n");
+    return 0;
+}
@@ -0,0 +1,194 @@
+#include <llab.h>
+#include <math.h>
+#include <sys/wait.h>
+
+/* Test of the ring all-reduce:
+ * N_WORKERS processes are connected in a ring on the loopback, each of them sums vectors of different sizes
+ * (smaller than the number of workers, smaller and larger than a segment) with ring_all_reduce and ring_all_reduce_start.
+ * Then each worker trains the same model on its own samples summing the partial derivatives with ring_all_reduce_model:
+ * the models of the workers must be equal, and equal to a model trained in a single process on all the samples
+ * */
+
+#define N_WORKERS 4
+#define PORT 9100
+#define STEPS 5
+#define INPUT 20
+#define MIDDLE 16
+#define OUTPUT 4
+#define SEED 7
+#define TOLERANCE 0.0001
+
+model* create_test_model(){
+    srand(SEED);
+    fcl** fcls = (fcl**)malloc(sizeof(fcl*)*2);
+    fcls[0] = fully_connected(INPUT,MIDDLE,0,NO_DROPOUT,RELU,0,0,NO_NORMALIZATION);
+    fcls[1] = fully_connected(MIDDLE,OUTPUT,1,NO_DROPOUT,SOFTMAX,0,0,NO_NORMALIZATION);
+    return network(2,0,0,2,NULL,NULL,fcls);
+}
+
+void train_step(model* m, float* input, float* output, float* error){
+    model_tensor_input_ff(m,INPUT,1,1,input);
+    derivative_cross_entropy_array(m->fcls[1]->post_activation,output,error,OUTPUT);
+    model_tensor_input_bp(m,INPUT,1,1,input,error,OUTPUT);
+}
+
+int test_vector(ring* r, int size, int async){
+    int i, failed = 0;
+    float* vector = (float*)malloc(sizeof(float)*size);
+    for(i = 0; i < size; i++){
+        vector[i] = (r->rank+1)*(i%97);
+    }
+    if(async){
+        ring_all_reduce_start(r,vector,size);
+        ring_all_reduce_wait(r);
+    }
+    else
+        ring_all_reduce(r,vector,size);
+    // 1+2+...+N_WORKERS
+    for(i = 0; i < size; i++){
+        if(vector[i] != N_WORKERS*(N_WORKERS+1)/2*(i%97))
+            failed = 1;
+    }
+    free(vector);
+    return failed;
+}
+
+int worker(int rank, int fd, float** inputs, float** outputs){
+    int i, failed = 0, ports[N_WORKERS];
+    char* addresses[N_WORKERS];
+    unsigned long long int t = 1;
+    for(i = 0; i < N_WORKERS; i++){
+        addresses[i] = "127.0.0.1";
+        ports[i] = PORT+i;
+    }
+    ring* r = create_ring(rank,N_WORKERS,addresses,ports);
+    
+    failed |= test_vector(r,3,0);
+    failed |= test_vector(r,1000,0);
+    failed |= test_vector(r,100003,0);
+    failed |= test_vector(r,100003,1);
+    
+    model* m = create_test_model();
+    int size = get_array_size_params_model(m);
+    float* vector = (float*)malloc(sizeof(float)*size);
+    float* error = (float*)malloc(sizeof(float)*OUTPUT);
+    for(i = 0; i < STEPS; i++){
+        train_step(m,inputs[i*N_WORKERS+rank],outputs[i*N_WORKERS+rank],error);
+        ring_all_reduce_model(r,m,vector);
+        update_model(m,0.01,0.9,N_WORKERS,NESTEROV,NULL,NULL,NO_REGULARIZATION,0,0,&t);
+        reset_model(m);
+    }
+    memcopy_params_to_vector_model(m,vector);
+    if(write(fd,vector,sizeof(float)*size) != sizeof(float)*size)
+        failed = 1;
+    free(vector);
+    free(error);
+    free_model(m);
+    free_ring(r);
+    return failed;
+}
+
+int main(){
+    int i,j,status,failed = 0,pids[N_WORKERS],fds[N_WORKERS][2];
+    unsigned long long int t = 1;
+    float** inputs = (float**)malloc(sizeof(float*)*STEPS*N_WORKERS);
+    float** outputs = (float**)malloc(sizeof(float*)*STEPS*N_WORKERS);
+    srand(SEED+1);
+    for(i = 0; i < STEPS*N_WORKERS; i++){
+        inputs[i] = (float*)malloc(sizeof(float)*INPUT);
+        outputs[i] = (float*)calloc(OUTPUT,sizeof(float));
+        for(j = 0; j < INPUT; j++){
+            inputs[i][j] = r2();
+        }
+        outputs[i][rand()%OUTPUT] = 1;
+    }
+    
+    for(i = 0; i < N_WORKERS; i++){
+        if(pipe(fds[i]) == -1){
+            fprintf(stderr,"Error: not able to create the pipe\n");
+            exit(1);
+        }
+        pids[i] = fork();
+        if(pids[i] == -1){
+            fprintf(stderr,"Error: not able to create a son process\n");
+            exit(1);
+        }
+        if(pids[i] == 0){
+            close(fds[i][0]);
+            exit(worker(i,fds[i][1],inputs,outputs));
+        }
+        close(fds[i][1]);
+    }
+    
+    // the same training in a single process
+    model* m = create_test_model();
+    int size = get_array_size_params_model(m);
+    float* error = (float*)malloc(sizeof(float)*OUTPUT);
+    float* reference = (float*)malloc(sizeof(float)*size);
+    float* first = (float*)malloc(sizeof(float)*size);
+    float* params = (float*)malloc(sizeof(float)*size);
+    float* sum = (float*)malloc(sizeof(float)*size);
+    for(i = 0; i < STEPS; i++){
+        memset(sum,0,sizeof(float)*size);
+        for(j = 0; j < N_WORKERS; j++){
+            train_step(m,inputs[i*N_WORKERS+j],outputs[i*N_WORKERS+j],error);
+            memcopy_derivative_params_to_vector_model(m,params);
+            sum1D(sum,params,sum,size);
+            reset_model(m);
+        }
+        memcopy_vector_to_derivative_params_model(m,sum);
+        update_model(m,0.01,0.9,N_WORKERS,NESTEROV,NULL,NULL,NO_REGULARIZATION,0,0,&t);
+        reset_model(m);
+    }
+    memcopy_params_to_vector_model(m,reference);
+    
+    for(i = 0; i < N_WORKERS; i++){
+        if(read(fds[i][0],i ? params : first,sizeof(float)*size) != sizeof(float)*size){
+            printf("worker %d: no params received\n",i);
+            failed = 1;
+            continue;
+        }
+        for(j = 0; j < size && i; j++){
+            if(params[j] != first[j]){
+                printf("worker %d: the params are different from the ones of worker 0\n",i);
+                failed = 1;
+                break;
+            }
+        }
+        for(j = 0; j < size && !i; j++){
+            if(fabs(first[j]-reference[j]) > TOLERANCE){
+                printf("worker 0: the params are different from the ones of a single process\n");
+                failed = 1;
+                break;
+            }
+        }
+        close(fds[i][0]);
+    }
+    for(i = 0; i < N_WORKERS; i++){
+        waitpid(pids[i],&status,0);
+        if(!WIFEXITED(status) || WEXITSTATUS(status)){
+            printf("worker %d failed\n",i);
+            failed = 1;
+        }
+    }
+    
+    free_model(m);
+    free(error);
+    free(reference);
+    free(first);
+    free(params);
+    free(sum);
+    for(i = 0; i < STEPS*N_WORKERS; i++){
+        free(inputs[i]);
+        free(outputs[i]);
+    }
+    free(inputs);
+    free(outputs);
+    
+    if(failed){
+        printf("ring all-reduce test failed\n");
+        return 1;
+    }
+    printf("ring all-reduce test passed\n");
+    return 0;
+}
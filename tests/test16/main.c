@@ -0,0 +1,168 @@
+#include <llab.h>
+#include <math.h>
+#include <sys/wait.h>
+
+/* Test of the parameter server:
+ * N_WORKERS processes train the same model through a parameter server for DURATION seconds, the worker 0 is slowed down
+ * by SLOW_DELAY microseconds each step. The training is done with a synchronous server (staleness 0), a bounded staleness
+ * and without bound: the staleness bound must be respected, the loss must decrease and without bound
+ * the fast workers must not wait for the slow one, so the pushes per second of the server are much more than the synchronous ones
+ * */
+
+#define N_WORKERS 3
+#define PORT 9200
+#define DURATION 1.0
+#define SLOW_DELAY 20000
+#define BATCH 8
+#define N_SAMPLES 256
+#define INPUT 20
+#define MIDDLE 16
+#define OUTPUT 4
+#define SEED 11
+#define STALENESS 4
+#define LR 0.01
+#define MOMENTUM 0.9
+
+model* create_test_model(){
+    srand(SEED);
+    fcl** fcls = (fcl**)malloc(sizeof(fcl*)*2);
+    fcls[0] = fully_connected(INPUT,MIDDLE,0,NO_DROPOUT,RELU,0,0,NO_NORMALIZATION);
+    fcls[1] = fully_connected(MIDDLE,OUTPUT,1,NO_DROPOUT,NO_ACTIVATION,0,0,NO_NORMALIZATION);
+    return network(2,0,0,2,NULL,NULL,fcls);
+}
+
+double now(){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC,&t);
+    return t.tv_sec+t.tv_nsec*1e-9;
+}
+
+float loss(model* m, float** inputs, float** outputs){
+    int i,j;
+    float sum = 0;
+    for(i = 0; i < N_SAMPLES; i++){
+        model_tensor_input_ff(m,INPUT,1,1,inputs[i]);
+        for(j = 0; j < OUTPUT; j++){
+            sum+=mse(m->output_layer[j],outputs[i][j]);
+        }
+        reset_model(m);
+    }
+    return sum/N_SAMPLES;
+}
+
+int worker(int rank, int port, float** inputs, float** outputs){
+    int i, j = rank;
+    unsigned int version;
+    model* m = create_test_model();
+    int size = get_array_size_params_model(m);
+    float* vector = (float*)malloc(sizeof(float)*size);
+    float* sum = (float*)malloc(sizeof(float)*size);
+    float* error = (float*)malloc(sizeof(float)*OUTPUT);
+    int fd = parameter_server_connect("127.0.0.1",port);
+    double start = now();
+    while(now()-start < DURATION){
+        version = parameter_server_pull_model(fd,m,vector);
+        memset(sum,0,sizeof(float)*size);
+        for(i = 0; i < BATCH; i++, j = (j+N_WORKERS)%N_SAMPLES){
+            model_tensor_input_ff(m,INPUT,1,1,inputs[j]);
+            derivative_mse_array(m->output_layer,outputs[j],error,OUTPUT);
+            model_tensor_input_bp(m,INPUT,1,1,inputs[j],error,OUTPUT);
+            memcopy_derivative_params_to_vector_model(m,vector);
+            sum1D(sum,vector,sum,size);
+            reset_model(m);
+        }
+        if(!rank)
+            usleep(SLOW_DELAY);
+        parameter_server_push(fd,version,sum,size);
+    }
+    parameter_server_close(fd);
+    free(vector);
+    free(sum);
+    free(error);
+    free_model(m);
+    return 0;
+}
+
+int train(int staleness, int port, float** inputs, float** outputs, double* pushes_per_second){
+    int i, status, failed = 0, pids[N_WORKERS];
+    model* m = create_test_model();
+    float initial_loss = loss(m,inputs,outputs), final_loss;
+    parameter_server* ps = create_parameter_server(m,N_WORKERS,staleness,LR,MOMENTUM,BATCH,NESTEROV);
+    
+    fflush(stdout);
+    for(i = 0; i < N_WORKERS; i++){
+        pids[i] = fork();
+        if(pids[i] == -1){
+            fprintf(stderr,"Error: not able to create a son process\n");
+            exit(1);
+        }
+        if(pids[i] == 0)
+            exit(worker(i,port,inputs,outputs));
+    }
+    double start = now();
+    run_parameter_server(ps,port);
+    *pushes_per_second = ps->version/(now()-start);
+    for(i = 0; i < N_WORKERS; i++){
+        waitpid(pids[i],&status,0);
+        if(!WIFEXITED(status) || WEXITSTATUS(status)){
+            printf("worker %d failed\n",i);
+            failed = 1;
+        }
+    }
+    final_loss = loss(m,inputs,outputs);
+    printf("staleness %2d: %8.1f pushes per second, loss %.4f -> %.4f, mean staleness of a push %.2f, max gap %d\n",staleness,*pushes_per_second,initial_loss,final_loss,(double)ps->total_staleness/ps->version,ps->max_gap);
+    if(final_loss >= initial_loss){
+        printf("staleness %d: the loss didn't decrease\n",staleness);
+        failed = 1;
+    }
+    if(staleness != PARAMETER_SERVER_ASYNC && ps->max_gap > staleness){
+        printf("staleness %d: a client was %d pushes ahead of the slowest one\n",staleness,ps->max_gap);
+        failed = 1;
+    }
+    free_parameter_server(ps);
+    free_model(m);
+    return failed;
+}
+
+int main(){
+    int i,j,k,failed = 0;
+    double synchronous, bounded, asynchronous;
+    float** inputs = (float**)malloc(sizeof(float*)*N_SAMPLES);
+    float** outputs = (float**)malloc(sizeof(float*)*N_SAMPLES);
+    srand(SEED+1);
+    // the class is the largest of the first OUTPUT inputs
+    for(i = 0; i < N_SAMPLES; i++){
+        inputs[i] = (float*)malloc(sizeof(float)*INPUT);
+        outputs[i] = (float*)calloc(OUTPUT,sizeof(float));
+        for(j = 0; j < INPUT; j++){
+            inputs[i][j] = r2();
+        }
+        for(j = 1, k = 0; j < OUTPUT; j++){
+            if(inputs[i][j] > inputs[i][k])
+                k = j;
+        }
+        outputs[i][k] = 1;
+    }
+
+    failed |= train(0,PORT,inputs,outputs,&synchronous);
+    failed |= train(STALENESS,PORT+1,inputs,outputs,&bounded);
+    failed |= train(PARAMETER_SERVER_ASYNC,PORT+2,inputs,outputs,&asynchronous);
+    if(asynchronous < 2*synchronous){
+        printf("the asynchronous server is not faster than the synchronous one\n");
+        failed = 1;
+    }
+
+    for(i = 0; i < N_SAMPLES; i++){
+        free(inputs[i]);
+        free(outputs[i]);
+    }
+    free(inputs);
+    free(outputs);
+
+    if(failed){
+        printf("parameter server test failed\n");
+        return 1;
+    }
+    printf("parameter server test passed\n");
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include <llab.h>
+#include <math.h>
+#include <sys/wait.h>
+
+/* Test of the shared memory trainer:
+ * N_WORKERS processes train the same model on their own samples through a POSIX shared memory segment,
+ * each worker accumulates the partial derivatives of SAMPLES samples in each step. The params of the segment must be
+ * equal to the params of a model trained in a single process on all the samples
+ * */
+
+#define N_WORKERS 4
+#define STEPS 5
+#define SAMPLES 2
+#define INPUT 20
+#define MIDDLE 256
+#define OUTPUT 4
+#define SEED 13
+#define TOLERANCE 0.0001
+#define NAME "/llab_test17"
+
+model* create_test_model(){
+    srand(SEED);
+    fcl** fcls = (fcl**)malloc(sizeof(fcl*)*2);
+    fcls[0] = fully_connected(INPUT,MIDDLE,0,NO_DROPOUT,RELU,0,0,NO_NORMALIZATION);
+    fcls[1] = fully_connected(MIDDLE,OUTPUT,1,NO_DROPOUT,SOFTMAX,0,0,NO_NORMALIZATION);
+    model* m = network(2,0,0,2,NULL,NULL,fcls);
+    make_model_contiguous(m);
+    return m;
+}
+
+void train_sample(model* m, float* input, float* output, float* error){
+    model_tensor_input_ff(m,INPUT,1,1,input);
+    derivative_cross_entropy_array(m->output_layer,output,error,OUTPUT);
+    model_tensor_input_bp(m,INPUT,1,1,input,error,OUTPUT);
+    reset_model_except_partial_derivatives(m);
+}
+
+int worker(shared_trainer* t, model* m, int rank, float** inputs, float** outputs){
+    int i,j;
+    float b1 = m->beta1_adam, b2 = m->beta2_adam;
+    unsigned long long int t_radam = 1;
+    float* error = (float*)malloc(sizeof(float)*OUTPUT);
+    join_shared_trainer(t,rank,m,0);
+    for(i = 0; i < STEPS; i++){
+        for(j = 0; j < SAMPLES; j++){
+            train_sample(m,inputs[(i*N_WORKERS+rank)*SAMPLES+j],outputs[(i*N_WORKERS+rank)*SAMPLES+j],error);
+        }
+        shared_trainer_step(t,m,0.01,0.9,N_WORKERS*SAMPLES,ADAM,&b1,&b2,NO_REGULARIZATION,0,0,&t_radam);
+    }
+    free(error);
+    free_model(m);
+    free_shared_trainer(t);
+    return 0;
+}
+
+int main(){
+    int i,j,w,status,failed = 0,pids[N_WORKERS];
+    float b1, b2;
+    unsigned long long int t_radam = 1;
+    float** inputs = (float**)malloc(sizeof(float*)*STEPS*N_WORKERS*SAMPLES);
+    float** outputs = (float**)malloc(sizeof(float*)*STEPS*N_WORKERS*SAMPLES);
+    srand(SEED+1);
+    for(i = 0; i < STEPS*N_WORKERS*SAMPLES; i++){
+        inputs[i] = (float*)malloc(sizeof(float)*INPUT);
+        outputs[i] = (float*)calloc(OUTPUT,sizeof(float));
+        for(j = 0; j < INPUT; j++){
+            inputs[i][j] = r2();
+        }
+        outputs[i][rand()%OUTPUT] = 1;
+    }
+
+    // a segment left by a crashed run
+    shm_unlink(NAME);
+    model* m = create_test_model();
+    shared_trainer* t = create_shared_trainer(NAME,N_WORKERS,m);
+    for(i = 0; i < N_WORKERS; i++){
+        pids[i] = fork();
+        if(pids[i] == -1){
+            fprintf(stderr,"Error: not able to create a son process\n");
+            exit(1);
+        }
+        if(pids[i] == 0)
+            exit(worker(t,m,i,inputs,outputs));
+    }
+    for(i = 0; i < N_WORKERS; i++){
+        waitpid(pids[i],&status,0);
+        if(!WIFEXITED(status) || WEXITSTATUS(status)){
+            printf("worker %d failed\n",i);
+            failed = 1;
+        }
+    }
+    copy_shared_trainer_params(t,m);
+
+    // the same training in a single process
+    model* reference = create_test_model();
+    int size = get_array_size_params_model(m);
+    float* error = (float*)malloc(sizeof(float)*OUTPUT);
+    float* params = (float*)malloc(sizeof(float)*size);
+    float* sum = (float*)malloc(sizeof(float)*size);
+    b1 = reference->beta1_adam;
+    b2 = reference->beta2_adam;
+    for(i = 0; i < STEPS; i++){
+        for(w = 0; w < N_WORKERS; w++){
+            for(j = 0; j < SAMPLES; j++){
+                train_sample(reference,inputs[(i*N_WORKERS+w)*SAMPLES+j],outputs[(i*N_WORKERS+w)*SAMPLES+j],error);
+            }
+            memcopy_derivative_params_to_vector_model(reference,params);
+            if(w)
+                sum1D(sum,params,sum,size);
+            else
+                copy_array(params,sum,size);
+            reset_model(reference);
+        }
+        memcopy_vector_to_derivative_params_model(reference,sum);
+        update_model(reference,0.01,0.9,N_WORKERS*SAMPLES,ADAM,&b1,&b2,NO_REGULARIZATION,0,0,&t_radam);
+        reset_model(reference);
+    }
+
+    memcopy_params_to_vector_model(reference,sum);
+    memcopy_params_to_vector_model(m,params);
+    for(i = 0; i < size; i++){
+        if(fabs(params[i]-sum[i]) > TOLERANCE){
+            printf("the params are different from the ones of a single process\n");
+            failed = 1;
+            break;
+        }
+    }
+
+    free_shared_trainer(t);
+    free_model(m);
+    free_model(reference);
+    free(error);
+    free(params);
+    free(sum);
+    for(i = 0; i < STEPS*N_WORKERS*SAMPLES; i++){
+        free(inputs[i]);
+        free(outputs[i]);
+    }
+    free(inputs);
+    free(outputs);
+
+    if(failed){
+        printf("shared memory trainer test failed\n");
+        return 1;
+    }
+    printf("shared memory trainer test passed\n");
+    return 0;
+}
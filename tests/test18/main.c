@@ -0,0 +1,134 @@
+#include <llab.h>
+#include <math.h>
+
+/* Test of the batched model:
+ * the same batch goes through a bmodel and through BATCH replicas of the model created with share_model.
+ * The outputs, the errors of the inputs and the partial derivatives summed with sum_models_partial_derivatives
+ * must be equal bit for bit to the ones of the bmodel, for a model with only fully-connected layers
+ * and for a model with convolutional, residual and fully-connected layers
+ * */
+
+#define BATCH 7
+#define CHANNELS 1
+#define ROWS 8
+#define COLS 8
+#define INPUT (CHANNELS*ROWS*COLS)
+#define OUTPUT 5
+#define SEED 3
+#define THREADS 3
+
+model* create_test_model(int convolutional_flag){
+    srand(SEED);
+    if(convolutional_flag){
+        cl** cls = (cl**)malloc(sizeof(cl*));
+        cl** rcls = (cl**)malloc(sizeof(cl*)*2);
+        rl** rls = (rl**)malloc(sizeof(rl*));
+        fcl** fcls = (fcl**)malloc(sizeof(fcl*)*2);
+        cls[0] = convolutional(CHANNELS,ROWS,COLS,3,3,4,1,1,1,1,2,2,0,0,2,2,NO_NORMALIZATION,RELU,MAX_POOLING,0,CONVOLUTION,0);
+        rcls[0] = convolutional(4,4,4,3,3,4,1,1,1,1,2,2,0,0,2,2,GROUP_NORMALIZATION,RELU,NO_POOLING,2,CONVOLUTION,1);
+        rcls[1] = convolutional(4,4,4,3,3,4,1,1,1,1,2,2,0,0,2,2,NO_NORMALIZATION,RELU,NO_POOLING,0,CONVOLUTION,2);
+        rls[0] = residual(4,4,4,2,rcls);
+        fcls[0] = fully_connected(64,20,3,NO_DROPOUT,RELU,0,0,NO_NORMALIZATION);
+        fcls[1] = fully_connected(20,OUTPUT,4,NO_DROPOUT,SOFTMAX,0,0,NO_NORMALIZATION);
+        return network(5,1,1,2,rls,cls,fcls);
+    }
+    fcl** fcls = (fcl**)malloc(sizeof(fcl*)*3);
+    fcls[0] = fully_connected(INPUT,30,0,NO_DROPOUT,SIGMOID,0,0,NO_NORMALIZATION);
+    fcls[1] = fully_connected(30,20,1,NO_DROPOUT,TANH,0,0,NO_NORMALIZATION);
+    fcls[2] = fully_connected(20,OUTPUT,2,NO_DROPOUT,NO_ACTIVATION,0,0,NO_NORMALIZATION);
+    return network(3,0,0,3,NULL,NULL,fcls);
+}
+
+int test_model(int convolutional_flag){
+    int i,j,size,different = 0;
+    model* m = create_test_model(convolutional_flag);
+    model* sum = copy_model(m);
+    model** replicas = (model**)malloc(sizeof(model*)*BATCH);
+    float** inputs = (float**)malloc(sizeof(float*)*BATCH);
+    float** errors = (float**)malloc(sizeof(float*)*BATCH);
+    float** input_errors = (float**)malloc(sizeof(float*)*BATCH);
+    float** batch_input_errors = (float**)malloc(sizeof(float*)*BATCH);
+    reset_model(sum);
+    for(i = 0; i < BATCH; i++){
+        replicas[i] = share_model(sum);
+        inputs[i] = (float*)malloc(sizeof(float)*INPUT);
+        errors[i] = (float*)malloc(sizeof(float)*OUTPUT);
+        for(j = 0; j < INPUT; j++){
+            inputs[i][j] = r2();
+        }
+        for(j = 0; j < OUTPUT; j++){
+            errors[i][j] = r2();
+        }
+    }
+
+    // the replicas
+    model_tensor_input_ff_multicore(replicas,CHANNELS,ROWS,COLS,inputs,BATCH,THREADS);
+    model_tensor_input_bp_multicore(replicas,CHANNELS,ROWS,COLS,inputs,BATCH,THREADS,errors,OUTPUT,input_errors);
+    sum_models_partial_derivatives(sum,replicas,BATCH);
+
+    // the batched model
+    bmodel* bm = batch_model(m,BATCH);
+    reset_batch_model(bm);
+    model_tensor_input_ff_batch(bm,CHANNELS,ROWS,COLS,inputs,THREADS);
+    for(i = 0; i < BATCH; i++){
+        for(j = 0; j < OUTPUT; j++){
+            if(get_batch_model_output(bm,i)[j] != replicas[i]->output_layer[j])
+                different = 1;
+        }
+    }
+    if(different)
+        printf("model %d: the outputs of the batched model are different from the ones of the replicas\n",convolutional_flag);
+    model_tensor_input_bp_batch(bm,CHANNELS,ROWS,COLS,inputs,errors,OUTPUT,batch_input_errors,THREADS);
+    for(i = 0; i < BATCH; i++){
+        for(j = 0; j < INPUT; j++){
+            if(batch_input_errors[i][j] != input_errors[i][j]){
+                printf("model %d: the errors of the input %d are different from the ones of the replicas\n",convolutional_flag,i);
+                different = 1;
+                break;
+            }
+        }
+    }
+
+    size = get_array_size_params_model(m);
+    float* expected = (float*)malloc(sizeof(float)*size);
+    float* computed = (float*)malloc(sizeof(float)*size);
+    memcopy_derivative_params_to_vector_model(sum,expected);
+    memcopy_derivative_params_to_vector_model(m,computed);
+    for(i = 0; i < size; i++){
+        if(expected[i] != computed[i]){
+            printf("model %d: the partial derivative %d is %.9g instead of %.9g\n",convolutional_flag,i,computed[i],expected[i]);
+            different = 1;
+            break;
+        }
+    }
+
+    free_batch_model(bm);
+    for(i = 0; i < BATCH; i++){
+        free_model(replicas[i]);
+        free(inputs[i]);
+        free(errors[i]);
+    }
+    free(replicas);
+    free(inputs);
+    free(errors);
+    free(input_errors);
+    free(batch_input_errors);
+    free(expected);
+    free(computed);
+    free_model(sum);
+    free_model(m);
+    return different;
+}
+
+int main(){
+    int failed = 0;
+    failed |= test_model(0);
+    failed |= test_model(1);
+    free_shared_thread_pool();
+    if(failed){
+        printf("batched model test failed\n");
+        return 1;
+    }
+    printf("batched model test passed\n");
+    return 0;
+}
@@ -0,0 +1,169 @@
+#include <llab.h>
+#include <math.h>
+
+/* Gradient test of bp_rmodel_lstm:
+ * the partial derivatives of the weights, of the recurrent weights and of the biases and the errors of the inputs
+ * computed by bp_rmodel_lstm are compared with central differences of the loss sum(error_model[t]*output[t]).
+ * The models have 1, 2 and 3 layers, with and without residual connections, so the first timestep of the first layer
+ * of a multi-layer model (u, not d_u) and all the rows of w and u in lstm_dinput and lstm_dh are covered.
+ * The errors of the initial hidden states are computed with lstm_dh from the dfioc returned by bp_rmodel_lstm
+ * */
+
+#define SIZE 6
+#define WINDOW 5
+#define MAX_LAYERS 3
+#define STEP 0.01
+#define TOLERANCE 0.02
+#define SEED 3
+
+int layers;
+rmodel* m;
+float** hidden_states;
+float** cell_states;
+float** inputs;
+float** errors;
+
+double loss(){
+    int i,t;
+    double sum = 0;
+    reset_rmodel(m);
+    ff_rmodel(hidden_states,cell_states,inputs,m);
+    for(t = 0; t < WINDOW; t++){
+        for(i = 0; i < SIZE; i++){
+            sum+=errors[t][i]*m->lstms[layers-1]->out_up[t][i];
+        }
+    }
+    return sum;
+}
+
+/* the max difference between the gradient and the central differences, relative to the max central difference*/
+double check(float* params, float* gradient, int size){
+    int i;
+    float p;
+    double plus,minus,numeric,max_difference = 0,max_numeric = 0;
+    for(i = 0; i < size; i++){
+        p = params[i];
+        params[i] = p+STEP;
+        plus = loss();
+        params[i] = p-STEP;
+        minus = loss();
+        params[i] = p;
+        numeric = (plus-minus)/(2*STEP);
+        if(fabs(numeric-gradient[i]) > max_difference)
+            max_difference = fabs(numeric-gradient[i]);
+        if(fabs(numeric) > max_numeric)
+            max_numeric = fabs(numeric);
+    }
+    return max_difference/(max_numeric+0.001);
+}
+
+int test_model(int n_layers, int residual_flag){
+    int i,j,k,t,failed = 0;
+    double error;
+    layers = n_layers;
+    srand(SEED+n_layers+residual_flag);
+    lstm** lstms = (lstm**)malloc(sizeof(lstm*)*layers);
+    for(j = 0; j < layers; j++){
+        lstms[j] = recurrent_lstm(SIZE,NO_DROPOUT,0,NO_DROPOUT,0,j,WINDOW,j && residual_flag ? LSTM_RESIDUAL : LSTM_NO_RESIDUAL,NO_NORMALIZATION,0);
+    }
+    m = recurrent_network(layers,layers,lstms,WINDOW,STATELESS);
+    hidden_states = (float**)malloc(sizeof(float*)*layers);
+    cell_states = (float**)malloc(sizeof(float*)*layers);
+    for(j = 0; j < layers; j++){
+        hidden_states[j] = (float*)malloc(sizeof(float)*SIZE);
+        cell_states[j] = (float*)malloc(sizeof(float)*SIZE);
+        for(i = 0; i < SIZE; i++){
+            hidden_states[j][i] = r2()-0.5;
+            cell_states[j][i] = r2()-0.5;
+        }
+    }
+    float* all_inputs = (float*)malloc(sizeof(float)*WINDOW*SIZE);
+    inputs = (float**)malloc(sizeof(float*)*WINDOW);
+    errors = (float**)malloc(sizeof(float*)*WINDOW);
+    for(t = 0; t < WINDOW; t++){
+        inputs[t] = &all_inputs[t*SIZE];
+        errors[t] = (float*)malloc(sizeof(float)*SIZE);
+        for(i = 0; i < SIZE; i++){
+            inputs[t][i] = r2()*2-1;
+            errors[t][i] = r2()*2-1;
+        }
+    }
+
+    // the analytic gradients
+    loss();
+    float** input_error = (float**)malloc(sizeof(float*)*WINDOW);
+    float*** ret = bp_rmodel_lstm(hidden_states,cell_states,inputs,errors,WINDOW,SIZE,layers,m->lstms,input_error);
+    float* input_gradient = (float*)malloc(sizeof(float)*WINDOW*SIZE);
+    for(t = 0; t < WINDOW; t++){
+        copy_array(input_error[t],&input_gradient[t*SIZE],SIZE);
+        free(input_error[t]);
+    }
+    float*** gradients = (float***)malloc(sizeof(float**)*layers);
+    float** hidden_gradients = (float**)malloc(sizeof(float*)*layers);
+    for(j = 0; j < layers; j++){
+        hidden_gradients[j] = lstm_dh(0,SIZE,ret[j],m->lstms[j]);
+        free_matrix(ret[j],4);
+        gradients[j] = (float**)malloc(sizeof(float*)*12);
+        for(k = 0; k < 4; k++){
+            gradients[j][k] = (float*)malloc(sizeof(float)*SIZE*SIZE);
+            gradients[j][4+k] = (float*)malloc(sizeof(float)*SIZE*SIZE);
+            gradients[j][8+k] = (float*)malloc(sizeof(float)*SIZE);
+            copy_array(m->lstms[j]->d_w[k],gradients[j][k],SIZE*SIZE);
+            copy_array(m->lstms[j]->d_u[k],gradients[j][4+k],SIZE*SIZE);
+            copy_array(m->lstms[j]->d_biases[k],gradients[j][8+k],SIZE);
+        }
+    }
+    free(ret);
+
+    for(j = 0; j < layers; j++){
+        for(k = 0; k < 4; k++){
+            if((error = check(m->lstms[j]->w[k],gradients[j][k],SIZE*SIZE)) > TOLERANCE){
+                printf("layers %d residual %d: the gradient of w[%d] of the layer %d is wrong (%g)\n",n_layers,residual_flag,k,j,error);
+                failed = 1;
+            }
+            if((error = check(m->lstms[j]->u[k],gradients[j][4+k],SIZE*SIZE)) > TOLERANCE){
+                printf("layers %d residual %d: the gradient of u[%d] of the layer %d is wrong (%g)\n",n_layers,residual_flag,k,j,error);
+                failed = 1;
+            }
+            if((error = check(m->lstms[j]->biases[k],gradients[j][8+k],SIZE)) > TOLERANCE){
+                printf("layers %d residual %d: the gradient of biases[%d] of the layer %d is wrong (%g)\n",n_layers,residual_flag,k,j,error);
+                failed = 1;
+            }
+        }
+        if((error = check(hidden_states[j],hidden_gradients[j],SIZE)) > TOLERANCE){
+            printf("layers %d residual %d: the error of the hidden state of the layer %d is wrong (%g)\n",n_layers,residual_flag,j,error);
+            failed = 1;
+        }
+        free_matrix(gradients[j],12);
+    }
+    if((error = check(all_inputs,input_gradient,WINDOW*SIZE)) > TOLERANCE){
+        printf("layers %d residual %d: the error of the inputs is wrong (%g)\n",n_layers,residual_flag,error);
+        failed = 1;
+    }
+
+    free(gradients);
+    free_matrix(hidden_gradients,layers);
+    free(input_gradient);
+    free(input_error);
+    free(all_inputs);
+    free(inputs);
+    free_matrix(errors,WINDOW);
+    free_matrix(hidden_states,layers);
+    free_matrix(cell_states,layers);
+    free_rmodel(m);
+    return failed;
+}
+
+int main(){
+    int n_layers,failed = 0;
+    for(n_layers = 1; n_layers <= MAX_LAYERS; n_layers++){
+        failed |= test_model(n_layers,0);
+    }
+    failed |= test_model(MAX_LAYERS,1);
+    if(failed){
+        printf("lstm gradient test failed\n");
+        return 1;
+    }
+    printf("lstm gradient test passed\n");
+    return 0;
+}
@@ -0,0 +1,177 @@
+#include <llab.h>
+#include <math.h>
+
+/* Test of the truncated back propagation through time of a stream:
+ * BATCH sequences of EXTRA+n_chunks chunks go through a stream, the feed forward of each chunk is followed by the back propagation
+ * of its errors. After the last chunk the outputs and the partial derivatives of the stream must be equal to the ones
+ * of a single batched rmodel with a window of n_chunks*WINDOW timesteps, that starts from the states after the first EXTRA chunks
+ * and whose errors are zero outside the last chunk. The test runs with TBPTT_STORE (the ring of the chunks wraps around)
+ * and TBPTT_CHECKPOINT (the older chunks are recomputed in the same batched rmodel), with 1 to 3 chunks, 1 and 2 layers,
+ * with and without dropout
+ * */
+
+#define SIZE 8
+#define WINDOW 3
+#define BATCH 3
+#define EXTRA 2
+#define MAX_CHUNKS 3
+#define MAX_LAYERS 2
+#define SEED 7
+#define TOLERANCE 0.0001
+
+float max_error;
+
+void compare(float* a, float* b, int size){
+    int i;
+    float error;
+    for(i = 0; i < size; i++){
+        error = fabs(a[i]-b[i])/(1+fabs(a[i]));
+        if(error > max_error || error != error)
+            max_error = error;
+    }
+}
+
+rmodel* create_test_model(int layers, int window, int dropout_flag, int seed){
+    int j;
+    srand(seed);
+    lstm** lstms = (lstm**)malloc(sizeof(lstm*)*layers);
+    for(j = 0; j < layers; j++){
+        lstms[j] = recurrent_lstm(SIZE,dropout_flag,0.3,dropout_flag,0.3,j,window,LSTM_NO_RESIDUAL,NO_NORMALIZATION,0);
+    }
+    return recurrent_network(layers,layers,lstms,window,STATEFUL);
+}
+
+/* the reference batched rmodels use the dropout masks of the stream and don't draw new ones*/
+void copy_dropout_masks(srmodel* sm, brmodel* bm){
+    int j;
+    for(j = 0; j < bm->layers; j++){
+        copy_array(sm->chunks[0]->dropout_mask_up[j],bm->dropout_mask_up[j],BATCH*SIZE);
+        copy_array(sm->chunks[0]->dropout_mask_right[j],bm->dropout_mask_right[j],BATCH*SIZE);
+        bm->m->lstms[j]->dropout_flag_up = NO_DROPOUT;
+        bm->m->lstms[j]->dropout_flag_right = NO_DROPOUT;
+    }
+}
+
+int test_stream(int memory_flag, int layers, int n_chunks, int dropout_flag){
+    int i,j,k,t,b,c,chunks = EXTRA+n_chunks,long_window = n_chunks*WINDOW,seed = SEED+layers*7+n_chunks;
+    rmodel* m = create_test_model(layers,WINDOW,dropout_flag,seed);
+    // same seed, same weights
+    rmodel* prefix = create_test_model(layers,EXTRA*WINDOW,dropout_flag,seed);
+    rmodel* reference = create_test_model(layers,long_window,dropout_flag,seed);
+    srmodel* sm = stream_rmodel(m,BATCH,n_chunks,memory_flag);
+
+    float*** inputs = (float***)malloc(sizeof(float**)*BATCH);
+    float*** errors = (float***)malloc(sizeof(float**)*BATCH);
+    float*** reference_errors = (float***)malloc(sizeof(float**)*BATCH);
+    float*** chunk_inputs = (float***)malloc(sizeof(float**)*BATCH);
+    float*** chunk_errors = (float***)malloc(sizeof(float**)*BATCH);
+    for(b = 0; b < BATCH; b++){
+        inputs[b] = (float**)malloc(sizeof(float*)*chunks*WINDOW);
+        errors[b] = (float**)malloc(sizeof(float*)*chunks*WINDOW);
+        reference_errors[b] = (float**)malloc(sizeof(float*)*long_window);
+        for(t = 0; t < chunks*WINDOW; t++){
+            inputs[b][t] = (float*)malloc(sizeof(float)*SIZE);
+            errors[b][t] = (float*)malloc(sizeof(float)*SIZE);
+            for(i = 0; i < SIZE; i++){
+                inputs[b][t][i] = r2()*2-1;
+                errors[b][t][i] = r2()-0.5;
+            }
+        }
+        for(t = 0; t < long_window; t++){
+            reference_errors[b][t] = (float*)calloc(SIZE,sizeof(float));
+            if(t >= long_window-WINDOW)
+                copy_array(errors[b][(EXTRA+n_chunks-1)*WINDOW+t-(long_window-WINDOW)],reference_errors[b][t],SIZE);
+        }
+    }
+
+    // the stream
+    for(c = 0; c < chunks; c++){
+        for(b = 0; b < BATCH; b++){
+            chunk_inputs[b] = &inputs[b][c*WINDOW];
+            chunk_errors[b] = &errors[b][c*WINDOW];
+        }
+        reset_stream_rmodel(sm);
+        ff_stream_rmodel(sm,chunk_inputs);
+        bp_stream_rmodel(sm,chunk_errors);
+    }
+
+    // the states after the first EXTRA chunks
+    brmodel* bp = batch_rmodel(prefix,BATCH);
+    copy_dropout_masks(sm,bp);
+    ff_rmodel_batch(bp,inputs);
+
+    // the single long window
+    brmodel* br = batch_rmodel(reference,BATCH);
+    copy_dropout_masks(sm,br);
+    for(j = 0; j < layers; j++){
+        copy_array(&bp->hidden[j][(EXTRA*WINDOW-1)*BATCH*SIZE],br->hidden_states[j],BATCH*SIZE);
+        copy_array(&bp->cell[j][(EXTRA*WINDOW-1)*BATCH*SIZE],br->cell_states[j],BATCH*SIZE);
+    }
+    for(b = 0; b < BATCH; b++){
+        chunk_inputs[b] = &inputs[b][EXTRA*WINDOW];
+    }
+    ff_rmodel_batch(br,chunk_inputs);
+    bp_rmodel_batch(br,reference_errors);
+
+    max_error = 0;
+    // the outputs of the last chunk are valid only with TBPTT_STORE after the back propagation
+    if(memory_flag == TBPTT_STORE){
+        for(b = 0; b < BATCH; b++){
+            for(t = 0; t < WINDOW; t++){
+                compare(get_batch_rmodel_output(br,b,long_window-WINDOW+t),get_stream_rmodel_output(sm,b,t),SIZE);
+            }
+        }
+    }
+    for(j = 0; j < layers; j++){
+        for(k = 0; k < 4; k++){
+            compare(reference->lstms[j]->d_w[k],m->lstms[j]->d_w[k],SIZE*SIZE);
+            compare(reference->lstms[j]->d_u[k],m->lstms[j]->d_u[k],SIZE*SIZE);
+            compare(reference->lstms[j]->d_biases[k],m->lstms[j]->d_biases[k],SIZE);
+        }
+    }
+
+    free_batch_rmodel(bp);
+    free_batch_rmodel(br);
+    free_stream_rmodel(sm);
+    free_rmodel(m);
+    free_rmodel(prefix);
+    free_rmodel(reference);
+    for(b = 0; b < BATCH; b++){
+        for(t = 0; t < chunks*WINDOW; t++){
+            free(inputs[b][t]);
+            free(errors[b][t]);
+        }
+        free(inputs[b]);
+        free(errors[b]);
+        free_matrix(reference_errors[b],long_window);
+    }
+    free(inputs);
+    free(errors);
+    free(reference_errors);
+    free(chunk_inputs);
+    free(chunk_errors);
+
+    if(max_error > TOLERANCE){
+        printf("%s, %d layers, %d chunks, dropout %d: the stream is different from a single window (%g)\n",memory_flag == TBPTT_STORE ? "TBPTT_STORE" : "TBPTT_CHECKPOINT",layers,n_chunks,dropout_flag == DROPOUT,max_error);
+        return 1;
+    }
+    return 0;
+}
+
+int main(){
+    int layers,n_chunks,failed = 0;
+    for(layers = 1; layers <= MAX_LAYERS; layers++){
+        for(n_chunks = 1; n_chunks <= MAX_CHUNKS; n_chunks++){
+            failed |= test_stream(TBPTT_STORE,layers,n_chunks,NO_DROPOUT);
+            failed |= test_stream(TBPTT_STORE,layers,n_chunks,DROPOUT);
+            failed |= test_stream(TBPTT_CHECKPOINT,layers,n_chunks,NO_DROPOUT);
+            failed |= test_stream(TBPTT_CHECKPOINT,layers,n_chunks,DROPOUT);
+        }
+    }
+    if(failed){
+        printf("stream rmodel test failed\n");
+        return 1;
+    }
+    printf("stream rmodel test passed\n");
+    return 0;
+}
@@ -0,0 +1,234 @@
+#include <llab.h>
+#include <math.h>
+
+/* Gradient test of bp_recurrent_enc_dec:
+ * the partial derivatives of the attention weights and biases, of w, u and the biases of each layer of the decoder and of the encoder
+ * and the errors of the inputs of the encoder and of the decoder are compared with central differences of the loss
+ * sum(error_model[t]*output[t]) of the last layer of the decoder. The encoder decoders have 1, 2 and 3 layers, the last one
+ * also with a residual connection in the middle layer of the encoder and of the decoder. The encoder gradients go through the attention values, the first query
+ * and the states passed to the decoder (through the u of the decoder)
+ * */
+
+#define ENCODER_SIZE 6
+#define DECODER_SIZE 10
+#define ENCODER_WINDOW 5
+#define DECODER_WINDOW 4
+#define MAX_LAYERS 3
+#define SAMPLES 23// the parameters of each array that are checked
+#define STEP 0.01
+#define TOLERANCE 0.02
+#define SEED 7
+
+int layers;
+recurrent_enc_dec* rec;
+float** hidden_states;
+float** cell_states;
+float** inputs1;
+float** inputs2;
+float** errors;
+
+double loss(){
+    int i,t;
+    double sum = 0;
+    reset_recurrent_enc_dec(rec);
+    ff_recurrent_enc_dec(hidden_states,cell_states,inputs1,inputs2,rec);
+    for(t = 0; t < DECODER_WINDOW; t++){
+        for(i = 0; i < DECODER_SIZE; i++){
+            sum+=errors[t][i]*rec->decoder->lstms[layers-1]->out_up[t][i];
+        }
+    }
+    return sum;
+}
+
+/* the max difference between the gradient and the central differences, relative to the max central difference*/
+double check(float* params, float* gradient, int size){
+    int i,step = size/SAMPLES+1;
+    float p;
+    double plus,minus,numeric,max_difference = 0,max_numeric = 0;
+    for(i = 0; i < size; i+=step){
+        p = params[i];
+        params[i] = p+STEP;
+        plus = loss();
+        params[i] = p-STEP;
+        minus = loss();
+        params[i] = p;
+        numeric = (plus-minus)/(2*STEP);
+        if(fabs(numeric-gradient[i]) > max_difference)
+            max_difference = fabs(numeric-gradient[i]);
+        if(fabs(numeric) > max_numeric)
+            max_numeric = fabs(numeric);
+    }
+    return max_difference/(max_numeric+0.001);
+}
+
+/* the analytic gradients of the layer are copied before any other feed forward, then checked*/
+int check_lstm(lstm* l, char* name, int layer, int size){
+    int k,failed = 0;
+    double error;
+    float** gradient = (float**)malloc(sizeof(float*)*12);
+    for(k = 0; k < 4; k++){
+        gradient[k] = (float*)malloc(sizeof(float)*size*size);
+        gradient[4+k] = (float*)malloc(sizeof(float)*size*size);
+        gradient[8+k] = (float*)malloc(sizeof(float)*size);
+        copy_array(l->d_w[k],gradient[k],size*size);
+        copy_array(l->d_u[k],gradient[4+k],size*size);
+        copy_array(l->d_biases[k],gradient[8+k],size);
+    }
+    for(k = 0; k < 4; k++){
+        if((error = check(l->w[k],gradient[k],size*size)) > TOLERANCE){
+            printf("layers %d: the gradient of w[%d] of the layer %d of the %s is wrong (%g)\n",layers,k,layer,name,error);
+            failed = 1;
+        }
+        if((error = check(l->u[k],gradient[4+k],size*size)) > TOLERANCE){
+            printf("layers %d: the gradient of u[%d] of the layer %d of the %s is wrong (%g)\n",layers,k,layer,name,error);
+            failed = 1;
+        }
+        if((error = check(l->biases[k],gradient[8+k],size)) > TOLERANCE){
+            printf("layers %d: the gradient of biases[%d] of the layer %d of the %s is wrong (%g)\n",layers,k,layer,name,error);
+            failed = 1;
+        }
+    }
+    free_matrix(gradient,12);
+    return failed;
+}
+
+/* the analytic gradients are computed again before each check, because each check changes the partial derivatives*/
+void gradients(float** input_error1, float** input_error2){
+    int j;
+    loss();
+    float** input_error = (float**)malloc(sizeof(float*)*ENCODER_WINDOW);
+    float*** ret = bp_recurrent_enc_dec(hidden_states,cell_states,inputs1,inputs2,errors,rec,input_error,input_error2);
+    for(j = 0; j < ENCODER_WINDOW; j++){
+        copy_array(input_error[j],input_error1[j],ENCODER_SIZE);
+    }
+    free_matrix(input_error,ENCODER_WINDOW);
+    for(j = 0; j < layers; j++){
+        free_matrix(ret[j],4);
+    }
+    free(ret);
+}
+
+int test_enc_dec(int n_layers, int residual_flag){
+    int i,j,t,failed = 0;
+    double error;
+    layers = n_layers;
+    srand(SEED+n_layers+residual_flag);
+    lstm** encoder = (lstm**)malloc(sizeof(lstm*)*layers);
+    lstm** decoder = (lstm**)malloc(sizeof(lstm*)*layers);
+    for(j = 0; j < layers; j++){
+        encoder[j] = recurrent_lstm(ENCODER_SIZE,NO_DROPOUT,0,NO_DROPOUT,0,j,ENCODER_WINDOW,residual_flag && j && j < layers-1 ? LSTM_RESIDUAL : LSTM_NO_RESIDUAL,NO_NORMALIZATION,0);
+        decoder[j] = recurrent_lstm(DECODER_SIZE,NO_DROPOUT,0,NO_DROPOUT,0,j,DECODER_WINDOW,residual_flag && j && j < layers-1 ? LSTM_RESIDUAL : LSTM_NO_RESIDUAL,NO_NORMALIZATION,0);
+    }
+    rec = recurrent_enc_dec_network(recurrent_network(layers,layers,encoder,ENCODER_WINDOW,STATELESS),recurrent_network(layers,layers,decoder,DECODER_WINDOW,STATELESS));
+
+    // larger attention weights, so the softmax is not almost uniform
+    fcl* f = rec->m[0]->fcls[0];
+    for(i = 0; i < f->input*f->output; i++){
+        f->weights[i]*=8;
+    }
+
+    hidden_states = (float**)malloc(sizeof(float*)*layers);
+    cell_states = (float**)malloc(sizeof(float*)*layers);
+    for(j = 0; j < layers; j++){
+        hidden_states[j] = (float*)malloc(sizeof(float)*ENCODER_SIZE);
+        cell_states[j] = (float*)malloc(sizeof(float)*ENCODER_SIZE);
+        for(i = 0; i < ENCODER_SIZE; i++){
+            hidden_states[j][i] = r2()-0.5;
+            cell_states[j][i] = r2()-0.5;
+        }
+    }
+    float* all_inputs1 = (float*)malloc(sizeof(float)*ENCODER_WINDOW*ENCODER_SIZE);
+    float* all_inputs2 = (float*)malloc(sizeof(float)*DECODER_WINDOW*(DECODER_SIZE-ENCODER_SIZE));
+    inputs1 = (float**)malloc(sizeof(float*)*ENCODER_WINDOW);
+    inputs2 = (float**)malloc(sizeof(float*)*DECODER_WINDOW);
+    errors = (float**)malloc(sizeof(float*)*DECODER_WINDOW);
+    for(t = 0; t < ENCODER_WINDOW; t++){
+        inputs1[t] = &all_inputs1[t*ENCODER_SIZE];
+        for(i = 0; i < ENCODER_SIZE; i++){
+            inputs1[t][i] = r2()*2-1;
+        }
+    }
+    for(t = 0; t < DECODER_WINDOW; t++){
+        inputs2[t] = &all_inputs2[t*(DECODER_SIZE-ENCODER_SIZE)];
+        errors[t] = (float*)malloc(sizeof(float)*DECODER_SIZE);
+        for(i = 0; i < DECODER_SIZE-ENCODER_SIZE; i++){
+            inputs2[t][i] = r2()*2-1;
+        }
+        for(i = 0; i < DECODER_SIZE; i++){
+            errors[t][i] = r2()*2-1;
+        }
+    }
+    float** input_error1 = (float**)malloc(sizeof(float*)*ENCODER_WINDOW);
+    float** input_error2 = (float**)malloc(sizeof(float*)*DECODER_WINDOW);
+    for(t = 0; t < ENCODER_WINDOW; t++){
+        input_error1[t] = (float*)malloc(sizeof(float)*ENCODER_SIZE);
+    }
+    for(t = 0; t < DECODER_WINDOW; t++){
+        input_error2[t] = (float*)malloc(sizeof(float)*(DECODER_SIZE-ENCODER_SIZE));
+    }
+    float* input_gradient1 = (float*)malloc(sizeof(float)*ENCODER_WINDOW*ENCODER_SIZE);
+    float* input_gradient2 = (float*)malloc(sizeof(float)*DECODER_WINDOW*(DECODER_SIZE-ENCODER_SIZE));
+    float* gradient = (float*)malloc(sizeof(float)*f->input*f->output);
+
+    gradients(input_error1,input_error2);
+    for(t = 0; t < ENCODER_WINDOW; t++){
+        copy_array(input_error1[t],&input_gradient1[t*ENCODER_SIZE],ENCODER_SIZE);
+    }
+    for(t = 0; t < DECODER_WINDOW; t++){
+        copy_array(input_error2[t],&input_gradient2[t*(DECODER_SIZE-ENCODER_SIZE)],DECODER_SIZE-ENCODER_SIZE);
+    }
+    copy_array(f->d_weights,gradient,f->input*f->output);
+    if((error = check(f->weights,gradient,f->input*f->output)) > TOLERANCE){
+        printf("layers %d: the gradient of the attention weights is wrong (%g)\n",layers,error);
+        failed = 1;
+    }
+    gradients(input_error1,input_error2);
+    copy_array(f->d_biases,gradient,f->output);
+    if((error = check(f->biases,gradient,f->output)) > TOLERANCE){
+        printf("layers %d: the gradient of the attention biases is wrong (%g)\n",layers,error);
+        failed = 1;
+    }
+    if((error = check(all_inputs1,input_gradient1,ENCODER_WINDOW*ENCODER_SIZE)) > TOLERANCE){
+        printf("layers %d: the error of the inputs of the encoder is wrong (%g)\n",layers,error);
+        failed = 1;
+    }
+    if((error = check(all_inputs2,input_gradient2,DECODER_WINDOW*(DECODER_SIZE-ENCODER_SIZE))) > TOLERANCE){
+        printf("layers %d: the error of the inputs of the decoder is wrong (%g)\n",layers,error);
+        failed = 1;
+    }
+    for(j = 0; j < layers; j++){
+        gradients(input_error1,input_error2);
+        failed |= check_lstm(rec->decoder->lstms[j],"decoder",j,DECODER_SIZE);
+        gradients(input_error1,input_error2);
+        failed |= check_lstm(rec->encoder->lstms[j],"encoder",j,ENCODER_SIZE);
+    }
+
+    free(gradient);
+    free(input_gradient1);
+    free(input_gradient2);
+    free_matrix(input_error1,ENCODER_WINDOW);
+    free_matrix(input_error2,DECODER_WINDOW);
+    free(all_inputs1);
+    free(all_inputs2);
+    free(inputs1);
+    free(inputs2);
+    free_matrix(errors,DECODER_WINDOW);
+    free_matrix(hidden_states,layers);
+    free_matrix(cell_states,layers);
+    free_recurrent_enc_dec(rec);
+    return failed;
+}
+
+int main(){
+    int n_layers,failed = 0;
+    for(n_layers = 1; n_layers <= MAX_LAYERS; n_layers++){
+        failed |= test_enc_dec(n_layers,0);
+    }
+    failed |= test_enc_dec(MAX_LAYERS,1);
+    if(failed){
+        printf("recurrent encoder decoder gradient test failed\n");
+        return 1;
+    }
+    printf("recurrent encoder decoder gradient test passed\n");
+    return 0;
+}
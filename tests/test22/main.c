@@ -0,0 +1,201 @@
+#include <llab.h>
+#include <math.h>
+
+/* Gradient test of bp_rmodel_workspace (bp_lstm_window):
+ * the partial derivatives of w, u and the biases of each layer, the errors of the inputs and the errors of the hidden
+ * and cell states passed to the first timestep (left in bp_temp) are compared with central differences of the loss
+ * sum(error_model[t]*output[t]) + sum(hidden_states_error[j]*h[j]) + sum(cell_states_error[j]*c[j]), where h[j] and c[j]
+ * are the states of the last timestep. The models have 1 and 3 layers, with a residual connection, with dropout
+ * (the masks are drawn once and then frozen) and stateful (the errors of the last states are carried by the next window)
+ * */
+
+#define SIZE 6
+#define WINDOW 5
+#define MAX_LAYERS 3
+#define STEP 0.01
+#define TOLERANCE 0.02
+#define SEED 5
+
+int layers;
+int stateful;
+rmodel* m;
+float** hidden_states;
+float** cell_states;
+float** hidden_states_error;
+float** cell_states_error;
+float** inputs;
+float** errors;
+
+double loss(){
+    int i,j,t;
+    double sum = 0;
+    reset_rmodel(m);
+    ff_rmodel(hidden_states,cell_states,inputs,m);
+    for(t = 0; t < WINDOW; t++){
+        for(i = 0; i < SIZE; i++){
+            sum+=errors[t][i]*m->lstms[layers-1]->out_up[t][i];
+        }
+    }
+    for(j = 0; stateful && j < layers; j++){
+        for(i = 0; i < SIZE; i++){
+            sum+=hidden_states_error[j][i]*m->lstms[j]->lstm_hidden[WINDOW-1][i];
+            sum+=cell_states_error[j][i]*m->lstms[j]->lstm_cell[WINDOW-1][i];
+        }
+    }
+    return sum;
+}
+
+/* the max difference between the gradient and the central differences, relative to the max central difference*/
+double check(float* params, float* gradient, int size){
+    int i;
+    float p;
+    double plus,minus,numeric,max_difference = 0,max_numeric = 0;
+    for(i = 0; i < size; i++){
+        p = params[i];
+        params[i] = p+STEP;
+        plus = loss();
+        params[i] = p-STEP;
+        minus = loss();
+        params[i] = p;
+        numeric = (plus-minus)/(2*STEP);
+        if(fabs(numeric-gradient[i]) > max_difference)
+            max_difference = fabs(numeric-gradient[i]);
+        if(fabs(numeric) > max_numeric)
+            max_numeric = fabs(numeric);
+    }
+    return max_difference/(max_numeric+0.001);
+}
+
+int test_model(int n_layers, int residual_flag, int dropout_flag, int stateful_flag){
+    int i,j,k,t,failed = 0;
+    double error;
+    layers = n_layers;
+    stateful = stateful_flag;
+    srand(SEED+n_layers+residual_flag*3+dropout_flag*5+stateful_flag*7);
+    lstm** lstms = (lstm**)malloc(sizeof(lstm*)*layers);
+    for(j = 0; j < layers; j++){
+        lstms[j] = recurrent_lstm(SIZE,j < layers-1 ? dropout_flag : NO_DROPOUT,0.3,dropout_flag,0.3,j,WINDOW,residual_flag && j && j < layers-1 ? LSTM_RESIDUAL : LSTM_NO_RESIDUAL,NO_NORMALIZATION,0);
+    }
+    m = recurrent_network(layers,layers,lstms,WINDOW,stateful_flag ? STATEFUL : STATELESS);
+    hidden_states = (float**)malloc(sizeof(float*)*layers);
+    cell_states = (float**)malloc(sizeof(float*)*layers);
+    hidden_states_error = (float**)malloc(sizeof(float*)*layers);
+    cell_states_error = (float**)malloc(sizeof(float*)*layers);
+    for(j = 0; j < layers; j++){
+        hidden_states[j] = (float*)calloc(SIZE,sizeof(float));
+        cell_states[j] = (float*)calloc(SIZE,sizeof(float));
+        hidden_states_error[j] = (float*)malloc(sizeof(float)*SIZE);
+        cell_states_error[j] = (float*)malloc(sizeof(float)*SIZE);
+        for(i = 0; i < SIZE; i++){
+            if(stateful_flag){
+                hidden_states[j][i] = r2()-0.5;
+                cell_states[j][i] = r2()-0.5;
+            }
+            hidden_states_error[j][i] = r2()*2-1;
+            cell_states_error[j][i] = r2()*2-1;
+        }
+    }
+    float* all_inputs = (float*)malloc(sizeof(float)*WINDOW*SIZE);
+    inputs = (float**)malloc(sizeof(float*)*WINDOW);
+    errors = (float**)malloc(sizeof(float*)*WINDOW);
+    float** input_error = (float**)malloc(sizeof(float*)*WINDOW);
+    for(t = 0; t < WINDOW; t++){
+        inputs[t] = &all_inputs[t*SIZE];
+        errors[t] = (float*)malloc(sizeof(float)*SIZE);
+        input_error[t] = (float*)malloc(sizeof(float)*SIZE);
+        for(i = 0; i < SIZE; i++){
+            inputs[t][i] = r2()*2-1;
+            errors[t][i] = r2()*2-1;
+        }
+    }
+
+    // the dropout masks are drawn by the first feed forward and then kept
+    loss();
+    for(j = 0; j < layers; j++){
+        m->lstms[j]->dropout_flag_up = NO_DROPOUT;
+        m->lstms[j]->dropout_flag_right = NO_DROPOUT;
+    }
+
+    // the analytic gradients
+    loss();
+    bp_rmodel_workspace(hidden_states,cell_states,inputs,errors,m,input_error,stateful_flag ? hidden_states_error : NULL,stateful_flag ? cell_states_error : NULL);
+    float* input_gradient = (float*)malloc(sizeof(float)*WINDOW*SIZE);
+    for(t = 0; t < WINDOW; t++){
+        copy_array(input_error[t],&input_gradient[t*SIZE],SIZE);
+    }
+    float*** gradients = (float***)malloc(sizeof(float**)*layers);
+    for(j = 0; j < layers; j++){
+        gradients[j] = (float**)malloc(sizeof(float*)*14);
+        for(k = 0; k < 4; k++){
+            gradients[j][k] = (float*)malloc(sizeof(float)*SIZE*SIZE);
+            gradients[j][4+k] = (float*)malloc(sizeof(float)*SIZE*SIZE);
+            gradients[j][8+k] = (float*)malloc(sizeof(float)*SIZE);
+            copy_array(m->lstms[j]->d_w[k],gradients[j][k],SIZE*SIZE);
+            copy_array(m->lstms[j]->d_u[k],gradients[j][4+k],SIZE*SIZE);
+            copy_array(m->lstms[j]->d_biases[k],gradients[j][8+k],SIZE);
+        }
+        gradients[j][12] = (float*)malloc(sizeof(float)*SIZE);
+        gradients[j][13] = (float*)malloc(sizeof(float)*SIZE);
+        copy_array(m->lstms[j]->bp_temp,gradients[j][12],SIZE);
+        copy_array(&m->lstms[j]->bp_temp[SIZE],gradients[j][13],SIZE);
+    }
+
+    for(j = 0; j < layers; j++){
+        for(k = 0; k < 4; k++){
+            if((error = check(m->lstms[j]->w[k],gradients[j][k],SIZE*SIZE)) > TOLERANCE){
+                printf("layers %d residual %d dropout %d stateful %d: the gradient of w[%d] of the layer %d is wrong (%g)\n",n_layers,residual_flag,dropout_flag,stateful_flag,k,j,error);
+                failed = 1;
+            }
+            if((error = check(m->lstms[j]->u[k],gradients[j][4+k],SIZE*SIZE)) > TOLERANCE){
+                printf("layers %d residual %d dropout %d stateful %d: the gradient of u[%d] of the layer %d is wrong (%g)\n",n_layers,residual_flag,dropout_flag,stateful_flag,k,j,error);
+                failed = 1;
+            }
+            if((error = check(m->lstms[j]->biases[k],gradients[j][8+k],SIZE)) > TOLERANCE){
+                printf("layers %d residual %d dropout %d stateful %d: the gradient of biases[%d] of the layer %d is wrong (%g)\n",n_layers,residual_flag,dropout_flag,stateful_flag,k,j,error);
+                failed = 1;
+            }
+        }
+        if((error = check(hidden_states[j],gradients[j][12],SIZE)) > TOLERANCE){
+            printf("layers %d residual %d dropout %d stateful %d: the error of the hidden state of the layer %d is wrong (%g)\n",n_layers,residual_flag,dropout_flag,stateful_flag,j,error);
+            failed = 1;
+        }
+        if((error = check(cell_states[j],gradients[j][13],SIZE)) > TOLERANCE){
+            printf("layers %d residual %d dropout %d stateful %d: the error of the cell state of the layer %d is wrong (%g)\n",n_layers,residual_flag,dropout_flag,stateful_flag,j,error);
+            failed = 1;
+        }
+        free_matrix(gradients[j],14);
+    }
+    if((error = check(all_inputs,input_gradient,WINDOW*SIZE)) > TOLERANCE){
+        printf("layers %d residual %d dropout %d stateful %d: the error of the inputs is wrong (%g)\n",n_layers,residual_flag,dropout_flag,stateful_flag,error);
+        failed = 1;
+    }
+
+    free(gradients);
+    free(input_gradient);
+    free_matrix(input_error,WINDOW);
+    free(all_inputs);
+    free(inputs);
+    free_matrix(errors,WINDOW);
+    free_matrix(hidden_states,layers);
+    free_matrix(cell_states,layers);
+    free_matrix(hidden_states_error,layers);
+    free_matrix(cell_states_error,layers);
+    free_rmodel(m);
+    return failed;
+}
+
+int main(){
+    int failed = 0;
+    failed |= test_model(1,0,NO_DROPOUT,0);
+    failed |= test_model(MAX_LAYERS,0,NO_DROPOUT,0);
+    failed |= test_model(MAX_LAYERS,1,NO_DROPOUT,0);
+    failed |= test_model(MAX_LAYERS,0,DROPOUT,0);
+    failed |= test_model(1,0,NO_DROPOUT,1);
+    failed |= test_model(MAX_LAYERS,1,DROPOUT,1);
+    if(failed){
+        printf("lstm workspace gradient test failed\n");
+        return 1;
+    }
+    printf("lstm workspace gradient test passed\n");
+    return 0;
+}
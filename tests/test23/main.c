@@ -0,0 +1,333 @@
+#include <llab.h>
+#include <math.h>
+
+/* Test of the gru layers of the rmodel:
+ * the partial derivatives of w, u and the biases of each layer, the errors of the inputs and of the hidden states
+ * passed to the first timestep computed by bp_rmodel and by bp_rmodel_workspace are compared with central differences
+ * of the loss sum(error_model[t]*output[t]), for gru stacks with and without a residual connection and for mixed lstm/gru stacks.
+ * Then a mixed rmodel is saved and loaded (save_rmodel, heavy_save_rmodel) and an lstm rmodel is written by hand
+ * with the layout of the files saved before the gru layers (no cell type tag) and loaded: the parameters and the outputs
+ * of the loaded rmodels must be equal to the ones of the original rmodel
+ * */
+
+#define SIZE 6
+#define WINDOW 5
+#define MAX_LAYERS 3
+#define STEP 0.01
+#define TOLERANCE 0.02
+#define SEED 11
+#define FILE_NAME 23
+#define FILE_STRING "23.bin"
+
+int layers;
+rmodel* m;
+float** hidden_states;
+float** cell_states;
+float** inputs;
+float** errors;
+
+double loss(){
+    int i,t;
+    double sum = 0;
+    reset_rmodel(m);
+    ff_rmodel(hidden_states,cell_states,inputs,m);
+    for(t = 0; t < WINDOW; t++){
+        for(i = 0; i < SIZE; i++){
+            sum+=errors[t][i]*m->lstms[layers-1]->out_up[t][i];
+        }
+    }
+    return sum;
+}
+
+/* the max difference between the gradient and the central differences, relative to the max central difference*/
+double check(float* params, float* gradient, int size){
+    int i;
+    float p;
+    double plus,minus,numeric,max_difference = 0,max_numeric = 0;
+    for(i = 0; i < size; i++){
+        p = params[i];
+        params[i] = p+STEP;
+        plus = loss();
+        params[i] = p-STEP;
+        minus = loss();
+        params[i] = p;
+        numeric = (plus-minus)/(2*STEP);
+        if(fabs(numeric-gradient[i]) > max_difference)
+            max_difference = fabs(numeric-gradient[i]);
+        if(fabs(numeric) > max_numeric)
+            max_numeric = fabs(numeric);
+    }
+    return max_difference/(max_numeric+0.001);
+}
+
+/* the analytic gradients of each layer: w, u and biases of each gate, then the error of the first hidden state.
+ * The errors of the inputs are written in input_gradient*/
+float*** gradients(int workspace_flag, float* input_gradient){
+    int j,k,t,n_gates;
+    float** input_error = (float**)malloc(sizeof(float*)*WINDOW);
+    float*** ret = NULL;
+    float*** g = (float***)malloc(sizeof(float**)*layers);
+    loss();
+    if(workspace_flag){
+        for(t = 0; t < WINDOW; t++){
+            input_error[t] = (float*)malloc(sizeof(float)*SIZE);
+        }
+        bp_rmodel_workspace(hidden_states,cell_states,inputs,errors,m,input_error,NULL,NULL);
+    }
+    else
+        ret = bp_rmodel(hidden_states,cell_states,inputs,errors,m,input_error);
+    for(t = 0; t < WINDOW; t++){
+        copy_array(input_error[t],&input_gradient[t*SIZE],SIZE);
+    }
+    free_matrix(input_error,WINDOW);
+    for(j = 0; j < layers; j++){
+        n_gates = m->lstms[j]->n_gates;
+        g[j] = (float**)malloc(sizeof(float*)*(3*n_gates+1));
+        for(k = 0; k < n_gates; k++){
+            g[j][k] = (float*)malloc(sizeof(float)*SIZE*SIZE);
+            g[j][n_gates+k] = (float*)malloc(sizeof(float)*SIZE*SIZE);
+            g[j][2*n_gates+k] = (float*)malloc(sizeof(float)*SIZE);
+            copy_array(m->lstms[j]->d_w[k],g[j][k],SIZE*SIZE);
+            copy_array(m->lstms[j]->d_u[k],g[j][n_gates+k],SIZE*SIZE);
+            copy_array(m->lstms[j]->d_biases[k],g[j][2*n_gates+k],SIZE);
+        }
+        if(workspace_flag){
+            g[j][3*n_gates] = (float*)malloc(sizeof(float)*SIZE);
+            copy_array(m->lstms[j]->bp_temp,g[j][3*n_gates],SIZE);
+        }
+        else{
+            // the row 3 of a gru is the error of the first hidden state
+            if(m->lstms[j]->cell_type == GRU_CELL){
+                g[j][3*n_gates] = (float*)malloc(sizeof(float)*SIZE);
+                copy_array(ret[j][3],g[j][3*n_gates],SIZE);
+            }
+            else
+                g[j][3*n_gates] = lstm_dh(0,SIZE,ret[j],m->lstms[j]);
+            free_matrix(ret[j],4);
+        }
+    }
+    free(ret);
+    return g;
+}
+
+int test_model(int* cell_types, int n_layers, int residual_flag, int workspace_flag){
+    int i,j,k,t,n_gates,failed = 0;
+    double error;
+    layers = n_layers;
+    srand(SEED+n_layers+residual_flag*3+cell_types[0]*5);
+    lstm** lstms = (lstm**)malloc(sizeof(lstm*)*layers);
+    for(j = 0; j < layers; j++){
+        lstms[j] = recurrent_cell(cell_types[j],SIZE,NO_DROPOUT,0,NO_DROPOUT,0,j,WINDOW,residual_flag && j && j < layers-1 ? LSTM_RESIDUAL : LSTM_NO_RESIDUAL,NO_NORMALIZATION,0);
+    }
+    m = recurrent_network(layers,layers,lstms,WINDOW,STATELESS);
+    hidden_states = (float**)malloc(sizeof(float*)*layers);
+    cell_states = (float**)malloc(sizeof(float*)*layers);
+    for(j = 0; j < layers; j++){
+        hidden_states[j] = (float*)malloc(sizeof(float)*SIZE);
+        cell_states[j] = (float*)malloc(sizeof(float)*SIZE);
+        for(i = 0; i < SIZE; i++){
+            hidden_states[j][i] = r2()-0.5;
+            cell_states[j][i] = r2()-0.5;
+        }
+    }
+    float* all_inputs = (float*)malloc(sizeof(float)*WINDOW*SIZE);
+    inputs = (float**)malloc(sizeof(float*)*WINDOW);
+    errors = (float**)malloc(sizeof(float*)*WINDOW);
+    for(t = 0; t < WINDOW; t++){
+        inputs[t] = &all_inputs[t*SIZE];
+        errors[t] = (float*)malloc(sizeof(float)*SIZE);
+        for(i = 0; i < SIZE; i++){
+            inputs[t][i] = r2()*2-1;
+            errors[t][i] = r2()*2-1;
+        }
+    }
+
+    float* input_gradient = (float*)malloc(sizeof(float)*WINDOW*SIZE);
+    float*** g = gradients(workspace_flag,input_gradient);
+
+    for(j = 0; j < layers; j++){
+        n_gates = m->lstms[j]->n_gates;
+        for(k = 0; k < n_gates; k++){
+            if((error = check(m->lstms[j]->w[k],g[j][k],SIZE*SIZE)) > TOLERANCE){
+                printf("%s, layers %d residual %d: the gradient of w[%d] of the layer %d is wrong (%g)\n",workspace_flag ? "bp_rmodel_workspace" : "bp_rmodel",n_layers,residual_flag,k,j,error);
+                failed = 1;
+            }
+            if((error = check(m->lstms[j]->u[k],g[j][n_gates+k],SIZE*SIZE)) > TOLERANCE){
+                printf("%s, layers %d residual %d: the gradient of u[%d] of the layer %d is wrong (%g)\n",workspace_flag ? "bp_rmodel_workspace" : "bp_rmodel",n_layers,residual_flag,k,j,error);
+                failed = 1;
+            }
+            if((error = check(m->lstms[j]->biases[k],g[j][2*n_gates+k],SIZE)) > TOLERANCE){
+                printf("%s, layers %d residual %d: the gradient of biases[%d] of the layer %d is wrong (%g)\n",workspace_flag ? "bp_rmodel_workspace" : "bp_rmodel",n_layers,residual_flag,k,j,error);
+                failed = 1;
+            }
+        }
+        if((error = check(hidden_states[j],g[j][3*n_gates],SIZE)) > TOLERANCE){
+            printf("%s, layers %d residual %d: the error of the hidden state of the layer %d is wrong (%g)\n",workspace_flag ? "bp_rmodel_workspace" : "bp_rmodel",n_layers,residual_flag,j,error);
+            failed = 1;
+        }
+        free_matrix(g[j],3*n_gates+1);
+    }
+    if((error = check(all_inputs,input_gradient,WINDOW*SIZE)) > TOLERANCE){
+        printf("%s, layers %d residual %d: the error of the inputs is wrong (%g)\n",workspace_flag ? "bp_rmodel_workspace" : "bp_rmodel",n_layers,residual_flag,error);
+        failed = 1;
+    }
+
+    free(g);
+    free(input_gradient);
+    free(all_inputs);
+    free(inputs);
+    free_matrix(errors,WINDOW);
+    free_matrix(hidden_states,layers);
+    free_matrix(cell_states,layers);
+    free_rmodel(m);
+    return failed;
+}
+
+/* 1 if the cells, the parameters and the outputs of the two rmodels are equal*/
+int equal_rmodels(rmodel* m1, rmodel* m2){
+    int i,j,k,t;
+    if(m1->layers != m2->layers || m1->n_lstm != m2->n_lstm || m1->window != m2->window || m1->hidden_state_mode != m2->hidden_state_mode)
+        return 0;
+    for(j = 0; j < m1->layers; j++){
+        lstm* l1 = m1->lstms[j];
+        lstm* l2 = m2->lstms[j];
+        if(l1->cell_type != l2->cell_type || l1->n_gates != l2->n_gates || l1->size != l2->size || l1->residual_flag != l2->residual_flag)
+            return 0;
+        for(k = 0; k < l1->n_gates; k++){
+            for(i = 0; i < l1->size*l1->size; i++){
+                if(l1->w[k][i] != l2->w[k][i] || l1->u[k][i] != l2->u[k][i])
+                    return 0;
+            }
+            for(i = 0; i < l1->size; i++){
+                if(l1->biases[k][i] != l2->biases[k][i])
+                    return 0;
+            }
+        }
+    }
+    reset_rmodel(m1);
+    reset_rmodel(m2);
+    ff_rmodel(hidden_states,cell_states,inputs,m1);
+    ff_rmodel(hidden_states,cell_states,inputs,m2);
+    for(t = 0; t < WINDOW; t++){
+        for(i = 0; i < SIZE; i++){
+            if(m1->lstms[m1->layers-1]->out_up[t][i] != m2->lstms[m2->layers-1]->out_up[t][i])
+                return 0;
+        }
+    }
+    return 1;
+}
+
+/* the layout of the rmodel files saved before the gru layers*/
+void write_pre_series_rmodel(rmodel* r, char* file){
+    int j,k;
+    FILE* fw = fopen(file,"w");
+    fwrite(&r->layers,sizeof(int),1,fw);
+    fwrite(&r->n_lstm,sizeof(int),1,fw);
+    fwrite(&r->window,sizeof(int),1,fw);
+    fwrite(&r->hidden_state_mode,sizeof(int),1,fw);
+    for(j = 0; j < r->n_lstm; j++){
+        lstm* l = r->lstms[j];
+        fwrite(&l->residual_flag,sizeof(int),1,fw);
+        fwrite(&l->norm_flag,sizeof(int),1,fw);
+        fwrite(&l->n_grouped_cell,sizeof(int),1,fw);
+        fwrite(&l->size,sizeof(int),1,fw);
+        fwrite(&l->layer,sizeof(int),1,fw);
+        fwrite(&l->dropout_flag_up,sizeof(int),1,fw);
+        fwrite(&l->dropout_flag_right,sizeof(int),1,fw);
+        fwrite(&l->window,sizeof(int),1,fw);
+        fwrite(&l->dropout_threshold_up,sizeof(float),1,fw);
+        fwrite(&l->dropout_threshold_right,sizeof(float),1,fw);
+        for(k = 0; k < LSTM_GATES; k++){
+            fwrite(l->w[k],sizeof(float)*l->size*l->size,1,fw);
+            fwrite(l->u[k],sizeof(float)*l->size*l->size,1,fw);
+            fwrite(l->biases[k],sizeof(float)*l->size,1,fw);
+        }
+    }
+    fclose(fw);
+}
+
+int test_save_load(){
+    int i,j,t,failed = 0;
+    int cell_types[] = {GRU_CELL,LSTM_CELL,GRU_CELL};
+    srand(SEED);
+    layers = MAX_LAYERS;
+    lstm** lstms = (lstm**)malloc(sizeof(lstm*)*layers);
+    lstm** lstms2 = (lstm**)malloc(sizeof(lstm*)*layers);
+    for(j = 0; j < layers; j++){
+        lstms[j] = recurrent_cell(cell_types[j],SIZE,NO_DROPOUT,0,NO_DROPOUT,0,j,WINDOW,j == 1 ? LSTM_RESIDUAL : LSTM_NO_RESIDUAL,NO_NORMALIZATION,0);
+        lstms2[j] = recurrent_lstm(SIZE,NO_DROPOUT,0,NO_DROPOUT,0,j,WINDOW,LSTM_NO_RESIDUAL,NO_NORMALIZATION,0);
+    }
+    rmodel* r = recurrent_network(layers,layers,lstms,WINDOW,STATELESS);
+    rmodel* old = recurrent_network(layers,layers,lstms2,WINDOW,STATEFUL);
+    hidden_states = (float**)malloc(sizeof(float*)*layers);
+    cell_states = (float**)malloc(sizeof(float*)*layers);
+    for(j = 0; j < layers; j++){
+        hidden_states[j] = (float*)malloc(sizeof(float)*SIZE);
+        cell_states[j] = (float*)malloc(sizeof(float)*SIZE);
+        for(i = 0; i < SIZE; i++){
+            hidden_states[j][i] = r2()-0.5;
+            cell_states[j][i] = r2()-0.5;
+        }
+    }
+    inputs = (float**)malloc(sizeof(float*)*WINDOW);
+    for(t = 0; t < WINDOW; t++){
+        inputs[t] = (float*)malloc(sizeof(float)*SIZE);
+        for(i = 0; i < SIZE; i++){
+            inputs[t][i] = r2()*2-1;
+        }
+    }
+
+    // the files are opened in append mode by the save functions
+    remove(FILE_STRING);
+    save_rmodel(r,FILE_NAME);
+    rmodel* loaded = load_rmodel(FILE_STRING);
+    if(!equal_rmodels(r,loaded)){
+        printf("the rmodel loaded by load_rmodel is different from the saved one\n");
+        failed = 1;
+    }
+    free_rmodel(loaded);
+    remove(FILE_STRING);
+    heavy_save_rmodel(r,FILE_NAME);
+    loaded = heavy_load_rmodel(FILE_STRING);
+    if(!equal_rmodels(r,loaded)){
+        printf("the rmodel loaded by heavy_load_rmodel is different from the saved one\n");
+        failed = 1;
+    }
+    free_rmodel(loaded);
+    write_pre_series_rmodel(old,FILE_STRING);
+    loaded = load_rmodel(FILE_STRING);
+    if(!equal_rmodels(old,loaded)){
+        printf("the lstm rmodel saved with the old layout is not loaded correctly\n");
+        failed = 1;
+    }
+    free_rmodel(loaded);
+    remove(FILE_STRING);
+
+    free_matrix(inputs,WINDOW);
+    free_matrix(hidden_states,layers);
+    free_matrix(cell_states,layers);
+    free_rmodel(r);
+    free_rmodel(old);
+    return failed;
+}
+
+int main(){
+    int workspace_flag,failed = 0;
+    int gru[] = {GRU_CELL,GRU_CELL,GRU_CELL};
+    int mixed1[] = {LSTM_CELL,GRU_CELL,LSTM_CELL};
+    int mixed2[] = {GRU_CELL,LSTM_CELL,GRU_CELL};
+    for(workspace_flag = 0; workspace_flag < 2; workspace_flag++){
+        failed |= test_model(gru,1,0,workspace_flag);
+        failed |= test_model(gru,MAX_LAYERS,0,workspace_flag);
+        failed |= test_model(gru,MAX_LAYERS,1,workspace_flag);
+        failed |= test_model(mixed1,MAX_LAYERS,0,workspace_flag);
+        failed |= test_model(mixed2,MAX_LAYERS,1,workspace_flag);
+    }
+    failed |= test_save_load();
+    if(failed){
+        printf("gru test failed\n");
+        return 1;
+    }
+    printf("gru test passed\n");
+    return 0;
+}
@@ -0,0 +1,180 @@
+#include <llab.h>
+#include <math.h>
+
+/* Test of the int8 quantized models:
+ * the scalar, avx2 and vnni kernels of qgemm_nt and qgemm_packed must give exactly the results of qgemm_nt_scalar,
+ * for sizes that are not multiples of the widths of the kernels and with leading dimensions larger than the rows.
+ * The outputs of the quantized copies of a convolutional model and of a fully connected model must be close to the
+ * float outputs on inputs that were not used for the calibration, and a quantized model saved with save_qmodel
+ * and loaded with load_qmodel must give exactly the same outputs
+ * */
+
+#define SAMPLES 16// calibration inputs, then the same number of test inputs
+#define TOLERANCE 0.05// max difference between the quantized and the float outputs, relative to the max float output
+#define FILE_NAME 24
+#define FILE_STRING "24.qbin"
+#define SEED 13
+
+/* the int32 results of each kernel and of each instruction set are compared with the scalar qgemm_nt*/
+int test_kernels(){
+    int i,j,x,y,z,set,failed = 0;
+    int ms[] = {1,5,17};
+    int ns[] = {1,7,16,33};
+    int ks[] = {1,3,4,13,64,67};
+    int sets[] = {SGEMM_SCALAR,SGEMM_AVX2,SGEMM_AVX512};
+    char* names[] = {"scalar","avx2","vnni"};
+
+    if(!__builtin_cpu_supports("avx512bw") || !__builtin_cpu_supports("avx512vnni"))
+        printf("the cpu has no vnni instructions, the vnni case runs the avx2 kernels\n");
+
+    for(x = 0; x < 3; x++){
+        for(y = 0; y < 4; y++){
+            for(z = 0; z < 6; z++){
+                int m = ms[x], n = ns[y], k = ks[z], lda = k+3, ldb = k+1, ldc = n+2;
+                signed char* a = (signed char*)malloc(m*lda);
+                signed char* b = (signed char*)malloc(n*ldb);
+                signed char* packed = (signed char*)malloc(qgemm_packed_size(n,k));
+                int* a_sums = (int*)calloc(m,sizeof(int));
+                int* reference = (int*)malloc(sizeof(int)*m*ldc);
+                int* c = (int*)malloc(sizeof(int)*m*ldc);
+                for(i = 0; i < m*lda; i++){
+                    a[i] = (signed char)(rand()%256-128);
+                }
+                for(i = 0; i < n*ldb; i++){
+                    b[i] = (signed char)(rand()%(2*QUANTIZED_MAX+1)-QUANTIZED_MAX);
+                }
+                for(i = 0; i < m; i++){
+                    for(j = 0; j < k; j++){
+                        a_sums[i] += a[i*lda+j];
+                    }
+                }
+                qgemm_pack_b(n,k,b,ldb,packed);
+                for(i = 0; i < m*ldc; i++){
+                    reference[i] = -1;
+                }
+                qgemm_nt_scalar(m,n,k,a,lda,b,ldb,reference,ldc);
+
+                for(set = 0; set < 3; set++){
+                    set_sgemm_instruction_set(sets[set]);
+                    for(i = 0; i < m*ldc; i++){
+                        c[i] = -1;
+                    }
+                    qgemm_nt(m,n,k,a,lda,a_sums,b,ldb,c,ldc);
+                    for(i = 0; i < m*ldc; i++){
+                        if(c[i] != reference[i]){
+                            printf("qgemm_nt %s, m %d n %d k %d: %d instead of %d at %d\n",names[set],m,n,k,c[i],reference[i],i);
+                            failed = 1;
+                            break;
+                        }
+                    }
+                    for(i = 0; i < m*ldc; i++){
+                        c[i] = -1;
+                    }
+                    qgemm_packed(m,n,k,a,lda,a_sums,packed,c,ldc);
+                    for(i = 0; i < m*ldc; i++){
+                        if(c[i] != reference[i]){
+                            printf("qgemm_packed %s, m %d n %d k %d: %d instead of %d at %d\n",names[set],m,n,k,c[i],reference[i],i);
+                            failed = 1;
+                            break;
+                        }
+                    }
+                }
+                set_sgemm_instruction_set(SGEMM_AUTO);
+
+                free(a);
+                free(b);
+                free(packed);
+                free(a_sums);
+                free(reference);
+                free(c);
+            }
+        }
+    }
+    return failed;
+}
+
+/* the quantized model is calibrated on the first SAMPLES inputs and compared with the float model on the other ones,
+ * then it is saved, loaded and compared with itself*/
+int test_model(model* m, int depth, int rows, int cols, char* name){
+    int i,j,failed = 0,input_size = depth*rows*cols;
+    float max_difference = 0,max_output = 0;
+    float** inputs = (float**)malloc(sizeof(float*)*2*SAMPLES);
+    for(i = 0; i < 2*SAMPLES; i++){
+        inputs[i] = (float*)malloc(sizeof(float)*input_size);
+        for(j = 0; j < input_size; j++){
+            inputs[i][j] = r2();
+        }
+    }
+    qmodel* q = quantize_model(m,inputs,SAMPLES,depth,rows,cols);
+    float* outputs = (float*)malloc(sizeof(float)*SAMPLES*q->output);
+
+    for(i = 0; i < SAMPLES; i++){
+        reset_model_except_partial_derivatives(m);
+        model_tensor_input_ff(m,depth,rows,cols,inputs[SAMPLES+i]);
+        qmodel_tensor_input_ff(q,inputs[SAMPLES+i]);
+        copy_array(q->output_layer,&outputs[i*q->output],q->output);
+        for(j = 0; j < q->output; j++){
+            if(fabs(q->output_layer[j]-m->output_layer[j]) > max_difference)
+                max_difference = fabs(q->output_layer[j]-m->output_layer[j]);
+            if(fabs(m->output_layer[j]) > max_output)
+                max_output = fabs(m->output_layer[j]);
+        }
+    }
+    if(max_difference > TOLERANCE*max_output){
+        printf("%s: the quantized outputs are too far from the float outputs (%g, max output %g)\n",name,max_difference,max_output);
+        failed = 1;
+    }
+
+    save_qmodel(q,FILE_NAME);
+    qmodel* loaded = load_qmodel(FILE_STRING);
+    remove(FILE_STRING);
+    if(size_of_qmodel(loaded) != size_of_qmodel(q)){
+        printf("%s: the loaded quantized model has a different size\n",name);
+        failed = 1;
+    }
+    for(i = 0; i < SAMPLES; i++){
+        qmodel_tensor_input_ff(loaded,inputs[SAMPLES+i]);
+        for(j = 0; j < q->output; j++){
+            if(loaded->output_layer[j] != outputs[i*q->output+j]){
+                printf("%s: the loaded quantized model gives different outputs\n",name);
+                failed = 1;
+                i = SAMPLES;
+                break;
+            }
+        }
+    }
+
+    free(outputs);
+    free_qmodel(loaded);
+    free_qmodel(q);
+    free_matrix(inputs,2*SAMPLES);
+    free_model(m);
+    return failed;
+}
+
+int main(){
+    int failed = 0;
+    srand(SEED);
+    failed |= test_kernels();
+
+    cl** cls = (cl**)malloc(sizeof(cl*)*2);
+    fcl** fcls = (fcl**)malloc(sizeof(fcl*)*2);
+    cls[0] = convolutional(1,12,12,3,3,8,1,1,1,1,2,2,0,0,2,2,NO_NORMALIZATION,RELU,MAX_POOLING,0,CONVOLUTION,0);
+    cls[1] = convolutional(8,6,6,3,3,12,1,1,1,1,2,2,0,0,2,2,NO_NORMALIZATION,RELU,MAX_POOLING,0,CONVOLUTION,1);
+    fcls[0] = fully_connected(cls[1]->n_kernels*cls[1]->rows2*cls[1]->cols2,40,2,DROPOUT_TEST,RELU,0.5,0,NO_NORMALIZATION);
+    fcls[1] = fully_connected(40,10,3,NO_DROPOUT,SOFTMAX,0,0,NO_NORMALIZATION);
+    failed |= test_model(network(4,0,2,2,NULL,cls,fcls),1,12,12,"convolutional model");
+
+    fcls = (fcl**)malloc(sizeof(fcl*)*3);
+    fcls[0] = fully_connected(50,64,0,NO_DROPOUT,RELU,0,0,NO_NORMALIZATION);
+    fcls[1] = fully_connected(64,33,1,NO_DROPOUT,RELU,0,0,NO_NORMALIZATION);
+    fcls[2] = fully_connected(33,7,2,NO_DROPOUT,SIGMOID,0,0,NO_NORMALIZATION);
+    failed |= test_model(network(3,0,0,3,NULL,NULL,fcls),1,1,50,"fully connected model");
+
+    if(failed){
+        printf("quantized model test failed\n");
+        return 1;
+    }
+    printf("quantized model test passed\n");
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include <llab.h>
+#include <math.h>
+
+/* Test of the compiled inference plans:
+ * the outputs of plan_tensor_input_ff must be equal bit for bit to the outputs of model_tensor_input_ff
+ * for a conv/pool/fc model, a model with residual layers and a model with local response, group and layer normalizations,
+ * with the convolutions computed by AUTO_CONVOLUTION, IM2COL_CONVOLUTION and DIRECT_CONVOLUTION.
+ * The plan is run on several inputs without resets, so no state must leak between two feed forwards
+ * */
+
+#define SAMPLES 4
+#define SEED 17
+
+int test_plan(model* m, int depth, int rows, int cols, char* name){
+    int i,j,a,failed = 0,input_size = depth*rows*cols;
+    int algorithms[] = {AUTO_CONVOLUTION,IM2COL_CONVOLUTION,DIRECT_CONVOLUTION};
+    char* names[] = {"AUTO_CONVOLUTION","IM2COL_CONVOLUTION","DIRECT_CONVOLUTION"};
+    float** inputs = (float**)malloc(sizeof(float*)*SAMPLES);
+    for(i = 0; i < SAMPLES; i++){
+        inputs[i] = (float*)malloc(sizeof(float)*input_size);
+        for(j = 0; j < input_size; j++){
+            inputs[i][j] = r2()*2-1;
+        }
+    }
+    for(a = 0; a < 3; a++){
+        set_model_convolution_algorithm(m,algorithms[a]);
+        inference_plan* p = compile_model(m,depth,rows,cols);
+        for(i = 0; i < SAMPLES; i++){
+            reset_model_except_partial_derivatives(m);
+            model_tensor_input_ff(m,depth,rows,cols,inputs[i]);
+            plan_tensor_input_ff(p,inputs[i]);
+            for(j = 0; j < p->output; j++){
+                if(p->output_layer[j] != m->output_layer[j]){
+                    printf("%s, %s, input %d: the output %d of the plan is %.9g instead of %.9g\n",name,names[a],i,j,p->output_layer[j],m->output_layer[j]);
+                    failed = 1;
+                    break;
+                }
+            }
+        }
+        free_inference_plan(p);
+    }
+    free_matrix(inputs,SAMPLES);
+    free_model(m);
+    return failed;
+}
+
+int main(){
+    int failed = 0;
+    srand(SEED);
+
+    // conv/pool/fc: a 3*3 convolution (winograd with AUTO_CONVOLUTION), a 5*5 convolution with stride 2 and average pooling
+    cl** cls = (cl**)malloc(sizeof(cl*)*3);
+    fcl** fcls = (fcl**)malloc(sizeof(fcl*)*2);
+    cls[0] = convolutional(2,16,16,3,3,6,1,1,1,1,2,2,0,0,2,2,NO_NORMALIZATION,RELU,MAX_POOLING,0,CONVOLUTION,0);
+    cls[1] = convolutional(6,8,8,5,5,8,2,2,2,2,1,1,0,0,2,2,NO_NORMALIZATION,LEAKY_RELU,AVARAGE_POOLING,0,CONVOLUTION,1);
+    cls[2] = convolutional(8,cls[1]->rows2,cls[1]->cols2,3,3,10,1,1,1,1,1,1,0,0,1,1,NO_NORMALIZATION,TANH,NO_POOLING,0,CONVOLUTION,2);
+    fcls[0] = fully_connected(cls[2]->n_kernels*cls[2]->rows2*cls[2]->cols2,30,3,DROPOUT_TEST,RELU,0.5,0,NO_NORMALIZATION);
+    fcls[1] = fully_connected(30,10,4,NO_DROPOUT,SOFTMAX,0,0,NO_NORMALIZATION);
+    failed |= test_plan(network(5,0,3,2,NULL,cls,fcls),2,16,16,"conv/pool/fc model");
+
+    // residual layers: 2 residual layers of 2 convolutions each after a convolution with max pooling
+    cls = (cl**)malloc(sizeof(cl*));
+    cl** cls2 = (cl**)malloc(sizeof(cl*)*2);
+    cl** cls3 = (cl**)malloc(sizeof(cl*)*2);
+    rl** rls = (rl**)malloc(sizeof(rl*)*2);
+    fcls = (fcl**)malloc(sizeof(fcl*));
+    cls[0] = convolutional(1,12,12,3,3,4,1,1,1,1,2,2,0,0,2,2,NO_NORMALIZATION,RELU,MAX_POOLING,0,CONVOLUTION,0);
+    cls2[0] = convolutional(4,6,6,3,3,8,1,1,1,1,1,1,0,0,1,1,NO_NORMALIZATION,RELU,NO_POOLING,0,CONVOLUTION,1);
+    cls2[1] = convolutional(8,6,6,3,3,4,1,1,1,1,1,1,0,0,1,1,NO_NORMALIZATION,NO_ACTIVATION,NO_POOLING,0,CONVOLUTION,2);
+    cls3[0] = convolutional(4,6,6,1,1,6,1,1,0,0,1,1,0,0,1,1,NO_NORMALIZATION,SIGMOID,NO_POOLING,0,CONVOLUTION,3);
+    cls3[1] = convolutional(6,6,6,3,3,4,1,1,1,1,1,1,0,0,1,1,NO_NORMALIZATION,RELU,NO_POOLING,0,CONVOLUTION,4);
+    rls[0] = residual(4,6,6,2,cls2);
+    rls[1] = residual(4,6,6,2,cls3);
+    fcls[0] = fully_connected(4*6*6,10,5,NO_DROPOUT,SIGMOID,0,0,NO_NORMALIZATION);
+    failed |= test_plan(network(6,2,1,1,rls,cls,fcls),1,12,12,"residual model");
+
+    // normalizations: local response normalization with pooling, group normalization without and with pooling, layer normalization
+    cls = (cl**)malloc(sizeof(cl*)*3);
+    fcls = (fcl**)malloc(sizeof(fcl*)*2);
+    cls[0] = convolutional(3,12,12,3,3,8,1,1,1,1,2,2,0,0,2,2,LOCAL_RESPONSE_NORMALIZATION,RELU,MAX_POOLING,0,CONVOLUTION,0);
+    cls[1] = convolutional(8,6,6,3,3,8,1,1,1,1,1,1,0,0,1,1,GROUP_NORMALIZATION,RELU,NO_POOLING,2,CONVOLUTION,1);
+    cls[2] = convolutional(8,6,6,3,3,12,1,1,1,1,2,2,0,0,2,2,GROUP_NORMALIZATION,LEAKY_RELU,MAX_POOLING,4,CONVOLUTION,2);
+    fcls[0] = fully_connected(12*3*3,24,3,NO_DROPOUT,RELU,0,4,LAYER_NORMALIZATION);
+    fcls[1] = fully_connected(24,5,4,NO_DROPOUT,NO_ACTIVATION,0,0,NO_NORMALIZATION);
+    failed |= test_plan(network(5,0,3,2,NULL,cls,fcls),3,12,12,"normalization model");
+
+    if(failed){
+        printf("inference plan test failed\n");
+        return 1;
+    }
+    printf("inference plan test passed\n");
+    return 0;
+}
@@ -0,0 +1,181 @@
+#include <llab.h>
+#include <math.h>
+
+/* Round trip test of compress_vector and decompress_add for every compression:
+ * the decompressed vector plus the residual left in the compressor must give back the vector plus the previous residual
+ * (exactly for COMPRESSION_NONE and COMPRESSION_TOPK), decompress_add must add exactly what decompress_add_scalar adds
+ * and the compressed sizes must be the ones of compressed_size.
+ * COMPRESSION_FP16 gets values beyond the half precision range that must be clamped, with the overflow kept in the residual,
+ * COMPRESSION_1BIT must send + or - the largest magnitude of each block, COMPRESSION_TOPK gets vectors with many values
+ * of equal magnitude, small and large enough to sample the threshold, and must send exactly k values, never a smaller
+ * magnitude than one left behind, and the ties in order of index
+ * */
+
+#define SIZE 1003// not a multiple of COMPRESSION_BLOCK nor of 8
+#define LARGE_SIZE (5*COMPRESSION_SAMPLE+77)// large enough for the sampled threshold of COMPRESSION_TOPK
+#define ROUNDS 3// vectors compressed by each compressor, the residual is carried
+#define RATIO 0.1
+#define TOLERANCE 1e-6// relative to the magnitude of the value
+#define SEED 23
+
+/* a vector of random values in [-1,1), with ties of the largest magnitude and (for COMPRESSION_FP16) values beyond the half precision range*/
+void fill(float* vector, int size, int type, int ties){
+    int i;
+    for(i = 0; i < size; i++){
+        vector[i] = r2()*2-1;
+        if(ties && i%3 == 0)
+            vector[i] = i%2 ? 1 : -1;
+        if(type == COMPRESSION_FP16 && i%50 == 7)
+            vector[i] = i%100 == 7 ? 1e6 : -70000;
+    }
+}
+
+int test_compression(int type, int size, int ties, char* name){
+    int i,j,r,k,sent,failed = 0,n_blocks = (size+COMPRESSION_BLOCK-1)/COMPRESSION_BLOCK;
+    long long int bytes;
+    float max,threshold;
+    compressor* c = create_compressor(type,size,RATIO);
+    void* buffer = malloc(compressed_size(type,size,RATIO));
+    float* vector = (float*)malloc(sizeof(float)*size);
+    float* expected = (float*)malloc(sizeof(float)*size);
+    float* output = (float*)malloc(sizeof(float)*size);
+    float* scalar_output = (float*)malloc(sizeof(float)*size);
+    char* taken = (char*)malloc(size);
+    // COMPRESSION_NONE loses nothing and has no residual
+    float* residual = type == COMPRESSION_NONE ? (float*)calloc(size,sizeof(float)) : c->residual;
+
+    for(r = 0; r < ROUNDS && !failed; r++){
+        fill(vector,size,type,ties);
+        // what the compressor has to send: the vector plus the residual of the previous vector
+        for(i = 0; i < size; i++){
+            expected[i] = vector[i]+residual[i];
+        }
+        bytes = compress_vector(c,vector,buffer);
+        if(bytes != compressed_size(type,size,RATIO)){
+            printf("%s, vector %d: %lld bytes instead of %lld\n",name,r,bytes,compressed_size(type,size,RATIO));
+            failed = 1;
+        }
+        for(i = 0; i < size; i++){
+            output[i] = scalar_output[i] = (float)i;
+        }
+        decompress_add(type,buffer,bytes,output,size);
+        decompress_add_scalar(type,buffer,scalar_output,size);
+        for(i = 0; i < size; i++){
+            if(output[i] != scalar_output[i]){
+                printf("%s, vector %d: decompress_add adds %.9g instead of %.9g at %d\n",name,r,output[i]-i,scalar_output[i]-i,i);
+                failed = 1;
+                break;
+            }
+        }
+        for(i = 0; i < size; i++){
+            output[i] = 0;
+        }
+        decompress_add(type,buffer,bytes,output,size);
+
+        if(type != COMPRESSION_1BIT){
+            for(i = 0; i < size; i++){
+                if(!isfinite(output[i]) || !isfinite(residual[i])){
+                    printf("%s, vector %d: the value %d is not finite (%g, residual %g)\n",name,r,i,output[i],residual[i]);
+                    failed = 1;
+                    break;
+                }
+                if(type == COMPRESSION_NONE || type == COMPRESSION_TOPK ? output[i]+residual[i] != expected[i] : fabs(output[i]+residual[i]-expected[i]) > TOLERANCE*(fabs(expected[i])+1)){
+                    printf("%s, vector %d: the value %d plus the residual is %.9g instead of %.9g\n",name,r,i,output[i]+residual[i],expected[i]);
+                    failed = 1;
+                    break;
+                }
+                if(type == COMPRESSION_FP16 && fabs(output[i]) > COMPRESSION_FP16_MAX){
+                    printf("%s, vector %d: the value %d is %g, out of the half precision range\n",name,r,i,output[i]);
+                    failed = 1;
+                    break;
+                }
+            }
+        }
+
+        else{
+            for(j = 0; j < n_blocks; j++){
+                for(i = j*COMPRESSION_BLOCK, max = 0; i < size && i < (j+1)*COMPRESSION_BLOCK; i++){
+                    if(fabs(expected[i]) > max)
+                        max = fabs(expected[i]);
+                }
+                for(i = j*COMPRESSION_BLOCK; i < size && i < (j+1)*COMPRESSION_BLOCK; i++){
+                    // the values with the largest magnitude can be rounded only to themselves
+                    if((output[i] != max && output[i] != -max) || (expected[i] == max && output[i] != max) || (expected[i] == -max && output[i] != -max) || residual[i] != 0){
+                        printf("%s, vector %d: the value %d is %g, the largest magnitude of its block is %g\n",name,r,i,output[i],max);
+                        failed = 1;
+                        break;
+                    }
+                }
+            }
+        }
+
+        if(type == COMPRESSION_TOPK){
+            k = topk_count(size,RATIO);
+            unsigned int* indices = (unsigned int*)((int*)buffer+1);
+            if(*(int*)buffer != k){
+                printf("%s, vector %d: %d values sent instead of %d\n",name,r,*(int*)buffer,k);
+                failed = 1;
+            }
+            for(i = 1; i < k; i++){
+                if(indices[i] <= indices[i-1]){
+                    printf("%s, vector %d: the indices are not in ascending order\n",name,r);
+                    failed = 1;
+                    break;
+                }
+            }
+            memset(taken,0,size);
+            for(i = 0; i < k; i++){
+                taken[indices[i]] = 1;
+            }
+            // the smallest magnitude sent must be at least the largest one left, a tie left must come after every tie sent
+            for(i = 0, threshold = INFINITY; i < size; i++){
+                if(taken[i] && fabs(expected[i]) < threshold)
+                    threshold = fabs(expected[i]);
+            }
+            for(i = 0, sent = 1; i < size; i++){
+                if(!taken[i] && fabs(expected[i]) > threshold){
+                    printf("%s, vector %d: the value %d (%g) is left while %g is sent\n",name,r,i,expected[i],threshold);
+                    failed = 1;
+                    break;
+                }
+                if(fabs(expected[i]) == threshold){
+                    if(taken[i] && !sent){
+                        printf("%s, vector %d: the tie %d is sent after a tie left\n",name,r,i);
+                        failed = 1;
+                        break;
+                    }
+                    sent = taken[i];
+                }
+            }
+        }
+    }
+
+    free(taken);
+    if(type == COMPRESSION_NONE)
+        free(residual);
+    free(scalar_output);
+    free(output);
+    free(expected);
+    free(vector);
+    free(buffer);
+    free_compressor(c);
+    return failed;
+}
+
+int main(){
+    int failed = 0;
+    srand(SEED);
+    failed |= test_compression(COMPRESSION_NONE,SIZE,0,"COMPRESSION_NONE");
+    failed |= test_compression(COMPRESSION_FP16,SIZE,0,"COMPRESSION_FP16");
+    failed |= test_compression(COMPRESSION_INT8,SIZE,0,"COMPRESSION_INT8");
+    failed |= test_compression(COMPRESSION_1BIT,SIZE,0,"COMPRESSION_1BIT");
+    failed |= test_compression(COMPRESSION_TOPK,SIZE,0,"COMPRESSION_TOPK");
+    failed |= test_compression(COMPRESSION_TOPK,SIZE,1,"COMPRESSION_TOPK with ties");
+    failed |= test_compression(COMPRESSION_TOPK,LARGE_SIZE,1,"COMPRESSION_TOPK sampled with ties");
+    if(failed){
+        printf("compression test failed\n");
+        return 1;
+    }
+    printf("compression test passed\n");
+    return 0;
+}
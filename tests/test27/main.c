@@ -0,0 +1,79 @@
+#include <llab.h>
+#include <math.h>
+
+/* Stress test of the shared thread pools:
+ * several threads submit tasks to the same pool returned by get_shared_thread_pool and wait on it at the same time,
+ * when thread_pool_wait returns every task submitted by the calling thread must be done.
+ * The callers ask for pools of 2 different numbers of threads, so 2 shared pools are used concurrently
+ * */
+
+#define CALLERS 6
+#define ROUNDS 20000
+#define TASKS 7// tasks submitted by a caller in each round
+#define THREADS 4
+#define SPIN 200// iterations of the busy loop of a task
+
+typedef struct task_args{
+    volatile float value;
+    int done;
+} task_args;
+
+typedef struct caller_args{
+    int index;
+    int failed;
+} caller_args;
+
+void* task(void* _args){
+    task_args* args = (task_args*)_args;
+    int i;
+    for(i = 0; i < SPIN; i++){
+        args->value = args->value*0.5+1;
+    }
+    __atomic_store_n(&args->done,1,__ATOMIC_SEQ_CST);
+    return NULL;
+}
+
+void* caller(void* _args){
+    caller_args* args = (caller_args*)_args;
+    task_args tasks[TASKS];
+    int i,r;
+    for(r = 0; r < ROUNDS && !args->failed; r++){
+        thread_pool* pool = get_shared_thread_pool(args->index%2 ? THREADS : THREADS-1);
+        for(i = 0; i < TASKS; i++){
+            tasks[i].value = 0;
+            tasks[i].done = 0;
+            thread_pool_submit(pool,task,&tasks[i]);
+        }
+        thread_pool_wait(pool);
+        for(i = 0; i < TASKS; i++){
+            if(!__atomic_load_n(&tasks[i].done,__ATOMIC_SEQ_CST)){
+                printf("caller %d, round %d: thread_pool_wait returned before the task %d was done\n",args->index,r,i);
+                args->failed = 1;
+                break;
+            }
+        }
+    }
+    return NULL;
+}
+
+int main(){
+    int i,failed = 0;
+    pthread_t threads[CALLERS];
+    caller_args args[CALLERS];
+    for(i = 0; i < CALLERS; i++){
+        args[i].index = i;
+        args[i].failed = 0;
+        pthread_create(&threads[i],NULL,caller,&args[i]);
+    }
+    for(i = 0; i < CALLERS; i++){
+        pthread_join(threads[i],NULL);
+        failed |= args[i].failed;
+    }
+    free_shared_thread_pool();
+    if(failed){
+        printf("thread pool test failed\n");
+        return 1;
+    }
+    printf("thread pool test passed\n");
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include <llab.h>
+#include <math.h>
+
+/* Accuracy test of the im2col convolution:
+ * the feed forward, the error of the input, the errors of the kernels and the errors of the biases computed with
+ * IM2COL_CONVOLUTION are compared with the ones of DIRECT_CONVOLUTION. The layers have strides > 1 that do and don't
+ * divide the input, padding (of the output, the constructor wants the same padding for rows and cols, so the padding
+ * is made asymmetric with respect to the kernel by the non square kernels), non square inputs and 1*1, 1*5, 5*3, 3*3
+ * and 7*7 kernels. The outputs and the errors are filled before the computation, both algorithms must sum to them.
+ * Then a model with a strided and padded im2col layer is trained for some steps against the same model with the direct convolution
+ * */
+
+#define TOLERANCE 0.0001
+#define SEED 29
+
+float max_relative_error(float* a, float* b, int size){
+    int i;
+    float max = 0, norm = 0;
+    for(i = 0; i < size; i++){
+        if(fabs(b[i]) > norm)
+            norm = fabs(b[i]);
+    }
+    if(norm < 1)
+        norm = 1;
+    for(i = 0; i < size; i++){
+        if(fabs(a[i]-b[i])/norm > max)
+            max = fabs(a[i]-b[i])/norm;
+    }
+    return max;
+}
+
+float test_layer(int channels, int rows, int cols, int kernel_rows, int kernel_cols, int n_kernels, int stride, int padding){
+    int i,j,size;
+    float max = 0, e;
+    cl* c1 = convolutional(channels,rows,cols,kernel_rows,kernel_cols,n_kernels,stride,stride,padding,padding,1,1,0,0,1,1,NO_NORMALIZATION,NO_ACTIVATION,NO_POOLING,0,CONVOLUTION,0);
+    cl* c2 = copy_cl(c1);
+    float* input = (float*)malloc(sizeof(float)*channels*rows*cols);
+    for(i = 0; i < channels*rows*cols; i++){
+        input[i] = r2()-0.5;
+        c1->error2[i] = r2()-0.5;
+        c2->error2[i] = c1->error2[i];
+    }
+    for(i = 0; i < n_kernels; i++){
+        c1->biases[i] = r2()-0.5;
+        c2->biases[i] = c1->biases[i];
+        c1->d_biases[i] = r2()-0.5;
+        c2->d_biases[i] = c1->d_biases[i];
+        for(j = 0; j < channels*kernel_rows*kernel_cols; j++){
+            c1->d_kernels[i][j] = r2()-0.5;
+            c2->d_kernels[i][j] = c1->d_kernels[i][j];
+        }
+    }
+    size = n_kernels*c1->rows1*c1->cols1;
+    for(i = 0; i < size; i++){
+        c1->pre_activation[i] = r2()-0.5;
+        c2->pre_activation[i] = c1->pre_activation[i];
+    }
+    set_convolution_algorithm(c1,DIRECT_CONVOLUTION);
+    set_convolution_algorithm(c2,IM2COL_CONVOLUTION);
+    convolutional_layer_feed_forward(c1,input);
+    convolutional_layer_feed_forward(c2,input);
+    e = max_relative_error(c2->pre_activation,c1->pre_activation,size);
+    if(e > max)
+        max = e;
+    for(i = 0; i < size; i++){
+        c1->temp[i] = r2()-0.5;
+        c2->temp[i] = c1->temp[i];
+    }
+    convolutional_layer_back_prop(c1,input);
+    convolutional_layer_back_prop(c2,input);
+    e = max_relative_error(c2->error2,c1->error2,channels*rows*cols);
+    if(e > max)
+        max = e;
+    e = max_relative_error(c2->d_biases,c1->d_biases,n_kernels);
+    if(e > max)
+        max = e;
+    for(j = 0; j < n_kernels; j++){
+        e = max_relative_error(c2->d_kernels[j],c1->d_kernels[j],channels*kernel_rows*kernel_cols);
+        if(e > max)
+            max = e;
+    }
+    printf("channels: %d, input: %d*%d, kernel: %d*%d, kernels: %d, stride: %d, padding: %d, max relative error: %f\n",channels,rows,cols,kernel_rows,kernel_cols,n_kernels,stride,padding,max);
+    free(input);
+    free_convolutional(c1);
+    free_convolutional(c2);
+    return max;
+}
+
+int main(){
+    srand(SEED);
+    int i,step,failed = 0;
+    float max;
+
+    // single layers
+    if(test_layer(1,5,5,1,1,1,1,0) > TOLERANCE) failed = 1;
+    if(test_layer(3,7,6,3,3,4,2,1) > TOLERANCE) failed = 1;
+    if(test_layer(2,9,14,1,5,3,1,2) > TOLERANCE) failed = 1;
+    if(test_layer(4,13,10,5,3,5,2,1) > TOLERANCE) failed = 1;
+    if(test_layer(5,16,11,5,3,6,3,0) > TOLERANCE) failed = 1;
+    if(test_layer(8,17,23,7,7,9,2,3) > TOLERANCE) failed = 1;
+    if(test_layer(16,32,20,3,3,16,1,1) > TOLERANCE) failed = 1;
+
+    // a model with the im2col convolution against the same model with the direct convolution
+    cl** cls = (cl**)malloc(sizeof(cl*)*2);
+    fcl** fcls = (fcl**)malloc(sizeof(fcl*));
+    cls[0] = convolutional(2,15,12,5,3,4,2,2,1,1,1,1,0,0,1,1,NO_NORMALIZATION,RELU,NO_POOLING,0,CONVOLUTION,0);
+    cls[1] = convolutional(4,cls[0]->rows1,cls[0]->cols1,3,1,6,1,1,0,0,2,2,0,0,2,2,NO_NORMALIZATION,RELU,MAX_POOLING,0,CONVOLUTION,1);
+    fcls[0] = fully_connected(6*cls[1]->rows2*cls[1]->cols2,10,2,NO_DROPOUT,SOFTMAX,0,0,NO_NORMALIZATION);
+    model* m = network(3,0,2,1,NULL,cls,fcls);
+    set_model_convolution_algorithm(m,IM2COL_CONVOLUTION);
+    model* direct = copy_model(m);
+    set_model_convolution_algorithm(direct,DIRECT_CONVOLUTION);
+    float* input = (float*)malloc(sizeof(float)*2*15*12);
+    float* error = (float*)malloc(sizeof(float)*10);
+    float b1 = BETA1_ADAM, b2 = BETA2_ADAM;
+    unsigned long long int t = 1;
+    for(i = 0; i < 2*15*12; i++){
+        input[i] = r2();
+    }
+    for(step = 0; step < 5; step++){
+        model_tensor_input_ff(m,2,15,12,input);
+        model_tensor_input_ff(direct,2,15,12,input);
+        max = max_relative_error(m->fcls[0]->post_activation,direct->fcls[0]->post_activation,10);
+        for(i = 0; i < 10; i++){
+            error[i] = m->fcls[0]->post_activation[i] - (i == 3);
+        }
+        model_tensor_input_bp(m,2,15,12,input,error,10);
+        model_tensor_input_bp(direct,2,15,12,input,error,10);
+        for(i = 0; i < 4; i++){
+            float e = max_relative_error(m->cls[0]->d_kernels[i],direct->cls[0]->d_kernels[i],2*5*3);
+            if(e > max)
+                max = e;
+        }
+        printf("step: %d, max relative error of the model: %f\n",step,max);
+        if(max > TOLERANCE)
+            failed = 1;
+        update_model(m,0.01,0.9,1,ADAM,&b1,&b2,NO_REGULARIZATION,0,0,&t);
+        reset_model(m);
+        paste_model(m,direct);
+        reset_model(direct);
+    }
+    free(input);
+    free(error);
+    free_model(m);
+    free_model(direct);
+
+    if(failed){
+        printf("im2col test failed\n");
+        return 1;
+    }
+    printf("im2col test passed\n");
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include <llab.h>
+#include <math.h>
+
+/* Test of the fused optimizer step:
+ * a model with its params in an arena (make_model_contiguous) is updated by update_model_multicore with a single sweep
+ * (update_params_arena_multicore and the span kernels of gd.c), a copy without arena is updated layer by layer by update_model.
+ * After some steps of NESTEROV, ADAM, RADAM, ADAMOD and DIFF_GRAD, with and without L2_REGULARIZATION, the params of the
+ * 2 models must be the same. The model has fully connected, convolutional and residual layers and more params than
+ * OPTIMIZER_CHUNK, it is updated with 1 and 4 threads. The same model with a group normalization and a layer normalization
+ * can't be updated with a single sweep (their params are excluded by model_state_lives_in_arena), it must fall back
+ * to the layer by layer update with the same params, the normalization params included
+ * */
+
+#define STEPS 4
+#define TOLERANCE 0.00001// relative to the max magnitude of the params
+#define SEED 31
+
+float max_difference(float* a, float* b, int size, float* max){
+    int i;
+    float difference = 0;
+    for(i = 0; i < size; i++){
+        if(fabs(a[i]-b[i]) > difference)
+            difference = fabs(a[i]-b[i]);
+        if(fabs(b[i]) > *max)
+            *max = fabs(b[i]);
+    }
+    return difference;
+}
+
+model* create_model(int normalization_flag){
+    cl** cls = (cl**)malloc(sizeof(cl*)*2);
+    cl** cls2 = (cl**)malloc(sizeof(cl*));
+    rl** rls = (rl**)malloc(sizeof(rl*));
+    fcl** fcls = (fcl**)malloc(sizeof(fcl*)*2);
+    cls[0] = convolutional(2,10,10,3,3,4,1,1,1,1,1,1,0,0,1,1,normalization_flag ? GROUP_NORMALIZATION : NO_NORMALIZATION,RELU,NO_POOLING,2,CONVOLUTION,0);
+    cls2[0] = convolutional(4,10,10,3,3,4,1,1,1,1,1,1,0,0,1,1,NO_NORMALIZATION,RELU,NO_POOLING,0,CONVOLUTION,1);
+    rls[0] = residual(4,10,10,1,cls2);
+    cls[1] = convolutional(4,10,10,5,5,6,1,1,0,0,2,2,0,0,2,2,NO_NORMALIZATION,LEAKY_RELU,MAX_POOLING,0,CONVOLUTION,2);
+    fcls[0] = fully_connected(6*cls[1]->rows2*cls[1]->cols2,400,3,NO_DROPOUT,RELU,0,normalization_flag ? 4 : 0,normalization_flag ? LAYER_NORMALIZATION : NO_NORMALIZATION);
+    fcls[1] = fully_connected(400,5,4,NO_DROPOUT,SOFTMAX,0,0,NO_NORMALIZATION);
+    return network(5,1,2,2,rls,cls,fcls);
+}
+
+int test_optimizer(int gradient_descent_flag, int regularization, int normalization_flag, int threads, char* name){
+    int i,j,step,failed = 0,size;
+    float difference = 0,max = 0,b1[2] = {BETA1_ADAM,BETA1_ADAM},b2[2] = {BETA2_ADAM,BETA2_ADAM};
+    unsigned long long int t[2] = {1,1};
+    model* m[2];
+    m[0] = create_model(normalization_flag);
+    m[1] = copy_model(m[0]);
+    make_model_contiguous(m[0]);
+    if(fused_update_supported_model(m[0]) == normalization_flag){
+        printf("%s: the model %s be updated with a single sweep\n",name,normalization_flag ? "must not" : "must");
+        failed = 1;
+    }
+    size = get_array_size_params_model(m[1]);
+    float* params[2] = {(float*)malloc(sizeof(float)*size),(float*)malloc(sizeof(float)*size)};
+    float* input = (float*)malloc(sizeof(float)*2*10*10);
+    float error[5];
+
+    for(step = 0; step < STEPS; step++){
+        for(i = 0; i < 2*10*10; i++){
+            input[i] = r2()*2-1;
+        }
+        for(j = 0; j < 2; j++){
+            model_tensor_input_ff(m[j],2,10,10,input);
+            for(i = 0; i < 5; i++){
+                error[i] = m[j]->fcls[1]->post_activation[i]-(i == step%5);
+            }
+            model_tensor_input_bp(m[j],2,10,10,input,error,5);
+            if(j == 0)
+                update_model_multicore(m[j],0.01,0.9,2,gradient_descent_flag,&b1[j],&b2[j],regularization,size,0.01,&t[j],0,threads);
+            else
+                update_model(m[j],0.01,0.9,2,gradient_descent_flag,&b1[j],&b2[j],regularization,size,0.01,&t[j]);
+            reset_model(m[j]);
+        }
+        memcopy_params_to_vector_model(m[0],params[0]);
+        memcopy_params_to_vector_model(m[1],params[1]);
+        difference = max_difference(params[0],params[1],size,&max);
+        if(normalization_flag){
+            // the group normalization params are inside the params vector, the layer normalization ones are not
+            bn* layer_norm[2] = {m[0]->fcls[0]->layer_norm,m[1]->fcls[0]->layer_norm};
+            float d = max_difference(layer_norm[0]->gamma,layer_norm[1]->gamma,layer_norm[1]->vector_dim,&max);
+            difference = d > difference ? d : difference;
+            d = max_difference(layer_norm[0]->beta,layer_norm[1]->beta,layer_norm[1]->vector_dim,&max);
+            difference = d > difference ? d : difference;
+        }
+        if(difference > TOLERANCE*max){
+            printf("%s, step %d: the fused update is %g away from the layer by layer update (max param %g)\n",name,step,difference,max);
+            failed = 1;
+            break;
+        }
+    }
+    if(b1[0] != b1[1] || b2[0] != b2[1] || t[0] != t[1]){
+        printf("%s: the fused update doesn't advance b1, b2 and t as the layer by layer update\n",name);
+        failed = 1;
+    }
+
+    free(input);
+    free(params[0]);
+    free(params[1]);
+    free_model(m[0]);
+    free_model(m[1]);
+    return failed;
+}
+
+int main(){
+    int i,j,k,failed = 0;
+    int optimizers[] = {NESTEROV,ADAM,RADAM,ADAMOD,DIFF_GRAD};
+    char* names[] = {"NESTEROV","ADAM","RADAM","ADAMOD","DIFF_GRAD"};
+    char name[256];
+    srand(SEED);
+    for(i = 0; i < 5; i++){
+        for(j = NO_REGULARIZATION; j <= L2_REGULARIZATION; j++){
+            for(k = 0; k < 3; k++){
+                sprintf(name,"%s%s, %s",names[i],j ? " with L2" : "",k == 0 ? "1 thread" : (k == 1 ? "4 threads" : "normalizations"));
+                failed |= test_optimizer(optimizers[i],j,k == 2,k == 1 ? 4 : 1,name);
+            }
+        }
+    }
+    if(failed){
+        printf("fused optimizer test failed\n");
+        return 1;
+    }
+    printf("fused optimizer test passed\n");
+    return 0;
+}
@@ -0,0 +1,194 @@
+#include <llab.h>
+#include <math.h>
+
+/* Test of the sgemm kernels:
+ * sgemm_nt, sgemm_nn, sgemm_tn, sgemv, sgemv_t and sger are compared with naive loops in double precision, for each
+ * instruction set (scalar, sse2, avx2, avx512, the ones not supported by the cpu fall back to the best supported one),
+ * with m, n and k that are not multiples of the widths of the vectors and of the tiles and with leading dimensions larger
+ * than the rows, B is also larger than a block of SGEMM_L2_FLOATS floats. C is not zero, the kernels must add to it.
+ * sgemm_tn must give exactly the bits of adding the k products to C one at a time, each product rounded to float,
+ * and the rows computed by sgemm_nt and sgemm_nn must not depend on m (a row alone gives the bits it gives inside a batch)
+ * */
+
+#define TOLERANCE 0.00001// relative to the sum of the magnitudes of the products of an element
+#define SEED 37
+
+int set;
+char* names[] = {"","scalar","sse2","avx2","avx512"};
+
+float* random_matrix(int rows, int ld){
+    int i;
+    float* a = (float*)malloc(sizeof(float)*rows*ld);
+    for(i = 0; i < rows*ld; i++){
+        a[i] = r2()*2-1;
+    }
+    return a;
+}
+
+/* c[i*ldc+j] + sum over p of a(i,p)*b(p,j), where a(i,p) = a[i*a_i+p*a_p] and b(p,j) = b[p*b_p+j*b_j]*/
+int check(char* name, int m, int n, int k, float* c0, float* c, int ldc, float* a, int a_i, int a_p, float* b, int b_p, int b_j){
+    int i,j,p;
+    double sum,magnitude;
+    for(i = 0; i < m; i++){
+        for(j = 0; j < n; j++){
+            sum = c0[i*ldc+j];
+            magnitude = fabs(c0[i*ldc+j]);
+            for(p = 0; p < k; p++){
+                sum += (double)a[i*a_i+p*a_p]*b[p*b_p+j*b_j];
+                magnitude += fabs((double)a[i*a_i+p*a_p]*b[p*b_p+j*b_j]);
+            }
+            if(fabs(c[i*ldc+j]-sum) > TOLERANCE*magnitude){
+                printf("%s %s, m %d n %d k %d: %.9g instead of %.9g at %d,%d\n",name,names[set],m,n,k,c[i*ldc+j],sum,i,j);
+                return 1;
+            }
+        }
+        // the padding of the leading dimension must be untouched
+        for(j = n; j < ldc; j++){
+            if(c[i*ldc+j] != c0[i*ldc+j]){
+                printf("%s %s, m %d n %d k %d: the column %d of the row %d is beyond n and it has been written\n",name,names[set],m,n,k,j,i);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+int test_sizes(int m, int n, int k){
+    int i,j,p,failed = 0,lda,ldb,ldc = n+3;
+    volatile float product;
+    float* a;
+    float* b;
+    float* c0 = random_matrix(m > k ? m : k,ldc > k+2 ? ldc : k+2);
+    float* c = (float*)malloc(sizeof(float)*(m > k ? m : k)*(ldc > k+2 ? ldc : k+2));
+    float* row = (float*)malloc(sizeof(float)*ldc);
+
+    // sgemm_nt: C += A*B^T, A m*k, B n*k
+    lda = k+1; ldb = k+2;
+    a = random_matrix(m,lda);
+    b = random_matrix(n,ldb);
+    copy_array(c0,c,m*ldc);
+    sgemm_nt(m,n,k,a,lda,b,ldb,c,ldc);
+    failed |= check("sgemm_nt",m,n,k,c0,c,ldc,a,lda,1,b,1,ldb);
+    for(i = 0; i < m && !failed; i++){
+        copy_array(&c0[i*ldc],row,ldc);
+        sgemm_nt(1,n,k,&a[i*lda],lda,b,ldb,row,ldc);
+        for(j = 0; j < n; j++){
+            if(row[j] != c[i*ldc+j]){
+                printf("sgemm_nt %s, m %d n %d k %d: the row %d alone gives %.9g instead of %.9g at %d\n",names[set],m,n,k,i,row[j],c[i*ldc+j],j);
+                failed = 1;
+                break;
+            }
+        }
+    }
+    // sgemv: y += A*x, A n*k
+    copy_array(c0,c,ldc);
+    sgemv(n,k,b,ldb,a,c);
+    failed |= check("sgemv",1,n,k,c0,c,ldc,a,0,1,b,1,ldb);
+    free(a);
+    free(b);
+
+    // sgemm_nn: C += A*B, A m*k, B k*n
+    lda = k+2; ldb = n+1;
+    a = random_matrix(m,lda);
+    b = random_matrix(k,ldb);
+    copy_array(c0,c,m*ldc);
+    sgemm_nn(m,n,k,a,lda,b,ldb,c,ldc);
+    failed |= check("sgemm_nn",m,n,k,c0,c,ldc,a,lda,1,b,ldb,1);
+    for(i = 0; i < m && !failed; i++){
+        copy_array(&c0[i*ldc],row,ldc);
+        sgemm_nn(1,n,k,&a[i*lda],lda,b,ldb,row,ldc);
+        for(j = 0; j < n; j++){
+            if(row[j] != c[i*ldc+j]){
+                printf("sgemm_nn %s, m %d n %d k %d: the row %d alone gives %.9g instead of %.9g at %d\n",names[set],m,n,k,i,row[j],c[i*ldc+j],j);
+                failed = 1;
+                break;
+            }
+        }
+    }
+    free(a);
+    free(b);
+
+    // sgemm_tn: C += A^T*B, A k*m, B k*n, the products are added one at a time
+    lda = m+1; ldb = n+2;
+    a = random_matrix(k,lda);
+    b = random_matrix(k,ldb);
+    copy_array(c0,c,m*ldc);
+    sgemm_tn(m,n,k,a,lda,b,ldb,c,ldc);
+    failed |= check("sgemm_tn",m,n,k,c0,c,ldc,a,1,lda,b,ldb,1);
+    for(i = 0; i < m && !failed; i++){
+        for(j = 0; j < n; j++){
+            float sum = c0[i*ldc+j];
+            for(p = 0; p < k; p++){
+                product = a[p*lda+i]*b[p*ldb+j];
+                sum += product;
+            }
+            if(sum != c[i*ldc+j]){
+                printf("sgemm_tn %s, m %d n %d k %d: %.9g instead of the sequential sum %.9g at %d,%d\n",names[set],m,n,k,c[i*ldc+j],sum,i,j);
+                failed = 1;
+                i = m;
+                break;
+            }
+        }
+    }
+    // the same bits adding the instances one at a time (k = 1)
+    copy_array(c0,row,ldc);
+    for(p = 0; p < k; p++){
+        sgemm_tn(1,n,1,&a[p*lda],lda,&b[p*ldb],ldb,row,ldc);
+    }
+    for(j = 0; j < n && !failed; j++){
+        if(row[j] != c[j]){
+            printf("sgemm_tn %s, m %d n %d k %d: the instances one at a time give %.9g instead of %.9g at %d\n",names[set],m,n,k,row[j],c[j],j);
+            failed = 1;
+        }
+    }
+    // sgemv_t: y += A^T*x, A k*n
+    copy_array(c0,c,ldc);
+    sgemv_t(k,n,b,ldb,a,c);
+    failed |= check("sgemv_t",1,n,k,c0,c,ldc,a,0,1,b,ldb,1);
+    free(a);
+    free(b);
+
+    // sger: A += x*y^T, A m*n
+    a = random_matrix(1,m);
+    b = random_matrix(1,n);
+    copy_array(c0,c,m*ldc);
+    sger(m,n,a,b,c,ldc);
+    failed |= check("sger",m,n,1,c0,c,ldc,a,1,0,b,0,1);
+    free(a);
+    free(b);
+
+    free(row);
+    free(c);
+    free(c0);
+    return failed;
+}
+
+int main(){
+    int x,y,z,failed = 0;
+    int ms[] = {1,2,3,5,17,64};
+    int ns[] = {1,3,4,8,15,16,33,100};
+    int ks[] = {1,2,7,8,16,31,129,300};
+    srand(SEED);
+    if(!__builtin_cpu_supports("avx512f"))
+        printf("the cpu has no avx512 instructions, the avx512 case runs the best supported kernels\n");
+    for(set = SGEMM_SCALAR; set <= SGEMM_AVX512; set++){
+        set_sgemm_instruction_set(set);
+        for(x = 0; x < 6; x++){
+            for(y = 0; y < 8; y++){
+                for(z = 0; z < 8; z++){
+                    failed |= test_sizes(ms[x],ns[y],ks[z]);
+                }
+            }
+        }
+        // B larger than SGEMM_L2_FLOATS, split in more blocks
+        failed |= test_sizes(9,257,200);
+        failed |= test_sizes(33,150,301);
+    }
+    set_sgemm_instruction_set(SGEMM_AUTO);
+    if(failed){
+        printf("sgemm test failed\n");
+        return 1;
+    }
+    printf("sgemm test passed\n");
+    return 0;
+}
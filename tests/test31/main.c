@@ -0,0 +1,106 @@
+#include <llab.h>
+#include <math.h>
+
+/* Test of the framed messages:
+ * a message sent with send_message on a socket pair is received by recv_message, then a message with a wrong magic number,
+ * one larger than the buffer of the receiver and one with a corrupted payload must be reported by recv_message with -1,
+ * without stopping the process, as a closed connection. The crc32c of the scalar table is computed by several threads
+ * at the same time the first time it is used, they must all get the crc32c of the check string "123456789"
+ * */
+
+#define SIZE 1000
+#define THREADS 8
+#define CHECK_CRC 0xe3069283// crc32c of "123456789"
+
+void* crc_thread(void* _args){
+    unsigned int* crc = (unsigned int*)_args;
+    *crc = crc32c_scalar(0,"123456789",9);
+    return NULL;
+}
+
+/* sends a vector, then corrupts its header or its payload on the way, if corruption is 0 the message is sent unchanged*/
+int send_corrupted(int fd, float* vector, int corruption){
+    message_header header;
+    float* payload = (float*)malloc(sizeof(float)*SIZE);
+    int ret;
+    copy_array(vector,payload,SIZE);
+    memset(&header,0,sizeof(message_header));
+    header.magic = MESSAGE_MAGIC;
+    header.type = MESSAGE_VECTOR;
+    header.step = 7;
+    header.checksum = message_checksum(payload,sizeof(float)*SIZE);
+    header.length = sizeof(float)*SIZE;
+    if(corruption == 1)
+        header.magic++;
+    else if(corruption == 2)
+        header.length+=sizeof(float);
+    else if(corruption == 3)
+        ((unsigned char*)payload)[123]^=1;
+    ret = write_all(fd,&header,sizeof(message_header));
+    if(corruption != 1 && corruption != 2 && ret != -1)
+        ret = write_all(fd,payload,sizeof(float)*SIZE);
+    free(payload);
+    return ret;
+}
+
+int main(){
+    int i,fds[2],failed = 0;
+    unsigned int crcs[THREADS];
+    pthread_t threads[THREADS];
+    char* names[] = {"a correct message","a wrong magic number","a payload too large","a corrupted payload"};
+    float* vector = (float*)malloc(sizeof(float)*SIZE);
+    float* received = (float*)malloc(sizeof(float)*SIZE);
+    message_header header;
+    srand(41);
+    
+    for(i = 0; i < THREADS; i++){
+        pthread_create(&threads[i],NULL,crc_thread,&crcs[i]);
+    }
+    for(i = 0; i < THREADS; i++){
+        pthread_join(threads[i],NULL);
+        if(crcs[i] != CHECK_CRC){
+            printf("the thread %d computed the crc32c %08x instead of %08x\n",i,crcs[i],CHECK_CRC);
+            failed = 1;
+        }
+    }
+    if(message_checksum("123456789",9) != CHECK_CRC){
+        printf("message_checksum gives %08x instead of %08x\n",message_checksum("123456789",9),CHECK_CRC);
+        failed = 1;
+    }
+    
+    for(i = 0; i < SIZE; i++){
+        vector[i] = r2()*2-1;
+    }
+    for(i = 0; i < 4; i++){
+        // a new connection for each message, after an error the stream can't be read anymore
+        if(socketpair(AF_UNIX,SOCK_STREAM,0,fds) == -1){
+            printf("can't create a socket pair\n");
+            return 1;
+        }
+        set_socket_options(fds[0]);
+        set_socket_options(fds[1]);
+        if(send_corrupted(fds[0],vector,i) == -1){
+            printf("%s can't be sent\n",names[i]);
+            failed = 1;
+        }
+        if(recv_message(fds[1],&header,received,sizeof(float)*SIZE) != (i ? -1 : 0)){
+            printf("recv_message doesn't give %d for %s\n",i ? -1 : 0,names[i]);
+            failed = 1;
+        }
+        if(!i && (header.type != MESSAGE_VECTOR || header.step != 7 || memcmp(vector,received,sizeof(float)*SIZE))){
+            printf("%s is received changed\n",names[i]);
+            failed = 1;
+        }
+        close(fds[0]);
+        close(fds[1]);
+    }
+    
+    free(vector);
+    free(received);
+    if(failed){
+        printf("message test failed\n");
+        return 1;
+    }
+    printf("message test passed\n");
+    return 0;
+}
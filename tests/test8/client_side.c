@@ -50,15 +50,15 @@ int main(){
     
     if(pid == 0){
         
-        close(fd1[0]);//reader
+        close(fd1[1]);//reader
         close(fd2[0]);//writer
         
         int buffer_size = get_array_size_params_model(m);
         free_model(m);
         
-        run_client(PORT,"127.0.0.1",buffer_size+INPUTS_PER_CLIENT+OUTPUT_PER_CLIENT,fd1[1],fd2[1]);
+        run_client(PORT,"127.0.0.1",buffer_size+INPUTS_PER_CLIENT+OUTPUT_PER_CLIENT,fd1[0],fd2[1]);
         
-        close(fd1[1]);
+        close(fd1[0]);
         close(fd2[1]);
         return 0;
     }
@@ -72,7 +72,7 @@ int main(){
         
         
         int j,batch_size = THREAD_PER_CLIENT;
-        close(fd1[1]);//writer
+        close(fd1[0]);//writer
         close(fd2[1]);//reader
         int buffer_size = get_array_size_params_model(m),output_dimension = 10;
         model** batch_m = (model**)malloc(sizeof(model*)*THREAD_PER_CLIENT);
@@ -94,17 +94,7 @@ int main(){
         }
         
         while(1){
-            clock_t t; 
-            t = clock();
-            int flag = 0; 
-            while(read(fd2[0], buff, sizeof(float)*(buffer_size+INPUTS_PER_CLIENT+OUTPUT_PER_CLIENT)) == 0){
-                t+=clock();
-                if((t)/CLOCKS_PER_SEC > 10)
-                    flag = 1;
-                    
-                break;
-            }
-            if(flag)
+            if(read_all(fd2[0], buff, sizeof(float)*(buffer_size+INPUTS_PER_CLIENT+OUTPUT_PER_CLIENT)) == -1)// waiting for the server, until it closes the connection
                 break;
             
             for(i = 0; i < THREAD_PER_CLIENT; i++){
@@ -126,7 +116,7 @@ int main(){
             
             sum_model_partial_derivatives(batch_m[0],batch_m[1],batch_m[0]);
             memcopy_derivative_params_to_vector_model(batch_m[0],buff);
-            ret = write(fd1[0],buff,sizeof(float)*(buffer_size+INPUTS_PER_CLIENT+OUTPUT_PER_CLIENT));// writing to sons
+            ret = write_all(fd1[1],buff,sizeof(float)*(buffer_size+INPUTS_PER_CLIENT+OUTPUT_PER_CLIENT));// writing to sons
             
             for(j = 0; j < THREAD_PER_CLIENT; j++){
                 reset_model(batch_m[j]);
@@ -57,8 +57,8 @@ int main(){
         for(i = 0; i < number_connections; i++){
             close(writers[i][0]);
             w[i] = writers[i][1];
-            close(readers[i][0]);
-            r[i] = readers[i][1];
+            close(readers[i][1]);
+            r[i] = readers[i][0];
         }
         
         int buffer_size = get_array_size_params_model(m);
@@ -68,7 +68,7 @@ int main(){
         
         for(i = 0; i < number_connections; i++){
             close(writers[i][1]);
-            close(readers[i][1]);
+            close(readers[i][0]);
         }
         
         free(writers);
@@ -90,8 +90,8 @@ int main(){
         int* r = (int*)malloc(sizeof(int)*number_connections);
         for(i = 0; i < number_connections; i++){
             close(writers[i][1]);
-            w[i] = readers[i][0];
-            close(readers[i][1]);
+            w[i] = readers[i][1];
+            close(readers[i][0]);
             r[i] = writers[i][0];
         }
         
@@ -162,10 +162,13 @@ int main(){
                     memcpy(&buff[j][buffer_size+(INPUTS_PER_CLIENT/THREAD_PER_CLIENT)],outputs[i*batch_size+z],(OUTPUT_PER_CLIENT/THREAD_PER_CLIENT)*sizeof(float));
                     memcpy(&buff[j][buffer_size+(OUTPUT_PER_CLIENT/THREAD_PER_CLIENT)+(INPUTS_PER_CLIENT/THREAD_PER_CLIENT)],inputs[i*batch_size+z+1],(INPUTS_PER_CLIENT/THREAD_PER_CLIENT)*sizeof(float));
                     memcpy(&buff[j][buffer_size+INPUTS_PER_CLIENT+(OUTPUT_PER_CLIENT/THREAD_PER_CLIENT)],outputs[i*batch_size+z+1],(OUTPUT_PER_CLIENT/THREAD_PER_CLIENT)*sizeof(float));
-                    ret = write(w[j],buff[j],sizeof(float)*(buffer_size+INPUTS_PER_CLIENT+OUTPUT_PER_CLIENT));// writing to sons
+                    ret = write_all(w[j],buff[j],sizeof(float)*(buffer_size+INPUTS_PER_CLIENT+OUTPUT_PER_CLIENT));// writing to sons
                 }
                 for(j = 0, z = 0; j < number_connections; j++, z+=2){
-                    while(read(r[j], buff[j], sizeof(float)*(buffer_size+INPUTS_PER_CLIENT+OUTPUT_PER_CLIENT)) == 0);// waiting for sons
+                    if(read_all(r[j], buff[j], sizeof(float)*(buffer_size+INPUTS_PER_CLIENT+OUTPUT_PER_CLIENT)) == -1){// waiting for sons
+                        fprintf(stderr,"Error: the client %d is disconnected\n",j);
+                        exit(1);
+                    }
                     memcopy_vector_to_derivative_params_model(m,buff[j]);
                     sum_model_partial_derivatives(m,sum_m,sum_m);
                 }